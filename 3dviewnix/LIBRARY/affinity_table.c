@@ -0,0 +1,174 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************
+ *                                                                      *
+ *      Filename  : affinity_table.c                                    *
+ *      Ext Funcs : VAffinityTable, VAffinityPlane.                     *
+ *      Int Funcs : None.                                               *
+ *                                                                      *
+ *      Tabulates a fuzzy affinity that depends only on the values of   *
+ *      the two cells, so that the feature transforms are evaluated     *
+ *      once per pair of values instead of once per pair of adjacent    *
+ *      cells, and fills the affinity of a scene in one direction from  *
+ *      such a table.  Both share the work among threads.               *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <cv3dv.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define AFFINITY_PARALLEL_CELLS 0x4000  /* less work uses one thread */
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VAffinityTable                                *
+ *      Description     : Tabulates an affinity function of the values  *
+ *                        of two cells.  Entry a*levels+b of the table  *
+ *                        is f(a, b, client).                           *
+ *      Return Value    :  The table, to be freed by the caller, or     *
+ *                         NULL if levels exceeds                       *
+ *                         VAFFINITY_TABLE_MAX_LEVELS or memory is not  *
+ *                         available; the caller should then evaluate   *
+ *                         the function directly.                       *
+ *      Parameters      :  levels - the number of values, 0 to levels-1.*
+ *                         f - the affinity function.  It is called     *
+ *                            from several threads at once and must not *
+ *                            change any shared state.                  *
+ *                         client - passed to f.                        *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VAffinityPlane.                               *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+float* VAffinityTable ( int levels, float (*f)(int a, int b, void* client),
+    void* client )
+{
+        float *table;
+        int a;
+
+        if (levels<1 || levels>VAFFINITY_TABLE_MAX_LEVELS)
+            return (NULL);
+        table = (float *)malloc((size_t)levels*levels*sizeof(float));
+        if (table == NULL)
+            return (NULL);
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 8) \
+            if ((long)levels*levels >= AFFINITY_PARALLEL_CELLS)
+#endif
+        for (a=0; a<levels; a++) {
+            float *row=table+(size_t)a*levels;
+            int b;
+
+            for (b=0; b<levels; b++)
+                row[b] = f(a, b, client);
+        }
+        return (table);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VAffinityPlane                                *
+ *      Description     : Computes the affinity between each cell of a  *
+ *                        scene and its next neighbor in one direction  *
+ *                        from a table made by VAffinityTable.  The     *
+ *                        tabulated value is multiplied by adjacency;   *
+ *                        a product of at least threshold is stored     *
+ *                        truncated, a smaller one as 0.  Cells without *
+ *                        a next neighbor get 0, except that the last   *
+ *                        slice is not stored for direction 2.  A cell  *
+ *                        either of whose values is not in the table    *
+ *                        gets undefined.                               *
+ *      Return Value    :  The number of cells given undefined.         *
+ *      Parameters      :  table, levels - as from VAffinityTable.      *
+ *                         data - the scene, 8 or 16 bits per cell.     *
+ *                         bits - 8 or 16.                              *
+ *                         width, height, slices - the size of the      *
+ *                            scene in cells.                           *
+ *                         direction - 0 for the next column, 1 for the *
+ *                            next row, 2 for the next slice.           *
+ *                         adjacency - the scale of the affinity.       *
+ *                         threshold - as above.                        *
+ *                         undefined - as above.                        *
+ *                         out - the affinities, width*height*slices    *
+ *                            cells, or width*height*(slices-1) for     *
+ *                            direction 2.                              *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VAffinityTable.                               *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+long VAffinityPlane ( const float* table, int levels, const void* data,
+    int bits, int width, int height, int slices, int direction,
+    float adjacency, float threshold, unsigned short undefined,
+    unsigned short* out )
+{
+        long plane=(long)width*height, step, undefined_cells=0;
+        int row, rows=height*(direction==2? slices-1: slices);
+
+        step = direction==0? 1: direction==1? width: plane;
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 16) \
+            reduction(+:undefined_cells) \
+            if ((long)rows*width >= AFFINITY_PARALLEL_CELLS)
+#endif
+        for (row=0; row<rows; row++) {
+            long j=(long)row*width, end=j+width, last=end;
+            int a, b;
+            float t;
+
+            /* cells from last on have no next neighbor */
+            if (direction == 0)
+                last = end-1;
+            else if (direction==1 && row%height==height-1)
+                last = j;
+            for (; j<last; j++) {
+                if (bits == 8) {
+                    a = ((const unsigned char *)data)[j];
+                    b = ((const unsigned char *)data)[j+step];
+                }
+                else {
+                    a = ((const unsigned short *)data)[j];
+                    b = ((const unsigned short *)data)[j+step];
+                }
+                if (a>=levels || b>=levels) {
+                    out[j] = undefined;
+                    undefined_cells++;
+                    continue;
+                }
+                t = table[(long)a*levels+b]*adjacency;
+                out[j] = t>=threshold? (unsigned short)t: 0;
+            }
+            for (; j<end; j++)
+                out[j] = 0;
+        }
+        return (undefined_cells);
+}
@@ -0,0 +1,930 @@
+/*
+  Copyright 1993-2013, 2017 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************
+ *                                                                      *
+ *      Filename  : fft.c                                               *
+ *      Ext Funcs : VFFT, VFFTReal, VFFTRealInverse, VFFTConvolve,      *
+ *                  VFFTSize.                                           *
+ *      Int Funcs : v_fft_plan, v_fft_new_plan, v_fft_axes, v_fft_line, *
+ *                  v_fft_work, v_fft_radix2, v_fft_radix3,             *
+ *                  v_fft_radix4, v_fft_generic.                        *
+ *                                                                      *
+ *      Fast Fourier transforms of complex and real data of any size    *
+ *      and dimension.  A length is factored into radices 4, 2, 3, 5,   *
+ *      7, 11 and 13 and transformed by recursive decimation in time;   *
+ *      a length with a larger prime factor is transformed by           *
+ *      Bluestein's algorithm as a convolution of a length VFFTSize     *
+ *      returns.  The factors and twiddle factors of each length are    *
+ *      computed once and kept for the rest of the process.  Each axis  *
+ *      is transformed in turn; the lines along an axis are divided     *
+ *      into contiguous slabs, one to a thread, and each line is copied *
+ *      to a buffer, transformed and copied back.  Transforms are not   *
+ *      normalized: a forward and an inverse transform multiply the     *
+ *      data by the number of elements.                                 *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cv3dv.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FFT_MAX_DIMS 8
+#define FFT_MAX_FACTORS 32
+#define FFT_MAX_RADIX 13                /* larger primes use Bluestein */
+#define FFT_PARALLEL_ELEMENTS 0x8000    /* smaller data use one thread */
+
+typedef struct FFTPlan {
+        int n;
+        int factors[2*FFT_MAX_FACTORS]; /* radix and remaining length */
+        double *twiddle;        /* cos and sin of 2*pi*k/n, k<n */
+        int m;                  /* Bluestein convolution length, else 0 */
+        struct FFTPlan *sub;    /* plan of length m */
+        double *chirp;          /* exp(i*pi*k*k/n), k<n */
+        double *spectrum[2];    /* transform of the conjugate chirp for
+                                   isign -1 and 1, divided by m */
+        struct FFTPlan *next;
+} FFTPlan;
+
+static FFTPlan *v_fft_plans;
+
+static FFTPlan *v_fft_plan ( int n );
+static FFTPlan *v_fft_new_plan ( int n );
+static int v_fft_axes ( double* data, int ndim, const int dims[],
+    int first_axis, int isign );
+static void v_fft_line ( const FFTPlan* plan, const double* in, double* out,
+    double* work, int isign );
+static void v_fft_work ( const FFTPlan* plan, double* out, const double* in,
+    long fstride, const int* factors, int isign );
+static void v_fft_radix2 ( double* f, const double* tw, long fstride,
+    int m, int isign );
+static void v_fft_radix3 ( double* f, const double* tw, long fstride,
+    int m, int isign );
+static void v_fft_radix4 ( double* f, const double* tw, long fstride,
+    int m, int isign );
+static void v_fft_generic ( double* f, const double* tw, long fstride,
+    int n, int p, int m, int isign );
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFFT                                          *
+ *      Description     : Replaces data by its discrete Fourier         *
+ *                        transform, sum of data[j]*exp(isign*2*pi*i*   *
+ *                        j*k/n) over each axis.                        *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - a size is less than 1 or more than 8     *
+ *                            axes.                                     *
+ *      Parameters      :  data - complex elements, real and imaginary  *
+ *                            parts interleaved, first axis fastest.    *
+ *                         ndim - the number of axes.                   *
+ *                         dims - the size of each axis.                *
+ *                         isign - -1 for the forward transform, 1 for  *
+ *                            the inverse.                              *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFTReal, VFFTSize.                           *
+ *      History         : Written on October 19, 2026.                  *
+ *                        Modified: 10/19/26 any size, threaded.        *
+ *                                                                      *
+ ************************************************************************/
+int VFFT ( double* data, int ndim, const int dims[], int isign )
+{
+        return (v_fft_axes(data, ndim, dims, 0, isign));
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFFTReal                                      *
+ *      Description     : Computes the forward transform of real data.  *
+ *                        Only elements 0 to dims[0]/2 of the first     *
+ *                        axis are stored; the others are the complex   *
+ *                        conjugates of elements at the negated         *
+ *                        frequency.  Pairs of lines of the first axis  *
+ *                        are transformed together as the real and     *
+ *                        imaginary parts of one complex line.          *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - a size is less than 1 or more than 8     *
+ *                            axes.                                     *
+ *      Parameters      :  in - the real data, first axis fastest.      *
+ *                         out - the transform, dims[0]/2+1 complex     *
+ *                            elements on the first axis, interleaved.  *
+ *                         ndim - the number of axes.                   *
+ *                         dims - the size of each axis of in.          *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFTRealInverse, VFFT.                        *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VFFTReal ( const double* in, double* out, int ndim, const int dims[] )
+{
+        FFTPlan *plan;
+        long total, nlines;
+        int d, n, h, pair, npairs, failed=0, hdims[FFT_MAX_DIMS];
+
+        if (ndim<1 || ndim>FFT_MAX_DIMS)
+            return (5);
+        for (total=1,d=0; d<ndim; d++) {
+            if (dims[d] < 1)
+                return (5);
+            total *= dims[d];
+        }
+        n = dims[0];
+        h = n/2+1;
+        nlines = total/n;
+        npairs = (int)((nlines+1)/2);
+        plan = v_fft_plan(n);
+        if (plan == NULL)
+            return (1);
+
+#ifdef _OPENMP
+        #pragma omp parallel if (total >= FFT_PARALLEL_ELEMENTS)
+#endif
+        {
+            double *buf=(double *)malloc((4*n+4*plan->m)*sizeof(double));
+            int j, k;
+
+#ifdef _OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (pair=0; pair<npairs; pair++) {
+                const double *a=in+2*(long)pair*n, *b=a+n;
+                double *z, *oa=out+4*(long)pair*h, *ob=oa+2*h;
+                int two=2*(long)pair+1 < nlines;
+
+                if (buf == NULL)
+                    continue;
+                z = buf+2*n;
+                for (j=0; j<n; j++) {
+                    buf[2*j] = a[j];
+                    buf[2*j+1] = two? b[j]: 0;
+                }
+                v_fft_line(plan, buf, z, buf+4*n, -1);
+                /* A[k] = (Z[k]+conj(Z[n-k]))/2,
+                   B[k] = (Z[k]-conj(Z[n-k]))/2i */
+                for (k=0; k<h; k++) {
+                    double zr=z[2*k], zi=z[2*k+1],
+                        wr=z[2*((n-k)%n)], wi=z[2*((n-k)%n)+1];
+
+                    oa[2*k] = .5*(zr+wr);
+                    oa[2*k+1] = .5*(zi-wi);
+                    if (two) {
+                        ob[2*k] = .5*(zi+wi);
+                        ob[2*k+1] = -.5*(zr-wr);
+                    }
+                }
+            }
+            if (buf == NULL)
+                failed = 1;
+            else
+                free(buf);
+        }
+        if (failed)
+            return (1);
+        for (d=0; d<ndim; d++)
+            hdims[d] = dims[d];
+        hdims[0] = h;
+        return (v_fft_axes(out, ndim, hdims, 1, -1));
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFFTRealInverse                               *
+ *      Description     : Computes the inverse transform of data with   *
+ *                        a real inverse, stored as VFFTReal stores it. *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - a size is less than 1 or more than 8     *
+ *                            axes.                                     *
+ *      Parameters      :  in - the transform, dims[0]/2+1 complex      *
+ *                            elements on the first axis, interleaved.  *
+ *                         out - the real data, first axis fastest; it  *
+ *                            may not be in.                            *
+ *                         ndim - the number of axes.                   *
+ *                         dims - the size of each axis of out.         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFTReal, VFFT.                               *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VFFTRealInverse ( const double* in, double* out, int ndim,
+    const int dims[] )
+{
+        FFTPlan *plan;
+        double *half;
+        long total, nlines;
+        int d, n, h, pair, npairs, failed=0, hdims[FFT_MAX_DIMS];
+
+        if (ndim<1 || ndim>FFT_MAX_DIMS)
+            return (5);
+        for (total=1,d=0; d<ndim; d++) {
+            if (dims[d] < 1)
+                return (5);
+            total *= dims[d];
+            hdims[d] = dims[d];
+        }
+        n = dims[0];
+        h = hdims[0] = n/2+1;
+        nlines = total/n;
+        npairs = (int)((nlines+1)/2);
+        plan = v_fft_plan(n);
+        half = (double *)malloc(2*h*nlines*sizeof(double));
+        if (plan==NULL || half==NULL) {
+            if (half)
+                free(half);
+            return (1);
+        }
+        memcpy(half, in, 2*h*nlines*sizeof(double));
+        if (v_fft_axes(half, ndim, hdims, 1, 1)) {
+            free(half);
+            return (1);
+        }
+
+#ifdef _OPENMP
+        #pragma omp parallel if (total >= FFT_PARALLEL_ELEMENTS)
+#endif
+        {
+            double *buf=(double *)malloc((4*n+4*plan->m)*sizeof(double));
+            int j, k;
+
+#ifdef _OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (pair=0; pair<npairs; pair++) {
+                const double *ha=half+4*(long)pair*h, *hb=ha+2*h;
+                double *z, *a=out+2*(long)pair*n, *b=a+n;
+                int two=2*(long)pair+1 < nlines;
+
+                if (buf == NULL)
+                    continue;
+                z = buf+2*n;
+                /* Z[k] = A[k]+i*B[k], A[n-k] = conj(A[k]) */
+                for (k=0; k<n; k++) {
+                    double ar, ai, br=0, bi=0;
+
+                    if (k < h) {
+                        ar = ha[2*k];
+                        ai = ha[2*k+1];
+                        if (two) {
+                            br = hb[2*k];
+                            bi = hb[2*k+1];
+                        }
+                    }
+                    else {
+                        ar = ha[2*(n-k)];
+                        ai = -ha[2*(n-k)+1];
+                        if (two) {
+                            br = hb[2*(n-k)];
+                            bi = -hb[2*(n-k)+1];
+                        }
+                    }
+                    buf[2*k] = ar-bi;
+                    buf[2*k+1] = ai+br;
+                }
+                v_fft_line(plan, buf, z, buf+4*n, 1);
+                for (j=0; j<n; j++) {
+                    a[j] = z[2*j];
+                    if (two)
+                        b[j] = z[2*j+1];
+                }
+            }
+            if (buf == NULL)
+                failed = 1;
+            else
+                free(buf);
+        }
+        free(half);
+        return (failed);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFFTConvolve                                  *
+ *      Description     : Computes the circular convolution,            *
+ *                        out[o] = sum of a[p]*b[o-p], or the circular  *
+ *                        cross-correlation, out[o] = sum of            *
+ *                        a[p]*b[p+o], of two real arrays, indices      *
+ *                        taken modulo the size of each axis.  Pad the  *
+ *                        arrays with zeros for linear results.         *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - a size is less than 1 or more than 8     *
+ *                            axes.                                     *
+ *      Parameters      :  a, b - the arrays, first axis fastest.       *
+ *                         out - the result; it may be a or b.          *
+ *                         ndim - the number of axes.                   *
+ *                         dims - the size of each axis.                *
+ *                         correlate - non-zero for cross-correlation.  *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFTReal, VFFTRealInverse, VFFTSize.          *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VFFTConvolve ( const double* a, const double* b, double* out, int ndim,
+    const int dims[], int correlate )
+{
+        double *sa, *sb, scale;
+        long total, nhalf, k;
+        int d, error;
+
+        if (ndim<1 || ndim>FFT_MAX_DIMS)
+            return (5);
+        for (total=1,d=0; d<ndim; d++) {
+            if (dims[d] < 1)
+                return (5);
+            total *= dims[d];
+        }
+        nhalf = total/dims[0]*(dims[0]/2+1);
+        sa = (double *)malloc(2*nhalf*sizeof(double));
+        sb = (double *)malloc(2*nhalf*sizeof(double));
+        if (sa==NULL || sb==NULL) {
+            if (sa)
+                free(sa);
+            if (sb)
+                free(sb);
+            return (1);
+        }
+        error = VFFTReal(a, sa, ndim, dims);
+        if (error == 0)
+            error = VFFTReal(b, sb, ndim, dims);
+        if (error) {
+            free(sa);
+            free(sb);
+            return (error);
+        }
+        scale = 1./total;
+        for (k=0; k<nhalf; k++) {
+            double ar=sa[2*k], ai=correlate? -sa[2*k+1]: sa[2*k+1],
+                br=sb[2*k], bi=sb[2*k+1];
+
+            sa[2*k] = scale*(ar*br-ai*bi);
+            sa[2*k+1] = scale*(ar*bi+ai*br);
+        }
+        free(sb);
+        error = VFFTRealInverse(sa, out, ndim, dims);
+        free(sa);
+        return (error);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFFTSize                                      *
+ *      Description     : Returns the smallest size at least n with no  *
+ *                        prime factor larger than 5, which VFFT        *
+ *                        transforms fastest.                           *
+ *      Return Value    : The size.                                     *
+ *      Parameters      :  n - the number of elements needed.           *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFT.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                        Modified: 10/19/26 products of 2, 3 and 5.    *
+ *                                                                      *
+ ************************************************************************/
+int VFFTSize ( int n )
+{
+        int size, r;
+
+        for (size=n>1? n: 1; ; size++) {
+            for (r=size; r%2==0; r/=2)
+                ;
+            for (; r%3==0; r/=3)
+                ;
+            for (; r%5==0; r/=5)
+                ;
+            if (r == 1)
+                return (size);
+        }
+}
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_plan                                    *
+ *      Description     : Returns the plan of a length, making it the   *
+ *                        first time the length is used.  Two threads   *
+ *                        may both make a plan of a new length; both    *
+ *                        are kept and either may be used.              *
+ *      Return Value    : The plan, NULL on memory allocation error.    *
+ *      Parameters      :  n - the length, at least 1.                  *
+ *      Side effects    : Adds the plan to v_fft_plans.                 *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_new_plan.                               *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static FFTPlan *v_fft_plan ( int n )
+{
+        FFTPlan *plan;
+
+#ifdef _OPENMP
+        #pragma omp critical (v_fft_plans)
+#endif
+        for (plan=v_fft_plans; plan && plan->n!=n; plan=plan->next)
+            ;
+        if (plan)
+            return (plan);
+        plan = v_fft_new_plan(n);
+        if (plan) {
+#ifdef _OPENMP
+            #pragma omp critical (v_fft_plans)
+#endif
+            {
+                plan->next = v_fft_plans;
+                v_fft_plans = plan;
+            }
+        }
+        return (plan);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_new_plan                                *
+ *      Description     : Makes the plan of a length: its twiddle       *
+ *                        factors and radices, or for Bluestein's       *
+ *                        algorithm the chirp and its transforms.       *
+ *      Return Value    : The plan, NULL on memory allocation error.    *
+ *      Parameters      :  n - the length, at least 1.                  *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_plan.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static FFTPlan *v_fft_new_plan ( int n )
+{
+        FFTPlan *plan;
+        double *b, *tmp;
+        int k, p, r, nf, s, m;
+        long t;
+
+        plan = (FFTPlan *)calloc(1, sizeof(FFTPlan));
+        if (plan == NULL)
+            return (NULL);
+        plan->n = n;
+        plan->twiddle = (double *)malloc(2*n*sizeof(double));
+        if (plan->twiddle == NULL) {
+            free(plan);
+            return (NULL);
+        }
+        for (k=0; k<n; k++) {
+            plan->twiddle[2*k] = cos(2*M_PI*k/n);
+            plan->twiddle[2*k+1] = sin(2*M_PI*k/n);
+        }
+        plan->factors[0] = plan->factors[1] = 1;
+
+        /* radix 4 first, then 2, then odd primes */
+        for (r=n,nf=0,p=4; r>1 && nf<FFT_MAX_FACTORS; nf++) {
+            while (r%p && p<=FFT_MAX_RADIX)
+                p = p==4? 2: p==2? 3: p+2;
+            if (p > FFT_MAX_RADIX)
+                break;
+            r /= p;
+            plan->factors[2*nf] = p;
+            plan->factors[2*nf+1] = r;
+        }
+        if (r == 1)
+            return (plan);
+
+        /* Bluestein's algorithm */
+        m = plan->m = VFFTSize(2*n-1);
+        plan->sub = v_fft_plan(m);
+        plan->chirp = (double *)malloc(2*n*sizeof(double));
+        plan->spectrum[0] = (double *)malloc(2*m*sizeof(double));
+        plan->spectrum[1] = (double *)malloc(2*m*sizeof(double));
+        tmp = (double *)malloc(2*m*sizeof(double));
+        if (plan->sub==NULL || plan->chirp==NULL || plan->spectrum[0]==NULL
+                || plan->spectrum[1]==NULL || tmp==NULL) {
+            if (plan->chirp)
+                free(plan->chirp);
+            if (plan->spectrum[0])
+                free(plan->spectrum[0]);
+            if (plan->spectrum[1])
+                free(plan->spectrum[1]);
+            if (tmp)
+                free(tmp);
+            free(plan->twiddle);
+            free(plan);
+            return (NULL);
+        }
+        for (k=0; k<n; k++) {
+            /* k*k modulo 2n keeps the angle accurate */
+            t = (long)k*k%(2*n);
+            plan->chirp[2*k] = cos(M_PI*t/n);
+            plan->chirp[2*k+1] = sin(M_PI*t/n);
+        }
+        for (s=0; s<2; s++) {
+            /* conj(w) from -(n-1) to n-1, circularly; w[k] is chirp[k]
+               for isign 1 and its conjugate for isign -1 */
+            for (k=0; k<2*m; k++)
+                tmp[k] = 0;
+            for (k=0; k<n; k++) {
+                tmp[2*k] = plan->chirp[2*k];
+                tmp[2*k+1] = (s? -1: 1)*plan->chirp[2*k+1];
+                if (k) {
+                    tmp[2*(m-k)] = tmp[2*k];
+                    tmp[2*(m-k)+1] = tmp[2*k+1];
+                }
+            }
+            b = plan->spectrum[s];
+            v_fft_work(plan->sub, b, tmp, 1, plan->sub->factors, -1);
+            for (k=0; k<2*m; k++)
+                b[k] /= m;
+        }
+        free(tmp);
+        return (plan);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_axes                                    *
+ *      Description     : Transforms complex data along each axis from  *
+ *                        first_axis on.                                *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - a size is less than 1.                   *
+ *      Parameters      :  data, ndim, dims, isign - as for VFFT.       *
+ *                         first_axis - the first axis transformed.     *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFT.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static int v_fft_axes ( double* data, int ndim, const int dims[],
+    int first_axis, int isign )
+{
+        FFTPlan *plan;
+        long total, stride;
+        int d, n, line, nlines, failed=0;
+
+        for (total=1,d=0; d<ndim; d++) {
+            if (dims[d] < 1)
+                return (5);
+            total *= dims[d];
+        }
+        for (stride=1,d=0; d<ndim; stride*=dims[d],d++) {
+            n = dims[d];
+            if (d<first_axis || n==1)
+                continue;
+            plan = v_fft_plan(n);
+            if (plan == NULL)
+                return (1);
+            nlines = (int)(total/n);
+
+            /* Consecutive lines go to the same thread, so each thread
+               works in one slab of the data. */
+#ifdef _OPENMP
+            #pragma omp parallel if (total >= FFT_PARALLEL_ELEMENTS)
+#endif
+            {
+                double *buf=(double *)malloc((4*n+4*plan->m)*sizeof(double));
+                long j;
+
+#ifdef _OPENMP
+                #pragma omp for schedule(static)
+#endif
+                for (line=0; line<nlines; line++) {
+                    /* first element of the line */
+                    double *p=data+2*((line/stride)*stride*n+line%stride);
+
+                    if (buf == NULL)
+                        continue;
+                    for (j=0; j<n; j++) {
+                        buf[2*j] = p[2*j*stride];
+                        buf[2*j+1] = p[2*j*stride+1];
+                    }
+                    v_fft_line(plan, buf, buf+2*n, buf+4*n, isign);
+                    for (j=0; j<n; j++) {
+                        p[2*j*stride] = buf[2*(n+j)];
+                        p[2*j*stride+1] = buf[2*(n+j)+1];
+                    }
+                }
+                if (buf == NULL)
+                    failed = 1;
+                else
+                    free(buf);
+            }
+            if (failed)
+                return (1);
+        }
+        return (0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_line                                    *
+ *      Description     : Transforms one line.                          *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  plan - the plan of the length.               *
+ *                         in - the line, complex, interleaved.         *
+ *                         out - the transform; it may not be in.       *
+ *                         work - 2*plan->m complex elements for        *
+ *                            Bluestein's algorithm.                    *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFFT.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_line ( const FFTPlan* plan, const double* in, double* out,
+    double* work, int isign )
+{
+        const double *c=plan->chirp, *b;
+        double *a, *f, s=isign<0? -1: 1;
+        int n=plan->n, m=plan->m, k;
+
+        if (m == 0) {
+            v_fft_work(plan, out, in, 1, plan->factors, isign);
+            return;
+        }
+        /* X[k] = w[k]*sum of x[j]*w[j]*conj(w[k-j]),
+           w[k] = exp(isign*i*pi*k*k/n) */
+        a = work;
+        f = work+2*m;
+        for (k=0; k<n; k++) {
+            a[2*k] = in[2*k]*c[2*k]-in[2*k+1]*s*c[2*k+1];
+            a[2*k+1] = in[2*k]*s*c[2*k+1]+in[2*k+1]*c[2*k];
+        }
+        for (k=2*n; k<2*m; k++)
+            a[k] = 0;
+        v_fft_work(plan->sub, f, a, 1, plan->sub->factors, -1);
+        b = plan->spectrum[isign > 0];
+        for (k=0; k<m; k++) {
+            double fr=f[2*k], fi=f[2*k+1];
+
+            f[2*k] = fr*b[2*k]-fi*b[2*k+1];
+            f[2*k+1] = fr*b[2*k+1]+fi*b[2*k];
+        }
+        v_fft_work(plan->sub, a, f, 1, plan->sub->factors, 1);
+        for (k=0; k<n; k++) {
+            out[2*k] = a[2*k]*c[2*k]-a[2*k+1]*s*c[2*k+1];
+            out[2*k+1] = a[2*k]*s*c[2*k+1]+a[2*k+1]*c[2*k];
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_work                                    *
+ *      Description     : Transforms every fstride-th element of in to  *
+ *                        out by transforming the subsequences of each  *
+ *                        residue modulo the first radix and combining  *
+ *                        them.                                         *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  plan - the plan of the whole length.         *
+ *                         out - factors[0]*factors[1] complex elements.*
+ *                         in - the first element.                      *
+ *                         fstride - the step between elements of in.   *
+ *                         factors - the remaining factors of the plan. *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_line.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_work ( const FFTPlan* plan, double* out, const double* in,
+    long fstride, const int* factors, int isign )
+{
+        int p=factors[0], m=factors[1], q;
+
+        if (m == 1)
+            for (q=0; q<p; q++) {
+                out[2*q] = in[2*q*fstride];
+                out[2*q+1] = in[2*q*fstride+1];
+            }
+        else
+            for (q=0; q<p; q++)
+                v_fft_work(plan, out+2*q*m, in+2*q*fstride, fstride*p,
+                    factors+2, isign);
+        switch (p) {
+            case 1:
+                break;
+            case 2:
+                v_fft_radix2(out, plan->twiddle, fstride, m, isign);
+                break;
+            case 3:
+                v_fft_radix3(out, plan->twiddle, fstride, m, isign);
+                break;
+            case 4:
+                v_fft_radix4(out, plan->twiddle, fstride, m, isign);
+                break;
+            default:
+                v_fft_generic(out, plan->twiddle, fstride, plan->n, p, m,
+                    isign);
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_radix2                                  *
+ *      Description     : Combines the transforms of two subsequences.  *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  f - 2*m complex elements.                    *
+ *                         tw - the twiddle factors of the plan.        *
+ *                         fstride - the step in tw.                    *
+ *                         m - the length of each subsequence.          *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_work.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_radix2 ( double* f, const double* tw, long fstride,
+    int m, int isign )
+{
+        double *g=f+2*m, s=isign<0? -1: 1, wr, wi, tr, ti;
+        int k;
+
+        for (k=0; k<m; k++,tw+=2*fstride) {
+            wr = tw[0];
+            wi = s*tw[1];
+            tr = g[2*k]*wr-g[2*k+1]*wi;
+            ti = g[2*k]*wi+g[2*k+1]*wr;
+            g[2*k] = f[2*k]-tr;
+            g[2*k+1] = f[2*k+1]-ti;
+            f[2*k] += tr;
+            f[2*k+1] += ti;
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_radix3                                  *
+ *      Description     : Combines the transforms of three              *
+ *                        subsequences.                                 *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  f - 3*m complex elements.                    *
+ *                         tw - the twiddle factors of the plan.        *
+ *                         fstride - the step in tw.                    *
+ *                         m - the length of each subsequence.          *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_work.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_radix3 ( double* f, const double* tw, long fstride,
+    int m, int isign )
+{
+        double *f1=f+2*m, *f2=f+4*m, s=isign<0? -1: 1,
+            h=s*sin(2*M_PI/3), ar, ai, br, bi, sr, si, dr, di;
+        int k;
+
+        for (k=0; k<m; k++) {
+            const double *t1=tw+2*k*fstride, *t2=tw+4*k*fstride;
+
+            ar = f1[2*k]*t1[0]-f1[2*k+1]*s*t1[1];
+            ai = f1[2*k]*s*t1[1]+f1[2*k+1]*t1[0];
+            br = f2[2*k]*t2[0]-f2[2*k+1]*s*t2[1];
+            bi = f2[2*k]*s*t2[1]+f2[2*k+1]*t2[0];
+            sr = ar+br;
+            si = ai+bi;
+            dr = h*(ar-br);
+            di = h*(ai-bi);
+            f1[2*k] = f[2*k]-.5*sr;
+            f1[2*k+1] = f[2*k+1]-.5*si;
+            f[2*k] += sr;
+            f[2*k+1] += si;
+            f2[2*k] = f1[2*k]+di;
+            f2[2*k+1] = f1[2*k+1]-dr;
+            f1[2*k] -= di;
+            f1[2*k+1] += dr;
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_radix4                                  *
+ *      Description     : Combines the transforms of four subsequences. *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  f - 4*m complex elements.                    *
+ *                         tw - the twiddle factors of the plan.        *
+ *                         fstride - the step in tw.                    *
+ *                         m - the length of each subsequence.          *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_work.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_radix4 ( double* f, const double* tw, long fstride,
+    int m, int isign )
+{
+        double *f1=f+2*m, *f2=f+4*m, *f3=f+6*m, s=isign<0? -1: 1,
+            ar, ai, br, bi, cr, ci, d0r, d0i, d1r, d1i, d2r, d2i;
+        int k;
+
+        for (k=0; k<m; k++) {
+            const double *t1=tw+2*k*fstride, *t2=tw+4*k*fstride,
+                *t3=tw+6*k*fstride;
+
+            ar = f1[2*k]*t1[0]-f1[2*k+1]*s*t1[1];
+            ai = f1[2*k]*s*t1[1]+f1[2*k+1]*t1[0];
+            br = f2[2*k]*t2[0]-f2[2*k+1]*s*t2[1];
+            bi = f2[2*k]*s*t2[1]+f2[2*k+1]*t2[0];
+            cr = f3[2*k]*t3[0]-f3[2*k+1]*s*t3[1];
+            ci = f3[2*k]*s*t3[1]+f3[2*k+1]*t3[0];
+            d0r = f[2*k]-br;
+            d0i = f[2*k+1]-bi;
+            f[2*k] += br;
+            f[2*k+1] += bi;
+            d1r = ar+cr;
+            d1i = ai+ci;
+            /* (a-c) times isign*i */
+            d2r = -s*(ai-ci);
+            d2i = s*(ar-cr);
+            f2[2*k] = f[2*k]-d1r;
+            f2[2*k+1] = f[2*k+1]-d1i;
+            f[2*k] += d1r;
+            f[2*k+1] += d1i;
+            f1[2*k] = d0r+d2r;
+            f1[2*k+1] = d0i+d2i;
+            f3[2*k] = d0r-d2r;
+            f3[2*k+1] = d0i-d2i;
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_fft_generic                                 *
+ *      Description     : Combines the transforms of p subsequences by  *
+ *                        direct evaluation.                            *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  f - p*m complex elements.                    *
+ *                         tw - the twiddle factors of the plan.        *
+ *                         fstride - the step in tw.                    *
+ *                         n - the length of the plan.                  *
+ *                         p - the radix, at most FFT_MAX_RADIX.        *
+ *                         m - the length of each subsequence.          *
+ *                         isign - as for VFFT.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_fft_work.                                   *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_fft_generic ( double* f, const double* tw, long fstride,
+    int n, int p, int m, int isign )
+{
+        double x[2*FFT_MAX_RADIX], s=isign<0? -1: 1, sr, si;
+        int u, q, q1;
+        long k, t;
+
+        for (u=0; u<m; u++) {
+            for (q=0; q<p; q++) {
+                x[2*q] = f[2*(u+q*m)];
+                x[2*q+1] = f[2*(u+q*m)+1];
+            }
+            for (q1=0; q1<p; q1++) {
+                k = u+q1*m;
+                sr = x[0];
+                si = x[1];
+                /* twiddle factor of subsequence q at output k */
+                for (t=0,q=1; q<p; q++) {
+                    t = (t+fstride*k)%n;
+                    sr += x[2*q]*tw[2*t]-x[2*q+1]*s*tw[2*t+1];
+                    si += x[2*q]*s*tw[2*t+1]+x[2*q+1]*tw[2*t];
+                }
+                f[2*k] = sr;
+                f[2*k+1] = si;
+            }
+        }
+}
@@ -0,0 +1,679 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************
+ *                                                                      *
+ *      Filename  : fuzzy_forest.c                                      *
+ *      Ext Funcs : VCreateFuzzyForest, VDestroyFuzzyForest,            *
+ *                  VClearFuzzyForest, VSetFuzzyForestAffinity,         *
+ *                  VSetFuzzyForestSeeds, VRunFuzzyForest.              *
+ *      Int Funcs : v_insert_cell, v_remove_cell, v_pop_cell,           *
+ *                  v_neighbor, v_offer, v_clear_cell, v_invalidate,    *
+ *                  v_add_seed, v_reseed.                               *
+ *                                                                      *
+ *      Keeps the fuzzy connectedness of a slice, absolute or relative  *
+ *      (object against background), as a forest of best paths from    *
+ *      the seeds, and brings it up to date when seeds come or go or    *
+ *      affinities change by propagating only from the cells concerned  *
+ *      (the differential image foresting transform).  When a cell is   *
+ *      taken by the other label or loses its path, the cells that      *
+ *      reached it through that path are cleared and take the best      *
+ *      path their neighbors offer again.                               *
+ *                                                                      *
+ *      The key of a cell is 2*(connectivity+1)+label, 0 if no path     *
+ *      reaches it, so that the background wins ties as in IRFC; the    *
+ *      label is always 0 for absolute connectedness.  A path is as     *
+ *      strong as its weakest step, and a step has the affinity of the  *
+ *      cell it leaves, toward the next, for the label of the path.     *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cv3dv.h>
+
+/* bits of VFuzzyForest.state */
+#define QUEUED   1
+#define DONE     2  /* propagated in this run */
+#define CLEARED  4  /* cleared by v_invalidate, not yet offered a path */
+#define SEED     8  /* given as a seed to VSetFuzzyForestSeeds */
+#define BG_SEED 16  /* given as a background seed */
+
+/* More changed affinities than one per this many cells rebuilds the
+   forest from its seeds. */
+#define AFFINITY_CHANGE_FRACTION 8
+
+static void v_insert_cell ( VFuzzyForest* forest, int cell, int key );
+static void v_remove_cell ( VFuzzyForest* forest, int cell );
+static int v_pop_cell ( VFuzzyForest* forest );
+static int v_neighbor ( const VFuzzyForest* forest, int cell,
+    int direction );
+static int v_offer ( const VFuzzyForest* forest, int cell, int direction );
+static void v_clear_cell ( VFuzzyForest* forest, int cell, int* head,
+    int* tail );
+static void v_invalidate ( VFuzzyForest* forest, int cell, int with_cell );
+static void v_add_seed ( VFuzzyForest* forest, int cell, int label );
+static void v_reseed ( VFuzzyForest* forest );
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VCreateFuzzyForest                            *
+ *      Description     : Makes an empty forest for a slice.            *
+ *      Return Value    :  The forest, or NULL if memory is not         *
+ *                         available or a parameter is out of range.    *
+ *      Parameters      :  width, height - the size of the slice.       *
+ *                         labels - 1 for absolute connectedness, 2 for *
+ *                            relative, label 1 being the background.   *
+ *                         max_connectivity - the connectivity of a     *
+ *                            seed, at most 65535.                      *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VDestroyFuzzyForest.                          *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+VFuzzyForest* VCreateFuzzyForest ( int width, int height, int labels,
+    int max_connectivity )
+{
+        VFuzzyForest *forest;
+        long size=(long)width*height;
+        int label, direction, j, ok;
+
+        if (width<1 || height<1 || labels<1 || labels>2 ||
+                max_connectivity<1 || max_connectivity>65535)
+            return (NULL);
+        forest = (VFuzzyForest *)calloc(1, sizeof(VFuzzyForest));
+        if (forest == NULL)
+            return (NULL);
+        forest->width = width;
+        forest->height = height;
+        forest->labels = labels;
+        forest->max_connectivity = max_connectivity;
+        forest->key = (int *)malloc(size*sizeof(int));
+        forest->pred = (int *)malloc(size*sizeof(int));
+        forest->next = (int *)malloc(size*sizeof(int));
+        forest->prev = (int *)malloc(size*sizeof(int));
+        forest->first = (int *)malloc((2*max_connectivity+4)*sizeof(int));
+        forest->state = (unsigned char *)malloc(size);
+        ok = forest->key && forest->pred && forest->next && forest->prev &&
+            forest->first && forest->state;
+        for (label=0; label<labels; label++)
+            for (direction=0; direction<4; direction++) {
+                forest->old_affinity[label][direction] =
+                    (unsigned short *)malloc(size*sizeof(short));
+                if (forest->old_affinity[label][direction] == NULL)
+                    ok = 0;
+            }
+        if (!ok) {
+            VDestroyFuzzyForest(forest);
+            return (NULL);
+        }
+        for (j=0; j<2*max_connectivity+4; j++)
+            forest->first[j] = -1;
+        forest->top = -1;
+        VClearFuzzyForest(forest);
+        return (forest);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VDestroyFuzzyForest                           *
+ *      Description     : Frees a forest.                               *
+ *      Return Value    :  None.                                        *
+ *      Parameters      :  forest - from VCreateFuzzyForest, or NULL.   *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VCreateFuzzyForest.                           *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VDestroyFuzzyForest ( VFuzzyForest* forest )
+{
+        int label, direction;
+
+        if (forest == NULL)
+            return;
+        free(forest->key);
+        free(forest->pred);
+        free(forest->next);
+        free(forest->prev);
+        free(forest->first);
+        free(forest->state);
+        free(forest->seed);
+        free(forest->seed_label);
+        for (label=0; label<2; label++)
+            for (direction=0; direction<4; direction++)
+                free(forest->old_affinity[label][direction]);
+        free(forest);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VClearFuzzyForest                             *
+ *      Description     : Takes away the seeds and the affinities of a  *
+ *                        forest, as for another slice.                 *
+ *      Return Value    :  None.                                        *
+ *      Parameters      :  forest - from VCreateFuzzyForest.            *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VCreateFuzzyForest.                           *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VClearFuzzyForest ( VFuzzyForest* forest )
+{
+        long size=(long)forest->width*forest->height, c;
+
+        while (v_pop_cell(forest) >= 0)
+            ;
+        for (c=0; c<size; c++) {
+            forest->key[c] = 0;
+            forest->pred[c] = -1;
+            forest->state[c] = 0;
+        }
+        forest->seeds = 0;
+        forest->affinity_set = 0;
+        forest->updated = 0;
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VSetFuzzyForestAffinity                       *
+ *      Description     : Gives a forest its affinities.  Where they    *
+ *                        differ from the last ones given, cells that   *
+ *                        can reach further are queued and paths whose  *
+ *                        steps got weaker are cleared, for             *
+ *                        VRunFuzzyForest to update; if many differ,    *
+ *                        the forest is grown again from its seeds.     *
+ *      Return Value    :  1 if the forest is grown again, else 0.      *
+ *      Parameters      :  forest - from VCreateFuzzyForest.            *
+ *                         affinity - for each label, the affinity from *
+ *                            each cell toward x+1, y+1, x-1 and y-1;   *
+ *                            entries toward cells outside the slice    *
+ *                            are not read.  They are used until the    *
+ *                            next call and must not change meanwhile.  *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VRunFuzzyForest.                              *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VSetFuzzyForestAffinity ( VFuzzyForest* forest,
+    const unsigned short* affinity[2][4] )
+{
+        long size=(long)forest->width*forest->height, changes=0, c,
+            lo[4], hi[4];
+        int label, direction, d, regrow;
+
+        /* cells lo to hi-1 have a neighbor in each direction */
+        lo[0] = lo[1] = 0;
+        lo[2] = 1;
+        lo[3] = forest->width;
+        hi[0] = size-1;
+        hi[1] = size-forest->width;
+        hi[2] = hi[3] = size;
+
+        regrow = !forest->affinity_set;
+        for (label=0; !regrow&&label<forest->labels; label++)
+            for (direction=0; !regrow&&direction<4; direction++) {
+                const unsigned short *new_a=affinity[label][direction],
+                    *old=forest->old_affinity[label][direction];
+
+                if (memcmp(new_a+lo[direction], old+lo[direction],
+                        (hi[direction]-lo[direction])*sizeof(short)) == 0)
+                    continue;
+                for (c=lo[direction]; c<hi[direction]; c++)
+                    if (new_a[c]!=old[c] &&
+                            ++changes>size/AFFINITY_CHANGE_FRACTION) {
+                        regrow = 1;
+                        break;
+                    }
+            }
+
+        if (!regrow && changes)
+            for (label=0; label<forest->labels; label++)
+                for (direction=0; direction<4; direction++) {
+                    const unsigned short *new_a=affinity[label][direction],
+                        *old=forest->old_affinity[label][direction];
+
+                    for (c=lo[direction]; c<hi[direction]; c++) {
+                        if (new_a[c]==old[c] || forest->key[c]==0 ||
+                                (forest->key[c]&1)!=label)
+                            continue;
+                        d = v_neighbor(forest, (int)c, direction);
+                        if (d < 0)
+                            continue;
+                        if (new_a[c] > old[c]) {
+                            if ((forest->state[c]&QUEUED) == 0)
+                                v_insert_cell(forest, (int)c,
+                                    forest->key[c]);
+                        }
+                        else if (forest->pred[d] == c)
+                            v_invalidate(forest, d, 1);
+                    }
+                }
+
+        for (label=0; label<forest->labels; label++) {
+            for (direction=0; direction<4; direction++) {
+                forest->affinity[label][direction] =
+                    affinity[label][direction];
+                memcpy(forest->old_affinity[label][direction]+lo[direction],
+                    affinity[label][direction]+lo[direction],
+                    (hi[direction]-lo[direction])*sizeof(short));
+            }
+        }
+        forest->affinity_set = 1;
+        if (regrow)
+            v_reseed(forest);
+        return (regrow);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VSetFuzzyForestSeeds                          *
+ *      Description     : Gives a forest its seeds.  The cells reached  *
+ *                        from seeds it had that are not given are      *
+ *                        cleared, and new seeds are queued, for        *
+ *                        VRunFuzzyForest to update.  Where seeds of    *
+ *                        both labels are given at a cell, the          *
+ *                        background seed counts.                       *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation failure.               *
+ *      Parameters      :  forest - from VCreateFuzzyForest.            *
+ *                         cells - the seeds, as x+width*y.             *
+ *                         labels - the label of each seed, or NULL if  *
+ *                            all are 0.                                *
+ *                         nseeds - the number of seeds.                *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VRunFuzzyForest.                              *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VSetFuzzyForestSeeds ( VFuzzyForest* forest, const int* cells,
+    const unsigned char* labels, int nseeds )
+{
+        int j, c, seed_key=2*forest->max_connectivity+2;
+
+        if (nseeds > forest->seeds_allocated) {
+            int *seed=(int *)realloc(forest->seed, nseeds*sizeof(int));
+            unsigned char *seed_label;
+
+            if (seed == NULL)
+                return (1);
+            forest->seed = seed;
+            seed_label = (unsigned char *)realloc(forest->seed_label, nseeds);
+            if (seed_label == NULL)
+                return (1);
+            forest->seed_label = seed_label;
+            forest->seeds_allocated = nseeds;
+        }
+
+        /* take away the old seeds not given, or not as background */
+        for (j=0; j<nseeds; j++)
+            forest->state[cells[j]] |= labels&&labels[j]? SEED|BG_SEED: SEED;
+        for (j=0; j<forest->seeds; j++) {
+            c = forest->seed[j];
+            if ((forest->state[c]&SEED)==0 ||
+                    (forest->seed_label[j] && (forest->state[c]&BG_SEED)==0))
+                if (forest->pred[c]==-1 && forest->key[c]>=seed_key)
+                    v_invalidate(forest, c, 1);
+        }
+        for (j=0; j<nseeds; j++)
+            forest->state[cells[j]] &= ~(SEED|BG_SEED);
+
+        for (j=0; j<nseeds; j++)
+            v_add_seed(forest, cells[j], labels? labels[j]: 0);
+        memcpy(forest->seed, cells, nseeds*sizeof(int));
+        for (j=0; j<nseeds; j++)
+            forest->seed_label[j] = labels? labels[j]: 0;
+        forest->seeds = nseeds;
+        return (0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VRunFuzzyForest                               *
+ *      Description     : Propagates the queued cells of a forest until *
+ *                        each cell has the best path its neighbors     *
+ *                        offer.                                        *
+ *      Return Value    :  The number of cells propagated.              *
+ *      Parameters      :  forest - from VCreateFuzzyForest, with       *
+ *                            affinities given.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VSetFuzzyForestAffinity, VSetFuzzyForestSeeds.*
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+long VRunFuzzyForest ( VFuzzyForest* forest )
+{
+        int c, d, k, direction, done=-1;
+        long updated=0;
+
+        /* cells done are listed through next */
+        while ((c = v_pop_cell(forest)) >= 0) {
+            forest->state[c] |= DONE;
+            forest->next[c] = done;
+            done = c;
+            updated++;
+            for (direction=0; direction<4; direction++) {
+                d = v_neighbor(forest, c, direction);
+                if (d<0 || (forest->state[d]&DONE))
+                    continue;
+                k = v_offer(forest, c, direction);
+                if (k <= forest->key[d])
+                    continue;
+                if (forest->key[d] && (forest->key[d]&1)!=(k&1)) {
+                    /* what d reached with its old label must go again */
+                    v_insert_cell(forest, d, k);
+                    forest->pred[d] = c;
+                    v_invalidate(forest, d, 0);
+                }
+                else {
+                    v_insert_cell(forest, d, k);
+                    forest->pred[d] = c;
+                }
+            }
+        }
+        for (; done>=0; done=forest->next[done])
+            forest->state[done] &= ~DONE;
+        forest->updated = updated;
+        return (updated);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_insert_cell                                 *
+ *      Description     : Gives a cell a key and queues it, first       *
+ *                        taking it out of the queue if it is there.    *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *                         key - the new key.                           *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_remove_cell, v_pop_cell.                    *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_insert_cell ( VFuzzyForest* forest, int cell, int key )
+{
+        if (forest->state[cell] & QUEUED)
+            v_remove_cell(forest, cell);
+        forest->key[cell] = key;
+        forest->prev[cell] = -1;
+        forest->next[cell] = forest->first[key];
+        if (forest->first[key] >= 0)
+            forest->prev[forest->first[key]] = cell;
+        forest->first[key] = cell;
+        forest->state[cell] |= QUEUED;
+        if (key > forest->top)
+            forest->top = key;
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_remove_cell                                 *
+ *      Description     : Takes a queued cell out of the queue.         *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_insert_cell.                                *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_remove_cell ( VFuzzyForest* forest, int cell )
+{
+        if (forest->prev[cell] >= 0)
+            forest->next[forest->prev[cell]] = forest->next[cell];
+        else
+            forest->first[forest->key[cell]] = forest->next[cell];
+        if (forest->next[cell] >= 0)
+            forest->prev[forest->next[cell]] = forest->prev[cell];
+        forest->state[cell] &= ~QUEUED;
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_pop_cell                                    *
+ *      Description     : Takes a cell of the largest key out of the    *
+ *                        queue.                                        *
+ *      Return Value    : The cell, or -1 if the queue is empty.        *
+ *      Parameters      :  forest - the forest.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_insert_cell.                                *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static int v_pop_cell ( VFuzzyForest* forest )
+{
+        int cell;
+
+        while (forest->top>=0 && forest->first[forest->top]<0)
+            forest->top--;
+        if (forest->top < 0)
+            return (-1);
+        cell = forest->first[forest->top];
+        v_remove_cell(forest, cell);
+        return (cell);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_neighbor                                    *
+ *      Description     : Returns the neighbor of a cell.               *
+ *      Return Value    : The neighbor, or -1 outside the slice.        *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *                         direction - 0 toward x+1, 1 toward y+1,      *
+ *                            2 toward x-1, 3 toward y-1.               *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : None.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static int v_neighbor ( const VFuzzyForest* forest, int cell,
+    int direction )
+{
+        switch (direction) {
+            case 0:
+                return (cell%forest->width<forest->width-1? cell+1: -1);
+            case 1:
+                return (cell<forest->width*(forest->height-1)?
+                    cell+forest->width: -1);
+            case 2:
+                return (cell%forest->width>0? cell-1: -1);
+            default:
+                return (cell>=forest->width? cell-forest->width: -1);
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_offer                                       *
+ *      Description     : Returns the key a cell offers a neighbor by   *
+ *                        extending its path.                           *
+ *      Return Value    : The key.                                      *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell, reached by a path.          *
+ *                         direction - toward the neighbor, as for      *
+ *                            v_neighbor.                               *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : None.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static int v_offer ( const VFuzzyForest* forest, int cell, int direction )
+{
+        int label=forest->key[cell]&1, conn=forest->key[cell]/2-1, a;
+
+        a = forest->affinity[label][direction][cell];
+        return (2*(a<conn? a: conn)+2+label);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_clear_cell                                  *
+ *      Description     : Takes a cell off its path and out of the      *
+ *                        queue and adds it to a list.                  *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *                         head, tail - the list, linked through next.  *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : v_invalidate.                                 *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_clear_cell ( VFuzzyForest* forest, int cell, int* head,
+    int* tail )
+{
+        if (forest->state[cell] & QUEUED)
+            v_remove_cell(forest, cell);
+        forest->state[cell] |= CLEARED;
+        forest->key[cell] = 0;
+        forest->pred[cell] = -1;
+        forest->next[cell] = -1;
+        if (*tail >= 0)
+            forest->next[*tail] = cell;
+        else
+            *head = cell;
+        *tail = cell;
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_invalidate                                  *
+ *      Description     : Clears the cells whose paths pass through a   *
+ *                        cell, then gives each the best key offered by *
+ *                        its neighbors not cleared, and queues it.     *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *                         with_cell - non-zero to clear the cell too.  *
+ *      Side effects    : None.                                         *
+ *      Entry condition : No cell whose path passes through the cell    *
+ *                        may be done in this run.                      *
+ *      Related funcs   : v_clear_cell.                                 *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_invalidate ( VFuzzyForest* forest, int cell, int with_cell )
+{
+        int head=-1, tail=-1, c, x, d, k, next, direction;
+
+        if (with_cell)
+            v_clear_cell(forest, cell, &head, &tail);
+        else
+            for (direction=0; direction<4; direction++) {
+                x = v_neighbor(forest, cell, direction);
+                if (x>=0 && forest->pred[x]==cell)
+                    v_clear_cell(forest, x, &head, &tail);
+            }
+        for (c=head; c>=0; c=forest->next[c])
+            for (direction=0; direction<4; direction++) {
+                x = v_neighbor(forest, c, direction);
+                if (x>=0 && forest->pred[x]==c)
+                    v_clear_cell(forest, x, &head, &tail);
+            }
+
+        for (x=head; x>=0; x=next) {
+            next = forest->next[x];
+            for (direction=0; direction<4; direction++) {
+                d = v_neighbor(forest, x, direction);
+                if (d<0 || forest->key[d]==0 || (forest->state[d]&CLEARED))
+                    continue;
+                k = v_offer(forest, d, direction^2);
+                if (k > forest->key[x]) {
+                    forest->key[x] = k;
+                    forest->pred[x] = d;
+                }
+            }
+            forest->state[x] &= ~CLEARED;
+            if (forest->key[x])
+                v_insert_cell(forest, x, forest->key[x]);
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_add_seed                                    *
+ *      Description     : Makes a cell a seed unless its key is as      *
+ *                        large already.                                *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *                         cell - the cell.                             *
+ *                         label - the label of the seed.               *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VSetFuzzyForestSeeds.                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_add_seed ( VFuzzyForest* forest, int cell, int label )
+{
+        int key=2*forest->max_connectivity+2+label, new_label;
+
+        if (key <= forest->key[cell])
+            return;
+        new_label = forest->key[cell] && (forest->key[cell]&1)!=label;
+        v_insert_cell(forest, cell, key);
+        forest->pred[cell] = -1;
+        if (new_label)
+            v_invalidate(forest, cell, 0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_reseed                                      *
+ *      Description     : Clears every cell of a forest and queues its  *
+ *                        seeds.                                        *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  forest - the forest.                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VSetFuzzyForestAffinity.                      *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_reseed ( VFuzzyForest* forest )
+{
+        long size=(long)forest->width*forest->height, c;
+        int j;
+
+        while (v_pop_cell(forest) >= 0)
+            ;
+        for (c=0; c<size; c++) {
+            forest->key[c] = 0;
+            forest->pred[c] = -1;
+        }
+        for (j=0; j<forest->seeds; j++)
+            v_add_seed(forest, forest->seed[j], forest->seed_label[j]);
+}
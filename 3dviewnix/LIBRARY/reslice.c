@@ -0,0 +1,289 @@
+/*
+  Copyright 1993-2013, 2017 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************
+ *                                                                      *
+ *      Filename  : reslice.c                                           *
+ *      Ext Funcs : VResliceSlice.                                      *
+ *      Int Funcs : v_reslice_cell, v_reslice_row.                      *
+ *                                                                      *
+ *      Samples a scene held in memory on an arbitrary plane.  The      *
+ *      position of a pixel is stepped along each row from the start of *
+ *      the row, the way exec_regist steps through a volume, and the    *
+ *      rows of the plane are shared among threads.  Pixels whose       *
+ *      neighborhood lies inside the scene are taken directly from the  *
+ *      data; only pixels at the border of the scene check each cell.   *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <cv3dv.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define RESLICE_PARALLEL_PIXELS 0x4000  /* smaller planes use one thread */
+#define Floor(x) ((int)(x)<=(x)? (int)(x): (int)(x)-1)
+
+typedef struct {
+        const unsigned char *data;
+        int bits, width, height, slices;
+        long plane;         /* cells per slice */
+        long slice_bytes;   /* bytes from one slice to the next */
+} ResliceSource;
+
+static double v_reslice_cell ( const ResliceSource* src, int x, int y,
+    int z );
+static void v_reslice_row ( const ResliceSource* src, const double p0[3],
+    const double u[3], int width, int flags, void* out, int out_bits );
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VResliceSlice                                 *
+ *      Description     : Computes a slice of a scene on the plane      *
+ *                        origin + i*v + j*u, where j is the column and *
+ *                        i the row of the output pixel, by trilinear   *
+ *                        interpolation or nearest neighbor.  With      *
+ *                        VRESLICE_ZERO_PAD, cells just outside the     *
+ *                        scene count as 0, so a pixel is computed      *
+ *                        within one cell of the scene as reslice_proc  *
+ *                        does; otherwise a pixel is computed only if   *
+ *                        all its neighbors are inside the scene, as    *
+ *                        for display.  Pixels not computed are 0.      *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         5 - unsupported number of bits.              *
+ *      Parameters      :  data - the scene, slices one after another;  *
+ *                            if bits is 1, each slice is packed and    *
+ *                            starts on a byte.                         *
+ *                         bits - 1, 8 or 16 bits per cell, unsigned.   *
+ *                         width, height, slices - the size of the      *
+ *                            scene in cells.                           *
+ *                         origin - the position of pixel (0, 0) in     *
+ *                            units of cells of the scene.              *
+ *                         u, v - the steps between columns and rows.   *
+ *                         out_width, out_height - the size of the      *
+ *                            slice in pixels.                          *
+ *                         flags - VRESLICE_LINEAR for trilinear        *
+ *                            interpolation, VRESLICE_ZERO_PAD for the  *
+ *                            border as described above.                *
+ *                         out - the slice, out_width*out_height cells. *
+ *                         out_bits - 8 or 16.  For binary scenes the   *
+ *                            output is 8 bits, 1 where the (rounded)   *
+ *                            value is on.                              *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : None.                                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VResliceSlice ( const void* data, int bits, int width, int height,
+    int slices, const double origin[3], const double u[3],
+    const double v[3], int out_width, int out_height, int flags, void* out,
+    int out_bits )
+{
+        ResliceSource src;
+        int i;
+
+        if ((bits!=1 && bits!=8 && bits!=16) || (out_bits!=8 && out_bits!=16)
+                || (bits==1 && out_bits!=8))
+            return (5);
+        src.data = (const unsigned char *)data;
+        src.bits = bits;
+        src.width = width;
+        src.height = height;
+        src.slices = slices;
+        src.plane = (long)width*height;
+        src.slice_bytes = bits==1? (src.plane+7)/8: src.plane*(bits/8);
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 4) \
+            if ((long)out_width*out_height >= RESLICE_PARALLEL_PIXELS)
+#endif
+        for (i=0; i<out_height; i++) {
+            double p0[3];
+
+            p0[0] = origin[0] + i*v[0];
+            p0[1] = origin[1] + i*v[1];
+            p0[2] = origin[2] + i*v[2];
+            v_reslice_row(&src, p0, u, out_width, flags, out_bits==16?
+                (void *)((unsigned short *)out+(long)i*out_width):
+                (void *)((unsigned char *)out+(long)i*out_width), out_bits);
+        }
+        return (0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_reslice_cell                                *
+ *      Description     : Returns the value of a cell, 0 outside the    *
+ *                        scene; on cells of binary scenes are 255.     *
+ *      Return Value    : The cell value.                               *
+ *      Parameters      :  src - the scene.                             *
+ *                         x, y, z - the cell.                          *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VResliceSlice.                                *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static double v_reslice_cell ( const ResliceSource* src, int x, int y,
+    int z )
+{
+        long n;
+
+        if (x<0 || x>=src->width || y<0 || y>=src->height || z<0 ||
+                z>=src->slices)
+            return (0);
+        n = (long)y*src->width+x;
+        switch (src->bits) {
+            case 1:
+                return (src->data[z*src->slice_bytes+(n>>3)]&(0x80>>(n&7))?
+                    255: 0);
+            case 8:
+                return (src->data[z*src->slice_bytes+n]);
+            default:
+                return (((const unsigned short *)src->data)[z*src->plane+n]);
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : v_reslice_row                                 *
+ *      Description     : Computes one row of a slice for VResliceSlice.*
+ *                        The interpolation is evaluated in the same    *
+ *                        order as reslice_proc, so results agree with  *
+ *                        it to the bit.                                *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  src - the scene.                             *
+ *                         p0 - the position of the first pixel.        *
+ *                         u - the step between pixels.                 *
+ *                         width - the number of pixels.                *
+ *                         flags - as for VResliceSlice.                *
+ *                         out - the row.                               *
+ *                         out_bits - 8 or 16.                          *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VResliceSlice.                                *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+static void v_reslice_row ( const ResliceSource* src, const double p0[3],
+    const double u[3], int width, int flags, void* out, int out_bits )
+{
+        unsigned char *out8=(unsigned char *)out;
+        unsigned short *out16=(unsigned short *)out;
+        double lo, xhi, yhi, zhi, px, py, pz, dx, dy, dz, c[8], a, b, val;
+        int j, x, y, z, w=src->width;
+        long plane=src->plane;
+
+        /* Range of positions computed on each axis */
+        if (flags & VRESLICE_ZERO_PAD) {
+            lo = -1;
+            xhi = src->width;
+            yhi = src->height;
+            zhi = src->slices;
+        }
+        else {
+            lo = 0;
+            xhi = src->width-1;
+            yhi = src->height-1;
+            zhi = src->slices-1;
+        }
+        for (j=0; j<width; j++) {
+            px = p0[0] + j*u[0];
+            py = p0[1] + j*u[1];
+            pz = p0[2] + j*u[2];
+            if (px<lo || px>=xhi || py<lo || py>=yhi || pz<lo || pz>=zhi) {
+                if (out_bits == 16)
+                    out16[j] = 0;
+                else
+                    out8[j] = 0;
+                continue;
+            }
+            x = Floor(px);
+            y = Floor(py);
+            z = Floor(pz);
+            dx = px-x;
+            dy = py-y;
+            dz = pz-z;
+            if (!(flags & VRESLICE_LINEAR)) {
+                if (dx >= .5)
+                    x++;
+                if (dy >= .5)
+                    y++;
+                if (dz >= .5)
+                    z++;
+                val = v_reslice_cell(src, x, y, z);
+                if (src->bits == 1)
+                    out8[j] = val != 0;
+                else if (out_bits == 16)
+                    out16[j] = (unsigned short)val;
+                else
+                    out8[j] = (unsigned char)val;
+                continue;
+            }
+            if (src->bits!=1 && x>=0 && x<src->width-1 && y>=0 &&
+                    y<src->height-1 && z>=0 && z<src->slices-1) {
+                long n=z*plane+(long)y*w+x;
+
+                if (src->bits == 16) {
+                    const unsigned short *p1=
+                        (const unsigned short *)src->data+n, *p2=p1+plane;
+
+                    c[0] = p1[0];  c[1] = p1[1];
+                    c[2] = p1[w];  c[3] = p1[w+1];
+                    c[4] = p2[0];  c[5] = p2[1];
+                    c[6] = p2[w];  c[7] = p2[w+1];
+                }
+                else {
+                    const unsigned char *p1=src->data+n, *p2=p1+plane;
+
+                    c[0] = p1[0];  c[1] = p1[1];
+                    c[2] = p1[w];  c[3] = p1[w+1];
+                    c[4] = p2[0];  c[5] = p2[1];
+                    c[6] = p2[w];  c[7] = p2[w+1];
+                }
+            }
+            else {
+                c[0] = v_reslice_cell(src, x, y, z);
+                c[1] = v_reslice_cell(src, x+1, y, z);
+                c[2] = v_reslice_cell(src, x, y+1, z);
+                c[3] = v_reslice_cell(src, x+1, y+1, z);
+                c[4] = v_reslice_cell(src, x, y, z+1);
+                c[5] = v_reslice_cell(src, x+1, y, z+1);
+                c[6] = v_reslice_cell(src, x, y+1, z+1);
+                c[7] = v_reslice_cell(src, x+1, y+1, z+1);
+            }
+            a = (1-dz)*((1-dy)*((1-dx)*c[0] + dx*c[1]) +
+                            dy*((1-dx)*c[2] + dx*c[3]));
+            b = dz*((1-dy)*((1-dx)*c[4] + dx*c[5]) +
+                        dy*((1-dx)*c[6] + dx*c[7]));
+            if (src->bits == 1)
+                out8[j] = a+b >= 127.5;
+            else if (out_bits == 16)
+                out16[j] = (unsigned short)(.5+a+b);
+            else
+                out8[j] = (unsigned char)(.5+a+b);
+        }
+}
@@ -0,0 +1,652 @@
+/*
+  Copyright 1993-2013, 2017 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/************************************************************************
+ *                                                                      *
+ *      Filename  : scene_stats.c                                       *
+ *      Ext Funcs : VInitSceneStats, VAccumulateSceneStats,             *
+ *                  VFinishSceneStats, VFreeSceneStats,                 *
+ *                  VGetSceneFileStats, VLookupSceneFileStats,          *
+ *                  VStoreSceneFileStats, VEnableSceneStatsCache.       *
+ *      Int Funcs : v_accumulate_block, v_stats_cache_name,             *
+ *                  v_scene_slices.                                     *
+ *                                                                      *
+ *      8- and 16-bit cells are counted in one histogram per thread;    *
+ *      count, sum, sum of squares, minimum and maximum are derived     *
+ *      from the merged histogram, so a scene is read only once.  The   *
+ *      statistics of whole IM0/BIM files are kept in a cache directory *
+ *      (VIEWNIX_STATS_CACHE, else .cavass_stats in the home directory, *
+ *      which only VEnableSceneStatsCache creates; an empty             *
+ *      VIEWNIX_STATS_CACHE turns the cache off), keyed by the full     *
+ *      path, inode, size and modification time, to the nanosecond, of  *
+ *      the file.  Files modified in the last STATS_SETTLE seconds are  *
+ *      not cached, as they may be rewritten within the resolution of   *
+ *      the file system's time stamps.                                  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <cv3dv.h>
+
+#if defined (WIN32) || defined (_WIN32)
+#include <direct.h>
+#define v_mkdir(dir) _mkdir(dir)
+#else
+#define v_mkdir(dir) mkdir(dir, 0777)
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#define omp_get_thread_num()  0
+#endif
+
+#define STATS_BLOCK 0x10000         /* cells per unit of parallel work */
+#define STATS_READ_CELLS 0x400000   /* cells per read from a file */
+#define STATS_CACHE_MAGIC "CAVASS scene statistics 2"
+#define STATS_SETTLE 2              /* seconds before a file is cached */
+
+#if defined (WIN32) || defined (_WIN32)
+#define v_mtime_nsec(sb) 0L
+#elif defined (__APPLE__)
+#define v_mtime_nsec(sb) ((long)(sb).st_mtimespec.tv_nsec)
+#else
+#define v_mtime_nsec(sb) ((long)(sb).st_mtim.tv_nsec)
+#endif
+
+/* What identifies the contents of a file */
+typedef struct {
+        double size, inode;
+        long mtime, mtime_nsec;
+} FileStamp;
+
+typedef struct {
+        double count, sum, sum_sqr, min, max;
+} ThreadMoments;
+
+static void v_accumulate_block ( VSceneStats* st, int thread,
+    const void* data, const unsigned char* mask, long j0, long j1 );
+static int v_stats_cache_name ( const char* filename, char** cache_name,
+    char** full_path, FileStamp* stamp );
+static int v_scene_slices ( ViewnixHeader* vh );
+
+static int v_stats_cache_create=0;
+
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VInitSceneStats                               *
+ *      Description     : Prepares st to accumulate statistics of cells *
+ *                        of the given size and signedness.             *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         5 - unsupported number of bits.              *
+ *      Parameters      :  st - the statistics to initialize.           *
+ *                         bits - 8, 16 or 32.                          *
+ *                         is_signed - non-zero for two's complement.   *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VAccumulateSceneStats, VFreeSceneStats.       *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VInitSceneStats ( VSceneStats* st, int bits, int is_signed )
+{
+        memset(st, 0, sizeof(*st));
+        if (bits!=8 && bits!=16 && bits!=32)
+            return (5);
+        st->bits = bits;
+        st->is_signed = is_signed!=0;
+        st->nthreads = omp_get_max_threads();
+        if (bits == 32) {
+            ThreadMoments *m;
+            int t;
+
+            m = (ThreadMoments *)malloc(st->nthreads*sizeof(ThreadMoments));
+            if (m == NULL)
+                return (1);
+            for (t=0; t<st->nthreads; t++) {
+                m[t].count = m[t].sum = m[t].sum_sqr = 0;
+                m[t].min = 1e300;
+                m[t].max = -1e300;
+            }
+            st->thread_data = m;
+            return (0);
+        }
+        st->hist_size = 1<<bits;
+        st->hist_min = st->is_signed? -(st->hist_size/2): 0;
+        st->hist = (double *)calloc(st->hist_size, sizeof(double));
+        st->thread_data = calloc((size_t)st->nthreads*st->hist_size,
+            sizeof(unsigned long long));
+        if (st->hist==NULL || st->thread_data==NULL) {
+            VFreeSceneStats(st);
+            return (1);
+        }
+        return (0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VAccumulateSceneStats                         *
+ *      Description     : Adds ncells cells of data to st, skipping     *
+ *                        those whose mask byte is zero.  Blocks of the *
+ *                        data are counted by parallel threads.         *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  st - statistics from VInitSceneStats.        *
+ *                         data - cells of st->bits bits each.          *
+ *                         mask - one byte per cell, or NULL for all.   *
+ *                         ncells - the number of cells.                *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VFinishSceneStats.                            *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VAccumulateSceneStats ( VSceneStats* st, const void* data,
+    const unsigned char* mask, long ncells )
+{
+        int b, nblocks;
+
+        nblocks = (int)((ncells+STATS_BLOCK-1)/STATS_BLOCK);
+        if (nblocks <= 1) {
+            v_accumulate_block(st, 0, data, mask, 0, ncells);
+            return;
+        }
+#pragma omp parallel for num_threads(st->nthreads) schedule(static)
+        for (b=0; b<nblocks; b++) {
+            long j1 = (long)(b+1)*STATS_BLOCK;
+            v_accumulate_block(st, omp_get_thread_num(), data, mask,
+                (long)b*STATS_BLOCK, j1<ncells? j1: ncells);
+        }
+}
+
+#define V_HIST_LOOP(type) { \
+            const type *d=(const type *)data; \
+            if (mask) { \
+                for (j=j0; j<j1; j++) \
+                    if (mask[j]) \
+                        h[d[j]]++; \
+            } \
+            else \
+                for (j=j0; j<j1; j++) \
+                    h[d[j]]++; \
+        }
+
+static void v_accumulate_block ( VSceneStats* st, int thread,
+    const void* data, const unsigned char* mask, long j0, long j1 )
+{
+        long j;
+        double v;
+
+        if (st->bits == 32) {
+            ThreadMoments *m = (ThreadMoments *)st->thread_data+thread;
+
+            for (j=j0; j<j1; j++) {
+                if (mask && mask[j]==0)
+                    continue;
+                v = st->is_signed? (double)((const int *)data)[j]:
+                    (double)((const unsigned int *)data)[j];
+                m->count++;
+                m->sum += v;
+                m->sum_sqr += v*v;
+                if (v < m->min) m->min = v;
+                if (v > m->max) m->max = v;
+            }
+        }
+        else {
+            unsigned long long *h = (unsigned long long *)st->thread_data+
+                (size_t)thread*st->hist_size-st->hist_min;
+
+            if (st->bits == 8) {
+                if (st->is_signed) V_HIST_LOOP(signed char)
+                else               V_HIST_LOOP(unsigned char)
+            }
+            else {
+                if (st->is_signed) V_HIST_LOOP(short)
+                else               V_HIST_LOOP(unsigned short)
+            }
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFinishSceneStats                             *
+ *      Description     : Merges the counts of the threads into         *
+ *                        st->hist, count, sum, sum_sqr, min and max.   *
+ *                        More data may be accumulated afterwards and   *
+ *                        the statistics finished again.                *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  st - statistics from VInitSceneStats.        *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VAccumulateSceneStats.                        *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VFinishSceneStats ( VSceneStats* st )
+{
+        int t, k;
+
+        st->count = st->sum = st->sum_sqr = 0;
+        st->min = st->max = 0;
+        if (st->bits == 32) {
+            ThreadMoments *m = (ThreadMoments *)st->thread_data;
+
+            for (t=0; t<st->nthreads; t++) {
+                if (m[t].count == 0)
+                    continue;
+                if (st->count==0 || m[t].min<st->min) st->min = m[t].min;
+                if (st->count==0 || m[t].max>st->max) st->max = m[t].max;
+                st->count += m[t].count;
+                st->sum += m[t].sum;
+                st->sum_sqr += m[t].sum_sqr;
+            }
+            return;
+        }
+        for (k=0; k<st->hist_size; k++) {
+            unsigned long long *h = (unsigned long long *)st->thread_data+k;
+            double c=0, v=k+st->hist_min;
+
+            for (t=0; t<st->nthreads; t++, h+=st->hist_size)
+                c += (double)*h;
+            st->hist[k] = c;
+            if (c == 0)
+                continue;
+            if (st->count == 0)
+                st->min = v;
+            st->max = v;
+            st->count += c;
+            st->sum += c*v;
+            st->sum_sqr += c*v*v;
+        }
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VFreeSceneStats                               *
+ *      Description     : Frees the memory held by st.                  *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  st - statistics from VInitSceneStats.        *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VInitSceneStats.                              *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VFreeSceneStats ( VSceneStats* st )
+{
+        if (st->hist)
+            free(st->hist);
+        if (st->thread_data)
+            free(st->thread_data);
+        st->hist = NULL;
+        st->thread_data = NULL;
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VGetSceneFileStats                            *
+ *      Description     : Computes the statistics of all cells of an    *
+ *                        IM0 or BIM file, or takes them from the cache *
+ *                        if the file has not changed since they were   *
+ *                        stored.  Binary cells are counted as 8-bit    *
+ *                        values 0 and 1.                               *
+ *      Return Value    :  0 - work successfully.                       *
+ *                         1 - memory allocation error.                 *
+ *                         4 - file open error.                         *
+ *                         5 - not an IM0 file of 1, 8, 16 or 32 bits.  *
+ *                         Errors of VReadHeader and VReadData.         *
+ *      Parameters      :  filename - the scene file.                   *
+ *                         st - receives the finished statistics; free  *
+ *                              them with VFreeSceneStats.              *
+ *      Side effects    : The statistics are stored in the cache.       *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VLookupSceneFileStats, VStoreSceneFileStats.  *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VGetSceneFileStats ( const char* filename, VSceneStats* st )
+{
+        FILE *fp;
+        ViewnixHeader vh;
+        char group[6], elem[6];
+        int error, bits, is_signed, slices, slice_cells, slice_bytes,
+            slices_per_read, i, n, num;
+        unsigned char *data, *cells;
+
+        fp = fopen(filename, "rb");
+        if (fp == NULL)
+            return (4);
+        error = VReadHeader(fp, &vh, group, elem);
+        if (error && error<=104) {
+            fclose(fp);
+            return (error);
+        }
+        bits = vh.scn.num_of_bits;
+        if (vh.gen.data_type!=IMAGE0 ||
+                (bits!=1 && bits!=8 && bits!=16 && bits!=32)) {
+            fclose(fp);
+            return (5);
+        }
+        is_signed = bits>1 && vh.scn.signed_bits_valid && vh.scn.signed_bits[0];
+        if (VLookupSceneFileStats(filename, bits==1? 8: bits, is_signed, st)
+                == 0) {
+            fclose(fp);
+            return (0);
+        }
+        error = VInitSceneStats(st, bits==1? 8: bits, is_signed);
+        if (error) {
+            fclose(fp);
+            return (error);
+        }
+
+        slices = v_scene_slices(&vh);
+        slice_cells = vh.scn.xysize[0]*vh.scn.xysize[1];
+        if (bits == 1) {
+            slice_bytes = (slice_cells+7)/8;
+            slices_per_read = 1;
+        }
+        else {
+            slice_bytes = slice_cells*(bits/8);
+            slices_per_read = slice_cells? STATS_READ_CELLS/slice_cells: 1;
+            if (slices_per_read < 1)
+                slices_per_read = 1;
+            if (slices_per_read > slices)
+                slices_per_read = slices;
+        }
+        data = (unsigned char *)malloc((size_t)slices_per_read*slice_bytes+1);
+        cells = bits==1? (unsigned char *)malloc(slice_cells+1): data;
+        if (data==NULL || cells==NULL) {
+            if (data) free(data);
+            fclose(fp);
+            VFreeSceneStats(st);
+            return (1);
+        }
+        VSeekData(fp, 0);
+        for (i=0; i<slices; i+=n) {
+            n = slices-i<slices_per_read? slices-i: slices_per_read;
+            if (bits == 1) {
+                error = VReadData((char *)data, 1, slice_bytes, fp, &num);
+                if (error == 0) {
+                    int j;
+                    for (j=0; j<slice_cells; j++)
+                        cells[j] = (data[j>>3]>>(7-(j&7)))&1;
+                }
+            }
+            else
+                error = VReadData((char *)data, bits/8, n*slice_cells, fp,
+                    &num);
+            if (error) {
+                if (cells != data) free(cells);
+                free(data);
+                fclose(fp);
+                VFreeSceneStats(st);
+                return (error);
+            }
+            VAccumulateSceneStats(st, cells, NULL, (long)n*slice_cells);
+        }
+        if (cells != data)
+            free(cells);
+        free(data);
+        fclose(fp);
+        VFinishSceneStats(st);
+        VStoreSceneFileStats(filename, st);
+        return (0);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VLookupSceneFileStats                         *
+ *      Description     : Reads the cached statistics of a file.        *
+ *      Return Value    :  0 - found.                                   *
+ *                         1 - not in the cache, or the file, its bits  *
+ *                             or signedness changed since storing.     *
+ *      Parameters      :  filename - the scene file.                   *
+ *                         bits, is_signed - as for VInitSceneStats.    *
+ *                         st - receives the finished statistics; free  *
+ *                              them with VFreeSceneStats.              *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VStoreSceneFileStats.                         *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+int VLookupSceneFileStats ( const char* filename, int bits, int is_signed,
+    VSceneStats* st )
+{
+        char *cache_name, *full_path, line[64];
+        FileStamp stamp, c_stamp;
+        int c_bits, c_signed, c_hist_min, c_hist_size, found=0, k;
+        FILE *fp;
+        size_t len;
+
+        if (v_stats_cache_name(filename, &cache_name, &full_path, &stamp))
+            return (1);
+        fp = fopen(cache_name, "rb");
+        free(cache_name);
+        if (fp == NULL) {
+            free(full_path);
+            return (1);
+        }
+        len = strlen(full_path);
+        if (fgets(line, sizeof(line), fp)==NULL ||
+                strncmp(line, STATS_CACHE_MAGIC, strlen(STATS_CACHE_MAGIC)))
+            goto done;
+        for (k=0; k<(int)len; k++)
+            if (getc(fp) != full_path[k])
+                goto done;
+        if (getc(fp) != '\n')
+            goto done;
+        if (fscanf(fp, "%lf %lf %ld %ld %d %d %d %d", &c_stamp.size,
+                &c_stamp.inode, &c_stamp.mtime, &c_stamp.mtime_nsec, &c_bits,
+                &c_signed, &c_hist_min, &c_hist_size) != 8 ||
+                c_stamp.size!=stamp.size || c_stamp.inode!=stamp.inode ||
+                c_stamp.mtime!=stamp.mtime ||
+                c_stamp.mtime_nsec!=stamp.mtime_nsec || c_bits!=bits ||
+                c_signed!=(is_signed!=0))
+            goto done;
+        if (VInitSceneStats(st, bits, is_signed))
+            goto done;
+        if (c_hist_min!=st->hist_min || c_hist_size!=st->hist_size)
+            goto fail;
+        if (bits == 32) {
+            ThreadMoments *m = (ThreadMoments *)st->thread_data;
+            if (fscanf(fp, "%lf %lf %lf %lf %lf", &m->count, &m->sum,
+                    &m->sum_sqr, &m->min, &m->max) != 5)
+                goto fail;
+        }
+        else {
+            unsigned long long *h = (unsigned long long *)st->thread_data;
+            double v, c;
+            while (fscanf(fp, "%lf %lf", &v, &c) == 2) {
+                k = (int)v-st->hist_min;
+                if (k<0 || k>=st->hist_size)
+                    goto fail;
+                h[k] = (unsigned long long)c;
+            }
+        }
+        if (fscanf(fp, "%63s", line)!=1 || strcmp(line, "end"))
+            goto fail;
+        VFinishSceneStats(st);
+        found = 1;
+        goto done;
+fail:
+        VFreeSceneStats(st);
+done:
+        fclose(fp);
+        free(full_path);
+        return (!found);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VStoreSceneFileStats                          *
+ *      Description     : Puts the statistics of all cells of a file,   *
+ *                        as read from the file, in the cache.          *
+ *                        Failures are ignored; the statistics will     *
+ *                        just be computed again.                       *
+ *      Return Value    : None.                                         *
+ *      Parameters      :  filename - the scene file.                   *
+ *                         st - finished statistics.                    *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VLookupSceneFileStats.                        *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VStoreSceneFileStats ( const char* filename, VSceneStats* st )
+{
+        char *cache_name, *full_path;
+        FileStamp stamp;
+        int k;
+        FILE *fp;
+
+        if (v_stats_cache_name(filename, &cache_name, &full_path, &stamp))
+            return;
+        fp = fopen(cache_name, "wb");
+        if (fp) {
+            fprintf(fp, "%s\n%s\n%.0f %.0f %ld %ld %d %d %d %d\n",
+                STATS_CACHE_MAGIC, full_path, stamp.size, stamp.inode,
+                stamp.mtime, stamp.mtime_nsec, st->bits, st->is_signed,
+                st->hist_min, st->hist_size);
+            if (st->bits == 32)
+                fprintf(fp, "%.17g %.17g %.17g %.17g %.17g\n", st->count,
+                    st->sum, st->sum_sqr, st->min, st->max);
+            else
+                for (k=0; k<st->hist_size; k++)
+                    if (st->hist[k])
+                        fprintf(fp, "%d %.0f\n", k+st->hist_min, st->hist[k]);
+            if (fprintf(fp, "end\n")<0 || fclose(fp))
+                remove(cache_name);
+        }
+        free(cache_name);
+        free(full_path);
+}
+
+/************************************************************************
+ *                                                                      *
+ *      Function        : VEnableSceneStatsCache                        *
+ *      Description     : Lets the cache create .cavass_stats in the    *
+ *                        home directory when VIEWNIX_STATS_CACHE is    *
+ *                        not set.  Otherwise the default cache is used *
+ *                        only if it already exists, so that command    *
+ *                        line programs do not create it.               *
+ *      Return Value    : None.                                         *
+ *      Parameters      : None.                                         *
+ *      Side effects    : None.                                         *
+ *      Entry condition : None.                                         *
+ *      Related funcs   : VLookupSceneFileStats, VStoreSceneFileStats.  *
+ *      History         : Written on October 19, 2026.                  *
+ *                                                                      *
+ ************************************************************************/
+void VEnableSceneStatsCache ( void )
+{
+        v_stats_cache_create = 1;
+}
+
+/* Returns non-zero if the cache is off, the file cannot be found or it
+ * was modified too recently; *cache_name and *full_path must be freed
+ * otherwise. */
+static int v_stats_cache_name ( const char* filename, char** cache_name,
+    char** full_path, FileStamp* stamp )
+{
+        struct stat sbuf;
+        const char *env;
+        char *dir;
+        unsigned long long hash=0xcbf29ce484222325ULL;
+        const unsigned char *p;
+
+        if (stat(filename, &sbuf))
+            return (1);
+        stamp->size = (double)sbuf.st_size;
+        stamp->inode = (double)sbuf.st_ino;
+        stamp->mtime = (long)sbuf.st_mtime;
+        stamp->mtime_nsec = v_mtime_nsec(sbuf);
+        if (difftime(time(NULL), sbuf.st_mtime) < STATS_SETTLE)
+            return (1);
+        env = getenv("VIEWNIX_STATS_CACHE");
+        if (env) {
+            if (env[0] == 0)
+                return (1);
+            dir = (char *)malloc(strlen(env)+1);
+            if (dir == NULL)
+                return (1);
+            strcpy(dir, env);
+        }
+        else {
+            env = getenv("HOME");
+#if defined (WIN32) || defined (_WIN32)
+            if (env == NULL)
+                env = getenv("USERPROFILE");
+#endif
+            if (env == NULL)
+                return (1);
+            dir = (char *)malloc(strlen(env)+sizeof("/.cavass_stats"));
+            if (dir == NULL)
+                return (1);
+            sprintf(dir, "%s/.cavass_stats", env);
+            if (stat(dir, &sbuf) && (!v_stats_cache_create || v_mkdir(dir))) {
+                free(dir);
+                return (1);
+            }
+        }
+        if (stat(dir, &sbuf))
+            v_mkdir(dir);
+
+#if defined (WIN32) || defined (_WIN32)
+        *full_path = _fullpath(NULL, filename, 0);
+#else
+        *full_path = realpath(filename, NULL);
+#endif
+        if (*full_path == NULL) {
+            free(dir);
+            return (1);
+        }
+        /* 64-bit FNV-1a hash of the path names the cache file */
+        for (p=(const unsigned char *)*full_path; *p; p++)
+            hash = (hash^*p)*0x100000001b3ULL;
+        *cache_name = (char *)malloc(strlen(dir)+32);
+        if (*cache_name == NULL) {
+            free(dir);
+            free(*full_path);
+            return (1);
+        }
+        sprintf(*cache_name, "%s/%08lx%08lx.stats", dir,
+            (unsigned long)(hash>>32), (unsigned long)(hash&0xffffffff));
+        free(dir);
+        return (0);
+}
+
+static int v_scene_slices ( ViewnixHeader* vh )
+{
+        int i, sum;
+
+        if (vh->scn.dimension == 3)
+            return (vh->scn.num_of_subscenes[0]);
+        for (sum=0,i=0; i<vh->scn.num_of_subscenes[0]; i++)
+            sum += vh->scn.num_of_subscenes[1+i];
+        return (sum);
+}
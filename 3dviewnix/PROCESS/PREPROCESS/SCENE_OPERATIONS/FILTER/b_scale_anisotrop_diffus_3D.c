@@ -24,21 +24,21 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
  * Title: scale_based_filtering_3D_anisotropy
  * Created: 1998 by Punam K Saha
  * Modified: February, 2004 by Punam K Saha
+ * Modified: 10/19/26 passes done by the stencil engine, in parallel
  * Function: Spherical-scale-based anisotropic fltering in three dimentions
  * Assumptions: All parameters are properly specified and the input file is readable
  * Parameters: homogeneity and number of iterations
  * Other effects: none
- * Output: FilteredFile ScaleFile 
+ * Output: FilteredFile ScaleFile
  *****************************************************************************/
 
 #include <math.h>
 #include <string.h>
 #include <cv3dv.h>
 #include <assert.h>
+#include "stencil.h"
 
 #define MAX_SCALE 8
-#define MIN_SCALE 1        /* Minimum value 1 */
-#define MIN_THR -1
 #define OBJECT_FRACTION_THRESHOLD 13.0
 #define MEDIAN_LEVEL 2
 double          DIFFUSION_CONSTANT;
@@ -50,40 +50,35 @@ double          DIFFUSION_CONSTANT;
   exit(1); \
 }
 
-int compute_feature_scale(),
-	compute_filter_image(), get_max(int a, int b), get_min(int a, int b);
+int compute_feature_scale();
+void diffusion_kernel(void *arg, const unsigned short *in,
+	unsigned short *out, const StTile *tile);
 
 ViewnixHeader   vh;
 int             smallest_density_value, largest_density_value;
 double          sigma;
-unsigned short ***pimage_16;
-unsigned char ***pimage_8;
+unsigned short *image, *spare;
 int             pslice, prow, pcol;
-unsigned short *feature_scale, ***pfeature_scale;
-int            *sphere_no_points, (**sphere_points)[3];
-unsigned short ***pfeature_data_filter;
-unsigned short *feature_data_filter;
-unsigned short *slice_data_16;
-unsigned char ***pfeature_data_filt_8, *feature_data_filt_8, *slice_data_8;
+unsigned short *feature_scale;
+StShells        shells;
 double         *transformation_scale;
 double         **transformation;
-long            iteration, histogram_count;
 int             max_iteration, slice_size, size, bytes;
 char            group[6], element[6];
 int             error;
 double  anisotropy_slice_coefficient, anisotropy_row_coefficient, anisotropy_column_coefficient;
 /*****************************************************************************/
 /*    Modified: 3/18/04 8-bit scenes handled by Dewey Odhner. */
+/*    Modified: 10/19/26 whole volume kept as 16 bits and iterated in place
+ *       of a spare buffer. */
 int main(argc, argv)
     int             argc;
     char           *argv[];
 {
-    int             i, j, k, l, tti1, tti2,
-                 ***ppptti1;
+    int             i, j, k;
     FILE           *in, *out;
-    int             slice, row;
     double          inv_sigma;
-    double          tt1;
+    double          tt1, coef[3];
 
 
 
@@ -128,80 +123,30 @@ int main(argc, argv)
     pslice = vh.scn.num_of_subscenes[0];
     slice_size = vh.scn.xysize[0] * vh.scn.xysize[1];
     size = pslice * slice_size;
-    if (bytes == 2)
-	{
-		slice_data_16 = (unsigned short *) malloc(size * bytes);
-	    if (slice_data_16 == NULL)
-	        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-	    pimage_16 = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-	    if (pimage_16 == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-
-	    pimage_16[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-	    if (pimage_16[0] == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pimage_16[slice] = pimage_16[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pimage_16[slice][row] = slice_data_16 + (slice * prow + row) * pcol;
-	}
-	else
-	{
-		slice_data_8 = (unsigned char *) malloc(size * bytes);
-	    if (slice_data_8 == NULL)
-	        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-	    pimage_8 = (unsigned char ***) malloc(pslice * sizeof(unsigned char **));
-	    if (pimage_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    pimage_8[0] = (unsigned char **) malloc(pslice * prow * sizeof(unsigned char *));
-	    if (pimage_8[0] == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pimage_8[slice] = pimage_8[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pimage_8[slice][row] = slice_data_8 + (slice * prow + row) * pcol;
-	}
+    image = (unsigned short *) malloc(size * sizeof(unsigned short));
+    spare = (unsigned short *) malloc(size * sizeof(unsigned short));
+    feature_scale = (unsigned short *) malloc(size * sizeof(unsigned short));
+    if (image == NULL || spare == NULL || feature_scale == NULL)
+        Handle_error("Couldn't allocate memory (execution terminated)\n");
 
     VSeekData(in, 0);
-    if (VReadData(bytes==2?(char *)slice_data_16:(char *)slice_data_8, bytes,
-		    size, in, &j)!=0 || j!=size)  {
+    if (VReadData((char *)image, bytes, size, in, &j)!=0 || j!=size)  {
 	    if(j!=0) {
            printf("Could read %d voxels out of %d\n", j, size);
 		   fflush(stdout);
 		   exit(-1);
 		   }
-		else   
+		else
            Handle_error("Could not read data\n");
 		}
     fclose(in);
+    if (bytes == 1)
+        st_widen(image, size);
 
-    if (bytes == 2)
-	{
-		largest_density_value = pimage_16[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pimage_16[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pimage_16[i][j][k];
-	                }
-    }
-	else
-	{
-		largest_density_value = pimage_8[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pimage_8[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pimage_8[i][j][k];
-	                }
-    }
+    largest_density_value = image[0];
+    for (i = 0; i < size; i++)
+        if (((int) image[i]) > largest_density_value)
+            largest_density_value = (int) image[i];
     if (largest_density_value <= 0)
         Handle_error("Empty image!\n");
     /******* Computation of transformation functions ***********************/
@@ -233,38 +178,6 @@ for(i=0;i<MAX_SCALE + 1;i++)  {
         transformation[i][j] = DIFFUSION_CONSTANT * exp(inv_sigma*pow((double) j, 2.0));
 			  }
     /***********************************************/
-    ppptti1 = (int ***) malloc(2 * (MAX_SCALE + 5) * sizeof(int **));
-    if (ppptti1 == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    ppptti1[0] = (int **) malloc(2 * (MAX_SCALE + 5) * 2 * (MAX_SCALE + 5) * sizeof(int *));
-    if (ppptti1[0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (i = 0; i < 2 * (MAX_SCALE + 5); i++)
-        ppptti1[i] = ppptti1[0] + i * 2 * (MAX_SCALE + 5);
-    ppptti1[0][0] = (int *) malloc(2 * (MAX_SCALE + 5) *
-           2 * (MAX_SCALE + 5) * 2 * (MAX_SCALE + 5) * sizeof(int));
-    if (ppptti1[0][0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (i = 0; i < 2 * (MAX_SCALE + 5); i++)
-        for (j = 0; j < 2 * (MAX_SCALE + 5); j++)
-            ppptti1[i][j] = ppptti1[0][0] +
-                (i * 2 * (MAX_SCALE + 5) + j) * 2 * (MAX_SCALE + 5);
-
-    tti1 = MAX_SCALE + 5;
-    for (i = 0; i < 2 * (MAX_SCALE + 5); i++)
-        for (j = 0; j < 2 * (MAX_SCALE + 5); j++)
-            for (k = 0; k < 2 * (MAX_SCALE + 5); k++)
-                ppptti1[i][j][k] = 0;
-
-    sphere_no_points = (int *) malloc(MAX_SCALE * sizeof(int));
-    if (sphere_no_points == NULL)
-        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-    sphere_points = (void *) malloc(MAX_SCALE * sizeof(void *));
-    if (sphere_points == NULL)
-        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-
     anisotropy_column_coefficient = vh.scn.xypixsz[0];
     anisotropy_row_coefficient = vh.scn.xypixsz[1];
     anisotropy_slice_coefficient = vh.scn.loc_of_subscenes[1] - vh.scn.loc_of_subscenes[0];
@@ -278,99 +191,38 @@ for(i=0;i<MAX_SCALE + 1;i++)  {
     anisotropy_column_coefficient = anisotropy_column_coefficient / tt1;
     anisotropy_row_coefficient = anisotropy_row_coefficient / tt1;
     anisotropy_slice_coefficient = anisotropy_slice_coefficient / tt1;
-	
+
 	printf("Anisotropy: slice = %f, row = %f, column = %f\n",
 	        anisotropy_slice_coefficient,anisotropy_row_coefficient,anisotropy_column_coefficient);
 
-    for (k = 0; k < MAX_SCALE; k++) {
-printf("Computing sphere  %d, ", k);
-fflush(stdout);	
-        sphere_no_points[k] = 0;
-        for (i = -k - 2; i <= k + 2; i++)
-            for (j = -k - 2; j <= k + 2; j++)
-                for (l = -k - 2; l <= k + 2; l++) 
-				  if (ppptti1[tti1 + i][tti1 + j][tti1 + l]==0)  {
-                    tt1 = sqrt(pow(((double) i) * anisotropy_slice_coefficient, 2.0)
-                           + pow(((double) j) * anisotropy_row_coefficient, 2.0)
-                           + pow(((double) l) * anisotropy_column_coefficient, 2.0));
-                    if (tt1 <= ((double) k) + 0.5) {
-                        sphere_no_points[k] = sphere_no_points[k] + 1;
-                        ppptti1[tti1 + i][tti1 + j][tti1 + l] = 2;
-                    }
-                }
-
-printf("number voxels = %d\n", sphere_no_points[k]);
-fflush(stdout);	
-
-        sphere_points[k] = (void *) malloc(3 * sphere_no_points[k] * sizeof(int));
-        if (sphere_points[k] == NULL)
-            Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-        tti2 = 0;
-        for (i = -k - 2; i <= k + 2; i++)
-            for (j = -k - 2; j <= k + 2; j++)
-                for (l = -k - 2; l <= k + 2; l++)
-                    if (ppptti1[tti1 + i][tti1 + j][tti1 + l] == 2) {
-                        ppptti1[tti1 + i][tti1 + j][tti1 + l] = 1;
-                        sphere_points[k][tti2][0] = i;
-                        sphere_points[k][tti2][1] = j;
-                        sphere_points[k][tti2][2] = l;
-                        tti2 = tti2 + 1;
-                    }
-    }
+    coef[0] = anisotropy_column_coefficient;
+    coef[1] = anisotropy_row_coefficient;
+    coef[2] = anisotropy_slice_coefficient;
+    if (st_shells(&shells, MAX_SCALE, coef, 0, pcol, prow))
+        Handle_error("Couldn't allocate memory (execution terminated)\n");
+    for (k = 0; k < MAX_SCALE; k++)
+        printf("Computing sphere  %d, number voxels = %d\n", k, shells.count[k]);
 printf("\n");
-fflush(stdout);	
+fflush(stdout);
 
     /***********************************************/
-    feature_data_filter = NULL;
-	feature_data_filt_8 = NULL;
-    feature_scale = NULL;
     compute_feature_scale();
-    for (iteration = 0; iteration < max_iteration; iteration++) {
-        compute_filter_image();
-		  for(i = 0; i < pslice; i++)
-            for (j = 0; j < prow; j++)
-                for (k = 0; k < pcol; k++)
-                    if (bytes == 2)
-						pimage_16[i][j][k] = pfeature_data_filter[i][j][k];
-					else
-						pimage_8[i][j][k] = pfeature_data_filt_8[i][j][k];
+    printf("Filtering, %d iterations\n", max_iteration);
+    fflush(stdout);
+    if (st_iterate(pcol, prow, pslice, diffusion_kernel, NULL, &image,
+            &spare, max_iteration))
+        Handle_error("Could not filter\n");
+
+
+    largest_density_value = smallest_density_value = image[0];
+    for (i = 0; i < size; i++)
+    {
+        if (((int) image[i]) > largest_density_value)
+            largest_density_value = (int) image[i];
+        if (((int) image[i]) < smallest_density_value)
+            smallest_density_value = (int) image[i];
     }
 
-
-	if (bytes == 2)
-	{
-	    largest_density_value = pfeature_data_filter[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pfeature_data_filter[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pfeature_data_filter[i][j][k];
-	                }
-	    smallest_density_value = pfeature_data_filter[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pfeature_data_filter[i][j][k]) < smallest_density_value)
-	                    smallest_density_value = (int) pfeature_data_filter[i][j][k];
-	}
-	else
-	{
-	    largest_density_value = pfeature_data_filt_8[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pfeature_data_filt_8[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pfeature_data_filt_8[i][j][k];
-	                }
-	    smallest_density_value = pfeature_data_filt_8[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pfeature_data_filt_8[i][j][k]) < smallest_density_value)
-	                    smallest_density_value = (int) pfeature_data_filt_8[i][j][k];
-	}
-
     /************ WRITE FILTER IMAGE ************/
     vh.scn.smallest_density_value[0] = (float)smallest_density_value;
     vh.scn.largest_density_value[0] = (float)largest_density_value;
@@ -382,7 +234,9 @@ fflush(stdout);
     if (error <= 104)
         Handle_error("Fatal error in writing header\n");
 
-    if (VWriteData(bytes==2?(char *)feature_data_filter:(char *)feature_data_filt_8, bytes, size, out, &j)!=0 || j!=size)
+    if (bytes == 1)
+        st_narrow(image, size);
+    if (VWriteData((char *)image, bytes, size, out, &j)!=0 || j!=size)
         Handle_error("Could not read data\n");
 
     fclose(out);
@@ -393,250 +247,83 @@ fflush(stdout);
 
     exit(0);
 }
+
+static double flow(int difference, double coefficient, const double *weight)
+{
+    int             d;
+
+    if (difference < 0) {
+        d = (int) (((double) -difference) / coefficient + 0.5);
+        return -(((double) d) * weight[d]);
+    }
+    d = (int) (((double) difference) / coefficient + 0.5);
+    return ((double) d) * weight[d];
+}
+
 /*****************************************************************************
- * FUNCTION: compute_affinity_3d
- * DESCRIPTION: Computes the affinity values for the current slice and
- *    stores them at affinity_data_across and affinity_data_down.
- * PARAMETERS: None
- * SIDE EFFECTS: The variable affinity_data_valid set on success.  The variable
- *    feature_status may be changed.  An error message may be displayed.
- * ENTRY CONDITIONS: The variables vh, feature_data_valid, feature_status,
- *    argv0, windows_open, affinity_type, histogram_bins,
- *    histogram_counts, reverse_histogram_counts, largest_density_value,
- *    det_covariance, det_reverse_covariance, training_mean, inv_covariance,
- *    reverse_training_mean, inv_reverse_covariance must be properly set.
- *    The input file must not change from one call to another.
- *    If affinity_data_across or affinity_data_down is non-null, sufficient
- *    space must be allocated there.
- *    A successful call to VCreateColormap must be made first.
+ * FUNCTION: diffusion_kernel
+ * DESCRIPTION: Does one iteration of the diffusion on a tile: each voxel
+ *    receives the flow from its 6 neighbors, weighted for the smallest scale
+ *    of the voxel and the two neighbors along each direction.
+ * PARAMETERS:
+ *    arg: not used
+ *    in: the image
+ *    out: receives the filtered image on the tile
+ *    tile: the voxels to filter
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The scale must be computed.  transformation,
+ *    pslice, prow, pcol and the anisotropy coefficients must be set.
  * RETURN VALUE: None
- * EXIT CONDITIONS: Fails if histogram_counts is NULL.
  * HISTORY:
- *    Created: 3/7/96 by Dewey Odhner
- *    Modified: 4/2/96 threshold applied by Dewey Odhner
- *    Modified: 5/22/96 histogram used by Dewey Odhner
- *    Modified: 5/28/96 reverse training allowed by Dewey Odhner
- *    Modified: 7/25/96 covariance affinity type allowed by Dewey Odhner
- *    Modified: 2/18/97 threshold applied covariance affinity type
- *       by Dewey Odhner
- *    Modified: 4/16/97 threshold not applied by Dewey Odhner
+ *    Created: 1998 by Punam K. Saha
+ *    Modified: 3/19/04 8-bit scenes handled by Dewey Odhner.
+ *    Modified: 10/19/26 done on tiles for the stencil engine
  *
  *****************************************************************************/
-/*    Modified: 3/19/04 8-bit scenes handled by Dewey Odhner. */
-int compute_filter_image()
+void diffusion_kernel(void *arg, const unsigned short *in,
+	unsigned short *out, const StTile *tile)
 {
-    int             slice, row, col, tti1, tti2, iscale, selected_scale;
-    unsigned short ***outptr, ***pin_16, ***pscale;
-	unsigned char ***outptr_8, ***pin_8;
-    double          sum;
-
-
-
-
-	if (bytes == 2)
-	{
-	    feature_data_filter = (unsigned short *) malloc(size * sizeof(unsigned short));
-	    if (feature_data_filter == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    pfeature_data_filter = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-	    if (pfeature_data_filter == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-
-	    pfeature_data_filter[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-	    if (pfeature_data_filter[0] == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pfeature_data_filter[slice] = pfeature_data_filter[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pfeature_data_filter[slice][row] = feature_data_filter
-	                + (slice * prow + row) * pcol;
-	}
-	else
-	{
-	    feature_data_filt_8 = (unsigned char *) malloc(size);
-	    if (feature_data_filt_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    pfeature_data_filt_8 = (unsigned char ***) malloc(pslice * sizeof(unsigned char **));
-	    if (pfeature_data_filt_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    pfeature_data_filt_8[0] = (unsigned char **) malloc(pslice * prow * sizeof(unsigned char *));
-	    if (pfeature_data_filt_8[0] == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pfeature_data_filt_8[slice] = pfeature_data_filt_8[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pfeature_data_filt_8[slice][row] = feature_data_filt_8
-	                + (slice * prow + row) * pcol;
-	}
-
-    pscale = pfeature_scale;
-    pin_16 = pimage_16;
-	pin_8 = pimage_8;
-
-    outptr = pfeature_data_filter;
-	outptr_8 = pfeature_data_filt_8;
-    for (slice = 0; slice < pslice; slice++) {
-        printf("\rFiltering, slice %d", slice);
-        fflush(stdout);
-        for (row = 0; row < prow; row++)
-            for (col = 0; col < pcol; col++)
-                if ((bytes==2? pin_16[slice][row][col]:
-					pin_8[slice][row][col]) > MIN_THR) {
-                sum = bytes==2? pin_16[slice][row][col]:pin_8[slice][row][col];
-                iscale = (int) pscale[slice][row][col];				
-				
-                if (slice > 0 && slice < pslice - 1) {
-                    tti1 = bytes==2?
-						(int) pin_16[slice + 1][row][col] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice + 1][row][col] -
-						(int) pin_8[slice][row][col];
-					
-                    tti2 = (int) pscale[slice + 1][row][col];
-                    if (tti2 > iscale)
-                        selected_scale = iscale;
-					else
-					    selected_scale = tti2;
-						
-                    tti2 = (int) pscale[slice - 1][row][col];
-                    if (tti2 < selected_scale)
-         					    selected_scale = tti2;
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_slice_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_slice_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
-                    }
-
-                    tti1 = bytes==2?
-						(int) pin_16[slice - 1][row][col] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice - 1][row][col] -
-						(int) pin_8[slice][row][col];
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_slice_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_slice_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
-                    }
-                }
-				
-                if (row > 0 && row < prow - 1) {
-                    tti1 = bytes==2?
-						(int) pin_16[slice][row + 1][col] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice][row + 1][col] -
-						(int) pin_8[slice][row][col];
-					
-                    tti2 = (int) pscale[slice][row + 1][col];
-                    if (tti2 > iscale)
-                        selected_scale = iscale;
-					else
-					    selected_scale = tti2;
-						
-                    tti2 = (int) pscale[slice][row - 1][col];
-                    if (tti2 < selected_scale)
-         					    selected_scale = tti2;
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_row_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_row_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
-                    }
-
-                    tti1 = bytes==2?
-						(int) pin_16[slice][row - 1][col] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice][row - 1][col] -
-						(int) pin_8[slice][row][col];
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_row_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_row_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
-                    }
-                }
-				
-                if (col > 0 && col < pcol - 1) {
-                    tti1 = bytes==2?
-						(int) pin_16[slice][row][col + 1] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice][row][col + 1] -
-						(int) pin_8[slice][row][col];
-					
-                    tti2 = (int) pscale[slice][row][col + 1];
-                    if (tti2 > iscale)
-                        selected_scale = iscale;
-					else
-					    selected_scale = tti2;
-						
-                    tti2 = (int) pscale[slice][row][col - 1];
-                    if (tti2 < selected_scale)
-					    selected_scale = tti2;
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_column_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_column_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
-                    }
-
-                    tti1 = bytes==2?
-						(int) pin_16[slice][row][col - 1] -
-						(int) pin_16[slice][row][col]:
-						(int) pin_8[slice][row][col - 1] -
-						(int) pin_8[slice][row][col];
-
-                    if (tti1 < 0) {
-                        tti1 = -tti1;
-                        tti1 = (int) (((double) tti1) / anisotropy_column_coefficient + 0.5);
-                        sum = sum - ((double) tti1) * transformation[selected_scale][tti1];
-                    } else {
-                        tti1 = (int) (((double) tti1) / anisotropy_column_coefficient + 0.5);
-                        sum = sum + ((double) tti1) * transformation[selected_scale][tti1];
+    int             slice, row, col, tti1, axis, position[3], extent[3],
+                    selected_scale;
+    long            c, step[3];
+    double          sum, coefficient[3];
+
+    step[0] = 1;
+    step[1] = pcol;
+    step[2] = slice_size;
+    extent[0] = pcol;
+    extent[1] = prow;
+    extent[2] = pslice;
+    coefficient[0] = anisotropy_column_coefficient;
+    coefficient[1] = anisotropy_row_coefficient;
+    coefficient[2] = anisotropy_slice_coefficient;
+    for (slice = tile->z0; slice < tile->z1; slice++)
+        for (row = tile->y0; row < tile->y1; row++)
+            for (col = 0; col < pcol; col++) {
+                c = slice * step[2] + row * step[1] + col;
+                sum = in[c];
+                position[0] = col;
+                position[1] = row;
+                position[2] = slice;
+                for (axis = 2; axis >= 0; axis--)
+                    if (position[axis] > 0 &&
+                            position[axis] < extent[axis] - 1) {
+                        selected_scale = feature_scale[c];
+                        if (feature_scale[c + step[axis]] < selected_scale)
+                            selected_scale = feature_scale[c + step[axis]];
+                        if (feature_scale[c - step[axis]] < selected_scale)
+                            selected_scale = feature_scale[c - step[axis]];
+                        sum = sum + flow((int) in[c + step[axis]] - (int) in[c],
+                            coefficient[axis], transformation[selected_scale]);
+                        sum = sum + flow((int) in[c - step[axis]] - (int) in[c],
+                            coefficient[axis], transformation[selected_scale]);
                     }
-                }
                 tti1 = (int) (sum + 0.5);
                 if (tti1 < 0)
                     tti1 = 0;
-                if (bytes == 2)
-					outptr[slice][row][col] = tti1;
-				else
-					outptr_8[slice][row][col] = tti1;
+                out[c] = tti1;
             }
-			 else
-                 if (bytes == 2)
-				 	outptr[slice][row][col] = pin_16[slice][row][col];
-				 else
-				 	outptr_8[slice][row][col] = pin_8[slice][row][col];
-    }
-    printf("\n");
-    fflush(stdout);
-
-    return (1);
 }
-
 /*****************************************************************************
  * FUNCTION: compute_feature_scale_3d
  * DESCRIPTION: computes scale representation of the image.
@@ -652,270 +339,22 @@ int compute_filter_image()
  * HISTORY:
  *    Created: 10/3/97 by Punam K. Saha
  *    Modified: 3/19/04 8-bit scenes handled by Dewey Odhner.
+ *    Modified: 10/19/26 passes done by the stencil engine
  *
  *****************************************************************************/
 int compute_feature_scale()
 {
-    int             tti2, tti5;
-    int             slice, row, col, i, j, k, x, y, z, xx, yy, zz, mean_g,
-                    tti1, tli1[27];
-    unsigned short ***pin_16, *temp_16, ***ptemp_16;
-	unsigned char ***pin_8, *temp_8, ***ptemp_8;
-    int             flag;
-    double          count_obj, count_nonobj;
-
-
-    feature_scale = (unsigned short *) malloc(size * sizeof(unsigned short));
-    if (feature_scale == NULL)
+    printf("Computing mean\n");
+    fflush(stdout);
+    if (st_rank_clamp(image, pcol, prow, pslice, MEDIAN_LEVEL))
         Handle_error("Couldn't allocate memory\n");
-
-    pfeature_scale = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-    if (pfeature_scale == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-
-    pfeature_scale[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-    if (pfeature_scale[0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (slice = 0; slice < pslice; slice++)
-        pfeature_scale[slice] = pfeature_scale[0] + slice * prow;
-
-    for (slice = 0; slice < pslice; slice++)
-        for (row = 0; row < prow; row++)
-            pfeature_scale[slice][row] = feature_scale + (slice * prow + row) * pcol;
-
-
-
-	if (bytes == 2)
-	{
-	    temp_16 = (unsigned short *) malloc(size * sizeof(unsigned short));
-	    if (temp_16 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    ptemp_16 = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-	    if (ptemp_16 == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-
-	    ptemp_16[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-	    if (ptemp_16[0] == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        ptemp_16[slice] = ptemp_16[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            ptemp_16[slice][row] = temp_16 + (slice * prow + row) * pcol;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            for (col = 0; col < pcol; col++)
-	                ptemp_16[slice][row][col] = pimage_16[slice][row][col];
-	}
-	else
-	{
-	    temp_8 = (unsigned char *) malloc(size);
-	    if (temp_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    ptemp_8 = (unsigned char ***) malloc(pslice * sizeof(unsigned char **));
-	    if (ptemp_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    ptemp_8[0] = (unsigned char **) malloc(pslice * prow * sizeof(unsigned char *));
-	    if (ptemp_8[0] == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        ptemp_8[slice] = ptemp_8[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            ptemp_8[slice][row] = temp_8 + (slice * prow + row) * pcol;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            for (col = 0; col < pcol; col++)
-	                ptemp_8[slice][row][col] = pimage_8[slice][row][col];
-	}
-
-    for (slice = 0; slice < pslice; slice++)   {
-	    printf("\rComputing mean, slice %d", slice);
-		fflush(stdout);
-        for (row = 0; row < prow; row++)
-            for (col = 0; col < pcol; col++) {
-                tti1 = 0;
-                for (xx = -1; xx <= 1; xx++)
-                    for (yy = -1; yy <= 1; yy++)
-                        for (zz = -1; zz <= 1; zz++) {
-                            if (xx < 0) {
-                                x = get_max(slice + xx, 0);
-                            } else {
-                                x = get_min(slice + xx, pslice - 1);
-                            }
-                            if (yy < 0) {
-                                y = get_max(row + yy, 0);
-                            } else {
-                                y = get_min(row + yy, prow - 1);
-                            }
-                            if (zz < 0) {
-                                z = get_max(col + zz, 0);
-                            } else {
-                                z = get_min(col + zz, pcol - 1);
-                            }
-                            j = 0;
-                            if (bytes == 2)
-								while (j < tti1 && ptemp_16[x][y][z] < tli1[j])
-                                	j = j + 1;
-                            else
-							    while (j < tti1 && ptemp_8[x][y][z] < tli1[j])
-								    j = j + 1;
-							tti2 = j;
-                            for (j = tti1 - 1; j >= tti2; j--)
-                                tli1[j + 1] = tli1[j];
-                            tli1[tti2] =
-							    bytes==2? ptemp_16[x][y][z]: ptemp_8[x][y][z];
-                            tti1 = tti1 + 1;
-                        }
-                if (bytes == 2)
-				{
-					for (j = 0; j < tti1; j++)
-	                    if (tli1[j] == pimage_16[slice][row][col]) {
-	                        tti2 = j;
-	                        tti1 = 27;
-	                    }
-	                if (tti2 < MEDIAN_LEVEL)
-	                    pimage_16[slice][row][col] = tli1[MEDIAN_LEVEL];
-	                else if (tti2 > 26-MEDIAN_LEVEL)
-	                    pimage_16[slice][row][col] = tli1[26-MEDIAN_LEVEL];
-	                else
-	                    pimage_16[slice][row][col] = ptemp_16[slice][row][col];
-				}
-				else
-				{
-					for (j = 0; j < tti1; j++)
-	                    if (tli1[j] == pimage_8[slice][row][col]) {
-	                        tti2 = j;
-	                        tti1 = 27;
-	                    }
-	                if (tti2 < MEDIAN_LEVEL)
-	                    pimage_8[slice][row][col] = tli1[MEDIAN_LEVEL];
-	                else if (tti2 > 26-MEDIAN_LEVEL)
-	                    pimage_8[slice][row][col] = tli1[26-MEDIAN_LEVEL];
-	                else
-	                    pimage_8[slice][row][col] = ptemp_8[slice][row][col];
-				}
-            }
-		}
-	printf("\n");
-	fflush(stdout);
-	if (bytes == 2)
-	{
-	    free(temp_16);
-	    free(ptemp_16[0]);
-	    free(ptemp_16);
-	}
-	else
-	{
-	    free(temp_8);
-	    free(ptemp_8[0]);
-	    free(ptemp_8);
-	}
-
-
-    pin_16 = pimage_16;
-	pin_8 = pimage_8;
-    for (slice = 0; slice < pslice; slice++) {
-        printf("\rScale computing slice %d", slice);
-        fflush(stdout);
-        for (row = 0; row < prow; row++)
-            for (col = 0; col < pcol; col++)
-                if ((bytes==2? pimage_16[slice][row][col]:
-						pimage_8[slice][row][col]) <= MIN_THR)
-                    pfeature_scale[slice][row][col] = MIN_SCALE;
-                else {
-                    flag = 0;
-                    mean_g = bytes==2? pimage_16[slice][row][col]:
-						pimage_8[slice][row][col];
-
-                    count_obj = 0;
-                    count_nonobj = 0;
-                    for (k = MIN_SCALE; (k < MAX_SCALE) && !flag; k++) {
-                        for (i = 0; i < sphere_no_points[k]; i++) {
-                            xx = slice + sphere_points[k][i][0];
-                            yy = row + sphere_points[k][i][1];
-                            zz = col + sphere_points[k][i][2];
-                            if (xx >= 0 && xx < pslice && yy >= 0 &&
-                                yy < prow && zz >= 0 && zz < pcol &&
-                                (bytes==2?pin_16[xx][yy][zz]:pin_8[xx][yy][zz])
-								 > MIN_THR) {
-                                tti5 = (bytes==2? pin_16[xx][yy][zz]:
-									pin_8[xx][yy][zz]) - mean_g;
-                                if (tti5 < 0)
-                                    tti5 = -tti5;
-                                count_obj = count_obj + transformation_scale[tti5];
-                                count_nonobj = count_nonobj + 1.0 - transformation_scale[tti5];
-                            }
-                        }
-
-                        if (100.0 * count_nonobj >= OBJECT_FRACTION_THRESHOLD
-                            * (count_nonobj + count_obj)) {
-                            pfeature_scale[slice][row][col] = k;
-                            flag = 1;
-                        }
-                    }
-                    if (!flag)
-                        pfeature_scale[slice][row][col] = MAX_SCALE - 1;
-                }
-    }
-    printf("\n");
+    printf("Scale computing\n");
     fflush(stdout);
-
+    if (st_object_scale(image, feature_scale, pcol, prow, pslice, &shells,
+            transformation_scale, OBJECT_FRACTION_THRESHOLD))
+        Handle_error("Could not compute scale\n");
     return (1);
 }
-/*****************************************************************************
-     * FUNCTION: get_max
-     * DESCRIPTION: returns the maximum between two integers
-     * PARAMETERS:
-     *    integer1 and integer2
-     * SIDE EFFECTS:
-     *    Nil.
-     * ENTRY CONDITIONS:
-     *    Nil.
-     * RETURN VALUE: see DESCRIPTION
-     * EXIT CONDITIONS:
-     * HISTORY:
-     *    Created: 9/5/97 by Punam K. Saha
-     *
-     *****************************************************************************/
-int get_max(int a, int b)
-{
-
-    if (a > b)
-        return (a);
-    else
-        return (b);
-}
-/*****************************************************************************
- * FUNCTION: get_min
- * DESCRIPTION: returns the minimum between two integers
- * PARAMETERS:
- *    integer1 and integer2
- * SIDE EFFECTS:
- *    Nil.
- * ENTRY CONDITIONS:
- *    Nil.
- * RETURN VALUE: see DESCRIPTION
- * EXIT CONDITIONS:
- * HISTORY:
- *    Created: 9/5/97 by Punam K. Saha
- *
- *****************************************************************************/
-int get_min(int a, int b)
-{
-
-    if (a < b)
-        return (a);
-    else
-        return (b);
-}
 /****************************************************/
 /***************************************************/
 int get_slices(dim, list)
@@ -932,6 +371,5 @@ int get_slices(dim, list)
         return (sum);
     }
     return (0);
-
 }
 /*******************************  THE END  *************************************/
@@ -24,12 +24,10 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>
 #include <cv3dv.h>
 #include <assert.h>
+#include "stencil.h"
 
 #define DEFAULT_MAX_SCALE 10 /* Minimum value 2 i.e., without scale */
 #define MIN_SCALE 1        /* Minimum value 1 */
-#define MIN_THR -1
-#define OBJECT_FRACTION_THRESHOLD 13.0
-#define MEDIAN_LEVEL 13
 
 #define Handle_error(message) \
 { \
@@ -38,8 +36,9 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
   exit(1); \
 }
 
-int compute_filter_image(), compute_feature_scale(), get_max(int, int),
- get_min(int, int);
+int compute_filter_image(), compute_feature_scale();
+void enhance_kernel(void *arg, const unsigned short *in,
+    unsigned short *out, const StTile *tile);
 
 // Welch's t-test
 // t = (m1-m2)/sqrt(s1_sqr/n1+s2_sqr/n2)
@@ -49,19 +48,11 @@ int compute_filter_image(), compute_feature_scale(), get_max(int, int),
 int             max_scale=DEFAULT_MAX_SCALE, min_scale=MIN_SCALE;
 ViewnixHeader   vh;
 int             smallest_density_value, largest_density_value;
-double          sigma=50;
-unsigned short ***pimage_16;
-unsigned char ***pimage_8;
+unsigned short *image;
 int             pslice, prow, pcol;
-unsigned short *feature_scale, ***pfeature_scale;
-unsigned char  *which_scale, ***pwhich_scale;
-int            *sphere_no_points, (**sphere_points)[3], *ball_no_points;
-unsigned short ***pfeature_data_filter;
-unsigned short *feature_data_filter;
-unsigned short *slice_data_16;
-unsigned char  *slice_data_8;
-double         *transformation_scale;
-long            histogram_count;
+unsigned short *feature_scale;
+unsigned char  *which_scale;
+StShells        shells;
 int             slice_size, size, bytes;
 char           *out_file_name, *out_file2_name;
 char            group[6], element[6];
@@ -70,16 +61,14 @@ int             min_density, ball_low, ball_high=65535;
 int             twoD;
 /*****************************************************************************/
 /*    Modified: 2/26/04 8-bit scenes handled by Dewey Odhner. */
+/*    Modified: 10/19/26 whole volume kept as 16 bits. */
 int main(argc, argv)
     int             argc;
     char           *argv[];
 {
-    int             i, j, k, l, tti1, tti2,
-                 ***ppptti1;
+    int             i, j;
     FILE           *in;
-    int             slice, row;
-    double          inv_sigma;
-    double          tt1, sphere_slice_coefficient, sphere_row_coefficient, sphere_column_coefficient;
+    double          tt1, coef[3], sphere_slice_coefficient, sphere_row_coefficient, sphere_column_coefficient;
 
 
 	if (argc>3 && strcmp(argv[argc-1], "-2D")==0)
@@ -142,127 +131,31 @@ int main(argc, argv)
     pslice = vh.scn.num_of_subscenes[0];
     slice_size = vh.scn.xysize[0] * vh.scn.xysize[1];
     size = pslice * slice_size;
-    if (bytes == 2)
-	{
-		slice_data_16 = (unsigned short *) malloc(size * bytes);
-	    if (slice_data_16 == NULL)
-	        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-	    pimage_16 = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-	    if (pimage_16 == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-
-	    pimage_16[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-	    if (pimage_16[0] == NULL)
-	        Handle_error("COULD ALLOCATE MEMORY\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pimage_16[slice] = pimage_16[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pimage_16[slice][row] = slice_data_16 + (slice * prow + row) * pcol;
-	}
-	else
-	{
-		slice_data_8 = (unsigned char *) malloc(size * bytes);
-	    if (slice_data_8 == NULL)
-	        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-	    pimage_8 = (unsigned char ***) malloc(pslice * sizeof(unsigned char **));
-	    if (pimage_8 == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-
-	    pimage_8[0] = (unsigned char **) malloc(pslice * prow * sizeof(unsigned char *));
-	    if (pimage_8[0] == NULL)
-	        Handle_error("Couldn't allocate memory\n");
-	    for (slice = 0; slice < pslice; slice++)
-	        pimage_8[slice] = pimage_8[0] + slice * prow;
-
-	    for (slice = 0; slice < pslice; slice++)
-	        for (row = 0; row < prow; row++)
-	            pimage_8[slice][row] = slice_data_8 + (slice * prow + row) * pcol;
-	}
+    image = (unsigned short *) malloc(size * sizeof(unsigned short));
+    if (image == NULL)
+        Handle_error("Couldn't allocate memory (execution terminated)\n");
 
     VSeekData(in, 0);
-    if (VReadData(bytes==2?(void *)slice_data_16:(void *)slice_data_8, bytes,
-		    size, in, &j)!=0 || j!=size)  {
+    if (VReadData((char *)image, bytes, size, in, &j)!=0 || j!=size)  {
 	    if(j!=0) {
            printf("Could read %d voxels out of %d\n", j, size);
 		   fflush(stdout);
 		   exit(-1);
 		   }
-		else   
+		else
            Handle_error("Could not read data\n");
 		}
     fclose(in);
+    if (bytes == 1)
+        st_widen(image, size);
 
-    if (bytes == 2)
-	{
-		largest_density_value = pimage_16[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pimage_16[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pimage_16[i][j][k];
-	                }
-    }
-	else
-	{
-		largest_density_value = pimage_8[0][0][0];
-	    for (i = 0; i < pslice; i++)
-	        for (j = 0; j < prow; j++)
-	            for (k = 0; k < pcol; k++)
-	                if (((int) pimage_8[i][j][k]) > largest_density_value) {
-	                    largest_density_value = (int) pimage_8[i][j][k];
-	                }
-    }
+    largest_density_value = image[0];
+    for (i = 0; i < size; i++)
+        if (((int) image[i]) > largest_density_value)
+            largest_density_value = (int) image[i];
 	if (largest_density_value <= 0)
         Handle_error("Empty image!\n");
-    /******* Computation of transformation functions ***********************/
-    transformation_scale = (double *) malloc((largest_density_value + 1) *
-                         sizeof(double));
-    if (transformation_scale == NULL)
-        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-    inv_sigma = -0.5 / pow(sigma, 2.0);
-
-    for (i = 0; i <= largest_density_value; i++)
-        transformation_scale[i] = exp(inv_sigma *
-                          pow((double) i, 2.0));
     /***********************************************/
-    ppptti1 = (int ***) malloc(2 * (max_scale + 5) * sizeof(int **));
-    if (ppptti1 == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    ppptti1[0] = (int **) malloc(2 * (max_scale + 5) * 2 * (max_scale + 5) * sizeof(int *));
-    if (ppptti1[0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (i = 0; i < 2 * (max_scale + 5); i++)
-        ppptti1[i] = ppptti1[0] + i * 2 * (max_scale + 5);
-    ppptti1[0][0] = (int *) malloc(2 * (max_scale + 5) *
-           2 * (max_scale + 5) * 2 * (max_scale + 5) * sizeof(int));
-    if (ppptti1[0][0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (i = 0; i < 2 * (max_scale + 5); i++)
-        for (j = 0; j < 2 * (max_scale + 5); j++)
-            ppptti1[i][j] = ppptti1[0][0] +
-                (i * 2 * (max_scale + 5) + j) * 2 * (max_scale + 5);
-
-    tti1 = max_scale + 5;
-    for (i = 0; i < 2 * (max_scale + 5); i++)
-        for (j = 0; j < 2 * (max_scale + 5); j++)
-            for (k = 0; k < 2 * (max_scale + 5); k++)
-                ppptti1[i][j][k] = 0;
-
-    sphere_no_points = (int *) malloc(max_scale * sizeof(int));
-	ball_no_points = (int *) malloc(max_scale * sizeof(int));
-    if (sphere_no_points == NULL || ball_no_points == NULL)
-        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-    sphere_points = (void *) malloc(max_scale * sizeof(void *));
-    if (sphere_points == NULL)
-        Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-
     sphere_column_coefficient = vh.scn.xypixsz[0];
     sphere_row_coefficient = vh.scn.xypixsz[1];
     sphere_slice_coefficient = vh.scn.num_of_subscenes[0]==1? 1:
@@ -277,48 +170,17 @@ int main(argc, argv)
     sphere_column_coefficient = sphere_column_coefficient / tt1;
     sphere_row_coefficient = sphere_row_coefficient / tt1;
     sphere_slice_coefficient = sphere_slice_coefficient / tt1;
-	
+
 	printf("Anisotropy: slice = %f, row = %f, column = %f\n",
 	        sphere_slice_coefficient,sphere_row_coefficient,sphere_column_coefficient);
 
-    for (k = 0; k < max_scale; k++) {
-        sphere_no_points[k] = 0;
-        for (i = twoD? 0: -k - 2; i <= (twoD? 0: k + 2); i++)
-            for (j = -k - 2; j <= k + 2; j++)
-                for (l = -k - 2; l <= k + 2; l++) 
-				  if (ppptti1[tti1 + i][tti1 + j][tti1 + l]==0)  {
-                    tt1 = sqrt(pow(((double) i) * sphere_slice_coefficient, 2.0)
-                           + pow(((double) j) * sphere_row_coefficient, 2.0)
-                           + pow(((double) l) * sphere_column_coefficient, 2.0));
-                    if (tt1 <= ((double) k) + 0.5) {
-                        sphere_no_points[k] = sphere_no_points[k] + 1;
-                        ppptti1[tti1 + i][tti1 + j][tti1 + l] = 2;
-                    }
-                }
-
-		if (k == 0)
-			ball_no_points[k] = 0;
-		else
-			ball_no_points[k] = ball_no_points[k-1]+sphere_no_points[k-1];
-
-        sphere_points[k] = (void *) malloc(3 * sphere_no_points[k] * sizeof(int));
-        if (sphere_points[k] == NULL)
-            Handle_error("Couldn't allocate memory (execution terminated)\n");
-
-        tti2 = 0;
-        for (i = -k - 2; i <= k + 2; i++)
-            for (j = -k - 2; j <= k + 2; j++)
-                for (l = -k - 2; l <= k + 2; l++)
-                    if (ppptti1[tti1 + i][tti1 + j][tti1 + l] == 2) {
-                        ppptti1[tti1 + i][tti1 + j][tti1 + l] = 1;
-                        sphere_points[k][tti2][0] = l;
-                        sphere_points[k][tti2][1] = j;
-                        sphere_points[k][tti2][2] = i;
-                        tti2 = tti2 + 1;
-                    }
-    }
+    coef[0] = sphere_column_coefficient;
+    coef[1] = sphere_row_coefficient;
+    coef[2] = sphere_slice_coefficient;
+    if (st_shells(&shells, max_scale, coef, twoD, pcol, prow))
+        Handle_error("Couldn't allocate memory (execution terminated)\n");
 printf("\n");
-fflush(stdout);	
+fflush(stdout);
 
     /***********************************************/
     feature_scale = NULL;
@@ -336,111 +198,91 @@ int compute_filter_image()
 }
 
 /*****************************************************************************
- * FUNCTION: compute_feature_scale_3d
- * DESCRIPTION: computes scale representation of the image.
+ * FUNCTION: enhance_kernel
+ * DESCRIPTION: Computes the ball enhancement of the voxels of a tile: the
+ *    largest t statistic between a ball and the sphere around it, over the
+ *    scales from min_scale on, until a voxel under min_density is met.
  * PARAMETERS:
- *    feature: whether it is an intensity or an edge or a fractal image.
- * SIDE EFFECTS:
- *    feature_scale_data_valid is set.
- * ENTRY CONDITIONS:
- *    sigma, bytes must be set.
- *    image data is valid.
+ *    arg: not used
+ *    in: the image
+ *    out: receives 1000 times the t statistic, up to 65535
+ *    tile: the voxels to do
+ * SIDE EFFECTS: which_scale receives the scale of the ball.
+ * ENTRY CONDITIONS: The variables shells, max_scale, min_scale,
+ *    min_density, ball_low, ball_high, pslice, prow, pcol must be set.
  * RETURN VALUE: None
- * EXIT CONDITIONS: Undefined if entry condition is not met.
  * HISTORY:
  *    Created: 10/3/97 by Punam K. Saha
  *    Modified: 3/16/04 8-bit scenes handled by Dewey Odhner.
+ *    Modified: 10/19/26 done on tiles for the stencil engine
  *
  *****************************************************************************/
-int compute_feature_scale()
+void enhance_kernel(void *arg, const unsigned short *in,
+    unsigned short *out, const StTile *tile)
 {
     int             tti5;
-    ViewnixHeader   vh_scale;
-    FILE           *fp_scale;
-	short           bit_fields[] = {0, 15};
-    float           smallest_density_value_scale[] = {0.0},
-                    largest_density_value_scale[] = {0.0};
-    int             slice, row, col, i, j, k, xx, yy, zz;
-    unsigned short ***pin_16;
-	unsigned char ***pin_8;
+    int             slice, row, col, i, k, end, xx, yy, zz;
+    long            c;
 	double          ball_sum, sphere_sum, ball_sumsq, sphere_sumsq, bestt;
 
-    feature_scale = (unsigned short *) malloc(size * sizeof(unsigned short));
-	which_scale = (unsigned char *) malloc(size);
-    if (feature_scale == NULL || which_scale == NULL)
-        Handle_error("Couldn't allocate memory\n");
-
-    pfeature_scale = (unsigned short ***) malloc(pslice * sizeof(unsigned short **));
-	pwhich_scale = (unsigned char ***) malloc(pslice*sizeof(unsigned char **));
-    if (pfeature_scale == NULL || pwhich_scale == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-
-    pfeature_scale[0] = (unsigned short **) malloc(pslice * prow * sizeof(unsigned short *));
-	pwhich_scale[0] = (unsigned char **)malloc(pslice * prow * sizeof(unsigned char *));
-    if (pfeature_scale[0] == NULL || pwhich_scale[0] == NULL)
-        Handle_error("COULD ALLOCATE MEMORY\n");
-    for (slice = 0; slice < pslice; slice++)
-	{
-        pfeature_scale[slice] = pfeature_scale[0] + slice * prow;
-		pwhich_scale[slice] = pwhich_scale[0] + slice * prow;
-	}
-
-    for (slice = 0; slice < pslice; slice++)
-        for (row = 0; row < prow; row++)
-        {
-		    pfeature_scale[slice][row] = feature_scale + (slice * prow + row) * pcol;
-			pwhich_scale[slice][row] = which_scale + (slice * prow + row) * pcol;
-		}
-
-    pin_16 = pimage_16;
-	pin_8 = pimage_8;
-    for (slice = 0; slice < pslice; slice++) {
-        printf("\rScale computing slice %d", slice);
-        fflush(stdout);
-        for (row = 0; row < prow; row++)
+    for (slice = tile->z0; slice < tile->z1; slice++)
+        for (row = tile->y0; row < tile->y1; row++)
             for (col = 0; col < pcol; col++)
                 {
-
+					c = slice * (long) slice_size + row * pcol + col;
 					bestt = 0;
 					ball_sum = ball_sumsq = 0;
-					pwhich_scale[slice][row][col] = MIN_SCALE;
+					which_scale[c] = MIN_SCALE;
                     for (k = MIN_SCALE; k < max_scale; k++) {
 						sphere_sum = sphere_sumsq = 0;
-                        for (i = 0; i < sphere_no_points[k]; i++) {
-                            xx = col + sphere_points[k][i][0];
-                            yy = row + sphere_points[k][i][1];
-                            zz = slice + sphere_points[k][i][2];
-                            if (xx >= 0 && xx < pcol && yy >= 0 &&
-                                yy < prow && zz >= 0 && zz < pslice) {
-                                tti5 = bytes==2? pin_16[zz][yy][xx]:
-									pin_8[zz][yy][xx];
-                                if (tti5 < min_density)
+						end = shells.first[k] + shells.count[k];
+						if (ST_INSIDE(tile, &shells, k, col, row, slice))
+	                        for (i = shells.first[k]; i < end; i++) {
+	                            tti5 = in[c + shells.offset[i]];
+	                            if (tti5 < min_density)
 								{
 									k = max_scale;
 									break;
 								}
 								sphere_sum += tti5;
 								sphere_sumsq += (double)tti5*tti5;
-                            }
-                        }
+	                        }
+						else
+	                        for (i = shells.first[k]; i < end; i++) {
+	                            xx = col + shells.cell[i][0];
+	                            yy = row + shells.cell[i][1];
+	                            zz = slice + shells.cell[i][2];
+	                            if (xx >= 0 && xx < pcol && yy >= 0 &&
+	                                yy < prow && zz >= 0 && zz < pslice) {
+	                                tti5 = in[c + shells.offset[i]];
+	                                if (tti5 < min_density)
+									{
+										k = max_scale;
+										break;
+									}
+									sphere_sum += tti5;
+									sphere_sumsq += (double)tti5*tti5;
+	                            }
+	                        }
 						if (k >= max_scale)
 							break;
 						if (k > min_scale)
 						{
+							/* shells.first[k] voxels are in the ball */
 							double m1, m2, s1_sqr, s2_sqr, t, s1;
-							m1 = ball_sum/ball_no_points[k];
-							m2 = sphere_sum/sphere_no_points[k];
+							m1 = ball_sum/shells.first[k];
+							m2 = sphere_sum/shells.count[k];
 							if (m1-m2 == 0)
 								continue;
 							s1_sqr =
-							    (ball_sumsq-m1*ball_sum)/(ball_no_points[k]-1);
+							    (ball_sumsq-m1*ball_sum)/(shells.first[k]-1);
 							s1 = sqrt(s1_sqr);
 							if (m1-s1>=ball_low && m1+s1<=ball_high)
 							{
 								s2_sqr = (sphere_sumsq-m2*sphere_sum)/
-									(sphere_no_points[k]-1);
-								t = s1_sqr/ball_no_points[k]+
-									s2_sqr/sphere_no_points[k];
+									(shells.count[k]-1);
+								t = s1_sqr/shells.first[k]+
+									s2_sqr/shells.count[k];
 								if (t == 0)
 								{
 									bestt = 65.535;
@@ -452,8 +294,7 @@ int compute_feature_scale()
 								if (t > bestt)
 								{
 									bestt = t;
-									pwhich_scale[slice][row][col] =
-									    (unsigned char)(k-1);
+									which_scale[c] = (unsigned char)(k-1);
 								}
 							}
 						}
@@ -464,13 +305,50 @@ int compute_feature_scale()
 					bestt = rint(1000*bestt);
 					if (bestt > 65535)
 						bestt = 65535;
-					if (bestt > largest_density_value_scale[0])
-						largest_density_value_scale[0] = (float)bestt;
-					pfeature_scale[slice][row][col] = (unsigned short)bestt;
+					out[c] = (unsigned short)bestt;
                 }
-    }
-    printf("\n");
+}
+
+/*****************************************************************************
+ * FUNCTION: compute_feature_scale_3d
+ * DESCRIPTION: computes scale representation of the image.
+ * PARAMETERS:
+ *    feature: whether it is an intensity or an edge or a fractal image.
+ * SIDE EFFECTS:
+ *    feature_scale_data_valid is set.
+ * ENTRY CONDITIONS:
+ *    sigma, bytes must be set.
+ *    image data is valid.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: Undefined if entry condition is not met.
+ * HISTORY:
+ *    Created: 10/3/97 by Punam K. Saha
+ *    Modified: 3/16/04 8-bit scenes handled by Dewey Odhner.
+ *    Modified: 10/19/26 computed by the stencil engine
+ *
+ *****************************************************************************/
+int compute_feature_scale()
+{
+    ViewnixHeader   vh_scale;
+    FILE           *fp_scale;
+	short           bit_fields[] = {0, 15};
+    float           smallest_density_value_scale[] = {0.0},
+                    largest_density_value_scale[] = {0.0};
+    int             i, j;
+
+    feature_scale = (unsigned short *) malloc(size * sizeof(unsigned short));
+	which_scale = (unsigned char *) malloc(size);
+    if (feature_scale == NULL || which_scale == NULL)
+        Handle_error("Couldn't allocate memory\n");
+
+    printf("Scale computing\n");
     fflush(stdout);
+    if (st_pass(pcol, prow, pslice, enhance_kernel, NULL, image,
+            feature_scale))
+        Handle_error("Could not compute scale\n");
+    for (i = 0; i < size; i++)
+        if (feature_scale[i] > largest_density_value_scale[0])
+            largest_density_value_scale[0] = (float)feature_scale[i];
     /************ WRITE SCALE IMAGE ************/
 	if (strcmp(out_file_name, "/dev/null"))
 	{
@@ -522,50 +400,4 @@ int compute_feature_scale()
 
     return (1);
 }
-/*****************************************************************************
-     * FUNCTION: get_max
-     * DESCRIPTION: returns the maximum between two integers
-     * PARAMETERS:
-     *    integer1 and integer2
-     * SIDE EFFECTS:
-     *    Nil.
-     * ENTRY CONDITIONS:
-     *    Nil.
-     * RETURN VALUE: see DESCRIPTION
-     * EXIT CONDITIONS:
-     * HISTORY:
-     *    Created: 9/5/97 by Punam K. Saha
-     *
-     *****************************************************************************/
-int get_max(int a, int b)
-{
-
-    if (a > b)
-        return (a);
-    else
-        return (b);
-}
-/*****************************************************************************
- * FUNCTION: get_min
- * DESCRIPTION: returns the minimum between two integers
- * PARAMETERS:
- *    integer1 and integer2
- * SIDE EFFECTS:
- *    Nil.
- * ENTRY CONDITIONS:
- *    Nil.
- * RETURN VALUE: see DESCRIPTION
- * EXIT CONDITIONS:
- * HISTORY:
- *    Created: 9/5/97 by Punam K. Saha
- *
- *****************************************************************************/
-int get_min(int a, int b)
-{
-
-    if (a < b)
-        return (a);
-    else
-        return (b);
-}
 /*******************************  THE END  *************************************/
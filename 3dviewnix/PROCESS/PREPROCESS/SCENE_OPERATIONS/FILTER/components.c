@@ -0,0 +1,403 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "components.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#endif
+
+/* Scan the runs of set bits in the row starting at bit base; runs may be
+   NULL to count them only. */
+static int scan_row(const unsigned char *bits, long base, int width,
+	CCRun *runs)
+{
+	int x=0, n=0, start;
+	long b;
+
+	while (x < width)
+	{
+		while (x < width)
+		{
+			b = base+x;
+			if ((b&7)==0 && x+8<=width && bits[b>>3]==0)
+			{
+				x += 8;
+				continue;
+			}
+			if (bits[b>>3] & (128>>(b&7)))
+				break;
+			x++;
+		}
+		if (x >= width)
+			break;
+		start = x;
+		while (x < width)
+		{
+			b = base+x;
+			if ((b&7)==0 && x+8<=width && bits[b>>3]==255)
+			{
+				x += 8;
+				continue;
+			}
+			if ((bits[b>>3] & (128>>(b&7))) == 0)
+				break;
+			x++;
+		}
+		if (runs)
+		{
+			runs[n].start = start;
+			runs[n].end = x;
+		}
+		n++;
+	}
+	return n;
+}
+
+/* The root of a set is always its smallest run index, so roots are met
+   first in raster order. */
+static int find_root(int *parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static void unite(int *parent, int a, int b)
+{
+	a = find_root(parent, a);
+	b = find_root(parent, b);
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+/* Join the runs of two rows that touch; ext is 1 if diagonal neighbors
+   along x count. */
+static void link_rows(const CCLabeling *cc, int *parent, int row_a,
+	int row_b, int ext)
+{
+	int i=cc->row_start[row_a], i1=cc->row_start[row_a+1],
+		j=cc->row_start[row_b], j1=cc->row_start[row_b+1];
+
+	while (i<i1 && j<j1)
+	{
+		if (cc->runs[j].start<cc->runs[i].end+ext &&
+				cc->runs[i].start<cc->runs[j].end+ext)
+			unite(parent, i, j);
+		if (cc->runs[i].end < cc->runs[j].end)
+			i++;
+		else
+			j++;
+	}
+}
+
+/* Join the runs of row y of slice z to those of the preceding rows;
+   links to slice z-1 are made only if with_prev_slice. */
+static void link_row(const CCLabeling *cc, int *parent, int y, int z,
+	int with_prev_slice)
+{
+	int row=cc->height*z+y, conn=cc->connectivity;
+
+	if (y > 0)
+		link_rows(cc, parent, row, row-1, conn==8||conn==18||conn==26);
+	if (!with_prev_slice || z==0 || conn==4 || conn==8)
+		return;
+	link_rows(cc, parent, row, row-cc->height, conn>=18);
+	if (conn >= 18)
+	{
+		if (y > 0)
+			link_rows(cc, parent, row, row-cc->height-1, conn==26);
+		if (y < cc->height-1)
+			link_rows(cc, parent, row, row-cc->height+1, conn==26);
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: cc_label_bits
+ * DESCRIPTION: Labels the connected components of a binary scene.
+ * PARAMETERS:
+ *    cc: receives the labeling; free with cc_free
+ *    bits: the packed binary data, (width*height+7)/8 bytes per slice
+ *    width, height, depth: scene size
+ *    connectivity: 4 or 8 within slices, or 6, 18 or 26
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 if connectivity is
+ *    not supported
+ *****************************************************************************/
+int cc_label_bits(CCLabeling *cc, const unsigned char *bits, int width,
+	int height, int depth, int connectivity)
+{
+	int nrows=height*depth, r, nslabs, s, *parent, root, label, max_comp=0;
+	long slice_bits=(long)(width*height+7)/8*8, total;
+	CCStats *st;
+
+	memset(cc, 0, sizeof(*cc));
+	if (connectivity!=4 && connectivity!=8 && connectivity!=6 &&
+			connectivity!=18 && connectivity!=26)
+		return 2;
+	cc->width = width;
+	cc->height = height;
+	cc->depth = depth;
+	cc->connectivity = connectivity;
+	cc->row_start = (int *)malloc((nrows+1)*sizeof(int));
+	if (cc->row_start == NULL)
+		return 1;
+
+	/* runs of each row */
+#pragma omp parallel for schedule(dynamic, 16)
+	for (r=0; r<nrows; r++)
+		cc->row_start[r+1] = scan_row(bits,
+			slice_bits*(r/height)+(long)width*(r%height), width, NULL);
+	cc->row_start[0] = 0;
+	for (total=0,r=1; r<=nrows; r++)
+	{
+		total += cc->row_start[r];
+		if (total > INT_MAX)
+		{
+			cc_free(cc);
+			return 1;
+		}
+		cc->row_start[r] = (int)total;
+	}
+	cc->nruns = (int)total;
+	cc->runs = (CCRun *)malloc((total+1)*sizeof(CCRun));
+	parent = (int *)malloc((total+1)*sizeof(int));
+	if (cc->runs==NULL || parent==NULL)
+	{
+		free(parent);
+		cc_free(cc);
+		return 1;
+	}
+#pragma omp parallel for schedule(dynamic, 16)
+	for (r=0; r<nrows; r++)
+	{
+		int i;
+
+		scan_row(bits, slice_bits*(r/height)+(long)width*(r%height), width,
+			cc->runs+cc->row_start[r]);
+		for (i=cc->row_start[r]; i<cc->row_start[r+1]; i++)
+			parent[i] = i;
+	}
+
+	/* join within slabs of slices, then across slab boundaries */
+	nslabs = omp_get_max_threads();
+	if (nslabs > depth)
+		nslabs = depth;
+#pragma omp parallel for schedule(static, 1)
+	for (s=0; s<nslabs; s++)
+	{
+		int y, z, z0=(int)((long)depth*s/nslabs),
+			z1=(int)((long)depth*(s+1)/nslabs);
+
+		for (z=z0; z<z1; z++)
+			for (y=0; y<height; y++)
+				link_row(cc, parent, y, z, z>z0);
+	}
+	if (connectivity!=4 && connectivity!=8)
+		for (s=1; s<nslabs; s++)
+		{
+			int y, z=(int)((long)depth*s/nslabs);
+
+			for (y=0; y<height; y++)
+			{
+				/* only the links to slice z-1 are missing */
+				int row=height*z+y;
+
+				link_rows(cc, parent, row, row-height, connectivity>=18);
+				if (connectivity >= 18)
+				{
+					if (y > 0)
+						link_rows(cc, parent, row, row-height-1,
+							connectivity==26);
+					if (y < height-1)
+						link_rows(cc, parent, row, row-height+1,
+							connectivity==26);
+				}
+			}
+		}
+
+	/* final labels and statistics */
+	for (r=0; r<nrows; r++)
+	{
+		int i, y=r%height, z=r/height, len;
+
+		for (i=cc->row_start[r]; i<cc->row_start[r+1]; i++)
+		{
+			root = find_root(parent, i);
+			if (root == i)
+			{
+				if (cc->ncomponents == max_comp)
+				{
+					max_comp = max_comp? 2*max_comp: 1024;
+					st = (CCStats *)
+						realloc(cc->stats, max_comp*sizeof(CCStats));
+					if (st == NULL)
+					{
+						free(parent);
+						cc_free(cc);
+						return 1;
+					}
+					cc->stats = st;
+				}
+				label = ++cc->ncomponents;
+				st = cc->stats+label-1;
+				memset(st, 0, sizeof(*st));
+				st->xmin = st->first_x = cc->runs[i].start;
+				st->xmax = cc->runs[i].end-1;
+				st->ymin = st->ymax = st->first_y = y;
+				st->zmin = st->zmax = st->first_z = z;
+			}
+			else
+				label = cc->runs[root].label;
+			cc->runs[i].label = label;
+			st = cc->stats+label-1;
+			len = cc->runs[i].end-cc->runs[i].start;
+			st->size += len;
+			if (cc->runs[i].start < st->xmin)
+				st->xmin = cc->runs[i].start;
+			if (cc->runs[i].end-1 > st->xmax)
+				st->xmax = cc->runs[i].end-1;
+			if (y < st->ymin)
+				st->ymin = y;
+			if (y > st->ymax)
+				st->ymax = y;
+			st->zmax = z; /* slices are visited in increasing order */
+			st->xsum += .5*(cc->runs[i].start+cc->runs[i].end-1)*len;
+			st->ysum += (double)y*len;
+			st->zsum += (double)z*len;
+		}
+	}
+	free(parent);
+	return 0;
+}
+
+void cc_free(CCLabeling *cc)
+{
+	free(cc->runs);
+	free(cc->row_start);
+	free(cc->stats);
+	cc->runs = NULL;
+	cc->row_start = NULL;
+	cc->stats = NULL;
+	cc->nruns = cc->ncomponents = 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: cc_label_at
+ * DESCRIPTION: Returns the label of a voxel, 0 if it is not set.
+ *****************************************************************************/
+int cc_label_at(const CCLabeling *cc, int x, int y, int z)
+{
+	int row=cc->height*z+y, lo=cc->row_start[row], hi=cc->row_start[row+1],
+		mid;
+
+	while (lo < hi)
+	{
+		mid = (lo+hi)/2;
+		if (cc->runs[mid].end <= x)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo<cc->row_start[row+1] && cc->runs[lo].start<=x?
+		cc->runs[lo].label: 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: cc_slice_labels
+ * DESCRIPTION: Fills a slice with the labels of its voxels.
+ * PARAMETERS:
+ *    cc: the labeling
+ *    z: the slice
+ *    out: width*height labels; 0 where not set
+ *    label_offset: added to each nonzero label
+ *****************************************************************************/
+void cc_slice_labels(const CCLabeling *cc, int z, unsigned short *out,
+	int label_offset)
+{
+	int y, i, x;
+
+	memset(out, 0, (size_t)cc->width*cc->height*sizeof(unsigned short));
+	for (y=0; y<cc->height; y++)
+		for (i=cc->row_start[cc->height*z+y];
+				i<cc->row_start[cc->height*z+y+1]; i++)
+			for (x=cc->runs[i].start; x<cc->runs[i].end; x++)
+				out[cc->width*y+x] =
+					(unsigned short)(cc->runs[i].label+label_offset);
+}
+
+static void set_bit_range(unsigned char *bits, long b0, long b1)
+{
+	for (; b0<b1 && (b0&7); b0++)
+		bits[b0>>3] |= 128>>(b0&7);
+	for (; b0+8<=b1; b0+=8)
+		bits[b0>>3] = 255;
+	for (; b0<b1; b0++)
+		bits[b0>>3] |= 128>>(b0&7);
+}
+
+/*****************************************************************************
+ * FUNCTION: cc_select_bits
+ * DESCRIPTION: Makes a packed binary scene of selected components.
+ * PARAMETERS:
+ *    cc: the labeling
+ *    keep: keep[label] is non-zero for each component to set;
+ *       ncomponents+1 entries
+ *    bits: receives the scene, (width*height+7)/8 bytes per slice
+ *****************************************************************************/
+void cc_select_bits(const CCLabeling *cc, const unsigned char *keep,
+	unsigned char *bits)
+{
+	long slice_bytes=((long)cc->width*cc->height+7)/8;
+	int z;
+
+	/* slices start on byte boundaries, so threads never share a byte */
+#pragma omp parallel for schedule(dynamic)
+	for (z=0; z<cc->depth; z++)
+	{
+		int y, i;
+		long base;
+
+		memset(bits+slice_bytes*z, 0, slice_bytes);
+		for (y=0; y<cc->height; y++)
+		{
+			base = slice_bytes*8*z+(long)cc->width*y;
+			for (i=cc->row_start[cc->height*z+y];
+					i<cc->row_start[cc->height*z+y+1]; i++)
+				if (keep[cc->runs[i].label])
+					set_bit_range(bits, base+cc->runs[i].start,
+						base+cc->runs[i].end);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Connected-component labeling of binary scenes.
+ *
+ * The packed BIM data are scanned into runs of set voxels along each row,
+ * and runs of adjacent rows that touch are joined with union-find.  Slabs
+ * of slices are labeled by separate threads and joined at the slab
+ * boundaries afterwards.  Components are numbered from 1 in the raster
+ * order of their first voxel, and their statistics are gathered while
+ * the final labels are assigned.  No voxel-sized label volume is built;
+ * labels of a slice or a mask of selected components are produced from
+ * the runs on demand.
+ */
+
+#ifndef __components_h
+#define __components_h
+
+typedef struct {
+	int start, end;     /* voxels [start, end) of the row */
+	int label;
+} CCRun;
+
+typedef struct {
+	long size;
+	int xmin, xmax, ymin, ymax, zmin, zmax;
+	double xsum, ysum, zsum;    /* centroid = sum / size */
+	int first_x, first_y, first_z;
+} CCStats;
+
+typedef struct {
+	int width, height, depth, connectivity;
+	int nruns;
+	CCRun *runs;
+	int *row_start;     /* first run of each row; height*depth+1 entries */
+	int ncomponents;
+	CCStats *stats;     /* stats[label-1] */
+} CCLabeling;
+
+int cc_label_bits(CCLabeling *cc, const unsigned char *bits, int width,
+	int height, int depth, int connectivity);
+void cc_free(CCLabeling *cc);
+int cc_label_at(const CCLabeling *cc, int x, int y, int z);
+void cc_slice_labels(const CCLabeling *cc, int z, unsigned short *out,
+	int label_offset);
+void cc_select_bits(const CCLabeling *cc, const unsigned char *keep,
+	unsigned char *bits);
+
+#endif
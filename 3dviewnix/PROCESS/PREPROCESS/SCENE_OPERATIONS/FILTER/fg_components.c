@@ -52,12 +52,7 @@ Adapted 6/13/01 from gaussian3d.c by Dewey Odhner.
 
 
 #include "slices.c"
-
-typedef struct { int x, y, z; } Point;
-
-#define QueueItem Point
-#define HandleQueueError {fprintf(stderr,"Out of memory.\n");exit(1);}
-#include "port_data/queue.c"
+#include "components.h"
 
 
 
@@ -125,15 +120,13 @@ char *argv[];
 	int i,j,k;			/* general use */
 	int error;			/* error code */
 	char *comments;     /* used to modify the header (description field) */
-	int ll, m, n, p, q;
+	int p, x, y, z;
 	int largest_density_value=0;
-	int neighbor[14], connectivity=6;
-	unsigned short eq_tab[65535];
-	int max_label=0, nseeds;
-	unsigned char *in_buffer1;
-	unsigned short *out_buffer, *outptr[14];
-	unsigned char flags[65535];
-	Point cur, nex, scanning;
+	int connectivity=6;
+	int label_offset=0, nseeds;
+	unsigned char *in_buffer1, *keep;
+	unsigned short *out_buffer;
+	CCLabeling cc;
 
 
 	if (argc<4 || (argc>=5 && (argc%3!=2 || (atoi(argv[4])>26))))
@@ -144,7 +137,7 @@ char *argv[];
 		fprintf(stderr, "input    : name of input file;\n");
 		fprintf(stderr, "output   : name of output file;\n");
 		fprintf(stderr, "mode     : mode of operation (0=foreground, 1=background);\n");
-		fprintf(stderr, "connectivity: [4 | 6 | 18 | 26];\n");
+		fprintf(stderr, "connectivity: [4 | 8 | 6 | 18 | 26];\n");
 		fprintf(stderr, "x y z    : seed coordinates\n");
 		exit(1);
 	}
@@ -169,7 +162,7 @@ char *argv[];
     sscanf(argv[3], "%d", &execution_mode);
 
 
-	if (argc == 5)
+	if (argc >= 5)
 		connectivity = atoi(argv[4]);
 
 	/* If in background mode, then place an entry in the BG_PROCESS.COM file */
@@ -198,38 +191,18 @@ char *argv[];
 	height =  vh.scn.xysize[1];
 	length = (width * height + 7) / 8;
 
-	neighbor[ 0] = (1*(height+2)+1)*(width+2)+1;
-
-	neighbor[ 1] = (1*(height+2)+0)*(width+2)+1;
-	neighbor[ 2] = (1*(height+2)+1)*(width+2)+0;
-
-	neighbor[ 3] = (0*(height+2)+1)*(width+2)+1;
-
-	neighbor[ 4] = (0*(height+2)+0)*(width+2)+1;
-	neighbor[ 5] = (0*(height+2)+1)*(width+2)+0;
-	neighbor[ 6] = (0*(height+2)+1)*(width+2)+2;
-	neighbor[ 7] = (0*(height+2)+2)*(width+2)+1;
-	neighbor[ 8] = (1*(height+2)+0)*(width+2)+0;
-	neighbor[ 9] = (1*(height+2)+0)*(width+2)+2;
-
-	neighbor[10] = (0*(height+2)+0)*(width+2)+0;
-	neighbor[11] = (0*(height+2)+0)*(width+2)+2;
-	neighbor[12] = (0*(height+2)+2)*(width+2)+0;
-	neighbor[13] = (0*(height+2)+2)*(width+2)+2;
-
-
 	/* Allocate memory */
 	if(vh.scn.num_of_bits == 1)
 	{
-    	/* create buffer for one binary image */
-    	if( (in_buffer1 = (unsigned char *) calloc(length, 1) ) == NULL)
+    	/* create buffer for one binary volume */
+    	if( (in_buffer1 = (unsigned char *) calloc(length, sl.max_slices) ) == NULL)
     	{
        		fprintf(stderr, "ERROR: Can't allocate input image buffer.\n");
        		exit(1);
     	}
 
     	/* create buffer for one grey image */
-    	if( (out_buffer = (unsigned short *) malloc(2*(width+2)*(height+2)*(sl.max_slices+2)) ) == NULL)
+    	if( (out_buffer = (unsigned short *) malloc(2*width*height) ) == NULL)
     	{
        		fprintf(stderr, "ERROR: Can't allocate output image buffer.\n");
        		exit(1);
@@ -266,7 +239,6 @@ char *argv[];
     vh.scn.description_valid = 0x1;
 	vh.scn.smallest_density_value[0] = 0;
 
-	memset(eq_tab, 0, sizeof(eq_tab));
 	largest_density_value = 1;
 
 
@@ -278,197 +250,73 @@ char *argv[];
 		/* Seek the appropriate location */
 		fseek(fpin, (k*length)+hlength, 0);
 
-		/* Initialize output volume */
-	    memset(out_buffer, 0, 2*(width+2)*(height+2)*(sl.slices[j]+2));
-		for(i=0; i<sl.slices[j]; i++)
+		/* read volume */
+		if(fread(in_buffer1, 1, length*sl.slices[j], fpin) !=
+				length*sl.slices[j])
 		{
-	        /* read first slice */
-	        if(fread(in_buffer1, 1, length, fpin) != length)
-   	        {
-   		        fprintf(stderr, "ERROR: Couldn't read slice #%d of volume #%d.\n", 1, j+1);
-   		        exit(2);
-   	        }
-			m = 0;
-			for (ll=0; ll<height; ll++)
-				for (n=0; n<width; n++, m++)
-					if (in_buffer1[m/8] & (128>>(m%8)))
-						(out_buffer+1+(width+2)*(1+ll+(height+2)*(1+i)))[n] =
-							65535;
+			fprintf(stderr, "ERROR: Couldn't read volume #%d.\n", j+1);
+			exit(2);
 		}
 
+		if(execution_mode == 0)
+		{
+			if(sl.volumes > 1)
+				printf("Filtering volume #%d/%d ...\n", j+1, sl.volumes);
+			else
+				printf("Filtering ...\n");
+			fflush(stdout);
+		}
+		error = cc_label_bits(&cc, in_buffer1, width, height, sl.slices[j],
+			connectivity);
+		if (error == 2)
+		{
+			fprintf(stderr, "%s: Connectivity %d not supported.\n", argv[0],
+				connectivity);
+			exit(1);
+		}
+		if (error)
+		{
+			fprintf(stderr, "ERROR: Can't allocate component buffers.\n");
+			exit(1);
+		}
 
-#define Is_Set(pt) (out_buffer[(width+2)*(height+2)*((pt).z+1)+ \
-	(width+2)*((pt).y+1)+(pt).x+1] == 1)
-
-#define Was_Set(pt) (out_buffer[(width+2)*(height+2)*((pt).z+1)+ \
-	(width+2)*((pt).y+1)+(pt).x+1] > 0)
-
-#define Set_Word(pt) (out_buffer[(width+2)*(height+2)*((pt).z+1)+ \
-	(width+2)*((pt).y+1)+(pt).x+1] = 1)
-
-#define Enqueue_nex { Set_Word(nex); Enqueue(nex); }
-
-
-		if (nseeds && connectivity==6)
+		if (nseeds)
 		{
-			eq_tab[1] = max_label = 1;
+			if ((keep=(unsigned char *)calloc(cc.ncomponents+1, 1)) == NULL)
+			{
+				fprintf(stderr, "ERROR: Can't allocate component buffers.\n");
+				exit(1);
+			}
 			for (p=0; p<nseeds; p++)
 			{
-				scanning.x = atoi(argv[3*p+5]);
-				scanning.y = atoi(argv[3*p+6]);
-				scanning.z = atoi(argv[3*p+7]);
-				if (scanning.x<0 || scanning.x>=width ||
-						scanning.y<0 || scanning.y>=height ||
-						scanning.z<0 || scanning.z>=sl.slices[j])
+				x = atoi(argv[3*p+5]);
+				y = atoi(argv[3*p+6]);
+				z = atoi(argv[3*p+7]);
+				if (x<0 || x>=width || y<0 || y>=height ||
+						z<0 || z>=sl.slices[j])
 				{
 					fprintf(stderr, "Seed out of scene.\n");
 					exit(1);
 				}
-				ClearQueue;
-				cur = scanning;
-				Set_Word(cur);
-				Enqueue(cur);
-				while (!QueueIsEmpty)
+				error = cc_label_at(&cc, x, y, z);
+				if (error && !keep[error])
 				{
-					Dequeue(cur);
-					nex.x = cur.x-1;
-					nex.y = cur.y;
-					nex.z = cur.z;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
-					nex.x = cur.x+1;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
-					nex.x = cur.x;
-					nex.y = cur.y-1;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
-					nex.y = cur.y+1;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
-					nex.y = cur.y;
-					nex.z = cur.z-1;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
-					nex.z = cur.z+1;
-					if (!Is_Set(nex) &&
-							Was_Set(nex))
-						Enqueue_nex
+					keep[error] = TRUE;
+					printf("First seed of component: (%f, %f, %f)\n",
+						vh.scn.xypixsz[0]*x, vh.scn.xypixsz[1]*y,
+						sl.location3[j][z]);
 				}
 			}
 		}
 		else
-	      /* Forward pass */
-	      for (i=0; i<sl.slices[j]; i++)
-	      {
-			if(execution_mode == 0)
-			{
-				if(sl.volumes > 1)
-					printf("Filtering volume #%d/%d, slice #%d/%d ...\n", j+1,sl.volumes,i+1, sl.slices[j]);
-				else
-					printf("Filtering slice #%d/%d ...\n", i+1, sl.slices[j]);
-
-				fflush(stdout);
-			}
-			for (ll=0; ll<height; ll++)
-			{
-				for (m=0; m<=connectivity/2; m++)
-					outptr[m] =
-						out_buffer+(ll+i*(height+2))*(width+2)+neighbor[m];
-				for (n=0; n<width; n++)
-				{
-					if (*outptr[0])
-					{
-						for (m=1; m<=connectivity/2; m++)
-							if (*outptr[m])
-							{
-								if (*outptr[0] == 65535)
-									*outptr[0] = *outptr[m];
-								else if (*outptr[0]!=*outptr[m] &&
-										eq_tab[*outptr[0]]!=eq_tab[*outptr[m]])
-								{
-									if (eq_tab[*outptr[0]]> eq_tab[*outptr[m]])
-									{
-										q = eq_tab[*outptr[0]];
-										for (p=q; p<=max_label; p++)
-											if (eq_tab[p] == q)
-												eq_tab[p] = eq_tab[*outptr[m]];
-									}
-									else
-									{
-										q = eq_tab[*outptr[m]];
-										for (p=q; p<=max_label; p++)
-											if (eq_tab[p] == q)
-												eq_tab[p] = eq_tab[*outptr[0]];
-									}
-								}
-							}
-						if (*outptr[0] == 65535)
-						{
-							++max_label;
-							*outptr[0] = eq_tab[max_label] = max_label;
-							if (max_label == 65535)
-							{
-    							fprintf(stderr,
-									"%s: Too many components.\n", argv[0]);
-    					  	 	exit(1);
-							}
-						}
-					}
-					for (m=0; m<=connectivity/2; m++)
-						outptr[m]++;
-				}
-			}
-
-	      } /* end forward pass */
-
-		for (p=1; p<=max_label; p++)
-		{
-			for (m=p; m<=max_label; m++)
-				if (eq_tab[m] == p)
-					goto next_p;
-			for (m=p; eq_tab[m]<p; m++)
-				if (m > max_label)
-					goto next_p;
-			for (ll=m; ll<=max_label; ll++)
-				if (eq_tab[ll] == m)
-					eq_tab[ll] = p;
-			next_p:;
-		}
-		if (nseeds)
 		{
-			memset(flags, FALSE, max_label+1);
-			for (p=0; p<nseeds; p++)
+			if (label_offset+cc.ncomponents > 65535)
 			{
-				m = eq_tab[out_buffer[atoi(argv[3*p+5])+1+(atoi(argv[3*p+6])+1+
-					(atoi(argv[3*p+7])+1)*(height+2))*(width+2)]];
-				for (ll=m; ll<=max_label; ll++)
-					if (eq_tab[ll] == m)
-						flags[ll] = TRUE;
-				for (ll=0; ll<p; ll++)
-					if (eq_tab[out_buffer[atoi(argv[3*ll+5])+1+
-							(atoi(argv[3*ll+6])+1+(atoi(argv[3*ll+7])+1)*
-							(height+2))*(width+2)]] == m)
-						break;
-				if (ll == p)
-					printf("First seed of component: (%f, %f, %f)\n",
-						vh.scn.xypixsz[0]*atoi(argv[3*p+5]),
-						vh.scn.xypixsz[1]*atoi(argv[3*p+6]),
-						sl.location3[j][atoi(argv[3*p+7])]);
+				fprintf(stderr, "%s: Too many components.\n", argv[0]);
+				exit(1);
 			}
-		}
-		else
-		{
-			for (m=0,p=1; p<=max_label; p++)
-				if (eq_tab[p] > m)
-					m = eq_tab[p];
-			if (m > largest_density_value)
-				largest_density_value = m;
+			if (label_offset+cc.ncomponents > largest_density_value)
+				largest_density_value = label_offset+cc.ncomponents;
 		}
 		if (j == 0)
 		{
@@ -485,36 +333,32 @@ char *argv[];
 		}
 
 		/* Save output volume */
-	    for(i=0; i<sl.slices[j]; i++)
-		  if (nseeds)
-		  {
-		    memset(in_buffer1, 0, length);
-			for (ll=0; ll<height; ll++)
-			{
-				outptr[0] = out_buffer+(ll+i*(height+2))*(width+2)+neighbor[0];
-				for (n=0; n<width; n++)
-					if (outptr[0][n]<65535 && flags[outptr[0][n]])
-						in_buffer1[(ll*width+n)/8] |= 128>>(ll*width+n)%8;
-			}
-			if(VWriteData((char *)in_buffer1, 1, length, fpout, &error))
+		if (nseeds)
+		{
+			cc_select_bits(&cc, keep, in_buffer1);
+			free(keep);
+			if(VWriteData((char *)in_buffer1, 1, length*sl.slices[j], fpout,
+					&error))
    		 	{
    				fprintf(stderr, "ERROR: Couldn't write volume #%d.\n", j+1);
    				exit(3);
    			}
-		  }
-		  else
-			for (ll=0; ll<height; ll++)
+		}
+		else
+		{
+			for(i=0; i<sl.slices[j]; i++)
 			{
-				outptr[0] = out_buffer+(ll+i*(height+2))*(width+2)+neighbor[0];
-				for (n=0; n<width; n++)
-					outptr[0][n] = eq_tab[outptr[0][n]];
-				if(VWriteData((char *)(out_buffer+1+(width+2)*(1+ll+(height+2)*(1+i))),
-						2, width, fpout, &error))
+				cc_slice_labels(&cc, i, out_buffer, label_offset);
+				if(VWriteData((char *)out_buffer, 2, width*height, fpout,
+						&error))
       		 	{
        				fprintf(stderr, "ERROR: Couldn't write volume #%d.\n",j+1);
        				exit(3);
        			}
 			}
+			label_offset += cc.ncomponents;
+		}
+		cc_free(&cc);
 
 	} /* end for-loop for volumes[j] */
 
@@ -34,7 +34,8 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 
 
 
-	Each slice is is loaded and filtered individually.
+	Each volume is loaded whole and filtered by the morphology engine
+	(morphology.c).
 
 
 
@@ -56,6 +57,7 @@ Date: 11/10/00
 
 #include "slices.c"
 #include "fff.c"
+#include "morphology.h"
 
 
 
@@ -105,13 +107,19 @@ int *len;   /* length of header */
 
 
 /* Modified: 11/14/00 for morphological operations by Dewey Odhner */
+/* Modified: 10/19/26 whole volumes filtered by the morphology engine;
+	iterations and ball operations added */
 int main(argc, argv)
 int argc;
 char *argv[];
 {
 	FILE *fpin, *fpout;	/* inpput/output files */
 	int execution_mode;	/* execution mode */
-	int operation;		/* execution mode */
+	int operation;		/* [+|-]N operation, or 0 for a ball */
+	int ball_op;		/* MM_DILATE, MM_ERODE, MM_OPEN or MM_CLOSE */
+	int iterations=1;	/* times to apply a [+|-]N operation */
+	double radius=0;	/* radius of the ball */
+	double spacing[3];	/* cell spacing for the ball */
 	ViewnixHeader vh;	/* 3DViewnix header */
 	SLICES	sl;			/* Structure containing information about the slices of the scene */
 	char group[5],		/* Used in VWriteHeader */
@@ -120,26 +128,55 @@ char *argv[];
 	int hlength;		/* length of the input header */
 	int width, height;	/* dimensions of a slice */
 	int nbits;			/* Number of bits of input data */
+	int bytes;			/* bytes per cell of the volume */
 	int i,j,k;			/* general use */
 	int error;			/* error code */
 	char *comments;     /* used to modify the header (description field) */
 	float space,pixel;
 	int ll, m;
 
-	unsigned char *in_buffer1;
-	unsigned char *in_buffer8a, *in_buffer8b, *in_buffer8c, *out_buffer8, *temp8;
-	unsigned short *in_buffer16a, *in_buffer16b, *in_buffer16c, *out_buffer16, *temp16;
+	unsigned char *in_buffer1, *out_buffer8;
+	unsigned char *volume;	/* the slices of a volume */
+	long slice_cells;
 
 
-	if(argc != 5)
+	operation = 0;
+	ball_op = -1;
+	if (argc==5 || argc==6)
+	{
+		if (strcmp(argv[3], "dilate") == 0)
+			ball_op = MM_DILATE;
+		else if (strcmp(argv[3], "erode") == 0)
+			ball_op = MM_ERODE;
+		else if (strcmp(argv[3], "open") == 0)
+			ball_op = MM_OPEN;
+		else if (strcmp(argv[3], "close") == 0)
+			ball_op = MM_CLOSE;
+		else
+			sscanf(argv[3], "%d", &operation);
+		if (argc == 6)
+		{
+			if (ball_op >= 0)
+				sscanf(argv[5], "%lf", &radius);
+			else
+				sscanf(argv[5], "%d", &iterations);
+		}
+	}
+	if((argc!=5 && argc!=6) || (ball_op>=0? argc!=6 || radius<0:
+			(abs(operation)|1)!=5 && (abs(operation)|1)!=7 &&
+			(abs(operation)|1)!=9 && (abs(operation)|1)!=19 &&
+			(abs(operation)|1)!=27))
 	{
 		printf("Usage:\n");
-		printf("%s input output operation mode\n", argv[0]);
+		printf("%s input output operation mode [iterations | radius]\n", argv[0]);
 		printf("where:\n");
 		printf("input    : name of input file;\n");
 		printf("output   : name of output file;\n");
-		printf("operation: [+|-][5|7|9|19|27];\n");
+		printf("operation: [+|-][5|7|9|19|27], or dilate, erode, open or close by a ball\n");
+		printf("           (binary scenes only);\n");
 		printf("mode     : mode of operation (0=foreground, 1=background);\n");
+		printf("iterations: times to apply a [+|-]N operation (default = 1);\n");
+		printf("radius   : radius of the ball, in the units of the scene;\n");
 		exit(1);
 	}
 	
@@ -159,9 +196,6 @@ char *argv[];
         exit(1);
     }
 
-    /* Get operation */
-    sscanf(argv[3], "%d", &operation);
-
     /* Get EXECUTION MODE */
     sscanf(argv[4], "%d", &execution_mode);
 
@@ -191,57 +225,38 @@ char *argv[];
 		length = (width * height + 7) / 8;
 	pixel = vh.scn.xypixsz[0];
 	space = sl.Min_spacing3;
+	if (ball_op>=0 && nbits!=1)
+	{
+		printf("ERROR: Ball operations need a binary scene.\n");
+		exit(1);
+	}
+	spacing[0] = pixel;
+	spacing[1] = vh.scn.xypixsz[1];
+	spacing[2] = space>0? space: pixel;
 
 
 	/* Allocate memory */
-	if(nbits == 1)
+	slice_cells = (long)width*height;
+	bytes = nbits==16? 2: 1;
+	if( (volume = (unsigned char *)
+			malloc(slice_cells*sl.max_slices*bytes+8)) == NULL)
 	{
-    	/* create buffer for one binary image */
-    	if( (in_buffer1 = (unsigned char *) calloc(1, length) ) == NULL)
-    	{
-       		printf("ERROR: Can't allocate input image buffer.\n");
-       		exit(1);
-    	}
-
-		length = length*8;
-
-    	/* create buffer for one grey image */
-    	if( (in_buffer8b = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(in_buffer8a = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(in_buffer8c = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(out_buffer8 = (unsigned char *) calloc(1, length) ) == NULL)
-    	{
-       		printf("ERROR: Can't allocate input image buffer.\n");
-       		exit(1);
-    	}
- 
+		printf("ERROR: Can't allocate volume buffer.\n");
+		exit(1);
 	}
-	else
-	if(nbits == 8)
+	if(nbits == 1)
 	{
-    	/* create buffer for one grey image */
-    	if( (in_buffer8b = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(in_buffer8a = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(in_buffer8c = (unsigned char *) calloc(1, length) ) == NULL  ||
-    		(out_buffer8 = (unsigned char *) calloc(1, length) ) == NULL)
+    	/* create buffers for one binary image */
+    	if( (in_buffer1 = (unsigned char *) calloc(1, length) ) == NULL)
     	{
        		printf("ERROR: Can't allocate input image buffer.\n");
        		exit(1);
     	}
- 
-	}
-	else
-	{
-    	/* create buffer for one grey image */
-    	if( (in_buffer16b = (unsigned short *) calloc(1, length) ) == NULL  ||
-    		(in_buffer16a = (unsigned short *) calloc(1, length) ) == NULL  ||
-    		(in_buffer16c = (unsigned short *) calloc(1, length) ) == NULL  ||
-    		(out_buffer16 = (unsigned short *) calloc(1, length) ) == NULL)
+    	if( (out_buffer8 = (unsigned char *) calloc(1, length) ) == NULL)
     	{
-       		printf("ERROR: Can't allocate input image buffer.\n");
+       		printf("ERROR: Can't allocate output image buffer.\n");
        		exit(1);
     	}
- 
 	}
 
 	/*-------------------------*/
@@ -277,151 +292,91 @@ char *argv[];
 	for(j=0; j<sl.volumes; j++)
 	{
 		/* Seek the appropriate location */
-		if(nbits == 1)
-			fseek(fpin, (k*length/8)+hlength, 0);
-		else
-			fseek(fpin, k*length+hlength, 0);
-
-
-	   /* Read slices for filtering first slice on the scene (a=b=1st, c=2nd slice) */
-	   if(nbits == 1)
-	   {
-		   /* read first slice */
-		   if(fread(in_buffer1, 1, (length/8), fpin) != length/8)
-       	   {
-       		   printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
-       		   exit(2);
-       	   }
-		   bin_to_grey(in_buffer1, (length/8), in_buffer8b, 0, 255);
-
-		   for(i=length-1; i>=0; i--)
-			   in_buffer8a[i] = 0;
-			
-	   }
-	   /* 8 BITS/PIXEL */
-	   else
-	   if (nbits <= 8)
-	   {
-		   if(fread(in_buffer8b, 1, length, fpin) != length)
-       	   {
-       		   printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
-       		   exit(2);
-       	   }
-
-		   for(i=length-1; i>=0; i--)
-			   in_buffer8a[i] = 0;
-	   }
-	   /* 16 BITS/PIXEL */
-	   else
-	   {
-			VReadData((char *)in_buffer16b, 2, length/2, fpin, &ll);
-			if( ll != length/2)
-       	   	{
-       		   printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
-       		   exit(2);
-       	   	}
-		   	for(i=(length/2)-1; i>=0; i--)
-			   in_buffer16a[i] = 0;
-	   }
-	
-	  /*--------------------------------------*/
-	  /* For each Volume, traverse ALL SLICES */
-	  for(i=0; i<sl.slices[j]; i++)
-	  {
-
+		fseek(fpin, k*length+hlength, 0);
 
 		if(execution_mode == 0)
 		{
 			if(sl.volumes > 1)
-			printf("Filtering volume #%d/%d, slice #%d/%d ...\n", j+1,sl.volumes,i+1, sl.slices[j]);
+			printf("Filtering volume #%d/%d ...\n", j+1,sl.volumes);
 			else
-			printf("Filtering slice #%d/%d ...\n", i+1, sl.slices[j]);
+			printf("Filtering ...\n");
 
 			fflush(stdout);
 		}
 
-
-		/*--------------------*/
-		/* LOAD NEXT SLICE IN */
-
-		if(i>0)
+		/*----------------------*/
+		/* LOAD THE WHOLE VOLUME */
+		for(i=0; i<sl.slices[j]; i++)
 		{
-			if(nbits <= 8)
-			{
-				temp8 = in_buffer8a;
-				in_buffer8a = in_buffer8b;
-				in_buffer8b = in_buffer8c;
-				in_buffer8c = temp8;
-			}
-			else
-			{
-				temp16 = in_buffer16a;
-				in_buffer16a = in_buffer16b;
-				in_buffer16b = in_buffer16c;
-				in_buffer16c = temp16;
-			}
-		}
-
-
-		/* 1 or 8 Bits/Pixel */
-		if(nbits <= 8)
-		{
-			/* Load input slice */
 			/* BINARY */
 			if(nbits == 1)
 			{
-				/* 3rd slice */
-				if (i < sl.slices[j]-1)
+				if (fread(in_buffer1, 1, length, fpin) != length)
 				{
-				  if (fread(in_buffer1, 1, (length/8), fpin) != length/8)
-       			  {
-       				printf("ERROR: Couldn't read slice #%d of volume #%d.\n",
-					  i+1, j+1);
-       				exit(2);
-       			  }
+					printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
+					exit(2);
 				}
-				else
-				  memset(in_buffer1, 0, length/8);
-				bin_to_grey(in_buffer1, (length/8), in_buffer8c, 0, 255);
+				bin_to_grey(in_buffer1, length, volume+slice_cells*i, 0, 255);
 			}
 			/* 8 BITS/PIXEL */
 			else
+			if (nbits <= 8)
 			{
-				/* 3rd slice */
-				if (i < sl.slices[j]-1)
+				if (fread(volume+slice_cells*i, 1, length, fpin) != length)
 				{
-				  if (fread(in_buffer8c, 1, length, fpin) != length)
-       			  {
-       				printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
-       				exit(2);
-       			  }
+					printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
+					exit(2);
 				}
-				else
-				  memset(in_buffer8c, 0, length);
 			}
+			/* 16 BITS/PIXEL */
+			else
+			{
+				VReadData((char *)(volume+slice_cells*i*2), 2, length/2, fpin, &ll);
+				if( ll != length/2)
+				{
+					printf("ERROR: Couldn't read slice #%d of volume #%d.\n", i+1, j+1);
+					exit(2);
+				}
+			}
+		}
 
-			/* Filter */
-			morph_8(in_buffer8a, in_buffer8b, in_buffer8c, width,height,
-								operation, out_buffer8);
+		/* Filter */
+		if (ball_op >= 0)
+			error = mm_ball(volume, width, height, sl.slices[j], spacing,
+				radius, ball_op);
+		else
+			error = mm_neighborhood(volume, bytes, width, height,
+				sl.slices[j], operation, iterations);
+		if (error)
+		{
+			printf("ERROR: Can't filter volume #%d (%s).\n", j+1,
+				error==1? "out of memory": "bad operation");
+			exit(1);
+		}
 
-			/* Save output slice */
-        	if (nbits == 1)
+		/*---------------------*/
+		/* SAVE OUTPUT SLICES */
+		for(i=0; i<sl.slices[j]; i++)
+		{
+			if (nbits == 1)
 			{
+				unsigned char *slice=volume+slice_cells*i;
+
 				for (ll=0; ll<width*height/8; ll++)
 					out_buffer8[ll] =
-						(out_buffer8[ll*8]? 128:0) |
-						(out_buffer8[ll*8+1]? 64:0) |
-						(out_buffer8[ll*8+2]? 32:0) |
-						(out_buffer8[ll*8+3]? 16:0) |
-						(out_buffer8[ll*8+4]? 8:0) |
-						(out_buffer8[ll*8+5]? 4:0) |
-						(out_buffer8[ll*8+6]? 2:0) |
-						(out_buffer8[ll*8+7]? 1:0);
+						(slice[ll*8]? 128:0) |
+						(slice[ll*8+1]? 64:0) |
+						(slice[ll*8+2]? 32:0) |
+						(slice[ll*8+3]? 16:0) |
+						(slice[ll*8+4]? 8:0) |
+						(slice[ll*8+5]? 4:0) |
+						(slice[ll*8+6]? 2:0) |
+						(slice[ll*8+7]? 1:0);
 				if (width*height%8)
 				{
 					m = 0;
 					for (ll=0; ll<width*height%8; ll++)
-						if (out_buffer8[width*height/8*8+ll])
+						if (slice[width*height/8*8+ll])
 							m |= 128>>ll;
 					out_buffer8[width*height/8] = m;
 				}
@@ -433,46 +388,27 @@ char *argv[];
            			exit(3);
         		}
 			}
-			else if(fwrite(out_buffer8, 1,width*height, fpout) != width*height)
-        	{
-           		printf("ERROR: Couldn't write slice #%d of volume #%d.\n",
-					i+1, j+1);
-           		exit(3);
-        	}
-		}
-		/* 16 Bits/Pixel */
-		else
-		{
-			/* 3rd slice */
-			if( i < sl.slices[j] - 1)
+			else if (nbits <= 8)
 			{
-				VReadData((char *)in_buffer16c, 2, length/2, fpin, &ll);
-				if( ll != length/2)
-       			{
-       				printf("ERROR: Couldn't read slice #%d of volume #%d.\n",
+				if(fwrite(volume+slice_cells*i, 1,width*height, fpout) != width*height)
+        		{
+           			printf("ERROR: Couldn't write slice #%d of volume #%d.\n",
 						i+1, j+1);
-       				exit(2);
-       			}
+           			exit(3);
+        		}
 			}
 			else
-				memset(in_buffer16c, 0, length);
-
-			/* Filter */
-			morph_16(in_buffer16a, in_buffer16b, in_buffer16c,
-								width, height, operation, out_buffer16);
-
-			/* Save output slice */
-			VWriteData((char *)out_buffer16, 2, width*height, fpout, &ll);
-			if(ll != length/2)
-        	{
-           		printf("ERROR: Couldn't write slice #%d of volume #%d.\n", i+1, j+1);
-           		exit(3);
-        	}
+			{
+				VWriteData((char *)(volume+slice_cells*i*2), 2, width*height, fpout, &ll);
+				if(ll != length/2)
+        		{
+           			printf("ERROR: Couldn't write slice #%d of volume #%d.\n", i+1, j+1);
+           			exit(3);
+        		}
+			}
 		}
 
-		k++;
-
-	  } /* end for-loop for all slices[i] */
+		k += sl.slices[j];
 	} /* end for-loop for volumes[j] */
 
 	VCloseData(fpout);
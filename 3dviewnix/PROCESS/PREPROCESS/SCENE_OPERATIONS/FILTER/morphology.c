@@ -0,0 +1,538 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "morphology.h"
+
+#define MM_INF 1e30f
+#define MM_TILE 32  /* lines along y or z copied at a time */
+
+/* The lines of a volume along one axis.  Line i of slab o starts at cell
+   o*outer_step+i*inner_step and has n cells stride apart; the slabs are
+   slices for the x and y axes and rows of slices for the z axis, so that
+   each slab is a separate block of memory for its thread.  Lines along y
+   and z are copied tile (adjacent) lines at a time, so that all of each
+   cache line read is used. */
+typedef struct {
+	int n, nouter, ninner, tile;
+	long stride, outer_step, inner_step;
+} LineSet;
+
+static int line_set(LineSet *ls, int width, int height, int depth,
+	int axis)
+{
+	long wh=(long)width*height;
+
+	switch (axis)
+	{
+		case 0:
+			ls->n = width;
+			ls->stride = 1;
+			ls->nouter = depth;
+			ls->outer_step = wh;
+			ls->ninner = height;
+			ls->inner_step = width;
+			ls->tile = 1;
+			break;
+		case 1:
+			ls->n = height;
+			ls->stride = width;
+			ls->nouter = depth;
+			ls->outer_step = wh;
+			ls->ninner = width;
+			ls->inner_step = 1;
+			ls->tile = MM_TILE;
+			break;
+		case 2:
+			ls->n = depth;
+			ls->stride = wh;
+			ls->nouter = height;
+			ls->outer_step = width;
+			ls->ninner = width;
+			ls->inner_step = 1;
+			ls->tile = MM_TILE;
+			break;
+		default:
+			return 2;
+	}
+	return 0;
+}
+
+/* Copy count adjacent lines of n cells stride apart, from start on, to
+   lines (line c at lines+c*ld) and back. */
+static void get_lines(const void *data, int bytes, long start, long stride,
+	int n, int count, unsigned short *lines, int ld)
+{
+	int i, c;
+
+	if (bytes == 1)
+	{
+		const unsigned char *p=(const unsigned char *)data+start;
+
+		for (i=0; i<n; i++,p+=stride)
+			for (c=0; c<count; c++)
+				lines[c*ld+i] = p[c];
+	}
+	else
+	{
+		const unsigned short *p=(const unsigned short *)data+start;
+
+		for (i=0; i<n; i++,p+=stride)
+			for (c=0; c<count; c++)
+				lines[c*ld+i] = p[c];
+	}
+}
+
+static void put_lines(void *data, int bytes, long start, long stride,
+	int n, int count, const unsigned short *lines, int ld)
+{
+	int i, c;
+
+	if (bytes == 1)
+	{
+		unsigned char *p=(unsigned char *)data+start;
+
+		for (i=0; i<n; i++,p+=stride)
+			for (c=0; c<count; c++)
+				p[c] = (unsigned char)lines[c*ld+i];
+	}
+	else
+	{
+		unsigned short *p=(unsigned short *)data+start;
+
+		for (i=0; i<n; i++,p+=stride)
+			for (c=0; c<count; c++)
+				p[c] = lines[c*ld+i];
+	}
+}
+
+static void get_float_lines(const float *data, long start, long stride,
+	int n, int count, float *lines)
+{
+	int i, c;
+	const float *p=data+start;
+
+	for (i=0; i<n; i++,p+=stride)
+		for (c=0; c<count; c++)
+			lines[c*n+i] = p[c];
+}
+
+static void put_float_lines(float *data, long start, long stride, int n,
+	int count, const float *lines)
+{
+	int i, c;
+	float *p=data+start;
+
+	for (i=0; i<n; i++,p+=stride)
+		for (c=0; c<count; c++)
+			p[c] = lines[c*n+i];
+}
+
+/* Running maximum (minimum if erode) of the windows of 2r+1 cells of p,
+   which has n+2r cells (the line with r cells of padding at each end),
+   by van Herk/Gil-Werman: g and h are the maxima from the start and to
+   the end of blocks of 2r+1 cells, and each window spans two blocks. */
+static void running_extreme(const unsigned short *p, int n, int r,
+	int erode, unsigned short *g, unsigned short *h, unsigned short *out)
+{
+	int m=n+2*r, k=2*r+1, b, e, i;
+
+	for (b=0; b<m; b=e)
+	{
+		e = b+k<m? b+k: m;
+		g[b] = p[b];
+		h[e-1] = p[e-1];
+		if (erode)
+		{
+			for (i=b+1; i<e; i++)
+				g[i] = p[i]<g[i-1]? p[i]: g[i-1];
+			for (i=e-2; i>=b; i--)
+				h[i] = p[i]<h[i+1]? p[i]: h[i+1];
+		}
+		else
+		{
+			for (i=b+1; i<e; i++)
+				g[i] = p[i]>g[i-1]? p[i]: g[i-1];
+			for (i=e-2; i>=b; i--)
+				h[i] = p[i]>h[i+1]? p[i]: h[i+1];
+		}
+	}
+	if (erode)
+		for (i=0; i<n; i++)
+			out[i] = h[i]<g[i+2*r]? h[i]: g[i+2*r];
+	else
+		for (i=0; i<n; i++)
+			out[i] = h[i]>g[i+2*r]? h[i]: g[i+2*r];
+}
+
+/*****************************************************************************
+ * FUNCTION: mm_line
+ * DESCRIPTION: Dilates or erodes a volume by a line of 2*radius+1 cells.
+ * PARAMETERS:
+ *    data: the volume, replaced by the result
+ *    bytes: bytes per cell, 1 or 2
+ *    width, height, depth: volume size
+ *    axis: direction of the line, 0 (x), 1 (y) or 2 (z)
+ *    radius: cells of the line on each side of the center
+ *    erode: non-zero to erode
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ *****************************************************************************/
+int mm_line(void *data, int bytes, int width, int height, int depth,
+	int axis, int radius, int erode)
+{
+	LineSet ls;
+	int o, failed=0;
+
+	if ((bytes!=1 && bytes!=2) || line_set(&ls, width, height, depth, axis))
+		return 2;
+	if (radius <= 0)
+		return 0;
+#pragma omp parallel
+	{
+		int i, c, count, m=ls.n+2*radius;
+		unsigned short *p, *g, *h, *out;
+
+		/* the tile of lines, each with its padding, g, h, and the
+		   results */
+		p = (unsigned short *)calloc((size_t)ls.tile*(m+ls.n)+2*m,
+			sizeof(unsigned short));
+		if (p == NULL)
+		{
+#pragma omp atomic write
+			failed = 1;
+		}
+		g = p+(size_t)ls.tile*m;
+		h = g+m;
+		out = h+m;
+#pragma omp for schedule(static)
+		for (o=0; o<ls.nouter; o++)
+			for (i=0; p && i<ls.ninner; i+=count)
+			{
+				long start=o*ls.outer_step+i*ls.inner_step;
+
+				count = ls.ninner-i<ls.tile? ls.ninner-i: ls.tile;
+				get_lines(data, bytes, start, ls.stride, ls.n, count,
+					p+radius, m);
+				for (c=0; c<count; c++)
+					running_extreme(p+c*m, ls.n, radius, erode, g, h,
+						out+c*ls.n);
+				put_lines(data, bytes, start, ls.stride, ls.n, count, out,
+					ls.n);
+			}
+		free(p);
+	}
+	return failed;
+}
+
+/*****************************************************************************
+ * FUNCTION: mm_box
+ * DESCRIPTION: Dilates or erodes a volume by a box of 2*radius[a]+1 cells
+ *    along each axis a.
+ * PARAMETERS:
+ *    data: the volume, replaced by the result
+ *    bytes: bytes per cell, 1 or 2
+ *    width, height, depth: volume size
+ *    radius: cells of the box on each side of the center along x, y, z
+ *    erode: non-zero to erode
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ *****************************************************************************/
+int mm_box(void *data, int bytes, int width, int height, int depth,
+	const int radius[3], int erode)
+{
+	int axis, error;
+
+	for (axis=0; axis<3; axis++)
+	{
+		error = mm_line(data, bytes, width, height, depth, axis,
+			radius[axis], erode);
+		if (error)
+			return error;
+	}
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: mm_neighborhood
+ * DESCRIPTION: Applies a morph operation a number of times: dilates or
+ *    erodes a volume by one of its elements, iterations times.
+ * PARAMETERS:
+ *    data: the volume, replaced by the result
+ *    bytes: bytes per cell, 1 or 2
+ *    width, height, depth: volume size
+ *    op: as of morph_8:
+ *       5, 9: 2D dilation, structuring element of op pixels
+ *       7, 19, 27: 3D dilation, structuring element of op pixels
+ *       -5, -9, -7, -19, -27: the erosions
+ *       (op may also be the number of neighbors, 4, 8, 6, 18 or 26)
+ *    iterations: times to apply the operation
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ * HISTORY:
+ *    Iterations of the boxes (9, 27) are done as one box of the combined
+ *    size; the other elements are unions of lines or planar boxes.
+ *****************************************************************************/
+int mm_neighborhood(void *data, int bytes, int width, int height,
+	int depth, int op, int iterations)
+{
+	static const int cross[3][3]={{1,0,0},{0,1,0},{0,0,1}},
+		planes[3][3]={{1,1,0},{1,0,1},{0,1,1}};
+	const int (*element)[3];
+	int erode=op<0, nelements, it, e, error=0, radius[3];
+	long cells=(long)width*height*depth, i;
+	unsigned char *src, *tmp;
+
+	if (bytes!=1 && bytes!=2)
+		return 2;
+	if (iterations <= 0)
+		return 0;
+	switch (abs(op)|1)
+	{
+		case 9:
+			radius[0] = radius[1] = iterations;
+			radius[2] = 0;
+			return mm_box(data, bytes, width, height, depth, radius, erode);
+		case 27:
+			radius[0] = radius[1] = radius[2] = iterations;
+			return mm_box(data, bytes, width, height, depth, radius, erode);
+		case 5:
+			element = cross;
+			nelements = 2;
+			break;
+		case 7:
+			element = cross;
+			nelements = 3;
+			break;
+		case 19:
+			element = planes;
+			nelements = 3;
+			break;
+		default:
+			return 2;
+	}
+	src = (unsigned char *)malloc(cells*bytes);
+	tmp = (unsigned char *)malloc(cells*bytes);
+	if (src==NULL || tmp==NULL)
+	{
+		free(src);
+		free(tmp);
+		return 1;
+	}
+	for (it=0; it<iterations && !error; it++)
+	{
+		memcpy(src, data, cells*bytes);
+		error = mm_box(data, bytes, width, height, depth, element[0], erode);
+		for (e=1; e<nelements && !error; e++)
+		{
+			memcpy(tmp, src, cells*bytes);
+			error = mm_box(tmp, bytes, width, height, depth, element[e],
+				erode);
+			if (error)
+				break;
+			if (bytes == 1)
+			{
+				unsigned char *d=(unsigned char *)data;
+
+#pragma omp parallel for schedule(static)
+				for (i=0; i<cells; i++)
+					if (erode? tmp[i]<d[i]: tmp[i]>d[i])
+						d[i] = tmp[i];
+			}
+			else
+			{
+				unsigned short *d=(unsigned short *)data,
+					*t=(unsigned short *)tmp;
+
+#pragma omp parallel for schedule(static)
+				for (i=0; i<cells; i++)
+					if (erode? t[i]<d[i]: t[i]>d[i])
+						d[i] = t[i];
+			}
+		}
+	}
+	free(src);
+	free(tmp);
+	return error;
+}
+
+/* Squared Euclidean distance transform of a line (Felzenszwalb and
+   Huttenlocher): d[q] = min over p of f[p]+(s*(q-p))^2, where f holds
+   the squared distances so far (0 at the sites, MM_INF where there are
+   none yet) and s is the cell spacing.  v and z hold the lower envelope
+   of the parabolas (n and n+1 entries).  With border, the cells just
+   outside the line are sites too. */
+static void edt_line(const float *f, int n, double s, int border,
+	float *d, int *v, double *z)
+{
+	int q, p, k=-1;
+	double ss=s*s, x, dq;
+
+	for (q=0; q<n; q++)
+	{
+		if (f[q] >= MM_INF)
+			continue;
+		if (k < 0)
+		{
+			k = 0;
+			v[0] = q;
+			z[0] = -HUGE_VAL;
+			z[1] = HUGE_VAL;
+			continue;
+		}
+		for (;;)
+		{
+			p = v[k];
+			x = ((f[q]+ss*q*q)-(f[p]+ss*p*p))/(2*ss*(q-p));
+			if (x > z[k])
+				break;
+			k--;
+		}
+		k++;
+		v[k] = q;
+		z[k] = x;
+		z[k+1] = HUGE_VAL;
+	}
+	for (q=0,p=0; q<n; q++)
+	{
+		if (k < 0)
+			d[q] = MM_INF;
+		else
+		{
+			while (z[p+1] < q)
+				p++;
+			dq = s*(q-v[p]);
+			d[q] = (float)(dq*dq+f[v[p]]);
+		}
+		if (border)
+		{
+			dq = s*(q < n-1-q? q+1: n-q);
+			if (dq*dq < d[q])
+				d[q] = (float)(dq*dq);
+		}
+	}
+}
+
+/* Dilate (erode) the binary volume data by a ball through the distance to
+   the nearest set (unset) cell, kept in dist. */
+static int ball(unsigned char *data, float *dist, int width, int height,
+	int depth, const double spacing[3], double radius, int erode)
+{
+	double r2=radius*radius*(1+1e-6);
+	long cells=(long)width*height*depth, i;
+	int axis, o, failed=0;
+
+	for (axis=0; axis<3; axis++)
+	{
+		LineSet ls;
+
+		line_set(&ls, width, height, depth, axis);
+#pragma omp parallel
+		{
+			int j, q, c, count;
+			float *f, *d;
+			int *v;
+			double *z;
+
+			f = (float *)malloc(2*(size_t)ls.tile*ls.n*sizeof(float));
+			v = (int *)malloc(ls.n*sizeof(int));
+			z = (double *)malloc((ls.n+1)*sizeof(double));
+			if (f==NULL || v==NULL || z==NULL)
+			{
+#pragma omp atomic write
+				failed = 1;
+				free(f);
+				f = NULL;
+			}
+			d = f+(size_t)ls.tile*ls.n;
+#pragma omp for schedule(static)
+			for (o=0; o<ls.nouter; o++)
+				for (j=0; f && j<ls.ninner; j+=count)
+				{
+					long start=o*ls.outer_step+j*ls.inner_step;
+
+					count = ls.ninner-j<ls.tile? ls.ninner-j: ls.tile;
+					if (axis == 0)
+						for (q=0; q<ls.n; q++)
+							f[q] = (data[start+q]==0)==erode? 0: MM_INF;
+					else
+						get_float_lines(dist, start, ls.stride, ls.n, count,
+							f);
+					for (c=0; c<count; c++)
+						edt_line(f+c*ls.n, ls.n, spacing[axis], erode,
+							d+c*ls.n, v, z);
+					put_float_lines(dist, start, ls.stride, ls.n, count, d);
+				}
+			free(f);
+			free(v);
+			free(z);
+		}
+		if (failed)
+			return 1;
+	}
+#pragma omp parallel for schedule(static)
+	for (i=0; i<cells; i++)
+		data[i] = erode? dist[i]>r2: dist[i]<=r2;
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: mm_ball
+ * DESCRIPTION: Dilates, erodes, opens or closes a binary volume by a ball,
+ *    by thresholding its Euclidean distance transform.
+ * PARAMETERS:
+ *    data: the volume, one byte per cell, non-zero for the set cells;
+ *       replaced by the result (0 or 1)
+ *    width, height, depth: volume size
+ *    spacing: the distance between cells along x, y and z
+ *    radius: the radius of the ball, in the units of spacing
+ *    op: MM_DILATE, MM_ERODE, MM_OPEN or MM_CLOSE
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ *****************************************************************************/
+int mm_ball(unsigned char *data, int width, int height, int depth,
+	const double spacing[3], double radius, int op)
+{
+	float *dist;
+	int error, first_erode=op==MM_ERODE || op==MM_OPEN;
+
+	if (op<MM_DILATE || op>MM_CLOSE || spacing[0]<=0 || spacing[1]<=0 ||
+			spacing[2]<=0 || radius<0)
+		return 2;
+	dist = (float *)malloc((size_t)width*height*depth*sizeof(float));
+	if (dist == NULL)
+		return 1;
+	error = ball(data, dist, width, height, depth, spacing, radius,
+		first_erode);
+	if ((op==MM_OPEN || op==MM_CLOSE) && !error)
+		error = ball(data, dist, width, height, depth, spacing, radius,
+			!first_erode);
+	free(dist);
+	return error;
+}
@@ -0,0 +1,56 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Morphological operations on whole volumes.
+ *
+ * Grey-scale dilation and erosion by boxes and lines are done with the
+ * van Herk/Gil-Werman running maximum (minimum), one pass along each axis,
+ * at a cost of about three comparisons per voxel and pass whatever the
+ * size of the element.  The small elements of morph (crosses and the
+ * 19-neighborhood) are unions of such boxes and lines.  Binary operations
+ * with a ball are done by thresholding the exact Euclidean distance
+ * transform (separable, in the scene units), so their cost does not
+ * depend on the radius either.  Each pass is split into slabs of lines
+ * done by separate threads.
+ *
+ * Volumes are width*height*depth cells of 1 or 2 bytes, x fastest.
+ * Cells outside the volume are taken to be 0 (background).
+ */
+
+#ifndef __morphology_h
+#define __morphology_h
+
+#define MM_DILATE 0
+#define MM_ERODE 1
+#define MM_OPEN 2
+#define MM_CLOSE 3
+
+int mm_line(void *data, int bytes, int width, int height, int depth,
+	int axis, int radius, int erode);
+int mm_box(void *data, int bytes, int width, int height, int depth,
+	const int radius[3], int erode);
+int mm_neighborhood(void *data, int bytes, int width, int height,
+	int depth, int op, int iterations);
+int mm_ball(unsigned char *data, int width, int height, int depth,
+	const double spacing[3], double radius, int op);
+
+#endif
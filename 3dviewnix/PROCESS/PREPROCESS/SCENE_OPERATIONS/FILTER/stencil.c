@@ -0,0 +1,363 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "stencil.h"
+
+typedef struct {
+	const StShells *shells;
+	const double *homogeneity;
+	double fraction;
+} ScaleArgs;
+
+/*****************************************************************************
+ * FUNCTION: st_shells
+ * DESCRIPTION: Makes the table of the shells of the balls of radius up to
+ *    nshells-1/2 in a volume.  The cells of each shell are in raster order
+ *    (x fastest), as the scale-based filters have always visited them.
+ * PARAMETERS:
+ *    shells: receives the table; free with st_free_shells
+ *    nshells: number of shells
+ *    coef: size of a voxel along x, y, z in units of the smallest one
+ *    planar: non-zero for balls within a slice
+ *    width, height: volume size
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ *****************************************************************************/
+int st_shells(StShells *shells, int nshells, const double coef[3],
+	int planar, int width, int height)
+{
+	int side=2*nshells+3, c=nshells+1, i, j, l, k, n, a;
+	char *mark;
+	double dist;
+
+	memset(shells, 0, sizeof(*shells));
+	if (nshells<1 || coef[0]<1 || coef[1]<1 || coef[2]<1)
+		return 2;
+	shells->nshells = nshells;
+	mark = (char *)calloc((size_t)side*side*side, 1);
+	shells->count = (int *)malloc(nshells*sizeof(int));
+	shells->first = (int *)malloc(nshells*sizeof(int));
+	shells->reach = (int (*)[3])calloc(nshells, sizeof(*shells->reach));
+	shells->cell = (int (*)[3])malloc((size_t)side*side*side*
+		sizeof(*shells->cell));
+	shells->offset = (long *)malloc((size_t)side*side*side*sizeof(long));
+	if (mark==NULL || shells->count==NULL || shells->first==NULL ||
+			shells->reach==NULL || shells->cell==NULL ||
+			shells->offset==NULL)
+	{
+		free(mark);
+		st_free_shells(shells);
+		return 1;
+	}
+	n = 0;
+	for (k=0; k<nshells; k++)
+	{
+		shells->first[k] = n;
+		if (k > 0)
+			memcpy(shells->reach[k], shells->reach[k-1],
+				sizeof(shells->reach[k]));
+		for (i=planar? 0: -k-2; i<=(planar? 0: k+2); i++)
+			for (j= -k-2; j<=k+2; j++)
+				for (l= -k-2; l<=k+2; l++)
+				{
+					if (mark[((c+i)*side+c+j)*side+c+l])
+						continue;
+					dist = sqrt(pow(i*coef[2], 2.0)+pow(j*coef[1], 2.0)+
+						pow(l*coef[0], 2.0));
+					if (dist > k+0.5)
+						continue;
+					mark[((c+i)*side+c+j)*side+c+l] = 1;
+					shells->cell[n][0] = l;
+					shells->cell[n][1] = j;
+					shells->cell[n][2] = i;
+					shells->offset[n] = ((long)i*height+j)*width+l;
+					for (a=0; a<3; a++)
+						if (abs(shells->cell[n][a]) > shells->reach[k][a])
+							shells->reach[k][a] = abs(shells->cell[n][a]);
+					n++;
+				}
+		shells->count[k] = n-shells->first[k];
+	}
+	free(mark);
+	return 0;
+}
+
+void st_free_shells(StShells *shells)
+{
+	free(shells->count);
+	free(shells->first);
+	free(shells->cell);
+	free(shells->offset);
+	free(shells->reach);
+	memset(shells, 0, sizeof(*shells));
+}
+
+/*****************************************************************************
+ * FUNCTION: st_pass
+ * DESCRIPTION: Applies a kernel to all the tiles of a volume, in parallel.
+ * PARAMETERS:
+ *    width, height, depth: volume size
+ *    kernel: called with arg, in, out and each tile; must write only the
+ *       cells of its tile in out
+ *    arg: passed to kernel
+ *    in: the input volume, or NULL
+ *    out: the output volume, or NULL
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: in and out must not overlap.
+ * RETURN VALUE: 0 on success, 2 for a bad argument
+ *****************************************************************************/
+int st_pass(int width, int height, int depth, StKernel kernel, void *arg,
+	const unsigned short *in, unsigned short *out)
+{
+	int ny=(height+ST_TILE_ROWS-1)/ST_TILE_ROWS,
+		nz=(depth+ST_TILE_SLICES-1)/ST_TILE_SLICES, t;
+
+	if (width<=0 || height<=0 || depth<=0)
+		return 2;
+#pragma omp parallel for schedule(dynamic)
+	for (t=0; t<ny*nz; t++)
+	{
+		StTile tile;
+
+		tile.width = width;
+		tile.height = height;
+		tile.depth = depth;
+		tile.y0 = t%ny*ST_TILE_ROWS;
+		tile.y1 = tile.y0+ST_TILE_ROWS<height? tile.y0+ST_TILE_ROWS: height;
+		tile.z0 = t/ny*ST_TILE_SLICES;
+		tile.z1 = tile.z0+ST_TILE_SLICES<depth? tile.z0+ST_TILE_SLICES: depth;
+		kernel(arg, in, out, &tile);
+	}
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: st_iterate
+ * DESCRIPTION: Applies a kernel to a volume repeatedly, the output of each
+ *    pass being the input of the next.
+ * PARAMETERS:
+ *    width, height, depth: volume size
+ *    kernel, arg: as for st_pass
+ *    data: the volume; receives the buffer of the result
+ *    spare: a buffer of the same size; receives the other buffer
+ *    iterations: number of passes
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 2 for a bad argument
+ *****************************************************************************/
+int st_iterate(int width, int height, int depth, StKernel kernel,
+	void *arg, unsigned short **data, unsigned short **spare,
+	int iterations)
+{
+	int it, error;
+	unsigned short *t;
+
+	for (it=0; it<iterations; it++)
+	{
+		error = st_pass(width, height, depth, kernel, arg, *data, *spare);
+		if (error)
+			return error;
+		t = *data;
+		*data = *spare;
+		*spare = t;
+	}
+	return 0;
+}
+
+static void rank_kernel(void *arg, const unsigned short *in,
+	unsigned short *out, const StTile *t)
+{
+	int level=*(int *)arg, x, y, z, dx, dy, dz, xx, yy, zz, n, j;
+	long wh=(long)t->width*t->height, c;
+	unsigned short v[27], u;
+
+	for (z=t->z0; z<t->z1; z++)
+		for (y=t->y0; y<t->y1; y++)
+			for (x=0; x<t->width; x++)
+			{
+				/* the 27 neighbors, replicated at the borders, in
+				   decreasing order */
+				n = 0;
+				for (dz= -1; dz<=1; dz++)
+				{
+					zz = z+dz<0? 0: z+dz>=t->depth? t->depth-1: z+dz;
+					for (dy= -1; dy<=1; dy++)
+					{
+						yy = y+dy<0? 0: y+dy>=t->height? t->height-1: y+dy;
+						for (dx= -1; dx<=1; dx++)
+						{
+							xx = x+dx<0? 0: x+dx>=t->width? t->width-1: x+dx;
+							u = in[zz*wh+(long)yy*t->width+xx];
+							for (j=n; j>0 && v[j-1]<=u; j--)
+								v[j] = v[j-1];
+							v[j] = u;
+							n++;
+						}
+					}
+				}
+				c = z*wh+(long)y*t->width+x;
+				for (j=26; v[j]!=in[c]; j--)
+					;
+				if (j < level)
+					out[c] = v[level];
+				else if (j > 26-level)
+					out[c] = v[26-level];
+				else
+					out[c] = in[c];
+			}
+}
+
+/*****************************************************************************
+ * FUNCTION: st_rank_clamp
+ * DESCRIPTION: Clamps each cell of a volume between the values of rank
+ *    level and 26-level of its 27-neighborhood (the median for level 13).
+ * PARAMETERS:
+ *    data: the volume, replaced by the result
+ *    width, height, depth: volume size
+ *    level: 0 to 13
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if out of memory, 2 for a bad argument
+ *****************************************************************************/
+int st_rank_clamp(unsigned short *data, int width, int height, int depth,
+	int level)
+{
+	unsigned short *copy;
+	int error;
+
+	if (level<0 || level>13)
+		return 2;
+	copy = (unsigned short *)malloc((size_t)width*height*depth*
+		sizeof(unsigned short));
+	if (copy == NULL)
+		return 1;
+	memcpy(copy, data, (size_t)width*height*depth*sizeof(unsigned short));
+	error = st_pass(width, height, depth, rank_kernel, &level, copy, data);
+	free(copy);
+	return error;
+}
+
+static void scale_kernel(void *arg, const unsigned short *in,
+	unsigned short *out, const StTile *t)
+{
+	const ScaleArgs *a=(const ScaleArgs *)arg;
+	const StShells *s=a->shells;
+	const double *h=a->homogeneity;
+	int x, y, z, xx, yy, zz, k, i, end, d;
+	long c;
+	double count_obj, count_nonobj;
+
+	for (z=t->z0; z<t->z1; z++)
+		for (y=t->y0; y<t->y1; y++)
+			for (x=0; x<t->width; x++)
+			{
+				c = ((long)z*t->height+y)*t->width+x;
+				count_obj = count_nonobj = 0;
+				out[c] = s->nshells-1;
+				for (k=1; k<s->nshells; k++)
+				{
+					end = s->first[k]+s->count[k];
+					if (ST_INSIDE(t, s, k, x, y, z))
+						for (i=s->first[k]; i<end; i++)
+						{
+							d = in[c+s->offset[i]]-in[c];
+							if (d < 0)
+								d = -d;
+							count_obj = count_obj+h[d];
+							count_nonobj = count_nonobj+1.0-h[d];
+						}
+					else
+						for (i=s->first[k]; i<end; i++)
+						{
+							xx = x+s->cell[i][0];
+							yy = y+s->cell[i][1];
+							zz = z+s->cell[i][2];
+							if (xx<0 || xx>=t->width || yy<0 ||
+									yy>=t->height || zz<0 || zz>=t->depth)
+								continue;
+							d = in[c+s->offset[i]]-in[c];
+							if (d < 0)
+								d = -d;
+							count_obj = count_obj+h[d];
+							count_nonobj = count_nonobj+1.0-h[d];
+						}
+					if (100.0*count_nonobj >=
+							a->fraction*(count_nonobj+count_obj))
+					{
+						out[c] = k;
+						break;
+					}
+				}
+			}
+}
+
+/*****************************************************************************
+ * FUNCTION: st_object_scale
+ * DESCRIPTION: Computes the scale of each cell of a volume: the first
+ *    shell around it, from shell 1 on, by which the balls reach the given
+ *    percentage of inhomogeneity.
+ * PARAMETERS:
+ *    image: the volume
+ *    scale: receives the scale of each cell, nshells-1 if the balls never
+ *       reach that percentage
+ *    width, height, depth: volume size
+ *    shells: the balls, made for this volume size
+ *    homogeneity: homogeneity of each difference of value, from 0 to the
+ *       largest in the volume
+ *    fraction: the percentage
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 2 for a bad argument
+ *****************************************************************************/
+int st_object_scale(const unsigned short *image, unsigned short *scale,
+	int width, int height, int depth, const StShells *shells,
+	const double *homogeneity, double fraction)
+{
+	ScaleArgs a;
+
+	a.shells = shells;
+	a.homogeneity = homogeneity;
+	a.fraction = fraction;
+	return st_pass(width, height, depth, scale_kernel, &a, image, scale);
+}
+
+/* Convert in place between size cells of 1 byte at data and of 2. */
+void st_widen(unsigned short *data, long size)
+{
+	long i;
+
+	for (i=size-1; i>=0; i--)
+		data[i] = ((unsigned char *)data)[i];
+}
+
+void st_narrow(unsigned short *data, long size)
+{
+	long i;
+
+	for (i=0; i<size; i++)
+		((unsigned char *)data)[i] = (unsigned char)data[i];
+}
@@ -0,0 +1,92 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Stencil passes over whole volumes, for the scale-based filters.
+ *
+ * A pass applies a kernel to every cell of a volume, reading one volume
+ * and writing another.  The volume is cut into tiles of ST_TILE_ROWS rows
+ * of ST_TILE_SLICES slices, which the threads take in turn.  The input is
+ * not written during a pass, so the halo of a tile (the cells of the
+ * neighboring tiles that its stencil reaches) is read where it is, and the
+ * end of the pass is the only exchange needed between the threads.
+ * Iterated filters alternate two buffers, the output of one iteration
+ * being the input of the next.
+ *
+ * The balls of the scale-based filters are tables of shells: shell k holds
+ * the cells whose distance from the center, in units of the smallest
+ * voxel dimension, is at most k+1/2 and that are not in shells 0 to k-1.
+ * Each cell is kept as a displacement and as an offset in the volume, and
+ * each shell with its reach, so that a kernel can tell whether the ball is
+ * inside the volume and skip the bounds tests where it is.
+ *
+ * Volumes are width*height*depth cells of unsigned short, x fastest;
+ * scenes of 1 byte per cell are widened on input and narrowed on output.
+ */
+
+#ifndef __stencil_h
+#define __stencil_h
+
+#define ST_TILE_ROWS 16
+#define ST_TILE_SLICES 4
+
+/* The rows y0 to y1-1 of slices z0 to z1-1 of a volume */
+typedef struct {
+	int width, height, depth;
+	int y0, y1, z0, z1;
+} StTile;
+
+typedef void (*StKernel)(void *arg, const unsigned short *in,
+	unsigned short *out, const StTile *tile);
+
+typedef struct {
+	int nshells;
+	int *count;          /* cells of each shell */
+	int *first;          /* index of the first cell of each shell */
+	int (*cell)[3];      /* displacement of each cell along x, y, z */
+	long *offset;        /* offset of each cell in the volume */
+	int (*reach)[3];     /* largest displacement of shells 0 to k */
+} StShells;
+
+/* Whether the ball of shells 0 to k around cell x, y, z of the volume of
+   tile t is inside the volume */
+#define ST_INSIDE(t, s, k, x, y, z) \
+	((x)>=(s)->reach[k][0] && (x)+(s)->reach[k][0]<(t)->width && \
+	 (y)>=(s)->reach[k][1] && (y)+(s)->reach[k][1]<(t)->height && \
+	 (z)>=(s)->reach[k][2] && (z)+(s)->reach[k][2]<(t)->depth)
+
+int st_shells(StShells *shells, int nshells, const double coef[3],
+	int planar, int width, int height);
+void st_free_shells(StShells *shells);
+int st_pass(int width, int height, int depth, StKernel kernel, void *arg,
+	const unsigned short *in, unsigned short *out);
+int st_iterate(int width, int height, int depth, StKernel kernel,
+	void *arg, unsigned short **data, unsigned short **spare,
+	int iterations);
+int st_rank_clamp(unsigned short *data, int width, int height, int depth,
+	int level);
+int st_object_scale(const unsigned short *image, unsigned short *scale,
+	int width, int height, int depth, const StShells *shells,
+	const double *homogeneity, double fraction);
+void st_widen(unsigned short *data, long size);
+void st_narrow(unsigned short *data, long size);
+
+#endif
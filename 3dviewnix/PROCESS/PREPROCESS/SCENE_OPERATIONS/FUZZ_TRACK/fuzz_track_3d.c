@@ -66,6 +66,12 @@ void load_volume(int), load_fom(), load_dfom(), load_feature_map(),
     GC_max(int current_volume), MOFS(int current_volume);
 int affinity(int a, int b, float adjacency, int ax, int ay, int az,
 	int bx, int by, int bz, int back);
+float pair_affinity(int a, int b, int ax, int ay, int az, int bx, int by,
+	int bz, int back);
+void make_affinity_tables(void);
+long fill_affinity_planes(OutCellType *x_affinity, OutCellType *y_affinity,
+	OutCellType *z_affinity, int slices_out, float x_adjacency,
+	float y_adjacency, float z_adjacency);
 int fom_value(int col, int row, int slc);
 int dfom_value(int col, int row, int slc);
 int input_slice_index(int volume, int slice);
@@ -124,6 +130,8 @@ static int *hist_bin_table[3], bins_per_feature;
 static unsigned short ***threeD_hist;
 static int mofs_flag;
 static FILE *outstream;
+static float *affinity_table[2]; /* pair_affinity by values; NULL if none */
+static int affinity_levels; /* values in affinity_table */
 
 
 /*****************************************************************************
@@ -587,6 +595,7 @@ int main(int argc, char *argv[])
 	load_dfom();
 	if (feature_status[7])
 		load_feature_map();
+	make_affinity_tables();
 	for (current_volume=0; current_volume<volumes_out; current_volume++)
 	{
 		load_volume(current_volume);
@@ -764,12 +773,49 @@ switch (feature_n) \
 /*****************************************************************************
  * FUNCTION: affinity
  * DESCRIPTION: Returns the affinity scaled to adjacency for adjacent
- *    voxel values.
+ *    voxel values, from affinity_table if the values are in it.
  * PARAMETERS:
  *    a, b: The values of the adjacent voxels
  *    adjacency: The fuzzy adjacency between the two voxels scaled to
  *       MAX_CONNECTIVITY.
- * SIDE EFFECTS: fb, ft incremented.
+ *    ax, ay, az, bx, by, bz: The coordinates of the voxels
+ *    back: Nonzero for the background affinity
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met;
+ *    affinity_table, affinity_levels, threshold must be properly set.
+ * RETURN VALUE: the affinity scaled to MAX_CONNECTIVITY
+ * EXIT CONDITIONS: On error, writes a message to stderr and exits with code 1.
+ * HISTORY:
+ *    Created: 4/2/96 by Dewey Odhner
+ *    Modified: 1/29/98 fuzzy adjacency passed by Dewey Odhner
+ *    Modified: 10/19/26 affinity_table used
+ *
+ *****************************************************************************/
+int affinity(int a, int b, float adjacency, int ax, int ay, int az,
+	int bx, int by, int bz, int back)
+{
+	float temp_affinity;
+
+	if (affinity_table[back] && a<affinity_levels && b<affinity_levels)
+		temp_affinity = affinity_table[back][a*affinity_levels+b];
+	else
+		temp_affinity = pair_affinity(a, b, ax, ay, az, bx, by, bz, back);
+	temp_affinity *= adjacency;
+	if (temp_affinity >= threshold)
+		return (int)temp_affinity;
+	else
+		return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: pair_affinity
+ * DESCRIPTION: Returns the affinity for adjacent voxel values on a scale
+ *    of 1, before adjacency and threshold are applied.
+ * PARAMETERS:
+ *    a, b: The values of the adjacent voxels
+ *    ax, ay, az, bx, by, bz: The coordinates of the voxels
+ *    back: Nonzero for the background affinity
+ * SIDE EFFECTS: None
  * ENTRY CONDITIONS: The variables feature_status, function_level,
  *    function_width, weight, function_selected, threshold, file_info, vh_in,
  *    in_data, affinity_type, histogram_bins, histogram_counts,
@@ -777,9 +823,10 @@ switch (feature_n) \
  *    covariance_flag, reverse_covariance_flag, inv_covariance,
  *    inv_reverse_covariance, training_mean, reverse_training_mean,
  *    weight_unit, vh_fom, fom_data, slice_spacing, rel_scale, translation,
- *    i_weight_unit, fb, ft, bg_filename, dfom_data, dfom_filename
+ *    i_weight_unit, bg_filename, dfom_data, dfom_filename
  *    must be properly set.
- * RETURN VALUE: the affinity scaled to MAX_CONNECTIVITY
+ * RETURN VALUE: the affinity on a scale of 1 (in which the fuzzy adjacency
+ *    scaled to MAX_CONNECTIVITY is the largest)
  * EXIT CONDITIONS: On error, writes a message to stderr and exits with code 1.
  * HISTORY:
  *    Created: 4/2/96 by Dewey Odhner
@@ -788,10 +835,11 @@ switch (feature_n) \
  *    Modified: 7/26/96 covariance affinity type allowed by Dewey Odhner
  *    Modified: 1/29/98 fuzzy adjacency passed by Dewey Odhner
  *    Modified: 9/9/10 fb, ft incremented by Dewey Odhner
+ *    Modified: 10/19/26 adjacency and threshold applied by affinity
  *
  *****************************************************************************/
-int affinity(int a, int b, float adjacency, int ax, int ay, int az,
-	int bx, int by, int bz, int back)
+float pair_affinity(int a, int b, int ax, int ay, int az, int bx, int by,
+	int bz, int back)
 {
 	int feature_n, high, low, t_count, features_on, on_feature_n, on_feature_m;
 	float temp_affinity, feature_val, xrel, on_feature_val[NUM_FEATURES],
@@ -1139,14 +1187,109 @@ int affinity(int a, int b, float adjacency, int ax, int ay, int az,
 	  default:
 		assert(FALSE);
 	}
-	temp_affinity *= adjacency;
-	temp_affinity2 *= adjacency;
+	/* Multiplying both by a positive adjacency afterwards gives the same
+	   minimum as multiplying each first. */
 	if (temp_affinity2 < temp_affinity)
 		temp_affinity = temp_affinity2;
-	if (temp_affinity >= threshold)
-		return (int)temp_affinity;
-	else
-		return 0;
+	return temp_affinity;
+}
+
+/*****************************************************************************
+ * FUNCTION: table_affinity
+ * DESCRIPTION: Returns pair_affinity for values of voxels whose position
+ *    does not matter; for VAffinityTable.
+ * PARAMETERS:
+ *    a, b: The values of the adjacent voxels
+ *    back: Points to the back parameter of pair_affinity.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met.
+ * RETURN VALUE: the affinity on a scale of 1
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static float table_affinity(int a, int b, void *back)
+{
+	return pair_affinity(a, b, 0, 0, 0, 0, 0, 0, *(int *)back);
+}
+
+/*****************************************************************************
+ * FUNCTION: make_affinity_tables
+ * DESCRIPTION: Tabulates pair_affinity over all pairs of voxel values, if
+ *    the affinity does not depend on voxel position and the values are few
+ *    enough, so that tracking need not evaluate the feature transforms for
+ *    each pair of adjacent voxels.
+ * PARAMETERS: None
+ * SIDE EFFECTS: affinity_table, affinity_levels are set; affinity_table
+ *    is left NULL for direct evaluation.
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met;
+ *    num_bg_points, bg_filename, threeD_hist must be properly set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void make_affinity_tables(void)
+{
+	int back;
+
+	/* fuzzy object model features depend on position */
+	if (affinity_type==3 && ((feature_status[6] && weight[6]) ||
+			(feature_status[2] && dfom_filename) ||
+			(feature_status[7] && threeD_hist)))
+		return;
+	affinity_levels = largest_density_value+1;
+	back = 0;
+	affinity_table[0] = VAffinityTable(affinity_levels, table_affinity, &back);
+	affinity_table[1] = affinity_table[0];
+	/* background affinity differs only in tissues */
+	if (affinity_table[0] && (num_bg_points || bg_filename) &&
+			affinity_type==3 && feature_status[MULTITISSUE])
+	{
+		back = 1;
+		affinity_table[1] =
+			VAffinityTable(affinity_levels, table_affinity, &back);
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: fill_affinity_planes
+ * DESCRIPTION: Computes the affinity of every voxel of the current volume
+ *    with its next neighbor in x, y and z from affinity_table.
+ * PARAMETERS:
+ *    x_affinity, y_affinity, z_affinity: The affinities will be stored
+ *       here, as by affinity with back 0.
+ *    slices_out: The number of slices in the volume
+ *    x_adjacency, y_adjacency, z_adjacency: The fuzzy adjacency in each
+ *       direction scaled to MAX_CONNECTIVITY.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The variables affinity_table, affinity_levels,
+ *    threshold, vh_in, in_data must be properly set.
+ * RETURN VALUE: The number of affinities left AFF_UNDEF for voxel values not
+ *    in the table, or -1 if there is no table and nothing is stored.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+long fill_affinity_planes(OutCellType *x_affinity, OutCellType *y_affinity,
+	OutCellType *z_affinity, int slices_out, float x_adjacency,
+	float y_adjacency, float z_adjacency)
+{
+	if (affinity_table[0] == NULL)
+		return -1;
+	return
+		VAffinityPlane(affinity_table[0], affinity_levels, in_data,
+			vh_in.scn.num_of_bits, vh_in.scn.xysize[0], vh_in.scn.xysize[1],
+			slices_out, 0, x_adjacency, threshold, AFF_UNDEF, x_affinity)+
+		VAffinityPlane(affinity_table[0], affinity_levels, in_data,
+			vh_in.scn.num_of_bits, vh_in.scn.xysize[0], vh_in.scn.xysize[1],
+			slices_out, 1, y_adjacency, threshold, AFF_UNDEF, y_affinity)+
+		VAffinityPlane(affinity_table[0], affinity_levels, in_data,
+			vh_in.scn.num_of_bits, vh_in.scn.xysize[0], vh_in.scn.xysize[1],
+			slices_out, 2, z_adjacency, threshold, AFF_UNDEF, z_affinity);
 }
 
 /*****************************************************************************
@@ -0,0 +1,486 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*****************************************************************************
+ * fuzzy_forest_bench times the connectivity update behind a click in the
+ * IRFC and fuzzy connectedness canvases on a slice of a scene: seeds are
+ * added one at a time, then some are taken away, then the affinities are
+ * changed in small squares and over the whole slice.  After each step the
+ * connectivity is computed both in full, as the canvases did before, and by
+ * updating a VFuzzyForest, and the two are compared.
+ *****************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <cv3dv.h>
+#include "gqueue.h"
+
+#define MAX_AFFINITY 65534
+#define MAX_CONNECTIVITY 65534
+#define EDIT_SIZE 16
+#define EDITS 8
+
+typedef struct {
+	double full, update, max_full, max_update, updated;
+	long mismatches;
+	int steps;
+} Timing;
+
+static int width, height, slice_size, labels=2;
+static double level[2], spread;
+static unsigned short *slice_data, *affinity[2][4], *full_conn, *forest_conn;
+static int *seed_cell, nseeds;
+static unsigned char *seed_label;
+static VFuzzyForest *forest;
+
+void compute_affinity(double scale, int x0, int y0, int x1, int y1),
+	full_connectivity(unsigned short *out),
+	forest_connectivity(unsigned short *out),
+	step(Timing *t, int new_affinity), report(const char *what, Timing *t);
+unsigned bench_random(void);
+
+
+int main(argc,argv)
+int argc;
+char *argv[];
+{
+	FILE *in;
+	ViewnixHeader vh;
+	char group[6], elem[6];
+	int error, slice, clicks, j, k, items, bytes, x=0, y=0;
+	double sum=0, sum_sqr=0;
+	unsigned char *in8;
+	Timing add, take, edit, all;
+
+	if (argc>1 && strcmp(argv[argc-1], "-absolute")==0)
+	{
+		labels = 1;
+		argc--;
+	}
+	if (argc != 4 || sscanf(argv[2], "%d", &slice)!=1 ||
+			sscanf(argv[3], "%d", &clicks)!=1 || clicks<2)
+	{
+		fprintf(stderr,
+		  "Usage: fuzzy_forest_bench <IM0_file> <slice> <clicks> [-absolute]\n");
+		exit(-1);
+	}
+	in = fopen(argv[1], "rb");
+	if (in == NULL)
+	{
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		exit(-1);
+	}
+	error = VReadHeader(in, &vh, group, elem);
+	if (error && error<=104)
+	{
+		fprintf(stderr, "Fatal error in reading header\n");
+		exit(-1);
+	}
+	if (vh.gen.data_type!=IMAGE0 || (vh.scn.num_of_bits!=8 &&
+			vh.scn.num_of_bits!=16) || vh.scn.signed_bits_valid&&
+			vh.scn.signed_bits[0])
+	{
+		fprintf(stderr, "Input must be an unsigned 8- or 16-bit IMAGE0\n");
+		exit(-1);
+	}
+	if (slice<0 || slice>=vh.scn.num_of_subscenes[0])
+	{
+		fprintf(stderr, "Slice out of range\n");
+		exit(-1);
+	}
+	width = vh.scn.xysize[0];
+	height = vh.scn.xysize[1];
+	slice_size = width*height;
+	bytes = vh.scn.num_of_bits/8;
+	slice_data = (unsigned short *)malloc(slice_size*sizeof(short));
+	in8 = (unsigned char *)malloc(slice_size*bytes);
+	full_conn = (unsigned short *)malloc(slice_size*sizeof(short));
+	forest_conn = (unsigned short *)malloc(slice_size*sizeof(short));
+	seed_cell = (int *)malloc(clicks*sizeof(int));
+	seed_label = (unsigned char *)malloc(clicks);
+	for (j=0; j<labels; j++)
+		for (k=0; k<4; k++)
+			affinity[j][k] = (unsigned short *)malloc(slice_size*sizeof(short));
+	if (slice_data==NULL || in8==NULL || full_conn==NULL ||
+			forest_conn==NULL || seed_cell==NULL || seed_label==NULL ||
+			affinity[labels-1][3]==NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	if (VLSeekData(in, (double)slice*slice_size*bytes) ||
+			VReadData((char *)in8, bytes, slice_size, in, &items) ||
+			items!=slice_size)
+	{
+		fprintf(stderr, "Could not read data\n");
+		exit(-1);
+	}
+	fclose(in);
+	for (j=0; j<slice_size; j++)
+	{
+		slice_data[j] = bytes==1? in8[j]: ((unsigned short *)in8)[j];
+		sum += slice_data[j];
+		sum_sqr += (double)slice_data[j]*slice_data[j];
+	}
+
+	/* object and background about a standard deviation above and below
+	   the mean */
+	spread = sqrt(sum_sqr/slice_size-sum*sum/((double)slice_size*slice_size));
+	if (spread < 1)
+		spread = 1;
+	level[0] = sum/slice_size+spread;
+	level[1] = sum/slice_size-spread;
+	compute_affinity(1, 0, 0, width, height);
+
+	forest = VCreateFuzzyForest(width, height, labels, MAX_CONNECTIVITY);
+	if (forest == NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	memset(&add, 0, sizeof(add));
+	memset(&take, 0, sizeof(take));
+	memset(&edit, 0, sizeof(edit));
+	memset(&all, 0, sizeof(all));
+
+	/* the first seed of each label together, then one per click */
+	for (nseeds=0; nseeds<clicks; )
+	{
+		seed_cell[nseeds] = bench_random()%slice_size;
+		seed_label[nseeds] = labels==2 && nseeds%2;
+		nseeds++;
+		if (nseeds < labels)
+			continue;
+		step(nseeds==labels? &all: &add, 0);
+	}
+	for (j=0; j<clicks/4 && nseeds>labels; j++)
+	{
+		k = labels+bench_random()%(nseeds-labels);
+		nseeds--;
+		seed_cell[k] = seed_cell[nseeds];
+		seed_label[k] = seed_label[nseeds];
+		step(&take, 0);
+	}
+	/* weaken a square, then restore it */
+	for (j=0; j<EDITS; j++)
+	{
+		if (j%2 == 0)
+		{
+			x = bench_random()%width;
+			y = bench_random()%height;
+		}
+		compute_affinity(j%2? 1: .5, x-EDIT_SIZE/2, y-EDIT_SIZE/2,
+			x+EDIT_SIZE/2, y+EDIT_SIZE/2);
+		step(&edit, 1);
+	}
+	spread *= 1.1;
+	compute_affinity(1, 0, 0, width, height);
+	step(&all, 1);
+
+	printf("%d x %d, %s connectedness\n", width, height,
+		labels==2? "relative": "absolute");
+	printf("%-18s %5s %10s %10s %10s %10s %9s %10s\n", "", "steps",
+		"full ms", "max", "update ms", "max", "cells", "mismatches");
+	report("seed added", &add);
+	report("seed taken away", &take);
+	report("affinity edited", &edit);
+	report("new slice/params", &all);
+	exit(add.mismatches||take.mismatches||edit.mismatches||all.mismatches);
+}
+
+/*****************************************************************************
+ * FUNCTION: bench_random
+ * DESCRIPTION: Returns a pseudo-random number, the same sequence everywhere.
+ * PARAMETERS: None
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: A number from 0 to 2^31-1
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+unsigned bench_random()
+{
+	static unsigned state=12345;
+
+	state = state*1103515245+12345;
+	return (state>>1)&0x7fffffff;
+}
+
+/*****************************************************************************
+ * FUNCTION: compute_affinity
+ * DESCRIPTION: Computes the affinities of a rectangle of the slice from a
+ *    homogeneity term and an object or background term, as the IRFC canvas
+ *    does, times scale.
+ * PARAMETERS:
+ *    scale: The factor, at most 1
+ *    x0, y0, x1, y1: The rectangle, x0 to x1-1 by y0 to y1-1
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The variables slice_data, width, height, labels, level,
+ *    spread and affinity must be set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void compute_affinity(double scale, int x0, int y0, int x1, int y1)
+{
+	int x, y, label, c, d, direction;
+
+	if (x0 < 0)
+		x0 = 0;
+	if (y0 < 0)
+		y0 = 0;
+	if (x1 > width)
+		x1 = width;
+	if (y1 > height)
+		y1 = height;
+	for (label=0; label<labels; label++)
+		for (y=y0; y<y1; y++)
+			for (x=x0; x<x1; x++)
+				for (direction=0; direction<4; direction++)
+				{
+					double g, m;
+
+					c = y*width+x;
+					switch (direction)
+					{
+						case 0: d = x<width-1? c+1: c; break;
+						case 1: d = y<height-1? c+width: c; break;
+						case 2: d = x>0? c-1: c; break;
+						default: d = y>0? c-width: c; break;
+					}
+					g = (slice_data[c]-(double)slice_data[d])/spread;
+					m = ((slice_data[c]+(double)slice_data[d])*.5-level[label])/
+						spread;
+					affinity[label][direction][c] = (unsigned short)
+						(MAX_AFFINITY*scale*exp(-.5*g*g)*(.5+.5*exp(-.5*m*m)));
+				}
+}
+
+/*****************************************************************************
+ * FUNCTION: full_connectivity
+ * DESCRIPTION: Computes the connectivity of the slice from all the seeds as
+ *    IRFCCanvas::compute_connectivity_image does, 0 where the background
+ *    wins.
+ * PARAMETERS:
+ *    out: The connectivity, slice_size cells
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The variables affinity, seed_cell, seed_label and
+ *    nseeds must be set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26 from IRFCCanvas::compute_connectivity_image
+ *
+ *****************************************************************************/
+void full_connectivity(unsigned short *out)
+{
+	const int nil=-1;
+	GQueue *Q;
+	int *hl, *R, *Pr, c, d, j;
+
+	hl = (int *)malloc(slice_size*sizeof(int));
+	R = (int *)malloc(slice_size*sizeof(int));
+	Pr = (int *)malloc(slice_size*sizeof(int));
+	if (hl==NULL || R==NULL || Pr==NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	Q = CreateGQueue(MAX_CONNECTIVITY*2+4, slice_size, hl);
+	SetRemovalPolicy(Q, MAXVALUE);
+	for (c=0; c<slice_size; c++)
+	{
+		hl[c] = 0;
+		R[c] = c;
+		Pr[c] = c;
+	}
+	for (j=0; j<nseeds; j++)
+		if (seed_label[j] == 0)
+		{
+			hl[seed_cell[j]] = 2+2*MAX_CONNECTIVITY;
+			Pr[seed_cell[j]] = nil;
+		}
+	for (j=0; j<nseeds; j++)
+		if (seed_label[j])
+		{
+			hl[seed_cell[j]] = 3+2*MAX_CONNECTIVITY;
+			Pr[seed_cell[j]] = nil;
+		}
+	for (c=0; c<slice_size; c++)
+		InsertGQueue(&Q, c);
+	while (!EmptyGQueue(Q))
+	{
+		int cx, cy, neighbor[4], kappa[4], ncount=0, ch, dh, minh, l;
+
+		c = RemoveGQueue(Q);
+		cy = c/width;
+		cx = c-width*cy;
+		l = labels==2 && (hl[c]&1);
+		if (cx>0 && hl[c-1]>=0)
+		{
+			neighbor[ncount] = c-1;
+			kappa[ncount++] = affinity[l][2][c];
+		}
+		if (cx<width-1 && hl[c+1]>=0)
+		{
+			neighbor[ncount] = c+1;
+			kappa[ncount++] = affinity[l][0][c];
+		}
+		if (cy>0 && hl[c-width]>=0)
+		{
+			neighbor[ncount] = c-width;
+			kappa[ncount++] = affinity[l][3][c];
+		}
+		if (cy<height-1 && hl[c+width]>=0)
+		{
+			neighbor[ncount] = c+width;
+			kappa[ncount++] = affinity[l][1][c];
+		}
+		ch = hl[c] & ~1;
+		hl[c] -= MAX_CONNECTIVITY*2+4;
+		for (j=0; j<ncount; j++)
+		{
+			d = neighbor[j];
+			dh = hl[d] & ~1;
+			minh = ch<kappa[j]*2+2? ch: kappa[j]*2+2;
+			if (dh<minh || (dh==minh && (hl[R[d]]&1)==0 && (hl[R[c]]&1)))
+			{
+				R[d] = R[c];
+				Pr[d] = c;
+				UpdateGQueue(&Q, d, minh+(hl[c]&1));
+			}
+		}
+	}
+	for (c=0; c<slice_size; c++)
+	{
+		hl[c] += MAX_CONNECTIVITY*2+4;
+		out[c] = (hl[R[c]]&1)==0? (unsigned short)(hl[c]/2-1): 0;
+	}
+	free(hl);
+	free(R);
+	free(Pr);
+	DestroyGQueue(&Q);
+}
+
+/*****************************************************************************
+ * FUNCTION: forest_connectivity
+ * DESCRIPTION: Brings the forest up to date with the seeds and affinities
+ *    and gets the connectivity from it as full_connectivity does.
+ * PARAMETERS:
+ *    out: The connectivity, slice_size cells
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The variables forest, affinity, seed_cell, seed_label
+ *    and nseeds must be set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void forest_connectivity(unsigned short *out)
+{
+	int c;
+
+	if (VSetFuzzyForestSeeds(forest, seed_cell, seed_label, nseeds))
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	VRunFuzzyForest(forest);
+	for (c=0; c<slice_size; c++)
+		out[c] = (forest->key[c]&1)==0?
+			(unsigned short)(forest->key[c]/2-1): 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: step
+ * DESCRIPTION: Times the full and the updated connectivity for the seeds
+ *    and affinities as they are, and compares them.
+ * PARAMETERS:
+ *    t: The timing to add to
+ *    new_affinity: Non-zero if the affinities have changed
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The variables of full_connectivity and
+ *    forest_connectivity must be set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void step(Timing *t, int new_affinity)
+{
+	clock_t start;
+	double full_ms, update_ms;
+	int c;
+
+	start = clock();
+	full_connectivity(full_conn);
+	full_ms = (clock()-start)*1000./CLOCKS_PER_SEC;
+
+	start = clock();
+	if (new_affinity || !forest->affinity_set)
+		VSetFuzzyForestAffinity(forest,
+			(const unsigned short *(*)[4])affinity);
+	forest_connectivity(forest_conn);
+	update_ms = (clock()-start)*1000./CLOCKS_PER_SEC;
+
+	t->steps++;
+	t->full += full_ms;
+	t->update += update_ms;
+	if (full_ms > t->max_full)
+		t->max_full = full_ms;
+	if (update_ms > t->max_update)
+		t->max_update = update_ms;
+	t->updated += forest->updated;
+	for (c=0; c<slice_size; c++)
+		if (full_conn[c] != forest_conn[c])
+			t->mismatches++;
+}
+
+/*****************************************************************************
+ * FUNCTION: report
+ * DESCRIPTION: Prints a line of the timings.
+ * PARAMETERS:
+ *    what: The kind of step
+ *    t: The timing
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void report(const char *what, Timing *t)
+{
+	if (t->steps == 0)
+		return;
+	printf("%-18s %5d %10.3f %10.3f %10.3f %10.3f %9.0f %10ld\n", what,
+		t->steps, t->full/t->steps, t->max_full, t->update/t->steps,
+		t->max_update, t->updated/t->steps, t->mismatches);
+}
@@ -44,6 +44,7 @@ int slice_from_input_index(int index, int volume);
  *    Modified: 1/21/99 hashed heap used instead of queue by Dewey Odhner
  *    Modified: 2/1/99 connectivity used for hash value by Dewey Odhner
  *    Modified: 3/26/99 affinity computed during tracking by Dewey Odhner
+ *    Modified: 10/19/26 affinity taken from affinity_table before tracking
  *
  *****************************************************************************/
 void fuzzy_track(int current_volume)
@@ -51,6 +52,7 @@ void fuzzy_track(int current_volume)
 
     int j, k, slices_out, slice_size, counter;
 	int toggle;
+	long undefined_affinities;
     int ei, x, y, z;
     Voxel cur;
 	unsigned char *in_points_data;
@@ -313,9 +315,15 @@ void fuzzy_track(int current_volume)
 	}
 	else
 	{
-		memset(x_affinity, 255, slices_out*slice_size*sizeof(OutCellType));
-		memset(y_affinity, 255, slices_out*slice_size*sizeof(OutCellType));
-		memset(z_affinity, 255, (slices_out-1)*slice_size*sizeof(OutCellType));
+		undefined_affinities = fill_affinity_planes(x_affinity, y_affinity,
+			z_affinity, slices_out, x_adjacency, y_adjacency, z_adjacency);
+		if (undefined_affinities < 0)
+		{
+		  memset(x_affinity, 255, slices_out*slice_size*sizeof(OutCellType));
+		  memset(y_affinity, 255, slices_out*slice_size*sizeof(OutCellType));
+		  memset(z_affinity, 255,
+		    (slices_out-1)*slice_size*sizeof(OutCellType));
+		}
 		affp[0] = x_affinity;
 		affp[1] = y_affinity;
 		affp[2] = z_affinity;
@@ -373,7 +381,9 @@ void fuzzy_track(int current_volume)
    	 	}
 		if (num_points_picked==0 && points_filename==NULL)
 		{
-		  if (vh_in.scn.num_of_bits == 8)
+		  if (undefined_affinities == 0)
+		    ; /* all filled from the table */
+		  else if (vh_in.scn.num_of_bits == 8)
 		  {
 			for (cur.z=0; cur.z<slices_out; cur.z++)
 				for (cur.y=0; cur.y<vh_in.scn.xysize[1]; cur.y++)
@@ -21,114 +21,21 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <cv3dv.h>
+#include "scene_expr.h"
 
-typedef struct Quadratic {float xx, xy, yy, x, y, cnst;} Quadratic;
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#endif
 
-#define Quadratic_value(X, Y, q) \
-	((X)*((q).xx*(X)+(q).xy*(Y)+(q).x)+(Y)*((q).yy*(Y)+(q).y)+(q).cnst)
+#define SLICES_PER_THREAD 4	/* slices read at a time, for each thread */
 
 int get_slices(int dim, short *list);
-void adjust_interval(float *min_out, float *max_out, float min1, float max1,
-    float min2, float max2, Quadratic *q);
-float FuzzySymmetricProduct(double x, double y);
-
-/*****************************************************************************
- * FUNCTION: parse_quadratic
- * DESCRIPTION: Extracts the coefficients from a quadratic exxpression
- *    in "x" & "y".
- * PARAMETERS:
- *    out: The coefficents are stored here.
- *    in: The input expression in the form "[<f>xx][[+|-]<f>xy][[+|-]<f>yy]
- *       [[+|-]<f>x][[+|-]<f>y][[+|-]<f>]" where each "<f>" is a decimal
- *       coefficient.
- * SIDE EFFECTS: None
- * ENTRY CONDITIONS: None
- * RETURN VALUE: Non-zero on error
- * EXIT CONDITIONS: Not all errors in in are detected.
- * HISTORY:
- *    Created: 5/22/97 by Dewey Odhner
- *
- *****************************************************************************/
-int parse_quadratic(out, in)
-	Quadratic *out;
-	char in[];
-{
-	char *buf;
-	int coef_len, x_degree, y_degree;
-	float *field, coeff, factor;
-
-	buf = malloc(strlen(in)+1);
-	if (buf == NULL)
-		return (1);
-	out->xx = out->xy = out->yy = out->x = out->y = out->cnst = 0;
-	while (*in)
-	{
-		coeff = 1;
-		for (;; in++)
-		{
-			if (*in == '-')
-				coeff = -coeff;
-			else if (*in!=' ' && *in!='+')
-				break;
-		}
-		if (*in == 0)
-		{
-			free(buf);
-			return (2);
-		}
-		x_degree = y_degree = coef_len = 0;
-		for (;;)
-		{
-			while (*in == ' ')
-				in++;
-			if (*in==0 || *in=='+' || *in=='-' || *in=='x' || *in=='y')
-			{
-				if (*in == 'x')
-					x_degree++;
-				if (*in == 'y')
-					y_degree++;
-				if (x_degree+y_degree > 2)
-				{
-					free(buf);
-					return (2);
-				}
-				if (coef_len)
-				{
-					buf[coef_len] = 0;
-					if (sscanf(buf, "%f", &factor) != 1)
-					{
-						free(buf);
-						return (2);
-					}
-					coeff *= factor;
-					coef_len = 0;
-				}
-				if (*in==0 || *in=='+' || *in=='-')
-					break;
-			}
-			else
-				buf[coef_len++] = *in;
-			in++;
-		}
-		if (x_degree == 2)
-			field = &out->xx;
-		else if (y_degree == 2)
-			field = &out->yy;
-		else if (x_degree && y_degree)
-			field = &out->xy;
-		else if (x_degree)
-			field = &out->x;
-		else if (y_degree)
-			field = &out->y;
-		else
-			field = &out->cnst;
-		*field += coeff;
-	}
-	free(buf);
-	return (0);
-}
 
 /*****************************************************************************
  * FUNCTION: main
@@ -149,6 +56,8 @@ int parse_quadratic(out, in)
  *    Modified: 7/2/97 bit fields set by Dewey Odhner
  *    Modified: 12/16/97 memory allocation corrected by Dewey Odhner
  *    Modified: 8/27/02 unequal number of slices handled by Dewey Odhner
+ *    Modified: 10/19/26 general expressions in any number of scenes,
+ *       compiled by scene_expr; slices computed in parallel
  *
  *****************************************************************************/
 int main(argc,argv)
@@ -156,16 +65,17 @@ int argc;
 char *argv[];
 {
 
-  int sn,j,bytes,bytes1,bytes2,slices,size,error, bg_flag=FALSE, slic1, slic2,
-	start, stop, step, fsp_flag;
-  float min1,max1,min2,max2;
-  float val1,val2;
-  ViewnixHeader vh1,vh2;
-  FILE *in1,*in2,*out;
-  unsigned char *data1, *data2;
+  int sn,j,bytes,slices,size,error, bg_flag=FALSE, ninputs=2, first=1,
+	nexpr, result, mask, alt, batch, nb, ntasks, blocks, failed=0, most=0,
+	*bits, *slic;
+  float lo, hi, vmax, *min, *max;
+  long *slice_bytes;
+  ViewnixHeader *vh;
+  FILE **in,*out;
+  unsigned char **data, *odata;
   char group[6],elem[6];
-  Quadratic q_out, q_mask, q_alt;
-  double total=0;
+  SEProgram prog;
+  double total=0, *partial=NULL;
 
 #define Handle_error(message) \
 { \
@@ -184,214 +94,255 @@ char *argv[];
 	bg_flag = TRUE;
 	argc--;
   }
-  if (argc!=5 && argc!=7) {
+  if (argc>2 && strcmp(argv[1], "-inputs")==0) {
+    if (sscanf(argv[2], "%d", &ninputs)!=1 || ninputs<1)
+      ninputs = -1;
+    first = 3;
+  }
+  nexpr = argc-first-ninputs-1;
+  if (ninputs<1 || (nexpr!=1 && nexpr!=3)) {
     fprintf(stderr,
-"Usage: %s inputfile1 inputfile2 output_file expr [mask_expr alt_expr] [-b]\n",
+"Usage: %s [-inputs <n>] inputfile1 inputfile2 ... output_file expr [mask_expr alt_expr] [-b]\n",
 	  argv[0]);
     exit(-1);
   }
   if (bg_flag == 1)
     VAddBackgroundProcessInformation(argv[0]);
 
-  in1=fopen(argv[1],"rb");
-  if (in1==NULL )
-    Handle_error("Error in opening the input file\n");
-  in2=fopen(argv[2],"rb");
-  if (in2==NULL )
-    Handle_error("Error in opening the input file\n");
+  in = (FILE **)malloc(ninputs*sizeof(FILE *));
+  vh = (ViewnixHeader *)calloc(ninputs, sizeof(ViewnixHeader));
+  bits = (int *)malloc(ninputs*sizeof(int));
+  slic = (int *)malloc(ninputs*sizeof(int));
+  slice_bytes = (long *)malloc(ninputs*sizeof(long));
+  min = (float *)malloc(ninputs*sizeof(float));
+  max = (float *)malloc(ninputs*sizeof(float));
+  data = (unsigned char **)malloc(ninputs*sizeof(unsigned char *));
+  if (in==NULL || vh==NULL || bits==NULL || slic==NULL ||
+      slice_bytes==NULL || min==NULL || max==NULL || data==NULL)
+    Handle_error("Out of memory.\n");
+  for (j=0; j<ninputs; j++)
+  {
+    in[j]=fopen(argv[first+j],"rb");
+    if (in[j]==NULL )
+      Handle_error("Error in opening the input file\n");
+  }
 
-  if (strcmp(argv[3], "/dev/null") == 0)
+  if (strcmp(argv[first+ninputs], "/dev/null") == 0)
     out = NULL;
   else
   {
-    out=fopen(argv[3],"w+b");
+    out=fopen(argv[first+ninputs],"w+b");
     if ( out==NULL )
       Handle_error("Error in opening output file\n");
   }
 
-  error=VReadHeader(in1,&vh1,group,elem);
-  if (error>0 && error<=104)
-    Handle_error("Fatal error in reading header\n");
-
-  if (vh1.gen.data_type!=IMAGE0)
-    Handle_error("This is not an IMAGE0 file\n");
-
-  if (strcmp(argv[4], "fsp") == 0)
-    fsp_flag = 1;
-  else
+  for (slices=j=0; j<ninputs; j++)
   {
-    fsp_flag = 0;
-	if (parse_quadratic(&q_out, argv[4]))
-      Handle_error("Cannot parse expr.\n");
+    error=VReadHeader(in[j],vh+j,group,elem);
+    if (error>0 && error<=104)
+      Handle_error("Fatal error in reading header\n");
+    if (j == 0)
+    {
+      if (vh[0].gen.data_type!=IMAGE0)
+        Handle_error("This is not an IMAGE0 file\n");
+    }
+    else if (vh[j].gen.data_type!=IMAGE0 ||
+        vh[j].scn.xysize[0]!=vh[0].scn.xysize[0] ||
+        vh[j].scn.xysize[1]!=vh[0].scn.xysize[1])
+      Handle_error("Input file is incompatible with 1st input file\n");
+    bits[j] = vh[j].scn.num_of_bits;
+    if (bits[j]!=1 && bits[j]!=8 && bits[j]!=16)
+      Handle_error("Input file must have 1, 8 or 16 bits\n");
+    slic[j] = get_slices(vh[j].scn.dimension,vh[j].scn.num_of_subscenes);
+    if (slic[j] > slices)
+    {
+      slices = slic[j];
+      most = j;
+    }
+    min[j] = vh[j].scn.smallest_density_value[0];
+    max[j] = vh[j].scn.largest_density_value[0];
   }
-  if (argc == 5)
-	parse_quadratic(&q_mask, "1");
-  else if (parse_quadratic(&q_mask, argv[5]))
-    Handle_error("Cannot parse mask_expr.\n")
-  else if (parse_quadratic(&q_alt, argv[6]))
-    Handle_error("Cannot parse alt_expr.\n");
-
-  bytes1 = vh1.scn.num_of_bits/8;
-  slices = slic1 = get_slices(vh1.scn.dimension,vh1.scn.num_of_subscenes);
-  size= (vh1.scn.xysize[0]*vh1.scn.xysize[1]);
-
-  error=VReadHeader(in2,&vh2,group,elem);
-  if (error>0 && error<=104)
-    Handle_error("Fatal error in reading header\n");
-
-  if (vh2.gen.data_type!=IMAGE0 ||
-      vh2.scn.xysize[0]!=vh1.scn.xysize[0] || 
-      vh2.scn.xysize[1]!=vh1.scn.xysize[1])
-    Handle_error("Second input file is incompatible with 1st input file");
-  if ((slic2=get_slices(vh2.scn.dimension,vh2.scn.num_of_subscenes)) > slices)
-    slices = slic2;
-  bytes2 = vh2.scn.num_of_bits/8;
-  min1 = vh1.scn.smallest_density_value[0];
-  max1 = vh1.scn.largest_density_value[0];
-  min2 = vh2.scn.smallest_density_value[0];
-  max2 = vh2.scn.largest_density_value[0];
-
-  vh1.scn.smallest_density_value[0] = 65535;
-  vh1.scn.largest_density_value[0] = 0;
-  adjust_interval(vh1.scn.smallest_density_value,
-	vh1.scn.largest_density_value, min1, max1, min2, max2,
-	fsp_flag? (Quadratic *)0:&q_out);
-  if (argc == 7)
-	adjust_interval(vh1.scn.smallest_density_value,
-	  vh1.scn.largest_density_value, min1, max1, min2, max2, &q_alt);
-  if (vh1.scn.smallest_density_value[0] < 0)
-	vh1.scn.smallest_density_value[0] = 0;
-  if (vh1.scn.largest_density_value[0] > 65535)
-	vh1.scn.largest_density_value[0] = 65535;
-
-  bytes = vh1.scn.largest_density_value[0]>=256? 2:1;
-  vh1.scn.num_of_bits=bytes*8;
-  vh1.scn.bit_fields[0] = 0;
-  vh1.scn.bit_fields[1] = vh1.scn.num_of_bits-1;
-  strncpy(vh1.gen.filename, argv[3], sizeof(vh1.gen.filename));
-  if (slic2 > slic1)
+  size= (vh[0].scn.xysize[0]*vh[0].scn.xysize[1]);
+  for (j=0; j<ninputs; j++)
+    slice_bytes[j] = bits[j]==1? (size+7)/8: size*(bits[j]/8);
+
+  if (se_init(&prog, ninputs))
+    Handle_error("Out of memory.\n");
+  result = se_compile(&prog, argv[first+ninputs+1]);
+  if (result < 0)
+    Handle_error("Cannot parse expr.\n");
+  if (nexpr == 3)
   {
-    vh1.scn.dimension = vh2.scn.dimension;
-	free(vh1.scn.num_of_subscenes);
-	free(vh1.scn.loc_of_subscenes);
-	vh1.scn.num_of_subscenes = vh2.scn.num_of_subscenes;
-	vh1.scn.loc_of_subscenes = vh2.scn.loc_of_subscenes;
+    mask = se_compile(&prog, argv[first+ninputs+2]);
+    if (mask < 0)
+      Handle_error("Cannot parse mask_expr.\n");
+    alt = se_compile(&prog, argv[first+ninputs+3]);
+    if (alt < 0)
+      Handle_error("Cannot parse alt_expr.\n");
+    result = se_select(&prog, mask, result, alt);
+  }
+  if (result<0 || se_finish(&prog, result))
+    Handle_error("Out of memory.\n");
+
+  se_range(&prog, result, min, max, &lo, &hi);
+  /* voxels are rounded to the nearest integer, and so is their range */
+  lo = (float)floor(lo+.5);
+  hi = (float)floor(hi+.5);
+  vh[0].scn.smallest_density_value[0] = lo<65535? lo: 65535;
+  vh[0].scn.largest_density_value[0] = hi>0? hi: 0;
+  if (vh[0].scn.smallest_density_value[0] < 0)
+	vh[0].scn.smallest_density_value[0] = 0;
+  if (vh[0].scn.largest_density_value[0] > 65535)
+	vh[0].scn.largest_density_value[0] = 65535;
+
+  bytes = vh[0].scn.largest_density_value[0]>=256? 2:1;
+  vmax = bytes==2? 65535: 255;
+  vh[0].scn.num_of_bits=bytes*8;
+  vh[0].scn.bit_fields[0] = 0;
+  vh[0].scn.bit_fields[1] = vh[0].scn.num_of_bits-1;
+  strncpy(vh[0].gen.filename, argv[first+ninputs],
+    sizeof(vh[0].gen.filename));
+  if (most > 0)
+  {
+    vh[0].scn.dimension = vh[most].scn.dimension;
+	free(vh[0].scn.num_of_subscenes);
+	free(vh[0].scn.loc_of_subscenes);
+	vh[0].scn.num_of_subscenes = vh[most].scn.num_of_subscenes;
+	vh[0].scn.loc_of_subscenes = vh[most].scn.loc_of_subscenes;
   }
 
-  data1= (unsigned char *)malloc(size*2);
-  if (data1==NULL)
-    Handle_error("Could not allocate data. Aborting fuzz_ops\n");
-
-  data2= (unsigned char *)malloc((size*vh2.scn.num_of_bits+7)/8);
-  if (data2==NULL)
-    Handle_error("Could not allocate output data. Aborting fuzz_ops\n");
+  /* Slices are read and written a batch at a time; the blocks of voxels
+     of a batch are computed in parallel. */
+  batch = SLICES_PER_THREAD*omp_get_max_threads();
+  if (batch > slices)
+    batch = slices;
+  blocks = (size+SE_BLOCK-1)/SE_BLOCK;
+  for (j=0; j<ninputs; j++)
+  {
+    data[j] = (unsigned char *)malloc(batch*slice_bytes[j]);
+    if (data[j] == NULL)
+      Handle_error("Could not allocate data. Aborting algebra\n");
+  }
+  odata = (unsigned char *)malloc((size_t)batch*size*bytes);
+  if (out == NULL)
+    partial = (double *)malloc(batch*blocks*sizeof(double));
+  if (odata==NULL || (out==NULL && partial==NULL))
+    Handle_error("Could not allocate output data. Aborting algebra\n");
 
   if (out)
   {
-    error=VWriteHeader(out,&vh1,group,elem);
+    error=VWriteHeader(out,vh,group,elem);
     if (error>0 && error<=104)
       Handle_error("Fatal error in writing header\n");
   }
 
-  VSeekData(in1,0);
-  VSeekData(in2,0);
+  for (j=0; j<ninputs; j++)
+    VSeekData(in[j],0);
 
-  if (bytes1 > bytes)
-  {
-	start = 0;
-	stop = size;
-	step = 1;
-  }
-  else
-  {
-	start = size-1;
-	stop = -1;
-	step = -1;
-  }
-  for(sn=0; sn<slices; sn++) {
+  for(sn=0; sn<slices; sn+=nb) {
+    nb = slices-sn<batch? slices-sn: batch;
     if (out && !bg_flag)
-	{	printf("Computing slice %d\r", sn+1);
+	{	printf("Computing slice %d\r", sn+nb);
     	fflush(stdout);
 	}
 
-    if (sn >= slic1)
-		memset(data1, 0, bytes1? bytes1*size: (size+7)/8);
-	else if (bytes1)
-		error = VReadData((char *)data1,bytes1,size,in1,&j);
-	else
-		error = VReadData((char *)data1, 1, (size+7)/8, in1, &j);
-	if (error)
-      Handle_error("Could not read data\n");
-    if (sn >= slic2)
-		memset(data2, 0, bytes2? bytes2*size: (size+7)/8);
-	else if (bytes2)
-		error = VReadData((char *)data2,bytes2,size,in2,&j);
-	else
-		error = VReadData((char *)data2, 1, (size+7)/8, in2, &j);
-	if (error)
-      Handle_error("Could not read data\n");
-
-	for (j=start; j!=stop; j+=step)
-	{
-		switch (bytes1)
-		{
-		  case 0:
-			val1 = (float)((data1[j/8]&(128>>(j%8))) != 0);
-			break;
-		  case 1:
-			val1 = data1[j];
-			break;
-		  case 2:
-			val1 = ((unsigned short *)data1)[j];
-			break;
-		}
-		switch (bytes2)
-		{
-		  case 0:
-			val2 = (float)((data2[j/8]&(128>>(j%8))) != 0);
-			break;
-		  case 1:
-			val2 = data2[j];
-			break;
-		  case 2:
-			val2 = ((unsigned short *)data2)[j];
-			break;
-		}
-		if (Quadratic_value(val1, val2, q_mask) > 0)
-		{
-			if (fsp_flag)
-				val1= 65534*FuzzySymmetricProduct(1/65534.*val1,1/65534.*val2);
-			else
-				val1 = Quadratic_value(val1, val2, q_out);
-		}
-		else
-			val1 = Quadratic_value(val1, val2, q_alt);
-		if (out)
-		{
-			val1 += .5;
-			if (val1 < 0)
-				val1 = 0;
-			if (val1 > 65535)
-				val1 = 65535;
-			if (bytes == 2)
-				((unsigned short *)data1)[j] = (unsigned short)val1;
-			else
-				data1[j] = (unsigned char)val1;
-		}
-		else
-			total += val1;
-	}
-
-    if (out && VWriteData((char *)data1,bytes,size,out,&j))
+    for (j=0; j<ninputs; j++)
+    {
+      int avail=slic[j]-sn<0? 0: slic[j]-sn<nb? slic[j]-sn: nb, nread;
+
+      if (avail)
+      {
+        if (bits[j] == 16)
+          error = VReadData((char *)data[j], 2, avail*size, in[j], &nread);
+        else
+          error = VReadData((char *)data[j], 1, avail*slice_bytes[j], in[j],
+            &nread);
+        if (error)
+          Handle_error("Could not read data\n");
+      }
+      memset(data[j]+avail*slice_bytes[j], 0, (nb-avail)*slice_bytes[j]);
+    }
+
+    ntasks = nb*blocks;
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+      float *regs=(float *)malloc(prog.ninstr*SE_BLOCK*sizeof(float));
+      SEInput *src=(SEInput *)malloc(ninputs*sizeof(SEInput));
+      int t, i, k, count;
+
+      if (regs && src)
+        se_start(&prog, regs);
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic, 16)
+#endif
+      for (t=0; t<ntasks; t++)
+      {
+        int s=t/blocks;
+        long start=(long)(t%blocks)*SE_BLOCK;
+        const float *v=regs+result*SE_BLOCK;
+
+        if (regs==NULL || src==NULL)
+          continue;
+        count = size-start<SE_BLOCK? (int)(size-start): SE_BLOCK;
+        for (i=0; i<ninputs; i++)
+        {
+          src[i].data = data[i]+s*slice_bytes[i];
+          src[i].bits = bits[i];
+        }
+        se_eval(&prog, src, start, count, regs);
+        if (out)
+        {
+          long o=(long)s*size+start;
+
+          for (k=0; k<count; k++)
+          {
+            float val=(float)(v[k]+.5);
+
+            if (val < 0)
+              val = 0;
+            if (val > vmax)
+              val = vmax;
+            if (bytes == 2)
+              ((unsigned short *)odata)[o+k] = (unsigned short)val;
+            else
+              odata[o+k] = (unsigned char)val;
+          }
+        }
+        else
+        {
+          double sum=0;
+
+          for (k=0; k<count; k++)
+            sum += v[k];
+          partial[t] = sum;
+        }
+      }
+      if (regs==NULL || src==NULL)
+        failed = 1;
+      if (regs)
+        free(regs);
+      if (src)
+        free(src);
+    }
+    if (failed)
+      Handle_error("Out of memory.\n");
+
+    if (out && VWriteData((char *)odata,bytes,nb*size,out,&j))
       Handle_error("Could not write data\n");
+    if (out == NULL)
+      for (j=0; j<ntasks; j++)
+        total += partial[j];
   }
 
-  fclose(in1);
-  fclose(in2);
+  for (j=0; j<ninputs; j++)
+    fclose(in[j]);
   if (out)
     VCloseData(out);
   else
     printf("%f\n", total);
+  se_free(&prog);
 
   if (bg_flag == 1)
   {	char cmd[256];
@@ -406,116 +357,6 @@ char *argv[];
   exit(0);
 }
 
-
-
-/*****************************************************************************
- * FUNCTION: adjust_interval
- * DESCRIPTION: Adjusts an interval to cover the range of a quadratic function
- *    within a rectangular domain.
- * PARAMETERS:
- *    min_out, max_out: The interval to be adjusted.
- *    min1, max1: The domain of the "x" variable.
- *    min2, max2: The domain of the "y" variable.
- *    q: The coefficients of the quadratic function.
- * SIDE EFFECTS: None
- * ENTRY CONDITIONS: None
- * RETURN VALUE: None
- * EXIT CONDITIONS: None
- * HISTORY:
- *    Created: 5/28/97 by Dewey Odhner
- *
- *****************************************************************************/
-void adjust_interval(float *min_out, float *max_out, float min1, float max1,
-    float min2, float max2, Quadratic *q)
-{
-  float val1,val2;
-
-  if (q == 0)
-  {
-    if (0 < *min_out)
-	  *min_out = 0;
-	if (65534 > *max_out)
-	  *max_out = 65534;
-	return;
-  }
-  val1 = (float)Quadratic_value(min1, min2, *q);
-  if (val1 < *min_out)
-	  *min_out = val1;
-  if (val1 > *max_out)
-	  *max_out = val1;
-  val1 = (float)Quadratic_value(min1, max2, *q);
-  if (val1 < *min_out)
-	  *min_out = val1;
-  if (val1 > *max_out)
-	  *max_out = val1;
-  val1 = (float)Quadratic_value(max1, min2, *q);
-  if (val1 < *min_out)
-	  *min_out = val1;
-  if (val1 > *max_out)
-	  *max_out = val1;
-  val1 = (float)Quadratic_value(max1, max2, *q);
-  if (val1 < *min_out)
-	  *min_out = val1;
-  if (val1 > *max_out)
-	  *max_out = val1;
-  if (q->xx != 0)
-  {
-	val1 = (float)(-(q->xy*min2+q->x)/(2*q->xx));
-	if (val1 > min1 && val1<max1)
-	{
-		val1 = (float)Quadratic_value(val1, min2, *q);
-		if (val1 < *min_out)
-			*min_out = val1;
-		if (val1 > *max_out)
-			*max_out = val1;
-	}
-	val1 = (float)(-(q->xy*max2+q->x)/(2*q->xx));
-	if (val1 > min1 && val1<max1)
-	{
-		val1 = (float)Quadratic_value(val1, max2, *q);
-		if (val1 < *min_out)
-			*min_out = val1;
-		if (val1 > *max_out)
-			*max_out = val1;
-	}
-  }
-  if (q->yy != 0)
-  {
-	val1 = (float)(-(q->xy*min1+q->y)/(2*q->yy));
-	if (val1 > min2 && val1<max2)
-	{
-		val1 = (float)Quadratic_value(min1, val1, *q);
-		if (val1 < *min_out)
-			*min_out = val1;
-		if (val1 > *max_out)
-			*max_out = val1;
-	}
-	val1 = (float)(-(q->xy*max1+q->y)/(2*q->yy));
-	if (val1 > min2 && val1<max2)
-	{
-		val1 = (float)Quadratic_value(max1, val1, *q);
-		if (val1 < *min_out)
-			*min_out = val1;
-		if (val1 > *max_out)
-			*max_out = val1;
-	}
-  }
-  val1 = 4*q->xx*q->yy-q->xy*q->xy;
-  if (val1 != 0)
-  {
-	val2 = (q->xy*q->x-2*q->xx*q->y)/val1;
-	val1 = (q->xy*q->y-2*q->yy*q->x)/val1;
-	if (val1>min1 && val1<max1 && val2>min2 && val2<max2)
-	{
-		val1 = Quadratic_value(val1, val2, *q);
-		if (val1 < *min_out)
-			*min_out = val1;
-		if (val1 > *max_out)
-			*max_out = val1;
-	}
-  }
-}
-
 /*****************************************************************************
  * FUNCTION: get_slices
  * DESCRIPTION: Returns total number of slices in a scene.
@@ -542,13 +383,3 @@ int get_slices(int dim, short *list)
   }
   return(0);
 }
-
-float FuzzySymmetricProduct(double x, double y)
-{
-	double r;
-
-	r = x*y*(x*y+1-x-y);
-	if (r < 0)
-		r = 0;
-	return (float)(1-x-y? (sqrt(r)-x*y)/(1-x-y): .5);
-}
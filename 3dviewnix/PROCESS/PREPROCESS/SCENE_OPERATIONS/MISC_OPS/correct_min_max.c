@@ -28,16 +28,14 @@ typedef double VECTOR[3];
 double VecMag(VECTOR u);
 double DotProd(VECTOR u, VECTOR v);
 int get_slices(int dim, short *list);
-void CrossProd(VECTOR out, VECTOR u, VECTOR v),
-  UpdateMinMax8(int *min, int *max, unsigned char *data, int size),
-  UpdateMinMax16(int *min, int *max, unsigned short *data, int size,
-    int signed_bits);
+void CrossProd(VECTOR out, VECTOR u, VECTOR v);
 
 /*    Modified: 9/6/95 vh.scn.smallest_density_value_valid and
  *       vh.scn.largest_density_value_valid set by Dewey Odhner */
 /*    Modified: 2/9/96 exit code 0 passed by Dewey Odhner */
 /*    Modified: 8/4/00 test for negative value by Dewey Odhner */
 /*    Modified: 2/20/02 negative values set to zero by Dewey Odhner */
+/*    Modified: 10/19/26 min & max from VGetSceneFileStats */
 int main(argc,argv)
 int argc;
 char *argv[];
@@ -51,6 +49,7 @@ char *argv[];
   int correct_flag, make_4D=0;
   double val;
   VECTOR u,v,w,temp;
+  VSceneStats stats;
 
   if (argc>3 && strcmp(argv[argc-1], "-make_4D")==0)
   {
@@ -187,33 +186,21 @@ char *argv[];
 	vh.scn.dimension = 4;
   }  
 
-  VSeekData(in,0);
-  switch (bytes) {
-  case 1:
-    min=255; max=0;
-    for(i=0;i<slices;i++) {
-      printf("Computing min max for slice %d\r",i);
-      if (VReadData((char *)data,bytes,size,in,&j)) {
-	printf("Could not read data\n");
-	exit(-1);
-      }
-      UpdateMinMax8(&min,&max,data,size);
-    }
-    break;
-  case 2:
-    min=65535; max=0;
-    for(i=0;i<slices;i++) {
-      printf("Computing min max for slice %d\r",i);
-      if (VReadData((char *)data,bytes,size,in,&j)) {
-	printf("Could not read data\n");
-	exit(-1);
-      }
-      UpdateMinMax16(&min,&max, (unsigned short *)data, size,
-	    vh.scn.signed_bits_valid && vh.scn.signed_bits[0]);
-    }
-    break;
+  /* one pass, or none if the statistics of the file are cached */
+  printf("Computing min max\r");
+  error = VGetSceneFileStats(argv[1], &stats);
+  if (error) {
+    printf("Could not read data\n");
+    exit(-1);
   }
-    
+  min = bytes==1? 255: 65535;
+  max = 0;
+  if (stats.count) {
+    if (stats.min < min) min = (int)stats.min;
+    if (stats.max > max) max = (int)stats.max;
+  }
+  VFreeSceneStats(&stats);
+
   vh.scn.smallest_density_value[0]=(float)min;
   vh.scn.largest_density_value[0] =(float)max;
   if (min >= 0)
@@ -244,7 +231,12 @@ char *argv[];
     }
 	if (min<0 && argc==3)
 	  for (j=0; j<size; j++)
-		if (((short *)data)[j] < 0)
+	    if (bytes == 1)
+		{
+		  if (((signed char *)data)[j] < 0)
+		    data[j] = 0;
+		}
+		else if (((short *)data)[j] < 0)
 		  ((short *)data)[j] = 0;
     if (VWriteData((char *)data,bytes,size,out, &j)) {
       printf("Could not read data\n");
@@ -259,38 +251,6 @@ char *argv[];
 }
 
 
-void UpdateMinMax8(int *min, int *max, unsigned char *data, int size)
-{
-  int i;
-  
-  for(i=0;i<size;data++,i++) {
-    if (*data < *min) *min=*data;
-    if (*data > *max) *max=*data;
-  }
-
-}
-
-/* Modified: 2/20/02 signed data handled by Dewey Odhner. */
-void UpdateMinMax16(int *min, int *max, unsigned short *data, int size,
-    int signed_bits)
-{
-  int i;
-  short *sdata;
-  
-  sdata = (short *)data;
-  if (signed_bits)
-    for(i=0;i<size;sdata++,i++) {
-      if (*sdata < *min) *min=*sdata;
-      if (*sdata > *max) *max=*sdata;
-    }
-  else
-    for(i=0;i<size;data++,i++) {
-      if (*data < *min) *min=*data;
-      if (*data > *max) *max=*data;
-    }
-
-}
-      
 double VecMag(VECTOR u)
 {
   return  sqrt((double)(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]));
@@ -23,12 +23,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 #include <stdlib.h>
 #include <cv3dv.h>
-
-typedef struct { int x, y, z; } Point;
-
-#define QueueItem Point
-#define HandleQueueError {fprintf(stderr,"Out of memory.\n");exit(1);}
-#include "port_data/queue.c"
+#include "../FILTER/components.h"
 
 int get_slices(int dim, short *list);
 
@@ -45,9 +40,10 @@ char *argv[];
 	int j, k;		/* general use */
 	int error;		/* error code */
 	char *comments;	/* used to modify the header (description field) */
-	unsigned char *in_buffer, *cur_buffer, *max_buffer, *cum_buffer;
-	Point cur, nex, scanning;
-	unsigned long cur_size, max_size=0, cum_size=0, tot_size=0;
+	unsigned char *in_buffer, *max_buffer, *keep;
+	CCLabeling cc;
+	long *max_size;
+	int *max_label;
 	int slicewise, cur_slice;
 
 
@@ -86,8 +82,6 @@ char *argv[];
 	width = vh.scn.xysize[0];
 	height = vh.scn.xysize[1];
 	in_buffer = (unsigned char *)malloc((width*height+7)/8*slices);
-	cur_buffer = (unsigned char *)malloc((width*height+7)/8*slices);
-	cum_buffer = (unsigned char *)malloc((width*height+7)/8*slices);
 	max_buffer = (unsigned char *)malloc((width*height+7)/8*slices);
 	if (max_buffer == NULL)
 	{
@@ -108,153 +102,34 @@ char *argv[];
         exit(1);
     }
 
-#define Is_Set(buf, pt) (((buf)[(width*height+7)/8*(pt).z+ \
-	(width*(pt).y+(pt).x)/8] & (128>>((width*(pt).y+(pt).x)%8))) != 0)
-
-#define Set_Bit(buf, pt) ((buf)[(width*height+7)/8*(pt).z+ \
-	(width*(pt).y+(pt).x)/8] |= (128>>((width*(pt).y+(pt).x)%8)))
-
-#define Step_Fwd {if (++scanning.x == width) \
-                  {   scanning.x = 0; \
-				      if (++scanning.y == height) \
-					  { \
-					      scanning.y = 0; \
-						  scanning.z++; \
-					  } \
-				  } \
-				 }
-
-#define Enqueue_nex { Set_Bit(cur_buffer, nex); Enqueue(nex); cur_size++; cum_size++; }
-
-	memset(cum_buffer, 0, (width*height+7)/8*slices);
-
-    if (slicewise)
-    {
-        for (cur_slice=0; cur_slice<slices; cur_slice++)
-        {
-			tot_size = 0;
-            scanning.x = scanning.y = 0;
-			scanning.z = cur_slice;
-            while (scanning.z == cur_slice)
-            {
-                if (Is_Set(in_buffer, scanning))
-                    tot_size++;
-                Step_Fwd
-            }
-			max_size = cum_size = 0;
-            scanning.x = scanning.y = 0;
-			scanning.z = cur_slice;
-            while (max_size < tot_size-cum_size)
-            {
-                memset(cur_buffer, 0, (width*height+7)/8*slices);
-                cur_size = 0;
-                while (!Is_Set(in_buffer, scanning) ||
-                        Is_Set(cum_buffer, scanning))
-                    Step_Fwd
-                ClearQueue;
-                cur = scanning;
-                Set_Bit(cur_buffer, cur);
-                Enqueue(cur);
-				cum_size++;
-                while (!QueueIsEmpty)
-                {
-                    Dequeue(cur);
-                    nex.x = cur.x-1;
-                    nex.y = cur.y;
-                    nex.z = cur.z;
-                    if (cur.x>0 && !Is_Set(cur_buffer, nex) &&
-                            Is_Set(in_buffer, nex))
-                        Enqueue_nex
-                    nex.x = cur.x+1;
-                    if (cur.x<width-1 && !Is_Set(cur_buffer, nex) &&
-                            Is_Set(in_buffer, nex))
-                        Enqueue_nex
-                    nex.x = cur.x;
-                    nex.y = cur.y-1;
-                    if (cur.y>0 && !Is_Set(cur_buffer, nex) &&
-                            Is_Set(in_buffer, nex))
-                        Enqueue_nex
-                    nex.y = cur.y+1;
-                    if (cur.y<height-1 && !Is_Set(cur_buffer, nex) &&
-                            Is_Set(in_buffer, nex))
-                        Enqueue_nex
-					assert(nex.z == cur_slice);
-                }
-                if (cur_size > max_size)
-                {
-                    max_size = cur_size;
-                    memcpy(max_buffer+(width*height+7)/8*cur_slice,
-					    cur_buffer+(width*height+7)/8*cur_slice,
-						(width*height+7)/8);
-                }
-                for (j=(width*height+7)/8*cur_slice;
-				        j<(width*height+7)/8*(cur_slice+1); j++)
-                    cum_buffer[j] |= cur_buffer[j];
-            }
-        }
-    }
-    else
-    {
-        scanning.x = scanning.y = scanning.z = 0;
-        while (scanning.z < slices)
-        {
-            if (Is_Set(in_buffer, scanning))
-                tot_size++;
-            Step_Fwd
-        }
-        scanning.x = scanning.y = scanning.z = 0;
-        while (max_size < tot_size-cum_size)
-        {
-            memset(cur_buffer, 0, (width*height+7)/8*slices);
-            cur_size = 0;
-            while (!Is_Set(in_buffer, scanning) || Is_Set(cum_buffer,scanning))
-                Step_Fwd
-            ClearQueue;
-            cur = scanning;
-            Set_Bit(cur_buffer, cur);
-            Enqueue(cur);
-			cum_size++;
-            while (!QueueIsEmpty)
-            {
-                Dequeue(cur);
-                nex.x = cur.x-1;
-                nex.y = cur.y;
-                nex.z = cur.z;
-                if (cur.x>0 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-                nex.x = cur.x+1;
-                if (cur.x<width-1 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-                nex.x = cur.x;
-                nex.y = cur.y-1;
-                if (cur.y>0 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-                nex.y = cur.y+1;
-                if (cur.y<height-1 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-                nex.y = cur.y;
-                nex.z = cur.z-1;
-                if (cur.z>0 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-                nex.z = cur.z+1;
-                if (cur.z<slices-1 && !Is_Set(cur_buffer, nex) &&
-                        Is_Set(in_buffer, nex))
-                    Enqueue_nex
-            }
-            if (cur_size > max_size)
-            {
-                max_size = cur_size;
-                memcpy(max_buffer, cur_buffer, (width*height+7)/8*slices);
-            }
-            for (j=0; j<(width*height+7)/8*slices; j++)
-                cum_buffer[j] |= cur_buffer[j];
-        }
-    }
+	/* Components are numbered in the order they are met scanning the
+	   scene, so the first of equal largest components is kept. */
+	error = cc_label_bits(&cc, in_buffer, width, height, slices,
+		slicewise? 4: 6);
+	keep = (unsigned char *)calloc(cc.ncomponents+1, 1);
+	max_size = (long *)calloc(slices, sizeof(long));
+	max_label = (int *)calloc(slices, sizeof(int));
+	if (error || keep==NULL || max_size==NULL || max_label==NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for (j=1; j<=cc.ncomponents; j++)
+	{
+		cur_slice = slicewise? cc.stats[j-1].zmin: 0;
+		if (cc.stats[j-1].size > max_size[cur_slice])
+		{
+			max_size[cur_slice] = cc.stats[j-1].size;
+			max_label[cur_slice] = j;
+		}
+	}
+	for (cur_slice=0; cur_slice<(slicewise? slices: 1); cur_slice++)
+		keep[max_label[cur_slice]] = max_label[cur_slice] > 0;
+	cc_select_bits(&cc, keep, max_buffer);
+	cc_free(&cc);
+	free(keep);
+	free(max_size);
+	free(max_label);
 
 	/* Get the filenames right (own and parent) */
     strncpy(vh.gen.filename1, argv[1], sizeof(vh.gen.filename1)-1);
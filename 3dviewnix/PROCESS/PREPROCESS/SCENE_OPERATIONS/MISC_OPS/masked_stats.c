@@ -26,9 +26,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 int get_slices(int dim, short *list);
 void bin_to_grey(unsigned char *bin_buffer, int length,
      unsigned char *grey_buffer, int min_value, int max_value),
-  Stat16(unsigned short *in, unsigned char *msk, int size),
   SSD16(unsigned short *in, unsigned char *msk, int xsize, int ysize),
-  Stat8(unsigned char *in, unsigned char *msk, int size),
   SSD8(unsigned char *in, unsigned char *msk, int xsize, int ysize);
 void destroy_scene_header(ViewnixHeader *vh);
 void get_stats(double *mean, double *sd, double *mode, int *median,
@@ -41,6 +39,7 @@ void get_stats2(double *mean, double *sd, double *mode, int *median,
 	int bin_size);
 void Stat_2D(unsigned char *in1, unsigned char *msk, unsigned char *in3,
     int size, int bytes1, int bytes3);
+void merge_stats(VSceneStats *stats);
 int get_percentile(double percentile);
 
 static double sum_sqr=0.0,sum=0.0, ssd=0.0;
@@ -64,6 +63,7 @@ char *argv[];
   char group[6],elem[6];
   double mean,sd,mode, inlier_mean, inlier_sd, inhomogeneity;
   double mu_2, mu_3, mu_4, skewness, kurtosis, peak_height, find_percentile=0;
+  VSceneStats stats[2]; /* 8- and 16-bit scenes */
 
   if (argc>6 && strcmp(argv[argc-4], "-adjust_threshold")==0 &&
       sscanf(argv[argc-3], "%d", orig_threshold)==1 &&
@@ -105,6 +105,11 @@ char *argv[];
   }
 
   nsubjects = (argc-1)/(twoDhist? 3:2);
+  if (VInitSceneStats(stats, 8, 0) || VInitSceneStats(stats+1, 16, 0))
+  {
+    fprintf(stderr, "Out of memory\n");
+    exit(-1);
+  }
 
   for (subject=0; subject<nsubjects; subject++)
   {
@@ -259,12 +264,12 @@ char *argv[];
 	  }
 	  else if (vh1.scn.num_of_bits==16)
       {
-        Stat16((unsigned short *)d1_8,d2_8,size);
+        VAccumulateSceneStats(stats+1, d1_8, d2_8, size);
         SSD16((unsigned short *)d1_8, d2_8, vh1.scn.xysize[0], vh1.scn.xysize[1]);
       }
       else
       {
-        Stat8(d1_8,d2_8,size);
+        VAccumulateSceneStats(stats, d1_8, d2_8, size);
         SSD8(d1_8, d2_8, vh1.scn.xysize[0], vh1.scn.xysize[1]);
       }
 
@@ -285,7 +290,13 @@ char *argv[];
 	  fclose(in3);
 	}
   }
-
+  if (!twoDhist)
+  {
+    merge_stats(stats);
+    merge_stats(stats+1);
+  }
+  VFreeSceneStats(stats);
+  VFreeSceneStats(stats+1);
 
   if (count) {
     if (delta > 0)
@@ -557,37 +568,22 @@ void Stat_2D(unsigned char *in1, unsigned char *msk, unsigned char *in3,
 	}
 }
 
-void Stat16(unsigned short *in, unsigned char *msk, int size)
-{
-  int i;
-
-  for(i=0;i<size;msk++,in++,i++)
-    if (*msk) {
-      if (*in > max_dens) max_dens= *in;
-      if (*in < min_dens) min_dens= *in;
-      dist[*in]++;
-      sum += *in;
-      sum_sqr += (double)(*in) * (*in);
-      count++;
-    }
-
-}
-
-
-void Stat8(unsigned char *in, unsigned char *msk, int size)
+/* Adds the masked intensities counted by VAccumulateSceneStats to dist[]
+ * and the running totals. */
+void merge_stats(VSceneStats *stats)
 {
   int i;
 
-  for(i=0;i<size;msk++,in++,i++)
-    if (*msk)  {
-      if (*in > max_dens) max_dens= *in;
-      if (*in < min_dens) min_dens= *in;
-      dist[*in]++;
-      sum += *in;
-      sum_sqr += (double)(*in) * (*in);
-      count++;
-    }
-  
+  VFinishSceneStats(stats);
+  if (stats->count == 0)
+    return;
+  if (stats->min < min_dens) min_dens = (unsigned int)stats->min;
+  if (stats->max > max_dens) max_dens = (unsigned int)stats->max;
+  for (i=0; i<stats->hist_size; i++)
+    dist[i] += stats->hist[i];
+  sum += stats->sum;
+  sum_sqr += stats->sum_sqr;
+  count += stats->count;
 }
 
 
@@ -33,6 +33,9 @@ OutCellType *out_data;
 
 #define INVERSE_METHOD 100
 
+/* cells of a scene mapped (read and written) at a time */
+#define SCALE_CHUNK_CELLS (1<<22)
+
 #define PERCENTILE_MAXNUM 20
 int percentile_num = 4;
 
@@ -626,7 +629,7 @@ printf("Scaling factor: %f\n",scale);fflush(stdout);
  *    and new_percentile[] will be set
  * HISTORY:
  *    Created: 2/18/99 by Laszlo Nyul
- *    Modified:
+ *    Modified: 10/19/26 top percentile set to old_max, new_max
  *
  *****************************************************************************/
 
@@ -648,6 +651,8 @@ printf("Maximum intensity: %d\n",max_dens);fflush(stdout);
   {
     new_percentile[j] = percentile_int[j];
   }
+  old_percentile[percentile_num] = old_max;
+  new_percentile[percentile_num] = new_max;
 printf("Minimum percentile: %d\n",old_min);fflush(stdout);
 printf("Maximum percentile: %d\n",old_max);fflush(stdout);
 printf("Minimum scale: %d\n",new_min);fflush(stdout);
@@ -865,7 +870,8 @@ int size;
  * EXIT CONDITIONS:
  * HISTORY:
  *    Created: 2/18/99 by Laszlo Nyul
- *    Modified:
+ *    Modified: 10/19/26 old_percentile[percentile_num] itself
+ *       mapped to new_percentile[percentile_num]
  *
  *****************************************************************************/
 
@@ -881,6 +887,8 @@ int size;
       if (nonzero && *in == 0) *out=0;
       else if (*in < old_min) *out=new_min;
       else if (*in > old_max) *out=new_max;
+      else if (*in == old_percentile[percentile_num])
+        *out=new_percentile[percentile_num];
       else {
         for (j=1;j<=percentile_num;j++)
         {
@@ -907,6 +915,8 @@ int size;
       if (nonzero && *in == 0) *out=0;
       else if (*in < old_min) *out=new_min;
       else if (*in > old_max) *out=new_max;
+      else if (*in == old_percentile[percentile_num])
+        *out=new_percentile[percentile_num];
       else {
         for (j=1;j<=percentile_num;j++)
         {
@@ -1134,7 +1144,8 @@ int size;
  * EXIT CONDITIONS:
  * HISTORY:
  *    Created: 2/18/99 by Laszlo Nyul
- *    Modified:
+ *    Modified: 10/19/26 old_percentile[percentile_num] itself
+ *       mapped to new_percentile[percentile_num]
  *
  *****************************************************************************/
 
@@ -1151,6 +1162,8 @@ int size;
       else if (*in < old_min) *out=new_min;
       else if (*in > old_max)
         *out=(OutCellType)((double)(*in-old_percentile[percentile_num])*percentile_scale[percentile_num]+new_percentile[percentile_num]);
+      else if (*in == old_percentile[percentile_num])
+        *out=new_percentile[percentile_num];
       else {
         for (j=1;j<=percentile_num;j++)
         {
@@ -1177,6 +1190,8 @@ int size;
       else if (*in < old_min) *out=new_min;
       else if (*in > old_max)
         *out=(OutCellType)((double)(*in-old_percentile[percentile_num])*percentile_scale[percentile_num]+new_percentile[percentile_num]);
+      else if (*in == old_percentile[percentile_num])
+        *out=new_percentile[percentile_num];
       else {
         for (j=1;j<=percentile_num;j++)
         {
@@ -1276,7 +1291,8 @@ int size;
  * EXIT CONDITIONS:
  * HISTORY:
  *    Created: 3/25/04 by Ying Zhuge
- *    Modified:
+ *    Modified: 10/19/26 old_max itself mapped as in
+ *       ScaleLandmarks16
  *
  *****************************************************************************/
 
@@ -1302,7 +1318,7 @@ int size;
     {
       if (nonzero && *in == 0) *out=0;
       else if (*in < old_min) *out=new_min;
-      else if (*in > old_max)
+      else if (*in >= old_max)
 	{ 
 	  if(!extrapolate)
 	    *out=new_max;
@@ -1322,51 +1338,6 @@ int size;
   return (0);
 }
 
-/********************************************/
-int Stat16(in,size)
-unsigned short *in;
-int size;
-{
-  int i;
-
-  for(i=0;i<size;in++,i++)
-    {
-      if (*in > max_dens) max_dens= *in;
-      if (*in < min_nz_dens) {
-        min_dens= *in;
-        if (min_dens) min_nz_dens=min_dens;
-      }
-      dist[*in]++;
-      sum += *in;
-      sum_sqr += (double)(*in) * (*in);
-      count++;
-    }
-  return (0);
-}
-
-
-int Stat8(in,size)
-unsigned char *in;
-int size;
-{
-  int i;
-
-  for(i=0;i<size;in++,i++)
-    {
-      if (*in > max_dens) max_dens= *in;
-      if (*in < min_nz_dens) {
-        min_dens= *in;
-        if (min_dens) min_nz_dens=min_dens;
-      }
-      dist[*in]++;
-      sum += *in;
-      sum_sqr += (double)(*in) * (*in);
-      count++;
-    }
-  return (0);
-}
-
-
 int get_slices(dim,list)
 int dim;
 short *list;
@@ -1411,18 +1382,17 @@ int min_value, max_value;
 }
 
 
-int read_and_stat(in_fname, stat_func16, stat_func8, free_data)
+int read_and_stat(in_fname, free_data)
   char *in_fname;
-  int (*stat_func16)(unsigned short *, int);
-  int (*stat_func8)(unsigned char *, int);
   int free_data;
 {
   int i;
   FILE *in1;
   ViewnixHeader vh1;
-  int j,slices,size,size1,error,bytes;
+  int j,k,slices,size,size1,error,bytes;
   char group[6],elem[6];
   int f_slice, l_slice;
+  VSceneStats stats;
 
   in1=fopen(in_fname,"rb");
   if (in1==NULL ) {
@@ -1450,34 +1420,121 @@ int read_and_stat(in_fname, stat_func16, stat_func8, free_data)
   else
     d1_8=data1;
   d1_16=(unsigned short *)d1_8;
-  sum_sqr=0.0;sum=0.0;
-  count=0;
-  min_dens=0xFFFFFFFF;max_dens=0x0;min_nz_dens=0xFFFFFFFF;
-  memset(dist, 0, sizeof(dist));
-  VSeekData(in1,0);
-  for(i=0;i<slices;i++) {
-/*    printf("Processing slice %d\r",i); fflush(stdout);*/
-    if (VReadData((char *)data1,bytes,(int)(size1/bytes),in1,&j)) {
+  if (f_slice<=0 && l_slice>=slices-1 && (vh1.scn.num_of_bits==1 ||
+      !vh1.scn.signed_bits_valid || !vh1.scn.signed_bits[0])) {
+    /* whole scene: one pass, or none if cached */
+    if (VGetSceneFileStats(in_fname, &stats)) {
       printf("Could not read data\n");
       exit(-1);
     }
-    if (i >= f_slice && i <= l_slice) {
-      if (vh1.scn.num_of_bits==1)
-        bin_to_grey(data1,size,d1_8,0,1);
-      if (vh1.scn.num_of_bits==16)
-        (*stat_func16)(d1_16,size);
-      else
-        (*stat_func8)(d1_8,size);
+  }
+  else {
+    if (VInitSceneStats(&stats, bytes*8, 0)) {
+      printf("Out of memory\n");
+      exit(-1);
     }
+    VSeekData(in1,0);
+    for(i=0;i<slices && i<=l_slice;i++) {
+      if (VReadData((char *)data1,bytes,(int)(size1/bytes),in1,&j)) {
+        printf("Could not read data\n");
+        exit(-1);
+      }
+      if (i >= f_slice) {
+        if (vh1.scn.num_of_bits==1)
+          bin_to_grey(data1,size,d1_8,0,1);
+        VAccumulateSceneStats(&stats, d1_8, NULL, size);
+      }
+    }
+    VFinishSceneStats(&stats);
   }
   fclose(in1);
+  memset(dist, 0, sizeof(dist));
+  for (k=0; k<stats.hist_size; k++)
+    dist[k] = (unsigned int)stats.hist[k];
+  sum=stats.sum;
+  sum_sqr=stats.sum_sqr;
+  count=(unsigned int)stats.count;
+  min_dens=0xFFFFFFFF;max_dens=0x0;min_nz_dens=0xFFFFFFFF;
+  if (count) {
+    min_dens=(unsigned int)stats.min;
+    max_dens=(unsigned int)stats.max;
+    for (k=1; k<stats.hist_size; k++)
+      if (dist[k]) {
+        min_nz_dens=k;
+        break;
+      }
+  }
+  VFreeSceneStats(&stats);
   if (free_data) {
     if (d1_8!=data1) free(d1_8);
     free(data1);
   }
   return (0);
+} 
+
+/*****************************************************************************
+ * FUNCTION: map_cells16, map_cells8
+ * DESCRIPTION: maps cells through a look-up table
+ * PARAMETERS:
+ *    in: input cells
+ *    out: output cells
+ *    n: number of cells
+ *    lut: the output value of each input value
+ * SIDE EFFECTS:
+ * ENTRY CONDITIONS:
+ * RETURN VALUE:
+ * EXIT CONDITIONS:
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+
+void map_cells16(in,out,n,lut)
+unsigned short *in;
+OutCellType *out;
+long n;
+OutCellType *lut;
+{
+  long i;
+
+#pragma omp parallel for if (n >= 0x10000) schedule(static)
+  for (i=0;i<n;i++)
+    out[i]=lut[in[i]];
 }
- 
+
+
+void map_cells8(in,out,n,lut)
+unsigned char *in;
+OutCellType *out;
+long n;
+OutCellType *lut;
+{
+  long i;
+
+#pragma omp parallel for if (n >= 0x10000) schedule(static)
+  for (i=0;i<n;i++)
+    out[i]=lut[in[i]];
+}
+
+
+/*****************************************************************************
+ * FUNCTION: scale_and_write
+ * DESCRIPTION: transforms a scene with the given scale functions and
+ *    writes the result (unless dry_run is set)
+ * PARAMETERS:
+ *    in_fname, out_fname: input and output scenes
+ *    scale_func16, scale_func8: map cells of 16 and 8 (or 1) bits
+ *    free_data: free the buffers allocated by read_and_stat
+ * SIDE EFFECTS: the parameters used are printed to stdout
+ * ENTRY CONDITIONS: the parameters of the scale functions must be set
+ * RETURN VALUE:
+ * EXIT CONDITIONS: Exits with code -1 on error.
+ * HISTORY:
+ *    Modified: 10/19/26 the scale function is applied once to each
+ *       possible cell value to make a look-up table; slices are read,
+ *       mapped and written several at a time
+ *
+ *****************************************************************************/
 
 int scale_and_write(in_fname, out_fname, scale_func16, scale_func8, free_data)
   char *in_fname, *out_fname;
@@ -1488,8 +1545,11 @@ int scale_and_write(in_fname, out_fname, scale_func16, scale_func8, free_data)
   int i;
   FILE *in1,*out1;
   ViewnixHeader vh1,vh_out;
-  int j,slices,size,size1,error,bytes;
+  int j,n,slices,size,size1,error,bytes,lut_size,chunk;
   char group[6],elem[6];
+  OutCellType *lut;
+  void *ramp;
+  unsigned char *in_buf,*grey;
 
   switch (transformmethod) {
     case 0:
@@ -1587,8 +1647,42 @@ int scale_and_write(in_fname, out_fname, scale_func16, scale_func8, free_data)
     else
       bytes=1;
     size1= (size*vh1.scn.num_of_bits+7)/8;
-    VSeekData(in1,0);
-    out_data = (OutCellType *)malloc(size*sizeof(OutCellType));
+
+    /* the scale functions map each cell on its own, so map every
+       possible value once and look the cells up */
+    lut_size = bytes==2? 0x10000: 0x100;
+    lut = (OutCellType *)calloc(lut_size, sizeof(OutCellType));
+    ramp = malloc(lut_size*bytes);
+    if (lut==NULL || ramp==NULL) {
+      printf("Out of memory\n");
+      exit(-1);
+    }
+    for (i=0; i<lut_size; i++)
+      if (bytes == 2)
+        ((unsigned short *)ramp)[i] = (unsigned short)i;
+      else
+        ((unsigned char *)ramp)[i] = (unsigned char)i;
+    if (bytes == 2)
+      (*scale_func16)((unsigned short *)ramp,lut,lut_size);
+    else
+      (*scale_func8)((unsigned char *)ramp,lut,lut_size);
+    free(ramp);
+
+    /* read, map and write as many slices at a time as fit in
+       SCALE_CHUNK_CELLS (a slice at a time for binary scenes) */
+    chunk = vh1.scn.num_of_bits==1 || size>=SCALE_CHUNK_CELLS?
+      1: SCALE_CHUNK_CELLS/size;
+    if (chunk > slices)
+      chunk = slices;
+    if (chunk < 1)
+      chunk = 1;
+    in_buf = (unsigned char *)malloc((size_t)chunk*size1+1);
+    grey = vh1.scn.num_of_bits==1? (unsigned char *)malloc(size): in_buf;
+    out_data = (OutCellType *)malloc((size_t)chunk*size*sizeof(OutCellType));
+    if (in_buf==NULL || grey==NULL || out_data==NULL) {
+      printf("Out of memory\n");
+      exit(-1);
+    }
     memcpy(&vh_out, &vh1, sizeof(vh1));
     strncpy(vh_out.gen.filename, out_fname, sizeof(vh_out.gen.filename));
     vh_out.scn.smallest_density_value[0] = 0;
@@ -1603,24 +1697,27 @@ int scale_and_write(in_fname, out_fname, scale_func16, scale_func8, free_data)
     out1 = fopen(out_fname,"wb");
     VWriteHeader(out1, &vh_out, group, elem);
     VSeekData(in1,0);
-    for(i=0;i<slices;i++) {
-      /*    printf("Processing slice %d\r",i); fflush(stdout);*/
-      if (VReadData((char *)data1,bytes,(int)(size1/bytes),in1,&j)) {
+    for(i=0;i<slices;i+=n) {
+      n = slices-i<chunk? slices-i: chunk;
+      if (VReadData((char *)in_buf,bytes,(int)((long)n*size1/bytes),in1,&j)) {
         printf("Could not read data\n");
         exit(-1);
       }
-      if (vh1.scn.num_of_bits==1) 
-        bin_to_grey(data1,size,d1_8,0,1);
-      if (vh1.scn.num_of_bits==16)
-        (*scale_func16)(d1_16,out_data,size);
+      if (vh1.scn.num_of_bits==1)
+        bin_to_grey(in_buf,size,grey,0,1);
+      if (bytes == 2)
+        map_cells16((unsigned short *)in_buf,out_data,(long)n*size,lut);
       else
-        (*scale_func8)(d1_8,out_data,size);
-      //(*scale_func8)(data1,out_data,size);
-      VWriteData((char *)out_data, sizeof(OutCellType), size, out1, &j);
+        map_cells8(grey,out_data,(long)n*size,lut);
+      VWriteData((char *)out_data, sizeof(OutCellType), n*size, out1, &j);
     }
     VCloseData(out1);
     fclose(in1);
     free(out_data);
+    if (grey != in_buf)
+      free(grey);
+    free(in_buf);
+    free(lut);
   }
   if (free_data) {
     if (d1_8!=data1) free(d1_8);
@@ -1680,7 +1777,7 @@ int read_paramfile(fname)
       sscanf(line+19, "%f", &minage);
     }
     if (!strncmp(line, "Maximum percentage:", 19)) {
-      sscanf(line+18, "%f", &maxage);
+      sscanf(line+19, "%f", &maxage);
     }
     if (!strncmp(line, "Minimum scale:", 14)) {
       sscanf(line+14, "%d", &new_min);
@@ -1946,7 +2043,7 @@ char *argv[];
       mean_mode=0;
       for (; k<argc; k++) {
 	printf("Processing file %s\n",argv[k]);fflush(stdout);
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
         volume_mean= (unsigned)(sum/count);
 	printf("Volume mean: %d\n", volume_mean);fflush(stdout);
         find_threshold();
@@ -1967,7 +2064,7 @@ char *argv[];
       mean_mode=0;
       for (; k<argc; k++) {
 	printf("Processing file %s\n",argv[k]);fflush(stdout);
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
         find_histmode();
 	printf("Mode: %d\n", old_mode);fflush(stdout);
 	printf("Scaled mode: %d\n", scaled_mode);fflush(stdout);
@@ -1981,7 +2078,7 @@ char *argv[];
       mean_mode=0;
       for (; k<argc; k++) {
 	printf("Processing file %s\n",argv[k]);fflush(stdout);
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
         volume_mean= (unsigned)(sum/count);
 	printf("Volume mean: %d\n", volume_mean);fflush(stdout);
         find_threshold2();
@@ -2002,7 +2099,7 @@ char *argv[];
       mean_median=0;
       for (; k<argc; k++) {
 	printf("Processing file %s\n",argv[k]);fflush(stdout);
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
         volume_mean= (unsigned)(sum/count);
 	printf("Volume mean: %d\n", volume_mean);fflush(stdout);
         find_threshold();
@@ -2026,7 +2123,7 @@ char *argv[];
       }
       for (; k<argc; k++) {
 	printf("Processing file %s\n",argv[k]);fflush(stdout);
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
         volume_mean= (unsigned)(sum/count);
 	printf("Volume mean: %d\n", volume_mean);fflush(stdout);
         find_threshold();
@@ -2062,7 +2159,7 @@ char *argv[];
         printf("Processing file %s\n",argv[k]);fflush(stdout);
 
         /* get maximum and minimum density */
-        read_and_stat(argv[k],Stat16,Stat8,1);
+        read_and_stat(argv[k],1);
 
         /* get percentile maximum and minimum density      */
         /* and save to old_min and old_max, get scale also */
@@ -2231,8 +2328,9 @@ char *argv[];
  *    printed to stdout
  * ENTRY CONDITIONS: argc and argv should be given according to the
  *    Usage 2 message
- * RETURN VALUE: None
- * EXIT CONDITIONS: Exits with code -1 on error.
+ * RETURN VALUE: 0, or -1 if the image is not transformed because scaling
+ *    would merge intensities
+ * EXIT CONDITIONS: Exits with code -1 on other errors.
  * HISTORY:
  *    Created: 11/19/97 by Laszlo Nyul
  *    Modified: 11/25/97 new method parameter (3) added by Laszlo Nyul
@@ -2242,6 +2340,7 @@ char *argv[];
  *    Modified: 6/18/98 new method parameter (4) added by Laszlo Nyul
  *    Modified: 2/18/99 new method parameters (6,7) added by Laszlo Nyul
  *    Modified: 9/28/99 Scalefullextra added by Laszlo Nyul
+ *    Modified: 10/19/26 returns instead of exiting on intensity merges
  *
  *****************************************************************************/
  
@@ -2270,7 +2369,7 @@ char *argv[];
   switch (transformmethod) {
     case 0:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode();
       scale=(float)((double)(new_max-new_min)/NONZERO_OR_ONE(old_max-old_min));
       if (scale < 1.0) {
@@ -2279,8 +2378,8 @@ char *argv[];
         } else if (force_merge) {
           printf("Scaling factor < 1.0; force scaling with intensity merge\n");fflush(stdout);
         } else {
-          printf("Scaling factor < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
-          exit(-1);
+          printf("Scaling factor < 1.0; not scaling with intensity merge\n");fflush(stdout);
+          return (-1);
         }
         if (auto_rescale) {
           range_save = new_max-new_min;
@@ -2304,7 +2403,7 @@ char *argv[];
       break;
     case 1:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       volume_mean= (unsigned)(sum/count);
       printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2336,12 +2435,12 @@ char *argv[];
           }
         } else {
           if (lscale < 1.0) {
-            printf("Scaling factor 1 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 1 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
           if (rscale < 1.0) {
-            printf("Scaling factor 2 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 2 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
-          exit(-1);
+          return (-1);
         }
         if (auto_rescale) {
           range_save = new_max-new_min;
@@ -2367,7 +2466,7 @@ char *argv[];
       break;
     case 2:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode();
       printf("Mode: %d\n", old_mode);fflush(stdout);
       printf("Scaled mode: %d\n", scaled_mode);fflush(stdout);
@@ -2392,12 +2491,12 @@ char *argv[];
           }
         } else {
           if (lscale < 1.0) {
-            printf("Scaling factor 1 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 1 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
           if (rscale < 1.0) {
-            printf("Scaling factor 2 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 2 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
-          exit(-1);
+          return (-1);
         }
         if (auto_rescale) {
           range_save = new_max-new_min;
@@ -2423,7 +2522,7 @@ char *argv[];
       break;
     case 3:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       volume_mean=(unsigned)(sum/count);
       printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold2();
@@ -2455,12 +2554,12 @@ char *argv[];
           }
         } else {
           if (lscale < 1.0) {
-            printf("Scaling factor 1 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 1 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
           if (rscale < 1.0) {
-            printf("Scaling factor 2 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 2 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
-          exit(-1);
+          return (-1);
         }
         if (auto_rescale) {
           range_save = new_max-new_min;
@@ -2480,7 +2579,7 @@ char *argv[];
       break;
     case 4:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       volume_mean= (unsigned)(sum/count);
       printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2512,12 +2611,12 @@ char *argv[];
           }
         } else {
           if (lscale < 1.0) {
-            printf("Scaling factor 1 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 1 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
           if (rscale < 1.0) {
-            printf("Scaling factor 2 < 1.0; not scaling with intensity merge; exiting\n");fflush(stdout);
+            printf("Scaling factor 2 < 1.0; not scaling with intensity merge\n");fflush(stdout);
           }
-          exit(-1);
+          return (-1);
         }
         if (auto_rescale) {
           range_save = new_max-new_min;
@@ -2543,7 +2642,7 @@ char *argv[];
       break;
     case 5:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       volume_mean= (unsigned)(sum/count);
       printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2568,6 +2667,7 @@ char *argv[];
       old_percentile[percentile_num] = old_max;
       mean_percentile[0] = new_min;
       mean_percentile[percentile_num] = new_max;
+      new_percentile[0] = mean_percentile[0];
       for (j=1;j<=percentile_num;j++)
       {
         new_percentile[j] = mean_percentile[j];
@@ -2601,8 +2701,8 @@ char *argv[];
           {
             if (percentile_scale[j] < 1.0)
             {
-              printf("Scaling factor %d < 1.0; not scaling with intensity merge; exiting\n", j);fflush(stdout);
-            exit(-1);
+              printf("Scaling factor %d < 1.0; not scaling with intensity merge\n", j);fflush(stdout);
+            return (-1);
             }
           }
         }
@@ -2645,7 +2745,7 @@ char *argv[];
     case 6:
       k=filename_arg_start;
       printf("Processing file %s\n",argv[k]);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       volume_mean=(unsigned)(sum/count);
       printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2728,8 +2828,8 @@ char *argv[];
           {
             if (landmarks_scale[j] < 1.0)
             {
-              printf("Scaling factor %d < 1.0; not scaling with intensity merge; exiting\n", j);fflush(stdout);
-            exit(-1);
+              printf("Scaling factor %d < 1.0; not scaling with intensity merge\n", j);fflush(stdout);
+            return (-1);
             }
           }
         }
@@ -2784,7 +2884,7 @@ char *argv[];
 
     case 0+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode_i();
       scale=(float)((double)(new_max-new_min)/NONZERO_OR_ONE(old_max-old_min));
       /*printf("Scaling factor: %f\n",scale);*/
@@ -2792,7 +2892,7 @@ char *argv[];
       break;
     case 1+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode_i();
       printf("Mode: %d\n", old_mode);fflush(stdout);
       printf("Scaled mode: %d\n", new_mode);fflush(stdout);
@@ -2804,7 +2904,7 @@ char *argv[];
       break;
     case 2+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode_i();
       printf("Mode: %d\n", old_mode);fflush(stdout);
       printf("Scaled mode: %d\n", new_mode);fflush(stdout);
@@ -2816,7 +2916,7 @@ char *argv[];
       break;
     case 3+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmode2_i();
       printf("Mode: %d\n", old_mode);fflush(stdout);
       printf("Scaled mode: %d\n", new_mode);fflush(stdout);
@@ -2828,7 +2928,7 @@ char *argv[];
       break;
     case 4+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histmedian_i();
       printf("Median: %d\n", old_median);fflush(stdout);
       printf("Scaled median: %d\n", new_median);fflush(stdout);
@@ -2840,7 +2940,7 @@ char *argv[];
       break;
     case 5+INVERSE_METHOD:
       printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,0);
+      read_and_stat(filename_in,0);
       find_histpercentile_i();
       for (j=1;j<percentile_num;j++)
       {
@@ -2865,6 +2965,114 @@ char *argv[];
 }
 
 
+/*****************************************************************************
+ * FUNCTION: run_apply_all
+ * DESCRIPTION: transforms each input image given: the files are groups of
+ *    <input IM0 file> <output IM0 file> [BIM file1 BIM file2 ...], each
+ *    done as run_apply does one.  An image that run_apply does not
+ *    transform is reported, and the rest are still done.
+ * PARAMETERS:
+ * SIDE EFFECTS: as of run_apply
+ * ENTRY CONDITIONS: argc and argv should be given according to the
+ *    Usage 2 message
+ * RETURN VALUE: the number of images not transformed
+ * EXIT CONDITIONS: Exits with code -1 on other errors.
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+
+int run_apply_all(argc,argv)
+int argc;
+char *argv[];
+{
+  int start, files, failed;
+
+  start = filename_arg_start;
+  failed = 0;
+  while (filename_arg_start < argc) {
+    /* the parameter file says how many BIM files follow each pair */
+    if (read_paramfile(paramfile_in))
+      exit(-1);
+    files = 2 + (transformmethod==6? num_landmarks: 0);
+    /* find_threshold2 keeps the threshold of the previous scene;
+       start each one afresh, as a run of its own would */
+    threshold = 0;
+    if (filename_arg_start+files > argc) {
+      printf("Missing files after %s\n", argv[filename_arg_start]);
+      exit(-1);
+    }
+    if (run_apply(argc, argv)) {
+      printf("Not transformed: %s\n", argv[filename_arg_start]);fflush(stdout);
+      failed++;
+    }
+    filename_arg_start += files;
+  }
+  filename_arg_start = start;
+  if (failed && files<argc-start) {
+    printf("%d of %d images not transformed\n", failed, (argc-start)/files);
+    fflush(stdout);
+  }
+  return (failed);
+}
+
+
+/*****************************************************************************
+ * FUNCTION: run_standardize
+ * DESCRIPTION: standardizes a set of images in one run: trains on all the
+ *    input images, writes the parameter file, and transforms each input
+ *    image with it.  The statistics of each scene are computed once (and
+ *    kept in the scene statistics cache), so applying does not read the
+ *    scenes again for them.
+ * PARAMETERS:
+ * SIDE EFFECTS: as of run_train and run_apply
+ * ENTRY CONDITIONS: argc and argv should be given according to the
+ *    Usage 4 message
+ * RETURN VALUE: the number of images not transformed
+ * EXIT CONDITIONS: Exits with code -1 on other errors.
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+
+int run_standardize(argc,argv)
+int argc;
+char *argv[];
+{
+  char **train_argv;
+  int files, k, j, n, start;
+
+  files = 2 + (transformmethod==6? num_landmarks: 0);
+  if ((argc-filename_arg_start)%files) {
+    printf("Each input IM0 file needs an output IM0 file");
+    if (transformmethod == 6)
+      printf(" and %d BIM files", num_landmarks);
+    printf("\n");
+    exit(-1);
+  }
+
+  /* train on the input (and BIM) files, leaving out the outputs */
+  train_argv = (char **)malloc(argc*sizeof(char *));
+  if (train_argv == NULL) {
+    printf("Out of memory\n");
+    exit(-1);
+  }
+  for (n=0,k=filename_arg_start; k<argc; k+=files) {
+    train_argv[n++] = argv[k];
+    for (j=2; j<files; j++)
+      train_argv[n++] = argv[k+j];
+  }
+  start = filename_arg_start;
+  filename_arg_start = 0;
+  run_train(n, train_argv);
+  free(train_argv);
+
+  filename_arg_start = start;
+  paramfile_in = paramfile_out;
+  return (run_apply_all(argc, argv));
+}
+
+
 /*****************************************************************************
  * FUNCTION: run_inverse
  * DESCRIPTION: Gets histogram landmarks from a parameter file and an image
@@ -2896,12 +3104,12 @@ printf("Method: %d\n", transformmethod);fflush(stdout);
   switch (transformmethod) {
     case 0:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       find_histmode();
       break;
     case 1:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       volume_mean= (unsigned)(sum/count);
 printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2916,7 +3124,7 @@ printf("Mode mean: %d\n", mean_mode);fflush(stdout);
       break;
     case 2:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       find_histmode();
 printf("Mode: %d\n", old_mode);fflush(stdout);
 printf("Scaled mode: %d\n", scaled_mode);fflush(stdout);
@@ -2924,7 +3132,7 @@ printf("Mode mean: %d\n", mean_mode);fflush(stdout);
       break;
     case 3:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       volume_mean= (unsigned)(sum/count);
 printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold2();
@@ -2939,7 +3147,7 @@ printf("Mode mean: %d\n", mean_mode);fflush(stdout);
       break;
     case 4:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       volume_mean= (unsigned)(sum/count);
 printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -2954,7 +3162,7 @@ printf("Median mean: %d\n", mean_median);fflush(stdout);
       break;
     case 5:
 printf("Processing file %s\n",filename_in);fflush(stdout);
-      read_and_stat(filename_in,Stat16,Stat8,1);
+      read_and_stat(filename_in,1);
       volume_mean= (unsigned)(sum/count);
 printf("Volume mean: %d\n", volume_mean);fflush(stdout);
       find_threshold();
@@ -3130,7 +3338,8 @@ void usage()
     printf("<first slice>       first slice to use in histogram computation (in percentage of the total number of slices, default = 0)\n");
     printf("<last slice>        last slice to use in histogram computation (in percentage of the total number of slices, default = 100)\n");
     printf("\n");
-    printf("Usage 2: mrscaleprog -apply [-force_merge | -auto_rescale] [-extrapolate | -no_extrapolate] [-dry_run] -paramfile_in <parameter file> -files <input IM0 file> <output IM0 file> [BIM file1 BIM file2 ...]\n");
+    printf("Usage 2: mrscaleprog -apply [-force_merge | -auto_rescale] [-extrapolate | -no_extrapolate] [-dry_run] -paramfile_in <parameter file> -files <input IM0 file> <output IM0 file> [BIM file1 BIM file2 ...] ...\n");
+    printf("each group of files given is transformed in turn\n");
     printf("<parameter file>    name of the file containing the parameters (generated by this program using -train mode)\n");
     printf("<input IM0 file>    name of the input file containing the original image\n");
     printf("<output IM0 file>   name of the output file storing the transformed image\n");
@@ -3145,6 +3354,9 @@ void usage()
     printf("<parameter file>    name of the file containing the parameters\n");
     printf("<output parameter file>     name of the output file storing the parameters of the inverse transform\n");
     printf("<input IM0 file>    name of the input file containing the original image\n");
+    printf("\n");
+    printf("Usage 4: mrscaleprog -standardize <the options of Usage 1> [<the options of Usage 2>] -paramfile_out <parameter file> -files <input IM0 file> <output IM0 file> [BIM file1 BIM file2 ...] ...\n");
+    printf("trains on all the input files (as Usage 1), then transforms each of them with the parameters (as Usage 2), in one run\n");
     exit(1);
 }
 
@@ -3174,6 +3386,12 @@ void parse_commandline(argc, argv)
       paramfile_in_r = 1;
     }
     else
+    if (strcmp(argv[args_parsed], "-standardize") == 0) {
+      args_parsed++;
+      runmode = 4;
+      paramfile_out_r = 1;
+    }
+    else
     if (strcmp(argv[args_parsed], "-inverse") == 0) {
       args_parsed++;
       runmode = 3;
@@ -3401,15 +3619,18 @@ void parse_commandline(argc, argv)
  *    In mode 2. it applies the actual transformation to an image.
  *    In mode 3. it creates the inverse parameter file from a parameter
  *               file and an image.
+ *    In mode 4. it trains on a set of images and transforms each of them.
  * PARAMETERS:
  *    argc, argv
  * SIDE EFFECTS:
  * ENTRY CONDITIONS:
  * RETURN VALUE: None
- * EXIT CONDITIONS: Exits with 0 on normal completion.
+ * EXIT CONDITIONS: Exits with 0 on normal completion, -1 if any image
+ *    was not transformed.
  * HISTORY:
  *    Created: 11/19/97 by Laszlo Nyul
  *    Modified: 5/6/98 running mode 3 added by Laszlo Nyul
+ *    Modified: 10/19/26 running mode 4 added
  *
  *****************************************************************************/
 
@@ -3423,11 +3644,16 @@ char *argv[];
       run_train(argc, argv);
       break;
     case 2:
-      run_apply(argc, argv);
+      if (run_apply_all(argc, argv))
+        exit(-1);
       break;
     case 3:
       run_inverse(argc, argv);
       break;
+    case 4:
+      if (run_standardize(argc, argv))
+        exit(-1);
+      break;
   }
   exit(0);
 }
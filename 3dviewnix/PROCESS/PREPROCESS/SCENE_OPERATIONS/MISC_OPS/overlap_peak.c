@@ -24,6 +24,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 #include <cv3dv.h>
 #include <assert.h>
+#include "translation_search.h"
 
 #define MAX_NUM_FEATURES 7 
 #define MAX_NUM_TRANSFORMS 6 
@@ -49,6 +50,8 @@ int get_slices(int dim, short *list);
 unsigned short edge_cost(int a, int b, int c, int d, int e, int f);
 void LoadFeatureList(const char *feature_def_file, int object_number);
 float fld_edge_cost(int a, int b, int c, int d, int e, int f);
+void add_overlap(unsigned char *model, int bytes, ViewnixHeader *vh1,
+  int slic1, unsigned char *image, ViewnixHeader *vh2, int slic2);
 
 
 struct FeatureList temp_list[MAX_NUM_FEATURES];
@@ -57,6 +60,10 @@ int Range;
 int fld_flag;
 float fld_weight[3];
 
+/* overlap of the models with the images over the box of offsets */
+int Box_start[3], Box_size[3];
+double *Overlap, Model_sum, Bin_volume;
+
 int main(argc,argv)
 int argc;
 char *argv[];
@@ -72,7 +79,7 @@ char *argv[];
 	all_edges=FALSE, xor_flag=FALSE, y_step=1, Start_y_offset, End_z_offset,
 	End_y_offset, inout_flag=FALSE, num_objects=1, cur_object, multi_flag=0,
 	options;
-  double total, best_total, deviation, bin_volume=0, inout_total, outin_total;
+  double total, best_total, deviation, inout_total, outin_total, overlap;
   double xsharp=1, ysharp=1, zsharp=1;
   ViewnixHeader *vh1, *vh2;
   FILE *in1,*in2, *outstream;
@@ -83,7 +90,6 @@ char *argv[];
   unsigned short **t_nedges, **l_nedges, ***t_edge, ***l_edge, *temp_edge2;
   unsigned short **b_nedges, **r_nedges, ***b_edge, ***r_edge;
   char ***h_edge_dir, ***v_edge_dir;
-  unsigned short ***data2_rle, **rle_buf;
 
 #define Handle_error(message) \
 { \
@@ -156,14 +162,27 @@ char *argv[];
   vh1 = (ViewnixHeader *)calloc(num_objects, sizeof(*vh1));
   vh2 = (ViewnixHeader *)calloc(num_objects, sizeof(*vh2));
   data1 = (unsigned char **)malloc(num_objects*sizeof(*data1));
-  data2_rle = (unsigned short ***)malloc(num_objects*sizeof(*data2_rle));
-  rle_buf = (unsigned short **)malloc(num_objects*sizeof(*rle_buf));
 
   best_x_offset = start_x_offset;
   best_y_offset = start_y_offset;
   best_z_offset = start_z_offset;
   best_total = 0;
 
+  /* The -xors refinement looks one row beyond the box. */
+  Box_start[0] = start_x_offset;
+  Box_start[1] = start_y_offset-(y_step==3);
+  Box_start[2] = start_z_offset;
+  Box_size[0] = end_x_offset-start_x_offset+1;
+  Box_size[1] = end_y_offset-start_y_offset+1+2*(y_step==3);
+  Box_size[2] = end_z_offset-start_z_offset+1;
+  if (!options)
+  {
+    Overlap = (double *)
+      calloc(Box_size[0]*Box_size[1]*Box_size[2], sizeof(double));
+    if (Overlap == NULL)
+      Handle_error("Out of memory.");
+  }
+
 
   for (cur_object=0; cur_object<num_objects; cur_object++)
   {
@@ -557,57 +576,13 @@ char *argv[];
     fclose(in2);
 
     if (xor_flag || inout_flag)
-    {
       best_total += 65534.*size2*slic2+65534.*size1*slic1;
-      data2_rle[cur_object] = (unsigned short **)malloc(
-        vh2->scn.xysize[1]*slic2*sizeof(unsigned short *));
-      rle_buf[cur_object] =
-	    (unsigned short *)malloc((vh2->scn.xysize[0]+1)*sizeof(short));
-      if (data2_rle[cur_object]==NULL || rle_buf[cur_object]==NULL)
-        Handle_error("Out of memory.");
-      for (z2=j=0; z2<slic2; z2++)
-      {
-        int xbyte=(size2+7)/8*z2, mask=128, slice_volume=0,
-		  byteval=data2[xbyte];
-
-        for (y2=0; y2<vh2->scn.xysize[1]; y2++,j++)
-        {
-          int runs=0;
-          for (x2=0; x2<vh2->scn.xysize[0]; x2++)
-          {
-            if (byteval & mask)
-            {
-              slice_volume++;
-              if ((runs&1) == 0)
-                rle_buf[cur_object][runs++] = x2;
-            }
-            else
-            {
-              if (runs & 1)
-                rle_buf[cur_object][runs++] = x2;
-            }
-            mask >>= 1;
-            if (mask == 0)
-            {
-              mask = 128;
-              xbyte++;
-              byteval = data2[xbyte];
-            }
-          }
-          if (runs & 1)
-            rle_buf[cur_object][runs++] = vh2->scn.xysize[0];
-          rle_buf[cur_object][runs++] = 65535;
-          data2_rle[cur_object][j] =
-		    (unsigned short *)malloc(runs*sizeof(short));
-          if (data2_rle[cur_object][j] == NULL)
-            Handle_error("Out of memory.");
-          memcpy(data2_rle[cur_object][j], rle_buf[cur_object],
-		    runs*sizeof(short));
-        }
-        bin_volume += slice_volume;
-      }
-    }
+    if (!options && (xor_flag || inout_flag))
+      add_overlap(data1[cur_object], bytes1, vh1+cur_object, slic1, data2,
+        vh2+cur_object, slic2);
   }
+  if (!options && !xor_flag && !inout_flag)
+    add_overlap(data1[0], bytes1, vh1, slic1, data2, vh2, slic2);
 
   if (end_x_offset > start_x_offset)
     xsharp = 4./((end_x_offset-start_x_offset)*
@@ -633,52 +608,19 @@ char *argv[];
     	x_start = x_offset<0? 0:x_offset;
     	x_stop = vh1->scn.xysize[0]+x_offset<vh2->scn.xysize[0]?
     	         vh1->scn.xysize[0]+x_offset:vh2->scn.xysize[0];
-        if (xor_flag)
-    	{
-          if (x_offset == start_x_offset)
-          {
-            total = 65534*bin_volume;
-            for (cur_object=0; cur_object<num_objects; cur_object++)
-              for (z1=0; z1<slic1; z1++)
-                for (y1=0; y1<vh1->scn.xysize[1]; y1++)
-                  for (x1=0; x1<vh1->scn.xysize[0]; )
-                  {
-                    if (z1+z_offset>=0 && z1+z_offset<slic2 &&
-                        y1+y_offset>=0 && y1+y_offset<vh2->scn.xysize[1] &&
-                        x1+x_offset>=0 && x1+x_offset<vh2->scn.xysize[0])
-                    {
-                      x1 = vh2->scn.xysize[0]-x_offset;
-                      continue;
-                    }
-                    total += ((unsigned short *)data1[cur_object])
-                      [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                    x1++;
-                  }
-          }
-        }
-        else if (inout_flag)
+        if (!options)
         {
-          if (x_offset == start_x_offset)
+          overlap = Overlap[((z_offset-Box_start[2])*Box_size[1]+
+            y_offset-Box_start[1])*Box_size[0]+x_offset-Box_start[0]];
+          if (xor_flag)
+            total = 65534*Bin_volume+Model_sum-2*overlap;
+          else if (inout_flag)
           {
-            inout_total = 0;
-            for (cur_object=0; cur_object<num_objects; cur_object++)
-              for (z1=0; z1<slic1; z1++)
-                for (y1=0; y1<vh1->scn.xysize[1]; y1++)
-                  for (x1=0; x1<vh1->scn.xysize[0]; )
-                  {
-                    if (z1+z_offset>=0 && z1+z_offset<slic2 &&
-                        y1+y_offset>=0 && y1+y_offset<vh2->scn.xysize[1] &&
-                        x1+x_offset>=0 && x1+x_offset<vh2->scn.xysize[0])
-                    {
-                      x1 = vh2->scn.xysize[0]-x_offset;
-                      continue;
-                    }
-                    inout_total += ((unsigned short *)data1[cur_object])
-                      [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                    x1++;
-                  }
-            outin_total = 65534*bin_volume;
+            inout_total = Model_sum-overlap;
+            outin_total = 65534*Bin_volume-overlap;
           }
+          else
+            total = overlap;
         }
         else
           total = 0;
@@ -1145,137 +1087,6 @@ char *argv[];
           }
 
          }
-         else // !options
-         if (xor_flag)
-         {
-		  for (cur_object=0; cur_object<num_objects; cur_object++)
-		  {
-           j = z2*vh2->scn.xysize[1]+y_start;
-           for (y1=(y2=y_start)-y_offset; y2<y_stop; y2++,y1++,j++)
-           {
-             int row_total=0, runs=0, isin;
-             if (x_offset == start_x_offset)
-             {
-               for (isin=0; data2_rle[cur_object][j][runs]<x_start; isin= !isin)
-                 runs++;
-               for (x1=(x2=x_start)-x_offset; x2<x_stop; x2++,x1++)
-               {
-                 int val1=((unsigned short *)data1[cur_object])
-                   [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                 if (data2_rle[cur_object][j][runs] == x2)
-                 {
-                   runs++;
-                   isin = !isin;
-                 }
-                 if (val1)
-                   row_total += isin? -val1: val1;
-               }
-             }
-             else
-             {
-               for (isin=1; (x2=data2_rle[cur_object][j][runs]) < x_stop; runs++,isin=
-                   !isin)
-               {
-                 int val1;
-                 if (x2 < x_start)
-                   continue;
-                 x1 = x2-x_offset;
-                 val1 = ((unsigned short *)data1[cur_object])
-                   [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                 if (val1)
-                   row_total += 2*(isin? -val1: val1);
-               }
-             }
-             total += row_total;
-           }
-		  }
-         }
-         else // !xor_flag
-         if (inout_flag)
-         {
-		  for (cur_object=0; cur_object<num_objects; cur_object++)
-		  {
-           j = z2*vh2->scn.xysize[1]+y_start;
-           for (y1=(y2=y_start)-y_offset; y2<y_stop; y2++,y1++,j++)
-           {
-             int row_inout=0, row_outin=0, runs=0, isin;
-             if (x_offset == start_x_offset)
-             {
-               for (isin=0; data2_rle[cur_object][j][runs]<x_start; isin= !isin)
-                 runs++;
-               for (x1=(x2=x_start)-x_offset; x2<x_stop; x2++,x1++)
-               {
-                 int val1=((unsigned short *)data1[cur_object])
-                   [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                 if (data2_rle[cur_object][j][runs] == x2)
-                 {
-                   runs++;
-                   isin = !isin;
-                 }
-                 if (val1)
-                 {
-                   if (isin)
-                     row_outin -= val1;
-                   else
-                     row_inout += val1;
-                 }
-               }
-             }
-             else
-             {
-               for (isin=1; (x2=data2_rle[cur_object][j][runs]) < x_stop; runs++,isin=
-                   !isin)
-               {
-                 int val1;
-                 if (x2 < x_start)
-                   continue;
-                 x1 = x2-x_offset;
-                 val1 = ((unsigned short *)data1[cur_object])
-                   [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                 if (val1)
-                 {
-                   if (isin)
-                     row_outin -= 2*val1;
-                   else
-                     row_inout += 2*val1;
-                 }
-               }
-             }
-             inout_total += row_inout;
-             outin_total += row_outin;
-           }
-		  }
-         }
-         else // !xor_flag && !inout_flag
-         {
-          int xbyte=(size2+7)/8*z2+(vh2->scn.xysize[0]*y_start+x_start)/8;
-          int mask=128>>((vh2->scn.xysize[0]*y_start+x_start)%8);
-          int byte2val=data2[xbyte];
-          for (y1=(y2=y_start)-y_offset; y2<y_stop; y2++,y1++)
-          {
-            int row_total=0;
-            for (x1=(x2=x_start)-x_offset; x2<x_stop; x2++,x1++)
-            {
-              if (byte2val & mask)
-              {
-                if (bytes1 == 2)
-                  row_total += ((unsigned short *)data1[0])
-                    [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-                else
-                  row_total += data1[0]
-                    [(z1*vh1->scn.xysize[1]+y1)*vh1->scn.xysize[0]+x1];
-              }
-              mask >>= 1;
-              if (mask == 0)
-              {
-                  mask = 128;
-                xbyte++;
-                byte2val = data2[xbyte];
-              }
-            }
-            total += row_total;
-          }
-         }
         if (options)
         {
           if (edge_count && (first_pass || (total>0? (1+loc_penalty*deviation):
@@ -1348,6 +1159,53 @@ char *argv[];
   exit(0);
 }
 
+/*****************************************************************************
+ * FUNCTION: add_overlap
+ * DESCRIPTION: Adds the overlap of a model scene with a binary scene at each
+ *    offset of the search box to Overlap, and the model sum and binary
+ *    volume to Model_sum and Bin_volume.
+ * PARAMETERS:
+ *    model: The model scene data.
+ *    bytes: Bytes per voxel of the model scene, 1 or 2.
+ *    vh1: The model scene header.
+ *    slic1: The number of slices of the model scene.
+ *    image: The binary scene data.
+ *    vh2: The binary scene header.
+ *    slic2: The number of slices of the binary scene.
+ * SIDE EFFECTS: Exits on memory allocation failure.
+ * ENTRY CONDITIONS: Box_start, Box_size, Overlap must be initialized.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void add_overlap(unsigned char *model, int bytes, ViewnixHeader *vh1,
+  int slic1, unsigned char *image, ViewnixHeader *vh2, int slic2)
+{
+  TSPair pair;
+  int end[3], j;
+
+  pair.model = model;
+  pair.model_bits = 8*bytes;
+  pair.model_size[0] = vh1->scn.xysize[0];
+  pair.model_size[1] = vh1->scn.xysize[1];
+  pair.model_size[2] = slic1;
+  pair.image = image;
+  pair.image_size[0] = vh2->scn.xysize[0];
+  pair.image_size[1] = vh2->scn.xysize[1];
+  pair.image_size[2] = slic2;
+  for (j=0; j<3; j++)
+    end[j] = Box_start[j]+Box_size[j]-1;
+  if (ts_overlap_box(&pair, Box_start, end, 1, Overlap))
+  {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+  Model_sum += ts_model_sum(&pair);
+  Bin_volume += ts_image_count(&pair);
+}
+
 /*****************************************************************************
  * FUNCTION: get_slices
  * DESCRIPTION: Returns total number of slices in a scene.
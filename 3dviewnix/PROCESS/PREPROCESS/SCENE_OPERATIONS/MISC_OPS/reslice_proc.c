@@ -699,6 +699,7 @@ void InitHeader(char *outfile, ViewnixHeader *vh, ViewnixHeader *outvh,
  *    Modified: 9/15/94 to make non-square slices by Dewey Odhner
  *    Modified: 9/15/94 to go faster with data in memory by Dewey Odhner
  *    Modified: 10/2/03 nearest neighbor option added by Dewey Odhner
+ *    Modified: 10/19/26 binary data kept packed in memory
  *
  *****************************************************************************/
 int ResliceData(ViewnixHeader *vh, int out_slices, int plane_size[2],
@@ -707,16 +708,17 @@ int ResliceData(ViewnixHeader *vh, int out_slices, int plane_size[2],
     int vhlen, int interp)
 {
   short *pl_slice_map;
-  int i, j, bin_bytes_per_slice, bin_out_bytes_per_slice, num, slice;
+  int i, j, bin_bytes_per_slice, bin_out_bytes_per_slice, num,
+    in_bytes_per_slice;
   double cur_ends[3][3], diff[3];
   unsigned char *tmp_out_data, *out_data, *in_data, *tmp_in_data;
 
-  in_data = (unsigned char  *)malloc((slices+2)*bytes_per_slice);
-  if (in_data) {
+  /* Binary scenes are kept packed in memory. */
+  in_bytes_per_slice = vh->scn.num_of_bits==1? (bytes_per_slice+7)/8:
+    bytes_per_slice;
+  in_data = (unsigned char  *)malloc((size_t)slices*in_bytes_per_slice);
+  if (in_data)
     pl_slice_map = NULL;
-    memset(in_data, 0, bytes_per_slice);
-    memset(in_data+(slices+1)*bytes_per_slice, 0, bytes_per_slice);
-  }
   else {
     /* Allocate space for the buffer that stores the lower slice numbrer */
     pl_slice_map= (short *)malloc(sizeof(short)*plane_size[0]*plane_size[1]);
@@ -766,34 +768,16 @@ int ResliceData(ViewnixHeader *vh, int out_slices, int plane_size[2],
   for(i=0;i<vols;i++) {
     if (pl_slice_map == NULL)
     {
-      if (vh->scn.num_of_bits == 1) {
-        if (fseek(infp, vhlen+i*slices*bin_bytes_per_slice, 0L)) {
-          printf("Seek error on input file");
-          fflush(stdout);
-          exit(-1);
-        }
-        for (slice=1; slice<=slices; slice++) {
-          if (VReadData((char*)tmp_in_data, 1,bin_bytes_per_slice,infp,&num)) {
-            printf("Could not read original data set");
-            fflush(stdout);
-            exit(-1);
-          }
-          UnpackBitToByte(tmp_in_data, in_data+slice*bytes_per_slice,
-            bytes_per_slice);
-        }
+      if (fseek(infp, vhlen+i*slices*in_bytes_per_slice, 0L)) {
+        printf("Seek error on input file");
+        fflush(stdout);
+        exit(-1);
       }
-      else {
-        if (fseek(infp, vhlen+i*slices*bytes_per_slice, 0L)) {
-          printf("Seek error on input file");
-          fflush(stdout);
-          exit(-1);
-        }
-        if (VReadData((char*)in_data+bytes_per_slice,(vh->scn.num_of_bits+7)/8,
-            slices*bytes_per_slice/((vh->scn.num_of_bits+7)/8),infp,&num)) {
-          printf("Could not read original data set");
-          fflush(stdout);
-          exit(-1);
-        }
+      if (VReadData((char*)in_data,(vh->scn.num_of_bits+7)/8,
+          slices*in_bytes_per_slice/((vh->scn.num_of_bits+7)/8),infp,&num)) {
+        printf("Could not read original data set");
+        fflush(stdout);
+        exit(-1);
       }
     }
     for(j=0;j<out_slices;j++) {
@@ -846,9 +830,9 @@ int ResliceData(ViewnixHeader *vh, int out_slices, int plane_size[2],
  *       one or eight bits per cell, or short words if 16 bits.
  *    tmp_out_data: A buffer of size bin_out_bytes_per_slice if data is one
  *       bit per cell; otherwise will not be dereferenced.
- *    in_data: If pl_slice_map is NULL, the input scene data with an empty
- *       slice before and after, unpacked if binary; otherwise a buffer of
- *       size bytes_per_slice.
+ *    in_data: If pl_slice_map is NULL, the input scene data, packed if
+ *       binary, which is resliced by VResliceSlice; otherwise a buffer of
+ *       size 2*bytes_per_slice.
  *    tmp_in_data: A buffer of size tmp_in_bytes_per_slice if data is one
  *       bit per cell and pl_slice_map is non-zero; otherwise will not be
  *       dereferenced.
@@ -883,6 +867,7 @@ int ResliceData(ViewnixHeader *vh, int out_slices, int plane_size[2],
  *    Modified: 9/15/94 to make non-square slices by Dewey Odhner
  *    Modified: 9/15/94 to go faster with data in memory by Dewey Odhner
  *    Modified: 10/2/03 nearest neighbor option added by Dewey Odhner
+ *    Modified: 10/19/26 data in memory resliced by VResliceSlice
  *
  *****************************************************************************/
 void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
@@ -919,6 +904,11 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
   else 
     v[0]=v[1]=v[2]=0.0;
 
+  if (pl_slice_map == NULL)
+    VResliceSlice(in_data, vh->scn.num_of_bits, vh->scn.xysize[0],
+      vh->scn.xysize[1], slices, cur_ends[0], u, v, plane_size[0],
+      plane_size[1], (interp? VRESLICE_LINEAR: 0)|VRESLICE_ZERO_PAD,
+      out_data, vh->scn.num_of_bits==16? 16: 8);
 
   /* Initialize the lower slice index which gives rise to each pixel
      in the plane */  
@@ -942,10 +932,9 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
   
  
   if (vh->scn.num_of_bits==16) {  /* if the data is 16 bits */
-    memset(out_data,0,2*plane_size[0]*plane_size[1]);
-
     /* ptr1 always points to the fist slice and ptr2 to the second */
     if (pl_slice_map) {
+      memset(out_data,0,2*plane_size[0]*plane_size[1]);
       ptr1=(unsigned short *)in_data;
       ptr2=(unsigned short *)(in_data + bytes_per_slice);
       /* Read the Next slice */
@@ -1050,86 +1039,6 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
             }
        }
     }
-    else {
-      img_ptr=(unsigned short *)out_data;
-      for(i=0;i<plane_size[1];i++)
-        for(j=0;j<plane_size[0];j++,img_ptr++) {
-          point[2]= cur_ends[0][2] + i*v[2] + j*u[2] ;
-          if (point[2]<-1 || point[2]>=slices)
-            continue;
-          point[0]= cur_ends[0][0] + i*v[0] + j*u[0] ;
-          x=Floor(point[0]);
-          if (x>= -1 && x<vh->scn.xysize[0]) {
-            point[1]= cur_ends[0][1] + i*v[1] + j*u[1] ;
-            y=Floor(point[1]);
-            if (y>= -1 && y<vh->scn.xysize[1]) {
-              z=Floor(point[2]);
-              ptr1 = (unsigned short *)(in_data+(z+1)*bytes_per_slice);
-              ptr2 = (unsigned short *)(in_data+(z+2)*bytes_per_slice);
-              dx=point[0]-x; dy=point[1]-y; dz=point[2]-z;
-              /* if within bounds init locations in each slice */
-              pt1= (unsigned short *)ptr1 + y*vh->scn.xysize[0]+x;
-              pt2= (unsigned short *)ptr2 + y*vh->scn.xysize[0]+x;
-              *img_ptr= (unsigned short)(interp? .5+ 
-                (1-dz)*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt1
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt1+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                ) +
-                dz*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt2
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt2+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                )
-               :
-                dz<.5?
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt1
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt1+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1+vh->scn.xysize[0]+1)
-                :
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt2
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt2+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2+vh->scn.xysize[0]+1));
-            }
-          }
-        }
-    }
 
     if (VWriteData((char*)out_data,2,plane_size[0]*plane_size[1],outfp,&num)) {
       printf("Could not write output data\n");
@@ -1139,10 +1048,9 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
 
   }
   else if (vh->scn.num_of_bits==8) {
-    memset(out_data,0,plane_size[0]*plane_size[1]);
-
     /* ptr1 always points to the fist slice and ptr2 to the second */
     if (pl_slice_map) {
+      memset(out_data,0,plane_size[0]*plane_size[1]);
       ptr1_8=(unsigned char *)in_data;
       ptr2_8=(unsigned char *)(in_data + bytes_per_slice);
 
@@ -1247,86 +1155,6 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
             }
       } 
     }
-    else {
-      img_ptr_8=(unsigned char *)out_data;
-      for(i=0;i<plane_size[1];i++)
-        for(j=0;j<plane_size[0];j++,img_ptr_8++) {
-          point[2]= cur_ends[0][2] + i*v[2] + j*u[2];
-          if (point[2]<-1 || point[2]>=slices)
-            continue;
-          point[0]= cur_ends[0][0] + i*v[0] + j*u[0];
-          x=Floor(point[0]);
-          if (x>= -1 && x<vh->scn.xysize[0]) {
-            point[1]= cur_ends[0][1] + i*v[1] + j*u[1];
-            y=Floor(point[1]);
-            if (y>= -1 && y<vh->scn.xysize[1]) {
-              z=Floor(point[2]);
-              ptr1_8 = in_data+(z+1)*bytes_per_slice;
-              ptr2_8 = in_data+(z+2)*bytes_per_slice;
-              dx=point[0]-x; dy=point[1]-y; dz=point[2]-z;
-              /* if within bounds init locations in each slice */
-              pt1_8= (unsigned char *)ptr1_8 + y*vh->scn.xysize[0]+x;
-              pt2_8= (unsigned char *)ptr2_8 + y*vh->scn.xysize[0]+x;
-              *img_ptr_8= (unsigned char)(interp? .5+
-                (1-dz)*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt1_8
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1_8+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt1_8+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1_8+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                ) +
-                dz*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt2_8
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2_8+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt2_8+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2_8+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                )
-               :
-                dz<.5?
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt1_8
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1_8+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt1_8+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1_8+vh->scn.xysize[0]+1)
-                :
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt2_8
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2_8+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt2_8+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2_8+vh->scn.xysize[0]+1));
-            }
-          }
-        }
-    }
     if (fwrite(out_data,1,plane_size[0]*plane_size[1],outfp)!=
             plane_size[0]*plane_size[1]) {
       printf("Could not write output data\n");
@@ -1335,10 +1163,9 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
     }
   }
   else {
-    memset(out_data,0,plane_size[0]*plane_size[1]);
-
     /* ptr1 always points to the fist slice and ptr2 to the second */
     if (pl_slice_map) {
+      memset(out_data,0,plane_size[0]*plane_size[1]);
       ptr1_8=(unsigned char *)in_data;
       ptr2_8=(unsigned char *)(in_data + bytes_per_slice);
 
@@ -1447,86 +1274,6 @@ void WriteVolume(ViewnixHeader *vh, int vol, unsigned char *out_data,
             }
       } 
     }
-    else {
-      img_ptr_8=(unsigned char *)out_data;
-      for(i=0;i<plane_size[1];i++)
-        for(j=0;j<plane_size[0];j++,img_ptr_8++) {
-          point[2]= cur_ends[0][2] + i*v[2] + j*u[2];
-          if (point[2]<-1 || point[2]>=slices)
-            continue;
-          point[0]= cur_ends[0][0] + i*v[0] + j*u[0];
-          x=Floor(point[0]);
-          if (x>= -1 && x<vh->scn.xysize[0]) {
-            point[1]= cur_ends[0][1] + i*v[1] + j*u[1];
-            y=Floor(point[1]);
-            if (y>= -1 && y<vh->scn.xysize[1]) {
-              z=Floor(point[2]);
-              ptr1_8 = in_data+(z+1)*bytes_per_slice;
-              ptr2_8 = in_data+(z+2)*bytes_per_slice;
-              dx=point[0]-x; dy=point[1]-y; dz=point[2]-z;
-              /* if within bounds init locations in each slice */
-              pt1_8= (unsigned char *)ptr1_8 + y*vh->scn.xysize[0]+x;
-              pt2_8= (unsigned char *)ptr2_8 + y*vh->scn.xysize[0]+x;
-              *img_ptr_8= interp?
-                (1-dz)*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt1_8
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1_8+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt1_8+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt1_8+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                ) +
-                dz*
-                ( (y==-1? 0: (1-dy)*
-                    ( (x==-1? 0:
-                        (1-dx)* *pt2_8
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2_8+1)
-                      )
-                    )
-                  ) +
-                  (y==vh->scn.xysize[1]-1? 0: dy*
-                    ( (x==-1? 0:
-                        (1-dx)* *(pt2_8+vh->scn.xysize[0])
-                      ) +
-                      (x==vh->scn.xysize[0]-1? 0:
-                        dx*     *(pt2_8+vh->scn.xysize[0]+1)
-                      )
-                    )
-                  )
-                ) >= 127.5
-               :
-                dz<.5?
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt1_8
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1_8+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt1_8+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt1_8+vh->scn.xysize[0]+1)
-                :
-                  dy<.5? y==-1? 0:
-                    dx<.5? x==-1? 0:             *pt2_8
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2_8+1)
-                  : y==vh->scn.xysize[1]-1? 0:
-                    dx<.5? x==-1? 0:             *(pt2_8+vh->scn.xysize[0])
-                    : x==vh->scn.xysize[0]-1? 0: *(pt2_8+vh->scn.xysize[0]+1);
-            }
-          }
-        }
-    }
     VPackByteToBit(out_data,plane_size[0]*plane_size[1],tmp_out_data);
     if (fwrite(tmp_out_data,1,bin_out_bytes_per_slice,outfp) !=
         bin_out_bytes_per_slice) {
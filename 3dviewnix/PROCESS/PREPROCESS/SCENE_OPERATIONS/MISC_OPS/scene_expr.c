@@ -0,0 +1,1155 @@
+/*
+  Copyright 1993-2015 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "scene_expr.h"
+
+enum {SE_CONST, SE_LOAD, SE_NEG, SE_NOT, SE_ABS, SE_SQRT, SE_ADD, SE_SUB,
+	SE_MUL, SE_DIV, SE_MIN, SE_MAX, SE_LT, SE_LE, SE_GT, SE_GE, SE_EQ,
+	SE_NE, SE_AND, SE_OR, SE_FSP, SE_SELECT, SE_QUAD};
+
+/* number of operands of each operation */
+static const int se_arity[]={0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 3, 2};
+
+typedef struct Quadratic {float xx, xy, yy, x, y, cnst;} Quadratic;
+
+#define Quadratic_value(X, Y, q) \
+	((X)*((q).xx*(X)+(q).xy*(Y)+(q).x)+(Y)*((q).yy*(Y)+(q).y)+(q).cnst)
+
+typedef struct {
+	SEProgram *prog;
+	const char *p;
+	int *load;		/* register of each input, -1 if not loaded */
+} SEParser;
+
+static int parse_quadratic(Quadratic *out, const char in[]);
+static void adjust_interval(float *min_out, float *max_out, float min1,
+	float max1, float min2, float max2, Quadratic *q);
+static float FuzzySymmetricProduct(double x, double y);
+static int se_emit(SEProgram *prog, int op, int a, int b, int c,
+	const float *k);
+static void se_kernel(const SEInstr *ins, float *d, const float *a,
+	const float *b, const float *c, int n);
+static int se_cond(SEParser *ps);
+
+/*****************************************************************************
+ * FUNCTION: se_init
+ * DESCRIPTION: Initializes an empty program.
+ * PARAMETERS:
+ *    prog: The program.
+ *    ninputs: The number of scenes the program may use.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: Non-zero if memory cannot be allocated.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int se_init(SEProgram *prog, int ninputs)
+{
+	prog->ninputs = ninputs;
+	prog->ninstr = 0;
+	prog->max_instr = 64;
+	prog->instr = (SEInstr *)malloc(prog->max_instr*sizeof(SEInstr));
+	prog->order = NULL;
+	prog->norder = 0;
+	return prog->instr == NULL;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_compile
+ * DESCRIPTION: Compiles an expression into a program.
+ * PARAMETERS:
+ *    prog: The program; the instructions are added to it.
+ *    text: The expression, as described in scene_expr.h.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: se_init must be called first.
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int se_compile(SEProgram *prog, const char *text)
+{
+	SEParser ps;
+	Quadratic q;
+	int j, result;
+
+	/* expressions of earlier versions; "x2" is a scene, not 2x */
+	for (j=0; text[j] && !((text[j]=='x' || text[j]=='y') &&
+			isdigit(text[j+1])); j++)
+		;
+	if (text[j]==0 && strspn(text, "0123456789.eE+- xy")==strlen(text) &&
+			(strchr(text, 'x') || strchr(text, 'y')) && prog->ninputs>=2 &&
+			parse_quadratic(&q, text) == 0)
+	{
+		int x=se_emit(prog, SE_LOAD, -1, -1, -1, NULL),
+			y=se_emit(prog, SE_LOAD, -1, -1, -1, NULL);
+
+		if (x<0 || y<0)
+			return -1;
+		prog->instr[x].k[0] = 0;
+		prog->instr[y].k[0] = 1;
+		return se_emit(prog, SE_QUAD, x, y, -1, &q.xx);
+	}
+	while (*text == ' ')
+		text++;
+	if (strcmp(text, "fsp") == 0)
+		text = "fsp(x, y)";
+
+	ps.prog = prog;
+	ps.p = text;
+	ps.load = (int *)malloc(prog->ninputs*sizeof(int));
+	if (ps.load == NULL)
+		return -1;
+	for (j=0; j<prog->ninputs; j++)
+		ps.load[j] = -1;
+	result = se_cond(&ps);
+	while (*ps.p == ' ')
+		ps.p++;
+	if (*ps.p)
+		result = -1;
+	free(ps.load);
+	return result;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_select
+ * DESCRIPTION: Adds an instruction that selects a where mask is positive,
+ *    else b.
+ * PARAMETERS:
+ *    prog: The program.
+ *    mask, a, b: Registers of the program.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int se_select(SEProgram *prog, int mask, int a, int b)
+{
+	return se_emit(prog, SE_SELECT, mask, a, b, NULL);
+}
+
+/*****************************************************************************
+ * FUNCTION: se_finish
+ * DESCRIPTION: Makes the list of instructions to run: those the result
+ *    depends on, other than constants.
+ * PARAMETERS:
+ *    prog: The program.
+ *    result: The register of the result.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: Non-zero if memory cannot be allocated.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int se_finish(SEProgram *prog, int result)
+{
+	char *live;
+	int j;
+
+	live = (char *)calloc(prog->ninstr, 1);
+	prog->order = (int *)malloc(prog->ninstr*sizeof(int));
+	if (live==NULL || prog->order==NULL)
+	{
+		if (live)
+			free(live);
+		return 1;
+	}
+	/* operands always precede the instruction */
+	live[result] = 1;
+	for (j=result; j>=0; j--)
+		if (live[j])
+		{
+			if (prog->instr[j].a >= 0)
+				live[prog->instr[j].a] = 1;
+			if (prog->instr[j].b >= 0)
+				live[prog->instr[j].b] = 1;
+			if (prog->instr[j].c >= 0)
+				live[prog->instr[j].c] = 1;
+		}
+	for (prog->norder=j=0; j<prog->ninstr; j++)
+		if (live[j] && prog->instr[j].op!=SE_CONST)
+			prog->order[prog->norder++] = j;
+	free(live);
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_range
+ * DESCRIPTION: Finds an interval containing the values of a register, by
+ *    interval arithmetic.
+ * PARAMETERS:
+ *    prog: The program.
+ *    reg: The register.
+ *    min, max: The range of values of each scene.
+ *    lo, hi: The interval is stored here.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void se_range(const SEProgram *prog, int reg, const float min[],
+	const float max[], float *lo, float *hi)
+{
+	float *l, *h, al, ah, bl, bh, p[4];
+	int j, m;
+
+	l = (float *)malloc(2*(reg+1)*sizeof(float));
+	if (l == NULL)
+	{
+		*lo = 0;
+		*hi = 65535;
+		return;
+	}
+	h = l+reg+1;
+	for (j=0; j<=reg; j++)
+	{
+		const SEInstr *ins=prog->instr+j;
+
+		al = ins->a>=0? l[ins->a]: 0;
+		ah = ins->a>=0? h[ins->a]: 0;
+		bl = ins->b>=0? l[ins->b]: 0;
+		bh = ins->b>=0? h[ins->b]: 0;
+		switch (ins->op)
+		{
+			case SE_CONST:
+				l[j] = h[j] = ins->k[0];
+				break;
+			case SE_LOAD:
+				l[j] = min[(int)ins->k[0]];
+				h[j] = max[(int)ins->k[0]];
+				break;
+			case SE_NEG:
+				l[j] = -ah;
+				h[j] = -al;
+				break;
+			case SE_ABS:
+				l[j] = al>0? al: ah<0? -ah: 0;
+				h[j] = ah>-al? ah: -al;
+				break;
+			case SE_SQRT:
+				l[j] = al>0? (float)sqrt(al): 0;
+				h[j] = ah>0? (float)sqrt(ah): 0;
+				break;
+			case SE_ADD:
+				l[j] = al+bl;
+				h[j] = ah+bh;
+				break;
+			case SE_SUB:
+				l[j] = al-bh;
+				h[j] = ah-bl;
+				break;
+			case SE_MUL:
+			case SE_DIV:
+				if (ins->op == SE_DIV)
+				{
+					if (bl<=0 && bh>=0)
+					{
+						/* any value, but 0 where b is 0 */
+						l[j] = -1e30f;
+						h[j] = 1e30f;
+						break;
+					}
+					p[0] = al/bl; p[1] = al/bh; p[2] = ah/bl; p[3] = ah/bh;
+				}
+				else
+				{
+					p[0] = al*bl; p[1] = al*bh; p[2] = ah*bl; p[3] = ah*bh;
+				}
+				l[j] = h[j] = p[0];
+				for (m=1; m<4; m++)
+				{
+					if (p[m] < l[j])
+						l[j] = p[m];
+					if (p[m] > h[j])
+						h[j] = p[m];
+				}
+				break;
+			case SE_MIN:
+				l[j] = al<bl? al: bl;
+				h[j] = ah<bh? ah: bh;
+				break;
+			case SE_MAX:
+				l[j] = al>bl? al: bl;
+				h[j] = ah>bh? ah: bh;
+				break;
+			case SE_FSP:
+				l[j] = 0;
+				h[j] = 65534;
+				break;
+			case SE_SELECT:
+				l[j] = l[ins->b]<l[ins->c]? l[ins->b]: l[ins->c];
+				h[j] = h[ins->b]>h[ins->c]? h[ins->b]: h[ins->c];
+				break;
+			case SE_QUAD:
+				l[j] = 1e30f;
+				h[j] = -1e30f;
+				adjust_interval(l+j, h+j, al, ah, bl, bh, (Quadratic *)ins->k);
+				break;
+			default:	/* comparisons and logical operations */
+				l[j] = 0;
+				h[j] = 1;
+		}
+	}
+	*lo = l[reg];
+	*hi = h[reg];
+	free(l);
+}
+
+/*****************************************************************************
+ * FUNCTION: se_start
+ * DESCRIPTION: Sets the constant registers of a program.
+ * PARAMETERS:
+ *    prog: The program.
+ *    regs: The registers, SE_BLOCK values each, prog->ninstr registers.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void se_start(const SEProgram *prog, float *regs)
+{
+	int j, k;
+
+	for (j=0; j<prog->ninstr; j++)
+		if (prog->instr[j].op == SE_CONST)
+			for (k=0; k<SE_BLOCK; k++)
+				regs[j*SE_BLOCK+k] = prog->instr[j].k[0];
+}
+
+/*****************************************************************************
+ * FUNCTION: se_eval
+ * DESCRIPTION: Runs a program on a block of voxels.
+ * PARAMETERS:
+ *    prog: The program.
+ *    in: The slice of each scene.
+ *    start: The index of the first voxel of the block in the slice.
+ *    count: The number of voxels, at most SE_BLOCK.
+ *    regs: The registers, as set by se_start; register j of voxel
+ *       start+k is regs[j*SE_BLOCK+k].
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: se_finish must be called first.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void se_eval(const SEProgram *prog, const SEInput in[], long start,
+	int count, float *regs)
+{
+	int j, k;
+
+	for (j=0; j<prog->norder; j++)
+	{
+		const SEInstr *ins=prog->instr+prog->order[j];
+		float *d=regs+prog->order[j]*SE_BLOCK;
+
+		if (ins->op == SE_LOAD)
+		{
+			const SEInput *s=in+(int)ins->k[0];
+
+			switch (s->bits)
+			{
+				case 1:
+					for (k=0; k<count; k++)
+						d[k] = (float)((s->data[(start+k)/8]&
+							(128>>((start+k)%8))) != 0);
+					break;
+				case 8:
+					for (k=0; k<count; k++)
+						d[k] = s->data[start+k];
+					break;
+				default:
+					for (k=0; k<count; k++)
+						d[k] = ((const unsigned short *)s->data)[start+k];
+			}
+		}
+		else
+			se_kernel(ins, d, regs+ins->a*SE_BLOCK,
+				ins->b>=0? regs+ins->b*SE_BLOCK: NULL,
+				ins->c>=0? regs+ins->c*SE_BLOCK: NULL, count);
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: se_free
+ * DESCRIPTION: Frees the memory of a program.
+ * PARAMETERS:
+ *    prog: The program.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void se_free(SEProgram *prog)
+{
+	if (prog->instr)
+		free(prog->instr);
+	if (prog->order)
+		free(prog->order);
+	prog->instr = NULL;
+	prog->order = NULL;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_kernel
+ * DESCRIPTION: Computes an instruction other than SE_LOAD for a block.
+ * PARAMETERS:
+ *    ins: The instruction.
+ *    d: The result.
+ *    a, b, c: The operands.
+ *    n: The number of values.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static void se_kernel(const SEInstr *ins, float *d, const float *a,
+	const float *b, const float *c, int n)
+{
+	int k;
+
+	switch (ins->op)
+	{
+		case SE_NEG:
+			for (k=0; k<n; k++)
+				d[k] = -a[k];
+			break;
+		case SE_NOT:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] <= 0);
+			break;
+		case SE_ABS:
+			for (k=0; k<n; k++)
+				d[k] = a[k]<0? -a[k]: a[k];
+			break;
+		case SE_SQRT:
+			for (k=0; k<n; k++)
+				d[k] = a[k]>0? (float)sqrt(a[k]): 0;
+			break;
+		case SE_ADD:
+			for (k=0; k<n; k++)
+				d[k] = a[k]+b[k];
+			break;
+		case SE_SUB:
+			for (k=0; k<n; k++)
+				d[k] = a[k]-b[k];
+			break;
+		case SE_MUL:
+			for (k=0; k<n; k++)
+				d[k] = a[k]*b[k];
+			break;
+		case SE_DIV:
+			for (k=0; k<n; k++)
+				d[k] = b[k]!=0? a[k]/b[k]: 0;
+			break;
+		case SE_MIN:
+			for (k=0; k<n; k++)
+				d[k] = a[k]<b[k]? a[k]: b[k];
+			break;
+		case SE_MAX:
+			for (k=0; k<n; k++)
+				d[k] = a[k]>b[k]? a[k]: b[k];
+			break;
+		case SE_LT:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] < b[k]);
+			break;
+		case SE_LE:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] <= b[k]);
+			break;
+		case SE_GT:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] > b[k]);
+			break;
+		case SE_GE:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] >= b[k]);
+			break;
+		case SE_EQ:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] == b[k]);
+			break;
+		case SE_NE:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k] != b[k]);
+			break;
+		case SE_AND:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k]>0 && b[k]>0);
+			break;
+		case SE_OR:
+			for (k=0; k<n; k++)
+				d[k] = (float)(a[k]>0 || b[k]>0);
+			break;
+		case SE_FSP:
+			for (k=0; k<n; k++)
+				d[k] = 65534*FuzzySymmetricProduct(1/65534.*a[k],
+					1/65534.*b[k]);
+			break;
+		case SE_SELECT:
+			for (k=0; k<n; k++)
+				d[k] = a[k]>0? b[k]: c[k];
+			break;
+		case SE_QUAD:
+		{
+			Quadratic q;
+
+			memcpy(&q, ins->k, sizeof(q));
+			for (k=0; k<n; k++)
+				d[k] = Quadratic_value(a[k], b[k], q);
+			break;
+		}
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: se_emit
+ * DESCRIPTION: Adds an instruction to a program, or, if its operands are
+ *    constant, the constant it computes.
+ * PARAMETERS:
+ *    prog: The program.
+ *    op: The operation.
+ *    a, b, c: The operand registers, -1 if not used.
+ *    k: The constants of the instruction, or NULL.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_emit(SEProgram *prog, int op, int a, int b, int c,
+	const float *k)
+{
+	SEInstr *ins;
+	int j, nconst=0, operand[3];
+
+	if ((se_arity[op]>0 && a<0) || (se_arity[op]>1 && b<0) ||
+			(se_arity[op]>2 && c<0))
+		return -1;
+	if (prog->ninstr == prog->max_instr)
+	{
+		ins = (SEInstr *)
+			realloc(prog->instr, 2*prog->max_instr*sizeof(SEInstr));
+		if (ins == NULL)
+			return -1;
+		prog->instr = ins;
+		prog->max_instr *= 2;
+	}
+	ins = prog->instr+prog->ninstr;
+	ins->op = op;
+	ins->a = a;
+	ins->b = b;
+	ins->c = c;
+	memset(ins->k, 0, sizeof(ins->k));
+	if (k)
+		memcpy(ins->k, k, (op==SE_QUAD? 6: 1)*sizeof(float));
+
+	/* fold constants */
+	operand[0] = a;
+	operand[1] = b;
+	operand[2] = c;
+	for (j=0; j<se_arity[op]; j++)
+		if (prog->instr[operand[j]].op == SE_CONST)
+			nconst++;
+	if (se_arity[op] && nconst==se_arity[op])
+	{
+		float v[3]={0, 0, 0}, r;
+
+		for (j=0; j<se_arity[op]; j++)
+			v[j] = prog->instr[operand[j]].k[0];
+		se_kernel(ins, &r, v, v+1, v+2, 1);
+		ins->op = SE_CONST;
+		ins->a = ins->b = ins->c = -1;
+		ins->k[0] = r;
+	}
+	return prog->ninstr++;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_args
+ * DESCRIPTION: Parses the parenthesized arguments of a function.
+ * PARAMETERS:
+ *    ps: The parser.
+ *    arg: The argument registers are stored here.
+ *    max_args: The most arguments accepted.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The number of arguments, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_args(SEParser *ps, int arg[], int max_args)
+{
+	int n=0;
+
+	while (*ps->p == ' ')
+		ps->p++;
+	if (*ps->p != '(')
+		return -1;
+	ps->p++;
+	for (;;)
+	{
+		if (n == max_args)
+			return -1;
+		arg[n] = se_cond(ps);
+		if (arg[n++] < 0)
+			return -1;
+		while (*ps->p == ' ')
+			ps->p++;
+		if (*ps->p == ')')
+		{
+			ps->p++;
+			return n;
+		}
+		if (*ps->p != ',')
+			return -1;
+		ps->p++;
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: se_primary
+ * DESCRIPTION: Parses a number, scene, function or parenthesized
+ *    expression.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_primary(SEParser *ps)
+{
+	static const char *name[]={"min", "max", "abs", "sqrt", "fsp", "if"};
+	int arg[64], n, j, r, len;
+	char *end;
+	float v;
+
+	while (*ps->p == ' ')
+		ps->p++;
+	if (isdigit(*ps->p) || *ps->p=='.')
+	{
+		v = (float)strtod(ps->p, &end);
+		if (end == ps->p)
+			return -1;
+		ps->p = end;
+		return se_emit(ps->prog, SE_CONST, -1, -1, -1, &v);
+	}
+	if (*ps->p == '(')
+	{
+		ps->p++;
+		r = se_cond(ps);
+		while (*ps->p == ' ')
+			ps->p++;
+		if (r<0 || *ps->p!=')')
+			return -1;
+		ps->p++;
+		return r;
+	}
+	for (len=0; isalpha(ps->p[len]); len++)
+		;
+	for (j=0; j<6; j++)
+		if ((int)strlen(name[j])==len && strncmp(ps->p, name[j], len)==0)
+			break;
+	if (j < 6)
+	{
+		ps->p += len;
+		n = se_args(ps, arg, 64);
+		switch (j)
+		{
+			case 0:
+			case 1:
+				if (n < 1)
+					return -1;
+				for (r=arg[0],len=1; len<n; len++)
+					r = se_emit(ps->prog, j? SE_MAX: SE_MIN, r, arg[len], -1,
+						NULL);
+				return r;
+			case 2:
+			case 3:
+				return n!=1? -1:
+					se_emit(ps->prog, j==2? SE_ABS: SE_SQRT, arg[0], -1, -1,
+					NULL);
+			case 4:
+				return n!=2? -1:
+					se_emit(ps->prog, SE_FSP, arg[0], arg[1], -1, NULL);
+			default:
+				return n!=3? -1:
+					se_emit(ps->prog, SE_SELECT, arg[0], arg[1], arg[2], NULL);
+		}
+	}
+
+	/* a scene: x, y or x<n> */
+	if (*ps->p == 'y')
+	{
+		j = 1;
+		ps->p++;
+	}
+	else if (*ps->p == 'x')
+	{
+		ps->p++;
+		if (isdigit(*ps->p))
+		{
+			j = (int)strtol(ps->p, &end, 10)-1;
+			ps->p = end;
+		}
+		else
+			j = 0;
+	}
+	else
+		return -1;
+	if (j<0 || j>=ps->prog->ninputs)
+		return -1;
+	if (ps->load[j] < 0)
+	{
+		ps->load[j] = se_emit(ps->prog, SE_LOAD, -1, -1, -1, NULL);
+		if (ps->load[j] >= 0)
+			ps->prog->instr[ps->load[j]].k[0] = (float)j;
+	}
+	return ps->load[j];
+}
+
+/*****************************************************************************
+ * FUNCTION: se_unary
+ * DESCRIPTION: Parses a primary with any unary operators.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_unary(SEParser *ps)
+{
+	while (*ps->p == ' ')
+		ps->p++;
+	switch (*ps->p)
+	{
+		case '-':
+			ps->p++;
+			return se_emit(ps->prog, SE_NEG, se_unary(ps), -1, -1, NULL);
+		case '+':
+			ps->p++;
+			return se_unary(ps);
+		case '!':
+			ps->p++;
+			return se_emit(ps->prog, SE_NOT, se_unary(ps), -1, -1, NULL);
+	}
+	return se_primary(ps);
+}
+
+/*****************************************************************************
+ * FUNCTION: se_product
+ * DESCRIPTION: Parses products and quotients; a factor following another
+ *    without an operator multiplies it.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_product(SEParser *ps)
+{
+	int r=se_unary(ps);
+
+	while (r >= 0)
+	{
+		while (*ps->p == ' ')
+			ps->p++;
+		if (*ps->p=='*' || *ps->p=='/')
+		{
+			int op=*ps->p=='*'? SE_MUL: SE_DIV;
+
+			ps->p++;
+			r = se_emit(ps->prog, op, r, se_unary(ps), -1, NULL);
+		}
+		else if (isalnum(*ps->p) || *ps->p=='.' || *ps->p=='(')
+			r = se_emit(ps->prog, SE_MUL, r, se_primary(ps), -1, NULL);
+		else
+			break;
+	}
+	return r;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_sum
+ * DESCRIPTION: Parses sums and differences.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_sum(SEParser *ps)
+{
+	int r=se_product(ps);
+
+	while (r >= 0)
+	{
+		while (*ps->p == ' ')
+			ps->p++;
+		if (*ps->p!='+' && *ps->p!='-')
+			break;
+		if (*ps->p++ == '+')
+			r = se_emit(ps->prog, SE_ADD, r, se_product(ps), -1, NULL);
+		else
+			r = se_emit(ps->prog, SE_SUB, r, se_product(ps), -1, NULL);
+	}
+	return r;
+}
+
+/*****************************************************************************
+ * FUNCTION: se_compare
+ * DESCRIPTION: Parses a sum or a comparison of two sums.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_compare(SEParser *ps)
+{
+	int r=se_sum(ps), op;
+
+	while (*ps->p == ' ')
+		ps->p++;
+	if (r < 0)
+		return r;
+	if (strncmp(ps->p, "<=", 2) == 0)
+		op = SE_LE;
+	else if (strncmp(ps->p, ">=", 2) == 0)
+		op = SE_GE;
+	else if (strncmp(ps->p, "==", 2) == 0)
+		op = SE_EQ;
+	else if (strncmp(ps->p, "!=", 2) == 0)
+		op = SE_NE;
+	else if (*ps->p == '<')
+		op = SE_LT;
+	else if (*ps->p == '>')
+		op = SE_GT;
+	else
+		return r;
+	ps->p += op==SE_LT || op==SE_GT? 1: 2;
+	return se_emit(ps->prog, op, r, se_sum(ps), -1, NULL);
+}
+
+/*****************************************************************************
+ * FUNCTION: se_cond
+ * DESCRIPTION: Parses an expression: comparisons joined by && and ||,
+ *    optionally followed by ? and two alternatives.
+ * PARAMETERS:
+ *    ps: The parser.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The register of the result, -1 on error.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int se_cond(SEParser *ps)
+{
+	int r, a, or_reg=-1;
+
+	/* && binds more tightly than || */
+	for (;;)
+	{
+		r = se_compare(ps);
+		while (r>=0 && strncmp(ps->p, "&&", 2)==0)
+		{
+			ps->p += 2;
+			r = se_emit(ps->prog, SE_AND, r, se_compare(ps), -1, NULL);
+		}
+		if (or_reg >= 0)
+			r = se_emit(ps->prog, SE_OR, or_reg, r, -1, NULL);
+		if (r<0 || strncmp(ps->p, "||", 2))
+			break;
+		ps->p += 2;
+		or_reg = r;
+	}
+	if (r<0 || *ps->p!='?')
+		return r;
+	ps->p++;
+	a = se_cond(ps);
+	while (*ps->p == ' ')
+		ps->p++;
+	if (a<0 || *ps->p!=':')
+		return -1;
+	ps->p++;
+	return se_emit(ps->prog, SE_SELECT, r, a, se_cond(ps), NULL);
+}
+
+/*****************************************************************************
+ * FUNCTION: parse_quadratic
+ * DESCRIPTION: Extracts the coefficients from a quadratic exxpression
+ *    in "x" & "y".
+ * PARAMETERS:
+ *    out: The coefficents are stored here.
+ *    in: The input expression in the form "[<f>xx][[+|-]<f>xy][[+|-]<f>yy]
+ *       [[+|-]<f>x][[+|-]<f>y][[+|-]<f>]" where each "<f>" is a decimal
+ *       coefficient.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: Non-zero on error
+ * EXIT CONDITIONS: Not all errors in in are detected.
+ * HISTORY:
+ *    Created: 5/22/97 by Dewey Odhner
+ *    Modified: 10/19/26 moved from algebra.c
+ *
+ *****************************************************************************/
+static int parse_quadratic(Quadratic *out, const char in[])
+{
+	char *buf;
+	int coef_len, x_degree, y_degree;
+	float *field, coeff, factor;
+
+	buf = malloc(strlen(in)+1);
+	if (buf == NULL)
+		return (1);
+	out->xx = out->xy = out->yy = out->x = out->y = out->cnst = 0;
+	while (*in)
+	{
+		coeff = 1;
+		for (;; in++)
+		{
+			if (*in == '-')
+				coeff = -coeff;
+			else if (*in!=' ' && *in!='+')
+				break;
+		}
+		if (*in == 0)
+		{
+			free(buf);
+			return (2);
+		}
+		x_degree = y_degree = coef_len = 0;
+		for (;;)
+		{
+			while (*in == ' ')
+				in++;
+			if (*in==0 || *in=='+' || *in=='-' || *in=='x' || *in=='y')
+			{
+				if (*in == 'x')
+					x_degree++;
+				if (*in == 'y')
+					y_degree++;
+				if (x_degree+y_degree > 2)
+				{
+					free(buf);
+					return (2);
+				}
+				if (coef_len)
+				{
+					buf[coef_len] = 0;
+					if (sscanf(buf, "%f", &factor) != 1)
+					{
+						free(buf);
+						return (2);
+					}
+					coeff *= factor;
+					coef_len = 0;
+				}
+				if (*in==0 || *in=='+' || *in=='-')
+					break;
+			}
+			else
+				buf[coef_len++] = *in;
+			in++;
+		}
+		if (x_degree == 2)
+			field = &out->xx;
+		else if (y_degree == 2)
+			field = &out->yy;
+		else if (x_degree && y_degree)
+			field = &out->xy;
+		else if (x_degree)
+			field = &out->x;
+		else if (y_degree)
+			field = &out->y;
+		else
+			field = &out->cnst;
+		*field += coeff;
+	}
+	free(buf);
+	return (0);
+}
+
+/*****************************************************************************
+ * FUNCTION: adjust_interval
+ * DESCRIPTION: Adjusts an interval to cover the range of a quadratic function
+ *    within a rectangular domain.
+ * PARAMETERS:
+ *    min_out, max_out: The interval to be adjusted.
+ *    min1, max1: The domain of the "x" variable.
+ *    min2, max2: The domain of the "y" variable.
+ *    q: The coefficients of the quadratic function.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 5/28/97 by Dewey Odhner
+ *    Modified: 10/19/26 moved from algebra.c
+ *
+ *****************************************************************************/
+static void adjust_interval(float *min_out, float *max_out, float min1,
+	float max1, float min2, float max2, Quadratic *q)
+{
+  float val1,val2;
+
+  val1 = (float)Quadratic_value(min1, min2, *q);
+  if (val1 < *min_out)
+	  *min_out = val1;
+  if (val1 > *max_out)
+	  *max_out = val1;
+  val1 = (float)Quadratic_value(min1, max2, *q);
+  if (val1 < *min_out)
+	  *min_out = val1;
+  if (val1 > *max_out)
+	  *max_out = val1;
+  val1 = (float)Quadratic_value(max1, min2, *q);
+  if (val1 < *min_out)
+	  *min_out = val1;
+  if (val1 > *max_out)
+	  *max_out = val1;
+  val1 = (float)Quadratic_value(max1, max2, *q);
+  if (val1 < *min_out)
+	  *min_out = val1;
+  if (val1 > *max_out)
+	  *max_out = val1;
+  if (q->xx != 0)
+  {
+	val1 = (float)(-(q->xy*min2+q->x)/(2*q->xx));
+	if (val1 > min1 && val1<max1)
+	{
+		val1 = (float)Quadratic_value(val1, min2, *q);
+		if (val1 < *min_out)
+			*min_out = val1;
+		if (val1 > *max_out)
+			*max_out = val1;
+	}
+	val1 = (float)(-(q->xy*max2+q->x)/(2*q->xx));
+	if (val1 > min1 && val1<max1)
+	{
+		val1 = (float)Quadratic_value(val1, max2, *q);
+		if (val1 < *min_out)
+			*min_out = val1;
+		if (val1 > *max_out)
+			*max_out = val1;
+	}
+  }
+  if (q->yy != 0)
+  {
+	val1 = (float)(-(q->xy*min1+q->y)/(2*q->yy));
+	if (val1 > min2 && val1<max2)
+	{
+		val1 = (float)Quadratic_value(min1, val1, *q);
+		if (val1 < *min_out)
+			*min_out = val1;
+		if (val1 > *max_out)
+			*max_out = val1;
+	}
+	val1 = (float)(-(q->xy*max1+q->y)/(2*q->yy));
+	if (val1 > min2 && val1<max2)
+	{
+		val1 = (float)Quadratic_value(max1, val1, *q);
+		if (val1 < *min_out)
+			*min_out = val1;
+		if (val1 > *max_out)
+			*max_out = val1;
+	}
+  }
+  val1 = 4*q->xx*q->yy-q->xy*q->xy;
+  if (val1 != 0)
+  {
+	val2 = (q->xy*q->x-2*q->xx*q->y)/val1;
+	val1 = (q->xy*q->y-2*q->yy*q->x)/val1;
+	if (val1>min1 && val1<max1 && val2>min2 && val2<max2)
+	{
+		val1 = Quadratic_value(val1, val2, *q);
+		if (val1 < *min_out)
+			*min_out = val1;
+		if (val1 > *max_out)
+			*max_out = val1;
+	}
+  }
+}
+
+static float FuzzySymmetricProduct(double x, double y)
+{
+	double r;
+
+	r = x*y*(x*y+1-x-y);
+	if (r < 0)
+		r = 0;
+	return (float)(1-x-y? (sqrt(r)-x*y)/(1-x-y): .5);
+}
@@ -0,0 +1,77 @@
+/*
+  Copyright 1993-2015 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Expressions in the voxel values of several scenes, for algebra.
+ *
+ * An expression is compiled once into a program of instructions, each of
+ * which computes one register: a float for each of SE_BLOCK voxels.  The
+ * program is run a block of voxels at a time, so each instruction is a
+ * simple loop over the block that the compiler vectorizes, and the cost
+ * of dispatching an instruction is shared by the whole block.  Constant
+ * subexpressions are computed at compile time, and instructions the
+ * result does not depend on are removed.
+ *
+ * Syntax: numbers; x or x1 for the first scene, y or x2 for the second,
+ * x3 ... for further scenes; + - * / with products also written by
+ * juxtaposition ("2xy" is 2*x*y); < <= > >= == != && || ! giving 0 or 1;
+ * c ? a : b; min(...), max(...), abs(a), sqrt(a), if(c, a, b), and
+ * fsp(a, b), the fuzzy symmetric product of a and b on the scale 0 to
+ * 65534.  A condition is true where it is positive.  Division by 0 and
+ * the square root of a negative number give 0.  An expression in the
+ * quadratic form of earlier versions ("[<f>xx][+<f>xy]...") is evaluated
+ * exactly as before, and "fsp" alone is fsp(x, y).
+ */
+
+#ifndef __scene_expr_h
+#define __scene_expr_h
+
+#define SE_BLOCK 256	/* voxels computed by each run of a program */
+
+typedef struct {
+	const unsigned char *data;	/* one slice */
+	int bits;					/* 1 (packed), 8 or 16 */
+} SEInput;
+
+typedef struct {
+	int op, a, b, c;	/* operation and operand registers */
+	float k[6];			/* constant or quadratic coefficients */
+} SEInstr;
+
+typedef struct {
+	int ninputs;
+	int ninstr, max_instr;	/* instruction i computes register i */
+	SEInstr *instr;
+	int *order, norder;		/* instructions run, in order */
+} SEProgram;
+
+int se_init(SEProgram *prog, int ninputs);
+int se_compile(SEProgram *prog, const char *text);
+int se_select(SEProgram *prog, int mask, int a, int b);
+int se_finish(SEProgram *prog, int result);
+void se_range(const SEProgram *prog, int reg, const float min[],
+	const float max[], float *lo, float *hi);
+void se_start(const SEProgram *prog, float *regs);
+void se_eval(const SEProgram *prog, const SEInput in[], long start,
+	int count, float *regs);
+void se_free(SEProgram *prog);
+
+#endif
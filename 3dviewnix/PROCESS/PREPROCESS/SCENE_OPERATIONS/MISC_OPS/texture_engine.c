@@ -0,0 +1,790 @@
+/*
+  Copyright 1993-2015, 2018 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <math.h>
+#include <cv3dv.h>
+#include "texture_engine.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+#ifndef M_E
+#define M_E 2.71828182845904523536
+#endif
+
+/*****************************************************************************
+ * FUNCTION: texture_cooc_direction
+ * DESCRIPTION: Computes the neighbor offset and the region of pair centers
+ *    of a co-occurrence angle.
+ * PARAMETERS:
+ *    angle: one of 0, 45, 90, 135, 180, 225, 270, 315
+ *    distance: pixel distance between the pair
+ *    width, height: slice size
+ *    dir: receives the result
+ * RETURN VALUE: 0 on success, -1 for an unsupported angle
+ *****************************************************************************/
+int texture_cooc_direction(int angle, int distance, int width, int height,
+	CoocDirection *dir)
+{
+	switch (angle)
+	{
+		case 0:
+			dir->start_row = 0;
+			dir->end_row = height;
+			dir->start_col = 0;
+			dir->end_col = width-distance;
+			dir->offset = distance;
+			break;
+		case 45:
+			dir->start_row = distance;
+			dir->end_row = height;
+			dir->start_col = 0;
+			dir->end_col = width-distance;
+			dir->offset = distance*(1-width);
+			break;
+		case 90:
+			dir->start_row = distance;
+			dir->end_row = height;
+			dir->start_col = 0;
+			dir->end_col = width;
+			dir->offset = distance*-width;
+			break;
+		case 135:
+			dir->start_row = distance;
+			dir->end_row = height;
+			dir->start_col = distance;
+			dir->end_col = width;
+			dir->offset = distance*(-1-width);
+			break;
+		case 180:
+			dir->start_row = 0;
+			dir->end_row = height;
+			dir->start_col = distance;
+			dir->end_col = width;
+			dir->offset = distance*-1;
+			break;
+		case 225:
+			dir->start_row = 0;
+			dir->end_row = height-distance;
+			dir->start_col = distance;
+			dir->end_col = width;
+			dir->offset = distance*(-1+width);
+			break;
+		case 270:
+			dir->start_row = 0;
+			dir->end_row = height-distance;
+			dir->start_col = 0;
+			dir->end_col = width;
+			dir->offset = distance*width;
+			break;
+		case 315:
+			dir->start_row = 0;
+			dir->end_row = height-distance;
+			dir->start_col = 0;
+			dir->end_col = width-distance;
+			dir->offset = distance*(1+width);
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: cooc_window_init
+ * DESCRIPTION: Allocates a sliding co-occurrence window.
+ * PARAMETERS:
+ *    cw: the window
+ *    nbins: number of gray levels after mapping
+ *    dir, ndirs: the angles accumulated into the matrix
+ *    width, height: slice size
+ *    half_window: the window is 2*half_window+1 pixels square
+ * RETURN VALUE: 0 on success, 1 if out of memory
+ *****************************************************************************/
+int cooc_window_init(CoocWindow *cw, int nbins, const CoocDirection *dir,
+	int ndirs, int width, int height, int half_window)
+{
+	int n;
+
+	memset(cw, 0, sizeof(*cw));
+	cw->nbins = nbins;
+	cw->width = width;
+	cw->height = height;
+	cw->half_window = half_window;
+	cw->ndirs = ndirs;
+	memcpy(cw->dir, dir, ndirs*sizeof(CoocDirection));
+	cw->max_count = ndirs*(2*half_window+1)*(2*half_window+1);
+	cw->hist = (unsigned int *)malloc(nbins*nbins*sizeof(unsigned int));
+	cw->count_freq = (int *)malloc((cw->max_count+2)*sizeof(int));
+	cw->xlogx = (double *)malloc((cw->max_count+2)*sizeof(double));
+	cw->diff_count = (int *)malloc(nbins*sizeof(int));
+	if (cw->hist==NULL || cw->count_freq==NULL || cw->xlogx==NULL ||
+			cw->diff_count==NULL)
+	{
+		cooc_window_free(cw);
+		return 1;
+	}
+	cw->xlogx[0] = 0;
+	for (n=1; n<=cw->max_count+1; n++)
+		cw->xlogx[n] = n*log((double)n);
+	return 0;
+}
+
+void cooc_window_free(CoocWindow *cw)
+{
+	free(cw->hist);
+	free(cw->count_freq);
+	free(cw->xlogx);
+	free(cw->diff_count);
+	cw->hist = NULL;
+	cw->count_freq = cw->diff_count = NULL;
+	cw->xlogx = NULL;
+}
+
+static void cooc_add(CoocWindow *cw, int a, int b)
+{
+	unsigned int *h=cw->hist+a*cw->nbins+b;
+	int v=(int)*h;
+
+	if (v)
+		cw->count_freq[v]--;
+	cw->count_freq[v+1]++;
+	if (v+1 > cw->max_cell)
+		cw->max_cell = v+1;
+	cw->hlogh += cw->xlogx[v+1]-cw->xlogx[v];
+	cw->sum_sq += 2*v+1;
+	*h = v+1;
+	cw->count++;
+	cw->sum_a += a;
+	cw->sum_b += b;
+	cw->sum_a2 += a*a;
+	cw->sum_b2 += b*b;
+	cw->sum_ab += a*b;
+	cw->contrast += (a-b)*(a-b);
+	cw->diff_count[a>b? a-b: b-a]++;
+}
+
+static void cooc_remove(CoocWindow *cw, int a, int b)
+{
+	unsigned int *h=cw->hist+a*cw->nbins+b;
+	int v=(int)*h;
+
+	cw->count_freq[v]--;
+	if (v > 1)
+		cw->count_freq[v-1]++;
+	if (v==cw->max_cell && cw->count_freq[v]==0)
+		cw->max_cell = v-1;
+	cw->hlogh += cw->xlogx[v-1]-cw->xlogx[v];
+	cw->sum_sq -= 2*v-1;
+	*h = v-1;
+	cw->count--;
+	cw->sum_a -= a;
+	cw->sum_b -= b;
+	cw->sum_a2 -= a*a;
+	cw->sum_b2 -= b*b;
+	cw->sum_ab -= a*b;
+	cw->contrast -= (a-b)*(a-b);
+	cw->diff_count[a>b? a-b: b-a]--;
+}
+
+/* Add (sign>0) or remove the pairs centered in column k of the window
+   centered in row y. */
+static void cooc_column(CoocWindow *cw, const unsigned short *g, int k, int y,
+	int sign)
+{
+	int d, j, j0, j1, i;
+	const CoocDirection *dir;
+
+	for (d=0; d<cw->ndirs; d++)
+	{
+		dir = cw->dir+d;
+		if (k<dir->start_col || k>=dir->end_col)
+			continue;
+		j0 = y-cw->half_window;
+		if (j0 < dir->start_row)
+			j0 = dir->start_row;
+		j1 = y+cw->half_window+1;
+		if (j1 > dir->end_row)
+			j1 = dir->end_row;
+		for (j=j0; j<j1; j++)
+		{
+			i = cw->width*j+k;
+			if (sign > 0)
+				cooc_add(cw, g[i], g[i+dir->offset]);
+			else
+				cooc_remove(cw, g[i], g[i+dir->offset]);
+		}
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: cooc_window_start
+ * DESCRIPTION: Builds the co-occurrence matrix of the window centered at
+ *    (x, y) from scratch.
+ * PARAMETERS:
+ *    cw: the window
+ *    g: the gray-mapped slice
+ *    x, y: window center
+ *****************************************************************************/
+void cooc_window_start(CoocWindow *cw, const unsigned short *g, int x, int y)
+{
+	int k;
+
+	memset(cw->hist, 0, cw->nbins*cw->nbins*sizeof(unsigned int));
+	memset(cw->count_freq, 0, (cw->max_count+2)*sizeof(int));
+	cw->max_cell = 0;
+	cw->count = cw->sum_sq = cw->contrast = 0;
+	cw->sum_a = cw->sum_b = cw->sum_a2 = cw->sum_b2 = cw->sum_ab = 0;
+	memset(cw->diff_count, 0, cw->nbins*sizeof(int));
+	cw->hlogh = 0;
+	for (k=x-cw->half_window; k<=x+cw->half_window; k++)
+		cooc_column(cw, g, k, y, 1);
+}
+
+/*****************************************************************************
+ * FUNCTION: cooc_window_slide
+ * DESCRIPTION: Moves the window centered at (x, y) to (x+1, y).
+ *****************************************************************************/
+void cooc_window_slide(CoocWindow *cw, const unsigned short *g, int x, int y)
+{
+	cooc_column(cw, g, x-cw->half_window, y, -1);
+	cooc_column(cw, g, x+cw->half_window+1, y, 1);
+}
+
+/*****************************************************************************
+ * FUNCTION: cooc_window_feature
+ * DESCRIPTION: Computes a co-occurrence feature of the current window,
+ *    scaled to the 16-bit output range.
+ * PARAMETERS:
+ *    cw: the window
+ *    feature: 1=energy, 2=entropy, 3=maximum probability, 4=contrast,
+ *       5=inverse difference moment, 6=correlation
+ * RETURN VALUE: the output value
+ *****************************************************************************/
+unsigned short cooc_window_feature(const CoocWindow *cw, int feature)
+{
+	double count=(double)cw->count, var_x, var_y, idm;
+	int d;
+
+	if (cw->count == 0)
+		return 0;
+	switch (feature)
+	{
+		case 1: // energy
+			return (unsigned short)rint(65535*(double)cw->sum_sq/(count*count));
+		case 2: // entropy
+			return (unsigned short)rint(-65535*M_E/(cw->nbins*cw->nbins)/
+				count*(cw->hlogh-count*log(count)));
+		case 3: // maximum probability
+			return (unsigned short)rint(65535/count*cw->max_cell);
+		case 4: // contrast
+			return (unsigned short)rint(65535./((cw->nbins-1)*(cw->nbins-1))/
+				count*cw->contrast);
+		case 5: // inverse difference moment
+			for (idm=0,d=1; d<cw->nbins; d++)
+				idm += (double)cw->diff_count[d]/(d*d);
+			return (unsigned short)rint(65535/count*idm);
+		case 6: // correlation
+			var_x = (double)(cw->count*cw->sum_a2-cw->sum_a*cw->sum_a);
+			var_y = (double)(cw->count*cw->sum_b2-cw->sum_b*cw->sum_b);
+			if (var_x<=0 || var_y<=0)
+				return 65535;
+			return (unsigned short)rint(32767.5*(1+
+				(count*cw->sum_ab-(double)cw->sum_a*cw->sum_b)/
+				sqrt(var_x*var_y)));
+		default:
+			fprintf(stderr, "Feature %d not implemented.\n", feature);
+			exit(-1);
+	}
+}
+
+/* Pixel index of position t along line l of an angle. */
+static int rlm_pixel(const RLMSlice *s, int angle, int l, int t)
+{
+	switch (angle)
+	{
+		case 0:
+			return s->width*l+t;
+		case 45:
+			return s->width*(l-t)+t;
+		case 90:
+			return s->width*t+l;
+		default: // 135
+			return s->width*(t-l)+t;
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: rlm_slice_init
+ * DESCRIPTION: Computes, for each pixel and angle, the number of equal
+ *    gray levels ahead of and behind it along the angle (itself included).
+ * PARAMETERS:
+ *    s: receives the result
+ *    g: the gray-mapped slice; referenced, not copied
+ *    width, height: slice size
+ *    angle, ndirs: angles among 0, 45, 90, 135
+ *    run_map: run length to bin for axis and diagonal angles
+ * RETURN VALUE: 0 on success, 1 if out of memory
+ *****************************************************************************/
+int rlm_slice_init(RLMSlice *s, const unsigned short *g, int width,
+	int height, const int *angle, int ndirs, int *run_map[2])
+{
+	int d, x, y, i, ex, ey, nx, ny, n;
+
+	memset(s, 0, sizeof(*s));
+	s->width = width;
+	s->height = height;
+	s->g = g;
+	s->ndirs = ndirs;
+	s->run_map[0] = run_map[0];
+	s->run_map[1] = run_map[1];
+	for (d=0; d<ndirs; d++)
+	{
+		s->angle[d] = angle[d];
+		s->fwd[d] = (int *)malloc(width*height*sizeof(int));
+		s->bwd[d] = (int *)malloc(width*height*sizeof(int));
+		if (s->fwd[d]==NULL || s->bwd[d]==NULL)
+		{
+			rlm_slice_free(s);
+			return 1;
+		}
+		ex = angle[d]==90? 0: 1;
+		ey = angle[d]==0? 0: angle[d]==45? -1: 1;
+		/* forward: visit (x+ex, y+ey) before (x, y) */
+		for (n=0; n<height; n++)
+		{
+			y = ey>0? height-1-n: n;
+			for (x=width-1; x>=0; x--)
+			{
+				i = width*y+x;
+				nx = x+ex;
+				ny = y+ey;
+				s->fwd[d][i] = nx<width && ny>=0 && ny<height &&
+					g[width*ny+nx]==g[i]? s->fwd[d][width*ny+nx]+1: 1;
+			}
+		}
+		for (n=0; n<height; n++)
+		{
+			y = ey>0? n: height-1-n;
+			for (x=0; x<width; x++)
+			{
+				i = width*y+x;
+				nx = x-ex;
+				ny = y-ey;
+				s->bwd[d][i] = nx>=0 && ny>=0 && ny<height &&
+					g[width*ny+nx]==g[i]? s->bwd[d][width*ny+nx]+1: 1;
+			}
+		}
+	}
+	return 0;
+}
+
+void rlm_slice_free(RLMSlice *s)
+{
+	int d;
+
+	for (d=0; d<4; d++)
+	{
+		free(s->fwd[d]);
+		free(s->bwd[d]);
+		s->fwd[d] = s->bwd[d] = NULL;
+	}
+}
+
+int rlm_window_init(RLMWindow *rw, const RLMSlice *s, int nbins,
+	int nrun_bins, int half_window)
+{
+	memset(rw, 0, sizeof(*rw));
+	rw->s = s;
+	rw->nbins = nbins;
+	rw->nrun_bins = nrun_bins;
+	rw->half_window = half_window;
+	rw->hist =
+		(unsigned int *)malloc(nrun_bins*nbins*sizeof(unsigned int));
+	rw->run_sum = (long long *)malloc(nrun_bins*sizeof(long long));
+	rw->gray_sum = (long long *)malloc(nbins*sizeof(long long));
+	if (rw->hist==NULL || rw->run_sum==NULL || rw->gray_sum==NULL)
+	{
+		rlm_window_free(rw);
+		return 1;
+	}
+	return 0;
+}
+
+void rlm_window_free(RLMWindow *rw)
+{
+	free(rw->hist);
+	free(rw->run_sum);
+	free(rw->gray_sum);
+	rw->hist = NULL;
+	rw->run_sum = rw->gray_sum = NULL;
+}
+
+static void rlm_change(RLMWindow *rw, int angle, int run, int gray, int sign)
+{
+	int h=rw->s->run_map[angle/45%2][run];
+
+	rw->hist[h*rw->nbins+gray] += sign;
+	rw->count += sign;
+	rw->sum_r2 += sign*2*rw->run_sum[h]+1;
+	rw->run_sum[h] += sign;
+	rw->sum_g2 += sign*2*rw->gray_sum[gray]+1;
+	rw->gray_sum[gray] += sign;
+}
+
+/* Remove the first pixel of the segment [lo, hi] of line l. */
+static void rlm_remove_start(RLMWindow *rw, int d, int l, int lo, int hi)
+{
+	const RLMSlice *s=rw->s;
+	int i=rlm_pixel(s, s->angle[d], l, lo), run=s->fwd[d][i];
+
+	if (run > hi-lo+1)
+		run = hi-lo+1;
+	rlm_change(rw, s->angle[d], run, s->g[i], -1);
+	if (run > 1)
+		rlm_change(rw, s->angle[d], run-1, s->g[i], 1);
+}
+
+/* Append pixel hi+1 to the (possibly empty) segment [lo, hi] of line l. */
+static void rlm_add_end(RLMWindow *rw, int d, int l, int lo, int hi)
+{
+	const RLMSlice *s=rw->s;
+	int i=rlm_pixel(s, s->angle[d], l, hi+1), p, run;
+
+	if (hi >= lo)
+	{
+		p = rlm_pixel(s, s->angle[d], l, hi);
+		if (s->g[p] == s->g[i])
+		{
+			run = s->bwd[d][p];
+			if (run > hi-lo+1)
+				run = hi-lo+1;
+			rlm_change(rw, s->angle[d], run, s->g[i], -1);
+			rlm_change(rw, s->angle[d], run+1, s->g[i], 1);
+			return;
+		}
+	}
+	rlm_change(rw, s->angle[d], 1, s->g[i], 1);
+}
+
+/* Lines of an angle crossing the window centered at (x, y), and the
+   segment of line l inside it; lo > hi for an empty segment. */
+static void rlm_lines(int angle, int x, int y, int w, int *l0, int *l1)
+{
+	switch (angle)
+	{
+		case 0:
+			*l0 = y-w;
+			*l1 = y+w;
+			break;
+		case 45:
+			*l0 = x+y-2*w;
+			*l1 = x+y+2*w;
+			break;
+		case 90:
+			*l0 = x-w;
+			*l1 = x+w;
+			break;
+		default: // 135
+			*l0 = x-y-2*w;
+			*l1 = x-y+2*w;
+	}
+}
+
+static void rlm_segment(int angle, int x, int y, int w, int l, int *lo,
+	int *hi)
+{
+	int l0, l1;
+
+	rlm_lines(angle, x, y, w, &l0, &l1);
+	if (l<l0 || l>l1)
+	{
+		*lo = 1;
+		*hi = 0;
+		return;
+	}
+	switch (angle)
+	{
+		case 0:
+			*lo = x-w;
+			*hi = x+w;
+			break;
+		case 45:
+			*lo = x-w>l-y-w? x-w: l-y-w;
+			*hi = x+w<l-y+w? x+w: l-y+w;
+			break;
+		case 90:
+			*lo = y-w;
+			*hi = y+w;
+			break;
+		default: // 135
+			*lo = x-w>l+y-w? x-w: l+y-w;
+			*hi = x+w<l+y+w? x+w: l+y+w;
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: rlm_window_start
+ * DESCRIPTION: Builds the run-length matrix of the window centered at
+ *    (x, y) from scratch.  The window must lie inside the slice.
+ *****************************************************************************/
+void rlm_window_start(RLMWindow *rw, int x, int y)
+{
+	int d, l, l0, l1, lo, hi, t, w=rw->half_window;
+
+	memset(rw->hist, 0, rw->nrun_bins*rw->nbins*sizeof(unsigned int));
+	memset(rw->run_sum, 0, rw->nrun_bins*sizeof(long long));
+	memset(rw->gray_sum, 0, rw->nbins*sizeof(long long));
+	rw->count = rw->sum_g2 = rw->sum_r2 = 0;
+	for (d=0; d<rw->s->ndirs; d++)
+	{
+		rlm_lines(rw->s->angle[d], x, y, w, &l0, &l1);
+		for (l=l0; l<=l1; l++)
+		{
+			rlm_segment(rw->s->angle[d], x, y, w, l, &lo, &hi);
+			for (t=lo; t<=hi; t++)
+				rlm_add_end(rw, d, l, lo, t-1);
+		}
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: rlm_window_slide
+ * DESCRIPTION: Moves the window centered at (x, y) to (x+1, y).  Each line
+ *    loses pixels only at its start and gains them only at its end.
+ *****************************************************************************/
+void rlm_window_slide(RLMWindow *rw, int x, int y)
+{
+	int d, angle, l, l0, l1, n0, n1, lo0, hi0, lo1, hi1, w=rw->half_window;
+
+	for (d=0; d<rw->s->ndirs; d++)
+	{
+		angle = rw->s->angle[d];
+		rlm_lines(angle, x, y, w, &l0, &l1);
+		rlm_lines(angle, x+1, y, w, &n0, &n1);
+		if (n0 < l0)
+			l0 = n0;
+		if (n1 > l1)
+			l1 = n1;
+		for (l=l0; l<=l1; l++)
+		{
+			rlm_segment(angle, x, y, w, l, &lo0, &hi0);
+			rlm_segment(angle, x+1, y, w, l, &lo1, &hi1);
+			while (lo0<=hi0 && (lo0<lo1 || lo1>hi1))
+			{
+				rlm_remove_start(rw, d, l, lo0, hi0);
+				lo0++;
+			}
+			if (lo1 > hi1)
+				continue;
+			if (lo0 > hi0)
+			{
+				lo0 = lo1;
+				hi0 = lo1-1;
+			}
+			while (hi0 < hi1)
+			{
+				rlm_add_end(rw, d, l, lo0, hi0);
+				hi0++;
+			}
+		}
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: rlm_window_feature
+ * DESCRIPTION: Computes a run-length feature of the current window,
+ *    scaled to the 16-bit output range.
+ * PARAMETERS:
+ *    rw: the window
+ *    feature: 1=short runs emphasis, 2=long runs emphasis, 3=gray level
+ *       nonuniformity, 4=run length nonuniformity, 5=run percentage
+ *    all_angles: non-zero if the 4 angles are accumulated together
+ * RETURN VALUE: the output value
+ *****************************************************************************/
+unsigned short rlm_window_feature(const RLMWindow *rw, int feature,
+	int all_angles)
+{
+	double count=(double)rw->count, cur_count=0, ov;
+	int h, i, ws=2*rw->half_window+1;
+	const unsigned int *row;
+
+	if (rw->count == 0)
+		return 0;
+	switch (feature)
+	{
+		case 1: // short runs emphasis
+			/* cell by cell, as the quotients are inexact and the sum has
+			   always been rounded in this order */
+			for (h=0,row=rw->hist; h<rw->nrun_bins; h++,row+=rw->nbins)
+				for (i=0; i<rw->nbins; i++)
+					if (row[i])
+						cur_count += (double)row[i]/((h+1)*(h+1));
+			ov = 65535./count*cur_count;
+			break;
+		case 2: // long runs emphasis
+			for (h=0; h<rw->nrun_bins; h++)
+				cur_count += (double)rw->run_sum[h]*((h+1)*(h+1));
+			ov = 65535./(rw->nrun_bins*rw->nrun_bins)/count*cur_count;
+			break;
+		case 3: // gray level nonuniformity
+			ov = 65535./(all_angles? 4:1)/ws/ws/count*rw->sum_g2;
+			break;
+		case 4: // run length nonuniformity
+			ov = 65535./ws/ws/count*rw->sum_r2;
+			break;
+		case 5: // run percentage
+			ov = 65535./(all_angles? 4:1)/ws/ws*count;
+			break;
+		default:
+			fprintf(stderr, "Feature %d not implemented.\n", feature);
+			exit(-1);
+	}
+	if (ov > 65535)
+		ov = 65535;
+	return (unsigned short)rint(ov);
+}
+
+/*****************************************************************************
+ * FUNCTION: lbp_sampling_init
+ * DESCRIPTION: Computes the bilinear sample positions on a circle and the
+ *    region of pixels whose samples all lie inside the slice.
+ * PARAMETERS:
+ *    ls: receives the result
+ *    radius, nsamples: the circle
+ *    width, height: slice size
+ * RETURN VALUE: 0 on success, 1 if out of memory
+ *****************************************************************************/
+int lbp_sampling_init(LBPSampling *ls, float radius, int nsamples,
+	int width, int height)
+{
+	int m, ix, iy;
+	double tx, ty;
+
+	ls->nsamples = nsamples;
+	ls->width = width;
+	ls->start_row = 0;
+	ls->end_row = height;
+	ls->start_col = 0;
+	ls->end_col = width;
+	ls->offset = (int *)malloc(nsamples*sizeof(int));
+	ls->fx = (float *)malloc(nsamples*sizeof(float));
+	ls->fy = (float *)malloc(nsamples*sizeof(float));
+	if (ls->offset==NULL || ls->fx==NULL || ls->fy==NULL)
+	{
+		lbp_sampling_free(ls);
+		return 1;
+	}
+	for (m=0; m<nsamples; m++)
+	{
+		tx = radius*cos(2*M_PI*m/nsamples);
+		ty = radius*sin(2*M_PI*m/nsamples);
+		ix = (int)floor(tx);
+		iy = (int)floor(ty);
+		ls->fx[m] = (float)(tx-ix);
+		ls->fy[m] = (float)(ty-iy);
+		if (ix>0 && ls->fx[m]<=0)
+		{
+			ix--;
+			ls->fx[m] = 1;
+		}
+		if (iy>0 && ls->fy[m]<=0)
+		{
+			iy--;
+			ls->fy[m] = 1;
+		}
+		if (ix<0 && ls->fx[m]>=1)
+		{
+			ix++;
+			ls->fx[m] = 0;
+		}
+		if (iy<0 && ls->fy[m]>=1)
+		{
+			iy++;
+			ls->fy[m] = 0;
+		}
+		if (-ix > ls->start_col)
+			ls->start_col = -ix;
+		if (-iy > ls->start_row)
+			ls->start_row = -iy;
+		if (width-1-ix < ls->end_col)
+			ls->end_col = width-1-ix;
+		if (height-1-iy < ls->end_row)
+			ls->end_row = height-1-iy;
+		ls->offset[m] = width*iy+ix;
+	}
+	return 0;
+}
+
+void lbp_sampling_free(LBPSampling *ls)
+{
+	free(ls->offset);
+	free(ls->fx);
+	free(ls->fy);
+	ls->offset = NULL;
+	ls->fx = ls->fy = NULL;
+}
+
+/* Bilinear sample m around pixel i. */
+#define LBP_SAMPLE(in, i, m) \
+	((1-ls->fy[m])*((1-ls->fx[m])*in[i+ls->offset[m]]+ \
+	                   ls->fx[m] *in[i+ls->offset[m]+1])+ \
+	    ls->fy[m] *((1-ls->fx[m])*in[i+ls->offset[m]+ls->width]+ \
+	                   ls->fx[m] *in[i+ls->offset[m]+ls->width+1]))
+
+/*****************************************************************************
+ * FUNCTION: lbp_code
+ * DESCRIPTION: Computes the rotation-invariant uniform LBP code of a pixel.
+ * PARAMETERS:
+ *    ls: the sampling
+ *    in: the slice, 1 or 2 bytes per pixel
+ *    bytes: bytes per pixel
+ *    index: pixel index; must be inside the sampling region
+ * RETURN VALUE: the number of samples >= the center for uniform patterns,
+ *    nsamples+1 otherwise
+ *****************************************************************************/
+int lbp_code(const LBPSampling *ls, const unsigned char *in, int bytes,
+	int index)
+{
+	const unsigned short *in2=(const unsigned short *)in;
+	int m, cen_val, nei_val, first=0, prev=0, up=0, transitions=0;
+	float v;
+
+	cen_val = bytes==2? in2[index]: in[index];
+	for (m=0; m<ls->nsamples; m++)
+	{
+		if (bytes == 2)
+			v = LBP_SAMPLE(in2, index, m);
+		else
+			v = LBP_SAMPLE(in, index, m);
+		nei_val = v >= cen_val;
+		if (m == 0)
+			first = nei_val;
+		else if (nei_val != prev)
+			transitions++;
+		up += nei_val;
+		prev = nei_val;
+	}
+	if (first != prev)
+		transitions++;
+	return transitions<=2? up: ls->nsamples+1;
+}
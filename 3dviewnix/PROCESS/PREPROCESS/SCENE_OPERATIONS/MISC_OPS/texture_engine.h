@@ -0,0 +1,113 @@
+/*
+  Copyright 1993-2015, 2018 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Texture feature engine shared by texture_image and texture_stats.
+ *
+ * The sliding-window engines keep the co-occurrence or run-length matrix
+ * of the current window plus the sums its features are derived from.
+ * Moving the window one pixel to the right removes the leaving column and
+ * adds the entering one, so a window costs O(window size) instead of
+ * O(window size squared) plus a pass over the whole matrix.  Each thread
+ * owns its own window; the slice data are shared read-only.
+ */
+
+#ifndef __texture_engine_h
+#define __texture_engine_h
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#define omp_get_thread_num()  0
+#endif
+
+/* Pixel pairs of one co-occurrence angle: the neighbor of the pixel at
+   index i is at i+offset; pair centers lie in [start_row, end_row) x
+   [start_col, end_col). */
+typedef struct {
+	int offset;
+	int start_row, end_row, start_col, end_col;
+} CoocDirection;
+
+typedef struct {
+	int nbins, width, height, half_window, ndirs;
+	CoocDirection dir[8];
+	unsigned int *hist;     /* nbins x nbins */
+	int *count_freq;        /* number of cells holding each count */
+	int *diff_count;        /* number of pairs with each |a-b| */
+	double *xlogx;          /* n*log(n) */
+	int max_cell, max_count;
+	long long count, sum_sq, contrast, sum_a, sum_b, sum_a2, sum_b2, sum_ab;
+	double hlogh;
+} CoocWindow;
+
+/* Gray-level runs of one slice along up to 4 angles (0, 45, 90, 135). */
+typedef struct {
+	int width, height, ndirs, angle[4];
+	const unsigned short *g;    /* gray-mapped slice */
+	int *fwd[4], *bwd[4];       /* run length ahead of / behind each pixel */
+	int *run_map[2];            /* run length -> bin, axis / diagonal */
+} RLMSlice;
+
+typedef struct {
+	const RLMSlice *s;
+	int nbins, nrun_bins, half_window;
+	unsigned int *hist;     /* nrun_bins x nbins */
+	long long *run_sum, *gray_sum;
+	long long count, sum_g2, sum_r2;
+} RLMWindow;
+
+/* Bilinear circular sampling for local binary patterns. */
+typedef struct {
+	int nsamples, width, *offset;
+	float *fx, *fy;
+	int start_row, end_row, start_col, end_col;
+} LBPSampling;
+
+int texture_cooc_direction(int angle, int distance, int width, int height,
+	CoocDirection *dir);
+
+int cooc_window_init(CoocWindow *cw, int nbins, const CoocDirection *dir,
+	int ndirs, int width, int height, int half_window);
+void cooc_window_free(CoocWindow *cw);
+void cooc_window_start(CoocWindow *cw, const unsigned short *g, int x, int y);
+void cooc_window_slide(CoocWindow *cw, const unsigned short *g, int x, int y);
+unsigned short cooc_window_feature(const CoocWindow *cw, int feature);
+
+int rlm_slice_init(RLMSlice *s, const unsigned short *g, int width,
+	int height, const int *angle, int ndirs, int *run_map[2]);
+void rlm_slice_free(RLMSlice *s);
+int rlm_window_init(RLMWindow *rw, const RLMSlice *s, int nbins,
+	int nrun_bins, int half_window);
+void rlm_window_free(RLMWindow *rw);
+void rlm_window_start(RLMWindow *rw, int x, int y);
+void rlm_window_slide(RLMWindow *rw, int x, int y);
+unsigned short rlm_window_feature(const RLMWindow *rw, int feature,
+	int all_angles);
+
+int lbp_sampling_init(LBPSampling *ls, float radius, int nsamples,
+	int width, int height);
+void lbp_sampling_free(LBPSampling *ls);
+int lbp_code(const LBPSampling *ls, const unsigned char *in, int bytes,
+	int index);
+
+#endif
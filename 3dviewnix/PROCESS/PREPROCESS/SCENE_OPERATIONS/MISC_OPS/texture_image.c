@@ -21,26 +21,18 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <math.h>
-#include <assert.h>
 #include <cv3dv.h>
-
-#ifndef M_PI
-#define M_PI 3.1415926535897932384626433832795
-#endif
-#ifndef M_E
-#define M_E 2.71828182845904523536
-#endif
+#include "texture_engine.h"
 
 void bin_to_grey(unsigned char *bin_buffer, int length,
      unsigned char *grey_buffer, int min_value, int max_value);
 void destroy_scene_header(ViewnixHeader *vh);
-void get_co_occurrence(double **joint_hist, unsigned char *in, int bytes,
-	int width, int height, int angle, int distance,
-	int window_size, int x, int y, unsigned short gray_map[0x10000]);
-void get_RLM(double **joint_hist, unsigned char *in, int bytes,
-	int width, int height, int angle,
-    int window_size, int x, int y,
-    unsigned short gray_map[0x10000], int *run_map);
+void get_co_occurrence_image(unsigned short *out, unsigned short *g,
+    unsigned char *mask, int width, int height, int angle, int distance,
+    int nbins, int window_size, int feature);
+void get_RLM_image(unsigned short *out, unsigned short *g,
+    unsigned char *mask, int width, int height, int angle, int nbins,
+    int num_run_bins, int window_size, int feature, int *run_map[2]);
 void get_LBP_image(unsigned char *out_8, unsigned char *in, int bytes,
     int width, int height, float radius, int nsamples);
 int get_slices(int dim, short *list);
@@ -60,9 +52,10 @@ char *argv[];
   unsigned short *data_out_16;
   char group[6],elem[6];
   float radius;
-  double **joint_hist, count=0, cur_count;
+  double count=0, cur_count;
   static double gray_hist[0x10000];
   static unsigned short gray_map[0x10000];
+  unsigned short *gray_slice=NULL;
   int *run_bin_end[2]; // along axis / diagonal
   int rl_feature=0;
   int *run_map[2]; // along axis / diagonal
@@ -107,6 +100,24 @@ char *argv[];
     fprintf(stderr, "Too many samples\n");
 	exit(-1);
   }
+  if (argc >= 8)
+  {
+    CoocDirection dir;
+
+    if (rl_feature? rl_feature>5: feature<1 || feature>6)
+    {
+      fprintf(stderr, "Feature %d not implemented.\n",
+        rl_feature? rl_feature: feature);
+      exit(-1);
+    }
+    if (rl_feature? angle<0 || angle>360 || angle%45:
+        angle!=360 && texture_cooc_direction(angle, distance, 1, 1, &dir))
+    {
+      fprintf(stderr, rl_feature? "Angle must be one of 0, 45, 90, 135.\n":
+        "Angle must be one of 0, 45, 90, 135, 180, 225, 270, 315.\n");
+      exit(-1);
+    }
+  }
   in1 = fopen(argv[1], "rb");
   if (in1 == NULL)
   {
@@ -257,16 +268,11 @@ char *argv[];
         printf("gray level = %d\n", j);
       }
     }
-    joint_hist =
-      (double **)malloc((rl_feature? distance:nbins)*sizeof(double *));
-    for (j=0; j<(rl_feature? distance:nbins); j++)
+    gray_slice = (unsigned short *)malloc(size*sizeof(unsigned short));
+    if (gray_slice == NULL)
     {
-      joint_hist[j] = (double *)calloc(nbins, sizeof(double));
-      if (joint_hist[j] == NULL)
-      {
-        fprintf(stderr, "Out of memory\n");
-        exit(1);
-      }
+      fprintf(stderr, "Out of memory\n");
+      exit(1);
     }
   }
 
@@ -325,8 +331,6 @@ char *argv[];
         vh1.scn.xysize[0], vh1.scn.xysize[1], radius, nsamples);
     else // co-occurrence or run length
     {
-      int x, y, h;
-	  double ps;
       if (argc == 11)
       {
           if (j < slices2) {
@@ -339,212 +343,17 @@ char *argv[];
           else
             memset(d2_8,0,size);
       }
-      for (y=0; y<vh1.scn.xysize[1]; y++)
-        for (x=0; x<vh1.scn.xysize[0]; x++)
-        {
-          double mu_x, mu_y, mu2_x, mu2_y, ov;
-          if (argc==11 && d2_8[vh2.scn.xysize[0]*y+x]==0)
-		  {
-		    data_out_16[y*vh1.scn.xysize[0]+x] = 0;
-			continue;
-		  }
-          if (rl_feature)
-          {
-            if (y<window_size || y>=vh1.scn.xysize[1]-window_size ||
-                x<window_size || x>=vh1.scn.xysize[0]-window_size)
-            {
-		      data_out_16[y*vh1.scn.xysize[0]+x] = 0;
-			  continue;
-            }
-            if (angle > 180)
-              angle -= 180;
-            for (h=0; h<distance; h++)
-              for (i=0; i<nbins; i++)
-                joint_hist[h][i] = 0;
-            if (angle == 180)
-              for (h=0; h<180; h+=45)
-                get_RLM(joint_hist, d1_8, bytes,
-                  vh1.scn.xysize[0], vh1.scn.xysize[1], h,
-                  2*window_size+1, x-window_size, y-window_size,
-                  gray_map, run_map[h/45%2]);
-            else
-              get_RLM(joint_hist, d1_8, bytes,
-                vh1.scn.xysize[0], vh1.scn.xysize[1], angle,
-                2*window_size+1, x-window_size, y-window_size,
-                gray_map, run_map[angle/45%2]);
-            // compute feature
-            cur_count = count = 0;
-            for (h=0; h<distance; h++)
-              for (i=0; i<nbins; i++)
-                count += joint_hist[h][i];
-            assert(count <=
-              (2*window_size+1)*(2*window_size+1)*(angle<180? 1:4));
-            switch (rl_feature)
-            {
-              case 1: // short runs emphasis
-                for (h=0; h<distance; h++)
-                  for (i=0; i<nbins; i++)
-                    cur_count += joint_hist[h][i]/((h+1)*(h+1));
-                ov = 65535./count*cur_count;
-                if (ov > 65535)
-                  ov = 65535;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(ov);
-                break;
-              case 2: // long runs emphasis
-                for (h=0; h<distance; h++)
-                  for (i=0; i<nbins; i++)
-                    cur_count += joint_hist[h][i]*((h+1)*(h+1));
-                ov = 65535./(distance*distance)/count*cur_count;
-                if (ov > 65535)
-                  ov = 65535;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(ov);
-                break;
-              case 3: // gray level nonuniformity
-                for (i=0; i<nbins; i++)
-                {
-                  ps = 0;
-                  for (h=0; h<distance; h++)
-                    ps += joint_hist[h][i];
-                  cur_count += ps*ps;
-                }
-                h = 2*window_size+1;
-                ov = 65535./(angle<180? 1:4)/h/h/count*cur_count;
-                if (ov > 65535)
-                  ov = 65535;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(ov);
-                break;
-              case 4: // run length nonuniformity
-                for (h=0; h<distance; h++)
-                {
-                  ps = 0;
-                  for (i=0; i<nbins; i++)
-                    ps += joint_hist[h][i];
-                  cur_count += ps*ps;
-                }
-                h = 2*window_size+1;
-                ov = 65535./h/h/count*cur_count;
-                if (ov > 65535)
-                  ov = 65535;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(ov);
-                break;
-              case 5:
-                h = 2*window_size+1;
-                ov = 65535./(angle<180? 1:4)/h/h*count;
-                if (ov > 65535)
-                  ov = 65535;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(ov);
-                break;
-              default:
-                fprintf(stderr, "Feature %d not implemented.\n", feature);
-                exit(-1);
-            }
-          }
-          else // co_occurrence
-          {
-            for (h=0; h<nbins; h++)
-              for (i=0; i<nbins; i++)
-                joint_hist[h][i] = 0;
-            if (angle == 360)
-              for (h=0; h<360; h+=45)
-                get_co_occurrence(joint_hist, d1_8, bytes,
-                  vh1.scn.xysize[0], vh1.scn.xysize[1], h, distance,
-                  window_size, x, y, gray_map);
-            else
-              get_co_occurrence(joint_hist, d1_8, bytes,
-                vh1.scn.xysize[0], vh1.scn.xysize[1], angle, distance,
-                window_size, x, y, gray_map);
-            // compute feature
-            cur_count = count = 0;
-            for (h=0; h<nbins; h++)
-              for (i=0; i<nbins; i++)
-                count += joint_hist[h][i];
-            assert(count <=
-              (2*window_size+1)*(2*window_size+1)*(angle<360? 1:8));
-            assert(x<window_size+distance ||
-                   x>=vh1.scn.xysize[0]-window_size-distance ||
-                   y<window_size+distance ||
-                   y>=vh1.scn.xysize[1]-window_size-distance ||
-                   angle==360 || count==(2*window_size+1)*(2*window_size+1));
-            switch (feature)
-            {
-              case 1: // energy
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    cur_count += joint_hist[h][i]*joint_hist[h][i];
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(
-                  65535*cur_count/(count*count));
-                break;
-              case 2: // entropy
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    if (joint_hist[h][i])
-                      cur_count +=
-                        joint_hist[h][i]*log(1/count*joint_hist[h][i]);
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(
-                  -65535*M_E/(nbins*nbins)/count*cur_count);
-                break;
-              case 3: // maximum probability
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    if (joint_hist[h][i] > cur_count)
-                      cur_count = joint_hist[h][i];
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(
-                  65535/count*cur_count);
-                break;
-              case 4: // contrast
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    if (i != h)
-                      cur_count += joint_hist[h][i]*(i-h)*(i-h);
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(
-                  65535./((nbins-1)*(nbins-1))/count*cur_count);
-                break;
-              case 5: // inverse difference moment
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    if (i != h)
-                      cur_count += joint_hist[h][i]/((i-h)*(i-h));
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)rint(
-                  65535/count*cur_count);
-                break;
-              case 6: // correlation
-                mu_x = mu_y = mu2_x = mu2_y = 0;
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                  {
-                    if (h)
-                      mu_x += joint_hist[h][i]*h;
-                    if (i)
-                      mu_y += joint_hist[h][i]*i;
-                  }
-                mu_x *= 1/count;
-                mu_y *= 1/count;
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                  {
-                    mu2_x += (h-mu_x)*(h-mu_x)*joint_hist[h][i];
-                    mu2_y += (i-mu_y)*(i-mu_y)*joint_hist[h][i];
-                  }
-                if (mu2_x<=0 || mu2_y<=0)
-                {
-                  data_out_16[y*vh1.scn.xysize[0]+x] = 65535;
-                  break;
-                }
-                mu2_x *= 1/count;
-                mu2_y *= 1/count;
-                for (h=0; h<nbins; h++)
-                  for (i=0; i<nbins; i++)
-                    cur_count += h*i*joint_hist[h][i];
-                cur_count *= 1/count;
-                data_out_16[y*vh1.scn.xysize[0]+x] = (unsigned short)
-                  rint(32767.5*(1+(cur_count-mu_x*mu_y)/sqrt(mu2_x*mu2_y)));
-                break;
-              default:
-                fprintf(stderr, "Feature %d not implemented.\n", feature);
-                exit(-1);
-            }
-          }
-        }
+      for (i=0; i<size; i++)
+        gray_slice[i] = gray_map[bytes==2? ((unsigned short *)d1_8)[i]:
+          d1_8[i]];
+      if (rl_feature)
+        get_RLM_image(data_out_16, gray_slice, argc==11? d2_8: NULL,
+          vh1.scn.xysize[0], vh1.scn.xysize[1], angle, nbins, distance,
+          window_size, rl_feature, run_map);
+      else
+        get_co_occurrence_image(data_out_16, gray_slice,
+          argc==11? d2_8: NULL, vh1.scn.xysize[0], vh1.scn.xysize[1],
+          angle, distance, nbins, window_size, feature);
     }
     error = VWriteData((char*)data_out_8, out_bytes, size, out, &i);
     if (error)
@@ -561,6 +370,8 @@ char *argv[];
     fclose(in2);
     destroy_scene_header(&vh2);
   }
+  if (argc > 5)
+    free(gray_slice);
   free(data1);
   free(d1_8);
   destroy_scene_header(&vh1);
@@ -569,390 +380,177 @@ char *argv[];
 }
 
 
-void get_RLM(double **joint_hist, unsigned char *in, int bytes,
-	int width, int height, int angle,
-    int window_size, int x, int y,
-    unsigned short gray_map[0x10000], int *run_map)
+/*****************************************************************************
+ * FUNCTION: get_RLM_image
+ * DESCRIPTION: Computes a run-length feature in a sliding window around
+ *    each pixel of a slice.  Rows are distributed among threads; each
+ *    thread slides its own window along a row.
+ * PARAMETERS:
+ *    out: the output slice
+ *    g: the gray-mapped slice
+ *    mask: pixels where mask is 0 are set to 0; NULL for no mask
+ *    width, height: slice size
+ *    angle: 0, 45, 90, 135 (+180), or 180 for all four
+ *    nbins: number of gray levels in g
+ *    num_run_bins: number of run length bins
+ *    window_size: the window is 2*window_size+1 pixels square
+ *    feature: 1 to 5, see rlm_window_feature
+ *    run_map: run length to bin, along axis / diagonal
+ * SIDE EFFECTS: Exits on failure to allocate memory.
+ * RETURN VALUE: None
+ *****************************************************************************/
+void get_RLM_image(unsigned short *out, unsigned short *g,
+    unsigned char *mask, int width, int height, int angle, int nbins,
+    int num_run_bins, int window_size, int feature, int *run_map[2])
 {
-	int cx, cy, cv, pv, rl, s;
+	static const int all_angles[4]={0, 45, 90, 135};
+	RLMSlice slice;
+	int y, error=0;
 
-	switch (angle)
+	if (angle > 180)
+		angle -= 180;
+	if (rlm_slice_init(&slice, g, width, height,
+			angle==180? all_angles: &angle, angle==180? 4: 1, run_map))
 	{
-		case 0:
-			for (cy=y; cy<y+window_size; cy++)
-			{
-				for (cx=x,rl=1,cv=-1; ;)
-				{
-					pv = cv;
-					if (cx == x+window_size)
-						cv = -1;
-					else
-						switch (bytes)
-						{
-							case 1:
-								cv = gray_map[in[width*cy+cx]];
-								break;
-							case 2:
-								cv =
-								 gray_map[((unsigned short *)in)[width*cy+cx]];
-								break;
-							default:
-								fprintf(stderr,
-									"%d-byte data not supported.\n", bytes);
-								exit(-1);
-						}
-					cx++;
-					if (cv == pv)
-						rl++;
-					else
-					{
-						if (pv >= 0)
-						{
-							joint_hist[run_map[rl]][pv]++;
-							rl = 1;
-						}
-						if (cv < 0)
-							break;
-					}
-				}
-			}
-			break;
-		case 45:
-			for (s=0; s<2*window_size-1; s++)
-			{
-				if (s < window_size)
-				{
-					cy = y+s;
-					cx = x;
-				}
-				else
-				{
-					cy = y+window_size-1;
-					cx = x-window_size+1+s;
-				}
-				for (rl=1,cv=-1; ;)
-				{
-					pv = cv;
-					if (cx==x+window_size || cy==-1)
-						cv = -1;
-					else
-						switch (bytes)
-						{
-							case 1:
-								cv = gray_map[in[width*cy+cx]];
-								break;
-							case 2:
-								cv =
-								 gray_map[((unsigned short *)in)[width*cy+cx]];
-								break;
-							default:
-								fprintf(stderr,
-									"%d-byte data not supported.\n", bytes);
-								exit(-1);
-						}
-					cx++;
-					cy--;
-					if (cv == pv)
-						rl++;
-					else
-					{
-						if (pv >= 0)
-						{
-							joint_hist[run_map[rl]][pv]++;
-							rl = 1;
-						}
-						if (cv < 0)
-							break;
-					}
-				}
-			}
-			break;
-		case 90:
-			for (cx=x; cx<x+window_size; cx++)
-			{
-				for (cy=y,rl=1,cv=-1; ;)
-				{
-					pv = cv;
-					if (cy == y+window_size)
-						cv = -1;
-					else
-						switch (bytes)
-						{
-							case 1:
-								cv = gray_map[in[width*cy+cx]];
-								break;
-							case 2:
-								cv =
-								 gray_map[((unsigned short *)in)[width*cy+cx]];
-								break;
-							default:
-								fprintf(stderr,
-									"%d-byte data not supported.\n", bytes);
-								exit(-1);
-						}
-					cy++;
-					if (cv == pv)
-						rl++;
-					else
-					{
-						if (pv >= 0)
-						{
-							joint_hist[run_map[rl]][pv]++;
-							rl = 1;
-						}
-						if (cv < 0)
-							break;
-					}
-				}
-			}
-			break;
-		case 135:
-			for (s=0; s<2*window_size-1; s++)
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	memset(out, 0, width*height*sizeof(unsigned short));
+#pragma omp parallel
+	{
+		RLMWindow rw;
+		int x, my_error=rlm_window_init(&rw, &slice, nbins, num_run_bins,
+			window_size);
+
+#pragma omp for schedule(dynamic)
+		for (y=window_size; y<height-window_size; y++)
+			for (x=window_size; !my_error && x<width-window_size; x++)
 			{
-				if (s < window_size)
-				{
-					cy = y;
-					cx = x+window_size-1-s;
-				}
+				if (x == window_size)
+					rlm_window_start(&rw, x, y);
 				else
-				{
-					cy = y-window_size+1+s;
-					cx = x;
-				}
-				for (rl=1,cv=-1; ;)
-				{
-					pv = cv;
-					if (cx==x+window_size || cy==y+window_size)
-						cv = -1;
-					else
-						switch (bytes)
-						{
-							case 1:
-								cv = gray_map[in[width*cy+cx]];
-								break;
-							case 2:
-								cv =
-								 gray_map[((unsigned short *)in)[width*cy+cx]];
-								break;
-							default:
-								fprintf(stderr,
-									"%d-byte data not supported.\n", bytes);
-								exit(-1);
-						}
-					cx++;
-					cy++;
-					if (cv == pv)
-						rl++;
-					else
-					{
-						if (pv >= 0)
-						{
-							joint_hist[run_map[rl]][pv]++;
-							rl = 1;
-						}
-						if (cv < 0)
-							break;
-					}
-				}
+					rlm_window_slide(&rw, x-1, y);
+				if (mask==NULL || mask[width*y+x])
+					out[width*y+x] =
+						rlm_window_feature(&rw, feature, angle==180);
 			}
-			break;
-		default:
-			fprintf(stderr,
-				"Angle must be one of 0, 45, 90, 135.\n");
-			exit(-1);
+		if (my_error)
+		{
+#pragma omp critical
+			error = 1;
+		}
+		else
+			rlm_window_free(&rw);
+	}
+	rlm_slice_free(&slice);
+	if (error)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
 	}
-
 }
 
-
-void get_co_occurrence(double **joint_hist, unsigned char *in, int bytes,
-	int width, int height, int angle, int distance,
-	int window_size, int x, int y, unsigned short gray_map[0x10000])
+/*****************************************************************************
+ * FUNCTION: get_co_occurrence_image
+ * DESCRIPTION: Computes a co-occurrence feature in a sliding window around
+ *    each pixel of a slice.  Rows are distributed among threads; each
+ *    thread slides its own window along a row.
+ * PARAMETERS:
+ *    out: the output slice
+ *    g: the gray-mapped slice
+ *    mask: pixels where mask is 0 are set to 0; NULL for no mask
+ *    width, height: slice size
+ *    angle: one of 0, 45, ... 315, or 360 for all eight
+ *    distance: pixel distance between pairs
+ *    nbins: number of gray levels in g
+ *    window_size: the window is 2*window_size+1 pixels square
+ *    feature: 1 to 6, see cooc_window_feature
+ * SIDE EFFECTS: Exits on failure to allocate memory.
+ * RETURN VALUE: None
+ *****************************************************************************/
+void get_co_occurrence_image(unsigned short *out, unsigned short *g,
+    unsigned char *mask, int width, int height, int angle, int distance,
+    int nbins, int window_size, int feature)
 {
-	int start_row, end_row, start_col, end_col, offset, cen_val, nei_val, j, k;
+	CoocDirection dir[8];
+	int ndirs=0, y, error=0;
 
-	switch (angle)
+	if (angle == 360)
+		for (ndirs=0; ndirs<8; ndirs++)
+			texture_cooc_direction(45*ndirs, distance, width, height,
+				dir+ndirs);
+	else
+		ndirs = texture_cooc_direction(angle, distance, width, height,
+			dir) == 0;
+#pragma omp parallel
 	{
-		case 0:
-			start_row = 0;
-			end_row = height;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance;
-			break;
-		case 45:
-			start_row = distance;
-			end_row = height;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance*(1-width);
-			break;
-		case 90:
-			start_row = distance;
-			end_row = height;
-			start_col = 0;
-			end_col = width;
-			offset = distance*-width;
-			break;
-		case 135:
-			start_row = distance;
-			end_row = height;
-			start_col = distance;
-			end_col = width;
-			offset = distance*(-1-width);
-			break;
-		case 180:
-			start_row = 0;
-			end_row = height;
-			start_col = distance;
-			end_col = width;
-			offset = distance*-1;
-			break;
-		case 225:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = distance;
-			end_col = width;
-			offset = distance*(-1+width);
-			break;
-		case 270:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = 0;
-			end_col = width;
-			offset = distance*width;
-			break;
-		case 315:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance*(1+width);
-			break;
-		default:
-			fprintf(stderr,
-				"Angle must be one of 0, 45, 90, 135, 180, 225, 270, 315.\n");
-			exit(-1);
-	}
-	if (start_row < y-window_size)
-		start_row = y-window_size;
-	if (end_row > y+window_size+1)
-		end_row = y+window_size+1;
-	if (start_col < x-window_size)
-		start_col = x-window_size;
-	if (end_col > x+window_size+1)
-		end_col = x+window_size+1;
-	for (j=start_row; j<end_row; j++)
-		for (k=start_col; k<end_col; k++)
-		{
-			switch (bytes)
+		CoocWindow cw;
+		int x, my_error=cooc_window_init(&cw, nbins, dir, ndirs, width,
+			height, window_size);
+
+#pragma omp for schedule(dynamic)
+		for (y=0; y<height; y++)
+			for (x=0; !my_error && x<width; x++)
 			{
-				case 1:
-					cen_val = in[width*j+k];
-					nei_val = in[width*j+k+offset];
-					break;
-				case 2:
-					cen_val = ((unsigned short *)in)[width*j+k];
-					nei_val = ((unsigned short *)in)[width*j+k+offset];
-					break;
-				default:
-					fprintf(stderr, "%d-byte data not supported.\n", bytes);
-					exit(-1);
+				if (x == 0)
+					cooc_window_start(&cw, g, x, y);
+				else
+					cooc_window_slide(&cw, g, x-1, y);
+				out[width*y+x] = mask==NULL || mask[width*y+x]?
+					cooc_window_feature(&cw, feature): 0;
 			}
-			joint_hist[gray_map[cen_val]][gray_map[nei_val]]++;
+		if (my_error)
+		{
+#pragma omp critical
+			error = 1;
 		}
+		else
+			cooc_window_free(&cw);
+	}
+	if (error)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
 }
 
+/*****************************************************************************
+ * FUNCTION: get_LBP_image
+ * DESCRIPTION: Computes the rotation-invariant uniform local binary pattern
+ *    of each nonzero pixel of a slice; other pixels get nsamples+1.
+ * PARAMETERS:
+ *    out_8: the output slice
+ *    in: the input slice
+ *    bytes: bytes per pixel of in
+ *    width, height: slice size
+ *    radius, nsamples: the sampling circle
+ * SIDE EFFECTS: Exits on failure to allocate memory.
+ * RETURN VALUE: None
+ *****************************************************************************/
 void get_LBP_image(unsigned char *out_8, unsigned char *in, int bytes,
     int width, int height, float radius, int nsamples)
 {
-	int start_row=0, end_row=height, start_col=0, end_col=width, *offset,
-		cen_val, *nei_val, j, k, m, ix, iy, transitions, up;
-	float *fx, *fy;
-	double tx, ty;
+	LBPSampling ls;
+	int j;
 	unsigned short *in2=(unsigned short *)in;
 
 	memset(out_8, nsamples+1, width*height);
-	offset = (int *)malloc(nsamples*sizeof(int));
-	nei_val = (int *)malloc(nsamples*sizeof(int));
-	fx = (float *)malloc(nsamples*sizeof(float));
-	fy = (float *)malloc(nsamples*sizeof(float));
-	for (m=0; m<nsamples; m++)
+	if (lbp_sampling_init(&ls, radius, nsamples, width, height))
 	{
-		tx = radius*cos(2*M_PI*m/nsamples);
-		ty = radius*sin(2*M_PI*m/nsamples);
-		ix = (int)floor(tx);
-		iy = (int)floor(ty);
-		fx[m] = (float)(tx-ix);
-		fy[m] = (float)(ty-iy);
-		if (ix>0 && fx[m]<=0)
-		{
-			ix--;
-			fx[m] = 1;
-		}
-		if (iy>0 && fy[m]<=0)
-		{
-			iy--;
-			fy[m] = 1;
-		}
-		if (ix<0 && fx[m]>=1)
-		{
-			ix++;
-			fx[m] = 0;
-		}
-		if (iy<0 && fy[m]>=1)
-		{
-			iy++;
-			fy[m] = 0;
-		}
-		if (-ix > start_col)
-			start_col = -ix;
-		if (-iy > start_row)
-			start_row = -iy;
-		if (width-1-ix < end_col)
-			end_col = width-1-ix;
-		if (height-1-iy < end_row)
-			end_row = height-1-iy;
-		offset[m] = width*iy+ix;
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
 	}
-	for (j=start_row; j<end_row; j++)
-		for (k=start_col; k<end_col; k++)
+#pragma omp parallel for schedule(dynamic)
+	for (j=ls.start_row; j<ls.end_row; j++)
+	{
+		int k;
+
+		for (k=ls.start_col; k<ls.end_col; k++)
 			if (bytes==2? in2[width*j+k]:in[width*j+k])
-			{
-				cen_val = bytes==2? in2[width*j+k]:in[width*j+k];
-				for (m=0; m<nsamples; m++)
-				{
-					float v;
-					if (bytes == 2)
-					  v = (1-fy[m])*((1-fx[m])*in2[width*j+k+offset[m]]+
-					                    fx[m] *in2[width*j+k+offset[m]+1])+
-					         fy[m] *((1-fx[m])*in2[width*j+k+offset[m]+width]+
-					                    fx[m] *in2[width*j+k+offset[m]+width+1]
-					                );
-					else
-					  v = (1-fy[m])*((1-fx[m])*in[width*j+k+offset[m]]+
-					                    fx[m] *in[width*j+k+offset[m]+1])+
-					         fy[m] *((1-fx[m])*in[width*j+k+offset[m]+width]+
-					                    fx[m] *in[width*j+k+offset[m]+width+1]
-					                );
-					nei_val[m] = v >= cen_val;
-				}
-				up = nei_val[nsamples-1];
-				transitions = nei_val[0] != nei_val[nsamples-1];
-				for (m=0; m<nsamples-1; m++)
-				{
-					if (nei_val[m])
-						up++;
-					if (nei_val[m] != nei_val[m+1])
-						transitions++;
-				}
-				assert(transitions%2 == 0);
-				out_8[width*j+k] = transitions<=2? up: nsamples+1;
-			}
-	free(fy);
-	free(fx);
-	free(nei_val);
-	free(offset);
+				out_8[width*j+k] = (unsigned char)
+					lbp_code(&ls, in, bytes, width*j+k);
+	}
+	lbp_sampling_free(&ls);
 }
 
 int get_slices(int dim, short *list)
@@ -25,11 +25,8 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
  
 #include <math.h>
 #include <cv3dv.h>
-#include <assert.h>
+#include "texture_engine.h"
 
-#ifndef M_PI
-#define M_PI 3.1415926535897932384626433832795
-#endif
 #ifndef M_E
 #define M_E 2.71828182845904523536
 #endif
@@ -311,219 +308,154 @@ char *argv[];
 }
 
 
+/*****************************************************************************
+ * FUNCTION: get_co_occurrence
+ * DESCRIPTION: Accumulates the co-occurrence of pixel pairs inside the mask
+ *    of a slice.  Rows are distributed among threads.
+ * PARAMETERS:
+ *    joint_hist: the co-occurrence matrix to accumulate into
+ *    in: the slice
+ *    bits: bits per pixel of in
+ *    msk: the mask slice
+ *    width, height: slice size
+ *    angle: one of 0, 45, ... 315
+ *    distance: pixel distance between pairs
+ *    bin_size: gray levels per bin
+ *    include_edge: non-zero to count pairs whose neighbor is outside the mask
+ *    max_dens, min_dens: updated with the range of gray levels counted
+ * SIDE EFFECTS: Exits on invalid angle or bits.
+ * RETURN VALUE: None
+ *****************************************************************************/
 void get_co_occurrence(double **joint_hist, unsigned char *in, int bits,
 	unsigned char *msk, int width, int height, int angle, int distance,
 	int bin_size, int include_edge, int *max_dens, int *min_dens)
 {
-	int start_row, end_row, start_col, end_col, offset, cen_val, nei_val, j, k;
+	CoocDirection dir;
+	int j;
 
-	switch (angle)
+	if (texture_cooc_direction(angle, distance, width, height, &dir))
 	{
-		case 0:
-			start_row = 0;
-			end_row = height;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance;
-			break;
-		case 45:
-			start_row = distance;
-			end_row = height;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance*(1-width);
-			break;
-		case 90:
-			start_row = distance;
-			end_row = height;
-			start_col = 0;
-			end_col = width;
-			offset = distance*-width;
-			break;
-		case 135:
-			start_row = distance;
-			end_row = height;
-			start_col = distance;
-			end_col = width;
-			offset = distance*(-1-width);
-			break;
-		case 180:
-			start_row = 0;
-			end_row = height;
-			start_col = distance;
-			end_col = width;
-			offset = distance*-1;
-			break;
-		case 225:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = distance;
-			end_col = width;
-			offset = distance*(-1+width);
-			break;
-		case 270:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = 0;
-			end_col = width;
-			offset = distance*width;
-			break;
-		case 315:
-			start_row = 0;
-			end_row = height-distance;
-			start_col = 0;
-			end_col = width-distance;
-			offset = distance*(1+width);
-			break;
-		default:
-			fprintf(stderr,
-				"Angle must be one of 0, 45, 90, 135, 180, 225, 270, 315.\n");
-			exit(-1);
+		fprintf(stderr,
+			"Angle must be one of 0, 45, 90, 135, 180, 225, 270, 315.\n");
+		exit(-1);
 	}
-	for (j=start_row; j<end_row; j++)
-		for (k=start_col; k<end_col; k++)
-		{
-			if (msk[width*j+k] && (include_edge || msk[width*j+k+offset]))
-			{
-				switch (bits)
+	if (bits!=1 && bits!=8 && bits!=16)
+	{
+		fprintf(stderr, "%d-bit data not supported.\n", bits);
+		exit(-1);
+	}
+#pragma omp parallel
+	{
+		int k, cen_val, nei_val, my_max=*max_dens, my_min=*min_dens;
+
+#pragma omp for schedule(dynamic)
+		for (j=dir.start_row; j<dir.end_row; j++)
+			for (k=dir.start_col; k<dir.end_col; k++)
+				if (msk[width*j+k] &&
+						(include_edge || msk[width*j+k+dir.offset]))
 				{
-					case 1:
-					case 8:
-						cen_val = in[width*j+k];
-						nei_val = in[width*j+k+offset];
-						break;
-					case 16:
+					if (bits == 16)
+					{
 						cen_val = ((unsigned short *)in)[width*j+k];
-						nei_val = ((unsigned short *)in)[width*j+k+offset];
-						break;
-					default:
-						fprintf(stderr, "%d-bit data not supported.\n", bits);
-						exit(-1);
+						nei_val = ((unsigned short *)in)[width*j+k+dir.offset];
+					}
+					else
+					{
+						cen_val = in[width*j+k];
+						nei_val = in[width*j+k+dir.offset];
+					}
+					if (cen_val > my_max)
+						my_max = cen_val;
+					if (cen_val < my_min)
+						my_min = cen_val;
+					if (nei_val > my_max)
+						my_max = nei_val;
+					if (nei_val < my_min)
+						my_min = nei_val;
+#pragma omp atomic
+					joint_hist[cen_val/bin_size][nei_val/bin_size] += 1;
 				}
-				if (cen_val > *max_dens)
-					*max_dens = cen_val;
-				if (cen_val < *min_dens)
-					*min_dens = cen_val;
-				if (nei_val > *max_dens)
-					*max_dens = cen_val;
-				if (nei_val < *min_dens)
-					*min_dens = cen_val;
-				joint_hist[cen_val/bin_size][nei_val/bin_size]++;
-			}
+#pragma omp critical
+		{
+			if (my_max > *max_dens)
+				*max_dens = my_max;
+			if (my_min < *min_dens)
+				*min_dens = my_min;
 		}
+	}
+}
+
+/* Whether all the samples of the circle around pixel index are inside the
+   mask. */
+static int lbp_in_mask(const LBPSampling *ls, const unsigned char *msk,
+	int index)
+{
+	int m, i;
+
+	for (m=0; m<ls->nsamples; m++)
+	{
+		i = index+ls->offset[m];
+		if ((1-ls->fy[m])*((1-ls->fx[m])*msk[i]+ls->fx[m]*msk[i+1])+
+				ls->fy[m]*((1-ls->fx[m])*msk[i+ls->width]+
+				ls->fx[m]*msk[i+ls->width+1]) < .5)
+			return 0;
+	}
+	return 1;
 }
 
+/*****************************************************************************
+ * FUNCTION: get_LBP_hist
+ * DESCRIPTION: Accumulates the histogram of rotation-invariant uniform local
+ *    binary patterns of nonzero pixels inside the mask of a slice.  Rows are
+ *    distributed among threads.
+ * PARAMETERS:
+ *    lbp_hist: the histogram to accumulate into, nsamples+2 bins
+ *    in: the slice
+ *    bits: bits per pixel of in
+ *    msk: the mask slice
+ *    width, height: slice size
+ *    radius, nsamples: the sampling circle
+ *    include_edge: non-zero to count pixels whose circle leaves the mask
+ * SIDE EFFECTS: Exits on failure to allocate memory.
+ * RETURN VALUE: None
+ *****************************************************************************/
 void get_LBP_hist(double *lbp_hist, unsigned char *in, int bits,
 	unsigned char *msk, int width, int height, float radius, int nsamples,
 	int include_edge)
 {
-	int start_row=0, end_row=height, start_col=0, end_col=width, *offset,
-		cen_val, *nei_val, j, k, m, ix, iy, transitions, up;
-	float *fx, *fy;
-	double tx, ty;
-	unsigned short *in2=(unsigned short *)in;
-
-	offset = (int *)malloc(nsamples*sizeof(int));
-	nei_val = (int *)malloc(nsamples*sizeof(int));
-	fx = (float *)malloc(nsamples*sizeof(float));
-	fy = (float *)malloc(nsamples*sizeof(float));
-	for (m=0; m<nsamples; m++)
+	LBPSampling ls;
+	int j;
+
+	if (lbp_sampling_init(&ls, radius, nsamples, width, height))
 	{
-		tx = radius*cos(2*M_PI*m/nsamples);
-		ty = radius*sin(2*M_PI*m/nsamples);
-		ix = (int)floor(tx);
-		iy = (int)floor(ty);
-		fx[m] = (float)(tx-ix);
-		fy[m] = (float)(ty-iy);
-		if (ix>0 && fx[m]<=0)
-		{
-			ix--;
-			fx[m] = 1;
-		}
-		if (iy>0 && fy[m]<=0)
-		{
-			iy--;
-			fy[m] = 1;
-		}
-		if (ix<0 && fx[m]>=1)
-		{
-			ix++;
-			fx[m] = 0;
-		}
-		if (iy<0 && fy[m]>=1)
-		{
-			iy++;
-			fy[m] = 0;
-		}
-		if (-ix > start_col)
-			start_col = -ix;
-		if (-iy > start_row)
-			start_row = -iy;
-		if (width-ix < end_col)
-			end_col = width-ix;
-		if (height-iy < end_row)
-			end_row = height-iy;
-		offset[m] = width*iy+ix;
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
 	}
-	for (j=start_row; j<end_row; j++)
-		for (k=start_col; k<end_col; k++)
-			if (in[width*j+k])
+#pragma omp parallel
+	{
+		int k, m;
+		double *my_hist=(double *)calloc(nsamples+2, sizeof(double));
+
+#pragma omp for schedule(dynamic)
+		for (j=ls.start_row; j<ls.end_row; j++)
+			for (k=ls.start_col; my_hist && k<ls.end_col; k++)
+				if ((bits==16? ((unsigned short *)in)[width*j+k]:
+						in[width*j+k]) && msk[width*j+k] &&
+						(include_edge || lbp_in_mask(&ls, msk, width*j+k)))
+					my_hist[lbp_code(&ls, in, bits==16? 2:1, width*j+k)]++;
+#pragma omp critical
+		{
+			if (my_hist == NULL)
 			{
-				if (!include_edge)
-				{
-					int in_flag = 1;
-					for (m=0; m<nsamples; m++)
-					{
-					  if ((1-fy[m])*((1-fx[m])*msk[width*j+k+offset[m]]+
-						                fx[m] *msk[width*j+k+offset[m]+1])+
-						     fy[m] *((1-fx[m])*msk[width*j+k+offset[m]+width]+
-						                fx[m] *msk[width*j+k+offset[m]+width+1]
-					      ) < .5)
-					  {
-						in_flag = 0;
-						break;
-					  }
-					}
-					if (!in_flag)
-						continue;
-				}
-				cen_val = bits==16? in2[width*j+k]:in[width*j+k];
-				for (m=0; m<nsamples; m++)
-				{
-					float v;
-					if (bits == 16)
-					  v = (1-fy[m])*((1-fx[m])*in2[width*j+k+offset[m]]+
-					                    fx[m] *in2[width*j+k+offset[m]+1])+
-					         fy[m] *((1-fx[m])*in2[width*j+k+offset[m]+width]+
-					                    fx[m] *in2[width*j+k+offset[m]+width+1]
-					                );
-					else
-					  v = (1-fy[m])*((1-fx[m])*in[width*j+k+offset[m]]+
-					                    fx[m] *in[width*j+k+offset[m]+1])+
-					         fy[m] *((1-fx[m])*in[width*j+k+offset[m]+width]+
-					                    fx[m] *in[width*j+k+offset[m]+width+1]
-					                );
-					nei_val[m] = v >= cen_val;
-				}
-				up = nei_val[nsamples-1];
-				transitions = nei_val[0] != nei_val[nsamples-1];
-				for (m=0; m<nsamples-1; m++)
-				{
-					if (nei_val[m])
-						up++;
-					if (nei_val[m] != nei_val[m+1])
-						transitions++;
-				}
-				assert(transitions%2 == 0);
-				if (transitions <= 2)
-					lbp_hist[up]++;
-				else
-					lbp_hist[nsamples+1]++;
+				fprintf(stderr, "Out of memory\n");
+				exit(1);
 			}
-	free(fy);
-	free(fx);
-	free(nei_val);
-	free(offset);
+			for (m=0; m<nsamples+2; m++)
+				lbp_hist[m] += my_hist[m];
+		}
+		free(my_hist);
+	}
+	lbp_sampling_free(&ls);
 }
 
 int get_slices(int dim, short *list)
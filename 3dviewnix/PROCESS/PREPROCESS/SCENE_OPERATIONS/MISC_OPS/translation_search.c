@@ -0,0 +1,223 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <cv3dv.h>
+#include "translation_search.h"
+
+static double model_value(const TSPair *pair, long n)
+{
+	return pair->model_bits==16? ((const unsigned short *)pair->model)[n]:
+		((const unsigned char *)pair->model)[n];
+}
+
+static int image_bit(const TSPair *pair, int x, int y, int z)
+{
+	long n=(long)y*pair->image_size[0]+x;
+
+	return pair->image[z*(((long)pair->image_size[0]*pair->image_size[1]+7)/8)+
+		(n>>3)] & (0x80>>(n&7));
+}
+
+/*****************************************************************************
+ * FUNCTION: ts_overlap_box
+ * DESCRIPTION: Adds the overlap of the model with the image at each offset
+ *    of a box to an array, by cross-correlation in the frequency domain.
+ * PARAMETERS:
+ *    pair: The model and image.
+ *    start, end: The corners of the box of offsets (x, y, z), inclusive.
+ *    shrink: 1 for the exact overlap at every offset; 2 for an
+ *       approximation at every other offset from start, computed on scenes
+ *       reduced by half.
+ *    overlap: The array, (end[i]-start[i])/shrink+1 entries on each axis,
+ *       x fastest.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if memory cannot be allocated.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int ts_overlap_box(const TSPair *pair, const int start[3], const int end[3],
+	int shrink, double *overlap)
+{
+	int a, w[3], nm[3], nb[3], n[3], x, y, z, q[3];
+	long total, k, plane;
+	double *m, *b;
+
+	for (a=0; a<3; a++)
+	{
+		w[a] = (end[a]-start[a])/shrink+1;
+		nm[a] = (pair->model_size[a]+shrink-1)/shrink;
+		nb[a] = nm[a]+w[a]-1;
+		n[a] = VFFTSize(nb[a]);
+	}
+	plane = (long)n[0]*n[1];
+	total = plane*n[2];
+	m = (double *)calloc(total, sizeof(double));
+	b = (double *)calloc(total, sizeof(double));
+	if (m==NULL || b==NULL)
+	{
+		if (m)
+			free(m);
+		if (b)
+			free(b);
+		return 1;
+	}
+
+	/* the model, and the image from start on */
+	for (z=k=0; z<pair->model_size[2]; z++)
+		for (y=0; y<pair->model_size[1]; y++)
+			for (x=0; x<pair->model_size[0]; x++,k++)
+				m[z/shrink*plane+y/shrink*n[0]+x/shrink] +=
+					model_value(pair, k);
+	for (z=0; z<nb[2]*shrink; z++)
+	{
+		q[2] = start[2]+z;
+		if (q[2]<0 || q[2]>=pair->image_size[2])
+			continue;
+		for (y=0; y<nb[1]*shrink; y++)
+		{
+			q[1] = start[1]+y;
+			if (q[1]<0 || q[1]>=pair->image_size[1])
+				continue;
+			for (x=0; x<nb[0]*shrink; x++)
+			{
+				q[0] = start[0]+x;
+				if (q[0]>=0 && q[0]<pair->image_size[0] &&
+						image_bit(pair, q[0], q[1], q[2]))
+					b[z/shrink*plane+y/shrink*n[0]+x/shrink] += 1;
+			}
+		}
+	}
+
+	/* The window is large enough that the circular correlation does not
+	   wrap for offsets in the box. */
+	a = VFFTConvolve(m, b, m, 3, n, 1);
+	free(b);
+	if (a)
+	{
+		free(m);
+		return 1;
+	}
+	for (z=0; z<w[2]; z++)
+		for (y=0; y<w[1]; y++)
+			for (x=0; x<w[0]; x++)
+			{
+				double v=m[z*plane+y*n[0]+x];
+
+				*overlap++ += shrink==1? floor(v+.5): v/(shrink*shrink*shrink);
+			}
+	free(m);
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: ts_overlap_at
+ * DESCRIPTION: Returns the overlap of the model with the image at one
+ *    offset, computed directly.
+ * PARAMETERS:
+ *    pair: The model and image.
+ *    offset: The offset (x, y, z) of the model in the image.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The sum of model values at voxels where the image is set.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+double ts_overlap_at(const TSPair *pair, const int offset[3])
+{
+	int lo[3], hi[3], a, x, y, z;
+	double sum=0;
+
+	for (a=0; a<3; a++)
+	{
+		lo[a] = offset[a]<0? -offset[a]: 0;
+		hi[a] = pair->image_size[a]-offset[a];
+		if (hi[a] > pair->model_size[a])
+			hi[a] = pair->model_size[a];
+	}
+	for (z=lo[2]; z<hi[2]; z++)
+		for (y=lo[1]; y<hi[1]; y++)
+		{
+			long row=((long)z*pair->model_size[1]+y)*pair->model_size[0];
+
+			for (x=lo[0]; x<hi[0]; x++)
+				if (image_bit(pair, x+offset[0], y+offset[1], z+offset[2]))
+					sum += model_value(pair, row+x);
+		}
+	return sum;
+}
+
+/*****************************************************************************
+ * FUNCTION: ts_model_sum
+ * DESCRIPTION: Returns the sum of the model values.
+ * PARAMETERS:
+ *    pair: The model and image.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The sum.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+double ts_model_sum(const TSPair *pair)
+{
+	long k, n=(long)pair->model_size[0]*pair->model_size[1]*
+		pair->model_size[2];
+	double sum=0;
+
+	for (k=0; k<n; k++)
+		sum += model_value(pair, k);
+	return sum;
+}
+
+/*****************************************************************************
+ * FUNCTION: ts_image_count
+ * DESCRIPTION: Returns the number of voxels set in the image.
+ * PARAMETERS:
+ *    pair: The model and image.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The count.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+double ts_image_count(const TSPair *pair)
+{
+	int x, y, z;
+	double count=0;
+
+	for (z=0; z<pair->image_size[2]; z++)
+		for (y=0; y<pair->image_size[1]; y++)
+			for (x=0; x<pair->image_size[0]; x++)
+				if (image_bit(pair, x, y, z))
+					count++;
+	return count;
+}
@@ -0,0 +1,52 @@
+/*
+  Copyright 1993-2008 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Overlap of a model scene with a binary scene under integer translations.
+ *
+ * The overlap at offset o is the sum over model voxels p of
+ * model(p)*image(p+o), image voxels outside the scene being 0.  XOR and
+ * in/out scores of xor_min and overlap_peak are linear in it.  The overlap
+ * for a whole box of offsets is one cross-correlation, computed with
+ * VFFTConvolve on the model and the part of the image the box can reach;
+ * the result is rounded to the integer it must be.  With shrink 2 the model and image
+ * are first reduced by summing 2x2x2 blocks, giving an approximation at
+ * every other offset for a coarse search that ts_overlap_at refines.
+ */
+
+#ifndef __translation_search_h
+#define __translation_search_h
+
+typedef struct {
+	const void *model;          /* 8 or 16 bits per voxel */
+	int model_bits;
+	int model_size[3];
+	const unsigned char *image; /* packed bits, each slice on a byte */
+	int image_size[3];
+} TSPair;
+
+int ts_overlap_box(const TSPair *pair, const int start[3], const int end[3],
+	int shrink, double *overlap);
+double ts_overlap_at(const TSPair *pair, const int offset[3]);
+double ts_model_sum(const TSPair *pair);
+double ts_image_count(const TSPair *pair);
+
+#endif
@@ -24,31 +24,37 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 #include <cv3dv.h>
 #include <assert.h>
+#include "translation_search.h"
 
 int get_slices(int dim, short *list);
+double xor_total(int x_offset, int y_offset, int z_offset);
+void overlap_box(int object, int shrink, double *overlap);
 
 
 float Imax, Imin;
 int Range;
 
+/* The offsets searched are those of the first object; the others keep
+   their distance from it. */
+TSPair *Pair;
+int Num_objects, (*Start)[3], Box_size[3];
+double *Overlap, Xor_constant;
+
 int main(argc,argv)
 int argc;
 char *argv[];
 {
   int j, bytes1, *size1, size2, error, *slic1, slic2,
-	*start_x_offset, *start_y_offset, *start_z_offset,
-	end_x_offset, end_y_offset, end_z_offset, x1, y1, z1, x2, y2, z2,
-	x_offset, y_offset, z_offset, x_start, y_start, z_start,
-	x_stop, y_stop, z_stop, best_x_offset, best_y_offset, best_z_offset,
-	best_on_boundary=FALSE, on_left_boundary,
+	*start_x_offset, *start_y_offset, *start_z_offset, end_x_offset, end_y_offset, end_z_offset,
+	x_offset, y_offset, z_offset, best_x_offset, best_y_offset, best_z_offset,
+	best_on_boundary=FALSE,
 	y_step=1, Start_y_offset, End_z_offset,
-	End_y_offset, num_objects=1, cur_object, multi_flag=0;
-  double total, best_total, bin_volume=0;
+	End_y_offset, num_objects=1, cur_object, multi_flag=0, coarse_flag=0;
+  double total, best_total;
   ViewnixHeader *vh1, *vh2;
   FILE *in1,*in2, *outstream;
-  unsigned char **data1, *data2;
+  unsigned char **data1, **data2;
   char group[6],elem[6];
-  unsigned short ***data2_rle, **rle_buf;
 
 #define Handle_error(message) \
 { \
@@ -69,6 +75,11 @@ char *argv[];
   {
     multi_flag = 1;
   }
+  if (argc>9 && strcmp(argv[argc-1], "-coarse")==0)
+  {
+    coarse_flag = 1;
+	argc--;
+  }
   if (argc>9 && strncmp(argv[argc-1], "-xor", 4)==0)
   {
 	if (strcmp(argv[argc-1], "-xors") == 0)
@@ -90,7 +101,7 @@ char *argv[];
 	  *start_z_offset>end_z_offset)
   {
     fprintf(stderr,
-"Usage: xor_min [<IM0> <BIM> | -multiple <num_objects>] <start_x_offset1> <start_y_offset1> <start_z_offset1> [<start_x_offset2> <start_y_offset2> <start_z_offset2>] ... <end_x_offset> <end_y_offset> <end_z_offset> [<IM0> <BIM>] ... [-xors]\n");
+"Usage: xor_min [<IM0> <BIM> | -multiple <num_objects>] <start_x_offset1> <start_y_offset1> <start_z_offset1> [<start_x_offset2> <start_y_offset2> <start_z_offset2>] ... <end_x_offset> <end_y_offset> <end_z_offset> [<IM0> <BIM>] ... [-xors] [-coarse] [-o <os>]\n");
     exit(-1);
   }
   for (cur_object=1; cur_object<num_objects; cur_object++)
@@ -102,8 +113,8 @@ char *argv[];
   vh1 = (ViewnixHeader *)calloc(num_objects, sizeof(*vh1));
   vh2 = (ViewnixHeader *)calloc(num_objects, sizeof(*vh2));
   data1 = (unsigned char **)malloc(num_objects*sizeof(*data1));
-  data2_rle = (unsigned short ***)malloc(num_objects*sizeof(*data2_rle));
-  rle_buf = (unsigned short **)malloc(num_objects*sizeof(*rle_buf));
+  data2 = (unsigned char **)malloc(num_objects*sizeof(*data2));
+  Pair = (TSPair *)malloc(num_objects*sizeof(*Pair));
   size1 = (int *)malloc(num_objects*sizeof(int));
   slic1 = (int *)malloc(num_objects*sizeof(int));
 
@@ -171,160 +182,107 @@ char *argv[];
     if (error)
       Handle_error("Could not read data");
     fclose(in1);
-    if (cur_object == 0)
-	  data2= (unsigned char *)
-	    malloc((size2*vh2[cur_object].scn.num_of_bits+7)/8*slic2+1);
-    if (data2==NULL)
+    data2[cur_object]= (unsigned char *)
+      malloc((size2*vh2[cur_object].scn.num_of_bits+7)/8*slic2+1);
+    if (data2[cur_object]==NULL)
       Handle_error("Could not allocate data. Aborting fuzz_ops");
-    data2[(size2*vh2[cur_object].scn.num_of_bits+7)/8*slic2] = 0;
-    error = VReadData((char *)data2, (vh2[cur_object].scn.num_of_bits+7)/8,
+    data2[cur_object][(size2*vh2[cur_object].scn.num_of_bits+7)/8*slic2] = 0;
+    error = VReadData((char *)data2[cur_object], (vh2[cur_object].scn.num_of_bits+7)/8,
       (vh2[cur_object].scn.num_of_bits==1?(size2+7)/8:size2)*slic2, in2, &j);
     if (error)
       Handle_error("Could not read data");
     fclose(in2);
 
-    {
-      best_total +=
-        65534.*size2*slic2+65534.*size1[cur_object]*slic1[cur_object];
-      data2_rle[cur_object] = (unsigned short **)malloc(
-        vh2->scn.xysize[1]*slic2*sizeof(unsigned short *));
-      rle_buf[cur_object] =
-	    (unsigned short *)malloc((vh2->scn.xysize[0]+1)*sizeof(short));
-      if (data2_rle[cur_object]==NULL || rle_buf[cur_object]==NULL)
-        Handle_error("Out of memory.");
-      for (z2=j=0; z2<slic2; z2++)
-      {
-        int xbyte=(size2+7)/8*z2, mask=128, slice_volume=0,
-		  byteval=data2[xbyte];
+    best_total +=
+      65534.*size2*slic2+65534.*size1[cur_object]*slic1[cur_object];
+    Pair[cur_object].model = data1[cur_object];
+    Pair[cur_object].model_bits = 16;
+    Pair[cur_object].model_size[0] = vh1[cur_object].scn.xysize[0];
+    Pair[cur_object].model_size[1] = vh1[cur_object].scn.xysize[1];
+    Pair[cur_object].model_size[2] = slic1[cur_object];
+    Pair[cur_object].image = data2[cur_object];
+    Pair[cur_object].image_size[0] = vh2->scn.xysize[0];
+    Pair[cur_object].image_size[1] = vh2->scn.xysize[1];
+    Pair[cur_object].image_size[2] = slic2;
+    Xor_constant += 65534*ts_image_count(Pair+cur_object)+
+      ts_model_sum(Pair+cur_object);
+  }
 
-        for (y2=0; y2<vh2->scn.xysize[1]; y2++,j++)
+  Num_objects = num_objects;
+  Start = (int (*)[3])malloc(num_objects*sizeof(*Start));
+  for (cur_object=0; cur_object<num_objects; cur_object++)
+  {
+    Start[cur_object][0] = start_x_offset[cur_object];
+    Start[cur_object][1] = start_y_offset[cur_object];
+    Start[cur_object][2] = start_z_offset[cur_object];
+  }
+  Box_size[0] = end_x_offset-start_x_offset[0]+1;
+  Box_size[1] = end_y_offset-start_y_offset[0]+1;
+  Box_size[2] = end_z_offset-start_z_offset[0]+1;
+  if (coarse_flag)
+  {
+    /* best offset on a grid of every other offset, then every offset
+       near it */
+    int t[3], coarse_size[3], best_t[3]={0,0,0};
+    double *coarse, best_overlap=0;
+
+    for (j=0; j<3; j++)
+      coarse_size[j] = (Box_size[j]-1)/2+1;
+    coarse = (double *)calloc(coarse_size[0]*coarse_size[1]*coarse_size[2],
+      sizeof(double));
+    if (coarse == NULL)
+      Handle_error("Out of memory.");
+    for (cur_object=0; cur_object<num_objects; cur_object++)
+      overlap_box(cur_object, 2, coarse);
+    for (t[2]=j=0; t[2]<coarse_size[2]; t[2]++)
+      for (t[1]=0; t[1]<coarse_size[1]; t[1]++)
+        for (t[0]=0; t[0]<coarse_size[0]; t[0]++,j++)
+          if (j==0 || coarse[j]>best_overlap)
+          {
+            best_overlap = coarse[j];
+            memcpy(best_t, t, sizeof(t));
+          }
+    free(coarse);
+    Box_size[0] = Box_size[1] = Box_size[2] = 0;
+    for (z_offset=start_z_offset[0]+2*best_t[2]-2;
+        z_offset<=start_z_offset[0]+2*best_t[2]+2; z_offset++)
+      for (y_offset=start_y_offset[0]+2*best_t[1]-2;
+          y_offset<=start_y_offset[0]+2*best_t[1]+2; y_offset++)
+        for (x_offset=start_x_offset[0]+2*best_t[0]-2;
+            x_offset<=start_x_offset[0]+2*best_t[0]+2; x_offset++)
         {
-          int runs=0;
-          for (x2=0; x2<vh2->scn.xysize[0]; x2++)
+          if (z_offset<start_z_offset[0] || z_offset>end_z_offset ||
+              y_offset<start_y_offset[0] || y_offset>end_y_offset ||
+              x_offset<start_x_offset[0] || x_offset>end_x_offset)
+            continue;
+          total = xor_total(x_offset, y_offset, z_offset);
+          if (total < best_total)
           {
-            if (byteval & mask)
-            {
-              slice_volume++;
-              if ((runs&1) == 0)
-                rle_buf[cur_object][runs++] = x2;
-            }
-            else
-            {
-              if (runs & 1)
-                rle_buf[cur_object][runs++] = x2;
-            }
-            mask >>= 1;
-            if (mask == 0)
-            {
-              mask = 128;
-              xbyte++;
-              byteval = data2[xbyte];
-            }
+            best_total = total;
+            best_x_offset = x_offset;
+            best_y_offset = y_offset;
+            best_z_offset = z_offset;
           }
-          if (runs & 1)
-            rle_buf[cur_object][runs++] = vh2->scn.xysize[0];
-          rle_buf[cur_object][runs++] = 65535;
-          data2_rle[cur_object][j] =
-		    (unsigned short *)malloc(runs*sizeof(short));
-          if (data2_rle[cur_object][j] == NULL)
-            Handle_error("Out of memory.");
-          memcpy(data2_rle[cur_object][j], rle_buf[cur_object],
-		    runs*sizeof(short));
         }
-        bin_volume += slice_volume;
-      }
-    }
+  }
+  else
+  {
+    Overlap = (double *)
+      calloc(Box_size[0]*Box_size[1]*Box_size[2], sizeof(double));
+    if (Overlap == NULL)
+      Handle_error("Out of memory.");
+    for (cur_object=0; cur_object<num_objects; cur_object++)
+      overlap_box(cur_object, 1, Overlap);
   }
 
-  for (z_offset=start_z_offset[0]; z_offset<=end_z_offset; z_offset++)
+  for (z_offset=start_z_offset[0]; !coarse_flag && z_offset<=end_z_offset;
+      z_offset++)
   {
     for (y_offset=start_y_offset[0]; y_offset<=end_y_offset; y_offset+=y_step)
     {
-      on_left_boundary = TRUE;
       for (x_offset=start_x_offset[0]; x_offset<=end_x_offset; x_offset++)
       {
-    	{
-          if (x_offset == start_x_offset[0])
-          {
-            total = 65534*bin_volume;
-            for (cur_object=0; cur_object<num_objects; cur_object++)
-              for (z1=0; z1<slic1[cur_object]; z1++)
-                for (y1=0; y1<vh1[cur_object].scn.xysize[1]; y1++)
-                  for (x1=0; x1<vh1[cur_object].scn.xysize[0]; )
-                  {
-                    if (z1+z_offset>=0 && z1+z_offset<slic2 &&
-                        y1+y_offset>=0 && y1+y_offset<vh2->scn.xysize[1] &&
-                        x1+x_offset>=0 && x1+x_offset<vh2->scn.xysize[0])
-                    {
-                      x1 = vh2->scn.xysize[0]-x_offset;
-                      continue;
-                    }
-                    total += ((unsigned short *)data1[cur_object])
-                      [(z1*vh1[cur_object].scn.xysize[1]+y1)*vh1[cur_object].scn.xysize[0]+x1];
-                    x1++;
-                  }
-          }
-        }
-        for (cur_object=0; cur_object<num_objects; cur_object++)
-        {
-          int xoffst, yoffst, zoffst;
-          zoffst = z_offset+start_z_offset[cur_object]-start_z_offset[0];
-          z_start = zoffst<0? 0: zoffst;
-          z_stop = slic1[cur_object]+zoffst<slic2?
-            slic1[cur_object]+zoffst:slic2;
-          yoffst = y_offset+start_y_offset[cur_object]-start_y_offset[0];
-          y_start = yoffst<0? 0:yoffst;
-          y_stop = vh1[cur_object].scn.xysize[1]+yoffst<vh2->scn.xysize[1]?
-                   vh1[cur_object].scn.xysize[1]+yoffst:vh2->scn.xysize[1];
-          xoffst = x_offset+start_x_offset[cur_object]-start_x_offset[0];
-          x_start = xoffst<0? 0:xoffst;
-          x_stop = vh1[cur_object].scn.xysize[0]+xoffst<vh2->scn.xysize[0]?
-                   vh1[cur_object].scn.xysize[0]+xoffst:vh2->scn.xysize[0];
-
-          for (z1=(z2=z_start)-zoffst; z2<z_stop; z2++,z1++)
-          {
-           j = z2*vh2->scn.xysize[1]+y_start;
-           for (y1=(y2=y_start)-yoffst; y2<y_stop; y2++,y1++,j++)
-           {
-             int row_total=0, runs=0, isin;
-             if (xoffst == start_x_offset[cur_object])
-             {
-               for (isin=0; data2_rle[cur_object][j][runs]<x_start; isin=!isin)
-                 runs++;
-               for (x1=(x2=x_start)-xoffst; x2<x_stop; x2++,x1++)
-               {
-                 int val1=((unsigned short *)data1[cur_object])
-                   [(z1*vh1[cur_object].scn.xysize[1]+y1)*
-                   vh1[cur_object].scn.xysize[0]+x1];
-                 if (data2_rle[cur_object][j][runs] == x2)
-                 {
-                   runs++;
-                   isin = !isin;
-                 }
-                 if (val1)
-                   row_total += isin? -val1: val1;
-               }
-             }
-             else
-             {
-               for (isin=1; (x2=data2_rle[cur_object][j][runs]) < x_stop;
-                   runs++,isin= !isin)
-               {
-                 int val1;
-                 if (x2 < x_start)
-                   continue;
-                 x1 = x2-xoffst;
-                 val1 = ((unsigned short *)data1[cur_object])
-                   [(z1*vh1[cur_object].scn.xysize[1]+y1)*
-                   vh1[cur_object].scn.xysize[0]+x1];
-                 if (val1)
-                   row_total += 2*(isin? -val1: val1);
-               }
-             }
-             total += row_total;
-           }
-          }
-        }
+        total = xor_total(x_offset, y_offset, z_offset);
         if (total < best_total)
         {
           best_total = total;
@@ -332,7 +290,6 @@ char *argv[];
           best_y_offset = y_offset;
           best_z_offset = z_offset;
         }
-        on_left_boundary = FALSE;
       }
     }
     if (y_step==3 && z_offset>=end_z_offset)
@@ -354,6 +311,7 @@ char *argv[];
     end_y_offset = End_y_offset;
   }
 
+
   if (best_z_offset==start_z_offset[0] || best_z_offset==end_z_offset-1 ||
       best_y_offset==start_y_offset[0] || best_y_offset==end_y_offset-1 ||
       best_x_offset==start_x_offset[0] || best_x_offset==end_x_offset-1 ||
@@ -371,6 +329,78 @@ char *argv[];
   exit(0);
 }
 
+/*****************************************************************************
+ * FUNCTION: xor_total
+ * DESCRIPTION: Returns the sum over objects of the XOR of the model with
+ *    the image, the model values counting as fractions of 65534.
+ * PARAMETERS:
+ *    x_offset, y_offset, z_offset: The offset of the first model.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The global variables Pair, Num_objects, Start,
+ *    Xor_constant must be set; Overlap must hold the overlap over the box
+ *    of Box_size offsets from the starting offsets.
+ * RETURN VALUE: The XOR total.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+double xor_total(int x_offset, int y_offset, int z_offset)
+{
+  int x, y, z, offset[3], cur_object;
+  double overlap=0;
+
+  x = x_offset-Start[0][0];
+  y = y_offset-Start[0][1];
+  z = z_offset-Start[0][2];
+  if (x>=0 && x<Box_size[0] && y>=0 && y<Box_size[1] && z>=0 &&
+      z<Box_size[2])
+    overlap = Overlap[(z*Box_size[1]+y)*Box_size[0]+x];
+  else
+    for (cur_object=0; cur_object<Num_objects; cur_object++)
+    {
+      offset[0] = x+Start[cur_object][0];
+      offset[1] = y+Start[cur_object][1];
+      offset[2] = z+Start[cur_object][2];
+      overlap += ts_overlap_at(Pair+cur_object, offset);
+    }
+  return Xor_constant-2*overlap;
+}
+
+/*****************************************************************************
+ * FUNCTION: overlap_box
+ * DESCRIPTION: Adds the overlap of one object over the box of offsets to an
+ *    array.
+ * PARAMETERS:
+ *    object: The object number from 0.
+ *    shrink: As for ts_overlap_box.
+ *    overlap: The array.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The global variables Pair, Start, Box_size must be
+ *    set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: If memory cannot be allocated, a message is written to
+ *    stderr and the process exits.
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void overlap_box(int object, int shrink, double *overlap)
+{
+  int start[3], end[3], j;
+
+  for (j=0; j<3; j++)
+  {
+    start[j] = Start[object][j];
+    end[j] = start[j]+Box_size[j]-1;
+  }
+  if (ts_overlap_box(Pair+object, start, end, shrink, overlap))
+  {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+}
+
 /*****************************************************************************
  * FUNCTION: get_slices
  * DESCRIPTION: Returns total number of slices in a scene.
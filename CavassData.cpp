@@ -95,37 +95,8 @@ void CavassData::loadData ( char* name,
             ucPtr[i] = t[i];
         }
         
-        //determine the global min & max
-        if (m_size==1) {
-            unsigned char*  ucData = (unsigned char*)m_data;
-            m_min = m_max = ucData[0];
-            for (int i=1; i<m_xSize*m_ySize*m_zSize; i++) {
-                if (ucData[i]<m_min)    m_min=ucData[i];
-                if (ucData[i]>m_max)    m_max=ucData[i];
-            }
-        } else if (m_size==2) {
-            unsigned short*  sData = (unsigned short*)m_data;
-            m_min = m_max = sData[0];
-            for (int i=1; i<m_xSize*m_ySize*m_zSize; i++) {
-                if (sData[i]<m_min)    m_min=sData[i];
-                if (sData[i]>m_max)    m_max=sData[i];
-            }
-        } else if (m_size==4) {
-            int*  iData = (int*)m_data;
-            m_min = m_max = iData[0];
-            for (int i=1; i<m_xSize*m_ySize*m_zSize; i++) {
-                if (iData[i]<m_min)    m_min=iData[i];
-                if (iData[i]>m_max)    m_max=iData[i];
-            }
-        } else {
-            assert(0);
-        }
-		if (mLogLevel >= 1)
-	        cout << "min=" << m_min << ", max=" << m_max << endl;
-        if (mLogLevel >= 2)
-		{
-			wxLogMessage( "min=%d, max=%d", m_min, m_max );
-        }
+        assert( m_size==1 || m_size==2 || m_size==4 );
+        determineGlobalMinAndMax();
 		m_lut = (unsigned char*)malloc( (m_max-m_min+1)*sizeof(unsigned char) );
         assert( m_lut != NULL );
         if (m_min==0 && m_max<=1)
@@ -183,7 +154,7 @@ int CavassData::loadFile ( const char* const fn, const bool loadHeaderOnly, bool
 			}
         }
         
-        determineGlobalMinAndMax();
+        determineGlobalMinAndMax( true );
         m_lut = (unsigned char*)malloc( (m_max-m_min+1)*sizeof(unsigned char) );
         assert( m_lut != NULL );
         if (m_min==0 && m_max<=1)
@@ -201,34 +172,28 @@ int CavassData::loadFile ( const char* const fn, const bool loadHeaderOnly, bool
         return 0;
 }
 
-void CavassData::determineGlobalMinAndMax ( void ) {
+void CavassData::determineGlobalMinAndMax ( const bool fromFile ) {
         //determine the global min & max
-        if (m_size==1) {
-            unsigned char*  ucData = (unsigned char*)m_data;
-            m_min = m_max = ucData[0];
-            for (int i=1; i<m_xSize*m_ySize*m_zSize*mSamplesPerPixel; i++) {
-                if (ucData[i]<m_min)    m_min=ucData[i];
-                if (ucData[i]>m_max)    m_max=ucData[i];
-            }
-        } else if (m_size==2) {
-            unsigned short*  sData = (unsigned short*)m_data;
-            int  i;
-            //cout << "loadFile: making short data 12 bits." << endl;
-            //sData[0] &= 0xfff;
-            m_min = m_max = sData[0];
-            for (i=1; i<m_xSize*m_ySize*m_zSize*mSamplesPerPixel; i++) {
-                //sData[i] &= 0xfff;
-                if (sData[i]<m_min)    m_min=sData[i];
-                if (sData[i]>m_max)    m_max=sData[i];
-            }
-        } else if (m_size==4) {
-            int*  iData = (int*)m_data;
-            m_min = m_max = iData[0];
-            for (int i=1; i<m_xSize*m_ySize*m_zSize*mSamplesPerPixel; i++) {
-                if (iData[i]<m_min)    m_min=iData[i];
-                if (iData[i]>m_max)    m_max=iData[i];
+        if (m_size!=1 && m_size!=2 && m_size!=4)    return;
+        const long  n = (long)m_xSize*m_ySize*m_zSize*mSamplesPerPixel;
+        //only unchanged IM0/BIM data may be looked up in the statistics cache
+        const bool  useCache = fromFile && m_vh_initialized
+            && m_vh.gen.data_type==IMAGE0 && mSamplesPerPixel==1
+            && (endsWith(m_fname,".im0") || endsWith(m_fname,".bim"));
+        VSceneStats  stats;
+        if (!useCache
+            || VLookupSceneFileStats( m_fname, m_size*8, m_size==4, &stats )) {
+            if (VInitSceneStats( &stats, m_size*8, m_size==4 )) {
+                cerr << "Out of memory while finding min & max of " << m_fname << endl;
+                return;
             }
+            VAccumulateSceneStats( &stats, m_data, NULL, n );
+            VFinishSceneStats( &stats );
+            if (useCache)    VStoreSceneFileStats( m_fname, &stats );
         }
+        m_min = (int)stats.min;
+        m_max = (int)stats.max;
+        VFreeSceneStats( &stats );
 		if (mLogLevel >= 1)
 	        cout << "min=" << m_min << ", max=" << m_max << endl;
         if (mLogLevel >= 2)
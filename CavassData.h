@@ -345,7 +345,11 @@ private:
      */
     int loadFile ( const char* const fn, const bool loadHeaderOnly, bool grayOnly );
     //------------------------------------------------------------------
-    void determineGlobalMinAndMax ( void );
+    /** \brief determine m_min and m_max in one parallel pass over the data.
+     *  \param fromFile should be true only when the data are the unmodified
+     *  contents of m_fname; the statistics cache is then consulted first.
+     */
+    void determineGlobalMinAndMax ( const bool fromFile=false );
     //------------------------------------------------------------------
 public:
     /** \brief get the current blue emphasis value.
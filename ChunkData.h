@@ -34,6 +34,26 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef  __ChunkData_h
 #define  __ChunkData_h
 
+#include  "ScenePyramid.h"
+#include  <wx/thread.h>
+
+class ChunkData;
+
+/** \brief reads slices of a ChunkData ahead of the viewer (see
+ *  ChunkData::prefetchNext).
+ */
+class ChunkPrefetchThread : public wxThread {
+    ChunkData*  mData;
+public:
+    wxSemaphore  mWake;  ///< posted when the viewer moves to another slice
+    explicit ChunkPrefetchThread ( ChunkData* data )
+      : wxThread( wxTHREAD_JOINABLE ), mData(data), mWake(0, 1)
+    {
+        Create();
+    }
+    inline ExitCode Entry ( void );
+};
+
 /** \brief This class can be used to manage contiguous slices called 
  *  "chunks" (rather loading the entire volume or dealing with the data
  *  one slice at a time).
@@ -43,6 +63,37 @@ protected:
     FILE*        mFp;                 ///< cache the file pointer so slices may be loaded as needed
     const int    mSlicesPerChunk;     ///< # of slices in a chunk
     const int    mOverlapSliceCount;  ///< # of slices that overlap (before and after this chunk)
+    ScenePyramid* mPyramid;           ///< reduced resolution slices (see getPyramid)
+    FILE*        mPrefetchFp;         ///< the prefetch thread's own file pointer
+    ChunkPrefetchThread* mPrefetchThread;  ///< reads slices ahead, once started
+    bool         mPrefetch;           ///< false if the prefetch thread cannot be started
+    wxCriticalSection  mSliceLock;    ///< guards the slices and the members below
+    unsigned long*  mLastUse;         ///< when each loaded slice was last requested
+    unsigned long   mClock;           ///< counts slice requests
+    size_t       mLoadedBytes;        ///< bytes used by the loaded slices
+    int          mLastRequest;        ///< slice requested last
+    int          mStride;             ///< slices between the last two requests
+    long         mHits;               ///< requests for a new slice already loaded
+    long         mMisses;             ///< requests for a new slice read from disk
+    long         mPrefetched;         ///< slices read by the prefetch thread
+    //------------------------------------------------------------------
+    /** \brief the most memory (in bytes) the loaded slices of a scene may use. */
+    static size_t& cacheBudget ( void ) {
+        static size_t  bytes = (size_t)defaultCacheMB << 20;
+        return bytes;
+    }
+    //------------------------------------------------------------------
+    void initCache ( void ) {
+        mPrefetchFp = NULL;
+        mPrefetchThread = NULL;
+        mPrefetch = true;
+        mLastUse = NULL;
+        mClock = 0;
+        mLoadedBytes = 0;
+        mLastRequest = -1;
+        mStride = 1;
+        mHits = mMisses = mPrefetched = 0;
+    }
     //------------------------------------------------------------------
     void init ( void ) {
         mFreeOldChunk = true;
@@ -58,6 +109,12 @@ protected:
             for (int i=0; i<m_zSize; i++) {
                 tmp[i] = 0;
             }
+            mLastUse = (unsigned long*)calloc( m_zSize, sizeof(unsigned long) );
+            if (mLastUse == NULL)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				exit(1);
+			}
         }
 
         /** \todo add support for files other than cavass files (e.g., vtk, tiff, etc) */
@@ -98,15 +155,92 @@ protected:
 		initLUT();
     }
     //------------------------------------------------------------------
+    /** \brief    keep a slice that has just been read (with mSliceLock
+     *            held).
+     */
+    void adoptSlice ( const int which, void* slice ) {
+        ((void**)m_data)[which] = slice;
+        mLoadedBytes += m_bytesPerSlice;
+        mLastUse[which] = ++mClock;
+    }
+    //------------------------------------------------------------------
+    /** \brief    read a slice with mFp (with mSliceLock held).
+     *  \returns  true if successful; false otherwise.
+     */
+    bool loadSlice ( const int which ) {
+        void*  slice = malloc( m_bytesPerSlice );
+        if (slice == NULL)
+        {
+            fprintf(stderr, "Out of memory.\n");
+            return false;
+        }
+        if (!readSlice( mFp, which, slice ))
+        {
+            free( slice );
+            return false;
+        }
+        adoptSlice( which, slice );
+        return true;
+    }
+    //------------------------------------------------------------------
+    /** \brief    free the least recently requested slices outside of the
+     *            chunk being viewed (first..last) until the prefetch
+     *            thread has room to read ahead within the cache budget
+     *            (with mSliceLock held).
+     */
+    void evictSlices ( const int first, const int last ) {
+        const size_t  budget  = cacheBudget();
+        const size_t  reserve = (size_t)prefetchDepth * m_bytesPerSlice;
+        const size_t  limit   = budget > 2*reserve ? budget-reserve : budget/2;
+        void** tmp = (void**)m_data;
+        while (mLoadedBytes > limit) {
+            int  lru = -1;
+            for (int i=0; i<m_zSize; i++) {
+                if (tmp[i] && (i<first || i>last)
+                           && (lru<0 || mLastUse[i]<mLastUse[lru]))
+                    lru = i;
+            }
+            if (lru < 0)    break;
+            free( tmp[lru] );
+            tmp[lru] = 0;
+            mLoadedBytes -= m_bytesPerSlice;
+        }
+    }
+    //------------------------------------------------------------------
+    /** \brief    start the prefetch thread, if not already running (with
+     *            mSliceLock held).
+     *  \returns  true if it is running; false if it cannot be started.
+     */
+    bool startPrefetch ( void ) {
+        if (mPrefetchThread)    return true;
+        if (!mPrefetch)         return false;
+        mPrefetch = false;
+        mPrefetchFp = fopen( m_fname, "rb" );
+        if (mPrefetchFp == NULL)    return false;
+        mPrefetchThread = new ChunkPrefetchThread( this );
+        if (mPrefetchThread->Run() != wxTHREAD_NO_ERROR) {
+            delete mPrefetchThread;
+            mPrefetchThread = NULL;
+            fclose( mPrefetchFp );
+            mPrefetchFp = NULL;
+            return false;
+        }
+        return true;
+    }
+    //------------------------------------------------------------------
 public:
-    enum { defaultSlicesPerChunk=10, defaultOverlapSliceCount=2 };
-    bool  mFreeOldChunk;       ///< free old chunk, otherwise entire volume may eventually be loaded; default=true;
+    enum { defaultSlicesPerChunk=10, defaultOverlapSliceCount=2,
+           prefetchDepth=16,   ///< # of slices read ahead in the direction of travel
+           defaultCacheMB=512  ///< default cache budget of each scene
+         };
+    bool  mFreeOldChunk;       ///< free least recently used slices beyond the cache budget, otherwise entire volume may eventually be loaded; default=true;
     //------------------------------------------------------------------
     ChunkData ( int slicesPerChunk=defaultSlicesPerChunk,
                 int overlapSliceCount=defaultOverlapSliceCount )
         : CavassData(), mSlicesPerChunk(slicesPerChunk),
-          mOverlapSliceCount(overlapSliceCount)
+          mOverlapSliceCount(overlapSliceCount), mPyramid(NULL)
     {
+        initCache();
         if (m_vh_initialized)
 			init();
     }
@@ -116,8 +250,10 @@ public:
         int overlapSliceCount=defaultOverlapSliceCount, bool grayOnly=false,
 		int loglevel=2 )
         : CavassData( fn, true, grayOnly, loglevel ),
-          mSlicesPerChunk(slicesPerChunk), mOverlapSliceCount(overlapSliceCount)
+          mSlicesPerChunk(slicesPerChunk), mOverlapSliceCount(overlapSliceCount),
+          mPyramid(NULL)
     {
+        initCache();
         if (mEntireVolumeIsLoaded) {
 		    mFp = fopen( fn, "rb" );
 			return;
@@ -136,13 +272,33 @@ public:
         const bool vh_initialized )
         : CavassData ( name, xSize, ySize, zSize, xSpacing, ySpacing, zSpacing,
                        data, vh, vh_initialized ),
-          mSlicesPerChunk(10), mOverlapSliceCount(2)
+          mSlicesPerChunk(10), mOverlapSliceCount(2), mPyramid(NULL)
     {
+        initCache();
         if (m_vh_initialized)
 			init();
     }
     //------------------------------------------------------------------
     virtual ~ChunkData ( void ) {
+        //stop the pyramid's background thread before anything it reads goes
+        if (mPyramid) {
+            delete mPyramid;
+            mPyramid = NULL;
+        }
+        //likewise the prefetch thread
+        if (mPrefetchThread) {
+            mPrefetchThread->mWake.Post();
+            mPrefetchThread->Delete();  //waits for it to finish (joinable)
+            delete mPrefetchThread;
+            mPrefetchThread = NULL;
+        }
+        if (mPrefetchFp) {
+            fclose( mPrefetchFp );
+            mPrefetchFp = NULL;
+        }
+        if (mLogLevel>=2 && mHits+mMisses>0)
+            wxLogMessage( "slice cache of %s: %ld hits, %ld misses, %ld prefetched",
+                          m_fname, mHits, mMisses, mPrefetched );
         if (mFp) {
             fclose( mFp );
             mFp = 0;
@@ -154,6 +310,8 @@ public:
             free( m_data );
             m_data = 0;
         }
+        free( mLastUse );
+        mLastUse = NULL;
     }
     //------------------------------------------------------------------
     /** \brief    this function determines if a particular slice has already
@@ -181,15 +339,104 @@ public:
         //really slice data?
         if (mEntireVolumeIsLoaded)    return false;
         //if particular slice has been loaded then free it.
+        wxCriticalSectionLocker  lock( mSliceLock );
         void** tmp = (void**)m_data;
         if (tmp[which]) {
             free( tmp[which] );
             tmp[which] = 0;
+            mLoadedBytes -= m_bytesPerSlice;
             return true;
         }
         return false;
     }
     //------------------------------------------------------------------
+    /** \brief    this function reads one slice of a cavass file from disk.
+     *            (binary data are unpacked to one byte per pixel.)
+     *  \param    fp is an open file pointer to the file.  it need not be
+     *            mFp, so that another thread may read with its own.
+     *  \param    which is the specific slice number.
+     *  \param    dst is where the m_bytesPerSlice bytes of slice data go.
+     *  \returns  true if successful; false otherwise.
+     */
+    bool readSlice ( FILE* fp, const int which, void* dst ) {
+        assert( mIsCavassFile && m_vh_initialized );
+        if (m_vh.scn.num_of_bits!=1) {
+            //gray (more than 1 bit per pixel) data
+            int  err = VLSeekData( fp, (double)which*m_bytesPerSlice );
+            int  num;
+            if (err == 0) {
+                if (m_size==8) {
+                    err = VReadData( (char*)dst, m_size/2,
+                              2*m_bytesPerSlice/m_size, fp, &num );
+                    if (err == 0)
+                        assert( num == 2*m_bytesPerSlice/m_size );
+                } else if (m_size%2) {
+                    err = VReadData( (char*)dst, 1, m_bytesPerSlice, fp, &num );
+                } else {
+                    err = VReadData( (char*)dst, m_size,
+                              m_bytesPerSlice/m_size, fp, &num );
+                    if (err == 0)
+                        assert( num == m_bytesPerSlice/m_size );
+                }
+            }
+            if (err)
+            {
+                fprintf(stderr, "Error reading file.\n");
+                return false;
+            }
+            return true;
+        }
+
+        //this is binary (1 bit per pixel) data
+        if (!( m_vh.scn.dimension_in_alignment == 2 &&
+               m_vh.scn.bytes_in_alignment     == 1 ))
+        {
+            fprintf(stderr, "Unsupported alignment.\n");
+            return false;
+        }
+        //unpack the packed binary data bits to either 0 or 1 in 8 bit data
+        //allow for widths that are not evenly divisible by (not multiples of) 8
+        int  pBytesPerSlice = m_xSize * m_ySize / 8;
+        if ((m_xSize*m_ySize)%8)    ++pBytesPerSlice;
+        //allocate temp space for the packed data
+        unsigned char*  pTmp = (unsigned char*)malloc( pBytesPerSlice );
+        if (pTmp == NULL)
+        {
+            fprintf(stderr, "Out of memory.\n");
+            return false;
+        }
+        //move to the beginning of the specific slice of packed data
+        int  err = VLSeekData( fp, (double)which*pBytesPerSlice );
+        //read the packed data
+        int  num;
+        if (err == 0)
+            err = VReadData( (char*)pTmp, 1, pBytesPerSlice, fp, &num );
+        if (err)
+        {
+            fprintf(stderr, "Error reading file.\n");
+            free(pTmp);
+            return false;
+        }
+        assert( num == pBytesPerSlice );
+        //move/change from packed to unpacked
+        unpack( (unsigned char*)dst, pTmp, m_xSize, m_ySize );
+        free( pTmp );    pTmp=NULL;
+        return true;
+    }
+    //------------------------------------------------------------------
+    /** \brief    the reduced resolution slices of this scene, made when
+     *            first asked for.
+     *  \param    persist is true if the finished pyramid may be saved in
+     *            (and an earlier one read from) a cache file beside the
+     *            scene.
+     *  \returns  the pyramid; NULL if not supported for these data.
+     */
+    ScenePyramid* getPyramid ( const bool persist ) {
+        if (mPyramid==NULL && ScenePyramid::supports( this ))
+            mPyramid = new ScenePyramid( this, persist );
+        return mPyramid;
+    }
+    //------------------------------------------------------------------
     /** \brief    this function returns a pointer to the beginning of the
      *            slice data.  this function will load the slice from disk
      *            into memory if it hasn't already been loaded.
@@ -207,123 +454,113 @@ public:
 
         //chunk data
         void** tmp = (void**)m_data;
-        if (tmp[which])    return tmp[which];
-        //so m_data[which] is 0 indicating that this slice hasn't 
-        // been loaded yet.  so let's go ahead and load it.
+        //the same slice again (only this thread frees slices)?
+        if (which==mLastRequest && tmp[which])    return tmp[which];
         assert( mFileOffsetToData >= 0 );
         assert( mIsBinaryVtkFile || mIsCavassFile );
-        
+
+        wxCriticalSectionLocker  lock( mSliceLock );
+        //note the direction of travel for the prefetch thread
+        if (mLastRequest>=0 && which!=mLastRequest)
+            mStride = which - mLastRequest;
+        mLastRequest = which;
+        mLastUse[which] = ++mClock;
+
         int  firstSlice = which / mSlicesPerChunk * mSlicesPerChunk;
         int  lastSlice  = firstSlice + mSlicesPerChunk - 1;
         firstSlice -= mOverlapSliceCount;
         lastSlice  += mOverlapSliceCount;
         if (firstSlice < 0)          firstSlice = 0;
         if (lastSlice >= m_zSize)    lastSlice = m_zSize-1;
-        if (mFreeOldChunk) {
-            //free any loaded slices that are before the first slice in the chunk
-            for (int i=0; i<firstSlice; i++) {
-                if (tmp[i])    freeSlice( i );
-            }
-            //free any loaded slices that are after the last slice in the chunk
-            for (int i=lastSlice+1; i<m_zSize; i++) {
-                if (tmp[i])    freeSlice( i );
+
+        if (tmp[which]) {
+            ++mHits;
+        } else {
+            //so m_data[which] is 0 indicating that this slice hasn't
+            // been loaded yet.  so let's go ahead and load it.
+            ++mMisses;
+            if (!mIsCavassFile) {
+                /** \todo handle vtk file */
+                assert( 0 );
             }
+            if (!loadSlice( which ))    return NULL;
         }
+        if (mFreeOldChunk)    evictSlices( firstSlice, lastSlice );
 
-        //load any slices that are missing from this chunk
-        for (int i=firstSlice; i<=lastSlice; i++) {
-            if (!tmp[i]) {
-                if (mIsCavassFile) {
-                    assert( m_vh_initialized );
-                    if (m_vh.scn.num_of_bits!=1) {
-                        //gray (more than 1 bit per pixel) data
-                        tmp[i] = malloc( m_bytesPerSlice );
-                        if (tmp[i] == NULL)
-						{
-							fprintf(stderr, "Out of memory.\n");
-							return NULL;
-						}
-                        int  err = VLSeekData( mFp, (double)i*m_bytesPerSlice );
-                        int  num;
-                        if (m_size==8) {
-                            err = VReadData( (char*)tmp[i], m_size/2,
-                                      2*m_bytesPerSlice/m_size, mFp, &num );
-                            if (err == 0)
-								assert( num == 2*m_bytesPerSlice/m_size );
-                        } else if (m_size%2) {
-                            err = VReadData( (char*)tmp[i], 1,
-                                      m_bytesPerSlice, mFp, &num );
-                        } else {
-                            err = VReadData( (char*)tmp[i], m_size,
-                                      m_bytesPerSlice/m_size, mFp, &num );
-                            if (err == 0)
-								assert( num == m_bytesPerSlice/m_size );
-                        }
-						if (err)
-						{
-							fprintf(stderr, "Error reading file.\n");
-							free(tmp[i]);
-							tmp[i] = NULL;
-							return NULL;
-						}
-                    } else {  //this is binary (1 bit per pixel) data
-                        if (!( m_vh.scn.dimension_in_alignment == 2 &&
-							   m_vh.scn.bytes_in_alignment     == 1 ))
-						{
-							fprintf(stderr, "Unsupported alignment.\n");
-							return NULL;
-                        }
-                        //unpack the packed binary data bits to either 0 or 1 in 8 bit data
-                        //static const int  masks[] = { 128, 64, 32, 16, 8, 4, 2, 1 };
-                        //allow for widths that are not evenly divisible by (not multiples of) 8
-                        int  pBytesPerSlice = m_xSize * m_ySize / 8;
-                        if ((m_xSize*m_ySize)%8)    ++pBytesPerSlice;
-                        //allocate temp space for the packed data
-                        unsigned char*  pTmp = (unsigned char*)malloc( pBytesPerSlice );
-                        if (pTmp == NULL)
-						{
-							fprintf(stderr, "Out of memory.\n");
-							return NULL;
-						}
-                        //allocate the unpacked data
-                        tmp[i] = malloc( m_bytesPerSlice );
-                        if (tmp[i] == NULL)
-						{
-							fprintf(stderr, "Out of memory.\n");
-							free(pTmp);
-							return NULL;
-                        }
-						//move to the beginning of the specific slice of packed data
-                        int  err = VLSeekData( mFp, (double)i*pBytesPerSlice );
-                        //read the packed data
-                        int  num;
-                        err = VReadData( (char*)pTmp, 1, pBytesPerSlice, mFp, &num );
-                        if (err == 0)
-						{
-							assert( num == pBytesPerSlice );
-                        }
-						else
-						{
-							fprintf(stderr, "Error reading file.\n");
-							free(pTmp);
-							free(tmp[i]);
-							tmp[i] = NULL;
-							return NULL;
-						}
-						//move/change from packed to unpacked
-                        unpack( (unsigned char*)tmp[i], pTmp, m_xSize, m_ySize );
-                        free( pTmp );    pTmp=NULL;
-                    }  //end else
-                } else {
-                    /** \todo handle vtk file */
-                    assert( 0 );
-                }
+        if (startPrefetch()) {
+            mPrefetchThread->mWake.Post();
+        } else {
+            //no thread to read ahead, so load the rest of this chunk now
+            for (int i=firstSlice; i<=lastSlice; i++) {
+                if (!tmp[i] && !loadSlice( i ))    return NULL;
             }
         }
 
         return tmp[ which ];
     }
     //------------------------------------------------------------------
+    /** \brief    read the next slice ahead of the viewer that is not yet
+     *            loaded, while there is room in the cache budget.  called
+     *            by the prefetch thread.
+     *  \returns  true if a slice was read; false if there is nothing to
+     *            do (or it cannot be read).
+     */
+    bool prefetchNext ( void ) {
+        int  which = -1;
+        {
+            wxCriticalSectionLocker  lock( mSliceLock );
+            if (mLastRequest<0 || mStride==0
+                || mLoadedBytes+m_bytesPerSlice > cacheBudget())
+                return false;
+            //ahead in the direction of travel, around to the start (cine)
+            void** tmp = (void**)m_data;
+            for (int k=1; k<=prefetchDepth && which<0; k++) {
+                int  s = (int)(((long)mLastRequest + (long)k*mStride) % m_zSize);
+                if (s < 0)    s += m_zSize;
+                if (!tmp[s])    which = s;
+            }
+            if (which < 0)    return false;
+        }
+        //read without the lock so the viewer is not kept waiting
+        void*  slice = malloc( m_bytesPerSlice );
+        if (slice == NULL)    return false;
+        const bool  ok = readSlice( mPrefetchFp, which, slice );
+        wxCriticalSectionLocker  lock( mSliceLock );
+        if (!ok) {
+            free( slice );
+            mStride = 0;  //don't try again until the viewer moves
+            return false;
+        }
+        if (((void**)m_data)[which]) {
+            free( slice );  //the viewer read it meanwhile
+        } else {
+            adoptSlice( which, slice );
+            ++mPrefetched;
+        }
+        return true;
+    }
+    //------------------------------------------------------------------
+    /** \brief the most memory the loaded slices of each scene may use. */
+    static void setCacheBudget ( const int megabytes ) {
+        cacheBudget() = (size_t)(megabytes>1 ? megabytes : 1) << 20;
+    }
+    //------------------------------------------------------------------
+    /** \brief # of requests for a new slice already in memory. */
+    long getCacheHits ( void ) {
+        wxCriticalSectionLocker  lock( mSliceLock );
+        return mHits;
+    }
+    /** \brief # of requests for a new slice that had to be read from disk. */
+    long getCacheMisses ( void ) {
+        wxCriticalSectionLocker  lock( mSliceLock );
+        return mMisses;
+    }
+    /** \brief # of slices read ahead by the prefetch thread. */
+    long getCachePrefetched ( void ) {
+        wxCriticalSectionLocker  lock( mSliceLock );
+        return mPrefetched;
+    }
+    //------------------------------------------------------------------
     /** \brief get the data value at a particular 3D (x,y,z) location.
      *  \param p is the source of the data of type T.
      *  \param x is the x location.
@@ -398,5 +635,13 @@ public:
         return CavassData::index( x, y, z );
     }
 };
+//----------------------------------------------------------------------
+inline wxThread::ExitCode ChunkPrefetchThread::Entry ( void ) {
+    while (!TestDestroy()) {
+        if (!mData->prefetchNext())
+            mWake.WaitTimeout( 100 );
+    }
+    return 0;
+}
 
 #endif
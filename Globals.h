@@ -259,5 +259,7 @@ void raiseWIndow ( wxString s );
 class CavassData;
 unsigned char* toRGB ( CavassData& cd );
 unsigned char* toRGBInterpolated ( CavassData& cd, double sx, double sy );
+unsigned char* toRGBReduced ( CavassData& cd, double sx, double sy,
+                              int& w, int& h );
 
 #endif
@@ -34,12 +34,284 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef  __KMeans_h
 #define  __KMeans_h
 
+#include  <assert.h>
+#include  <float.h>
+#include  <math.h>
 #include  <stdlib.h>
-#include  <time.h>
+#include  <algorithm>
+#include  <limits>
+#include  <random>
 #include  <vector>
 
 using namespace std;
-/** \brief Definition and implementation of K Means segmentation.
+/** \brief k means clustering of integer gray values via their histogram.
+ *  the data are visited once (to count each value, in parallel when
+ *  compiled with OpenMP); after that, each iteration costs only O(k)
+ *  because, in 1D, the classes are runs of consecutive values whose
+ *  counts and sums come from prefix sums of the histogram.
+ *
+ *  typical use:
+ *  <pre>
+ *      KMeansHistogram  h( min, max );
+ *      for (each slice)    h.add( slice, w*h );
+ *      h.cluster( 3 );  //h.mCenters[0..2] are the (ascending) centers
+ *  </pre>
+ */
+class KMeansHistogram {
+  public:
+    const long  mMin;        ///< smallest value counted (bin 0)
+    const long  mMax;        ///< largest value counted
+    const long  mBins;       ///< number of bins (mMax-mMin+1)
+    double*     mCount;      ///< number of occurrences of each value
+    int         mK;          ///< number of classes of the last clustering
+    double*     mCenters;    ///< centers (ascending) of the last clustering
+    double      mCost;       ///< sum of squared distances to the centers
+    int         mIteration;  ///< number of iterations (of the best restart)
+    double      mDelta;      ///< last change in the centers
+    enum { MaxIterations=1000 };
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief ctor for values in [minValue,maxValue]; values outside
+     *  are counted as the nearest of the two.
+     */
+    KMeansHistogram ( const long minValue, const long maxValue )
+        : mMin(minValue), mMax(maxValue), mBins(maxValue-minValue+1)
+    {
+        assert( mBins > 0 );
+        mCount = new double[ mBins ];
+        for (long i=0; i<mBins; i++)    mCount[i] = 0;
+        mK = 0;
+        mCenters = NULL;
+        mCost = 0;
+        mIteration = 0;
+        mDelta = 0;
+        mP0 = mP1 = mP2 = NULL;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    ~KMeansHistogram ( void ) {
+        delete [] mCount;
+        if (mCenters!=NULL)    delete [] mCenters;
+        freePrefixSums();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief count values.
+     *  \param L  pointer to input gray pixel values (integer type)
+     *  \param length  # of input gray pixel values
+     */
+    template< typename T >
+    void add ( const T* const L, const long length ) {
+        freePrefixSums();
+        //a private histogram per thread, merged at the end, is not worth
+        // it for a few values
+        if (length < 4*mBins) {
+            for (long i=0; i<length; i++) {
+                long  v = (long)L[i];
+                if (v < mMin)         v = mMin;
+                else if (v > mMax)    v = mMax;
+                ++mCount[ v-mMin ];
+            }
+            return;
+        }
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            double*  count = new double[ mBins ];
+            for (long i=0; i<mBins; i++)    count[i] = 0;
+#ifdef _OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (long i=0; i<length; i++) {
+                long  v = (long)L[i];
+                if (v < mMin)         v = mMin;
+                else if (v > mMax)    v = mMax;
+                ++count[ v-mMin ];
+            }
+#ifdef _OPENMP
+            #pragma omp critical
+#endif
+            {
+                for (long i=0; i<mBins; i++)    mCount[i] += count[i];
+            }
+            delete [] count;
+        }
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief partition the values counted so far into k classes.
+     *  \param k  number of classes
+     *  \param restarts  number of times to cluster (from different
+     *                   initial centers); the one with the least cost
+     *                   is kept
+     *  \param plusPlus  true to choose the initial centers by k-means++
+     *                   (spread out, each with probability proportional
+     *                   to its squared distance from those already
+     *                   chosen); false for k values chosen at random
+     *  \param seed  seed of the random numbers (the same seed gives the
+     *               same result)
+     *  \returns true if successful; false if nothing has been counted.
+     */
+    bool cluster ( const int k, const int restarts=1,
+                   const bool plusPlus=true, const unsigned int seed=1 )
+    {
+        assert( k >= 1 );
+        makePrefixSums();
+        if (mP0[mBins] <= 0)    return false;
+        if (mCenters!=NULL)    delete [] mCenters;
+        mK = k;
+        mCenters = new double[ k ];
+        mCost = DBL_MAX;
+
+        mt19937  random( seed );
+        vector< double >  c( k ), newC( k );
+        for (int r=0; r<(restarts>1 ? restarts : 1); r++) {
+            if (plusPlus)    seedPlusPlus( c, random );
+            else             seedRandom( c, random );
+            sort( c.begin(), c.end() );
+
+            int     it;
+            double  delta = 0;
+            for (it=1; it<=MaxIterations; it++) {
+                //each class is the run of values nearer its center than
+                // the neighboring centers (ties go to the lower class)
+                delta = 0;
+                for (int j=0; j<k; j++) {
+                    double  n, s1, s2;
+                    sums( c, j, n, s1, s2 );
+                    //an empty class keeps its center
+                    newC[j] = n>0 ? mMin + s1/n : c[j];
+                    delta += fabs( newC[j]-c[j] );
+                }
+                sort( newC.begin(), newC.end() );
+                c.swap( newC );
+                if (delta == 0)    break;  //no more changes
+            }
+
+            double  cost = 0;
+            for (int j=0; j<k; j++) {
+                double  n, s1, s2;
+                sums( c, j, n, s1, s2 );
+                const double  o = c[j] - mMin;
+                cost += s2 - 2*o*s1 + o*o*n;
+            }
+            if (cost < mCost) {
+                mCost = cost;
+                mIteration = it>MaxIterations ? MaxIterations : it;
+                mDelta = delta;
+                for (int j=0; j<k; j++)    mCenters[j] = c[j];
+            }
+        }
+        return true;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief class of a value according to the last clustering. */
+    int classOf ( const double value ) const {
+        assert( mCenters != NULL );
+        int  best = 0;
+        for (int j=1; j<mK; j++) {
+            if (fabs( mCenters[j]-value ) < fabs( mCenters[best]-value ))
+                best = j;
+        }
+        return best;
+    }
+
+  protected:
+    double*  mP0;  ///< prefix sums of the counts
+    double*  mP1;  ///< prefix sums of count * (value-mMin)
+    double*  mP2;  ///< prefix sums of count * (value-mMin)^2
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    void freePrefixSums ( void ) {
+        if (mP0!=NULL) {
+            delete [] mP0;    delete [] mP1;    delete [] mP2;
+            mP0 = mP1 = mP2 = NULL;
+        }
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    void makePrefixSums ( void ) {
+        if (mP0!=NULL)    return;
+        mP0 = new double[ mBins+1 ];
+        mP1 = new double[ mBins+1 ];
+        mP2 = new double[ mBins+1 ];
+        mP0[0] = mP1[0] = mP2[0] = 0;
+        for (long i=0; i<mBins; i++) {
+            mP0[i+1] = mP0[i] + mCount[i];
+            mP1[i+1] = mP1[i] + mCount[i]*i;
+            mP2[i+1] = mP2[i] + mCount[i]*i*(double)i;
+        }
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief last bin nearer center j than center j+1. */
+    long lastBin ( const vector< double >& c, const int j ) const {
+        if (j >= (int)c.size()-1)    return mBins-1;
+        const double  b = floor( (c[j]+c[j+1])/2 - mMin );
+        if (b < -1)       return -1;
+        if (b >= mBins)   return mBins-1;
+        return (long)b;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief count, sum, and sum of squares (of value-mMin) of class j. */
+    void sums ( const vector< double >& c, const int j,
+                double& n, double& s1, double& s2 ) const
+    {
+        const long  lo = j>0 ? lastBin( c, j-1 )+1 : 0;
+        const long  hi = lastBin( c, j );
+        if (hi < lo) {
+            n = s1 = s2 = 0;
+            return;
+        }
+        n  = mP0[hi+1] - mP0[lo];
+        s1 = mP1[hi+1] - mP1[lo];
+        s2 = mP2[hi+1] - mP2[lo];
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief a value drawn with probability proportional to weight. */
+    long draw ( const vector< double >& weight, const double total,
+                mt19937& random ) const
+    {
+        const double  u = uniform_real_distribution< double >( 0, total )( random );
+        double  sum = 0;
+        long    last = 0;
+        for (long i=0; i<mBins; i++) {
+            if (weight[i] <= 0)    continue;
+            sum += weight[i];
+            last = i;
+            if (u < sum)    break;
+        }
+        return mMin + last;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief k distinct counted values (if there are that many) at random. */
+    void seedRandom ( vector< double >& c, mt19937& random ) const {
+        vector< double >  weight( mCount, mCount+mBins );
+        double  total = mP0[mBins];
+        for (size_t j=0; j<c.size(); j++) {
+            if (total <= 0)    { c[j] = c[j-1];  continue; }
+            const long  v = draw( weight, total, random );
+            c[j] = (double)v;
+            total -= weight[ v-mMin ];
+            weight[ v-mMin ] = 0;
+        }
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief k-means++ initial centers. */
+    void seedPlusPlus ( vector< double >& c, mt19937& random ) const {
+        vector< double >  d2( mBins, DBL_MAX );
+        vector< double >  weight( mCount, mCount+mBins );
+        c[0] = (double)draw( weight, mP0[mBins], random );
+        for (size_t j=1; j<c.size(); j++) {
+            double  total = 0;
+            for (long i=0; i<mBins; i++) {
+                const double  d = mMin + i - c[j-1];
+                if (d*d < d2[i])    d2[i] = d*d;
+                weight[i] = mCount[i] * d2[i];
+                total += weight[i];
+            }
+            //all values are already centers?
+            c[j] = total>0 ? (double)draw( weight, total, random ) : c[j-1];
+        }
+    }
+};
+//======================================================================
+/** \brief Definition and implementation of K Means segmentation (of
+ *  integer gray values; see KMeansHistogram).
  */
 template< typename T >
 class KMeans1D {
@@ -48,103 +320,51 @@ class KMeans1D {
     int        mIteration;   ///< number of iterations
     double*    mCenters;     ///< location of cluster centers
     double     mDelta;       ///< last change
-    typedef  vector< T >  Vector;
-    Vector*    mPartitions;
+    double     mCost;        ///< sum of squared distances to the centers
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     /** \brief ctor which also performs k means segmentation.
      *  \param k  number of classes
      *  \param L  pointer to input gray pixel values
      *  \param length  # of input gray pixel values
+     *  \param restarts  number of times to cluster (the best is kept)
+     *  \param plusPlus  true for k-means++ initial centers; false for
+     *                   centers chosen at random
      */
-    KMeans1D ( const int k, const T* const L, const int length )
+    KMeans1D ( const int k, const T* const L, const int length,
+               const int restarts=1, const bool plusPlus=true )
         : mK(k)
     {
-        //init the centers
-        mCenters = new double[k];    assert( mCenters!=NULL );
-        double  min = L[0];
-        double  max = L[0];
-        int  i;
-        for (i=0; i<length; i++) {
-            if (L[i]<min)  min=L[i];
-            if (L[i]>max)  max=L[i];
-        }
-        //pick k points (initial cluster centers) at random
-        srand( time(NULL) );
-        for (i=0; i<k; i++) {
-            mCenters[i] = rand() * (max-min+1) / RAND_MAX + min;
-        }
-
-        //init the partitions
-        mPartitions = new Vector[k];    assert( mPartitions!=NULL );
-        for (i=0; i<length; i++) {
-            mPartitions[0].push_back( L[i] );
-        }
-
-        for (mIteration=1; mIteration<=1000; mIteration++) {
-            wxLogMessage( "iteration=%d/%d.", mIteration, 1000 );
-            wxYield();
-            //redistribute the contents of mPartitions according
-            // to the cluster centers
-            Vector*  newPartitions = new Vector[k];
-            assert( newPartitions!=NULL );
-            int  j;
-            for (j=0; j<k; j++) {
-                while (mPartitions[j].size() > 0) {
-                    T  t = mPartitions[j].back();
-                    mPartitions[j].pop_back();
-
-                    int     best = 0;
-                    double  bestValue = fabs( mCenters[0] - t );
-                    for (int m=1; m<k; m++) {
-                        const double  temp = fabs( mCenters[m] - t );
-                        if (temp<bestValue) {
-                            best = m;
-                            bestValue = temp;
-                        }
-                    }
-                    newPartitions[best].push_back( t );
-                }
-            }
-            //now that we've re-partitioned the data, the next step
-            // is to recalculate the cluster centers
-            mDelta = 0.0;
-            for (j=0; j<k; j++) {
-                double  sum   = 0.0;
-                //for ( Vector::iterator vi=newPartitions[j].begin();
-                for ( typename Vector::iterator vi=newPartitions[j].begin();
-                      vi!=newPartitions[j].end(); vi++ )
-                {
-                    sum += *vi;
-                }
-                sum    /= newPartitions[j].size();
-                mDelta += fabs(mCenters[j]-sum);
-                mCenters[j] = sum;
+        assert( length > 0 );
+        //the range of the histogram: every value of a 1 or 2 byte type,
+        // otherwise (one more pass) the range of the data
+        long  min, max;
+        if (sizeof(T) <= 2) {
+            min = (long)numeric_limits< T >::min();
+            max = (long)numeric_limits< T >::max();
+        } else {
+            T  tMin = L[0], tMax = L[0];
+            for (int i=0; i<length; i++) {
+                if (L[i] < tMin)  tMin = L[i];
+                if (L[i] > tMax)  tMax = L[i];
             }
-            //finally, update the current set of partitions
-#ifndef WIN32
-            //delete mPartitions;
-#endif
-            mPartitions = newPartitions;
-
-            //cout << "k-means: " << mIteration << ": delta=" << mDelta << endl;
-            if (mDelta<0.0001*(max-min))  break;
+            min = (long)tMin;
+            max = (long)tMax;
         }
-        //if (k==2) {
-        //    cout << "result: " << (mCenters[1]-mCenters[0])/2+mCenters[0] << endl;
-        //}
+        KMeansHistogram  h( min, max );
+        h.add( L, length );
+        h.cluster( k, restarts, plusPlus );
+        mCenters = new double[k];
+        for (int i=0; i<k; i++)    mCenters[i] = h.mCenters[i];
+        mIteration = h.mIteration;
+        mDelta = h.mDelta;
+        mCost = h.mCost;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     ~KMeans1D ( void ) {
         if (mCenters!=NULL) {
-            delete mCenters;
+            delete [] mCenters;
             mCenters=NULL;
         }
-#if ! defined (WIN32) && ! defined (_WIN32)
-        if (mPartitions!=NULL) {
-            //delete mPartitions;
-            mPartitions=NULL;
-        }
-#endif
     }
 
 };
@@ -70,6 +70,9 @@ wxString       Preferences::_stereoAngle     = "4.0";
 int            Preferences::_stereoLeftRed   = 255,  Preferences::_stereoLeftGreen  =   0,  Preferences::_stereoLeftBlue  =   0;
 int            Preferences::_stereoRightRed  = 0,    Preferences::_stereoRightGreen = 255,  Preferences::_stereoRightBlue = 255;
 int            Preferences::_stereoLeftOdd   = 1;
+int            Preferences::_stereoConcurrent = 1;
+int            Preferences::_pyramidCache    = 1;
+int            Preferences::_sliceCacheMB    = 512;
 
 long           Preferences::_useInputHistory = 1;
 
@@ -106,6 +106,9 @@ class Preferences {
         _stereoRightBlue  = _preferences->Read( "stereoRightBlue", _stereoRightBlue   );
 
         _stereoLeftOdd    = _preferences->Read( "stereoLeftOdd",   _stereoLeftOdd  );
+        _stereoConcurrent = _preferences->Read( "stereoConcurrent",_stereoConcurrent );
+        _pyramidCache     = _preferences->Read( "pyramidCache",    _pyramidCache     );
+        _sliceCacheMB     = _preferences->Read( "sliceCacheMB",    _sliceCacheMB     );
 
         _useInputHistory  = _preferences->Read( "useInputHistory", _useInputHistory  );
         _customAppearance = _preferences->Read("customAppearance",_customAppearance );
@@ -520,6 +523,34 @@ class Preferences {
         return false;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief accessor for concurrent stereo rendering preference.
+     *  true if the left and right views are rendered at the same time
+     *  on separate threads.
+     */
+    static bool getStereoConcurrent ( void ) {
+        Preferences::Instance();
+        if (_stereoConcurrent)    return true;
+        return false;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief accessor for pyramid cache preference.
+     *  true if the reduced slices made for zoomed out views are saved in
+     *  a cache file beside the scene, for use the next time.
+     */
+    static bool getPyramidCache ( void ) {
+        Preferences::Instance();
+        if (_pyramidCache)    return true;
+        return false;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief accessor for slice cache preference: the most memory (in
+     *  megabytes) that the loaded slices of a scene may use.
+     */
+    static int getSliceCacheMB ( void ) {
+        Preferences::Instance();
+        return _sliceCacheMB;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     /** \brief accessor for use input history preference. */
     static bool getUseInputHistory ( void ) {
         Preferences::Instance();
@@ -1009,6 +1040,30 @@ class Preferences {
         Preferences::DeleteInstance();
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief mutator for concurrent stereo rendering preference. */
+    static void setStereoConcurrent ( bool newValue ) {
+        Preferences::Instance();
+        _stereoConcurrent = newValue;
+        _preferences->Write( "stereoConcurrent", _stereoConcurrent );
+        Preferences::DeleteInstance();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief mutator for pyramid cache preference. */
+    static void setPyramidCache ( bool newValue ) {
+        Preferences::Instance();
+        _pyramidCache = newValue;
+        _preferences->Write( "pyramidCache", _pyramidCache );
+        Preferences::DeleteInstance();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief mutator for slice cache preference. */
+    static void setSliceCacheMB ( int newValue ) {
+        Preferences::Instance();
+        _sliceCacheMB = newValue;
+        _preferences->Write( "sliceCacheMB", _sliceCacheMB );
+        Preferences::DeleteInstance();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     /** \brief mutator for use input history preference. */
     static void setUseInputHistory ( bool newValue ) {
         Preferences::Instance();
@@ -1059,6 +1114,9 @@ private:
     static int       _stereoLeftRed,  _stereoLeftGreen,  _stereoLeftBlue;   ///< stereo anaglyph left rgb color
     static int       _stereoRightRed, _stereoRightGreen, _stereoRightBlue;  ///< stereo anaglyph right rgb color
     static int       _stereoLeftOdd;    ///< stereo interlaced rows 1=left-odd-right-even; 0=left-even-right-odd
+    static int       _stereoConcurrent; ///< 1=render left and right views on separate threads; 0=one after the other
+    static int       _pyramidCache;     ///< 1=save reduced slices in a cache file beside the scene; 0=don't
+    static int       _sliceCacheMB;     ///< most memory (MB) the loaded slices of a scene may use
 
     static long      _useInputHistory;  ///< 0=don't use; 1=use input (from) history
 
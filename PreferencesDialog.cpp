@@ -33,6 +33,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include  "cavass.h"
 #include  "PreferencesDialog.h"
+#include  "ChunkData.h"
 #include  "wx/colordlg.h"
 #include  "wx/dirdlg.h"
 #include  "wx/radiobut.h"
@@ -58,8 +59,11 @@ PreferencesDialog::PreferencesDialog ( wxWindow* parent ) {
     mSingleFrameMode    = Preferences::getSingleFrameMode();
     mDejaVuMode         = Preferences::getDejaVuMode();
     mUseInputHistory    = Preferences::getUseInputHistory();
+    mPyramidCache       = Preferences::getPyramidCache();
+    mSliceCacheMB       = Preferences::getSliceCacheMB();
     mStereoMode         = Preferences::getStereoMode();
     mStereoLeftOdd      = false;
+    mStereoConcurrent   = Preferences::getStereoConcurrent();
     mSystemListCtrl     = nullptr;
     mMPIDirectory       = nullptr;
     mTest               = nullptr;
@@ -123,6 +127,17 @@ wxPanel* PreferencesDialog::CreateGeneralSettingsPage ( wxWindow* parent ) const
     cb->SetValue( mUseInputHistory );
     sizer->Add( cb, 0, wxALL, WXC_FROM_DIP(border) );
 
+    //save reduced slices (for zoomed out views) beside the scenes
+    cb = new wxCheckBox( panel, ID_PYRAMID_CACHE, _("save &reduced slices beside scenes"), wxDefaultPosition, wxDefaultSize );
+    cb->SetValue( mPyramidCache );
+    sizer->Add( cb, 0, wxALL, WXC_FROM_DIP(border) );
+
+    //most memory the loaded slices of a scene may use
+    auto bs = new wxBoxSizer( wxHORIZONTAL );
+    bs->Add( new wxStaticText( panel, wxID_ANY, _("slice cache per scene (MB):") ), 0, wxALIGN_CENTER_VERTICAL );
+    bs->Add( new wxTextCtrl( panel, ID_SLICE_CACHE_MB, wxString::Format( "%ld", mSliceCacheMB ), wxDefaultPosition, wxSize(80,-1) ), 0, wxLEFT, 5 );
+    sizer->Add( bs, 0, wxALL, WXC_FROM_DIP(border) );
+
     //show savescreen
     cb = new wxCheckBox( panel, ID_SHOW_SAVE_SCREEN, _("show &save screen"), wxDefaultPosition, wxDefaultSize );
     cb->SetValue( mShowSaveScreen );
@@ -898,6 +913,13 @@ wxPanel* PreferencesDialog::CreateStereoSettingsPage ( wxWindow* parent )
     bs->Add( mStereoAngle, 1 );
     item->Add( bs, 1 );
 
+    //render left and right views concurrently
+    bs = new wxBoxSizer( wxHORIZONTAL );
+    mStereoConcurrentCb = new wxCheckBox( panel, ID_STEREO_CONCURRENT, _("render both views &concurrently") );
+    mStereoConcurrentCb->SetValue( mStereoConcurrent );
+    bs->Add( mStereoConcurrentCb, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+    item->Add( bs, 0, wxGROW|wxALL, 0 );
+
     //add some space
     bs = new wxBoxSizer( wxHORIZONTAL );
     bs->Add( 20, 20, 0 );
@@ -1060,6 +1082,9 @@ void PreferencesDialog::OnOK ( wxCommandEvent& unused ) {
     Preferences::setShowToolTips(         mShowToolTips );
     Preferences::setSingleFrameMode(      mSingleFrameMode );
     Preferences::setDejaVuMode(           mDejaVuMode );
+    Preferences::setPyramidCache(         mPyramidCache );
+    Preferences::setSliceCacheMB(         (int)mSliceCacheMB );
+    ChunkData::setCacheBudget(            (int)mSliceCacheMB );
 #ifdef  PARALLEL
     //save the grid values
     Preferences::clearHostNamesAndProcessCounts();
@@ -1078,6 +1103,8 @@ void PreferencesDialog::OnOK ( wxCommandEvent& unused ) {
     Preferences::setStereoAngle( d );
     //save stereo left odd (for interlaced)
     Preferences::setStereoLeftOdd( mStereoLeftOdd );
+    //save concurrent rendering of the two views
+    Preferences::setStereoConcurrent( mStereoConcurrent );
     //save stereo left rgb (for anaglyph)
     mStereoLeftRed->GetValue().ToDouble(   &r );
     mStereoLeftGreen->GetValue().ToDouble( &g );
@@ -1101,6 +1128,8 @@ IMPLEMENT_CLASS(   PreferencesDialog, wxPropertySheetDialog )
 BEGIN_EVENT_TABLE( PreferencesDialog, wxPropertySheetDialog )
     EVT_CHECKBOX( ID_SINGLE_FRAME_MODE, PreferencesDialog::OnSingleFrameMode )
     EVT_CHECKBOX( ID_DEJA_VU_MODE,      PreferencesDialog::OnDejaVuMode      )
+    EVT_CHECKBOX( ID_PYRAMID_CACHE,     PreferencesDialog::OnPyramidCache    )
+    EVT_TEXT(     ID_SLICE_CACHE_MB,    PreferencesDialog::OnSliceCacheMB    )
     EVT_CHECKBOX( ID_SHOW_LOG,          PreferencesDialog::OnShowLog         )
     EVT_CHECKBOX( ID_SHOW_SAVE_SCREEN,  PreferencesDialog::OnShowSaveScreen  )
     EVT_CHECKBOX( ID_SHOW_TOOL_TIPS,    PreferencesDialog::OnShowToolTips    )
@@ -1119,5 +1148,6 @@ BEGIN_EVENT_TABLE( PreferencesDialog, wxPropertySheetDialog )
     EVT_RADIOBUTTON( ID_STEREO_MODE_INTERLACED, PreferencesDialog::OnStereoModeInterlaced )
     EVT_RADIOBUTTON( ID_STEREO_MODE_ANAGLYPH,   PreferencesDialog::OnStereoModeAnaglyph   )
     EVT_CHECKBOX( ID_STEREO_LEFT_ODD,   PreferencesDialog::OnStereoLeftOdd   )
+    EVT_CHECKBOX( ID_STEREO_CONCURRENT, PreferencesDialog::OnStereoConcurrent )
 END_EVENT_TABLE()
 //----------------------------------------------------------------------
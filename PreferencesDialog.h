@@ -66,6 +66,8 @@ protected:
     bool           mSingleFrameMode;
     bool           mDejaVuMode;
     bool           mUseInputHistory;
+    bool           mPyramidCache;
+    long           mSliceCacheMB;
 
     wxStaticText*  mFgSt;
     wxTextCtrl*    mFgRed;
@@ -129,6 +131,8 @@ protected:
     wxTextCtrl*    mStereoRightBlue;
     bool           mStereoLeftOdd;
     wxCheckBox*    mStereoLeftOddCb;
+    bool           mStereoConcurrent;
+    wxCheckBox*    mStereoConcurrentCb;
 public:
     explicit PreferencesDialog ( wxWindow* parent );
     //~PreferencesDialog ( void )  {  }
@@ -170,6 +174,17 @@ public:
         mUseInputHistory = e.IsChecked();
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief callback for changes to saving reduced slices. */
+    void OnPyramidCache ( wxCommandEvent& e ) {
+        mPyramidCache = e.IsChecked();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief callback for changes to the slice cache size. */
+    void OnSliceCacheMB ( wxCommandEvent& e ) {
+        long  mb;
+        if (e.GetString().ToLong( &mb ) && mb > 0)    mSliceCacheMB = mb;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     /** \brief callback for changes to show log. */
     void OnShowLog ( wxCommandEvent& e ) {
         mShowLog = e.IsChecked();
@@ -221,9 +236,15 @@ public:
         mStereoLeftOdd = e.IsChecked();
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    /** \brief callback for changes to concurrent stereo rendering. */
+    void OnStereoConcurrent ( wxCommandEvent& e ) {
+        mStereoConcurrent = e.IsChecked();
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     void handleStereoModeChange ( void ) {
         mStereoAngleSt->Enable(    mStereoMode != Preferences::StereoModeOff        );
         mStereoAngle->Enable(      mStereoMode != Preferences::StereoModeOff        );
+        mStereoConcurrentCb->Enable( mStereoMode != Preferences::StereoModeOff      );
 
         mStereoLeftOddCb->Enable(  mStereoMode == Preferences::StereoModeInterlaced );
 
@@ -247,8 +268,10 @@ public:
         ID_SINGLE_FRAME_MODE,
         ID_DEJA_VU_MODE,
         ID_USE_INPUT_HISTORY,
+        ID_PYRAMID_CACHE,
+        ID_SLICE_CACHE_MB,
 
-        ID_STEREO_MODE_OFF, ID_STEREO_ANGLE,
+        ID_STEREO_MODE_OFF, ID_STEREO_ANGLE, ID_STEREO_CONCURRENT,
         ID_STEREO_MODE_INTERLACED, ID_STEREO_LEFT_ODD,
         ID_STEREO_MODE_ANAGLYPH, ID_STEREO_LEFT_RED,  ID_STEREO_LEFT_GREEN,  ID_STEREO_LEFT_BLUE,
                                  ID_STEREO_RIGHT_RED, ID_STEREO_RIGHT_GREEN, ID_STEREO_RIGHT_BLUE,
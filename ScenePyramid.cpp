@@ -0,0 +1,332 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include  "cavass.h"
+#include  "ChunkData.h"
+#include  <sys/stat.h>
+
+static const unsigned short  cacheByteOrder = 0x0102;
+
+/** \brief reduces the slices of a pyramid in the background. */
+class PyramidThread : public wxThread {
+    ScenePyramid*  mPyramid;
+public:
+    explicit PyramidThread ( ScenePyramid* pyramid )
+      : wxThread( wxTHREAD_JOINABLE ), mPyramid(pyramid)
+    {
+        Create();
+        SetPriority( WXTHREAD_MIN_PRIORITY );
+    }
+    ExitCode Entry ( void ) {
+        while (!TestDestroy() && mPyramid->buildNext())
+            ;
+        if (!TestDestroy())
+            mPyramid->save();
+        return 0;
+    }
+};
+//----------------------------------------------------------------------
+/** \brief halve a slice in x and y.
+ *  \param src is the slice; w by h pixels of samples values each.
+ *  \param dst receives (w+1)/2 by (h+1)/2 pixels, each the rounded mean
+ *         (or for binary data the max) of the 2x2 pixels it covers.
+ */
+template< typename T >
+static void halve ( const T* const src, const int w, const int h,
+                    T* const dst, const int samples, const bool binary )
+{
+    const int  dw = (w+1)/2,  dh = (h+1)/2;
+    for (int y=0; y<dh; y++) {
+        for (int x=0; x<dw; x++) {
+            for (int s=0; s<samples; s++) {
+                double  sum = 0;
+                int     n = 0;
+                T       most = src[ ((2*y)*w + 2*x)*samples + s ];
+                for (int j=2*y; j<2*y+2 && j<h; j++) {
+                    for (int i=2*x; i<2*x+2 && i<w; i++) {
+                        const T  v = src[ (j*w + i)*samples + s ];
+                        sum += v;
+                        n++;
+                        if (v>most)    most = v;
+                    }
+                }
+                dst[ (y*dw + x)*samples + s ] =
+                    binary ? most : (T)floor( sum/n + 0.5 );
+            }
+        }
+    }
+}
+//----------------------------------------------------------------------
+/** \brief determine whether a pyramid can be made for a scene.
+ *  \param cd is the scene.
+ *  \returns true for IM0/BIM files read a chunk at a time, with 1 or 2
+ *  bytes per gray or rgb sample.
+ */
+bool ScenePyramid::supports ( const ChunkData* cd ) {
+    if (!cd->mIsCavassFile || !cd->m_vh_initialized ||
+        cd->mEntireVolumeIsLoaded || cd->m_fname==NULL)
+        return false;
+    if (cd->mSamplesPerPixel!=1 && cd->mSamplesPerPixel!=3)    return false;
+    if (cd->m_size % cd->mSamplesPerPixel)    return false;
+    const int  bytes = cd->m_size / cd->mSamplesPerPixel;
+    return (bytes==1 || bytes==2) && cd->m_xSize>1 && cd->m_ySize>1;
+}
+//----------------------------------------------------------------------
+/** \brief choose the level to display a scene at a given scale.
+ *  \param sx is the scale (displayed pixels per scene pixel) in x.
+ *  \param sy is the scale in y.
+ *  \returns the coarsest level that still has at least the displayed
+ *  resolution in both directions; 0 if none is reduced.
+ */
+int ScenePyramid::levelFor ( const double sx, const double sy ) {
+    const double  s = (sx>sy) ? sx : sy;
+    int  level = 0;
+    while (level<Levels && s>0 && s*(2<<level) <= 1.0)    level++;
+    return level;
+}
+//----------------------------------------------------------------------
+/** \brief ScenePyramid ctor.  nothing is read until a slice is asked for.
+ *  \param cd is the scene; supports(cd) must be true.
+ *  \param persist is true if the finished pyramid may be saved in (and an
+ *         earlier one read from) a cache file beside the scene.
+ */
+ScenePyramid::ScenePyramid ( ChunkData* cd, const bool persist )
+    : mData(cd), mPersist(persist), mDone(0), mNext(0), mFp(NULL),
+      mCacheFp(NULL), mCacheOffset(0), mFull(NULL), mCacheName(NULL),
+      mThread(NULL)
+{
+    assert( supports(cd) );
+    mSamples      = cd->mSamplesPerPixel;
+    mElementBytes = cd->m_size / mSamples;
+    mSigned       = cd->m_min < 0;
+    mBinary       = cd->m_vh.scn.num_of_bits == 1;
+    mSlices       = cd->m_zSize;
+    mWidth[0]  = cd->m_xSize;
+    mHeight[0] = cd->m_ySize;
+    mLevel[0]  = NULL;
+    for (int level=0; level<=Levels; level++) {
+        if (level>0) {
+            mWidth[level]  = (mWidth[level-1]+1) / 2;
+            mHeight[level] = (mHeight[level-1]+1) / 2;
+            mLevel[level]  = (void**)calloc( mSlices, sizeof(void*) );
+            if (mLevel[level]==NULL) {
+                fprintf(stderr, "Out of memory.\n");
+                exit(1);
+            }
+        }
+        mBytes[level] = (long)mWidth[level] * mHeight[level] * mSamples *
+                        mElementBytes;
+    }
+    mCacheName = (char*)malloc( strlen(cd->m_fname) + 5 );
+    if (mCacheName==NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    sprintf( mCacheName, "%s.pyr", cd->m_fname );
+    if (!mPersist || !openCache())
+        mFp = fopen( cd->m_fname, "rb" );
+}
+//----------------------------------------------------------------------
+/** \brief ScenePyramid dtor.  stops the background thread first. */
+ScenePyramid::~ScenePyramid ( void ) {
+    if (mThread!=NULL) {
+        mThread->Delete();  //waits for it to finish (joinable)
+        delete mThread;
+        mThread = NULL;
+    }
+    for (int level=1; level<=Levels; level++) {
+        for (int i=0; i<mSlices; i++)
+            if (mLevel[level][i]!=NULL)    free( mLevel[level][i] );
+        free( mLevel[level] );
+    }
+    if (mFp!=NULL)         fclose( mFp );
+    if (mCacheFp!=NULL)    fclose( mCacheFp );
+    if (mFull!=NULL)       free( mFull );
+    free( mCacheName );
+}
+//----------------------------------------------------------------------
+/** \brief get one slice at one level.  the first request starts the
+ *  background thread that reduces the other slices.
+ *  \param level is the level, 1..Levels.
+ *  \param which is the slice number.
+ *  \returns the slice (owned by the pyramid; getWidth(level) by
+ *  getHeight(level) pixels of the same type as the scene); NULL if it
+ *  cannot be read.
+ */
+const void* ScenePyramid::getSlice ( const int level, const int which ) {
+    if (level<1 || level>Levels || which<0 || which>=mSlices)    return NULL;
+    wxCriticalSectionLocker  lock( mLock );
+    if (mLevel[level][which]==NULL && !reduce( which ))    return NULL;
+    //mThread and mNext are shared with buildNext on the worker thread
+    if (mThread==NULL && mNext<mSlices) {
+        mThread = new PyramidThread( this );
+        if (mThread->Run() != wxTHREAD_NO_ERROR) {
+            delete mThread;
+            mThread = NULL;
+            mNext = mSlices;  //don't try again
+        }
+    }
+    return mLevel[level][which];
+}
+//----------------------------------------------------------------------
+/** \brief reduce the next slice not yet done (for the background thread).
+ *  \returns false when there is nothing more to do.
+ */
+bool ScenePyramid::buildNext ( void ) {
+    wxCriticalSectionLocker  lock( mLock );
+    while (mNext<mSlices && mLevel[1][mNext]!=NULL)    mNext++;
+    if (mNext>=mSlices)    return false;
+    if (!reduce( mNext )) {
+        mNext = mSlices;
+        return false;
+    }
+    mNext++;
+    return true;
+}
+//----------------------------------------------------------------------
+/** \brief make all levels of one slice, from the cache file if it is
+ *  valid and otherwise from the scene.  mLock must be held.
+ *  \param which is the slice number.
+ *  \returns true if successful; false otherwise.
+ */
+bool ScenePyramid::reduce ( const int which ) {
+    void*  slice[Levels+1];
+    int    level;
+
+    for (level=1; level<=Levels; level++) {
+        slice[level] = malloc( mBytes[level] );
+        if (slice[level]==NULL) {
+            fprintf(stderr, "Out of memory.\n");
+            while (--level>0)    free( slice[level] );
+            return false;
+        }
+    }
+
+    bool  ok = true;
+    if (mCacheFp!=NULL) {
+        long  sliceBytes = 0;
+        for (level=1; level<=Levels; level++)    sliceBytes += mBytes[level];
+        ok = fseeko( mCacheFp, (off_t)(mCacheOffset +
+                     (double)which*sliceBytes), SEEK_SET ) == 0;
+        for (level=1; ok && level<=Levels; level++)
+            ok = fread( slice[level], 1, mBytes[level], mCacheFp ) ==
+                 (size_t)mBytes[level];
+    } else {
+        if (mFull==NULL)    mFull = malloc( mData->m_bytesPerSlice );
+        ok = mFp!=NULL && mFull!=NULL &&
+             mData->readSlice( mFp, which, mFull );
+        slice[0] = mFull;
+        for (level=1; ok && level<=Levels; level++) {
+            const int  w = mWidth[level-1],  h = mHeight[level-1];
+            if (mElementBytes==1 && mSigned)
+                halve( (signed char*)slice[level-1], w, h,
+                       (signed char*)slice[level], mSamples, mBinary );
+            else if (mElementBytes==1)
+                halve( (unsigned char*)slice[level-1], w, h,
+                       (unsigned char*)slice[level], mSamples, mBinary );
+            else if (mSigned)
+                halve( (signed short*)slice[level-1], w, h,
+                       (signed short*)slice[level], mSamples, mBinary );
+            else
+                halve( (unsigned short*)slice[level-1], w, h,
+                       (unsigned short*)slice[level], mSamples, mBinary );
+        }
+    }
+    if (!ok) {
+        for (level=1; level<=Levels; level++)    free( slice[level] );
+        return false;
+    }
+
+    for (level=1; level<=Levels; level++)
+        mLevel[level][which] = slice[level];
+    if (++mDone==mSlices && mFull!=NULL) {
+        free( mFull );
+        mFull = NULL;
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+/** \brief the first line of the cache file for the scene as it is now.
+ *  the size and modification time of the scene make an old cache invalid.
+ *  \returns false if the scene cannot be examined.
+ */
+bool ScenePyramid::cacheHeader ( char* header, const int size ) const {
+    struct stat  st;
+    if (stat( mData->m_fname, &st ) != 0)    return false;
+    snprintf( header, size, "CAVASS pyramid 1 %d %d %d %d %d %d %d %lld %lld\n",
+              mWidth[0], mHeight[0], mSlices, Levels, mElementBytes,
+              mSamples, mBinary ? 1 : 0, (long long)st.st_size,
+              (long long)st.st_mtime );
+    return true;
+}
+//----------------------------------------------------------------------
+/** \brief open the cache file if it matches the scene.
+ *  \returns true if the slices will be read from the cache file.
+ */
+bool ScenePyramid::openCache ( void ) {
+    char  expected[200], found[200];
+    if (!cacheHeader( expected, sizeof(expected) ))    return false;
+    FILE*  fp = fopen( mCacheName, "rb" );
+    if (fp==NULL)    return false;
+    const size_t  n = strlen( expected );
+    unsigned short  order = 0;
+    if (fread( found, 1, n, fp ) != n || memcmp( found, expected, n ) != 0 ||
+        fread( &order, sizeof(order), 1, fp ) != 1 || order!=cacheByteOrder) {
+        fclose( fp );
+        return false;
+    }
+    mCacheFp = fp;
+    mCacheOffset = (long)(n + sizeof(order));
+    return true;
+}
+//----------------------------------------------------------------------
+/** \brief save the finished pyramid in the cache file (if persist was
+ *  requested and it did not come from there).  the file is written under
+ *  a temporary name and renamed, so a partial cache is never seen.
+ *  failures are silent; the pyramid is simply made again next time.
+ */
+void ScenePyramid::save ( void ) {
+    char  header[200];
+    if (!mPersist || mCacheFp!=NULL || mDone<mSlices)    return;
+    if (!cacheHeader( header, sizeof(header) ))    return;
+    char*  tmpName = (char*)malloc( strlen(mCacheName) + 5 );
+    if (tmpName==NULL)    return;
+    sprintf( tmpName, "%s.tmp", mCacheName );
+    FILE*  fp = fopen( tmpName, "wb" );
+    if (fp==NULL) {
+        free( tmpName );
+        return;
+    }
+    bool  ok = fwrite( header, 1, strlen(header), fp ) == strlen(header) &&
+               fwrite( &cacheByteOrder, sizeof(cacheByteOrder), 1, fp ) == 1;
+    for (int i=0; ok && i<mSlices; i++)
+        for (int level=1; ok && level<=Levels; level++)
+            ok = fwrite( mLevel[level][i], 1, mBytes[level], fp ) ==
+                 (size_t)mBytes[level];
+    if (fclose( fp ) != 0)    ok = false;
+    if (ok) {
+        remove( mCacheName );
+        ok = rename( tmpName, mCacheName ) == 0;
+    }
+    if (!ok)    remove( tmpName );
+    free( tmpName );
+}
@@ -0,0 +1,92 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+//======================================================================
+/**
+ * \file   ScenePyramid.h
+ * \brief  Definition of ScenePyramid class.
+ */
+//======================================================================
+#ifndef  __ScenePyramid_h
+#define  __ScenePyramid_h
+
+#include  <stdio.h>
+#include  <wx/thread.h>
+
+class ChunkData;
+
+/** \brief This class keeps copies of the slices of a scene reduced 2, 4
+ *  and 8 times in x and y, so that views zoomed out (montage thumbnails in
+ *  particular) need neither read nor convert the slices at full resolution.
+ *
+ *  A slice is reduced the first time any of its levels is asked for, and
+ *  from then on a background thread reduces the rest.  When every slice
+ *  is done, the levels may be saved in a cache file beside the scene (its
+ *  name with ".pyr" appended); a later pyramid of the unchanged scene then
+ *  reads its slices from there instead of from the scene.
+ */
+class ScenePyramid {
+public:
+    enum { Levels=3 };  ///< reduced levels; level n is reduced 2^n times
+    //------------------------------------------------------------------
+    ScenePyramid ( ChunkData* cd, const bool persist );
+    ~ScenePyramid ( void );
+    //------------------------------------------------------------------
+    static bool supports ( const ChunkData* cd );
+    static int  levelFor ( const double sx, const double sy );
+    //------------------------------------------------------------------
+    /** \brief width of the slices at a level (0 for full resolution). */
+    int  getWidth  ( const int level ) const {  return mWidth[level];   }
+    /** \brief height of the slices at a level (0 for full resolution). */
+    int  getHeight ( const int level ) const {  return mHeight[level];  }
+    //------------------------------------------------------------------
+    const void* getSlice ( const int level, const int which );
+    bool buildNext ( void );
+    void save ( void );
+
+protected:
+    ChunkData*   mData;          ///< the scene
+    const bool   mPersist;       ///< save to / read from the cache file
+    int          mElementBytes;  ///< 1 or 2 bytes per sample
+    int          mSamples;       ///< samples per pixel: 1 (gray) or 3 (rgb)
+    bool         mSigned;        ///< signed data
+    bool         mBinary;        ///< binary data (reduced by max, not mean)
+    int          mSlices;        ///< # of slices
+    int          mWidth[Levels+1], mHeight[Levels+1];
+    long         mBytes[Levels+1];  ///< bytes in a slice at each level
+    void**       mLevel[Levels+1];  ///< slices at each level (not level 0)
+    int          mDone;          ///< # of slices reduced
+    int          mNext;          ///< next slice for the background thread
+    FILE*        mFp;            ///< our own file pointer to the scene
+    FILE*        mCacheFp;       ///< the cache file, if valid
+    long         mCacheOffset;   ///< offset of the slices in the cache file
+    void*        mFull;          ///< one full resolution slice
+    char*        mCacheName;     ///< name of the cache file
+    wxCriticalSection  mLock;    ///< guards everything above
+    wxThread*    mThread;        ///< the background thread, once started
+
+    bool reduce ( const int which );
+    bool openCache ( void );
+    bool cacheHeader ( char* header, const int size ) const;
+};
+
+#endif
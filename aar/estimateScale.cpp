@@ -27,6 +27,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 //----------------------------------------------------------------------
 #include  "cavass.h"
 #include  "ChunkData.h"
+#include  "KMeans.h"
 #include  <limits.h>
 #include  <vector>
 
@@ -34,113 +35,51 @@ using namespace std;
 
 static bool  verbose = true;
 //----------------------------------------------------------------------
-static int compare ( const void* a, const void* b ) {
-    const double *ia = (const double *)a; // casting pointer types
-    const double *ib = (const double *)b;
-    if (*ia < *ib)    return -1;
-    if (*ia > *ib)    return 1;
-    return 0;
+/** \brief histogram of the gray values (one pass over the data, slice
+ *  by slice), from which k means are then calculated for any k.
+ */
+static KMeansHistogram* histogram ( ChunkData* gray ) {
+    printf( "calculating histogram ... \n" );  fflush(stdout);
+    KMeansHistogram*  h = new KMeansHistogram( gray->m_min, gray->m_max );
+    const long  n = (long)gray->m_xSize * gray->m_ySize;
+    for (int z=0; z<gray->m_zSize; z++) {
+        void*  slice = gray->getSlice( z );
+        assert( slice != NULL );
+        if (gray->m_size%2==1) {
+            if (gray->m_min>=0)    h->add( (unsigned char*)slice, n );
+            else                   h->add( (signed char*)slice, n );
+        } else if (gray->m_size==2) {
+            if (gray->m_min>=0)    h->add( (unsigned short*)slice, n );
+            else                   h->add( (signed short*)slice, n );
+        } else if (gray->m_size==4) {
+            h->add( (int*)slice, n );
+        } else if (gray->m_size==8) {
+            h->add( (double*)slice, n );
+        } else {
+            assert( 0 );
+        }
+    }
+    return h;
 }
 //----------------------------------------------------------------------
-static double* kMeans ( int k, ChunkData* gray ) {
+static double* kMeans ( int k, KMeansHistogram* histo ) {
     printf( "in kMeans \n" );  fflush(stdout);
     assert( k >= 2 );
-    assert( gray != NULL );
-
-    //allocate k centers (means)
-    double* m = (double*) malloc( k * sizeof(double) );
-    assert( m != NULL );
-    double* newM = (double*) malloc( k * sizeof(double) );
-    assert( newM != NULL );
-
-    //randomly assign cluster centers (uniquely)
-    srand( time(NULL) );
-    for (int i=0; i<k; /*blank*/) {
-        m[i] = rand() % (gray->m_max+1);  //0 .. max
-        bool duplicate = false;
-        for (int j=0; j<i; j++) {
-            if (m[j] == m[i]) { duplicate = true;  break; }
-        }
-        if (!duplicate)  ++i;
-    }
-
-    //create a histogram of gray values
-    int* histo = (int*) malloc( (gray->m_max+1) * sizeof(int) );
     assert( histo != NULL );
-    for (int i=0; i<=gray->m_max; i++)    histo[i] = 0;
-    //init histogram
-    printf( "calculating histogram ... \n" );  fflush(stdout);
-    for (int z=0; z<gray->m_zSize; z++) {
-        for (int y=0; y<gray->m_ySize; y++) {
-            for (int x=0; x<gray->m_xSize; x++) {
-                ++histo[ gray->getData( x, y, z ) ];
-            }
-        }
-    }
 
     printf( "determining cluster centers ... \n" );  fflush(stdout);
-    double*  sum   = (double*) malloc( k * sizeof(double) );
-    int*     count = (int*)    malloc( k * sizeof(int) );
-    double*  d     = (double*) malloc( k * sizeof(double) );
-    for (int i=0; i<k; i++) {
-        sum[i]   = 0;
-        count[i] = 0;
-        d[i]     = 0;
-    }
-
-    for (int it=1; it<=1000; it++) {
-        printf( "." );  fflush(stdout);
-        for (int i=0; i<k; i++) {
-            sum[i]   = 0;
-            count[i] = 0;
-        }
-        //for each pixel (via processing the histogram)
-        for (int i=0; i<=gray->m_max; i++) {
-            if (histo[i]==0)    continue;
-            //calc diffs from means
-            for (int j=0; j<k; j++) {
-                d[j] = fabs( i - m[j] );
-            }
-            //find the min d
-            int where = 0;
-            for (int j=1; j<k; j++) {
-                if (d[j] < d[where])    where = j;
-            }
-            sum[ where ]   += histo[ i ] * i;
-            count[ where ] += histo[ i ];
-        }
-
-        //determine new centers
-        for (int j=0; j<k; j++) {
-            assert( count[j] > 0 );
-            newM[j] = sum[j] / count[ j ];
-        }
-
-        //any more changes?
-        // (no need to keep iterating if no more changes)
-        bool allSame = true;
-        for (int j=0; j<k; j++) {
-            if (newM[j] != m[j]) {
-                allSame = false;
-                break;
-            }
-        }
-        if (allSame)    break;  //done!
-
-        //copy new centers to old
-        for (int j=0; j<k; j++) {
-            m[j] = newM[j];
-        }
+    //k-means++ initial centers, best of a few
+    if (!histo->cluster( k, 5, true )) {
+        printf( "No data. \n" );
+        exit( -1 );
     }
+    if (verbose)
+        printf( "%d iterations, cost=%g \n", histo->mIteration, histo->mCost );
 
-    free( d );
-    free( count );
-    free( sum );
-    free( histo );
-    free( newM );
-
-    //return results (centers)
-    qsort( m, k, sizeof(m[0]), compare );
+    //return results (centers, ascending)
+    double* m = (double*) malloc( k * sizeof(double) );
+    assert( m != NULL );
+    for (int j=0; j<k; j++)    m[j] = histo->mCenters[j];
     return m;
 }
 //----------------------------------------------------------------------
@@ -636,9 +575,10 @@ int main ( int argc, char* argv[] ) {
     printf( "file=%s \n", argv[1] );
     ChunkData* gray = new ChunkData( argv[1] );
     assert( gray != NULL );
+    KMeansHistogram*  histo = histogram( gray );
 
     //try 1 threshold
-    double* mean = kMeans ( 2, gray );
+    double* mean = kMeans ( 2, histo );
     printf( "\n" );
     printf( "for k=2 \n" );
     for (int k=0; k<2; k++) {
@@ -650,7 +590,7 @@ int main ( int argc, char* argv[] ) {
     free( mean );    mean = NULL;
 
     //try 2 thresholds
-    mean = kMeans ( 3, gray );
+    mean = kMeans ( 3, histo );
     printf( "\n" );
     printf( "for k=3 \n" );
     for (int k=0; k<3; k++) {
@@ -658,6 +598,7 @@ int main ( int argc, char* argv[] ) {
         if (k>0)    printf( "    t%d=%.2f \n", k, (mean[k]+mean[k-1])/2.0 );
     }
     free( mean );    mean = NULL;
+    delete histo;    histo = NULL;
 
     //optionally apply theshold, determine largest connected component in each slice,
 	// fill open areas/voids in largest connected component
@@ -26,31 +26,73 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef WIN32
 	#include <unistd.h>
 #endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "render/matrix.cpp"
 
+/* A training mask: its header, voxel size, and the bounding box of its set
+ * voxels in voxel units (x, y from 0, slice index), empty if bounds[1] is
+ * less than bounds[0].
+ */
+typedef struct {
+  ViewnixHeader vh;
+  float voxsz[3];
+  int bounds[6];
+} Mask_info;
+
+/* Partial sums of one thread: count[v] is the number of its masks that set
+ * output voxel v; stamp[v] is 1 + the last of its masks to set v.
+ */
+typedef struct {
+  unsigned short *count;
+  int *stamp;
+} Accumulator;
+
 void destroy_scene_header(ViewnixHeader *vh);
+int read_mask_info(const char filename[], Mask_info *info);
+int accumulate_mask(const char filename[], const Mask_info *info, int mask,
+  const ViewnixHeader *outvh, const double max_voxel_size[3],
+  Accumulator *acc);
 
 int main(argc,argv)
 int argc;
 char *argv[];
 {
-  int i, j, size, error, slices1;
-  ViewnixHeader vh1, outvh;
-  FILE *in1, *outfp;
+  int i, j, error, fuzzy=FALSE, first, bad_mask=-1;
+  long size, out_size, v;
+  ViewnixHeader outvh;
+  FILE *outfp;
   char group[6],elem[6];
   unsigned char *out_data;
+  unsigned short *count;
   int out_slices;
-  int slc, row, col;
   double bbox[6], max_voxel_size[3];
-  float (*voxsz)[3];
+  Mask_info *info;
   int ns; // number of samples
 
+  if (argc>1 && strcmp(argv[1], "-fuzzy")==0)
+  {
+    fuzzy = TRUE;
+    argv++;
+    argc--;
+  }
   if (argc < 3) {
-    fprintf(stderr, "Usage: merge <input BIM_file> ... <output BIM_file>\n");
+    fprintf(stderr,
+      "Usage: merge [-fuzzy] <input BIM_file> ... <output BIM_file>\n");
+    fprintf(stderr,
+      "  -fuzzy: output the fraction of inputs set at each voxel,\n");
+    fprintf(stderr,
+      "          0 to 65534, instead of their union\n");
     exit(-1);
   }
   ns = argc-2;
+  if (ns > 65535)
+  {
+    fprintf(stderr, "Too many inputs.\n");
+    exit(-1);
+  }
   memset(max_voxel_size, 0, sizeof(max_voxel_size));
   memset(&outvh, 0, sizeof(outvh));
   strcpy(outvh.gen.recognition_code, "VIEWNIX1.0");
@@ -65,71 +107,87 @@ char *argv[];
   outvh.scn.smallest_density_value[0] = 0;
   outvh.scn.smallest_density_value_valid = 1;
   outvh.scn.largest_density_value = (float *)malloc(sizeof(float));
-  outvh.scn.largest_density_value[0] = 1;
+  outvh.scn.largest_density_value[0] = fuzzy? 65534: 1;
   outvh.scn.largest_density_value_valid = 1;
   outvh.scn.num_of_integers = 1;
   outvh.scn.num_of_integers_valid = 1;
   outvh.scn.signed_bits = (short *)calloc(1, sizeof(short));
   outvh.scn.signed_bits_valid = 1;
-  outvh.scn.num_of_bits = 1;
+  outvh.scn.num_of_bits = fuzzy? 16: 1;
   outvh.scn.num_of_bits_valid = 1;
   outvh.scn.bit_fields = (short *)malloc(2*sizeof(short));
   outvh.scn.bit_fields[0] = 0;
-  outvh.scn.bit_fields[1] = 0;
+  outvh.scn.bit_fields[1] = outvh.scn.num_of_bits-1;
   outvh.scn.bit_fields_valid = 1;
-  voxsz = (float (*)[3])malloc(ns*sizeof(float)*3);
+
+  /* Find the bounding box of each mask, reading the masks concurrently. */
+  info = (Mask_info *)calloc(ns, sizeof(Mask_info));
+  if (info == NULL)
+  {
+    fprintf(stderr, "Out of memory.\n");
+    exit(1);
+  }
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
   for (j=0; j<ns; j++)
+    if (read_mask_info(argv[j+1], info+j))
+    {
+#ifdef _OPENMP
+      #pragma omp critical
+#endif
+      if (bad_mask<0 || j<bad_mask)
+        bad_mask = j;
+    }
+  if (bad_mask >= 0)
+  {
+    fprintf(stderr, "Could not read %s\n", argv[bad_mask+1]);
+    exit(-1);
+  }
+  for (j=0,first=TRUE; j<ns; j++)
   {
-    FILE *tfp;
-	int len1=strlen(argv[j+1]);
-    char *cmd=(char *)malloc(len1+36);
-	char line[80];
-	float bbj[6];
+    float bbj[6]; // Use scanner origin, but scene orientation.
+	ViewnixHeader *vh1=&info[j].vh;
 
-	sprintf(cmd, "bin_volume %s -b > MRG-TMP-INFO", argv[j+1]);
-	system(cmd);
-	tfp = fopen("MRG-TMP-INFO", "rb");
-	fgets(line, 80, tfp);
-	fgets(line, 80, tfp);
-	fgets(line, 80, tfp);
-	if (fscanf(tfp,"Bounding Box            -> [%f, %f] x [%f, %f] x [%f, %f]",
-	    bbj, bbj+1, bbj+2, bbj+3, bbj+4, bbj+5) != 6)
+	if (info[j].bounds[1] < info[j].bounds[0])
 	{
-	  fprintf(stderr, "Could not find bounding box for %s\n", argv[j+1]);
-	  exit(-1);
+	  fprintf(stderr, "Warning: %s is empty.\n", argv[j+1]);
+	  continue;
 	}
-	fclose(tfp);
-	unlink("MRG-TMP-INFO");
-	if (j==0 || bbj[0]<bbox[0])
-	  bbox[0] = bbj[0];
-	if (j==0 || bbj[1]>bbox[1])
-	  bbox[1] = bbj[1];
-	if (j==0 || bbj[2]<bbox[2])
-	  bbox[2] = bbj[2];
-	if (j==0 || bbj[3]>bbox[3])
-	  bbox[3] = bbj[3];
-	if (j==0 || bbj[4]<bbox[4])
-	  bbox[4] = bbj[4];
-	if (j==0 || bbj[5]>bbox[5])
-	  bbox[5] = bbj[5];
-	sprintf(cmd, "get_slicenumber %s -s > SAMPLING-TEMP", argv[j+1]);
-	system(cmd);
-	tfp = fopen("SAMPLING-TEMP", "rb");
-	if (fscanf(tfp, "%f %f %f", voxsz[j], voxsz[j]+1, voxsz[j]+2) != 3)
+	bbj[0] = vh1->scn.xypixsz[0]*info[j].bounds[0];
+	bbj[1] = vh1->scn.xypixsz[0]*info[j].bounds[1];
+	bbj[2] = vh1->scn.xypixsz[1]*info[j].bounds[2];
+	bbj[3] = vh1->scn.xypixsz[1]*info[j].bounds[3];
+	bbj[4] = vh1->scn.loc_of_subscenes[info[j].bounds[4]];
+	bbj[5] = vh1->scn.loc_of_subscenes[info[j].bounds[5]];
+	if (vh1->scn.domain_valid)
+	  for (i=0; i<3; i++)
+	  {
+	    float d=vh1->scn.domain[0]*vh1->scn.domain[3+3*i]+
+		        vh1->scn.domain[1]*vh1->scn.domain[4+3*i]+
+		        vh1->scn.domain[2]*vh1->scn.domain[5+3*i];
+
+	    bbj[2*i] += d;
+	    bbj[2*i+1] += d;
+	  }
+	for (i=0; i<3; i++)
 	{
-		fprintf(stderr, "failure reading temorary file.\n");
-		exit(-1);
+	  if (first || bbj[2*i]<bbox[2*i])
+	    bbox[2*i] = bbj[2*i];
+	  if (first || bbj[2*i+1]>bbox[2*i+1])
+	    bbox[2*i+1] = bbj[2*i+1];
 	}
-	fclose(tfp);
-	unlink("SAMPLING-TEMP");
-	free(cmd);
-	if (j==0 || max_voxel_size[0]<voxsz[j][0])
-	  max_voxel_size[0] = voxsz[j][0];
-	if (j==0 || max_voxel_size[1]<voxsz[j][1])
-	  max_voxel_size[1] = voxsz[j][1];
-	if (j==0 || max_voxel_size[2]<voxsz[j][2])
-	  max_voxel_size[2] = voxsz[j][2];
+	first = FALSE;
+  }
+  if (first)
+  {
+    fprintf(stderr, "All inputs are empty.\n");
+    exit(-1);
   }
+  for (j=0; j<ns; j++)
+    for (i=0; i<3; i++)
+      if (max_voxel_size[i] < info[j].voxsz[i])
+        max_voxel_size[i] = info[j].voxsz[i];
   outvh.scn.xypixsz[0] = (float)max_voxel_size[0];
   outvh.scn.xypixsz[1] = (float)max_voxel_size[1];
   outvh.scn.xypixsz_valid = 1;
@@ -144,90 +202,100 @@ char *argv[];
   for (j=0; j<out_slices; j++)
     outvh.scn.loc_of_subscenes[j] = (float)(j*max_voxel_size[2]);
   outvh.scn.loc_of_subscenes_valid = 1;
-  size = outvh.scn.xysize[0]*outvh.scn.xysize[1];
-  out_data = (unsigned char *)malloc((size+7)/8*out_slices);
-  if (out_data == NULL)
-  {
-    fprintf(stderr, "Out of memory.\n");
-	exit(1);
-  }
-  memset(out_data, 0, (size+7)/8*out_slices*sizeof(*out_data));
-  memset(&vh1, 0, sizeof(vh1));
   outvh.scn.domain = (float *)calloc(12, sizeof(float));
   outvh.scn.domain[3] = 1;
   outvh.scn.domain[7] = 1;
   outvh.scn.domain[11] = 1;
+  if (info[0].vh.scn.domain_valid)
+  {
+	for (i=0; i<3; i++)
+	  outvh.scn.domain[i] = (float)(info[0].vh.scn.domain[3+i]*bbox[0]+
+	                                info[0].vh.scn.domain[6+i]*bbox[2]+
+	                                info[0].vh.scn.domain[9+i]*bbox[4]);
+	memcpy(outvh.scn.domain+3, info[0].vh.scn.domain+3, 9*sizeof(float));
+	outvh.scn.domain_valid = 1;
+  }
+  size = (long)outvh.scn.xysize[0]*outvh.scn.xysize[1];
+  out_size = size*out_slices;
+  count = (unsigned short *)calloc(out_size, sizeof(unsigned short));
+  if (count == NULL)
+  {
+    fprintf(stderr, "Out of memory.\n");
+	exit(1);
+  }
 
-  for (j=0; j<ns; j++)
+  /* Count the masks set at each output voxel.  Each thread sums the masks
+     it reads into its own counts, which are added at the end, so memory
+     depends on the output grid and the number of threads only. */
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
   {
-	unsigned char *bin_data;
+    Accumulator acc;
+	int k;
+	long w;
 
-    in1 = fopen(argv[j+1], "rb");
-    if (in1==NULL) {
-      fprintf(stderr, "Error in opening the files\n");
-      exit(-1);
-    }
-    error=VReadHeader(in1,&vh1,group,elem);
-    if (error && error<=105) {
-      fprintf(stderr, "Fatal error in reading header\n");
-      exit(-1);
-    }
-    if (vh1.gen.data_type!=IMAGE0) {
-      fprintf(stderr, "Input file should be IMAGE0\n");
-      exit(-1);
-    }
-	slices1 = vh1.scn.num_of_subscenes[0];
-    bin_data = (unsigned char *)
-	  malloc((vh1.scn.xysize[0]*vh1.scn.xysize[1]+7)/8*slices1);
-    VSeekData(in1,0);
-	if (VReadData((char *)bin_data, 1,
-	    (vh1.scn.xysize[0]*vh1.scn.xysize[1]+7)/8*slices1, in1, &error))
-	{
-	  fprintf(stderr, "Could not read data\n");
-	  exit(-1);
-	}
-	fclose(in1);
-	if (j==0 && vh1.scn.domain_valid)
+	acc.count = (unsigned short *)calloc(out_size, sizeof(unsigned short));
+	acc.stamp = (int *)calloc(out_size, sizeof(int));
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+	for (k=0; k<ns; k++)
+	  if (acc.count==NULL || acc.stamp==NULL ||
+	      (info[k].bounds[0]<=info[k].bounds[1] && accumulate_mask(argv[k+1],
+	      info+k, k, &outvh, max_voxel_size, &acc)))
+	  {
+#ifdef _OPENMP
+	    #pragma omp critical
+#endif
+	    if (bad_mask<0 || k<bad_mask)
+	      bad_mask = k;
+	  }
+	if (acc.count && acc.stamp)
 	{
-	  for (i=0; i<3; i++)
-	    outvh.scn.domain[i] = (float)(vh1.scn.domain[3+i]*bbox[0]+
-	                                  vh1.scn.domain[6+i]*bbox[2]+
-									  vh1.scn.domain[9+i]*bbox[4]);
-	  memcpy(outvh.scn.domain+3, vh1.scn.domain+3, 9*sizeof(float));
-	  outvh.scn.domain_valid = 1;
+#ifdef _OPENMP
+	  #pragma omp critical
+#endif
+	  for (w=0; w<out_size; w++)
+	    count[w] += acc.count[w];
 	}
-	for (slc=0; slc<vh1.scn.num_of_subscenes[0]; slc++)
+	if (acc.count)
+	  free(acc.count);
+	if (acc.stamp)
+	  free(acc.stamp);
+  }
+  if (bad_mask >= 0)
+  {
+    fprintf(stderr, "Could not merge %s\n", argv[bad_mask+1]);
+	exit(-1);
+  }
+  for (j=0; j<ns; j++)
+    destroy_scene_header(&info[j].vh);
+  free(info);
+
+  if (fuzzy)
+  {
+    unsigned short *fuzzy_data=count;
+
+    out_data = (unsigned char *)count;
+	for (v=0; v<out_size; v++)
+	  fuzzy_data[v] = (unsigned short)((count[v]*65534L+ns/2)/ns);
+	out_size *= 2;
+  }
+  else
+  {
+    out_size = (size+7)/8*out_slices;
+    out_data = (unsigned char *)calloc(out_size, 1);
+	if (out_data == NULL)
 	{
-	  for (row=0; row<vh1.scn.xysize[1]; row++)
-		for (col=0; col<vh1.scn.xysize[0]; col++)
-		  if (bin_data[(vh1.scn.xysize[0]*vh1.scn.xysize[1]+7)/8*slc+
-		      (row*vh1.scn.xysize[0]+col)/8] & (128>>
-			  (row*vh1.scn.xysize[0]+col)%8))
-		  {
-		    double x[3];
-			int outx[3];
-		    x[0] = col*voxsz[j][0];
-		    x[1] = row*voxsz[j][1];
-		    x[2] = vh1.scn.loc_of_subscenes[slc];
-		    if (vh1.scn.domain_valid)
-		     for (i=0; i<3; i++)
-			  x[i] +=
-			    vh1.scn.domain[3+3*i]*(vh1.scn.domain[0]-outvh.scn.domain[0])+
-				vh1.scn.domain[4+3*i]*(vh1.scn.domain[1]-outvh.scn.domain[1])+
-				vh1.scn.domain[5+3*i]*(vh1.scn.domain[2]-outvh.scn.domain[2]);
-		    x[2] -= outvh.scn.loc_of_subscenes[0];
-		    for (i=0; i<3; i++)
-			  outx[i] = (int)rint(x[i]/max_voxel_size[i]);
-		    assert(outx[0]>=0 && outx[0]<outvh.scn.xysize[0]);
-			assert(outx[1]>=0 && outx[1]<outvh.scn.xysize[1]);
-			assert(outx[2]>=0 && outx[2]<outvh.scn.num_of_subscenes[0]);
-			out_data[(size+7)/8*outx[2]+
-			  (outvh.scn.xysize[0]*outx[1]+outx[0])/8] |=
-			  (128>>(outvh.scn.xysize[0]*outx[1]+outx[0])%8);
-		  }
+	  fprintf(stderr, "Out of memory.\n");
+	  exit(1);
 	}
-	free(bin_data);
-	destroy_scene_header(&vh1);
+	for (j=0; j<out_slices; j++)
+	  for (v=0; v<size; v++)
+	    if (count[j*size+v])
+	      out_data[(size+7)/8*j+v/8] |= 128>>(v%8);
+	free(count);
   }
   outfp = fopen(argv[argc-1], "wb+");
   if (outfp == NULL)
@@ -242,7 +310,8 @@ char *argv[];
 	  error, group,elem);
 	exit(error);
   }
-  if (VWriteData((char *)out_data, 1, (size+7)/8*out_slices, outfp, &i))
+  if (VWriteData((char *)out_data, fuzzy? 2: 1, fuzzy? out_size/2: out_size,
+      outfp, &i))
   {
     fprintf(stderr, "Write error.\n");
 	exit(-1);
@@ -251,6 +320,210 @@ char *argv[];
   exit(0);
 }
 
+/*****************************************************************************
+ * FUNCTION: read_mask_info
+ * DESCRIPTION: Reads the header of a binary mask and finds its voxel size
+ *    and the bounding box of its set voxels.
+ * PARAMETERS:
+ *    filename: The mask file.
+ *    info: The header, voxel size and bounding box will go here.  The
+ *       bounding box is empty if no voxels are set.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if the file is not a binary IMAGE0 file or
+ *    cannot be read.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26 from bin_volume -b and get_slicenumber -s
+ *
+ *****************************************************************************/
+int read_mask_info(const char filename[], Mask_info *info)
+{
+  FILE *in1;
+  ViewnixHeader *vh1=&info->vh;
+  char group[6],elem[6];
+  int error, slc, row, col, slices1, nread;
+  long slice_bytes;
+  unsigned char *bin_data;
+
+  in1 = fopen(filename, "rb");
+  if (in1 == NULL)
+    return 1;
+  error = VReadHeader(in1, vh1, group, elem);
+  if ((error && error<=105) || vh1->gen.data_type!=IMAGE0 ||
+      vh1->scn.num_of_bits!=1)
+  {
+    fclose(in1);
+    return 1;
+  }
+  slices1 = vh1->scn.num_of_subscenes[0];
+  info->voxsz[0] = vh1->scn.xypixsz[0];
+  info->voxsz[1] = vh1->scn.xypixsz[1];
+  info->voxsz[2] = slices1<2? 0:
+    vh1->scn.loc_of_subscenes[1]-vh1->scn.loc_of_subscenes[0];
+  info->bounds[0] = vh1->scn.xysize[0];
+  info->bounds[2] = vh1->scn.xysize[1];
+  info->bounds[4] = slices1;
+  info->bounds[1] = info->bounds[3] = info->bounds[5] = -1;
+  slice_bytes = ((long)vh1->scn.xysize[0]*vh1->scn.xysize[1]+7)/8;
+  bin_data = (unsigned char *)malloc(slice_bytes);
+  if (bin_data==NULL || VSeekData(in1, 0))
+  {
+    if (bin_data)
+      free(bin_data);
+    fclose(in1);
+    return 1;
+  }
+  for (slc=0; slc<slices1; slc++)
+  {
+    long b;
+
+    if (VReadData((char *)bin_data, 1, slice_bytes, in1, &nread))
+    {
+      free(bin_data);
+      fclose(in1);
+      return 1;
+    }
+    for (b=0; b<slice_bytes; b++)
+      if (bin_data[b])
+      {
+        int bit;
+
+        for (bit=0; bit<8; bit++)
+          if (bin_data[b] & (128>>bit))
+          {
+            long n=b*8+bit;
+
+            row = (int)(n/vh1->scn.xysize[0]);
+            col = (int)(n%vh1->scn.xysize[0]);
+            if (col < info->bounds[0])
+              info->bounds[0] = col;
+            if (col > info->bounds[1])
+              info->bounds[1] = col;
+            if (row < info->bounds[2])
+              info->bounds[2] = row;
+            if (row > info->bounds[3])
+              info->bounds[3] = row;
+          }
+        if (slc < info->bounds[4])
+          info->bounds[4] = slc;
+        info->bounds[5] = slc;
+      }
+  }
+  free(bin_data);
+  fclose(in1);
+  return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: accumulate_mask
+ * DESCRIPTION: Adds a binary mask to the counts of a thread, resampling it
+ *    to the output grid.  Only the slices in the bounding box of the mask
+ *    are read, one at a time.
+ * PARAMETERS:
+ *    filename: The mask file.
+ *    info: From read_mask_info for the mask; the bounding box must not be
+ *       empty.
+ *    mask: The index of the mask, to mark the output voxels it sets.
+ *    outvh: The output scene header.
+ *    max_voxel_size: The output voxel size.
+ *    acc: The counts of the thread.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 on success, 1 if memory cannot be allocated or the file
+ *    cannot be read.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int accumulate_mask(const char filename[], const Mask_info *info, int mask,
+  const ViewnixHeader *outvh, const double max_voxel_size[3],
+  Accumulator *acc)
+{
+  FILE *in1;
+  const ViewnixHeader *vh1=&info->vh;
+  int i, slc, row, col, outz, nread, *outx, *outy;
+  long slice_bytes, size=(long)outvh->scn.xysize[0]*outvh->scn.xysize[1];
+  double offset[3];
+  unsigned char *bin_data;
+
+  /* The resampling is a translation and scaling on each axis, so the output
+     column depends on the input column only, and so on. */
+  for (i=0; i<3; i++)
+  {
+    offset[i] = 0;
+    if (vh1->scn.domain_valid)
+      offset[i] =
+        vh1->scn.domain[3+3*i]*(vh1->scn.domain[0]-outvh->scn.domain[0])+
+        vh1->scn.domain[4+3*i]*(vh1->scn.domain[1]-outvh->scn.domain[1])+
+        vh1->scn.domain[5+3*i]*(vh1->scn.domain[2]-outvh->scn.domain[2]);
+  }
+  offset[2] -= outvh->scn.loc_of_subscenes[0];
+  slice_bytes = ((long)vh1->scn.xysize[0]*vh1->scn.xysize[1]+7)/8;
+  bin_data = (unsigned char *)malloc(slice_bytes);
+  outx = (int *)malloc(vh1->scn.xysize[0]*sizeof(int));
+  outy = (int *)malloc(vh1->scn.xysize[1]*sizeof(int));
+  in1 = fopen(filename, "rb");
+  if (bin_data==NULL || outx==NULL || outy==NULL || in1==NULL ||
+      VSeekData(in1, info->bounds[4]*slice_bytes))
+  {
+    if (bin_data)
+      free(bin_data);
+    if (outx)
+      free(outx);
+    if (outy)
+      free(outy);
+    if (in1)
+      fclose(in1);
+    return 1;
+  }
+  for (col=info->bounds[0]; col<=info->bounds[1]; col++)
+  {
+    outx[col] = (int)rint((col*info->voxsz[0]+offset[0])/max_voxel_size[0]);
+    assert(outx[col]>=0 && outx[col]<outvh->scn.xysize[0]);
+  }
+  for (row=info->bounds[2]; row<=info->bounds[3]; row++)
+  {
+    outy[row] = (int)rint((row*info->voxsz[1]+offset[1])/max_voxel_size[1]);
+    assert(outy[row]>=0 && outy[row]<outvh->scn.xysize[1]);
+  }
+  for (slc=info->bounds[4]; slc<=info->bounds[5]; slc++)
+  {
+    if (VReadData((char *)bin_data, 1, slice_bytes, in1, &nread))
+    {
+      free(bin_data);
+      free(outx);
+      free(outy);
+      fclose(in1);
+      return 1;
+    }
+    outz = (int)rint((vh1->scn.loc_of_subscenes[slc]+offset[2])/
+      max_voxel_size[2]);
+    assert(outz>=0 && outz<outvh->scn.num_of_subscenes[0]);
+    for (row=info->bounds[2]; row<=info->bounds[3]; row++)
+    {
+      long n=(long)row*vh1->scn.xysize[0];
+
+      for (col=info->bounds[0]; col<=info->bounds[1]; col++)
+        if (bin_data[(n+col)/8] & (128>>(n+col)%8))
+        {
+          long v=outz*size+(long)outvh->scn.xysize[0]*outy[row]+outx[col];
+
+          if (acc->stamp[v] != mask+1)
+          {
+            acc->stamp[v] = mask+1;
+            acc->count[v]++;
+          }
+        }
+    }
+  }
+  free(bin_data);
+  free(outx);
+  free(outy);
+  fclose(in1);
+  return 0;
+}
 
 
 
@@ -32,6 +32,42 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 
 typedef struct { int x, y; } X_Point;
 
+/* Intensity statistics of a scene; see 3dviewnix/LIBRARY/scene_stats.c. */
+typedef struct {
+  int bits, is_signed;        /* 8, 16 or 32 bits per cell */
+  double count, sum, sum_sqr; /* valid after VFinishSceneStats */
+  double min, max;            /* valid if count > 0 */
+  int hist_min, hist_size;    /* hist[v-hist_min] counts cells of value v */
+  double *hist;               /* NULL for 32-bit data */
+  int nthreads;
+  void *thread_data;          /* per-thread accumulators */
+} VSceneStats;
+
+/* Flags of VResliceSlice; see 3dviewnix/LIBRARY/reslice.c. */
+#define VRESLICE_LINEAR   1  /* trilinear interpolation, else nearest */
+#define VRESLICE_ZERO_PAD 2  /* cells just outside the scene count as 0 */
+
+/* Largest table of VAffinityTable; see 3dviewnix/LIBRARY/affinity_table.c. */
+#define VAFFINITY_TABLE_MAX_LEVELS 4096
+
+/* Fuzzy connectedness of a slice kept up to date as seeds and affinities
+   change; see 3dviewnix/LIBRARY/fuzzy_forest.c. */
+typedef struct {
+  int width, height;
+  int labels;                 /* 1 absolute, 2 relative (1 = background) */
+  int max_connectivity;       /* connectivity of a seed */
+  int *key;                   /* 2*(connectivity+1)+label, 0 if unreached */
+  int *pred;                  /* previous cell on the path, -1 at a seed */
+  long updated;               /* cells propagated by the last run */
+  const unsigned short *affinity[2][4]; /* toward x+1, y+1, x-1, y-1 */
+  unsigned short *old_affinity[2][4];   /* as last given */
+  int affinity_set;
+  int *seed, seeds, seeds_allocated;
+  unsigned char *seed_label;
+  int *next, *prev, *first, top;        /* queue, by key */
+  unsigned char *state;
+} VFuzzyForest;
+
 #ifdef __cplusplus
 extern "C" {
 #else
@@ -56,6 +92,43 @@ extern "C" {
   int VLSeek         ( FILE* fp, double offset );
   int VGetHeaderLength ( FILE* fp, int* hdrlen );
   int VComputeLine   ( int x1, int y1, int x2, int y2, X_Point** points, int* npoints );
+  int VInitSceneStats ( VSceneStats* st, int bits, int is_signed );
+  void VAccumulateSceneStats ( VSceneStats* st, const void* data,
+                       const unsigned char* mask, long ncells );
+  void VFinishSceneStats ( VSceneStats* st );
+  void VFreeSceneStats ( VSceneStats* st );
+  int VGetSceneFileStats ( const char* filename, VSceneStats* st );
+  int VLookupSceneFileStats ( const char* filename, int bits, int is_signed,
+                       VSceneStats* st );
+  void VStoreSceneFileStats ( const char* filename, VSceneStats* st );
+  void VEnableSceneStatsCache ( void );
+  int VResliceSlice  ( const void* data, int bits, int width, int height,
+                       int slices, const double origin[3], const double u[3],
+                       const double v[3], int out_width, int out_height,
+                       int flags, void* out, int out_bits );
+  float* VAffinityTable ( int levels, float (*f)(int a, int b, void* client),
+                       void* client );
+  long VAffinityPlane ( const float* table, int levels, const void* data,
+                       int bits, int width, int height, int slices,
+                       int direction, float adjacency, float threshold,
+                       unsigned short undefined, unsigned short* out );
+  VFuzzyForest* VCreateFuzzyForest ( int width, int height, int labels,
+                       int max_connectivity );
+  void VDestroyFuzzyForest ( VFuzzyForest* forest );
+  void VClearFuzzyForest ( VFuzzyForest* forest );
+  int VSetFuzzyForestAffinity ( VFuzzyForest* forest,
+                       const unsigned short* affinity[2][4] );
+  int VSetFuzzyForestSeeds ( VFuzzyForest* forest, const int* cells,
+                       const unsigned char* labels, int nseeds );
+  long VRunFuzzyForest ( VFuzzyForest* forest );
+  int VFFT           ( double* data, int ndim, const int dims[], int isign );
+  int VFFTSize       ( int n );
+  int VFFTReal       ( const double* in, double* out, int ndim,
+                       const int dims[] );
+  int VFFTRealInverse ( const double* in, double* out, int ndim,
+                       const int dims[] );
+  int VFFTConvolve   ( const double* a, const double* b, double* out,
+                       int ndim, const int dims[], int correlate );
 #ifdef __cplusplus
 }
 #endif
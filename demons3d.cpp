@@ -4,7 +4,12 @@
 #include  "itkDemonsRegistrationFilter.h"
 #include  "itkHistogramMatchingImageFilter.h"
 #include  "itkImage.h"
+#include  "itkImageRegionConstIterator.h"
 #include  "itkImportImageFilter.h"
+#include  "itkLinearInterpolateImageFunction.h"
+#include  "itkMultiResolutionPyramidImageFilter.h"
+#include  "itkMultiThreaderBase.h"
+#include  "itkResampleImageFilter.h"
 #include  "itkWarpImageFilter.h"
 
 #include  <assert.h>
@@ -13,91 +18,221 @@
 #define  Dim    3  //dimension
 typedef  float  PixelType;
 typedef  itk::Image< PixelType, Dim >              ImageType;
-typedef  itk::ImportImageFilter< PixelType, Dim >  ImportFilterType;
+typedef  itk::Vector< float, Dim >                 VectorPixelType;
+typedef  itk::Image< VectorPixelType, Dim >        DeformationFieldType;
+
+static const int  WarpSlabSlices = 16;  ///< slices warped at a time
 //----------------------------------------------------------------------
-static ImportFilterType::Pointer  convertScene ( const int xSize,
-    const int ySize, const int zSize, const double pixelSizeX,
-    const double pixelSizeY, const double pixelSizeZ,
-    const int dataSize, const unsigned char* const ucData )
-{
-    assert(Dim==3);
-
-    //const ImportFilterType::SizeType  size = { xSize, ySize, zSize };
-    ImportFilterType::SizeType  size;
-    size[0]=xSize;  size[1]=ySize; size[2]=zSize;
-    const unsigned int                numberOfPixels = size[0]*size[1]*size[2];
-    ImportFilterType::Pointer         in = ImportFilterType::New();
-    ImportFilterType::IndexType       start;
+/** \brief a scene as passed to doDemons3DRegistration. */
+struct Scene {
+    int                   size[Dim];
+    double                spacing[Dim];
+    int                   dataSize;
+    const unsigned char*  data;
+};
+
+/** \brief the demons parameters passed to doDemons3DRegistration. */
+struct Parameters {
+    int     iterations, matchPoints, histogramLevels;
+    double  standardDeviation;
+    bool    thresholdAtMean;
+    int     levels;
+};
+//----------------------------------------------------------------------
+/** \brief wrap the data of a scene (of cells of type T) in an image
+ *  without copying it.  the image does not own the data.
+ */
+template < class T >
+static typename itk::Image< T, Dim >::Pointer  wrapScene ( const Scene& s ) {
+    typedef  itk::ImportImageFilter< T, Dim >  ImportFilterType;
+    typename ImportFilterType::SizeType  size;
+    size[0]=s.size[0];  size[1]=s.size[1];  size[2]=s.size[2];
+    const size_t  numberOfPixels = (size_t)size[0]*size[1]*size[2];
+    typename ImportFilterType::IndexType  start;
     start.Fill( 0 );
-    ImportFilterType::RegionType      region;
+    typename ImportFilterType::RegionType  region;
     region.SetIndex( start );
     region.SetSize(  size  );
+    typename ImportFilterType::Pointer  in = ImportFilterType::New();
     in->SetRegion( region );
-        const double  origin[Dim]  = {0.0, 0.0, 0.0};  //x,y,z coordinates
+    const double  origin[Dim] = {0.0, 0.0, 0.0};  //x,y,z coordinates
     in->SetOrigin( origin );
-    const double  spacing[Dim] = { pixelSizeX, pixelSizeY, pixelSizeZ };
-    //along x,y,z directions
-    in->SetSpacing( spacing );
-    PixelType*  localBuffer = new PixelType[ numberOfPixels ];
-    if        (dataSize == 1) {
-        for (int i=0; i<(int)numberOfPixels; i++)
-            localBuffer[i] = ucData[i];
-    } else if (dataSize == 2) {
-        unsigned short*  us = (unsigned short*)ucData;
-        for (int i=0; i<(int)numberOfPixels; i++)
-            localBuffer[i] = us[i];
-    } else if (dataSize == 4) {
-        int*  si = (int*)ucData;
-        for (int i=0; i<(int)numberOfPixels; i++)
-            localBuffer[i] = si[i];
-    } else {
-        assert(0);
+    in->SetSpacing( s.spacing );
+    const bool  importImageFilterWillOwnTheBuffer = false;
+    in->SetImportPointer( (T*)s.data, numberOfPixels,
+                          importImageFilterWillOwnTheBuffer );
+    in->Update();
+    typename itk::Image< T, Dim >::Pointer  image = in->GetOutput();
+    image->DisconnectPipeline();
+    return image;
+}
+//----------------------------------------------------------------------
+/** \brief the shrink factors of a pyramid with the given number of
+ *  levels.  each level halves the resolution of the next, but a
+ *  direction whose cells are already coarser (the slice spacing of a
+ *  ct, typically) is not shrunk until the others catch up with it.
+ */
+static itk::Array2D< unsigned int >  schedule ( const int levels,
+    const double spacing[Dim] )
+{
+    double  finest = spacing[0];
+    for (int d=1; d<Dim; d++)    if (spacing[d]<finest)  finest = spacing[d];
+    itk::Array2D< unsigned int >  s( levels, Dim );
+    for (int level=0; level<levels; level++) {
+        const double  factor = (double)(1 << (levels-1-level));
+        for (int d=0; d<Dim; d++) {
+            const int  f = (int)(factor * finest / spacing[d] + 0.5);
+            s[level][d] = (f<1) ? 1 : f;
+        }
     }
+    return s;
+}
+//----------------------------------------------------------------------
+/** \brief warp moving by field onto the grid of the field, a slab of
+ *  slices at a time, into a new buffer of ints (so that neither the
+ *  float result of the whole scene nor a copy of it is ever needed).
+ */
+template < class MovingImageType >
+static int*  warpScene ( const MovingImageType* const moving,
+    const DeformationFieldType* const field )
+{
+    typedef  itk::WarpImageFilter< MovingImageType, ImageType,
+                                   DeformationFieldType >  WarperType;
+    typedef  itk::LinearInterpolateImageFunction< MovingImageType, double >
+        InterpolatorType;
+    typename WarperType::Pointer  warper = WarperType::New();
+    warper->SetInput( moving );
+    warper->SetInterpolator( InterpolatorType::New() );
+    warper->SetOutputParametersFromImage( field );
+    warper->SetDisplacementField( field );
+    warper->UpdateOutputInformation();
 
-    PixelType  myMin = localBuffer[0];
-    PixelType  myMax = localBuffer[0];
-    for (int i=1; i<(int)numberOfPixels; i++) {
-        if (localBuffer[i]<myMin)  myMin=localBuffer[i];
-        if (localBuffer[i]>myMax)  myMax=localBuffer[i];
-    }
-    std::cout << "my min=" << myMin << std::endl
-              << "my max=" << myMax << std::endl;
+    ImageType*  out = warper->GetOutput();
+    const ImageType::RegionType  all = out->GetLargestPossibleRegion();
+    const int  xSize = all.GetSize(0);
+    const int  ySize = all.GetSize(1);
+    const int  zSize = all.GetSize(2);
+    std::cout << "warpScene: xSize=" << xSize << ", ySize=" << ySize
+              << ", zSize=" << zSize << std::endl;
+    int*  buffer = (int*)malloc( sizeof(int) * xSize * ySize * zSize );
+    assert( buffer!=NULL );
 
-    // Note that the last argument of this method
-    // specifies who will be responsible for deleting the memory block once it
-    // is no longer in use.
-    const bool  userPromiseToDeleteTheBuffer = false;
-    in->SetImportPointer( localBuffer, numberOfPixels,
-                          userPromiseToDeleteTheBuffer );
+    int*  b = buffer;
+    for (int z=0; z<zSize; z+=WarpSlabSlices) {
+        ImageType::RegionType  slab = all;
+        slab.SetIndex( 2, all.GetIndex(2) + z );
+        slab.SetSize(  2, (zSize-z < WarpSlabSlices) ? zSize-z : WarpSlabSlices );
+        out->SetRequestedRegion( slab );
+        out->PropagateRequestedRegion();
+        out->UpdateOutputData();
+        typedef  itk::ImageRegionConstIterator< ImageType >  ImageIterator;
+        for (ImageIterator ii( out, slab ); !ii.IsAtEnd(); ++ii)
+            *b++ = (int)ii.Get();
+    }
 
-    return in;
+    return buffer;
 }
 //----------------------------------------------------------------------
-static int*  retrieveScene ( const ImageType* const image ) {
-    assert(Dim==3);
+/** \brief multiresolution demons registration of moving (cells of type
+ *  M) to fixed (cells of type F).  both scenes are used in place; the
+ *  pyramids make the float images that the demons need.  at each level,
+ *  the moving image is histogram matched to the fixed one, and the
+ *  demons start from the field of the coarser level.  coarser levels
+ *  are cheap, so each one gets twice the iterations of the next.
+ */
+template < class F, class M >
+static int*  demons ( const Scene& s1, const Scene& s2, const Parameters& p ) {
+    typedef  itk::Image< F, Dim >  FixedImageType;
+    typedef  itk::Image< M, Dim >  MovingImageType;
+    typename FixedImageType::Pointer   fixed  = wrapScene<F>( s1 );
+    typename MovingImageType::Pointer  moving = wrapScene<M>( s2 );
 
-    const int  xSize = image->GetLargestPossibleRegion().GetSize(0);
-    const int  ySize = image->GetLargestPossibleRegion().GetSize(1);
-    const int  zSize = image->GetLargestPossibleRegion().GetSize(2);
+    std::cout << std::endl << "starting 3d demons registration ("
+              << p.levels << " levels, "
+              << itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads()
+              << " threads)" << std::endl;
 
-    std::cout << "retrieveScene: xSize=" << xSize << ", ySize=" << ySize
-              << ", zSize=" << zSize << std::endl;
-    int*  buffer = (int*)malloc(sizeof(int) * xSize * ySize * zSize);
-    assert(buffer!=NULL);
-    typedef  itk::ImageRegionConstIterator< ImageType >  ImageIterator;
-    ImageIterator  ii( image, image->GetLargestPossibleRegion() );
-    ii.GoToBegin();
-    int  i=0;
-    while (!ii.IsAtEnd()) {
-        PixelType v = ii.Get();
-        buffer[i++] = (int)v;
-        ++ii;
+    typedef  itk::MultiResolutionPyramidImageFilter< FixedImageType, ImageType >
+        FixedPyramidType;
+    typedef  itk::MultiResolutionPyramidImageFilter< MovingImageType, ImageType >
+        MovingPyramidType;
+    typename FixedPyramidType::Pointer   fixedPyramid  = FixedPyramidType::New();
+    typename MovingPyramidType::Pointer  movingPyramid = MovingPyramidType::New();
+    fixedPyramid->SetNumberOfLevels( p.levels );
+    fixedPyramid->SetSchedule( schedule( p.levels, s1.spacing ) );
+    fixedPyramid->SetInput( fixed );
+    movingPyramid->SetNumberOfLevels( p.levels );
+    movingPyramid->SetSchedule( schedule( p.levels, s2.spacing ) );
+    movingPyramid->SetInput( moving );
+
+    typedef  itk::HistogramMatchingImageFilter< ImageType, ImageType >
+             MatchingFilterType;
+    typedef  itk::DemonsRegistrationFilter< ImageType, ImageType,
+                                            DeformationFieldType >
+             RegistrationFilterType;
+    typedef  itk::ResampleImageFilter< DeformationFieldType,
+                                       DeformationFieldType >
+             FieldExpanderType;
+
+    DeformationFieldType::Pointer  field;
+    for (int level=0; level<p.levels; level++) {
+        ImageType*  fixedLevel  = fixedPyramid->GetOutput( level );
+        ImageType*  movingLevel = movingPyramid->GetOutput( level );
+
+        MatchingFilterType::Pointer  matcher = MatchingFilterType::New();
+        matcher->SetInput( movingLevel );
+        matcher->SetReferenceImage( fixedLevel );
+        matcher->SetNumberOfHistogramLevels( p.histogramLevels );
+        matcher->SetNumberOfMatchPoints( p.matchPoints );
+        if (p.thresholdAtMean)    matcher->ThresholdAtMeanIntensityOn();
+        else                      matcher->ThresholdAtMeanIntensityOff();
+
+        RegistrationFilterType::Pointer  filter = RegistrationFilterType::New();
+        filter->SetFixedImage( fixedLevel );
+        filter->SetMovingImage( matcher->GetOutput() );
+        filter->SetNumberOfIterations( p.iterations << (p.levels-1-level) );
+        filter->SetStandardDeviations( p.standardDeviation );
+
+        //start from the field of the coarser level (resampled to this one)
+        FieldExpanderType::Pointer  expander;
+        if (field) {
+            fixedLevel->UpdateOutputInformation();
+            expander = FieldExpanderType::New();
+            expander->SetInput( field );
+            expander->SetReferenceImage( fixedLevel );
+            expander->UseReferenceImageOn();
+            VectorPixelType  zero;
+            zero.Fill( 0 );
+            expander->SetDefaultPixelValue( zero );
+            filter->SetInitialDisplacementField( expander->GetOutput() );
+        }
+
+        std::cout << "level " << level << ": "
+                  << filter->GetNumberOfIterations() << " iterations"
+                  << std::endl;
+        filter->Update();
+        field = filter->GetOutput();
+        field->DisconnectPipeline();
     }
+    //the pyramids' images are no longer needed
+    fixedPyramid  = NULL;
+    movingPyramid = NULL;
 
-    return buffer;
+    return warpScene< MovingImageType >( moving, field );
 }
 //----------------------------------------------------------------------
-int*  doDemons3DRegistration ( 
+template < class F >
+static int*  demons ( const Scene& s1, const Scene& s2, const Parameters& p ) {
+    switch (s2.dataSize) {
+        case 1 :  return demons< F, unsigned char  >( s1, s2, p );
+        case 2 :  return demons< F, unsigned short >( s1, s2, p );
+        case 4 :  return demons< F, int            >( s1, s2, p );
+    }
+    assert(0);
+    return NULL;
+}
+//----------------------------------------------------------------------
+int*  doDemons3DRegistration (
     const int xSize1, const int ySize1, const int zSize1,
     const double pixelSizeX1, const double pixelSizeY1,
     const double pixelSizeZ1, const int dataSize1,
@@ -109,59 +244,25 @@ int*  doDemons3DRegistration (
     const unsigned char* const ucData2,
 
     const int iterations, const int matchPoints, const int histogramLevels,
-    const double standardDeviation, const bool thresholdAtMean )
+    const double standardDeviation, const bool thresholdAtMean,
+    const int levels, const int threads )
 {
-    ImportFilterType::Pointer  fixed  = convertScene( xSize1, ySize1, zSize1,
-        pixelSizeX1, pixelSizeY1, pixelSizeZ1, dataSize1, ucData1 );
+    const Scene  s1 = { { xSize1, ySize1, zSize1 },
+        { pixelSizeX1, pixelSizeY1, pixelSizeZ1 }, dataSize1, ucData1 };
+    const Scene  s2 = { { xSize2, ySize2, zSize2 },
+        { pixelSizeX2, pixelSizeY2, pixelSizeZ2 }, dataSize2, ucData2 };
+    const Parameters  p = { iterations, matchPoints, histogramLevels,
+        standardDeviation, thresholdAtMean, (levels<1) ? 1 : levels };
 
-    ImportFilterType::Pointer  moving = convertScene( xSize2, ySize2, zSize2,
-        pixelSizeX2, pixelSizeY2, pixelSizeZ2, dataSize2, ucData2 );
+    if (threads > 0)
+        itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads( threads );
 
-    fixed->Update();
-    const double*  fixedSpacing = fixed->GetOutput()->GetSpacing();
-    const double*  fixedOrigin  = fixed->GetOutput()->GetOrigin();
-    moving->Update();
-
-    std::cout << std::endl << "starting 3d demons registration" << std::endl;
-    typedef  itk::HistogramMatchingImageFilter< ImageType, ImageType >
-             MatchingFilterType;
-    MatchingFilterType::Pointer  matcher = MatchingFilterType::New();
-    matcher->SetInput( moving->GetOutput() );
-    matcher->SetReferenceImage( fixed->GetOutput() );
-    matcher->SetNumberOfHistogramLevels( histogramLevels );
-    matcher->SetNumberOfMatchPoints( matchPoints );
-    if (thresholdAtMean)    matcher->ThresholdAtMeanIntensityOn();
-    else                    matcher->ThresholdAtMeanIntensityOff();
-
-    typedef  itk::Vector< float, Dim >  VectorPixelType;
-    typedef  itk::Image<  VectorPixelType, Dim >  DeformationFieldType;
-    typedef  itk::DemonsRegistrationFilter< ImageType, ImageType,
-                                            DeformationFieldType >
-             RegistrationFilterType;
-    RegistrationFilterType::Pointer  filter = RegistrationFilterType::New();
-    filter->SetFixedImage( fixed->GetOutput() );
-    filter->SetMovingImage( matcher->GetOutput() );
-    filter->SetNumberOfIterations( iterations );
-    filter->SetStandardDeviations( standardDeviation );
-    filter->Update();
-
-    typedef  itk::WarpImageFilter< ImageType, ImageType, DeformationFieldType >
-        WarperType;
-    typedef  itk::LinearInterpolateImageFunction< ImageType, double >
-        InterpolatorType;
-    std::cout << "linear interpolator" << std::endl;
-
-    WarperType::Pointer  warper = WarperType::New();
-    InterpolatorType::Pointer  interpolator = InterpolatorType::New();
-
-    warper->SetInput( moving->GetOutput() );
-    warper->SetInterpolator( interpolator );
-    warper->SetOutputSpacing( fixedSpacing );
-    warper->SetOutputOrigin( fixedOrigin );
-    warper->SetDeformationField( filter->GetOutput() );
-    warper->Update();
-
-    return retrieveScene( warper->GetOutput() );
+    switch (s1.dataSize) {
+        case 1 :  return demons< unsigned char  >( s1, s2, p );
+        case 2 :  return demons< unsigned short >( s1, s2, p );
+        case 4 :  return demons< int            >( s1, s2, p );
+    }
+    assert(0);
+    return NULL;
 }
 //======================================================================
-
@@ -17,7 +17,9 @@ int*  doDemons3DRegistration (
 
     const int iterations=10, const int matchPoints=10,
     const int histogramLevels=200, const double standardDeviation=1.0,
-    const bool thresholdAtMean=true );
+    const bool thresholdAtMean=true,
+    const int levels=1,    //# of resolution levels (1 = full resolution only)
+    const int threads=0 ); //# of threads (0 = itk's default, all processors)
 
 #endif
 //======================================================================
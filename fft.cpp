@@ -34,9 +34,11 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include  <assert.h>
 #include  <math.h>
 #include  <stdlib.h>
+#include  <stdio.h>
+#include  <Viewnix.h>
+#include  "cv3dv.h"
 #include  "fft.h"
 
-#define  SWAP(a,b)  tempr=(a);  (a)=(b);  (b)=tempr
 //----------------------------------------------------------------------
 bool isPowerOf2 ( const unsigned long value ) {
     static const unsigned long p2[] = {
@@ -126,57 +128,11 @@ void fit ( vector< double >* xv, vector< double >* yv, const int ndata,
  * if isign is input as 1; or replaces data[1..2*nn] by nn times its 
  * inverse discrete Fourier transform, if isign is input as -1. data is
  * a complex array of length nn or, equivalently, a real array of length
- * 2*nn.  nn MUST be an integer power of 2 (this is checked!).
+ * 2*nn.  nn may be any length; the transform is done by VFFT in the
+ * 3dviewnix library, which also handles 2-D and 3-D and real data.
  */
 void dfour1 ( double data[], unsigned long nn, int isign ) {
-    --data;  //because NRC arrays are subscripted [1..N] (as in fortran)
-             // instead of C++ standard [0..N-1]
-    if (!isPowerOf2(nn))  return;
-
-    unsigned long  n, mmax, m, j, istep, i;
-    double  wtemp, wr, wpr, wpi, wi, theta;   //trigonometric recurrences
-    double  tempr, tempi;
-
-    n = nn << 1;
-    j = 1;
-    for (i=1; i<n; i+=2) { //this is the bit-reversal section of the routine.
-        if (j > i) {
-            SWAP(data[j],   data[i]);  //exchange the two complex numbers.
-            SWAP(data[j+1], data[i+1]);
-        }
-        m=n >> 1;
-        while (m>=2 && j>m) {
-            j -= m;
-            m >>= 1;
-        }
-        j += m;
-    }
-
-    //begin the Danielson-Lanczos section of the routine.
-    mmax = 2;
-    while (n > mmax) {  //outer loop executed log2 nn times.
-        istep = mmax << 1;
-        theta = isign*(6.28318530717959/mmax);  //initialize the trigonometric
-                                                // recurrence.
-        wtemp = sin(0.5*theta);
-        wpr = -2.0*wtemp*wtemp;
-        wpi = sin(theta);
-        wr = 1.0;
-        wi = 0.0;
-        for (m=1; m<mmax; m+=2) {  //here are the two nested inner loops.
-            for (i=m; i<=n; i+=istep) {
-                j = i+mmax;  //this is the Danielson-Lanczos formula:
-                tempr = wr*data[j]-wi*data[j+1];
-                tempi = wr*data[j+1]+wi*data[j];
-                data[j] = data[i]-tempr;
-                data[j+1] = data[i+1]-tempi;
-                data[i] += tempr;
-                data[i+1] += tempi;
-            }
-            wr = (wtemp=wr)*wpr-wi*wpi+wr;  //trigonometric recurrence.
-            wi = wi*wpr+wtemp*wpi+wi;
-        }
-        mmax = istep;
-    }
+    const int  n = (int)nn;
+    VFFT( data, 1, &n, isign );
 }
 //----------------------------------------------------------------------
@@ -47,7 +47,7 @@ void fit ( double* x, double* y, const int ndata, double& a, double& b,
 void fit ( vector< double >* xv, vector< double >* yv, const int ndata,
            double& a, double& b,
            double& siga, double& sigb, double& chi2, double& q );
-//from NRC:
+//from NRC, now computed by VFFT for any nn:
 void dfour1 ( double data[], unsigned long nn, int isign=1 );
 
 #endif
@@ -472,7 +472,6 @@ void FilterCanvas::RunFilter()
 
 	// step 2:
 	wxString  cmd;
-	int iterations=1;
     switch (m_filterType) 
 	{
       case FILTER_GAUSSIAN2D:
@@ -534,12 +533,10 @@ void FilterCanvas::RunFilter()
 		  cmd = wxString::Format("median3d %s %s %d", "voi_tmp.IM0", "voi_tmp2.IM0", 0);
 		  break;
 	  case FILTER_DILATE:
-		  cmd = wxString::Format("morph %s %s %d %d", "voi_tmp.IM0", "voi_tmp2.IM0", getMorphN(), 0);
-		  iterations = m_MorphIterations;
+		  cmd = wxString::Format("morph %s %s %d %d %d", "voi_tmp.IM0", "voi_tmp2.IM0", getMorphN(), 0, m_MorphIterations);
 		  break;
 	  case FILTER_ERODE:
-		  cmd = wxString::Format("morph %s %s %d %d", "voi_tmp.IM0", "voi_tmp2.IM0", -getMorphN(), 0);
-		  iterations = m_MorphIterations;
+		  cmd = wxString::Format("morph %s %s %d %d %d", "voi_tmp.IM0", "voi_tmp2.IM0", -getMorphN(), 0, m_MorphIterations);
 		  break;
 	  case FILTER_BALL_ENH:
 	      cmd = wxString::Format("ball_enhance %s %s %d %d", "voi_tmp.IM0", "voi_tmp2.IM0", m_MaxRadius, m_MinRadius);
@@ -560,16 +557,6 @@ void FilterCanvas::RunFilter()
     ProcessManager  p( "filter running...", cmd, true, false, false );
     if (p.getCancel())    return;
     error = p.getStatus();
-	while (iterations > 1)
-	{
-		unlink("voi_tmp.IM0");
-		rename("voi_tmp2.IM0", "voi_tmp.IM0");
-		p = ProcessManager( "filter running...", cmd, true, false, false );
-		if (p.getCancel())    return;
-		if (!error)
-		    error = p.getStatus();
-		iterations--;
-	}
 #if 0
     if (error != 0) {  wxMessageBox( "Filter Failed." );  return;  }
 #endif
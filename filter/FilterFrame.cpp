@@ -895,14 +895,14 @@ void FilterFrame::OnFilterSave ( wxCommandEvent &e )
 		  break;
 	  case FILTER_DILATE:
 	      iterations = canvas->getMorphIterations();
-	      cmd += wxString::Format("mmorph\" \"%s\" \"%s\" %d %d",
+	      cmd += wxString::Format("morph\" \"%s\" \"%s\" %d 0 %d",
 		       (mCanvas->mCavassData)->m_fname,
 			   (const char *)saveDlg.GetPath().c_str(),
 		       canvas->getMorphN(), iterations);
 		  break;
 	  case FILTER_ERODE:
 	      iterations = canvas->getMorphIterations();
-	      cmd += wxString::Format("morph\" \"%s\" \"%s\" %d %d",
+	      cmd += wxString::Format("morph\" \"%s\" \"%s\" %d 0 %d",
 		       (mCanvas->mCavassData)->m_fname,
 			   (const char *)saveDlg.GetPath().c_str(),
 		       -canvas->getMorphN(), iterations);
@@ -244,6 +244,7 @@ ITKFilterFrame::ITKFilterFrame ( bool maximize, int w, int h )
     mFilteredGrayMapControls  = NULL;
     mFilteredSetIndexControls = NULL;
     mGrayMapControls          = NULL;
+    mFirstStage               = -1;
     mInputIsBinary            = false;
     mITKFilterControls        = NULL;
     mModuleName               = "CAVASS:Tools:ITK Filters";
@@ -407,6 +408,13 @@ void ITKFilterFrame::addButtonBox ( void ) {
         cb->SetToolTip( _T("synchronize changes to gray map and index") );
     #endif
     cb->SetValue( mSyncChecked );
+    //row 6, col 2
+    wxButton*  addStage = new wxButton( mControlPanel, ID_ADD_STAGE, "AddStage", wxDefaultPosition, wxSize(width,buttonHeight) );
+    ::setColor( addStage );
+    fgs->Add( addStage, 0, wxALIGN_CENTER_HORIZONTAL|wxALIGN_CENTER_VERTICAL, 0 );
+    #if defined(wxUSE_TOOLTIPS) && !defined(__WXX11__)
+        addStage->SetToolTip( _T("add the selected filter (with its parameters) to the chain run by Filter and Save") );
+    #endif
 
     buttonSizer->Add( fgs, 0, wxGROW|wxALL, 10 );
     mBottomSizer->Add( buttonSizer, 0, wxGROW|wxALL, 10 );
@@ -857,6 +865,60 @@ void ITKFilterFrame::OnMouseWheel ( wxMouseEvent& e ) {
     else if (rot<0)    OnNext(ce);
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief check that the input is binary if the first filter in the
+ *  chain requires it.
+ *  \returns true if the input is suitable; false otherwise.
+ */
+bool ITKFilterFrame::checkInput ( void ) {
+    const int  first = (mFirstStage>=0) ? mFirstStage : mWhichFilter;
+    if (!mInputIsBinary && ::ITKFilterTable[first].inputFileType == ::ITKFilterTable[first].BinaryOnly) {
+        wxMessageBox( "ITK filter requires binary input but the input is not binary." );
+        return false;
+    }
+    return true;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief the selected filter and its parameters (user input, or the
+ *  defaults) as a stage of itkFilterPipeline.
+ */
+wxString ITKFilterFrame::currentStage ( void ) {
+    wxString  stage = ::ITKFilterTable[mWhichFilter].progName;
+    for (int i=0; i<MaxITKParameters; i++) {
+        if (::ITKFilterTable[mWhichFilter].parameters[i].paramName==0)    break;
+        if (mP[i] != "")  //use user input
+            stage += " " + mP[i];
+        else  //use default
+            stage += wxString::Format( " %s",
+                ::ITKFilterTable[mWhichFilter].parameters[i].idDefault );
+    }
+    return stage;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief the command that runs the chain (the stages that were added,
+ *  then the selected filter) in one itkFilterPipeline process.
+ *  \param in is the (quoted, if necessary) input file name.
+ *  \param out is the (quoted, if necessary) output file name.
+ */
+wxString ITKFilterFrame::pipelineCommand ( const wxString& in,
+                                           const wxString& out )
+{
+    wxString  itkCmd("\"");
+    itkCmd += Preferences::getHome() + "/itkFilterPipeline\" " + in + " " + out
+        + " " + mStages + currentStage();
+    return itkCmd;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief this method is called when the user presses the AddStage
+ *  button (to add the selected filter and its parameters to the chain
+ *  that Filter and Save run).
+ */
+void ITKFilterFrame::OnAddStage ( wxCommandEvent& unused ) {
+    assert( mWhichFilter>=0 && ::ITKFilterTable[mWhichFilter].name!=0 );
+    if (mFirstStage<0)    mFirstStage = mWhichFilter;
+    mStages += currentStage() + " : ";
+    SetStatusText( "chain: " + mStages, 0 );
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 /** \brief this method is called when the user presses the Filter button
  *  (to run the itk filter program on one sample slice and to display
  *  the result).
@@ -868,10 +930,7 @@ void ITKFilterFrame::OnFilter (  wxCommandEvent& unused  ) {
     unlink( "voi_tmp2.IM0" );
 
     //check for a binary-input-only filter
-    if (!mInputIsBinary && ::ITKFilterTable[mWhichFilter].inputFileType == ::ITKFilterTable[mWhichFilter].BinaryOnly) {
-        wxMessageBox( "ITK filter requires binary input but the input is not binary." );
-        return;
-    }
+    if (!checkInput())    return;
 
     //step 1:
     //  run the nvdoi program to obtain a file that contains only the
@@ -892,20 +951,9 @@ void ITKFilterFrame::OnFilter (  wxCommandEvent& unused  ) {
     if (error != 0) {  wxMessageBox( "ndvoi failed." );  return;  }
 #endif
     //step 2:
-    //  run the selected itk filter program on this slice.
-    wxString  itkCmd("\"");
-	itkCmd += Preferences::getHome()+wxString::Format( "/%s\" %s %s",
-        ::ITKFilterTable[mWhichFilter].progName, "voi_tmp.IM0", "voi_tmp2.IM0"
-    );
-    //use user-input parameters.  otherwise, use default parameters.
-    for (int i=0; i<MaxITKParameters; i++) {
-        if (::ITKFilterTable[mWhichFilter].parameters[i].paramName==0)    break;
-        if (mP[i] != "")  //use user input
-            itkCmd += " " + mP[i];
-        else  //use default
-            itkCmd += wxString::Format( " %s",
-                ::ITKFilterTable[mWhichFilter].parameters[i].idDefault );
-    }
+    //  run the chain of itk filters (ending with the selected one) on
+    //  this slice.
+    wxString  itkCmd = pipelineCommand( "voi_tmp.IM0", "voi_tmp2.IM0" );
     wxLogMessage( "command=%s", (const char *)itkCmd.c_str() );	
 
 #if defined (WIN32) || defined (_WIN32)
@@ -975,6 +1023,10 @@ void ITKFilterFrame::OnReset ( wxCommandEvent& unused ) {
 
     mWhichFilter = 0;
     mFilterName->SetSelection( mWhichFilter );
+    //empty the chain
+    mStages = "";
+    mFirstStage = -1;
+    SetStatusText( "", 0 );
     //reset user-input filter parameters
     for (int i=0; i<MaxITKParameters; i++) {
         mP[i] = "";
@@ -991,10 +1043,7 @@ void ITKFilterFrame::OnSave (  wxCommandEvent& unused  ) {
     unlink( "voi_tmp2.IM0" );
 
     //check for a binary-input-only filter
-    if (!mInputIsBinary && ::ITKFilterTable[mWhichFilter].inputFileType == ::ITKFilterTable[mWhichFilter].BinaryOnly) {
-        wxMessageBox( "ITK filter requires binary input but the input is not binary." );
-        return;
-    }
+    if (!checkInput())    return;
 
     //pop up a dialog to allow the user to specify the output file for the result.
     wxFileDialog  f( this, "Select filter output image file", "", "voi_tmp.IM0",
@@ -1003,21 +1052,13 @@ void ITKFilterFrame::OnSave (  wxCommandEvent& unused  ) {
     if (ret == wxID_CANCEL)    return;
 
     //step 1:
-    //  run the selected itk filter program on this slice.
+    //  run the chain of itk filters (ending with the selected one) on
+    //  the entire input.
     ITKFilterCanvas*  canvas = dynamic_cast<ITKFilterCanvas*>(mCanvas);
     canvas->freeFilteredData();
-    wxString  itkCmd("\"");
-	itkCmd += Preferences::getHome()+wxString::Format( "/%s\" \"%s\" \"%s\"",
-        ::ITKFilterTable[mWhichFilter].progName, canvas->mCavassData->m_fname,
-        (const char *)f.GetPath().c_str() );
-    //use user-input parameters.  otherwise, use default parameters.
-    for (int i=0; i<MaxITKParameters; i++) {
-        if (::ITKFilterTable[mWhichFilter].parameters[i].paramName==0)    break;
-        //get the parameter value (using default if necessary)
-        wxString  p = ::ITKFilterTable[mWhichFilter].parameters[i].idDefault;
-        if (mP[i] != "")    p = mP[i];  //use user input instead
-        itkCmd += " " + p;
-    }
+    wxString  itkCmd = pipelineCommand(
+        wxString::Format( "\"%s\"", canvas->mCavassData->m_fname ),
+        "\"" + f.GetPath() + "\"" );
     wxLogMessage( "command=%s", (const char *)itkCmd.c_str() );
 
 	//time_t ltime;
@@ -1267,6 +1308,7 @@ BEGIN_EVENT_TABLE       ( ITKFilterFrame, wxFrame )
   EVT_BUTTON( ID_FILTER,             ITKFilterFrame::OnFilter           )
   EVT_BUTTON( ID_RESET,              ITKFilterFrame::OnReset            )
   EVT_BUTTON( ID_SAVE,               ITKFilterFrame::OnSave             )
+  EVT_BUTTON( ID_ADD_STAGE,          ITKFilterFrame::OnAddStage         )
   EVT_BUTTON( ID_SET_INDEX,          ITKFilterFrame::OnSetIndex         )
   EVT_BUTTON( ID_FILTERED_SET_INDEX, ITKFilterFrame::OnFilteredSetIndex )
 
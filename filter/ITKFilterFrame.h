@@ -70,6 +70,8 @@ class ITKFilterFrame : public MainFrame {
     wxComboBox*         mFilterName;                ///< button displays current filter name
 	wxString            mP[ MaxITKParameters ];     ///< parameter strings
 	bool                mInputIsBinary;             ///< true when input is binary
+	wxString            mStages;                    ///< stages added to the chain (run before the selected filter)
+	int                 mFirstStage;                ///< filter of the first stage in the chain (-1 if none)
 	bool                mSyncChecked;               ///< true when sync is checked (to sync scale and other changes)
   public:
     /** \brief additional ids for buttons, sliders, etc. */
@@ -80,7 +82,7 @@ class ITKFilterFrame : public MainFrame {
         ID_GRAYMAP, ID_CENTER_SLIDER, ID_WIDTH_SLIDER, ID_INVERT,
         ID_CT_LUNG,        ID_CT_SOFT_TISSUE, ID_CT_BONE, ID_PET,
         ID_FILTER, ID_FILTER_NAME,
-        ID_SAVE, ID_RESET,
+        ID_SAVE, ID_RESET, ID_ADD_STAGE,
         ID_FILTERED_SET_INDEX, ID_FILTERED_SLICE_SLIDER, ID_FILTERED_SCALE_SLIDER,
         ID_FILTERED_GRAYMAP, ID_FILTERED_CENTER_SLIDER, ID_FILTERED_WIDTH_SLIDER, ID_FILTERED_INVERT,
 		ID_SYNC,
@@ -91,6 +93,9 @@ class ITKFilterFrame : public MainFrame {
     int  mFileOrDataCount;  ///< count data/datafiles used (1 for loaded data; 2 for loaded and filtered data).
   protected:
     void addButtonBox   ( void );
+    bool checkInput     ( void );
+    wxString currentStage ( void );
+    wxString pipelineCommand ( const wxString& in, const wxString& out );
     void initializeMenu ( void );
     void removeControls ( void );
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -111,6 +116,7 @@ class ITKFilterFrame : public MainFrame {
         const int* const data,
         const ViewnixHeader* const vh=NULL, const bool vh_initialized=false );
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    virtual void OnAddStage        ( wxCommandEvent& unused );
     virtual void OnFilter          ( wxCommandEvent& unused );
     virtual void OnFilteredGrayMap ( wxCommandEvent& unused );
     virtual void OnFilteredInvert  ( wxCommandEvent& e      );
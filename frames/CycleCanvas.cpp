@@ -221,14 +221,25 @@ void CycleCanvas::reload ( void ) {
                 delete m_images[i];
                 m_images[i] = tmp;
             }
-        } else if (!mInterpolate) {
-            m_images[i] = new wxImage( data->m_xSize, data->m_ySize, ::toRGB(*data) );
+        } else if (!mInterpolate || ScenePyramid::levelFor( xFactor, yFactor )>0) {
+            //start from the smallest reduced copy of the slice that
+            // still has the displayed resolution
+            int  w, h;
+            unsigned char*  rgb = ::toRGBReduced( *data, xFactor, yFactor, w, h );
+            m_images[i] = new wxImage( w, h, rgb );
             int  scaledW=0, scaledH=0;
             if (data->mHasRoi) {
 				assert( data->mRoiX>=0 && data->mRoiY>=0 );
                 assert( data->mRoiX + data->mRoiWidth  <= data->m_xSize );
                 assert( data->mRoiY + data->mRoiHeight <= data->m_ySize );
-                wxRect  r( data->mRoiX, data->mRoiY, data->mRoiWidth, data->mRoiHeight );
+                //roi in the (possibly reduced) image
+                const double  rx = (double)w / data->m_xSize;
+                const double  ry = (double)h / data->m_ySize;
+                wxRect  r( (int)(data->mRoiX * rx), (int)(data->mRoiY * ry),
+                           (int)ceil( data->mRoiWidth  * rx ),
+                           (int)ceil( data->mRoiHeight * ry ) );
+                if (r.x + r.width  > w)    r.width  = w - r.x;
+                if (r.y + r.height > h)    r.height = h - r.y;
                 wxImage*  tmp = new wxImage( m_images[i]->GetSubImage(r) );
                 delete m_images[i];
                 m_images[i] = tmp;
@@ -238,7 +249,8 @@ void CycleCanvas::reload ( void ) {
                 scaledW = (int)ceil( data->m_xSize * xFactor );
                 scaledH = (int)ceil( data->m_ySize * yFactor );
             }
-            m_images[i]->Rescale( scaledW, scaledH );
+            m_images[i]->Rescale( scaledW, scaledH, mInterpolate
+                ? wxIMAGE_QUALITY_BILINEAR : wxIMAGE_QUALITY_NORMAL );
         } else {
             m_images[i] = new wxImage( (int)(data->m_xSize*xFactor),
                 (int)(data->m_ySize*yFactor),
@@ -34,6 +34,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include  "cavass.h"
 #include  "ChunkData.h"
 #include  "FuzzCompCanvas.h"
+#include  <vector>
 
 using namespace std;
 
@@ -92,6 +93,7 @@ FuzzCompCanvas::FuzzCompCanvas ( wxWindow* parent, MainFrame* parent_frame,
 	}
         
 	H = NULL;
+	forest = NULL;
 	affinity_type = 0;
 	training_sample = NULL;
 	training_samples = 0;
@@ -162,6 +164,7 @@ FuzzCompCanvas::~FuzzCompCanvas ( void )
 	if (training_image)
 		free(training_image);
 	training_image = NULL;
+	VDestroyFuzzyForest(forest);
 
 	if( m_paintingPts != NULL )
 	delete []m_paintingPts;
@@ -1949,6 +1952,7 @@ long FuzzCompCanvas::pop_xy_hheap(int *x, int *y)
  *    Created: 3/18/96 adapted from Supun Samarasekra by Dewey Odhner
  *    Modified: 4/17/97 alternate definition of fuzzy AND used by Dewey Odhner
  *    Modified: 1/26/99 hashed heap used instead of queue by Dewey Odhner
+ *    Modified: 10/19/26 update_forest tried first
  *
  *****************************************************************************/
 void FuzzCompCanvas::compute_connectivity_image()
@@ -1968,6 +1972,12 @@ void FuzzCompCanvas::compute_connectivity_image()
     	m_parent_frame->SetStatusText("Memory alloc Error.", 1);//display_error(1);
 		return;
     }
+	if (update_forest())
+	{
+		computed_threshold = threshold;
+		connectivity_data_valid = TRUE;
+		return;
+	}
 	
 	H = hheap_create(8999L, sizeof(PointWithValue) );
 	if (H == NULL)
@@ -2038,6 +2048,71 @@ void FuzzCompCanvas::compute_connectivity_image()
     connectivity_data_valid = TRUE;
 }
 
+/*****************************************************************************
+ * FUNCTION: update_forest
+ * DESCRIPTION: Gives forest the affinities and seeds of the current slice,
+ *    so that connectivity is propagated only from seeds added, cells that
+ *    lost their paths with seeds taken away, and affinities changed since
+ *    the last call, and stores the connectivity values at
+ *    connectivity_data.
+ * PARAMETERS: None
+ * SIDE EFFECTS: The variable dimensions is set.  forest is made if need
+ *    be; it is freed on failure.
+ * ENTRY CONDITIONS: The variables affinity_data_across, affinity_data_down,
+ *    connectivity_data, mData and nSeed must be valid for the current
+ *    slice.
+ * RETURN VALUE: false if the connectivity must be computed in full: when
+ *    memory is not available, or for the alternate fuzzy AND (and_op 2).
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+bool FuzzCompCanvas::update_forest()
+{
+	if (and_op == 2)
+		return false;
+	dimensions.xdim = mCavassData->m_vh.scn.xysize[0];
+	dimensions.ydim = mCavassData->m_vh.scn.xysize[1];
+	dimensions.zdim = mCavassData->m_zSize;
+	dimensions.slice_size = dimensions.xdim*dimensions.ydim;
+	if (forest && (forest->width!=dimensions.xdim ||
+			forest->height!=dimensions.ydim))
+	{
+		VDestroyFuzzyForest(forest);
+		forest = NULL;
+	}
+	if (forest == NULL)
+		forest = VCreateFuzzyForest(dimensions.xdim, dimensions.ydim, 1,
+			MAX_CONNECTIVITY);
+	if (forest == NULL)
+		return false;
+
+	// the affinity toward x-1 or y-1 is that of the neighbor toward the cell
+	const unsigned short *affinity[2][4]={
+		{affinity_data_across, affinity_data_down, affinity_data_across-1,
+		 affinity_data_down-dimensions.xdim}, {NULL}};
+	VSetFuzzyForestAffinity(forest, affinity);
+
+	std::vector<int> seed_cells;
+	int j;
+	for (j=0; j<nSeed; j++)
+		if (mData[j][2] == m_sliceNo)
+			seed_cells.push_back(mData[j][0]+dimensions.xdim*mData[j][1]);
+	if (VSetFuzzyForestSeeds(forest, seed_cells.empty()? NULL: &seed_cells[0],
+			NULL, (int)seed_cells.size()))
+	{
+		VDestroyFuzzyForest(forest);
+		forest = NULL;
+		return false;
+	}
+	VRunFuzzyForest(forest);
+	for (j=0; j<dimensions.slice_size; j++)
+		connectivity_data[j] = forest->key[j]?
+			(conn_t)(forest->key[j]/2-1): 0;
+	return true;
+}
+
 
 /*****************************************************************************
  * FUNCTION: function_update
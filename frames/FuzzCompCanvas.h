@@ -265,6 +265,7 @@ public:
 	void compute_feature_image(int feature);
 	void compute_affinity_image();
 	void compute_connectivity_image();
+	bool update_forest();
 	float transform(float x, int type, float level, float width);
 	void  display_image(int which, unsigned short* pData);
 
@@ -283,6 +284,7 @@ public:
 	int point_value_cmp(PointWithValue *v, PointWithValue *vv);
 	int point_cmp(PointWithValue *v, PointWithValue *vv);
 	Hheap *H;
+	VFuzzyForest *forest;  ///< connectivity kept up to date as seeds change
 
 	////////////Fuzzy component algorithm  //////////
 
@@ -23,6 +23,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 //======================================================================
 #include  "cavass.h"
 #include  "IRFCCanvas.h"
+#include  <vector>
 #undef M_PI
 #include "3dviewnix/PROCESS/PREPROCESS/SCENE_OPERATIONS/FUZZ_TRACK/gqueue.h"
 #include  "CavassData.h"
@@ -149,6 +150,11 @@ IRFCCanvas::IRFCCanvas ( wxWindow* parent, MainFrame* parent_frame,
 	affinityImg = NULL;
 	connectivityImg = NULL;
 	slice_buffer_16 = NULL;
+	affinity_table_grad = affinity_table_obj[0] = affinity_table_obj[1] =
+		NULL;
+	affinity_table_obj_param = NULL;
+	affinity_table_levels = affinity_table_objects = 0;
+	forest = NULL;
 
 	m_bPararell = false;
 
@@ -182,6 +188,12 @@ IRFCCanvas::~IRFCCanvas ( void )
 		free(training_image);
 	training_image = NULL;
 
+	free(affinity_table_grad);
+	free(affinity_table_obj[0]);
+	free(affinity_table_obj[1]);
+	free(affinity_table_obj_param);
+	VDestroyFuzzyForest(forest);
+
 	if( m_paintingPts != NULL )
 	delete []m_paintingPts;
 	m_paintingPts = NULL;
@@ -1352,6 +1364,159 @@ void IRFCCanvas::IRFC_update()
 }
 
 
+/*****************************************************************************
+ * FUNCTION: table_affinity
+ * DESCRIPTION: Returns the affinity between two adjacent pixels from the
+ *    tabulated terms of compute_affinity_image.
+ * PARAMETERS:
+ *    grad: The gradient term for the difference of the pixel values.
+ *    obj_a, obj_b: The object term for the value of each pixel.
+ *    mod: The model value at the first pixel, or NULL if the model term is
+ *       not applied.
+ *    mod_step: The offset from mod to the model value at the second pixel.
+ *    mod_weight: The weight of the model term.
+ *    back: true for the background (complemented) model.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The affinity scaled to MAX_AFFINITY
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26 from compute_affinity_image
+ *
+ *****************************************************************************/
+static inline unsigned short table_affinity(float grad, float obj_a,
+	float obj_b, const unsigned short *mod, int mod_step, float mod_weight,
+	bool back)
+{
+	float temp_affinity=grad+obj_a, temp_affinity2=grad+obj_b,
+		temp_affinity3, temp_affinity4;
+
+	if (mod)
+	{
+		temp_affinity3 = (float)(back? 65534-mod[0]: mod[0]);
+		temp_affinity4 = (float)(back? 65534-mod[mod_step]: mod[mod_step]);
+		temp_affinity += mod_weight*temp_affinity3;
+		temp_affinity2 += mod_weight*temp_affinity4;
+	}
+	if (temp_affinity2 < temp_affinity)
+		temp_affinity = temp_affinity2;
+	return (unsigned short)(temp_affinity*MAX_AFFINITY);
+}
+
+/*****************************************************************************
+ * FUNCTION: update_affinity_tables
+ * DESCRIPTION: Makes the tables of the terms of compute_affinity_image for
+ *    the current parameters, unless the tables already made will do:
+ *    affinity_table_grad[d] is the gradient term for values d apart;
+ *    affinity_table_obj[0][v] and affinity_table_obj[1][v] are the object
+ *    and background object terms for value v.
+ * PARAMETERS:
+ *    levels: The tables must cover values 0 to levels-1.
+ *    gradient_width: The width of the gradient function.
+ *    obj_w: The weight of the object terms.
+ *    gradient_w: The weight of the gradient term.
+ * SIDE EFFECTS: The affinity_table_ variables are set.
+ * ENTRY CONDITIONS: The variables nObj, obj_level, obj_width, obj_type
+ *    must be properly set.
+ * RETURN VALUE: false if memory is not available.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+bool IRFCCanvas::update_affinity_tables(int levels, float gradient_width,
+	float obj_w, float gradient_w)
+{
+	int j, v;
+	bool same=affinity_table_grad!=NULL && levels<=affinity_table_levels &&
+		gradient_width==affinity_table_param[0] &&
+		obj_w==affinity_table_param[1] && gradient_w==affinity_table_param[2]
+		&& nObj==affinity_table_objects;
+
+	for (j=0; same && j<nObj; j++)
+		same = obj_level[j]==affinity_table_obj_param[3*j] &&
+			obj_width[j]==affinity_table_obj_param[3*j+1] &&
+			obj_type[j]==affinity_table_obj_param[3*j+2];
+	if (same)
+		return true;
+
+	free(affinity_table_grad);
+	free(affinity_table_obj[0]);
+	free(affinity_table_obj[1]);
+	free(affinity_table_obj_param);
+	affinity_table_grad = (float *)malloc(levels*sizeof(float));
+	affinity_table_obj[0] = (float *)malloc(levels*sizeof(float));
+	affinity_table_obj[1] = (float *)malloc(levels*sizeof(float));
+	affinity_table_obj_param = (int *)malloc((3*nObj+1)*sizeof(int));
+	if (affinity_table_grad==NULL || affinity_table_obj[0]==NULL ||
+			affinity_table_obj[1]==NULL || affinity_table_obj_param==NULL)
+	{
+		free(affinity_table_grad);
+		free(affinity_table_obj[0]);
+		free(affinity_table_obj[1]);
+		free(affinity_table_obj_param);
+		affinity_table_grad = affinity_table_obj[0] =
+			affinity_table_obj[1] = NULL;
+		affinity_table_obj_param = NULL;
+		return false;
+	}
+	affinity_table_levels = levels;
+	affinity_table_param[0] = gradient_width;
+	affinity_table_param[1] = obj_w;
+	affinity_table_param[2] = gradient_w;
+	affinity_table_objects = nObj;
+	for (j=0; j<nObj; j++)
+	{
+		affinity_table_obj_param[3*j] = obj_level[j];
+		affinity_table_obj_param[3*j+1] = obj_width[j];
+		affinity_table_obj_param[3*j+2] = obj_type[j];
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for private(j)
+#endif
+	for (v=0; v<levels; v++)
+	{
+		float xrel, temp_affinity3, temp_affinity4, temp_affinity5;
+
+		xrel = (float)v/gradient_width;
+		affinity_table_grad[v] = (float)exp(-.5*xrel*xrel)*gradient_w;
+		temp_affinity3 = temp_affinity5 = 0;
+		for (j=0; j<nObj; j++)
+		{
+			xrel = (v-obj_level[j])*(float)(1./obj_width[j]);
+			switch (obj_type[j])
+			{
+				case 1:
+				case 4:
+					temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
+					break;
+				case -1:
+				case 2:
+					temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
+					break;
+				case 0:
+				case 3:
+					temp_affinity4 = (float)exp(-.5*xrel*xrel);
+					break;
+				default:
+					temp_affinity4 = 0;
+			}
+			/* types 1, -1, 0 are object; 4, 2, 3 background */
+			if (obj_type[j]>=-1 && obj_type[j]<=1)
+			{
+				if (temp_affinity4 > temp_affinity3)
+					temp_affinity3 = temp_affinity4;
+			}
+			else if (temp_affinity4 > temp_affinity5)
+				temp_affinity5 = temp_affinity4;
+		}
+		affinity_table_obj[0][v] = obj_w*temp_affinity3;
+		affinity_table_obj[1][v] = obj_w*temp_affinity5;
+	}
+	return true;
+}
+
 /*****************************************************************************
  * FUNCTION: compute_affinity_image
  * DESCRIPTION: Computes the affinity values for the current slice and
@@ -1379,17 +1544,14 @@ void IRFCCanvas::IRFC_update()
  *    Modified: 2/18/97 threshold applied covariance affinity type
  *       by Dewey Odhner
  *    Modified: 4/16/97 threshold not applied by Dewey Odhner
+ *    Modified: 10/19/26 terms taken from tables, rows computed in parallel
  *
  *****************************************************************************/
 void IRFCCanvas::compute_affinity_image()
 {
 	int row,column, feature_n, features_on;
-	unsigned short *out_ptr_down, *out_ptr_across, *row_ptr_16,
-		*out_ptr_up, *out_ptr_back, *out_ptr_down2, *out_ptr_across2,
-		*out_ptr_up2, *out_ptr_back2;
 	float on_function_level[NUM_FEATURES], on_function_width[NUM_FEATURES],
-		on_weight[NUM_FEATURES], temp_affinity, temp_affinity2, xrel,
-		temp_affinity3, temp_affinity4, mod_weight;
+		on_weight[NUM_FEATURES], mod_weight;
 
 	slice_data = (void*)mCavassData->getSlice( m_sliceNo );
 	if (slice_buffer_16 == NULL)
@@ -1495,559 +1657,99 @@ void IRFCCanvas::compute_affinity_image()
 
 	if (features_on == 0)
 		return;
-	unsigned short *mod_ptr;
+	unsigned short *mod_ptr=NULL;
 	if (model_filename)
 		mod_ptr = (unsigned short *)modelData->getSlice( m_sliceNo );
 	on_weight[1] = (float)(.01*obj_weight);
 	on_weight[2] = (float)(.01*weight[2]);
 	mod_weight = (float)(.01/65534)*(100-obj_weight-weight[2]);
-	out_ptr_across = affinity_data_across;
-	out_ptr_down = affinity_data_down;
-	out_ptr_up = affinity_data_up;
-	out_ptr_back = affinity_data_back;
-	out_ptr_across2 = affinity_data_across2;
-	out_ptr_down2 = affinity_data_down2;
-	out_ptr_up2 = affinity_data_up2;
-	out_ptr_back2 = affinity_data_back2;
-	for (row=0; row<mCavassData->m_vh.scn.xysize[1]; row++)
-	{
-		row_ptr_16 = slice_buffer_16+row*mCavassData->m_vh.scn.xysize[0];
-		for (column=0; column<mCavassData->m_vh.scn.xysize[0]; column++)
+
+	/* The gradient term depends only on the difference of the values and
+	   the object terms each only on one value, so they come from tables. */
+	const int width=mCavassData->m_vh.scn.xysize[0],
+		height=mCavassData->m_vh.scn.xysize[1];
+	int levels=1;
+	for (column=0; column<width*height; column++)
+		if (slice_buffer_16[column] >= levels)
+			levels = slice_buffer_16[column]+1;
+	if (!update_affinity_tables(levels, on_function_width[2], on_weight[1],
+			on_weight[2]))
+	{
+		m_parent_frame->SetStatusText("Memory alloc Error.", 1);
+		return;
+	}
+	const float *grad=affinity_table_grad, *fg=affinity_table_obj[0],
+		*bg=affinity_table_obj[1];
+	const int mod_width= model_filename? modelData->m_vh.scn.xysize[0]: 0,
+		mod_height= model_filename? modelData->m_vh.scn.xysize[1]: 0;
+
+#ifdef _OPENMP
+	#pragma omp parallel for private(column)
+#endif
+	for (row=0; row<height; row++)
+	{
+		const unsigned short *v=slice_buffer_16+row*width,
+			*mod= mod_ptr? mod_ptr+row*width: NULL;
+		const int k=row*width;
+
+		for (column=0; column<width; column++)
 		{
-		  if (column == mCavassData->m_vh.scn.xysize[0]-1)
-		    *out_ptr_across = *out_ptr_across2 = 0;
+		  const int a=v[column];
+		  int b;
+		  bool m;
+
+		  if (column == width-1)
+		    affinity_data_across[k+column] =
+				affinity_data_across2[k+column] = 0;
 		  else
 		  {
-			xrel = ((float)row_ptr_16[column+1]-row_ptr_16[column])/
-				on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column+1]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && column<modelData->m_vh.scn.xysize[0]-1)
-			{
-				temp_affinity3 = *mod_ptr;
-				temp_affinity4 = mod_ptr[1];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_across = (unsigned short)(temp_affinity*MAX_AFFINITY);
-
-			xrel = ((float)row_ptr_16[column+1]-row_ptr_16[column])/
-				on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column+1]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && column<modelData->m_vh.scn.xysize[0]-1)
-			{
-				temp_affinity3 = 65534-*mod_ptr;
-				temp_affinity4 = 65534-mod_ptr[1];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_across2 = (unsigned short)(temp_affinity*MAX_AFFINITY);
+			b = v[column+1];
+			m = mod && column<mod_width-1;
+			affinity_data_across[k+column] = table_affinity(grad[abs(b-a)],
+				fg[a], fg[b], m? mod+column: NULL, 1, mod_weight, false);
+			affinity_data_across2[k+column] = table_affinity(grad[abs(b-a)],
+				bg[a], bg[b], m? mod+column: NULL, 1, mod_weight, true);
 		  }
 
 		  if (column == 0)
-		    *out_ptr_back = *out_ptr_back2 = 0;
+		    affinity_data_back[k+column] = affinity_data_back2[k+column] = 0;
 		  else
 		  {
-			xrel = ((float)row_ptr_16[column-1]-row_ptr_16[column])/
-				on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column-1]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && column<modelData->m_vh.scn.xysize[0]-1)
-			{
-				temp_affinity3 = *mod_ptr;
-				temp_affinity4 = mod_ptr[-1];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_back = (unsigned short)(temp_affinity*MAX_AFFINITY);
-
-			xrel = ((float)row_ptr_16[column-1]-row_ptr_16[column])/
-				on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column-1]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && column<modelData->m_vh.scn.xysize[0]-1)
-			{
-				temp_affinity3 = 65534-*mod_ptr;
-				temp_affinity4 = 65534-mod_ptr[-1];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_back2 = (unsigned short)(temp_affinity*MAX_AFFINITY);
+			b = v[column-1];
+			m = mod && column<mod_width-1;
+			affinity_data_back[k+column] = table_affinity(grad[abs(b-a)],
+				fg[a], fg[b], m? mod+column: NULL, -1, mod_weight, false);
+			affinity_data_back2[k+column] = table_affinity(grad[abs(b-a)],
+				bg[a], bg[b], m? mod+column: NULL, -1, mod_weight, true);
 		  }
 
-		  if (row == mCavassData->m_vh.scn.xysize[1]-1)
-		    *out_ptr_down = *out_ptr_down2 = 0;
+		  if (row == height-1)
+		    affinity_data_down[k+column] = affinity_data_down2[k+column] = 0;
 		  else
 		  {
-			xrel = ((float)row_ptr_16[column+mCavassData->m_vh.scn.xysize[0]]-
-				row_ptr_16[column])/on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column+mCavassData->m_vh.scn.xysize[0]]-
-					obj_level[j])*(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && row<modelData->m_vh.scn.xysize[1]-1)
-			{
-				temp_affinity3 = *mod_ptr;
-				temp_affinity4 = mod_ptr[modelData->m_vh.scn.xysize[0]];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_down = (unsigned short)(temp_affinity*MAX_AFFINITY);
-
-			xrel = ((float)row_ptr_16[column+mCavassData->m_vh.scn.xysize[0]]-
-				row_ptr_16[column])/on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column+mCavassData->m_vh.scn.xysize[0]]-
-					obj_level[j])*(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && row<modelData->m_vh.scn.xysize[1]-1)
-			{
-				temp_affinity3 = 65534-*mod_ptr;
-				temp_affinity4 = 65534-mod_ptr[modelData->m_vh.scn.xysize[0]];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_down2 = (unsigned short)(temp_affinity*MAX_AFFINITY);
+			b = v[column+width];
+			m = mod && row<mod_height-1;
+			affinity_data_down[k+column] = table_affinity(grad[abs(b-a)],
+				fg[a], fg[b], m? mod+column: NULL, mod_width, mod_weight,
+				false);
+			affinity_data_down2[k+column] = table_affinity(grad[abs(b-a)],
+				bg[a], bg[b], m? mod+column: NULL, mod_width, mod_weight,
+				true);
 		  }
 
 		  if (row == 0)
-		    *out_ptr_up = *out_ptr_up2 = 0;
+		    affinity_data_up[k+column] = affinity_data_up2[k+column] = 0;
 		  else
 		  {
-			xrel = ((float)row_ptr_16[column-mCavassData->m_vh.scn.xysize[0]]-
-				row_ptr_16[column])/on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column-mCavassData->m_vh.scn.xysize[0]]-
-					obj_level[j])*(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 1:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case -1:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 0:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && row<modelData->m_vh.scn.xysize[1]-1)
-			{
-				temp_affinity3 = *mod_ptr;
-				temp_affinity4 = mod_ptr[-modelData->m_vh.scn.xysize[0]];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_up = (unsigned short)(temp_affinity*MAX_AFFINITY);
-
-			xrel = ((float)row_ptr_16[column-mCavassData->m_vh.scn.xysize[0]]-
-				row_ptr_16[column])/on_function_width[2];
-			if (xrel < 0)
-				xrel = -xrel;
-			temp_affinity = (float)exp(-.5*xrel*xrel)*on_weight[2];
-			temp_affinity2 = temp_affinity;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column]-obj_level[j])*
-					(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity += on_weight[1]*temp_affinity3;
-			temp_affinity3 = 0;
-			for (int j=0; j<nObj; j++)
-			{
-				xrel = (row_ptr_16[column-mCavassData->m_vh.scn.xysize[0]]-
-					obj_level[j])*(float)(1./obj_width[j]);
-				switch (obj_type[j])
-				{
-					case 4:
-						temp_affinity4 = (float)(xrel>0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 2:
-						temp_affinity4 = (float)(xrel<0? 1:exp(-.5*xrel*xrel));
-						break;
-					case 3:
-						temp_affinity4 = (float)exp(-.5*xrel*xrel);
-						break;
-					default:
-						temp_affinity4 = 0;
-				}
-				if (temp_affinity4 > temp_affinity3)
-					temp_affinity3 = temp_affinity4;
-			}
-			temp_affinity2 += on_weight[1]*temp_affinity3;
-			if (model_filename && row<modelData->m_vh.scn.xysize[1]-1)
-			{
-				temp_affinity3 = 65534-*mod_ptr;
-				temp_affinity4 = 65534-mod_ptr[-modelData->m_vh.scn.xysize[0]];
-				temp_affinity += mod_weight*temp_affinity3;
-				temp_affinity2 += mod_weight*temp_affinity4;
-			}
-			if (temp_affinity2 < temp_affinity)
-				temp_affinity = temp_affinity2;
-			*out_ptr_up2 = (unsigned short)(temp_affinity*MAX_AFFINITY);
+			b = v[column-width];
+			m = mod && row<mod_height-1;
+			affinity_data_up[k+column] = table_affinity(grad[abs(b-a)],
+				fg[a], fg[b], m? mod+column: NULL, -mod_width, mod_weight,
+				false);
+			affinity_data_up2[k+column] = table_affinity(grad[abs(b-a)],
+				bg[a], bg[b], m? mod+column: NULL, -mod_width, mod_weight,
+				true);
 		  }
-
-          if (model_filename)
-		    mod_ptr++;
-		  out_ptr_across++;
-		  out_ptr_down++;
-		  out_ptr_back++;
-		  out_ptr_up++;
-		  out_ptr_across2++;
-		  out_ptr_down2++;
-		  out_ptr_back2++;
-		  out_ptr_up2++;
 		}
 	}
 	affinity_data_valid = TRUE;
@@ -2100,7 +1802,11 @@ float IRFCCanvas::transform(float x, int type, float level, float width)
 /*****************************************************************************
  * FUNCTION: compute_connectivity_image
  * DESCRIPTION: Computes the connectivity values for the current slice and
- *    stores them at connectivity_data.
+ *    stores them at connectivity_data.  They are updated from what changed
+ *    since the last call by update_forest if possible, else computed in
+ *    full.
+ * HISTORY:
+ *    Modified: 10/19/26 update_forest tried first
  *
  *****************************************************************************/
 
@@ -2139,6 +1845,12 @@ void IRFCCanvas::compute_connectivity_image()
     dimensions.ydim = mCavassData->m_vh.scn.xysize[1];
     dimensions.zdim = mCavassData->m_zSize;
     dimensions.slice_size = dimensions.xdim*dimensions.ydim;
+	if (update_forest())
+	{
+		computed_threshold = threshold;
+		connectivity_data_valid = true;
+		return;
+	}
     memset(connectivity_data, 0, dimensions.slice_size*sizeof(conn_t));
 	float slice_spacing=dimensions.zdim==1? mCavassData->m_vh.scn.xypixsz[0]:
 		mCavassData->m_vh.scn.loc_of_subscenes[1]-
@@ -2319,6 +2031,98 @@ void IRFCCanvas::compute_connectivity_image()
     connectivity_data_valid = true;
 }
 
+/*****************************************************************************
+ * FUNCTION: update_forest
+ * DESCRIPTION: Gives forest the affinities and seeds of the current slice,
+ *    so that connectivity is propagated only from seeds added, cells that
+ *    lost their paths with seeds taken away, and affinities changed since
+ *    the last call, and stores the connectivity values at
+ *    connectivity_data as compute_connectivity_image does.
+ * PARAMETERS: None
+ * SIDE EFFECTS: forest is made if need be; it is freed on failure.
+ * ENTRY CONDITIONS: The variables dimensions, connectivity_data and the
+ *    affinity_data_ variables must be valid for the current slice.
+ * RETURN VALUE: false if memory is not available; the connectivity must
+ *    then be computed in full.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+bool IRFCCanvas::update_forest()
+{
+	if (forest && (forest->width!=dimensions.xdim ||
+			forest->height!=dimensions.ydim))
+	{
+		VDestroyFuzzyForest(forest);
+		forest = NULL;
+	}
+	if (forest == NULL)
+		forest = VCreateFuzzyForest(dimensions.xdim, dimensions.ydim, 2,
+			MAX_CONNECTIVITY);
+	if (forest == NULL)
+		return false;
+
+	const unsigned short *affinity[2][4]={
+		{affinity_data_across, affinity_data_down, affinity_data_back,
+		 affinity_data_up},
+		{affinity_data_across2, affinity_data_down2, affinity_data_back2,
+		 affinity_data_up2}};
+	VSetFuzzyForestAffinity(forest, affinity);
+
+	std::vector<int> seed_cells;
+	std::vector<unsigned char> seed_labels;
+	int j, c;
+	for (j=0; j<nFg_seed; j++)
+		if (fg_seed[j][2] == m_sliceNo)
+		{
+			seed_cells.push_back(fg_seed[j][0]+dimensions.xdim*fg_seed[j][1]);
+			seed_labels.push_back(0);
+		}
+	if (points_filename)
+	{
+		unsigned char *points_slice=(unsigned char *)pointsData->
+			getSlice(m_sliceNo);
+		for (j=c=0; j<pointsData->m_ySize; j++)
+			for (int k=0; k<pointsData->m_xSize; k++,c++)
+				if (points_slice[c])
+				{
+					seed_cells.push_back(c);
+					seed_labels.push_back(0);
+				}
+	}
+	for (j=0; j<nBg_seed; j++)
+		if (bg_seed[j][2] == m_sliceNo)
+		{
+			seed_cells.push_back(bg_seed[j][0]+dimensions.xdim*bg_seed[j][1]);
+			seed_labels.push_back(1);
+		}
+	if (bg_filename)
+	{
+		unsigned char *points_slice=(unsigned char *)bgData->
+			getSlice(m_sliceNo);
+		for (j=c=0; j<bgData->m_ySize; j++)
+			for (int k=0; k<bgData->m_xSize; k++,c++)
+				if (points_slice[c])
+				{
+					seed_cells.push_back(c);
+					seed_labels.push_back(1);
+				}
+	}
+	if (VSetFuzzyForestSeeds(forest, seed_cells.empty()? NULL: &seed_cells[0],
+			seed_labels.empty()? NULL: &seed_labels[0], (int)seed_cells.size()))
+	{
+		VDestroyFuzzyForest(forest);
+		forest = NULL;
+		return false;
+	}
+	VRunFuzzyForest(forest);
+	for (c=0; c<dimensions.slice_size; c++)
+		connectivity_data[c] = (forest->key[c]&1)==0?
+			(OutCellType)(forest->key[c]/2-1): 0;
+	return true;
+}
+
 
 /*****************************************************************************
  * FUNCTION: function_update
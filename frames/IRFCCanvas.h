@@ -248,6 +248,13 @@ public:
 	unsigned char *training_image;	
 	void *slice_data, *masked_original;
 	unsigned short *slice_buffer_16;
+	float *affinity_table_grad;    ///< gradient term by value difference
+	float *affinity_table_obj[2];  ///< object, background terms by value
+	int    affinity_table_levels;  ///< values covered by the tables
+	float  affinity_table_param[3];   ///< parameters the tables were made
+	int   *affinity_table_obj_param;  ///<   for (see update_affinity_tables)
+	int    affinity_table_objects;
+	VFuzzyForest *forest;  ///< connectivity kept up to date as seeds change
 	int computed_threshold;
 	int threshold;
 	
@@ -272,7 +279,10 @@ public:
 	void IRFC_update();
 	void compute_feature_image(int feature);
 	void compute_affinity_image();
+	bool update_affinity_tables(int levels, float gradient_width,
+		float obj_w, float gradient_w);
 	void compute_connectivity_image();
+	bool update_forest();
 	float transform(float x, int type, float level, float width);
 	void  display_image(int which, unsigned short* pData);
 
@@ -227,11 +227,16 @@ void MontageCanvas::reload ( void ) {
             //note: image data is 24-bit rgb
             if (xFactor==1.0 && yFactor==1.0) {
                 m_images[k] = new wxImage( data->m_xSize, data->m_ySize, ::toRGB(*data) );
-            } else if (!mInterpolate) {
-                m_images[k] = new wxImage( data->m_xSize, data->m_ySize, ::toRGB(*data) );
+            } else if (!mInterpolate || ScenePyramid::levelFor( xFactor, yFactor )>0) {
+                //start from the smallest reduced copy of the slice that
+                // still has the displayed resolution
+                int  w, h;
+                unsigned char*  rgb = ::toRGBReduced( *data, xFactor, yFactor, w, h );
+                m_images[k] = new wxImage( w, h, rgb );
                 const int  scaledW = (int)ceil( data->m_xSize * xFactor );
                 const int  scaledH = (int)ceil( data->m_ySize * yFactor );
-                m_images[k]->Rescale( scaledW, scaledH );
+                m_images[k]->Rescale( scaledW, scaledH, mInterpolate
+                    ? wxIMAGE_QUALITY_BILINEAR : wxIMAGE_QUALITY_NORMAL );
             } else {
                 m_images[k] = new wxImage( (int)(data->m_xSize*xFactor),
                     (int)(data->m_ySize*yFactor),
@@ -707,8 +707,10 @@ void SurfViewCanvas::loadFile ( const char* const fn ) {
     mRenderer = new cvRenderer(&file_list, 1);
     bool  stereoOn = false;
     if (Preferences::getStereoMode() != Preferences::StereoModeOff) {
-        mRenderer->mAux = new cvRenderer( &file_list, 1 );
+        //the aux renderer shares the loaded objects of mRenderer
+        mRenderer->mAux = new cvRenderer( mRenderer );
         assert( mRenderer->mAux != NULL );
+        mRenderer->mConcurrentStereo = Preferences::getStereoConcurrent();
         stereoOn = true;
     }
     free(file_list);
@@ -768,8 +770,10 @@ void SurfViewCanvas::loadFiles ( wxArrayString &filenames ) {
     mRenderer = new cvRenderer(file_list, filenames.Count());
     bool  stereoOn = false;
     if (Preferences::getStereoMode() != Preferences::StereoModeOff) {
-        mRenderer->mAux = new cvRenderer( file_list, filenames.Count() );
+        //the aux renderer shares the loaded objects of mRenderer
+        mRenderer->mAux = new cvRenderer( mRenderer );
         assert( mRenderer->mAux != NULL );
+        mRenderer->mConcurrentStereo = Preferences::getStereoConcurrent();
         stereoOn = true;
     }
     for (unsigned int j=0; j<filenames.Count(); j++)
@@ -1827,6 +1831,7 @@ public:
                         re->mRenderer->do_plane_slice();
                     data = re->mRenderer->render2( overallXSize, overallYSize,
                         mCanvas->mInterruptRenderingFlag );
+                    mCanvas->handleStereo( data );
                     if (re->mRenderer->line)
                     {
                         if (mCanvas->mLinePixelCount)
@@ -5726,158 +5731,35 @@ void SurfViewCanvas::save_movie( const char path[] )
         return;
     }
 
-    int frames_to_go = key_poses;
-    for (int j=0; j<key_poses-1; j++)
-        frames_to_go += key_pose[j+1].views;
-    if (key_poses>2 && key_pose[key_poses-1].angle[0]==key_pose[0].angle[0] &&
-            key_pose[key_poses-1].angle[1]==key_pose[0].angle[1] &&
-            key_pose[key_poses-1].angle[2]==key_pose[0].angle[2])
-        frames_to_go--;
+    int frames_to_go = ::movie_frames(key_pose, key_poses);
 
   if (strlen(path)>4 && strcmp(path+strlen(path)-4, ".MV0")==0)
   {
     int error_code, obytes;
     FILE *movie_file;
-    ViewnixHeader *header;
-    float smallest_value[3], largest_value[3];
-    short signed_bits[3], bit_fields[6];
     char *data, bad_group[5], bad_element[5];
     const int frame_bytes=mRenderer->main_image->width*
         mRenderer->main_image->height*3;
-    Shell_data *obj_data=&mRenderer->object_list->main_data;
 
-    /* Create new file, write header, copy frames from temp file. */
-    header = (ViewnixHeader *)calloc(1, sizeof(ViewnixHeader));
-    if (header == NULL)
-    {
-        wxMessageBox("Out of memory.");
-        return;
-    }
-    strcpy(header->gen.filename1,
-        obj_data->file->file_header.gen.filename);
-    strncpy(header->gen.filename, path, sizeof(header->gen.filename)-1);
-    header->gen.filename1_valid = header->gen.filename_valid = 1;
+    /* Create new file, write header, then the frames as they are rendered. */
     movie_file = fopen(path, "wb+");
     if (movie_file == NULL)
     {
         wxMessageBox(wxString("Unable to create file ")+path);
-        free(header);
         return;
     }
-    /*@ Fill in type 1 now, deal with the rest later. */
-    strcpy(header->gen.recognition_code, "VIEWNIX1.0");
-    header->gen.data_type = MOVIE0;
-    header->gen.data_type_valid = header->gen.recognition_code_valid = 1;
-    if (obj_data->file->file_header.gen.study_date_valid)
-    {	strcpy(header->gen.study_date,
-            obj_data->file->file_header.gen.study_date);
-        header->gen.study_date_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.study_time_valid)
-    {	strcpy(header->gen.study_time,
-            obj_data->file->file_header.gen.study_time);
-        header->gen.study_time_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.modality_valid)
-    {	strcpy(header->gen.modality,
-            obj_data->file->file_header.gen.modality);
-        header->gen.modality_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.institution_valid)
-    {	strcpy(header->gen.institution,
-            obj_data->file->file_header.gen.institution);
-        header->gen.institution_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.physician_valid)
-    {	strcpy(header->gen.physician,
-            obj_data->file->file_header.gen.physician);
-        header->gen.physician_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.department_valid)
-    {	strcpy(header->gen.department,
-            obj_data->file->file_header.gen.department);
-        header->gen.department_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.radiologist_valid)
-    {	strcpy(header->gen.radiologist,
-            obj_data->file->file_header.gen.radiologist);
-        header->gen.radiologist_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.model_valid)
-    {	strcpy(header->gen.model,
-            obj_data->file->file_header.gen.model);
-        header->gen.model_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.patient_name_valid)
-    {	strcpy(header->gen.patient_name,
-            obj_data->file->file_header.gen.patient_name);
-        header->gen.patient_name_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.patient_id_valid)
-    {	strcpy(header->gen.patient_id,
-            obj_data->file->file_header.gen.patient_id);
-        header->gen.patient_id_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.study_valid)
-    {	strcpy(header->gen.study,
-            obj_data->file->file_header.gen.study);
-        header->gen.study_valid = 1;
-    }
-    if (obj_data->file->file_header.gen.series_valid)
-    {	strcpy(header->gen.series,
-            obj_data->file->file_header.gen.series);
-        header->gen.series_valid = 1;
-    }
-    header->dsp.num_of_elems = 3;
-    header->dsp.measurement_unit[0] = header->dsp.measurement_unit[1] =
-        obj_data->file->file_header.str.measurement_unit[0];
-    header->dsp.measurement_unit_valid = 1;
-    header->dsp.dimension = 5;
-    smallest_value[0] = smallest_value[1] = smallest_value[2] = 0;
-    header->dsp.smallest_value = smallest_value;
-    largest_value[0] = largest_value[1] = largest_value[2] = 255;
-    header->dsp.largest_value = largest_value;
-    header->dsp.num_of_integers = header->dsp.num_of_elems;
-    signed_bits[0] = signed_bits[1] = signed_bits[2] = 0;
-    header->dsp.signed_bits = signed_bits;
-    bit_fields[0] = 0;
-    bit_fields[1] = 7;
-    bit_fields[2] = 8;
-    bit_fields[3] = 15;
-    bit_fields[4] = 16;
-    bit_fields[5] = 23;
-    header->dsp.num_of_bits = 24;
-    header->dsp.bit_fields = bit_fields;
-    header->dsp.num_of_images = frames_to_go;
-    header->dsp.xysize[0] = mRenderer->main_image->width;
-    header->dsp.xysize[1] = mRenderer->main_image->height;
-    header->dsp.xypixsz[0] = header->dsp.xypixsz[1] =
-        1/(mRenderer->scale*unit_mm(obj_data));
-    header->dsp.dimension_valid = header->dsp.num_of_elems_valid =
-        header->dsp.smallest_value_valid = header->dsp.largest_value_valid =
-        header->dsp.num_of_integers_valid = header->dsp.signed_bits_valid =
-        header->dsp.num_of_bits_valid = header->dsp.bit_fields_valid =
-        header->dsp.num_of_images_valid = header->dsp.xysize_valid =
-        header->dsp.xypixsz_valid = 1;
-    error_code = VWriteHeader(movie_file, header, bad_group, bad_element);
-    switch (error_code)
-    {	case 0:
-        case 107:
-        case 106:
-            break;
-        default:
+    error_code = ::write_movie_header(movie_file, path, mRenderer,
+        frames_to_go, bad_group, bad_element);
+    if (error_code)
+    {
+        if (error_code == 1)
+            wxMessageBox("Out of memory.");
+        else if (bad_group[0])
             wxMessageBox(wxString::Format(
                 "Group %s element %s undefined in VWriteHeader",
                 bad_group, bad_element));
-            free(header);
-            fclose(movie_file);
-            return;
-    }
-    error_code = VSeekData(movie_file, 0);
-    if (error_code)
-    {
-        wxMessageBox("File seek failed.");
-        free(header);
+        else
+            wxMessageBox("File write failed.");
         fclose(movie_file);
         return;
     }
@@ -5908,12 +5790,11 @@ void SurfViewCanvas::save_movie( const char path[] )
         if (error_code)
         {
             wxMessageBox("File write failed.");
-            free(header);
             fclose(movie_file);
+            return;
         }
     }
     VCloseData(movie_file);
-    free(header);
   }
   else
   {
@@ -6001,10 +5882,11 @@ void SurfViewCanvas::save_movie( const char path[] )
 void SurfViewCanvas::handleStereo ( char* rendered ) {
     assert( rendered != NULL );
     if (Preferences::getStereoMode() == Preferences::StereoModeOff)    return;
-    mRenderer->setStereoTransform();
+    if (mRenderer->mAux == NULL)    return;
 
+    //rendered already if render2 rendered both views concurrently
     int  auxOverallXSize, auxOverallYSize;
-    char*  dataAux = mRenderer->mAux->render2( auxOverallXSize, auxOverallYSize, mInterruptRenderingFlag );
+    char*  dataAux = mRenderer->renderStereoPartner( auxOverallXSize, auxOverallYSize, mInterruptRenderingFlag );
     assert( dataAux != NULL );
     assert( auxOverallXSize == mOverallXSize && auxOverallYSize == mOverallYSize );
     /** \todo creat the stereo pair */
@@ -43,7 +43,6 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 
 class  RenderThread;
 class  RenderingEventData;
-typedef struct {double angle[3]; int views;} Key_pose;
 
 //class SurfViewCanvas : public wxScrolledWindow {
 /** \brief SurfViewCanvas - the canvas on which images and other things
@@ -565,21 +565,30 @@ int compute_histogram(double hist[65536], CavassData *cd,
 				end = cd->m_vh.scn.num_of_subscenes[0]*slice_size;
 			break;
 	}
-	memset(hist, 0, sizeof(long)*(cd->m_max+1));
-	if (cd->m_vh.scn.num_of_bits == 8)
+	if (cd->m_vh.scn.num_of_bits!=8 && cd->m_vh.scn.num_of_bits!=16)
 	{
-		unsigned char *data = (unsigned char *)cd->m_data;
-		for (long j=offset; j<end; j++)
-			if (data[j])
-				hist[data[j]]++;
+		memset(hist, 0, sizeof(double)*(cd->m_max+1));
+		return 0;
 	}
-	else if (cd->m_vh.scn.num_of_bits == 16)
+	// One parallel pass; the whole scene of an unchanged file may be cached.
+	const int bits = cd->m_vh.scn.num_of_bits;
+	const bool whole_file = scope==2 && cd->m_fname!=NULL &&
+		CavassData::endsWith(cd->m_fname, ".im0");
+	VSceneStats stats;
+	if (!whole_file || VLookupSceneFileStats(cd->m_fname, bits, 0, &stats))
 	{
-		unsigned short *data = (unsigned short *)cd->m_data;
-		for (long j=offset; j<end; j++)
-			if (data[j])
-				hist[data[j]]++;
+		if (VInitSceneStats(&stats, bits, 0))
+			return 1;
+		VAccumulateSceneStats(&stats,
+			(unsigned char *)cd->m_data+offset*(bits/8), NULL, end-offset);
+		VFinishSceneStats(&stats);
+		if (whole_file)
+			VStoreSceneFileStats(cd->m_fname, &stats);
 	}
+	for (int j=1; j<=cd->m_max && j<stats.hist_size; j++)
+		hist[j] = stats.hist[j];
+	hist[0] = 0;
+	VFreeSceneStats(&stats);
 	return 0;
 }
 
@@ -95,7 +95,8 @@ const string PersistentSegment2dFrame::ilw_iterates   = "ilw_iterates",
 const string PersistentSegment2dFrame::ls_iterates = "ls_iterates",
              PersistentSegment2dFrame::ls_alpha    = "ls_alpha",
              PersistentSegment2dFrame::ls_beta     = "ls_beta",
-             PersistentSegment2dFrame::ls_gamma    = "ls_gamma";
+             PersistentSegment2dFrame::ls_gamma    = "ls_gamma",
+             PersistentSegment2dFrame::ls_semiImplicit = "ls_semiImplicit";
 //paint mode item
 const string PersistentSegment2dFrame::p_brushSize = "p_brushSize";
 //peek   mode items: none
@@ -433,6 +434,7 @@ void PersistentSegment2dFrame::saveLiveSnakeControls ( ) const {
     SaveValue( ls_alpha, c->mAlphaCtrl->GetValue() );
     SaveValue( ls_beta, c->mBetaCtrl->GetValue() );
     SaveValue( ls_gamma, c->mGammaCtrl->GetValue() );
+    SaveValue( ls_semiImplicit, c->mSemiImplicit->GetValue() );
 }
 //------------------------------------------------------------------------
 void PersistentSegment2dFrame::savePaintControls ( ) const {
@@ -990,6 +992,12 @@ void PersistentSegment2dFrame::restoreLiveSnakeControls ( ) {
     ok = RestoreValue( ls_gamma, &tmp );
     if (!ok)    cerr << "restore ls_gamma failed." << endl;
     else        w->doGamma( tmp );
+
+    //semi-implicit evolution (greedy by default)
+    int checked;
+    ok = RestoreValue( ls_semiImplicit, &checked );
+    if (!ok)    cerr << "restore ls_semiImplicit failed." << endl;
+    else        w->doSemiImplicit( checked );
 }
 
 void PersistentSegment2dFrame::restorePaintControls ( ) {
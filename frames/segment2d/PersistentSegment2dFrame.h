@@ -81,7 +81,8 @@ public:
     _seg2d( gradient4 );
 #undef _seg2d
     static const string ilw_iterates, ilw_minCtrlPts;  ///< ilw mode items
-    static const string ls_iterates, ls_alpha, ls_beta, ls_gamma;  ///< livesnake mode items
+    static const string ls_iterates, ls_alpha, ls_beta, ls_gamma,
+                        ls_semiImplicit;  ///< livesnake mode items
     static const string p_brushSize;  ///< paint mode item
     //peek mode items:   none
     //report mode items: none
@@ -0,0 +1,247 @@
+#include "cavass.h"
+#include "SamWorker.h"
+#include <wx/txtstrm.h>
+
+/**
+ * \brief the worker process. it deletes itself when the worker exits, so
+ * it lets its owner know first.
+ */
+class SamWorkerProcess : public wxProcess {
+public:
+    SamWorker*  mOwner;     ///< nullptr once the owner has let go
+
+    SamWorkerProcess ( SamWorker* owner ) : mOwner(owner) {
+        Redirect();
+    }
+
+    void OnTerminate ( int pid, int status ) override {
+        wxLogMessage( wxString::Format( "sam_worker exited (%d)", status ) );
+        if (mOwner != nullptr)    mOwner->mProcess = nullptr;
+        delete this;
+    }
+};
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief the worker shared by all interactive dl controls. it's never
+ * deleted; the worker process exits when cavass closes its stdin at exit.
+ */
+SamWorker* SamWorker::get ( ) {
+    static auto worker = new SamWorker();
+    return worker;
+}
+
+SamWorker::~SamWorker ( ) {
+    stop();
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief is the worker process running? */
+bool SamWorker::isRunning ( ) const {
+    return mProcess != nullptr && wxProcess::Exists( (int)mPid );
+}
+
+/**
+ * \brief start the worker (sam_worker.py, assumed to be in the cavass build
+ * directory as inference.py is).
+ * @return true if started; false otherwise.
+ */
+bool SamWorker::start ( ) {
+    if (isRunning())    return true;
+    stop();
+    wxString sep = wxFileName::GetPathSeparator();
+#ifdef WIN32
+    wxString cmd = "python \"" + Preferences::getHome() + sep + "sam_worker.py\"";
+#else
+    wxString cmd = "python3 \"" + Preferences::getHome() + sep + "sam_worker.py\"";
+#endif
+    wxLogMessage( "cmd: " + cmd );
+    auto p = new SamWorkerProcess( this );
+    mPid = ::wxExecute( cmd, wxEXEC_ASYNC, p );
+    if (mPid <= 0) {
+        delete p;
+        return false;
+    }
+    mProcess = p;
+    mCheckpoint.clear();
+    mDevice.clear();
+    return true;
+}
+
+/** \brief ask the worker to quit (if it's running) and let go of it. */
+void SamWorker::stop ( ) {
+    if (mProcess == nullptr)    return;
+    auto p = dynamic_cast<SamWorkerProcess*>( mProcess );
+    mProcess = nullptr;
+    if (p == nullptr)    return;
+    p->mOwner = nullptr;  //it will delete itself when the worker exits
+    auto out = p->GetOutputStream();
+    if (out != nullptr) {
+        unsigned char quit[8] = { QUIT, 0, 0, 0, 0, 0, 0, 0 };
+        out->Write( quit, sizeof quit );
+    }
+    p->CloseOutput();
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief store v as 4 little-endian bytes at p. */
+static void pack ( unsigned char* p, unsigned int v ) {
+    for (int i=0; i<4; i++)    p[i] = (v >> (8*i)) & 0xff;
+}
+
+/** \brief read 4 little-endian bytes at p. */
+static unsigned int unpack ( const unsigned char* p ) {
+    return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+/** \brief append a little-endian 32-bit int to the request. */
+void SamWorker::putInt ( int v ) {
+    unsigned char b[4];
+    pack( b, (unsigned int)v );
+    mRequest.insert( mRequest.end(), b, b+4 );
+}
+
+/** \brief append a string (length, then utf-8 bytes) to the request. */
+void SamWorker::putString ( const wxString& s ) {
+    wxScopedCharBuffer b = s.utf8_str();
+    putInt( (int)b.length() );
+    mRequest.insert( mRequest.end(), b.data(), b.data()+b.length() );
+}
+
+/** \brief read exactly n bytes from the worker. */
+bool SamWorker::readFully ( void* buff, size_t n ) {
+    auto in = mProcess->GetInputStream();
+    auto p = (char*)buff;
+    while (n > 0) {
+        in->Read( p, n );
+        size_t got = in->LastRead();
+        if (got == 0)    return false;  //worker exited
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+
+/** \brief pass on whatever the worker has written to stderr. */
+void SamWorker::drainErrors ( ) {
+    if (mProcess == nullptr || mProcess->GetErrorStream() == nullptr)    return;
+    wxTextInputStream tis( *mProcess->GetErrorStream() );
+    while (mProcess->IsErrorAvailable()) {
+        wxString ln = tis.ReadLine();
+        wxLogMessage( ln );
+        cout << ln << endl;
+    }
+}
+
+/**
+ * \brief send the request built in mRequest and wait for the reply, whose
+ * payload is left in mReply.
+ * @param command is the request.
+ * @return the status of the reply, or -1 if the worker failed (and has
+ * been stopped).
+ */
+int SamWorker::transact ( int command ) {
+    if (!isRunning())    return -1;
+    unsigned char h[8];
+    pack( h, command );
+    pack( h+4, (unsigned int)mRequest.size() );
+    auto out = mProcess->GetOutputStream();
+    out->Write( h, sizeof h );
+    bool ok = out->LastWrite() == sizeof h;
+    if (ok && !mRequest.empty()) {
+        out->Write( mRequest.data(), mRequest.size() );
+        ok = out->LastWrite() == mRequest.size();
+    }
+    mRequest.clear();
+    unsigned char r[8];
+    if (ok)    ok = readFully( r, sizeof r );
+    if (ok) {
+        mReply.resize( unpack(r+4) );
+        ok = mReply.empty() || readFully( mReply.data(), mReply.size() );
+    }
+    drainErrors();
+    if (!ok) {
+        wxLogMessage( "sam_worker failed" );
+        stop();
+        return -1;
+    }
+    return (int)unpack( r );
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief have the worker load a model (starting the worker if necessary).
+ * nothing is done if the worker already has this model on this device,
+ * and a model that failed to load isn't tried again.
+ * @param checkpoint is the model file.
+ * @param device is cpu, cuda, or mps.
+ * @return true if the worker has the model; false otherwise.
+ */
+bool SamWorker::load ( const wxString& checkpoint, const wxString& device ) {
+    //don't start python again just to fail again
+    if (checkpoint + "\n" + device == mFailed)    return false;
+    if (!start()) {
+        mFailed = checkpoint + "\n" + device;
+        return false;
+    }
+    if (checkpoint == mCheckpoint && device == mDevice)    return true;
+    putString( checkpoint );
+    putString( device );
+    if (transact( LOAD ) != OK) {
+        mFailed = checkpoint + "\n" + device;
+        return false;
+    }
+    mCheckpoint = checkpoint;
+    mDevice = device;
+    return true;
+}
+
+/** \brief does the worker have this slice (so it needn't be sent again)? */
+bool SamWorker::has ( const wxString& scene, int slice ) {
+    putString( scene );
+    putInt( slice );
+    return transact( HAS ) == OK && mReply.size() == 1 && mReply[0] == 1;
+}
+
+/**
+ * \brief send a slice to the worker.
+ * @param prefetch is true to have the worker compute the image embedding
+ * in the background (for a slice that is likely to be used next).
+ */
+bool SamWorker::sendSlice ( const wxString& scene, int slice, int width,
+                            int height, const unsigned short* data,
+                            bool prefetch )
+{
+    putString( scene );
+    putInt( slice );
+    putInt( prefetch ? 1 : 0 );
+    putInt( width );
+    putInt( height );
+    size_t at = mRequest.size();
+    mRequest.resize( at + 2*(size_t)width*height );
+    for (size_t i=0; i<(size_t)width*height; i++) {
+        mRequest[at++] = data[i] & 0xff;
+        mRequest[at++] = data[i] >> 8;
+    }
+    return transact( IMAGE ) == OK;
+}
+
+/**
+ * \brief segment the object in a box on a slice that has been sent.
+ * @param x0, y0, x1, y1 are the corners of the box.
+ * @param width, height are the size of the slice.
+ * @param mask receives width*height values: 1 in the object, 0 elsewhere.
+ * @return true if successful; false otherwise.
+ */
+bool SamWorker::segment ( const wxString& scene, int slice,
+                          int x0, int y0, int x1, int y1,
+                          int width, int height, unsigned char* mask )
+{
+    putString( scene );
+    putInt( slice );
+    putInt( x0 );
+    putInt( y0 );
+    putInt( x1 );
+    putInt( y1 );
+    if (transact( SEGMENT ) != OK)    return false;
+    size_t n = (size_t)width*height;
+    if (mReply.size() != 8+n)    return false;
+    memcpy( mask, mReply.data()+8, n );
+    return true;
+}
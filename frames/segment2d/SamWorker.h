@@ -0,0 +1,53 @@
+#pragma once
+
+#include <wx/process.h>
+#include <wx/string.h>
+#include <vector>
+
+/**
+ * \brief client of the persistent MedSAM/SAM worker (ml/sam_worker.py).
+ * the worker is started once (the first time it's needed) and keeps the
+ * model loaded and the image embeddings of recently used slices, so that a
+ * box prompt on a slice that the worker already has only runs the prompt
+ * encoder and mask decoder. requests and replies are binary and are sent
+ * over the worker's stdin and stdout; see sam_worker.py for the protocol.
+ *
+ * there is one worker per cavass process (see get()). it exits when cavass
+ * does (because its stdin is then closed).
+ */
+class SamWorker {
+    friend class SamWorkerProcess;
+
+    enum { LOAD = 1, HAS, IMAGE, SEGMENT, QUIT };          ///< commands
+    enum { OK = 0, FAILED, UNKNOWN_SLICE, BAD_REQUEST };   ///< reply status
+
+    wxProcess*     mProcess = nullptr;  ///< the worker (nullptr if not running)
+    long           mPid     = 0;        ///< its process id
+    wxString       mCheckpoint;         ///< model file loaded by the worker
+    wxString       mDevice;             ///< device used by the worker
+    wxString       mFailed;             ///< checkpoint and device that failed to load
+
+    std::vector<unsigned char>  mRequest;  ///< request being built
+    std::vector<unsigned char>  mReply;    ///< payload of last reply
+
+    SamWorker ( ) { }
+    bool start ( );
+    void stop ( );
+    void putInt ( int v );
+    void putString ( const wxString& s );
+    int  transact ( int command );
+    bool readFully ( void* buff, size_t n );
+    void drainErrors ( );
+public:
+    static SamWorker* get ( );
+    ~SamWorker ( );
+
+    bool isRunning ( ) const;
+    bool load ( const wxString& checkpoint, const wxString& device );
+    bool has ( const wxString& scene, int slice );
+    bool sendSlice ( const wxString& scene, int slice, int width, int height,
+                     const unsigned short* data, bool prefetch );
+    bool segment ( const wxString& scene, int slice,
+                   int x0, int y0, int x1, int y1,
+                   int width, int height, unsigned char* mask );
+};
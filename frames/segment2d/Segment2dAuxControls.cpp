@@ -90,7 +90,7 @@ Segment2dAuxControls::Segment2dAuxControls ( Segment2dFrame* frame,
 Segment2dAuxControls::Segment2dAuxControls ( Segment2dFrame* frame,
     wxPanel* cp, wxSizer* bottomSizer,
     const char* const title, int currentIterates, double currentAlpha,
-    double currentBeta, double currentGamma )
+    double currentBeta, double currentGamma, bool currentSemiImplicit )
     : mFrame( frame )
 {
     init();
@@ -156,6 +156,14 @@ Segment2dAuxControls::Segment2dAuxControls ( Segment2dFrame* frame,
                                 wxDefaultPosition, wxSize(150,-1), wxTE_RIGHT );
     ::setColor(mGammaCtrl);
     mFgs->Add( mGammaCtrl, 0, wxALL|wxEXPAND, 5 );
+    //row 4, col 0
+    mFgs->AddSpacer( 0 );
+    //row 4, col 1
+    mSemiImplicit = new wxCheckBox( mAuxSizer->GetStaticBox(), Segment2dFrame::ID_SEMI_IMPLICIT,
+                                    "semi-implicit", wxDefaultPosition, wxDefaultSize, 0 );
+    ::setColor( mSemiImplicit );
+    mSemiImplicit->SetValue( currentSemiImplicit );
+    mFgs->Add( mSemiImplicit, 0, wxALIGN_CENTER_VERTICAL|wxALL|wxEXPAND, 5 );
 
     mAuxSizer->Add( mFgs, 0, 0, 0 );
     mAuxSizer->Add( 20, 0, 1, wxGROW|wxALL );  //spacer on right
@@ -207,6 +215,12 @@ Segment2dAuxControls::Segment2dAuxControls ( Segment2dFrame* frame,
     ::setColor(mGammaCtrl);
     mFgsButton->Add(mGammaCtrl, 0,
                     wxALIGN_CENTER_HORIZONTAL | wxALIGN_CENTER_VERTICAL, 0);
+    mSemiImplicit = new wxCheckBox(cp, Segment2dFrame::ID_SEMI_IMPLICIT,
+                                   "semi-implicit");
+    ::setColor(mSemiImplicit);
+    mSemiImplicit->SetValue(currentSemiImplicit);
+    mFgsButton->Add(mSemiImplicit, 0,
+                    wxALIGN_CENTER_HORIZONTAL | wxALIGN_CENTER_VERTICAL, 0);
     display_fgs();
 #endif
 }
@@ -540,6 +554,12 @@ Segment2dAuxControls::~Segment2dAuxControls ( ) {
         delete mTransform;
         mTransform = nullptr;
     }
+    if (mSemiImplicit) {
+        if (mFgsButton != nullptr)    mFgsButton->Detach(mSemiImplicit);
+        else                          mFgs->Detach(mSemiImplicit);
+        delete mSemiImplicit;
+        mSemiImplicit = nullptr;
+    }
     if (mGammaCtrl) {
         if (mFgsButton != nullptr)    mFgsButton->Detach(mGammaCtrl);
         else                          mFgs->Detach(mGammaCtrl);
@@ -694,6 +714,7 @@ void Segment2dAuxControls::init ( ) {
     mIterates = nullptr;
     mMean = nullptr;
     mMinPointsCtrl = nullptr;
+    mSemiImplicit = nullptr;
     mSt1 = nullptr;
     mSt2 = nullptr;
     mSt3 = nullptr;
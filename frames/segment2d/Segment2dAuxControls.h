@@ -32,6 +32,7 @@ class Segment2dAuxControls {
 	wxTextCtrl       *mAlphaCtrl;
 	wxTextCtrl       *mBetaCtrl;
 	wxTextCtrl       *mGammaCtrl;
+	wxCheckBox       *mSemiImplicit;
 	Segment2dSlider  *mWeight;
 	Segment2dSlider  *mMean;
 	Segment2dSlider  *mStdDev;
@@ -59,7 +60,8 @@ public:
     /** live snake controls */
 	Segment2dAuxControls ( Segment2dFrame* frame, wxPanel* cp, wxSizer* bottomSizer,
 		const char* title, int currentIterates,
-		double currentAlpha, double currentBeta, double currentGamma );
+		double currentAlpha, double currentBeta, double currentGamma,
+		bool currentSemiImplicit );
 
     /** feature controls */
 	Segment2dAuxControls ( Segment2dFrame* frame, wxPanel* cp, wxSizer* bottomSizer,
@@ -34,6 +34,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include  "cavass.h"
 #include  "Segment2dFrame.h"
 #include  "Segment2dIntDLControls.h"
+#include  "SnakeEngine.h"
 
 #define QueueItem X_Point
 #define HandleQueueError {fprintf(stderr,"Out of memory.\n");exit(1);}
@@ -205,7 +206,8 @@ void Segment2dCanvas::init ( ) {
 	lsnake_alpha     = 0.1;
 	lsnake_beta      = 0.2;
 	lsnake_gamma     = -0.5;
-	Gradient         = NULL;
+	lsnake_semi_implicit = false;
+	snake_engine     = NULL;
 	ControlPoint     = NULL;
 	curr_feature     = 5;
 	switch_images_flag = false;
@@ -361,6 +363,9 @@ void Segment2dCanvas::release ( void ) {
 	if (ControlPoint)
 		free(ControlPoint);
 	ControlPoint = NULL;
+	if (snake_engine)
+		delete snake_engine;
+	snake_engine = NULL;
 	ResetPeekPoints();
     init();
 }
@@ -3720,25 +3725,33 @@ void Segment2dCanvas::add_anchor_point(int x, int y, OPEN_CONTOUR *cont)
  * ENTRY CONDITIONS: o_contour, circular, dp_anchor_point, dp_anchor_points
  *    must be valid.  Entry conditions of Is_Point_Selected_Valid,
  *    FindShortestPath, Live_Wire, Point_Selected, UpdateCircular must be met.
- *    Image size must not chenage between calls.
  * RETURN VALUE: None
  * EXIT CONDITIONS: memory allocation failures ignored
  * HISTORY:
  *    Created: 6/30/05 by Dewey Odhner.
  *    Modified: 12/2/05 bounds check corrected by Dewey Odhner.
+ *    Modified: 10/19/26 optionally (lsnake_semi_implicit) force fields
+ *       precomputed and cached, and the snake evolved semi-implicitly, by
+ *       SnakeEngine; the greedy SnakeDeformation remains the default.
  *****************************************************************************/
 int Segment2dCanvas::iterate_live_snake(IMAGE *timg, int ilw_iterations,
 	double alpha, double beta, double gamma)
 {
-	int j, k, tmp_anchor_points, tt;
+	int j, k, tmp_anchor_points, tt, iterations;
 	X_Point pt;
-	unsigned char *data8;
-	unsigned short *data16;
 
 	if (dp_anchor_points < 2)
 		return 0;
-	if (Gradient == NULL)
+	if (allocControlPoints())
+		return 1;
+	tmp_anchor_points = dp_anchor_points;
+	iterations = ilw_iterations<6? ilw_iterations: (ilw_iterations-4)*5;
+	if (!lsnake_semi_implicit)
 	{
+		unsigned char *data8;
+		unsigned short *data16;
+		double **Gradient;
+
 		Gradient = (double **)malloc(timg->height*sizeof(double *));
 		if (Gradient == NULL)
 			return 1;
@@ -3746,95 +3759,140 @@ int Segment2dCanvas::iterate_live_snake(IMAGE *timg, int ilw_iterations,
 		if (Gradient[0] == NULL)
 		{
 			free(Gradient);
-			Gradient = NULL;
 			return 1;
 		}
 		for (k=1; k<timg->height; k++)
 			Gradient[k] = Gradient[k-1]+timg->width;
-	}
-	if (allocControlPoints())
-		return 1;
-	tmp_anchor_points = dp_anchor_points;
 
-	/* compute gradient image */
-	data8 = (unsigned char *)mCavassData->getSlice(mCavassData->m_sliceNo);
-	data16 = (unsigned short *)mCavassData->getSlice(mCavassData->m_sliceNo);
-	for (k=0; k<timg->height; k++)
-		for (j=0; j<timg->width; j++)
-		{	double weight[2];
-			int lf, rt, up, dn, sh;
+		/* compute gradient image */
+		data8 = (unsigned char *)mCavassData->getSlice(mCavassData->m_sliceNo);
+		data16 = (unsigned short *)mCavassData->getSlice(mCavassData->m_sliceNo);
+		for (k=0; k<timg->height; k++)
+			for (j=0; j<timg->width; j++)
+			{	double weight[2];
+				int lf, rt, up, dn, sh;
 
-			sh = k*timg->width;
-			if (k == 0)
-			{
-				weight[0] = 1/4.;
-				weight[1] = 1/3.;
-				up = sh;
-				dn = sh+timg->width;
-			}
-			else if (k == timg->height-1)
-			{
-				weight[0] = 1/4.;
-				weight[1] = 1/3.;
-				up = sh-timg->width;
-				dn = sh;
-			}
-			else
-			{
-				weight[0] = 1/6.,
-				weight[1] = 1/6.;
-				up = sh-timg->width;
-				dn = sh+timg->width;
-			}
-			if (j == 0)
-			{
-				weight[0] *= 2;
-				weight[1] *= 1.5;
-				lf = j;
-				rt = j+1;
-			}
-			else if (j == timg->width-1)
-			{
-				weight[0] *= 2;
-				weight[1] *= 1.5;
-				lf = j-1;
-				rt = j;
-			}
-			else
-			{
-				lf = j-1;
-				rt = j+1;
-			}
-			if (timg->bits > 8)
-			{
-				weight[0] *=
-					 (int)data16[up+rt]+data16[sh+rt]+data16[dn+rt]-
-					((int)data16[up+lf]+data16[sh+lf]+data16[dn+lf]);
-				weight[1] *=
-					 (int)data16[dn+lf]+data16[dn+ j]+data16[dn+rt]-
-					((int)data16[up+lf]+data16[up+ j]+data16[up+rt]);
-			}
-			else
-			{
-				weight[0] *=
-				     (int)data8[up+rt]+data8[sh+rt]+data8[dn+rt]-
-				    ((int)data8[up+lf]+data8[sh+lf]+data8[dn+lf]);
-				weight[1] *=
-				     (int)data8[dn+lf]+data8[dn+ j]+data8[dn+rt]-
-				    ((int)data8[up+lf]+data8[up+ j]+data8[up+rt]);
+				sh = k*timg->width;
+				if (k == 0)
+				{
+					weight[0] = 1/4.;
+					weight[1] = 1/3.;
+					up = sh;
+					dn = sh+timg->width;
+				}
+				else if (k == timg->height-1)
+				{
+					weight[0] = 1/4.;
+					weight[1] = 1/3.;
+					up = sh-timg->width;
+					dn = sh;
+				}
+				else
+				{
+					weight[0] = 1/6.,
+					weight[1] = 1/6.;
+					up = sh-timg->width;
+					dn = sh+timg->width;
+				}
+				if (j == 0)
+				{
+					weight[0] *= 2;
+					weight[1] *= 1.5;
+					lf = j;
+					rt = j+1;
+				}
+				else if (j == timg->width-1)
+				{
+					weight[0] *= 2;
+					weight[1] *= 1.5;
+					lf = j-1;
+					rt = j;
+				}
+				else
+				{
+					lf = j-1;
+					rt = j+1;
+				}
+				if (timg->bits > 8)
+				{
+					weight[0] *=
+						 (int)data16[up+rt]+data16[sh+rt]+data16[dn+rt]-
+						((int)data16[up+lf]+data16[sh+lf]+data16[dn+lf]);
+					weight[1] *=
+						 (int)data16[dn+lf]+data16[dn+ j]+data16[dn+rt]-
+						((int)data16[up+lf]+data16[up+ j]+data16[up+rt]);
+				}
+				else
+				{
+					weight[0] *=
+					     (int)data8[up+rt]+data8[sh+rt]+data8[dn+rt]-
+					    ((int)data8[up+lf]+data8[sh+lf]+data8[dn+lf]);
+					weight[1] *=
+					     (int)data8[dn+lf]+data8[dn+ j]+data8[dn+rt]-
+					    ((int)data8[up+lf]+data8[up+ j]+data8[up+rt]);
+				}
+				Gradient[k][j] = sqrt(weight[0]*weight[0]+weight[1]*weight[1]);
 			}
-			Gradient[k][j] = sqrt(weight[0]*weight[0]+weight[1]*weight[1]);
-		}
 
-	for (j=0; j<tmp_anchor_points; j++)
+		for (j=0; j<tmp_anchor_points; j++)
+		{
+			ControlPoint[j].x = dp_anchor_point[j][0];
+			ControlPoint[j].y = dp_anchor_point[j][1];
+		}
+		ControlPoint[j] = ControlPoint[0];
+		SnakeDeformation(Gradient, tmp_anchor_points, ControlPoint,
+			alpha, beta, gamma, timg->height, timg->width, iterations);
+		free(Gradient[0]);
+		free(Gradient);
+	}
+	else
 	{
-		ControlPoint[j].x = dp_anchor_point[j][0];
-		ControlPoint[j].y = dp_anchor_point[j][1];
+		SnakeEngine::Snake snake;
+		SnakeEngine::Parameters parameters;
+
+		if (snake_engine && (snake_engine->getWidth()!=timg->width ||
+				snake_engine->getHeight()!=timg->height))
+		{
+			delete snake_engine;
+			snake_engine = NULL;
+		}
+		if (snake_engine == NULL)
+			snake_engine = new SnakeEngine(timg->width, timg->height);
+
+		/* force field of this slice, and (in the background) of the slices
+		   next to it, to which the contour is likely to be propagated */
+		snake.slice = mCavassData->m_sliceNo;
+		for (k=0; k<3; k++)
+		{
+			int z = snake.slice+(k==0? 0: k==1? -1: 1);
+			void *data;
+
+			if (z<0 || z>=mCavassData->m_zSize || snake_engine->hasSlice(z))
+				continue;
+			data = mCavassData->getSlice(z);
+			if (data)
+				snake_engine->setSlice(z, data, timg->bits);
+		}
+		/* reload it if a neighbor replaced it */
+		mCavassData->getSlice(snake.slice);
+
+		for (j=0; j<tmp_anchor_points; j++)
+		{
+			snake.x.push_back(dp_anchor_point[j][0]);
+			snake.y.push_back(dp_anchor_point[j][1]);
+		}
+		parameters.tensile = alpha;
+		parameters.flexural = beta;
+		parameters.external = -gamma;
+		parameters.iterations = iterations;
+		snake_engine->evolve(snake, parameters);
+		for (j=0; j<tmp_anchor_points; j++)
+		{
+			ControlPoint[j].x = snake.x[j];
+			ControlPoint[j].y = snake.y[j];
+		}
+		ControlPoint[j] = ControlPoint[0];
 	}
-	ControlPoint[j] = ControlPoint[0];
-	SnakeDeformation(Gradient, tmp_anchor_points, ControlPoint,
-		alpha, beta, gamma, timg->height, timg->width,
-		ilw_iterations<6? ilw_iterations: (ilw_iterations-4)*5);
 
 	NumPoints=0;
 	o_contour.last = -1;
@@ -181,6 +181,8 @@ typedef struct {
 extern const unsigned char onbit[9];
 extern const unsigned char offbit[9];
 
+class SnakeEngine;
+
 /** \brief the canvas on which images and other things are drawn (i.e., 
  *  the drawing area of the window).
  *
@@ -278,7 +280,8 @@ public:
 	int overlay_intensity;
 	int ilw_min_pts;
 	double lsnake_alpha, lsnake_beta, lsnake_gamma;
-	double **Gradient;
+	bool lsnake_semi_implicit; /* evolve live snakes by snake_engine */
+	SnakeEngine *snake_engine; /* force fields and evolution of live snakes */
 	CPoint *ControlPoint;
 	int train_brush_size, paint_brush_size;
     int               mRows, mCols;      ///< rows/cols of displayed images
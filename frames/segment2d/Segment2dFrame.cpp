@@ -1478,7 +1478,8 @@ void Segment2dFrame::doMode ( const wxString& e_GetString ) {
         case Segment2dCanvas::LSNAKE:
             mAuxControls = new Segment2dAuxControls( this, mControlPanel,
                                                      mBottomSizer, "LiveSnake Controls", canvas->ilw_iterations,
-                                                     canvas->lsnake_alpha,canvas->lsnake_beta,canvas->lsnake_gamma );
+                                                     canvas->lsnake_alpha,canvas->lsnake_beta,canvas->lsnake_gamma,
+                                                     canvas->lsnake_semi_implicit );
             mAuxControls->restoreAuxControls();
             break;
         case Segment2dCanvas::SEL_FEATURES:
@@ -1757,6 +1758,17 @@ void Segment2dFrame::doGamma ( const wxString& e_GetString ) {
     //    auto canvas = dynamic_cast<Segment2dCanvas*>( mCanvas );
     //    sscanf( (const char*)e_GetString.c_str(), "%lf", &canvas->lsnake_gamma );
 }
+
+void Segment2dFrame::OnSemiImplicit ( wxCommandEvent& e ) {
+    doSemiImplicit( e.IsChecked() );
+}
+/** choose between the greedy (default) and semi-implicit live snake */
+void Segment2dFrame::doSemiImplicit ( bool isChecked ) {
+    auto canvas = dynamic_cast<Segment2dCanvas*>( mCanvas );
+    canvas->lsnake_semi_implicit = isChecked;
+    //set checkbox appropriately (not necessary when call in response to an event, only for persistence)
+    mAuxControls->mSemiImplicit->SetValue( isChecked );
+}
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Segment2dFrame::OnFeature ( wxCommandEvent& e ) {
     doFeature( e.GetString() );
@@ -2097,6 +2109,7 @@ BEGIN_EVENT_TABLE       ( Segment2dFrame, wxFrame )
   EVT_TEXT(   ID_ALPHA,            Segment2dFrame::OnAlpha      )
   EVT_TEXT(   ID_BETA,             Segment2dFrame::OnBeta       )
   EVT_TEXT(   ID_GAMMA,            Segment2dFrame::OnGamma      )
+  EVT_CHECKBOX( ID_SEMI_IMPLICIT,  Segment2dFrame::OnSemiImplicit)
   EVT_COMBOBOX( ID_FEATURE,        Segment2dFrame::OnFeature    )
   EVT_CHECKBOX( ID_FEATURE_STATUS, Segment2dFrame::OnFeatureStatus)
   EVT_COMBOBOX( ID_TRANSFORM,      Segment2dFrame::OnTransform  )
@@ -133,6 +133,7 @@ class Segment2dFrame : public MainFrame {
     void doObject      ( const wxString& e_GetString );
     void doOverlay     ( bool isChecked );  //used by Set Index
     void doOutputType  ( const wxString& type );  //used by Set Output
+    void doSemiImplicit( bool isChecked );
 
     void doFeature       ( const wxString& e_GetString );
     void doTransform     ( const wxString& e_GetString );
@@ -173,6 +174,7 @@ public:
 		ID_FEATURE_DISPLAY, ID_FEATURE, ID_FEATURE_STATUS,
 		ID_TRANSFORM, ID_TRANSFORM_SELECT, ID_FEATURE_UPDATE,
 		ID_MIN_POINTS, ID_ALPHA, ID_BETA, ID_GAMMA,
+		ID_SEMI_IMPLICIT,
 		ID_WEIGHT, ID_MEAN, ID_STD_DEV, ID_FEATURE_MIN, ID_FEATURE_MAX,
         /** for interactive deep learning: */
     	ID_INTDL_ADD, ID_INTDL_BLINK, ID_INTDL_CHOOSE, ID_INTDL_CLEAR, ID_INTDL_RUN
@@ -286,6 +288,7 @@ public:
 	void OnAlpha        ( wxCommandEvent& e );
 	void OnBeta         ( wxCommandEvent& e );
 	void OnGamma        ( wxCommandEvent& e );
+	void OnSemiImplicit ( wxCommandEvent& e );
 
 	void OnWeight       ( wxScrollEvent& unused );
 	void OnMean         ( wxScrollEvent& unused );
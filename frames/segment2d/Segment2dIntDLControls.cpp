@@ -6,12 +6,16 @@
 #include "cavass.h"
 #include "Segment2dIntDLControls.h"
 #include "PersistentSegment2dFrame.h"
+#include "SamWorker.h"
 
 #ifndef WIN32
 #define VERBOSE        cout << __PRETTY_FUNCTION__  << endl
 #else
 #define VERBOSE        /*this space intentionally left blank*/
 #endif
+
+/** slices on each side of the current one sent to the worker for embedding in the background */
+static const int PrefetchSlices = 2;
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 /**
  * \brief ctor (obviously).
@@ -197,11 +201,16 @@ void Segment2dIntDLControls::loadModel ( wxString& fn ) {
 #if 1
     /**
      * send request to server to load model file.
-     * if unsuccessful, then return (w/out changing current model, if any).
-     * otherwise, update model info (as per below).
+     * if unsuccessful, inference.py (which loads the model itself each
+     * time) will be used instead.
      */
-
-    /** \todo send request to server to load model file. */
+    mFr->SetStatusText( "loading ...", 0 );
+    wxSetCursor( wxCursor(wxCURSOR_WAIT) );
+    wxYield();
+    if (!SamWorker::get()->load( fn, getDevice() )) {
+        wxLogMessage( "sam_worker unavailable; using inference.py" );
+    }
+    wxSetCursor( *wxSTANDARD_CURSOR );
 
     //update model info after successful load
     mFullFileNameStr = fn;
@@ -319,6 +328,93 @@ void Segment2dIntDLControls::saveCurrentSlice ( bool ascii ) {
     fp = nullptr;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief copy a slice of the data (for the worker).
+ * @param z is the slice number.
+ * @return the slice (to be deleted[] by the caller).
+ */
+unsigned short* Segment2dIntDLControls::getSlice ( int z ) {
+    int rows = mFr->mCanvas->mCavassData->m_ySize;
+    int cols = mFr->mCanvas->mCavassData->m_xSize;
+    auto slice = new unsigned short[ rows*cols ];
+    for (int y=0,i=0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            slice[i++] = mFr->mCanvas->mCavassData->getData(x, y, z);
+        }
+    }
+    return slice;
+}
+
+/** \brief the device (cpu, or the gpu if use GPU is checked) for inference. */
+wxString Segment2dIntDLControls::getDevice ( ) {
+    wxString device = "cpu";  //default
+#if defined(__APPLE__) || defined(__MACH__)
+    if (mUseGPU->IsChecked())    device = "mps";
+#else
+    if (mUseGPU->IsChecked())    device = "cuda";
+#endif
+    return device;
+}
+
+/**
+ * \brief name of the data for the worker's cache of slices. the address of
+ * the data is included because a file may be loaded more than once.
+ */
+wxString Segment2dIntDLControls::getScene ( ) {
+    auto d = mFr->mCanvas->mCavassData;
+    return wxString::Format( "%s@%p", d->m_fname != nullptr ? d->m_fname : "", (void*)d );
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief segment via the persistent worker (see SamWorker). the current
+ * slice is sent only if the worker doesn't already have it (with its image
+ * embedding), and the neighboring slices are then sent so that the worker
+ * can embed them in the background.
+ * @return true if mAlpha, etc. now hold the result; false if the worker
+ * isn't available (so inference.py should be used instead).
+ */
+bool Segment2dIntDLControls::runWorker ( int left, int top, int right, int bottom ) {
+    VERBOSE;
+    auto worker = SamWorker::get();
+    if (!worker->load( mFullFileNameStr, getDevice() ))    return false;
+
+    int rows  = mFr->mCanvas->mCavassData->m_ySize;
+    int cols  = mFr->mCanvas->mCavassData->m_xSize;
+    int z     = mFr->mCanvas->mCavassData->m_sliceNo;
+    int nz    = mFr->mCanvas->mCavassData->m_zSize;
+    wxString scene = getScene();
+    if (!worker->has( scene, z )) {
+        auto slice = getSlice( z );
+        bool ok = worker->sendSlice( scene, z, cols, rows, slice, false );
+        delete[] slice;
+        if (!ok)    return false;
+    }
+
+    if (mResult) { delete mResult;  mResult = nullptr; }
+    if (mBitmap) { delete mBitmap;  mBitmap = nullptr; }
+    if (mAlpha ) { delete mAlpha;   mAlpha  = nullptr; }
+    mHeight = rows;
+    mWidth  = cols;
+    mAlpha  = new unsigned char[ mWidth * mHeight ];  //_not_ automatically deleted; deleted in dtor
+    if (!worker->segment( scene, z, left, top, right, bottom, cols, rows, mAlpha )) {
+        delete mAlpha;
+        mAlpha = nullptr;
+        return false;
+    }
+    setResult();
+
+    //nearest first
+    for (int d=1; d<=PrefetchSlices; d++) {
+        for (int zz : { z+d, z-d }) {
+            if (zz < 0 || zz >= nz || worker->has( scene, zz ))    continue;
+            auto slice = getSlice( zz );
+            worker->sendSlice( scene, zz, cols, rows, slice, true );
+            delete[] slice;
+        }
+    }
+    return true;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 /** called when Add button is pressed */
 void Segment2dIntDLControls::doAdd ( ) {
     VERBOSE;
@@ -432,10 +528,6 @@ void Segment2dIntDLControls::doRun ( ) {
         }
     }
 
-    //save current slice to temp file in PGM P2 (grey, ASCII) format
-    /** \todo avoid doing this more than once per a specific slice */
-    saveCurrentSlice();
-
     //determine top-left of rect
     int top  = (mdy1 <= mdy2) ? mdy1 : mdy2;
     int left = (mdx1 <= mdx2) ? mdx1 : mdx2;
@@ -448,6 +540,22 @@ void Segment2dIntDLControls::doRun ( ) {
     int bottom = top + h;
     int right = left + w;
 
+    mFr->SetStatusText( "running ...", 0 );
+    wxSetCursor( wxCursor(wxCURSOR_WAIT) );
+    wxYield();
+    if (runWorker( left, top, right, bottom )) {
+        mFr->SetStatusText( "done", 0 );
+        wxSetCursor( *wxSTANDARD_CURSOR );
+        mShow = true;
+        mFr->mCanvas->Refresh();  //cause repaint
+        setButtonState();
+        return;
+    }
+
+    //otherwise, run inference.py (which loads the model each time).
+    //save current slice to temp file in PGM P2 (grey, ASCII) format.
+    saveCurrentSlice();
+
     //inference.py is assumed to be in the cavass build directory (which is
     // assumed to be in path). if it isn't in path, something like the
     // following may be used instead:
@@ -456,12 +564,7 @@ void Segment2dIntDLControls::doRun ( ) {
 
     wxString sep = wxFileName::GetPathSeparator();
 
-    wxString device = "cpu";  //default
-#if defined(__APPLE__) || defined(__MACH__)
-    if (mUseGPU->IsChecked())    device = "mps";
-#else
-    if (mUseGPU->IsChecked())    device = "cuda";
-#endif
+    wxString device = getDevice();
 
 #ifdef WIN32
     wxString path = "python " + Preferences::getHome() + sep;
@@ -590,6 +693,14 @@ void Segment2dIntDLControls::loadResult ( ) {
     fread( mAlpha, mWidth*mHeight, 1, fp );    //rest of file is data as binary uchars
     fclose( fp );
     fp = nullptr;
+    setResult();
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief make the rgb values, alpha and bitmap from the binary result of
+ * seg (0 or not) in mAlpha.
+ */
+void Segment2dIntDLControls::setResult ( ) {
     //convert the binary result of seg to rgb and alpha values
     mResult = new unsigned char[ mWidth * mHeight * 3 ];  //rgb data
     for (int i=0,j=0; i<mWidth*mHeight; i++) {
@@ -56,8 +56,13 @@ class Segment2dIntDLControls {
     double            mScale  = -1;          ///< image scale factor (to keep track of changes)
 
     void saveCurrentSlice ( bool ascii = true );
+    unsigned short* getSlice ( int z );
+    wxString getDevice ( );
+    wxString getScene ( );
     void loadModel ( wxString& fn );
     void loadResult ( );
+    void setResult ( );
+    bool runWorker ( int left, int top, int right, int bottom );
     void reset ( );
     void setButtonState ( );
 public:
@@ -0,0 +1,421 @@
+#include "SnakeEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static const double  Spacing    = 2.0;  ///< of the samples of a contour (pixels)
+static const int     MinSamples = 8;    ///< of a (small) contour
+static const double  GvfMu      = 0.2;  ///< gvf smoothness (<= 1/4 for stability)
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief the cholesky factor, L, of the n x n (n >= 5) symmetric cyclic
+ * pentadiagonal matrix with c0 on the diagonal, c1 one off it, and c2 two
+ * off it. rows 0..n-3 of L are banded (as the matrix is); rows n-2 and n-1
+ * are dense because of the corners of the matrix. factoring and solving
+ * are O(n).
+ */
+class CyclicPentadiagonal {
+    int                  n;
+    std::vector<double>  d, l1, l2;  ///< L(i,i), L(i,i-1), L(i,i-2) (i < n-2)
+    std::vector<double>  r0, r1;     ///< rows n-2 and n-1 of L
+
+    /** \brief the first column of row i that may be nonzero. */
+    int first ( int i ) const { return (i <= n-3) ? std::max( 0, i-2 ) : 0; }
+
+    double L ( int i, int j ) const {
+        if (i == n-2)    return r0[j];
+        if (i == n-1)    return r1[j];
+        if (j == i)      return d[i];
+        if (j == i-1)    return l1[i];
+        if (j == i-2)    return l2[i];
+        return 0;
+    }
+
+    double& at ( int i, int j ) {
+        if (i == n-2)    return r0[j];
+        if (i == n-1)    return r1[j];
+        return (j == i) ? d[i] : (j == i-1) ? l1[i] : l2[i];
+    }
+
+public:
+    CyclicPentadiagonal ( int n, double c0, double c1, double c2 )
+        : n(n), d(n), l1(n), l2(n), r0(n), r1(n)
+    {
+        const double  c[3] = { c0, c1, c2 };
+        for (int i=0; i<n; i++) {
+            for (int j=first(i); j<=i; j++) {
+                const int  dist = std::min( i-j, n-i+j );   //cyclic
+                double  s = (dist < 3) ? c[dist] : 0;
+                for (int k=std::max( first(i), first(j) ); k<j; k++)
+                    s -= L(i,k) * L(j,k);
+                at(i,j) = (j == i) ? sqrt( s ) : s / L(j,j);
+            }
+        }
+    }
+
+    /** \brief solve for two right-hand sides (x and y) in place. */
+    void solve ( double* x, double* y ) const {
+        for (int i=0; i<n; i++) {
+            for (int k=first(i); k<i; k++) {
+                const double  l = L(i,k);
+                x[i] -= l * x[k];
+                y[i] -= l * y[k];
+            }
+            x[i] /= L(i,i);
+            y[i] /= L(i,i);
+        }
+        for (int i=n-1; i>=0; i--) {
+            for (int k=i+1; k<=std::min( i+2, n-3 ); k++) {
+                const double  l = L(k,i);
+                x[i] -= l * x[k];
+                y[i] -= l * y[k];
+            }
+            for (int k=std::max( i+1, n-2 ); k<n; k++) {
+                const double  l = L(k,i);
+                x[i] -= l * x[k];
+                y[i] -= l * y[k];
+            }
+            x[i] /= L(i,i);
+            y[i] /= L(i,i);
+        }
+    }
+};
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** \brief separable gaussian smoothing (replicating the border). */
+static void smooth ( std::vector<float>& a, int w, int h, double sigma ) {
+    const int  r = (int)ceil( 3*sigma );
+    std::vector<float>  k( 2*r+1 );
+    double  sum = 0;
+    for (int i=-r; i<=r; i++)    sum += k[i+r] = (float)exp( -i*i/(2*sigma*sigma) );
+    for (auto& v : k)    v = (float)(v / sum);
+
+    std::vector<float>  t( a.size() );
+    for (int y=0; y<h; y++) {
+        const float*  row = &a[(size_t)y*w];
+        for (int x=0; x<w; x++) {
+            float  s = 0;
+            for (int i=-r; i<=r; i++)
+                s += k[i+r] * row[std::min( std::max( x+i, 0 ), w-1 )];
+            t[(size_t)y*w+x] = s;
+        }
+    }
+    for (int y=0; y<h; y++) {
+        float*  row = &a[(size_t)y*w];
+        for (int x=0; x<w; x++)    row[x] = 0;
+        for (int i=-r; i<=r; i++) {
+            const float*  src = &t[(size_t)std::min( std::max( y+i, 0 ), h-1 )*w];
+            for (int x=0; x<w; x++)    row[x] += k[i+r] * src[x];
+        }
+    }
+}
+
+/** \brief central differences (one-sided at the border). */
+static void gradient ( const std::vector<float>& a, int w, int h,
+                       std::vector<float>& gx, std::vector<float>& gy )
+{
+    gx.resize( a.size() );
+    gy.resize( a.size() );
+    for (int y=0; y<h; y++) {
+        const int  up = std::max( y-1, 0 ), dn = std::min( y+1, h-1 );
+        const float  sy = (dn-up > 0) ? 1.0f/(dn-up) : 0;
+        for (int x=0; x<w; x++) {
+            const int  lf = std::max( x-1, 0 ), rt = std::min( x+1, w-1 );
+            const float  sx = (rt-lf > 0) ? 1.0f/(rt-lf) : 0;
+            const size_t  i = (size_t)y*w + x;
+            gx[i] = (a[(size_t)y*w+rt] - a[(size_t)y*w+lf]) * sx;
+            gy[i] = (a[(size_t)dn*w+x] - a[(size_t)up*w+x]) * sy;
+        }
+    }
+}
+
+/** \brief bilinear interpolation of a at (x,y) (which must be in the image). */
+static inline float sample ( const std::vector<float>& a, int w, int h,
+                             double x, double y )
+{
+    const int  x0 = std::min( (int)x, w-2 < 0 ? 0 : w-2 );
+    const int  y0 = std::min( (int)y, h-2 < 0 ? 0 : h-2 );
+    const int  x1 = std::min( x0+1, w-1 ), y1 = std::min( y0+1, h-1 );
+    const float  fx = (float)(x-x0), fy = (float)(y-y0);
+    const float  top = a[(size_t)y0*w+x0] + fx*(a[(size_t)y0*w+x1] - a[(size_t)y0*w+x0]);
+    const float  bot = a[(size_t)y1*w+x0] + fx*(a[(size_t)y1*w+x1] - a[(size_t)y1*w+x0]);
+    return top + fy*(bot - top);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief start the workers that compute force fields.
+ * @param width, height are the size of the slices.
+ * @param sigma is the standard deviation of the smoothing (pixels) done
+ * before the edge map is computed (0 for none).
+ * @param gvfIterations are the iterations of gradient vector flow used to
+ * extend the force away from edges (0 for none).
+ * @param threads is the number of workers (0 for one per core).
+ */
+SnakeEngine::SnakeEngine ( int width, int height, double sigma,
+                           int gvfIterations, int threads )
+    : mWidth(width), mHeight(height), mSigma(sigma),
+      mGvfIterations(gvfIterations)
+{
+    mThreads = (threads > 0) ? threads : (int)std::thread::hardware_concurrency();
+    if (mThreads < 1)    mThreads = 1;
+    for (int i=0; i<mThreads; i++)
+        mWorkers.emplace_back( &SnakeEngine::work, this );
+}
+
+SnakeEngine::~SnakeEngine ( ) {
+    {
+        std::lock_guard<std::mutex>  lk( mLock );
+        mStop = true;
+    }
+    mChanged.notify_all();
+    for (auto& t : mWorkers)    t.join();
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief have the force field of a slice computed in the background
+ * (unless it has been already). only the last few slices are kept.
+ * @param data are width*height cells.
+ * @param bits are the bits per cell: 8, or 16 if more than 8.
+ */
+void SnakeEngine::setSlice ( int slice, const void* data, int bits ) {
+    if (hasSlice( slice ))    return;
+    auto f = std::make_shared<Field>();
+    const size_t  n = (size_t)mWidth * mHeight;
+    f->image.resize( n );
+    if (bits > 8) {
+        auto p = (const unsigned short*)data;
+        for (size_t i=0; i<n; i++)    f->image[i] = p[i];
+    } else {
+        auto p = (const unsigned char*)data;
+        for (size_t i=0; i<n; i++)    f->image[i] = p[i];
+    }
+
+    {
+        std::lock_guard<std::mutex>  lk( mLock );
+        if (mFields.count( slice ))    return;
+        mFields[slice] = f;
+        mOrder.push_back( slice );
+        while ((int)mFields.size() > MaxSlices) {
+            mFields.erase( mOrder.front() );
+            mOrder.pop_front();
+        }
+        mQueue.push_back( slice );
+    }
+    mChanged.notify_all();
+}
+
+/** \brief has setSlice() been given this slice (and has it been kept)? */
+bool SnakeEngine::hasSlice ( int slice ) {
+    std::lock_guard<std::mutex>  lk( mLock );
+    return mFields.count( slice ) > 0;
+}
+
+/** \brief a worker: compute queued fields until told to stop. */
+void SnakeEngine::work ( ) {
+    for ( ; ; ) {
+        FieldPtr  f;
+        {
+            std::unique_lock<std::mutex>  lk( mLock );
+            mChanged.wait( lk, [this] { return mStop || !mQueue.empty(); } );
+            if (mStop)    return;
+            auto i = mFields.find( mQueue.front() );
+            mQueue.pop_front();
+            //forgotten, or taken by evolve() already?
+            if (i == mFields.end() || i->second->state != Field::QUEUED)
+                continue;
+            f = i->second;
+            f->state = Field::COMPUTING;
+        }
+        compute( *f );
+        {
+            std::lock_guard<std::mutex>  lk( mLock );
+            f->state = Field::READY;
+        }
+        mChanged.notify_all();
+    }
+}
+
+/**
+ * \brief the field of a slice, waiting for it to be computed (or computing
+ * it here if no worker has got to it yet).
+ * @return the field, or nullptr if the slice hasn't been set.
+ */
+SnakeEngine::FieldPtr SnakeEngine::field ( int slice ) {
+    std::unique_lock<std::mutex>  lk( mLock );
+    auto i = mFields.find( slice );
+    if (i == mFields.end())    return nullptr;
+    FieldPtr  f = i->second;
+    if (f->state == Field::QUEUED) {
+        f->state = Field::COMPUTING;
+        lk.unlock();
+        compute( *f );
+        lk.lock();
+        f->state = Field::READY;
+        mChanged.notify_all();
+    } else {
+        mChanged.wait( lk, [&f] { return f->state == Field::READY; } );
+    }
+    return f;
+}
+
+/**
+ * \brief compute the force field of a slice: the gradient of its edge map
+ * (the gradient magnitude of the smoothed slice, scaled to [0,1]),
+ * diffused by gvf if requested, and scaled so that the strongest force is
+ * 1 pixel per unit of time.
+ */
+void SnakeEngine::compute ( Field& f ) const {
+    const int  w = mWidth, h = mHeight;
+    std::vector<float>&  image = f.image;
+    if (mSigma > 0)    smooth( image, w, h, mSigma );
+
+    std::vector<float>  gx, gy;
+    gradient( image, w, h, gx, gy );
+    std::vector<float>().swap( image );
+    std::vector<float>  edge( gx.size() );
+    float  most = 0;
+    for (size_t i=0; i<edge.size(); i++) {
+        edge[i] = sqrt( gx[i]*gx[i] + gy[i]*gy[i] );
+        most = std::max( most, edge[i] );
+    }
+    if (most > 0)    for (auto& e : edge)    e /= most;
+    gradient( edge, w, h, f.fx, f.fy );
+
+    if (mGvfIterations > 0) {
+        //u' = u + mu lap(u) - (u - fx) |f|^2 (and likewise v)
+        std::vector<float>  b( edge.size() ), u = f.fx, v = f.fy;
+        for (size_t i=0; i<b.size(); i++)
+            b[i] = f.fx[i]*f.fx[i] + f.fy[i]*f.fy[i];
+        std::vector<float>  un( u.size() ), vn( v.size() );
+        for (int it=0; it<mGvfIterations; it++) {
+            for (int y=0; y<h; y++) {
+                const size_t  up = (size_t)std::max( y-1, 0 )*w;
+                const size_t  dn = (size_t)std::min( y+1, h-1 )*w;
+                const size_t  at = (size_t)y*w;
+                for (int x=0; x<w; x++) {
+                    const int  lf = std::max( x-1, 0 ), rt = std::min( x+1, w-1 );
+                    const size_t  i = at + x;
+                    const float  lu = u[at+lf] + u[at+rt] + u[up+x] + u[dn+x] - 4*u[i];
+                    const float  lv = v[at+lf] + v[at+rt] + v[up+x] + v[dn+x] - 4*v[i];
+                    un[i] = u[i] + (float)GvfMu*lu - b[i]*(u[i] - f.fx[i]);
+                    vn[i] = v[i] + (float)GvfMu*lv - b[i]*(v[i] - f.fy[i]);
+                }
+            }
+            u.swap( un );
+            v.swap( vn );
+        }
+        f.fx.swap( u );
+        f.fy.swap( v );
+    }
+
+    most = 0;
+    for (size_t i=0; i<f.fx.size(); i++)
+        most = std::max( most, f.fx[i]*f.fx[i] + f.fy[i]*f.fy[i] );
+    if (most > 0) {
+        const float  s = 1 / sqrt( most );
+        for (size_t i=0; i<f.fx.size(); i++) {
+            f.fx[i] *= s;
+            f.fy[i] *= s;
+        }
+    }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/**
+ * \brief evolve a snake on its slice (which must have been given to
+ * setSlice(); otherwise the snake is left alone).
+ */
+void SnakeEngine::evolve ( Snake& snake, const Parameters& p ) {
+    FieldPtr  f = field( snake.slice );
+    if (f != nullptr)    evolve( *f, snake, p );
+}
+
+/**
+ * \brief evolve snakes (on different slices, typically) at the same time,
+ * computing the fields that aren't ready yet as they're needed.
+ */
+void SnakeEngine::evolve ( std::vector<Snake>& snakes, const Parameters& p ) {
+    const int  threads = std::min( mThreads, (int)snakes.size() );
+    std::atomic<size_t>  next( 0 );
+    std::vector<std::thread>  t;
+    for (int i=0; i<threads; i++) {
+        t.emplace_back( [&] {
+            for (size_t j; (j = next++) < snakes.size(); )
+                evolve( snakes[j], p );
+        } );
+    }
+    for (auto& th : t)    th.join();
+}
+
+void SnakeEngine::evolve ( const Field& f, Snake& snake, const Parameters& p )
+    const
+{
+    const int  anchors = (int)snake.x.size();
+    if (anchors < 2)    return;
+
+    //sample the contour (closed) between the anchors
+    double  perimeter = 0;
+    for (int i=0; i<anchors; i++) {
+        const int  j = (i+1) % anchors;
+        perimeter += hypot( snake.x[j]-snake.x[i], snake.y[j]-snake.y[i] );
+    }
+    if (perimeter < 1)    return;
+    const double  spacing = std::min( Spacing, perimeter / MinSamples );
+    std::vector<double>  x, y;
+    std::vector<int>     at( anchors );
+    for (int i=0; i<anchors; i++) {
+        const int  j = (i+1) % anchors;
+        const double  dx = snake.x[j]-snake.x[i], dy = snake.y[j]-snake.y[i];
+        const int  k = std::max( 1, (int)ceil( hypot( dx, dy ) / spacing ) );
+        at[i] = (int)x.size();
+        for (int s=0; s<k; s++) {
+            x.push_back( snake.x[i] + dx*s/k );
+            y.push_back( snake.y[i] + dy*s/k );
+        }
+    }
+    const int  n = (int)x.size();   //>= MinSamples
+
+    const double  tau   = p.timeStep;
+    const double  alpha = std::max( p.tensile,  0.0 );
+    const double  beta  = std::max( p.flexural, 0.0 );
+    const CyclicPentadiagonal  m( n, 1 + tau*(2*alpha + 6*beta),
+                                  -tau*(alpha + 4*beta), tau*beta );
+    const int  w = mWidth, h = mHeight;
+    std::vector<double>  bx( n ), by( n );
+    for (int it=0; it<p.iterations; it++) {
+        //outward normals are (ty,-tx) if the contour is counterclockwise
+        double  orientation = 0;
+        if (p.inflation != 0) {
+            double  area = 0;
+            for (int i=0; i<n; i++) {
+                const int  j = (i+1) % n;
+                area += x[i]*y[j] - x[j]*y[i];
+            }
+            orientation = (area > 0) ? 1 : -1;
+        }
+        for (int i=0; i<n; i++) {
+            double  fx = p.external * sample( f.fx, w, h, x[i], y[i] );
+            double  fy = p.external * sample( f.fy, w, h, x[i], y[i] );
+            if (orientation != 0) {
+                const int  prev = (i+n-1) % n, next = (i+1) % n;
+                const double  tx = x[next]-x[prev], ty = y[next]-y[prev];
+                const double  t = hypot( tx, ty );
+                if (t > 0) {
+                    fx += p.inflation * orientation *  ty / t;
+                    fy += p.inflation * orientation * -tx / t;
+                }
+            }
+            bx[i] = x[i] + tau*fx;
+            by[i] = y[i] + tau*fy;
+        }
+        m.solve( bx.data(), by.data() );
+        for (int i=0; i<n; i++) {
+            x[i] = std::min( std::max( bx[i], 0.0 ), (double)(w-1) );
+            y[i] = std::min( std::max( by[i], 0.0 ), (double)(h-1) );
+        }
+    }
+
+    for (int i=0; i<anchors; i++) {
+        snake.x[i] = x[at[i]];
+        snake.y[i] = y[at[i]];
+    }
+}
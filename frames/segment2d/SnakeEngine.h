@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief active contour (snake) evolution for the live snake.
+ *
+ * the external force of a slice (the gradient of its smoothed, normalized
+ * edge map, optionally diffused by gradient vector flow) is computed once,
+ * in the background, as soon as the slice is given to setSlice(), and is
+ * kept for the next few slices asked for. the canvas gives it the slices
+ * next to the one being traced too, so that the field is usually ready by
+ * the time the contour is propagated to them.
+ *
+ * the snake is evolved semi-implicitly (kass et al.): each iteration
+ * solves (I + tau A) x' = x + tau f(x), where A is the cyclic pentadiagonal
+ * matrix of the tensile and flexural energies. A doesn't change, so it is
+ * factored once per evolve() (a banded cholesky factorization whose only
+ * fill-in is in the last two rows), and each iteration costs O(n).
+ *
+ * no wx here: the engine is used from the gui thread, but its own threads
+ * only ever touch its own data.
+ */
+class SnakeEngine {
+public:
+    /** \brief weights of the snake energy. */
+    struct Parameters {
+        double  tensile   = 0.1;   ///< alpha: resistance to stretching
+        double  flexural  = 0.2;   ///< beta: resistance to bending
+        double  external  = 0.5;   ///< weight of the image (edge) force
+        double  inflation = 0.0;   ///< balloon force (> 0 grows the contour)
+        double  timeStep  = 1.0;   ///< tau
+        int     iterations = 10;
+    };
+
+    /** \brief a closed contour on a slice. the points are anchors: the
+     *  contour is sampled more finely between them while it evolves, and
+     *  they are moved to where their samples ended up. */
+    struct Snake {
+        int                  slice = 0;
+        std::vector<double>  x, y;
+    };
+
+    SnakeEngine ( int width, int height, double sigma=1.0,
+                  int gvfIterations=0, int threads=0 );
+    ~SnakeEngine ( );
+
+    int  getWidth  ( ) const { return mWidth;  }
+    int  getHeight ( ) const { return mHeight; }
+
+    void setSlice ( int slice, const void* data, int bits );
+    bool hasSlice ( int slice );
+    void evolve ( Snake& snake, const Parameters& p );
+    void evolve ( std::vector<Snake>& snakes, const Parameters& p );
+
+private:
+    /** \brief the force field of a slice. */
+    struct Field {
+        enum { QUEUED, COMPUTING, READY }  state = QUEUED;
+        std::vector<float>  image;   ///< the slice (until the field is computed)
+        std::vector<float>  fx, fy;  ///< the force
+    };
+    typedef std::shared_ptr<Field>  FieldPtr;
+
+    static const int  MaxSlices = 8;   ///< fields kept
+
+    int       mWidth, mHeight;
+    double    mSigma;
+    int       mGvfIterations;
+
+    std::mutex               mLock;
+    std::condition_variable  mChanged;
+    std::map<int, FieldPtr>  mFields;
+    std::deque<int>          mOrder;   ///< slices of mFields, oldest first
+    std::deque<int>          mQueue;   ///< slices waiting for a worker
+    bool                     mStop = false;
+    std::vector<std::thread> mWorkers;
+    int                      mThreads;
+
+    void     work ( );
+    void     compute ( Field& f ) const;
+    FieldPtr field ( int slice );
+    void     evolve ( const Field& f, Snake& snake, const Parameters& p ) const;
+};
@@ -0,0 +1,170 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* demons3d: registers a moving IM0 scene to a fixed one with the 3d
+ * demons of demons3d.cpp and writes the warped moving scene, on the grid
+ * of the fixed scene, as a 16-bit IM0 scene with the fixed scene's header.
+ */
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <Viewnix.h>
+#include "cv3dv.h"
+#include "demons3d.h"
+
+struct SceneFile {
+  ViewnixHeader vh;
+  int size[3];
+  double spacing[3];
+  int bytes;
+  unsigned char* data;
+};
+
+static int readScene(const char* name, SceneFile* s)
+{
+  char group[5], element[5];
+  FILE* fp = fopen(name, "rb");
+  if (fp == NULL)
+    {
+    std::cerr << "Cannot open " << name << std::endl;
+    return 1;
+    }
+  int error_code = VReadHeader(fp, &s->vh, group, element);
+  if (error_code != 0 && error_code != 106 && error_code != 107)
+    {
+    std::cerr << "Cannot read the header of " << name << std::endl;
+    fclose(fp);
+    return 1;
+    }
+  if (s->vh.gen.data_type != IMAGE0 || s->vh.scn.dimension != 3 ||
+      (s->vh.scn.num_of_bits != 8 && s->vh.scn.num_of_bits != 16))
+    {
+    std::cerr << name << " is not a 3d scene of 8 or 16 bits" << std::endl;
+    fclose(fp);
+    return 1;
+    }
+  s->size[0] = s->vh.scn.xysize[0];
+  s->size[1] = s->vh.scn.xysize[1];
+  s->size[2] = s->vh.scn.num_of_subscenes[0];
+  s->spacing[0] = s->vh.scn.xypixsz[0];
+  s->spacing[1] = s->vh.scn.xypixsz[1];
+  s->spacing[2] = s->size[2] > 1 ?
+    fabs(s->vh.scn.loc_of_subscenes[1] - s->vh.scn.loc_of_subscenes[0]) :
+    s->spacing[0];
+  s->bytes = s->vh.scn.num_of_bits / 8;
+  int cells = s->size[0] * s->size[1] * s->size[2], items;
+  s->data = (unsigned char*)malloc((size_t)cells * s->bytes);
+  if (s->data == NULL)
+    {
+    std::cerr << "Out of memory." << std::endl;
+    fclose(fp);
+    return 1;
+    }
+  VSeekData(fp, 0);
+  error_code = VReadData((char*)s->data, s->bytes, cells, fp, &items);
+  fclose(fp);
+  if (error_code || items != cells)
+    {
+    std::cerr << "Cannot read the data of " << name << std::endl;
+    return 1;
+    }
+  return 0;
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << " fixedFile<IM0> movingFile<IM0> outputFile<IM0>"
+      " [iterations [levels [standardDeviation [threads]]]]" << std::endl;
+    return -1;
+    }
+  int iterations = argc > 4 ? atoi(argv[4]) : 10;
+  int levels = argc > 5 ? atoi(argv[5]) : 1;
+  double standardDeviation = argc > 6 ? atof(argv[6]) : 1.0;
+  int threads = argc > 7 ? atoi(argv[7]) : 0;
+
+  static SceneFile fixed, moving;
+  if (readScene(argv[1], &fixed) || readScene(argv[2], &moving))
+    return -1;
+
+  int* warped = doDemons3DRegistration(
+    fixed.size[0], fixed.size[1], fixed.size[2],
+    fixed.spacing[0], fixed.spacing[1], fixed.spacing[2],
+    fixed.bytes, fixed.data,
+    moving.size[0], moving.size[1], moving.size[2],
+    moving.spacing[0], moving.spacing[1], moving.spacing[2],
+    moving.bytes, moving.data,
+    iterations, 10, 200, standardDeviation, true, levels, threads);
+  free(fixed.data);
+  free(moving.data);
+  if (warped == NULL)
+    return -1;
+
+  int cells = fixed.size[0] * fixed.size[1] * fixed.size[2], items;
+  unsigned short* out = (unsigned short*)malloc(cells * sizeof(unsigned short));
+  if (out == NULL)
+    {
+    std::cerr << "Out of memory." << std::endl;
+    return -1;
+    }
+  int min = 65535, max = 0;
+  for (int i = 0; i < cells; i++)
+    {
+    int v = warped[i] < 0 ? 0 : warped[i] > 65535 ? 65535 : warped[i];
+    out[i] = (unsigned short)v;
+    if (v < min)  min = v;
+    if (v > max)  max = v;
+    }
+  free(warped);
+
+  ViewnixHeader vh = fixed.vh;
+  char group[5], element[5];
+  vh.scn.num_of_bits = 16;
+  vh.scn.bit_fields[0] = 0;
+  vh.scn.bit_fields[1] = 15;
+  vh.scn.smallest_density_value[0] = (float)min;
+  vh.scn.largest_density_value[0] = (float)max;
+  strncpy(vh.gen.filename, argv[3], sizeof(vh.gen.filename) - 1);
+  vh.gen.filename[sizeof(vh.gen.filename) - 1] = 0;
+  FILE* fp = fopen(argv[3], "wb+");
+  if (fp == NULL)
+    {
+    std::cerr << "Cannot create " << argv[3] << std::endl;
+    return -1;
+    }
+  int error_code = VWriteHeader(fp, &vh, group, element);
+  if ((error_code > 0 && error_code <= 104) ||
+      VWriteData((char*)out, 2, cells, fp, &items) || items != cells)
+    {
+    std::cerr << "Cannot write " << argv[3] << std::endl;
+    fclose(fp);
+    return -1;
+    }
+  VCloseData(fp);
+  free(out);
+  return 0;
+}
@@ -0,0 +1,496 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/**
+ * \brief this program runs a chain of itk filters on a scene in one
+ * process.  the stages are connected in memory as a single itk pipeline,
+ * so only the input is read and only the final result is written.
+ *
+ * each stage is named after the separate program that runs the same
+ * filter (itkMedianFilter, itkDiscreteGaussianFilter, ...) and takes the
+ * same parameters in the same order (those after inputFile outputFile),
+ * so
+ *     itkMedianFilter in.IM0 tmp.IM0 1 1 1
+ *     itkBinaryThresholdFilter tmp.IM0 out.IM0 100 200 0 1
+ * becomes
+ *     itkFilterPipeline in.IM0 out.IM0 itkMedianFilter 1 1 1 : itkBinaryThresholdFilter 100 200 0 1
+ * stages may instead be given in a file (-f), one per line (# starts a
+ * comment).  cells are carried between stages as floats.  a stage whose
+ * program rescales its result to [0,255] does the same here.
+ *
+ * the multithreader uses every processor (unless -t is given).  with
+ * -s n, the result is computed in n pieces (slabs of slices) so that only
+ * a piece of each intermediate scene is in memory at a time (filters that
+ * need the whole scene, like the distance transform, still get it).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <itkImage.h>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMultiThreaderBase.h"
+#include "itkIM0ImageIO.h"
+#include "ElapsedTime.h"
+
+#include "itkBinaryBallStructuringElement.h"
+#include "itkBinaryDilateImageFilter.h"
+#include "itkBinaryErodeImageFilter.h"
+#include "itkBinaryMedianImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkBinomialBlurImageFilter.h"
+#include "itkCurvatureAnisotropicDiffusionImageFilter.h"
+#include "itkCurvatureFlowImageFilter.h"
+#include "itkDerivativeImageFilter.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkGradientAnisotropicDiffusionImageFilter.h"
+#include "itkGradientMagnitudeImageFilter.h"
+#include "itkGradientMagnitudeRecursiveGaussianImageFilter.h"
+#include "itkGrayscaleDilateImageFilter.h"
+#include "itkGrayscaleErodeImageFilter.h"
+#include "itkMeanImageFilter.h"
+#include "itkMedianImageFilter.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkSigmoidImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkThresholdImageFilter.h"
+#include "itkVotingBinaryHoleFillingImageFilter.h"
+#include "FilterProgress.h"
+
+const unsigned int  Dimension = 3;
+typedef  float                           PixelType;
+typedef  itk::Image< PixelType, Dimension >  ImageType;
+typedef  itk::BinaryBallStructuringElement< unsigned char, Dimension >  BallType;
+typedef  std::vector< std::string >     Args;
+
+//----------------------------------------------------------------------
+/** \brief the chain of filters built so far. */
+class Pipeline {
+    std::vector< itk::ProcessObject::Pointer >  mFilters;  ///< keeps them alive
+    FilterProgress::Pointer                     mProgress;
+public:
+    ImageType::Pointer  mOutput;  ///< output of the last stage
+
+    Pipeline ( ImageType* input ) : mProgress( FilterProgress::New() ), mOutput( input ) { }
+
+    /** \brief add f to the end of the chain. */
+    template < class F >
+    void append ( F* f ) {
+        f->SetInput( mOutput );
+        f->AddObserver( itk::ProgressEvent(), mProgress );
+        mFilters.push_back( f );
+        mOutput = f->GetOutput();
+    }
+
+    /** \brief rescale the output to [min,max] (as many of the programs do). */
+    void rescale ( double min, double max ) {
+        typedef itk::RescaleIntensityImageFilter< ImageType, ImageType >  FilterType;
+        FilterType::Pointer  f = FilterType::New();
+        f->SetOutputMinimum( min );
+        f->SetOutputMaximum( max );
+        append( f.GetPointer() );
+    }
+};
+//----------------------------------------------------------------------
+static ImageType::SizeType radius ( const Args& a ) {
+    ImageType::SizeType  r;
+    for (unsigned int i=0; i<Dimension; i++)    r[i] = atoi( a[i].c_str() );
+    return r;
+}
+
+static BallType ball ( const BallType::SizeType& r ) {
+    BallType  b;
+    b.SetRadius( r );
+    b.CreateStructuringElement();
+    return b;
+}
+
+static BallType ball ( int r ) {
+    BallType::SizeType  s;
+    s.Fill( r );
+    return ball( s );
+}
+//----------------------------------------------------------------------
+static void binaryDilate ( Pipeline& p, const Args& a ) {
+    typedef itk::BinaryDilateImageFilter< ImageType, ImageType, BallType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetKernel( ball( atoi(a[0].c_str()) ) );
+    f->SetDilateValue( 1 );  // foreground object
+    p.append( f.GetPointer() );
+}
+
+static void binaryErode ( Pipeline& p, const Args& a ) {
+    typedef itk::BinaryErodeImageFilter< ImageType, ImageType, BallType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetKernel( ball( atoi(a[0].c_str()) ) );
+    f->SetErodeValue( 1 );  // foreground object
+    p.append( f.GetPointer() );
+}
+
+static void binaryMedian ( Pipeline& p, const Args& a ) {
+    typedef itk::BinaryMedianImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetRadius( radius(a) );
+    p.append( f.GetPointer() );
+}
+
+static void binaryOpening ( Pipeline& p, const Args& a ) {
+    //as itkBinaryOpeningFilter, the ball is in-plane only
+    BallType::SizeType  r;
+    r[0] = r[1] = atoi( a[0].c_str() );
+    r[2] = 0;
+    typedef itk::BinaryErodeImageFilter<  ImageType, ImageType, BallType >  ErodeFilterType;
+    typedef itk::BinaryDilateImageFilter< ImageType, ImageType, BallType >  DilateFilterType;
+    ErodeFilterType::Pointer  f1 = ErodeFilterType::New();
+    f1->SetKernel( ball(r) );
+    f1->SetErodeValue( 1 );
+    p.append( f1.GetPointer() );
+    DilateFilterType::Pointer  f2 = DilateFilterType::New();
+    f2->SetKernel( ball(r) );
+    f2->SetDilateValue( 1 );
+    p.append( f2.GetPointer() );
+}
+
+static void binaryThreshold ( Pipeline& p, const Args& a ) {
+    typedef itk::BinaryThresholdImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetLowerThreshold( atoi( a[0].c_str() ) );
+    f->SetUpperThreshold( atoi( a[1].c_str() ) );
+    f->SetOutsideValue(   atoi( a[2].c_str() ) );
+    f->SetInsideValue(    atoi( a[3].c_str() ) );
+    p.append( f.GetPointer() );
+}
+
+static void binomialBlur ( Pipeline& p, const Args& a ) {
+    typedef itk::BinomialBlurImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetRepetitions( atoi( a[0].c_str() ) );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void curvatureAnisotropicDiffusion ( Pipeline& p, const Args& a ) {
+    typedef itk::CurvatureAnisotropicDiffusionImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetNumberOfIterations(   atoi( a[0].c_str() ) );
+    f->SetTimeStep(             atof( a[1].c_str() ) );
+    f->SetConductanceParameter( atof( a[2].c_str() ) );
+    p.append( f.GetPointer() );
+}
+
+static void curvatureFlow ( Pipeline& p, const Args& a ) {
+    typedef itk::CurvatureFlowImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetNumberOfIterations( atoi( a[0].c_str() ) );
+    f->SetTimeStep(           atof( a[1].c_str() ) );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void derivative ( Pipeline& p, const Args& a ) {
+    typedef itk::DerivativeImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetOrder(     atoi( a[0].c_str() ) );
+    f->SetDirection( atoi( a[1].c_str() ) );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void discreteGaussian ( Pipeline& p, const Args& a ) {
+    typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetVariance(           atof( a[0].c_str() ) );
+    f->SetMaximumKernelWidth( atoi( a[1].c_str() ) );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void gradientAnisotropicDiffusion ( Pipeline& p, const Args& a ) {
+    typedef itk::GradientAnisotropicDiffusionImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetNumberOfIterations(   atoi( a[0].c_str() ) );
+    f->SetTimeStep(             atof( a[1].c_str() ) );
+    f->SetConductanceParameter( atof( a[2].c_str() ) );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void gradientMagnitude ( Pipeline& p, const Args& ) {
+    typedef itk::GradientMagnitudeImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    p.append( f.GetPointer() );
+}
+
+static void gradientMagnitudeRecursiveGaussian ( Pipeline& p, const Args& a ) {
+    typedef itk::GradientMagnitudeRecursiveGaussianImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetSigma( atof( a[0].c_str() ) );
+    p.append( f.GetPointer() );
+}
+
+static void grayDilate ( Pipeline& p, const Args& a ) {
+    typedef itk::GrayscaleDilateImageFilter< ImageType, ImageType, BallType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetKernel( ball( atoi(a[0].c_str()) ) );
+    p.append( f.GetPointer() );
+}
+
+static void grayErode ( Pipeline& p, const Args& a ) {
+    typedef itk::GrayscaleErodeImageFilter< ImageType, ImageType, BallType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetKernel( ball( atoi(a[0].c_str()) ) );
+    p.append( f.GetPointer() );
+}
+
+static void mean ( Pipeline& p, const Args& a ) {
+    typedef itk::MeanImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetRadius( radius(a) );
+    p.append( f.GetPointer() );
+}
+
+static void median ( Pipeline& p, const Args& a ) {
+    typedef itk::MedianImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetRadius( radius(a) );
+    p.append( f.GetPointer() );
+}
+
+static void rescale ( Pipeline& p, const Args& a ) {
+    p.rescale( atoi( a[0].c_str() ), atoi( a[1].c_str() ) );
+}
+
+static void sigmoid ( Pipeline& p, const Args& a ) {
+    typedef itk::SigmoidImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetOutputMinimum( atoi( a[0].c_str() ) );
+    f->SetOutputMaximum( atoi( a[1].c_str() ) );
+    f->SetAlpha(         atof( a[2].c_str() ) );
+    f->SetBeta(          atof( a[3].c_str() ) );
+    p.append( f.GetPointer() );
+}
+
+static void signedMaurerDistanceMap ( Pipeline& p, const Args& ) {
+    typedef itk::SignedMaurerDistanceMapImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->UseImageSpacingOn();
+    f->SquaredDistanceOff();
+    f->InsideIsPositiveOn();
+    p.append( f.GetPointer() );
+}
+
+static void smoothRecursiveGaussian ( Pipeline& p, const Args& a ) {
+    //zero order along x, y and z, not normalized across scale
+    typedef itk::SmoothingRecursiveGaussianImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetSigma( atof( a[0].c_str() ) );
+    f->SetNormalizeAcrossScale( false );
+    p.append( f.GetPointer() );
+    p.rescale( 0, 255 );
+}
+
+static void threshold ( Pipeline& p, const Args& a ) {
+    typedef itk::ThresholdImageFilter< ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetOutsideValue( atoi( a[0].c_str() ) );
+    const int  option = atoi( a[1].c_str() );
+    if (option == 1)         f->ThresholdBelow( atoi( a[2].c_str() ) );
+    else if (option == 2)    f->ThresholdAbove( atoi( a[2].c_str() ) );
+    else if (option == 3 && a.size() > 3)
+        f->ThresholdOutside( atoi( a[2].c_str() ), atoi( a[3].c_str() ) );
+    else {
+        std::cerr << "itkThresholdFilter: wrong option!" << std::endl;
+        exit( EXIT_FAILURE );
+    }
+    p.append( f.GetPointer() );
+}
+
+static void votingBinaryHoleFilling ( Pipeline& p, const Args& a ) {
+    typedef itk::VotingBinaryHoleFillingImageFilter< ImageType, ImageType >  FilterType;
+    FilterType::Pointer  f = FilterType::New();
+    f->SetRadius( radius(a) );
+    f->SetBackgroundValue(   0 );
+    f->SetForegroundValue( 255 );
+    f->SetMajorityThreshold( 2 );
+    p.append( f.GetPointer() );
+}
+//----------------------------------------------------------------------
+/** \brief table of stages (kept in the order of the programs' names). */
+static const struct Stage {
+    const char*  name;     ///< name of the program that runs this filter
+    int          minArgs;  ///< # of parameters
+    int          maxArgs;
+    const char*  params;   ///< for the usage message
+    void       (*add)( Pipeline& p, const Args& a );
+} stages[] = {
+    { "itkBinaryDilateFilter",             1, 1, "radius",                        binaryDilate },
+    { "itkBinaryErodeFilter",              1, 1, "radius",                        binaryErode },
+    { "itkBinaryMedianFilter",             3, 3, "radius_x radius_y radius_z",    binaryMedian },
+    { "itkBinaryMorphFilter",              3, 3, "radius_x radius_y radius_z",    median },
+    { "itkBinaryOpeningFilter",            1, 1, "radius",                        binaryOpening },
+    { "itkBinaryThresholdFilter",          4, 4, "lowerTh upper outValue inValue", binaryThreshold },
+    { "itkBinomialBlurFilter",             1, 1, "numberOfRepetitions",           binomialBlur },
+    { "itkCurvatureAnisotropicDiffusionFilter", 3, 3, "numberOfIterations timeStep conductance", curvatureAnisotropicDiffusion },
+    { "itkCurvatureFlowImageFilter",       2, 2, "numberOfIterations timeStep",   curvatureFlow },
+    { "itkDerivativeFilter",               2, 2, "derivativeOrder direction",     derivative },
+    { "itkDiscreteGaussianFilter",         2, 2, "variance maxKernelWidth",       discreteGaussian },
+    { "itkGradientAnisotropicDiffusionFilter", 3, 3, "numberOfIterations timeStep conductance", gradientAnisotropicDiffusion },
+    { "itkGradientMagnitudeFilter",        0, 0, "",                              gradientMagnitude },
+    { "itkGradientMagnitudeRecursiveGaussianFilter", 1, 1, "sigma",               gradientMagnitudeRecursiveGaussian },
+    { "itkGrayDilateFilter",               1, 1, "radius",                        grayDilate },
+    { "itkGrayErodeFilter",                1, 1, "radius",                        grayErode },
+    { "itkMeanFilter",                     3, 3, "radius_x radius_y radius_z",    mean },
+    { "itkMedianFilter",                   3, 3, "radius_x radius_y radius_z",    median },
+    { "itkRescaleFilter",                  2, 2, "outputMin outputMax",           rescale },
+    { "itkSigmoidFilter",                  4, 4, "outputMin outputMax alpha beta", sigmoid },
+    { "itkSignedMaurerDistanceMapFilter",  0, 0, "",                              signedMaurerDistanceMap },
+    { "itkSmoothRecursiveGaussianFilter",  1, 1, "sigma",                         smoothRecursiveGaussian },
+    { "itkThresholdFilter",                3, 4, "outsideValue option(1:below;2:above;3:outside) th1 [th2]", threshold },
+    { "itkVotingBinaryHoleFillingFilter",  3, 3, "radius_x radius_y radius_z",    votingBinaryHoleFilling },
+    { 0 }
+};
+//----------------------------------------------------------------------
+static void usage ( const char* programName ) {
+    std::cerr << "Usage:" << std::endl << std::endl
+        << "    " << programName << " [-d] [-t threads] [-s pieces] inputFile outputFile stage params [: stage params]..." << std::endl
+        << "    " << programName << " [-d] [-t threads] [-s pieces] inputFile outputFile -f stageFile" << std::endl
+        << std::endl
+        << "        -d = output values as doubles" << std::endl
+        << "        -t = # of threads (default: # of processors)" << std::endl
+        << "        -s = compute the result in this many pieces (default: 1)" << std::endl
+        << "        stageFile has one stage and its params per line" << std::endl
+        << std::endl << "    stages:" << std::endl;
+    for (int i=0; stages[i].name!=0; i++)
+        std::cerr << "        " << stages[i].name << " " << stages[i].params << std::endl;
+    exit( EXIT_FAILURE );
+}
+//----------------------------------------------------------------------
+/** \brief add the stage whose name and params are in words to p. */
+static void addStage ( Pipeline& p, const Args& words, const char* programName ) {
+    if (words.empty())    return;
+    const Args  a( words.begin()+1, words.end() );
+    for (int i=0; stages[i].name!=0; i++) {
+        if (words[0] != stages[i].name)    continue;
+        if ((int)a.size() < stages[i].minArgs || (int)a.size() > stages[i].maxArgs) {
+            std::cerr << "stage " << stages[i].name << " takes the params: "
+                      << stages[i].params << std::endl;
+            exit( EXIT_FAILURE );
+        }
+        stages[i].add( p, a );
+        return;
+    }
+    std::cerr << "unknown stage: " << words[0] << std::endl;
+    usage( programName );
+}
+//----------------------------------------------------------------------
+int main ( int argc, char* argv[] ) {
+    ElapsedTime  et;  /* timer class */
+
+    bool  outputDouble = false;
+    int   threads = std::thread::hardware_concurrency();
+    int   pieces  = 1;
+    int   nextArg = 1;
+    for ( ; nextArg<argc && argv[nextArg][0]=='-'; nextArg++) {
+        if (strcmp(argv[nextArg],"-d")==0)
+            outputDouble = true;
+        else if (strcmp(argv[nextArg],"-t")==0 && nextArg+1<argc)
+            threads = atoi( argv[++nextArg] );
+        else if (strcmp(argv[nextArg],"-s")==0 && nextArg+1<argc)
+            pieces = atoi( argv[++nextArg] );
+        else
+            usage( argv[0] );
+    }
+    if (nextArg+3 > argc)    usage( argv[0] );
+    const char*  inputFile  = argv[nextArg++];
+    const char*  outputFile = argv[nextArg++];
+
+    if (threads > 0)
+        itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads( threads );
+
+    typedef itk::ImageFileReader< ImageType >  ReaderType;
+    ReaderType::Pointer  reader = ReaderType::New();
+    reader->SetImageIO( itk::IM0ImageIO::New() );
+    reader->SetFileName( inputFile );
+
+    //build the chain of stages
+    Pipeline  p( reader->GetOutput() );
+    if (strcmp(argv[nextArg],"-f")==0) {
+        if (nextArg+1 >= argc)    usage( argv[0] );
+        std::ifstream  in( argv[nextArg+1] );
+        if (!in) {
+            std::cerr << "can't open " << argv[nextArg+1] << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::string  line;
+        while (std::getline( in, line )) {
+            line = line.substr( 0, line.find('#') );
+            std::istringstream  ss( line );
+            Args  words;
+            std::string  w;
+            while (ss >> w)    words.push_back( w );
+            addStage( p, words, argv[0] );
+        }
+    } else {
+        Args  words;
+        for ( ; nextArg<argc; nextArg++) {
+            if (strcmp(argv[nextArg],":")==0) {
+                addStage( p, words, argv[0] );
+                words.clear();
+            } else {
+                words.push_back( argv[nextArg] );
+            }
+        }
+        addStage( p, words, argv[0] );
+    }
+
+    //pull the result through the pipeline (in pieces, if requested)
+    typedef itk::StreamingImageFilter< ImageType, ImageType >  StreamerType;
+    StreamerType::Pointer  streamer = StreamerType::New();
+    streamer->SetInput( p.mOutput );
+    streamer->SetNumberOfStreamDivisions( pieces > 1 ? pieces : 1 );
+
+    itk::IM0ImageIO::Pointer  io = itk::IM0ImageIO::New();
+    io->SetOutputDoubleData( outputDouble );
+    typedef itk::ImageFileWriter< ImageType >  WriterType;
+    WriterType::Pointer  writer = WriterType::New();
+    writer->SetImageIO( io );
+    writer->SetFileName( outputFile );
+    writer->SetInput( streamer->GetOutput() );
+    try {
+        writer->Update();
+    } catch (itk::ExceptionObject& e) {
+        std::cerr << e << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Elapsed time: " << et.getElapsedTime() << "s." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,327 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <Viewnix.h>
+#include "cv3dv.h"
+#include "itkIM0ImageIO.h"
+
+namespace itk {
+
+/** Does the file name end in .IM0 or .BIM (in either case)? */
+static bool hasSceneExtension ( const char* fileName ) {
+    if (fileName == NULL)    return false;
+    size_t n = strlen( fileName );
+    if (n < 4 || fileName[n-4] != '.')    return false;
+    char ext[4];
+    for (int i=0; i<3; i++)    ext[i] = toupper( fileName[n-3+i] );
+    ext[3] = 0;
+    return strcmp( ext, "IM0" ) == 0 || strcmp( ext, "BIM" ) == 0;
+}
+
+/** Read the header of a scene; errors 1-105 are fatal (106 and 107 are not). */
+static bool readSceneHeader ( const char* fileName, ViewnixHeader* vh ) {
+    FILE* fp = fopen( fileName, "rb" );
+    if (fp == NULL)    return false;
+    char group[6], element[6];
+    int error = VReadHeader( fp, vh, group, element );
+    fclose( fp );
+    if (error > 0 && error < 106)    return false;
+    return vh->gen.data_type == IMAGE0;
+}
+
+IM0ImageIO::IM0ImageIO ( ) {
+    m_BitsPerCell = 0;
+    m_DoAbs = false;
+    m_OutputDoubleData = false;
+    SetNumberOfDimensions( 3 );
+    m_PixelType = SCALAR;
+    m_ComponentType = UCHAR;
+    AddSupportedReadExtension( ".IM0" );
+    AddSupportedReadExtension( ".BIM" );
+    AddSupportedWriteExtension( ".IM0" );
+    AddSupportedWriteExtension( ".BIM" );
+}
+
+void IM0ImageIO::PrintSelf ( std::ostream& os, Indent indent ) const {
+    Superclass::PrintSelf( os, indent );
+    os << indent << "BitsPerCell: " << m_BitsPerCell << std::endl;
+    os << indent << "DoAbs: " << m_DoAbs << std::endl;
+    os << indent << "OutputDoubleData: " << m_OutputDoubleData << std::endl;
+}
+//----------------------------------------------------------------------
+bool IM0ImageIO::CanReadFile ( const char* fileName ) {
+    if (!hasSceneExtension( fileName ))    return false;
+    ViewnixHeader vh;
+    if (!readSceneHeader( fileName, &vh ))    return false;
+    int bits = vh.scn.num_of_bits;
+    return bits == 1 || bits == 8 || bits == 16 || bits == 64;
+}
+
+void IM0ImageIO::ReadImageInformation ( ) {
+    ViewnixHeader vh;
+    if (!readSceneHeader( m_FileName.c_str(), &vh ))
+        itkExceptionMacro( "Could not read 3DVIEWNIX scene " << m_FileName );
+    m_BitsPerCell = vh.scn.num_of_bits;
+
+    //all of the slices (of all of the volumes of a 4D scene)
+    int slices = vh.scn.num_of_subscenes[0];
+    if (vh.scn.dimension == 4) {
+        slices = 0;
+        for (int v=1; v<=vh.scn.num_of_subscenes[0]; v++)
+            slices += vh.scn.num_of_subscenes[v];
+    }
+
+    SetNumberOfDimensions( 3 );
+    m_Dimensions[0] = vh.scn.xysize[0];
+    m_Dimensions[1] = vh.scn.xysize[1];
+    m_Dimensions[2] = slices;
+    m_Spacing[0] = vh.scn.xypixsz[0];
+    m_Spacing[1] = vh.scn.xypixsz[1];
+    m_Spacing[2] = 1.0;
+    if (slices > 1)
+        m_Spacing[2] = vh.scn.loc_of_subscenes[1] - vh.scn.loc_of_subscenes[0];
+    for (int i=0; i<3; i++)    m_Origin[i] = 0.0;
+
+    SetPixelType( SCALAR );
+    SetNumberOfComponents( 1 );
+    switch (m_BitsPerCell) {
+        case 1 :
+        case 8 :
+            SetComponentType( UCHAR );
+            break;
+        case 16 :
+            if (vh.scn.signed_bits_valid && vh.scn.signed_bits[0])
+                SetComponentType( SHORT );
+            else
+                SetComponentType( USHORT );
+            break;
+        case 64 :
+            SetComponentType( DOUBLE );
+            break;
+        default :
+            itkExceptionMacro( "Unsupported bits per cell (" << m_BitsPerCell
+                               << ") in " << m_FileName );
+    }
+}
+
+/**
+ * Reads the cells of m_IORegion into buffer, a slice at a time.  Cells of
+ * 8 or more bits are read straight into buffer when the region spans
+ * whole rows; otherwise the rows are read and the wanted columns copied.
+ */
+void IM0ImageIO::Read ( void* buffer ) {
+    const long width = m_Dimensions[0], height = m_Dimensions[1];
+    long x0 = m_IORegion.GetIndex( 0 ), nx = m_IORegion.GetSize( 0 );
+    long y0 = 0, ny = 1, z0 = 0, nz = 1;
+    if (m_IORegion.GetImageDimension() > 1) {
+        y0 = m_IORegion.GetIndex( 1 );
+        ny = m_IORegion.GetSize( 1 );
+    }
+    if (m_IORegion.GetImageDimension() > 2) {
+        z0 = m_IORegion.GetIndex( 2 );
+        nz = m_IORegion.GetSize( 2 );
+    }
+    if (nx<=0 || ny<=0 || nz<=0)    return;
+
+    FILE* fp = fopen( m_FileName.c_str(), "rb" );
+    if (fp == NULL)
+        itkExceptionMacro( "Could not open " << m_FileName );
+    bool ok = true;
+
+    if (m_BitsPerCell == 1) {
+        //only the bytes holding rows y0 to y0+ny-1 of each slice
+        const long sliceBytes = (width*height + 7) / 8;
+        const long first = y0*width / 8;
+        const long bytes = ((y0+ny)*width + 7) / 8 - first;
+        std::vector<unsigned char> packed( bytes );
+        unsigned char* out = (unsigned char*)buffer;
+        for (long z=z0; ok && z<z0+nz; z++) {
+            int n = 0;
+            ok = VSeekData( fp, (off_t)z*sliceBytes + first ) == 0
+              && VReadData( (char*)&packed[0], 1, (int)bytes, fp, &n ) == 0
+              && n == bytes;
+            for (long y=y0; ok && y<y0+ny; y++) {
+                for (long x=x0; x<x0+nx; x++) {
+                    long i = y*width + x - first*8;
+                    *out++ = (packed[i>>3] & (0x80>>(i&7))) != 0;
+                }
+            }
+        }
+    } else {
+        //as VReadData expects them: doubles are read as pairs of 4 bytes
+        const int  size = m_BitsPerCell==64 ? 4 : m_BitsPerCell/8;
+        const int  perCell = m_BitsPerCell==64 ? 2 : 1;
+        const long cellBytes = m_BitsPerCell / 8;
+        const bool wholeRows = nx == width;
+        std::vector<char> rows( wholeRows ? 0 : ny*width*cellBytes );
+        char* out = (char*)buffer;
+        for (long z=z0; ok && z<z0+nz; z++) {
+            char* to = wholeRows ? out : &rows[0];
+            int items = (int)(ny*width*perCell), n = 0;
+            ok = VSeekData( fp, (off_t)(z*height + y0)*width*cellBytes ) == 0
+              && VReadData( to, size, items, fp, &n ) == 0
+              && n == items;
+            if (wholeRows) {
+                out += ny*width*cellBytes;
+                continue;
+            }
+            for (long y=0; ok && y<ny; y++) {
+                memcpy( out, &rows[(y*width + x0)*cellBytes], nx*cellBytes );
+                out += nx*cellBytes;
+            }
+        }
+    }
+    fclose( fp );
+    if (!ok)
+        itkExceptionMacro( "Could not read the cells of " << m_FileName );
+}
+//----------------------------------------------------------------------
+bool IM0ImageIO::CanWriteFile ( const char* fileName ) {
+    return hasSceneExtension( fileName );
+}
+
+void IM0ImageIO::Write ( const void* buffer ) {
+    switch (m_ComponentType) {
+        case UCHAR  :  WriteCells( (const unsigned char*)  buffer );  break;
+        case CHAR   :  WriteCells( (const char*)           buffer );  break;
+        case USHORT :  WriteCells( (const unsigned short*) buffer );  break;
+        case SHORT  :  WriteCells( (const short*)          buffer );  break;
+        case UINT   :  WriteCells( (const unsigned int*)   buffer );  break;
+        case INT    :  WriteCells( (const int*)            buffer );  break;
+        case ULONG  :  WriteCells( (const unsigned long*)  buffer );  break;
+        case LONG   :  WriteCells( (const long*)           buffer );  break;
+        case FLOAT  :  WriteCells( (const float*)          buffer );  break;
+        case DOUBLE :  WriteCells( (const double*)         buffer );  break;
+        default :
+            itkExceptionMacro( "Unsupported pixel type for " << m_FileName );
+    }
+}
+
+/**
+ * Writes the header and then the cells, converted a slice at a time.
+ * Values are stored as IM0VolumeWriter stores them: their absolute values
+ * if DoAbs is on, else with negative values replaced by 0.
+ */
+template <typename T>
+void IM0ImageIO::WriteCells ( const T* data ) {
+    const long width  = m_Dimensions[0];
+    const long height = GetNumberOfDimensions()>1 ? m_Dimensions[1] : 1;
+    const long slices = GetNumberOfDimensions()>2 ? m_Dimensions[2] : 1;
+    const long sliceSize = width * height;
+
+    double dmin = 0, dmax = 0;
+    for (long i=0; i<sliceSize*slices; i++) {
+        if (i==0 || data[i]<dmin)    dmin = data[i];
+        if (i==0 || data[i]>dmax)    dmax = data[i];
+    }
+    float fmin = static_cast<float>( dmin ), fmax = static_cast<float>( dmax );
+    if (m_DoAbs && dmin<0) {
+        fmin = 0;
+        if (-dmin > fmax)    fmax = static_cast<float>( -dmin );
+    }
+    printf( "min=%.2f, max=%.2f \n", fmin, fmax );
+
+    /* set up viewnix header */
+    ViewnixHeader vh;
+    memset( &vh, 0, sizeof(vh) );
+    strcpy( vh.gen.recognition_code, "VIEWNIX1.0" );
+    vh.gen.recognition_code_valid = 1;
+    vh.gen.data_type = IMAGE0;
+    vh.gen.data_type_valid = 1;
+    strncpy( vh.gen.filename, m_FileName.c_str(), sizeof(vh.gen.filename)-1 );
+
+    vh.scn.dimension = 3;
+    vh.scn.dimension_valid = 1;
+    vh.scn.xysize[0] = (short)width;
+    vh.scn.xysize[1] = (short)height;
+    vh.scn.xysize_valid = 1;
+    short numOfSubscenes = (short)slices;
+    vh.scn.num_of_subscenes = &numOfSubscenes;
+    vh.scn.num_of_subscenes_valid = 1;
+    vh.scn.xypixsz[0] = (float)GetSpacing( 0 );
+    vh.scn.xypixsz[1] = GetNumberOfDimensions()>1 ? (float)GetSpacing( 1 ) : 1;
+    vh.scn.xypixsz_valid = 1;
+    std::vector<float> locations( slices );
+    for (long z=1; z<slices; z++)
+        locations[z] = locations[z-1] + (float)GetSpacing( 2 );
+    vh.scn.loc_of_subscenes = &locations[0];
+    vh.scn.loc_of_subscenes_valid = 1;
+    vh.scn.smallest_density_value = &fmin;
+    vh.scn.largest_density_value  = &fmax;
+    vh.scn.smallest_density_value_valid = 1;
+    vh.scn.largest_density_value_valid  = 1;
+    if (m_OutputDoubleData)
+        vh.scn.num_of_bits = sizeof(double) * 8;
+    else if (fmin>=0 && fmax<=255)
+        vh.scn.num_of_bits = 8;  /* only numbers 8 and 16 are allowed */
+    else
+        vh.scn.num_of_bits = 16;
+    vh.scn.num_of_bits_valid = 1;
+    vh.scn.num_of_density_values = 1;
+    vh.scn.num_of_density_values_valid = 1;
+    vh.scn.num_of_integers = vh.scn.num_of_density_values;
+    vh.scn.num_of_integers_valid = 1;
+    short bitFields[2] = { vh.scn.num_of_bits, (short)(vh.scn.num_of_bits-1) };
+    vh.scn.bit_fields = bitFields;
+    vh.scn.bit_fields_valid = 1;
+
+    FILE* fp = fopen( m_FileName.c_str(), "wb" );
+    if (fp == NULL)
+        itkExceptionMacro( "Could not open output file " << m_FileName );
+    char group[6], element[6];
+    int error = VWriteHeader( fp, &vh, group, element );
+    if (error > 0 && error < 106) {
+        fclose( fp );
+        itkExceptionMacro( "Could not write header of " << m_FileName );
+    }
+
+    const int bits = vh.scn.num_of_bits;
+    std::vector<unsigned char>  out8 ( bits==8  ? sliceSize : 0 );
+    std::vector<unsigned short> out16( bits==16 ? sliceSize : 0 );
+    std::vector<double>         out64( bits==64 ? sliceSize : 0 );
+    bool ok = true;
+    for (long z=0; ok && z<slices; z++) {
+        const T* in = data + z*sliceSize;
+        for (long i=0; i<sliceSize; i++) {
+            double v = static_cast<double>( in[i] );
+            if (v < 0)    v = m_DoAbs ? -v : 0;
+            if (bits == 8)         out8[i]  = static_cast<unsigned char>( v );
+            else if (bits == 16)   out16[i] = static_cast<unsigned short>( static_cast<int>(v) );
+            else                   out64[i] = v;
+        }
+        int n = 0;
+        if (bits == 8)
+            ok = VWriteData( (char*)&out8[0], 1, (int)sliceSize, fp, &n ) == 0;
+        else if (bits == 16)
+            ok = VWriteData( (char*)&out16[0], 2, (int)sliceSize, fp, &n ) == 0;
+        else
+            ok = VWriteData( (char*)&out64[0], sizeof(double)/2, 2*(int)sliceSize, fp, &n ) == 0;
+    }
+    fclose( fp );
+    if (!ok)
+        itkExceptionMacro( "Could not write the cells of " << m_FileName );
+}
+
+} // namespace itk
@@ -0,0 +1,97 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _itkIM0ImageIO_h
+#define _itkIM0ImageIO_h
+
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+
+/** \class IM0ImageIO
+ *
+ * ImageIO for 3DVIEWNIX scenes (IM0, and BIM with 1 bit per cell).
+ *
+ * Cells are read straight into the buffer given by ImageFileReader.
+ * CanStreamRead() is true, so only the slices (rows, columns) of the
+ * requested region are read; a reader followed by a StreamingImageFilter
+ * then holds no more than a piece of the scene at a time.  BIM cells are
+ * unpacked to 0 and 1 as each slice is read.
+ *
+ * As IM0VolumeWriter always has, Write() picks 8 bits per cell if the
+ * values are all in [0,255], else 16 (negative values become 0 unless
+ * DoAbs is on), or 64-bit doubles if OutputDoubleData is on.  The data
+ * are converted and written a slice at a time.
+ *
+ * Register IM0ImageIOFactory (or give an IM0ImageIO to the reader or
+ * writer) for ImageFileReader and ImageFileWriter to use it.
+ */
+class IM0ImageIO : public ImageIOBase {
+public:
+    /** Standard class typedefs. */
+    typedef IM0ImageIO           Self;
+    typedef ImageIOBase          Superclass;
+    typedef SmartPointer<Self>   Pointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self);
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(IM0ImageIO, ImageIOBase);
+
+    /** Take the absolute value of negative values when writing. */
+    itkSetMacro(DoAbs, bool);
+    itkGetConstMacro(DoAbs, bool);
+
+    /** Write 64-bit doubles. */
+    itkSetMacro(OutputDoubleData, bool);
+    itkGetConstMacro(OutputDoubleData, bool);
+
+    bool CanReadFile ( const char* fileName ) override;
+    bool CanStreamRead ( ) override { return true; }
+    void ReadImageInformation ( ) override;
+    void Read ( void* buffer ) override;
+
+    bool CanWriteFile ( const char* fileName ) override;
+    /** The header depends on the data, so it is written by Write(). */
+    void WriteImageInformation ( ) override { }
+    void Write ( const void* buffer ) override;
+
+protected:
+    IM0ImageIO ( );
+    ~IM0ImageIO ( ) override { }
+    void PrintSelf ( std::ostream& os, Indent indent ) const override;
+
+private:
+    IM0ImageIO ( const Self& );     //purposely not implemented
+    void operator= ( const Self& ); //purposely not implemented
+
+    template <typename T> void WriteCells ( const T* data );
+
+    int   m_BitsPerCell;   ///< of the scene read: 1, 8, 16 or 64
+    bool  m_DoAbs;
+    bool  m_OutputDoubleData;
+};
+
+} // namespace itk
+
+#endif
@@ -0,0 +1,49 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "itkIM0ImageIOFactory.h"
+#include "itkIM0ImageIO.h"
+#include "itkVersion.h"
+
+namespace itk {
+
+IM0ImageIOFactory::IM0ImageIOFactory ( ) {
+    this->RegisterOverride( "itkImageIOBase", "itkIM0ImageIO",
+                            "3DVIEWNIX IM0/BIM Image IO", 1,
+                            CreateObjectFunction<IM0ImageIO>::New() );
+}
+
+const char* IM0ImageIOFactory::GetITKSourceVersion ( ) const {
+    return ITK_SOURCE_VERSION;
+}
+
+const char* IM0ImageIOFactory::GetDescription ( ) const {
+    return "3DVIEWNIX IM0/BIM ImageIO Factory, allows the loading of 3DVIEWNIX scenes into ITK";
+}
+
+void IM0ImageIOFactory::RegisterOneFactory ( ) {
+    static bool registered = false;
+    if (registered)    return;
+    registered = true;
+    ObjectFactoryBase::RegisterFactory( IM0ImageIOFactory::New() );
+}
+
+} // namespace itk
@@ -0,0 +1,68 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _itkIM0ImageIOFactory_h
+#define _itkIM0ImageIOFactory_h
+
+#include "itkObjectFactoryBase.h"
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+
+/** \class IM0ImageIOFactory
+ *
+ * Creates an IM0ImageIO, so that ImageFileReader and ImageFileWriter
+ * handle IM0 and BIM files once RegisterOneFactory() has been called.
+ */
+class IM0ImageIOFactory : public ObjectFactoryBase {
+public:
+    /** Standard class typedefs. */
+    typedef IM0ImageIOFactory         Self;
+    typedef ObjectFactoryBase         Superclass;
+    typedef SmartPointer<Self>        Pointer;
+    typedef SmartPointer<const Self>  ConstPointer;
+
+    /** Class methods used to interface with the registered factories. */
+    const char* GetITKSourceVersion ( ) const override;
+    const char* GetDescription ( ) const override;
+
+    /** Method for class instantiation. */
+    itkFactorylessNewMacro(Self);
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(IM0ImageIOFactory, ObjectFactoryBase);
+
+    /** Register one factory of this type (once, however often called). */
+    static void RegisterOneFactory ( );
+
+protected:
+    IM0ImageIOFactory ( );
+    ~IM0ImageIOFactory ( ) override { }
+
+private:
+    IM0ImageIOFactory ( const Self& );  //purposely not implemented
+    void operator= ( const Self& );     //purposely not implemented
+};
+
+} // namespace itk
+
+#endif
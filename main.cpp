@@ -35,6 +35,7 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include  "cavass.h"
 #include  <wx/stdpaths.h>
 #include  "MontageCanvas.h"
+#include  "ChunkData.h"
 
 #include  "frames/ExampleFrame.h"
 #include  "frames/segment2d/Segment2dFrame.h"
@@ -289,20 +290,27 @@ void changeAllWindowMenus ( wxString from, wxString to ) {
     }
 }
 //----------------------------------------------------------------------
+/** \brief   apply the contrast lookup table and rgb weights of a scene
+*            to one slice of data.
+*   \param   cd is the scene
+*   \param   p is the slice data (of the current slice at some resolution)
+*   \param   w is the width of the slice data
+*   \param   h is the height of the slice data
+*   \returns w by h rgb data (malloc'd by this function so the caller
+*            must free it)
+*/
 template< typename T >
-static unsigned char* lookup ( CavassData& cd, T dummy ) {
-    assert( cd.mDisplay );
-    assert( 0<=cd.m_sliceNo && cd.m_sliceNo<cd.m_zSize );
-
-    unsigned char*  slice = (unsigned char*)malloc( cd.m_xSize * cd.m_ySize * 3 );  //3 for rgb data
+static unsigned char* lookup ( CavassData& cd, const T* const p, const int w,
+                               const int h )
+{
+    unsigned char*  slice = (unsigned char*)malloc( w * h * 3 );  //3 for rgb data
     assert( slice!=NULL );
 
     int  dst = 0;  //offset into result rgb data
     int  offset = 0;  //offset from beginning of (original, gray or color) slice data
-    const T* const  p = (const T* const)cd.getSlice( cd.m_sliceNo );
     if (cd.mSamplesPerPixel==1) {
-        for (int y=0; y<cd.m_ySize; y++) {
-            for (int x=0; x<cd.m_xSize; x++) {
+        for (int y=0; y<h; y++) {
+            for (int x=0; x<w; x++) {
                 int  index = (int)(p[offset++] - cd.m_min);
                 assert( 0 <= index && index <= cd.m_max-cd.m_min );
                 double  red   = cd.mR * cd.m_lut[ index ];
@@ -324,8 +332,8 @@ static unsigned char* lookup ( CavassData& cd, T dummy ) {
             }
         }
     } else if (cd.mSamplesPerPixel==3) {
-        for (int y=0; y<cd.m_ySize; y++) {
-            for (int x=0; x<cd.m_xSize; x++) {
+        for (int y=0; y<h; y++) {
+            for (int x=0; x<w; x++) {
                 const double  red   = cd.mR * cd.m_lut[ (int)(p[offset++]-cd.m_min) ];
                 const double  green = cd.mG * cd.m_lut[ (int)(p[offset++]-cd.m_min) ];
                 const double  blue  = cd.mB * cd.m_lut[ (int)(p[offset++]-cd.m_min) ];
@@ -350,6 +358,15 @@ static unsigned char* lookup ( CavassData& cd, T dummy ) {
     return slice;
 }
 //----------------------------------------------------------------------
+template< typename T >
+static unsigned char* lookup ( CavassData& cd, T dummy ) {
+    assert( cd.mDisplay );
+    assert( 0<=cd.m_sliceNo && cd.m_sliceNo<cd.m_zSize );
+
+    return lookup( cd, (const T*)cd.getSlice( cd.m_sliceNo ), cd.m_xSize,
+                   cd.m_ySize );
+}
+//----------------------------------------------------------------------
 /** \brief   create the displayed data from the image data.
 *   \param   cd is the source image data
 *   \returns one composited slice of rgb data (malloc'd by this
@@ -382,6 +399,46 @@ unsigned char* toRGB ( CavassData& cd ) {
     return NULL;
 }
 //----------------------------------------------------------------------
+/** \brief   create the displayed data for display at a reduced scale.
+*   \param   cd is the source image data
+*   \param   sx is the display scale (displayed pixels per pixel) in x
+*   \param   sy is the display scale in y
+*   \param   w receives the width of the result
+*   \param   h receives the height of the result
+*   \returns one composited slice of rgb data from the coarsest level of
+*            the scene's pyramid that still has at least the displayed
+*            resolution, or from the full resolution data if there is no
+*            such level (malloc'd by this function so the caller must
+*            free it).  the caller rescales it to the displayed size.
+*/
+unsigned char* toRGBReduced ( CavassData& cd, double sx, double sy,
+                              int& w, int& h )
+{
+    const int    level = ScenePyramid::levelFor( sx, sy );
+    ChunkData*   chunk = dynamic_cast<ChunkData*>( &cd );
+    ScenePyramid*  pyramid = NULL;
+    const void*  p = NULL;
+    if (level>0 && chunk!=NULL && cd.mDisplay)
+        pyramid = chunk->getPyramid( Preferences::getPyramidCache() );
+    if (pyramid!=NULL)
+        p = pyramid->getSlice( level, cd.m_sliceNo );
+    if (p==NULL) {
+        w = cd.m_xSize;
+        h = cd.m_ySize;
+        return toRGB( cd );
+    }
+    w = pyramid->getWidth( level );
+    h = pyramid->getHeight( level );
+    const int  bytes = cd.m_size / cd.mSamplesPerPixel;
+    if (bytes==1 && cd.m_min>=0)
+        return lookup( cd, (const unsigned char*)p, w, h );
+    if (bytes==1)
+        return lookup( cd, (const signed char*)p, w, h );
+    if (cd.m_min>=0)
+        return lookup( cd, (const unsigned short*)p, w, h );
+    return lookup( cd, (const signed short*)p, w, h );
+}
+//----------------------------------------------------------------------
 inline static int interpolate ( int a,  int b,  int c,  int d,
                                 int x1, int x2, int y1, int y2,
                                 double xPos, double yPos )
@@ -573,6 +630,8 @@ class CavassMain : public wxApp {
 
         loadConfig();
 		::modifyEnvironment( (char *)(const char *)argv[0].c_str() );
+        ChunkData::setCacheBudget( Preferences::getSliceCacheMB() );
+        VEnableSceneStatsCache();
 
         wxInitAllImageHandlers();
         gLogWindow = new wxLogWindow( nullptr, "log", false, false );
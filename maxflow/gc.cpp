@@ -68,11 +68,15 @@ extern "C" {
 	int VDecodeError(char[], const char[], int, char[]);
 	int VSeekData(FILE *, int);
 	int VReadData(unsigned char *, int, int, FILE *, int *);
+	float *VAffinityTable(int, float (*)(int, int, void *), void *);
 }
 
 void load_volume(int), load_fom(), load_dfom(), load_feature_map();
 int affinity(int a, int b, float adjacency, int ax, int ay, int az,
 	int bx, int by, int bz);
+float pair_affinity(int a, int b, int ax, int ay, int az, int bx, int by,
+	int bz);
+void make_affinity_table(void);
 int fom_value(int col, int row, int slc);
 int dfom_value(int col, int row, int slc);
 int input_slice_index(int volume, int slice);
@@ -121,6 +125,8 @@ static unsigned short gray_map[0x10000];
 static int *hist_bin_table[3], bins_per_feature;
 static unsigned short ***threeD_hist;
 static FILE *outstream;
+static float *affinity_table; /* pair_affinity by values; NULL if none */
+static int affinity_levels; /* values in affinity_table */
 
 /*****************************************************************************
  * FUNCTION: main
@@ -314,6 +320,7 @@ int main(int argc, char *argv[])
 	load_dfom();
 	if (feature_status[7])
 		load_feature_map();
+	make_affinity_table();
 
 	float x_adjacency, y_adjacency, z_adjacency;
 
@@ -639,12 +646,39 @@ switch (feature_n) \
 /*****************************************************************************
  * FUNCTION: affinity
  * DESCRIPTION: Returns the affinity scaled to adjacency for adjacent
- *    voxel values.
+ *    voxel values, from affinity_table if the values are in it.
  * PARAMETERS:
  *    a, b: The values of the adjacent voxels
  *    adjacency: The fuzzy adjacency between the two voxels scaled to
  *       MAX_CONNECTIVITY.
- * SIDE EFFECTS:
+ *    ax, ay, az, bx, by, bz: The coordinates of the voxels
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met;
+ *    affinity_table, affinity_levels must be properly set.
+ * RETURN VALUE: the affinity scaled to MAX_CONNECTIVITY
+ * EXIT CONDITIONS: On error, writes a message to stderr and exits with code 1.
+ * HISTORY:
+ *    Created: 4/2/96 by Dewey Odhner
+ *    Modified: 1/29/98 fuzzy adjacency passed by Dewey Odhner
+ *    Modified: 10/19/26 affinity_table used
+ *
+ *****************************************************************************/
+int affinity(int a, int b, float adjacency, int ax, int ay, int az,
+	int bx, int by, int bz)
+{
+	if (affinity_table && a<affinity_levels && b<affinity_levels)
+		return (int)(affinity_table[a*affinity_levels+b]*adjacency);
+	return (int)(pair_affinity(a, b, ax, ay, az, bx, by, bz)*adjacency);
+}
+
+/*****************************************************************************
+ * FUNCTION: pair_affinity
+ * DESCRIPTION: Returns the affinity for adjacent voxel values on a scale
+ *    of 1, before adjacency is applied.
+ * PARAMETERS:
+ *    a, b: The values of the adjacent voxels
+ *    ax, ay, az, bx, by, bz: The coordinates of the voxels
+ * SIDE EFFECTS: None
  * ENTRY CONDITIONS: The variables feature_status, function_level,
  *    function_width, weight, function_selected, file_info, vh_in,
  *    in_data, affinity_type, histogram_bins, histogram_counts,
@@ -654,7 +688,8 @@ switch (feature_n) \
  *    weight_unit, vh_fom, fom_data, slice_spacing, rel_scale, translation,
  *    i_weight_unit, dfom_data, dfom_filename
  *    must be properly set.
- * RETURN VALUE: the affinity scaled to MAX_CONNECTIVITY
+ * RETURN VALUE: the affinity on a scale of 1 (in which the fuzzy adjacency
+ *    scaled to MAX_CONNECTIVITY is the largest)
  * EXIT CONDITIONS: On error, writes a message to stderr and exits with code 1.
  * HISTORY:
  *    Created: 4/2/96 by Dewey Odhner
@@ -662,10 +697,11 @@ switch (feature_n) \
  *    Modified: 5/31/96 dual-histogram-type affinity allowed by Dewey Odhner
  *    Modified: 7/26/96 covariance affinity type allowed by Dewey Odhner
  *    Modified: 1/29/98 fuzzy adjacency passed by Dewey Odhner
+ *    Modified: 10/19/26 adjacency applied by affinity
  *
  *****************************************************************************/
-int affinity(int a, int b, float adjacency, int ax, int ay, int az,
-	int bx, int by, int bz)
+float pair_affinity(int a, int b, int ax, int ay, int az, int bx, int by,
+	int bz)
 {
 	int feature_n, high, low, t_count, features_on, on_feature_n, on_feature_m;
 	float temp_affinity, feature_val, xrel, on_feature_val[NUM_FEATURES],
@@ -1016,7 +1052,54 @@ int affinity(int a, int b, float adjacency, int ax, int ay, int az,
 	}
 	if (temp_affinity2 < temp_affinity)
 		temp_affinity = temp_affinity2;
-	return (int)(temp_affinity*adjacency);
+	return temp_affinity;
+}
+
+/*****************************************************************************
+ * FUNCTION: table_affinity
+ * DESCRIPTION: Returns pair_affinity for values of voxels whose position
+ *    does not matter; for VAffinityTable.
+ * PARAMETERS:
+ *    a, b: The values of the adjacent voxels
+ *    client: Not used
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met.
+ * RETURN VALUE: the affinity on a scale of 1
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static float table_affinity(int a, int b, void *client)
+{
+	return pair_affinity(a, b, 0, 0, 0, 0, 0, 0);
+}
+
+/*****************************************************************************
+ * FUNCTION: make_affinity_table
+ * DESCRIPTION: Tabulates pair_affinity over all pairs of voxel values, if
+ *    the affinity does not depend on voxel position and the values are few
+ *    enough, so that building the graph need not evaluate the feature
+ *    transforms for each pair of adjacent voxels.
+ * PARAMETERS: None
+ * SIDE EFFECTS: affinity_table, affinity_levels are set; affinity_table
+ *    is left NULL for direct evaluation.
+ * ENTRY CONDITIONS: The entry conditions of pair_affinity must be met;
+ *    threeD_hist must be properly set.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void make_affinity_table(void)
+{
+	/* fuzzy object model features depend on position */
+	if (dfom_filename || (affinity_type==3 && ((feature_status[6] &&
+			weight[6]) || (feature_status[7] && threeD_hist))))
+		return;
+	affinity_levels = largest_density_value+1;
+	affinity_table = VAffinityTable(affinity_levels, table_affinity, NULL);
 }
 
 /*****************************************************************************
@@ -0,0 +1,293 @@
+#!/usr/bin/python3
+
+"""
+persistent MedSAM/SAM worker for interactive segmentation in cavass
+(Segment2dIntDLControls via SamWorker).
+
+inference.py starts python, imports torch, loads the checkpoint and
+computes the image embedding for every box.  this worker is started once
+and keeps the model loaded.  image embeddings are cached per (scene,
+slice), so another box on the same slice only runs the prompt encoder and
+mask decoder.  slices sent with the prefetch flag (the neighbors of the
+current slice) are embedded by a background thread.
+
+requests are read from stdin and replies written to stdout.  both are
+binary and little-endian:
+    request:  uint32 command, uint32 payload length, payload
+    reply:    int32 status (0 is ok), uint32 payload length, payload
+a string is a uint32 length followed by that many bytes of utf-8.
+
+    LOAD     checkpoint (string), device (string)
+    HAS      scene (string), int32 slice
+             -> uint8 1 if the slice has been sent, else 0
+    IMAGE    scene (string), int32 slice, int32 prefetch, uint32 width,
+             uint32 height, width*height uint16 values
+    SEGMENT  scene (string), int32 slice, int32 x0, y0, x1, y1 (the box)
+             -> uint32 width, uint32 height, width*height uint8 (0 or 1)
+    QUIT
+
+the worker exits on QUIT or when stdin is closed.  messages go to stderr.
+
+usage:
+    python3 sam_worker.py
+"""
+
+import collections
+import os
+import queue
+import struct
+import sys
+import threading
+import time
+
+LOAD, HAS, IMAGE, SEGMENT, QUIT = 1, 2, 3, 4, 5
+OK, FAILED, UNKNOWN_SLICE, BAD_REQUEST = 0, 1, 2, 3
+
+CACHE_SLICES = 24    # slices (and their 4 MB embeddings) kept; oldest dropped
+
+
+def log ( msg ):
+    sys.stderr.write( 'sam_worker: %s\n' % msg )
+    sys.stderr.flush()
+
+
+# the heavy imports are done once, here, rather than for every box
+start = time.time()
+import numpy as np
+import torch
+import torch.nn.functional as F
+from segment_anything import sam_model_registry
+from skimage import transform
+log( 'imports e.t. = %.2f' % (time.time()-start) )
+
+
+class Reader:
+    """ unpacks the payload of a request """
+    def __init__ ( self, payload ):
+        self.payload = payload
+        self.at = 0
+
+    def take ( self, n ):
+        if self.at + n > len(self.payload):
+            raise ValueError( 'request too short' )
+        b = self.payload[ self.at : self.at+n ]
+        self.at += n
+        return b
+
+    def int32 ( self ):
+        return struct.unpack( '<i', self.take(4) )[0]
+
+    def uint32 ( self ):
+        return struct.unpack( '<I', self.take(4) )[0]
+
+    def string ( self ):
+        return self.take( self.uint32() ).decode( 'utf-8' )
+
+
+class Slice:
+    """ a slice as sent and, once computed, its image embedding """
+    def __init__ ( self, pixels ):
+        self.pixels = pixels         # (H, W) uint16
+        self.embedding = None        # (1, 256, 64, 64) on the device
+        self.model = None            # the model that computed embedding
+        self.lock = threading.Lock() # held while embedding is computed
+
+
+class Worker:
+    def __init__ ( self ):
+        self.model = None
+        self.checkpoint = None
+        self.device = None
+        # (scene, slice) -> Slice, least recently used first
+        self.slices = collections.OrderedDict()
+        self.lock = threading.Lock()        # guards slices and the model
+        self.prefetch = queue.Queue()
+        threading.Thread( target=self.prefetcher, daemon=True ).start()
+
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    def load ( self, r ):
+        checkpoint = r.string()
+        device = r.string()
+        if device.startswith( 'cuda' ) and not torch.cuda.is_available():
+            log( 'cuda is not available; using cpu' )
+            device = 'cpu'
+        if device == 'mps' and not torch.backends.mps.is_available():
+            log( 'mps is not available; using cpu' )
+            device = 'cpu'
+        if checkpoint == self.checkpoint and device == self.device:
+            return OK, b''
+        start = time.time()
+        model = sam_model_registry["vit_b"]( checkpoint=checkpoint )
+        model = model.to( device )
+        model.eval()
+        log( 'load model file e.t. = %.2f' % (time.time()-start) )
+        # embeddings made by the previous model are recomputed when used
+        with self.lock:
+            self.model, self.checkpoint, self.device = model, checkpoint, device
+        return OK, b''
+
+    def has ( self, r ):
+        key = ( r.string(), r.int32() )
+        with self.lock:
+            known = key in self.slices
+        return OK, struct.pack( '<B', 1 if known else 0 )
+
+    def image ( self, r ):
+        key = ( r.string(), r.int32() )
+        prefetch = r.int32()
+        w = r.uint32()
+        h = r.uint32()
+        pixels = np.frombuffer( r.take(2*w*h), dtype='<u2' ).reshape( h, w )
+        with self.lock:
+            self.slices[ key ] = Slice( pixels.copy() )
+            self.slices.move_to_end( key )
+            while len(self.slices) > CACHE_SLICES:
+                self.slices.popitem( last=False )
+        if prefetch:
+            self.prefetch.put( key )
+        return OK, b''
+
+    def segment ( self, r ):
+        key = ( r.string(), r.int32() )
+        box = [ r.int32() for i in range(4) ]
+        with self.lock:
+            model, device = self.model, self.device
+            s = self.slices.get( key )
+            if s is not None:
+                self.slices.move_to_end( key )
+        if model is None:
+            log( 'no model loaded' )
+            return FAILED, b''
+        if s is None:
+            return UNKNOWN_SLICE, b''
+        embedding = self.embedding( s, model, device )
+        start = time.time()
+        H, W = s.pixels.shape
+        box_np = np.array( [box] )
+        box_1024 = box_np / np.array( [W, H, W, H] ) * 1024
+        seg = medsam_inference( model, embedding, box_1024, H, W )
+        log( 'inference e.t. = %.2f' % (time.time()-start) )
+        return OK, struct.pack( '<II', W, H ) + seg.astype( np.uint8 ).tobytes()
+
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    def embedding ( self, s, model, device ):
+        """ the embedding of slice s by model, computed if necessary.  if
+            the prefetcher is computing it, this waits for it. """
+        with s.lock:
+            if s.embedding is None or s.model is not model:
+                start = time.time()
+                s.embedding = embed( model, device, s.pixels )
+                s.model = model
+                log( 'image encoder e.t. = %.2f' % (time.time()-start) )
+            return s.embedding
+
+    def prefetcher ( self ):
+        """ embeds prefetched slices in the background """
+        while True:
+            key = self.prefetch.get()
+            with self.lock:
+                model, device = self.model, self.device
+                s = self.slices.get( key )
+            if s is None or model is None:
+                continue
+            try:
+                self.embedding( s, model, device )
+            except Exception as e:
+                log( 'prefetch of %s slice %d failed: %s' % (key[0], key[1], e) )
+
+    # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    def serve ( self, fin, fout ):
+        handlers = { LOAD: self.load, HAS: self.has, IMAGE: self.image,
+                     SEGMENT: self.segment }
+        while True:
+            header = read_fully( fin, 8 )
+            if header is None:
+                return
+            command, n = struct.unpack( '<II', header )
+            payload = read_fully( fin, n )
+            if payload is None:
+                return
+            if command == QUIT:
+                return
+            handler = handlers.get( command )
+            if handler is None:
+                status, reply = BAD_REQUEST, b''
+            else:
+                try:
+                    status, reply = handler( Reader(payload) )
+                except Exception as e:
+                    log( 'command %d failed: %s' % (command, e) )
+                    status, reply = FAILED, b''
+            fout.write( struct.pack( '<iI', status, len(reply) ) )
+            fout.write( reply )
+            fout.flush()
+
+
+def read_fully ( f, n ):
+    """ n bytes from f, or None at end of file """
+    b = b''
+    while len(b) < n:
+        more = f.read( n - len(b) )
+        if not more:
+            return None
+        b += more
+    return b
+
+
+def embed ( model, device, pixels ):
+    """ the image embedding of pixels (same preprocessing as inference.py) """
+    img_np = pixels.astype( np.float64 )
+    max = np.max( img_np )
+    if max > 0:
+        img_np = img_np / max
+    img_3c = np.repeat( img_np[:, :, None], 3, axis=-1 )
+    img_1024 = transform.resize(
+        img_3c, (1024, 1024), order=3, preserve_range=True, anti_aliasing=True
+    )
+    img_1024 = (img_1024 - img_1024.min()) / np.clip(
+        img_1024.max() - img_1024.min(), a_min=1e-8, a_max=None
+    )  # normalize to [0, 1], (H, W, 3)
+    img_1024_tensor = (
+        torch.tensor(img_1024).float().permute(2, 0, 1).unsqueeze(0).to(device)
+    )
+    with torch.no_grad():
+        return model.image_encoder( img_1024_tensor )  # (1, 256, 64, 64)
+
+
+@torch.no_grad()
+def medsam_inference(medsam_model, img_embed, box_1024, H, W):
+    """ as in inference.py """
+    box_torch = torch.as_tensor(box_1024, dtype=torch.float, device=img_embed.device)
+    if len(box_torch.shape) == 2:
+        box_torch = box_torch[:, None, :]  # (B, 1, 4)
+
+    sparse_embeddings, dense_embeddings = medsam_model.prompt_encoder(
+        points=None,
+        boxes=box_torch,
+        masks=None,
+    )
+    low_res_logits, _ = medsam_model.mask_decoder(
+        image_embeddings=img_embed,  # (B, 256, 64, 64)
+        image_pe=medsam_model.prompt_encoder.get_dense_pe(),  # (1, 256, 64, 64)
+        sparse_prompt_embeddings=sparse_embeddings,  # (B, 2, 256)
+        dense_prompt_embeddings=dense_embeddings,  # (B, 256, 64, 64)
+        multimask_output=False,
+    )
+
+    low_res_pred = torch.sigmoid(low_res_logits)  # (1, 1, 256, 256)
+
+    low_res_pred = F.interpolate(
+        low_res_pred,
+        size=(H, W),
+        mode="bilinear",
+        align_corners=False,
+    )  # (1, 1, gt.shape)
+    low_res_pred = low_res_pred.squeeze().cpu().numpy()  # (256, 256)
+    medsam_seg = (low_res_pred > 0.5).astype(np.uint8)
+    return medsam_seg
+
+
+if __name__ == '__main__':
+    log( 'ready (pid %d)' % os.getpid() )
+    Worker().serve( sys.stdin.buffer, sys.stdout.buffer )
+    log( 'done' )
@@ -0,0 +1,697 @@
+/*
+  Copyright 1993-2011, 2017 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+//======================================================================
+/**
+ * \file   bspline_mi.c
+ * \brief  Mutual-information B-spline registration engine.
+ * \notes: The control point weights of every voxel are separable, so they
+ *   are tabulated once per axis and control point spacing instead of
+ *   calling B3() for all 64 supporting points of every sample.  The cost
+ *   (negative Mattes mutual information with a cubic Parzen window on the
+ *   test image and a box window on the reference image) and its analytic
+ *   gradient with respect to ALL control points are computed in two
+ *   parallel passes over a fixed sample set, using per-thread joint
+ *   histograms and per-thread gradient buffers.  The control mesh is then
+ *   updated by limited-memory BFGS with a backtracking line search, in
+ *   place of one-control-point-at-a-time gradient steps.
+ */
+//======================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#define omp_get_thread_num()  0
+#endif
+#include "bspline_mi.h"
+
+/* Cubic B-spline and its derivative (same as B3() and dB3() in nonrigid.c). */
+static float B3 ( float x )
+{
+    float absx=x<0? -x: x, t;
+
+    if (absx < 1)
+        return (4+3*x*x*absx)/6-x*x;
+    if (absx < 2)
+    {
+        t = 2-absx;
+        return t*t*t/6;
+    }
+    return 0;
+}
+
+static float dB3 ( float x )
+{
+    float absx=x<0? -x: x;
+
+    if (absx <= 1)
+        return (1.5f*absx-2)*x;
+    if (absx < 2)
+        return x>1? 2*x-x*x/2-2: x*x/2+2*x+2;
+    return 0;
+}
+
+/* State shared by the cost/gradient evaluations of one optimization. */
+typedef struct _MIContext {
+    BSplineWeights  wx, wy, wz;
+    const float    *test;
+    int             xdim, ydim, zdim;
+    int             cnumx, cnumy, cnumz;
+    int             RBINNUM, TBINNUM;
+    float           fT0, binT;
+    int             nsamples;
+    int            *sx, *sy, *sz;  /* sample positions */
+    int            *sk;            /* reference bin of each sample */
+    float          *slp;           /* test bin coordinate of each sample */
+    float          *sdf;           /* test image gradient, 0 if clamped */
+    int             nthreads;
+    double         *thist;         /* per-thread joint histograms */
+    double         *tgrad;         /* per-thread gradient buffers */
+    double         *logratio;      /* log(p(l,k)/pT(l)) */
+} MIContext;
+
+/*****************************************************************************
+ * FUNCTION: bspline_weights_init
+ * DESCRIPTION: Tabulates the cubic B-spline weights of the control points
+ *    supporting each voxel along one axis.
+ * PARAMETERS:
+ *    t: the table to initialize
+ *    dim: number of voxels along the axis
+ *    space: control point spacing in voxels
+ *    cnum: number of control points along the axis
+ * RETURN VALUE: 0 on success, 1 if out of memory.
+ *****************************************************************************/
+int bspline_weights_init ( BSplineWeights *t, int dim, float space, int cnum )
+{
+    int x, n, i;
+    float u;
+
+    t->dim = dim;
+    t->cnum = cnum;
+    t->first = (int *)malloc(dim*sizeof(int));
+    t->w = (float *)malloc(4*dim*sizeof(float));
+    if (t->first==NULL || t->w==NULL)
+    {
+        bspline_weights_free(t);
+        return 1;
+    }
+    for (x=0; x<dim; x++)
+    {
+        u = x/space;
+        t->first[x] = (int)floor(u)-1;
+        for (n=0; n<4; n++)
+        {
+            i = t->first[x]+n;
+            t->w[4*x+n] = i>=0 && i<cnum? B3(u-i): 0;
+        }
+    }
+    return 0;
+}
+
+void bspline_weights_free ( BSplineWeights *t )
+{
+    free(t->first);
+    free(t->w);
+    t->first = NULL;
+    t->w = NULL;
+}
+
+/* Reflect an index into [0, n) using the same mirror boundary as
+ * bsplineimage(). */
+static int mirror_index ( int i, int n )
+{
+    int period;
+
+    if (n == 1)
+        return 0;
+    period = 2*n-2;
+    i %= period;
+    if (i < 0)
+        i += period;
+    if (i >= n)
+        i = period-i;
+    return i;
+}
+
+/* Displacement of voxel (x,y,z) for the control mesh ctrl. */
+static void displacement ( const float *ctrl, const BSplineWeights *wx,
+    const BSplineWeights *wy, const BSplineWeights *wz, int x, int y, int z,
+    float d[3] )
+{
+    int a, b, c, ix, iy, iz, ipos;
+    const float *tx=wx->w+4*x, *ty=wy->w+4*y, *tz=wz->w+4*z;
+    float wyz, w;
+
+    d[0] = d[1] = d[2] = 0;
+    for (c=0; c<4; c++)
+    {
+        if (tz[c] == 0)
+            continue;
+        iz = wz->first[z]+c;
+        for (b=0; b<4; b++)
+        {
+            if (ty[b] == 0)
+                continue;
+            iy = wy->first[y]+b;
+            wyz = tz[c]*ty[b];
+            for (a=0; a<4; a++)
+            {
+                if (tx[a] == 0)
+                    continue;
+                ix = wx->first[x]+a;
+                w = wyz*tx[a];
+                ipos = ((iz*wy->cnum+iy)*wx->cnum+ix)*3;
+                d[0] += w*ctrl[ipos];
+                d[1] += w*ctrl[ipos+1];
+                d[2] += w*ctrl[ipos+2];
+            }
+        }
+    }
+}
+
+/* Cubic B-spline interpolation of the coefficient image at (px,py,pz);
+ * also returns the spatial gradient if grad is not NULL. */
+static float interpolate ( const float *coeff, int xdim, int ydim, int zdim,
+    float px, float py, float pz, float grad[3] )
+{
+    int n, a, b, c, lx, ly, lz, ix[4], iy[4], iz[4];
+    float bx[4], by[4], bz[4], dbx[4], dby[4], dbz[4];
+    float val, gx, gy, gz, ci, rowv, rowdx, byz;
+    const float *row;
+
+    /* keep runaway deformations inside int range */
+    if (!(px > -1e6f && px < 1e6f)) px = 0;
+    if (!(py > -1e6f && py < 1e6f)) py = 0;
+    if (!(pz > -1e6f && pz < 1e6f)) pz = 0;
+    lx = (int)floor(px)-1;
+    ly = (int)floor(py)-1;
+    lz = (int)floor(pz)-1;
+    for (n=0; n<4; n++)
+    {
+        bx[n] = B3(px-(lx+n)); ix[n] = mirror_index(lx+n, xdim);
+        by[n] = B3(py-(ly+n)); iy[n] = mirror_index(ly+n, ydim);
+        bz[n] = B3(pz-(lz+n)); iz[n] = mirror_index(lz+n, zdim);
+        if (grad)
+        {
+            dbx[n] = dB3(px-(lx+n));
+            dby[n] = dB3(py-(ly+n));
+            dbz[n] = dB3(pz-(lz+n));
+        }
+    }
+    val = gx = gy = gz = 0;
+    for (c=0; c<4; c++)
+        for (b=0; b<4; b++)
+        {
+            row = coeff+((long)iz[c]*ydim+iy[b])*xdim;
+            rowv = rowdx = 0;
+            for (a=0; a<4; a++)
+            {
+                ci = row[ix[a]];
+                rowv += ci*bx[a];
+                if (grad)
+                    rowdx += ci*dbx[a];
+            }
+            byz = by[b]*bz[c];
+            val += rowv*byz;
+            if (grad)
+            {
+                gx += rowdx*byz;
+                gy += rowv*dby[b]*bz[c];
+                gz += rowv*by[b]*dbz[c];
+            }
+        }
+    if (grad)
+    {
+        grad[0] = gx;
+        grad[1] = gy;
+        grad[2] = gz;
+    }
+    return val;
+}
+
+/*****************************************************************************
+ * FUNCTION: mi_evaluate
+ * DESCRIPTION: Computes the negative mutual information of the deformed
+ *    test image and the reference image over the sample set, and its
+ *    gradient with respect to every control point coordinate.
+ * PARAMETERS:
+ *    c: the optimization context
+ *    ctrl: the control mesh
+ *    grad: receives the gradient (cnumx*cnumy*cnumz*3 values)
+ * RETURN VALUE: -MI
+ *****************************************************************************/
+static double mi_evaluate ( MIContext *c, const float *ctrl, float *grad )
+{
+    int nbins=c->RBINNUM*c->TBINNUM, nparam=c->cnumx*c->cnumy*c->cnumz*3;
+    int s, l, k, i, t;
+    double N, mi, *hist=c->thist, *pT, *pR, p;
+
+    /* pass 1: warped intensities and per-thread joint histograms; all of
+       them are cleared, as a team may get fewer threads than nthreads */
+    memset(c->thist, 0, (long)c->nthreads*nbins*sizeof(double));
+#pragma omp parallel private(s, l)
+    {
+        double *h=c->thist+(long)omp_get_thread_num()*nbins;
+        float d[3], f, lp, g[3];
+        int l0;
+
+#pragma omp for schedule(static)
+        for (s=0; s<c->nsamples; s++)
+        {
+            displacement(ctrl, &c->wx, &c->wy, &c->wz,
+                c->sx[s], c->sy[s], c->sz[s], d);
+            f = interpolate(c->test, c->xdim, c->ydim, c->zdim,
+                c->sx[s]+d[0], c->sy[s]+d[1], c->sz[s]+d[2], g);
+            lp = (f-c->fT0)/c->binT+1;
+            if (lp < 1 || lp >= c->TBINNUM-2)
+            {
+                /* outside the histogram range: no gradient contribution */
+                lp = lp<1? 1: (float)(c->TBINNUM-2)-0.001f;
+                g[0] = g[1] = g[2] = 0;
+            }
+            c->slp[s] = lp;
+            c->sdf[3*s] = g[0];
+            c->sdf[3*s+1] = g[1];
+            c->sdf[3*s+2] = g[2];
+            l0 = (int)floor(lp)-1;
+            for (l=l0; l<l0+4; l++)
+                h[l*c->RBINNUM+c->sk[s]] += B3(l-lp);
+        }
+    }
+    for (t=1; t<c->nthreads; t++)
+        for (i=0; i<nbins; i++)
+            hist[i] += c->thist[(long)t*nbins+i];
+
+    pT = (double *)calloc(c->TBINNUM+c->RBINNUM, sizeof(double));
+    pR = pT+c->TBINNUM;
+    N = 0;
+    for (i=0; i<nbins; i++)
+        N += hist[i];
+    if (N <= 0)
+        N = 1;
+    for (l=0; l<c->TBINNUM; l++)
+        for (k=0; k<c->RBINNUM; k++)
+        {
+            p = hist[l*c->RBINNUM+k]/N;
+            pT[l] += p;
+            pR[k] += p;
+        }
+    mi = 0;
+    for (l=0; l<c->TBINNUM; l++)
+        for (k=0; k<c->RBINNUM; k++)
+        {
+            p = hist[l*c->RBINNUM+k]/N;
+            if (p > 0)
+            {
+                mi += p*log(p/(pT[l]*pR[k]));
+                c->logratio[l*c->RBINNUM+k] = log(p/pT[l]);
+            }
+            else
+                c->logratio[l*c->RBINNUM+k] = 0;
+        }
+    free(pT);
+
+    /* pass 2: scatter d(-MI)/d(position) onto the supporting control points */
+    memset(c->tgrad, 0, (long)c->nthreads*nparam*sizeof(double));
+#pragma omp parallel private(s, l, i)
+    {
+        double *gb=c->tgrad+(long)omp_get_thread_num()*nparam;
+        const float *tx, *ty, *tz;
+        double sum, dpos[3], w, wyz;
+        float lp;
+        int a, b, cc, x, y, z, l0, ipos;
+
+#pragma omp for schedule(static)
+        for (s=0; s<c->nsamples; s++)
+        {
+            if (c->sdf[3*s]==0 && c->sdf[3*s+1]==0 && c->sdf[3*s+2]==0)
+                continue;
+            lp = c->slp[s];
+            l0 = (int)floor(lp)-1;
+            sum = 0;
+            for (l=l0; l<l0+4; l++)
+                sum += dB3(l-lp)*c->logratio[l*c->RBINNUM+c->sk[s]];
+            /* dMI/dlp = -sum/N, dlp/dpos = grad f/binT, cost = -MI */
+            sum /= N*c->binT;
+            for (i=0; i<3; i++)
+                dpos[i] = sum*c->sdf[3*s+i];
+            x = c->sx[s]; y = c->sy[s]; z = c->sz[s];
+            tx = c->wx.w+4*x; ty = c->wy.w+4*y; tz = c->wz.w+4*z;
+            for (cc=0; cc<4; cc++)
+            {
+                if (tz[cc] == 0)
+                    continue;
+                for (b=0; b<4; b++)
+                {
+                    if (ty[b] == 0)
+                        continue;
+                    wyz = tz[cc]*ty[b];
+                    for (a=0; a<4; a++)
+                    {
+                        if (tx[a] == 0)
+                            continue;
+                        w = wyz*tx[a];
+                        ipos = (((c->wz.first[z]+cc)*c->cnumy+
+                            c->wy.first[y]+b)*c->cnumx+c->wx.first[x]+a)*3;
+                        gb[ipos] += w*dpos[0];
+                        gb[ipos+1] += w*dpos[1];
+                        gb[ipos+2] += w*dpos[2];
+                    }
+                }
+            }
+        }
+    }
+#pragma omp parallel for private(t) schedule(static)
+    for (i=0; i<nparam; i++)
+    {
+        double sum=0;
+        for (t=0; t<c->nthreads; t++)
+            sum += c->tgrad[(long)t*nparam+i];
+        grad[i] = (float)sum;
+    }
+    return -mi;
+}
+
+static double dot ( const float *a, const float *b, int n )
+{
+    double sum=0;
+    int i;
+
+    for (i=0; i<n; i++)
+        sum += (double)a[i]*b[i];
+    return sum;
+}
+
+/*****************************************************************************
+ * FUNCTION: dMIoptimizeLBFGS
+ * DESCRIPTION: Optimizes all control points at once by maximizing mutual
+ *    information with limited-memory BFGS and the analytic gradient.
+ * PARAMETERS:
+ *    ctrl: input and optimized output 3D control point mesh
+ *    cnumx, cnumy, cnumz: control point resolution
+ *    test: B-spline coefficients of the test image (see calci3)
+ *    ref_f, ref_us: the reference image; exactly one must be non-NULL
+ *    spacex, spacey, spacez: control point spacing in voxels
+ *    xdim1, ydim1, zdim1: the dimensions of the test image
+ *    xdim2, ydim2, zdim2: the dimensions of the reference image
+ *    itra: maximum number of iterations
+ *    RBINNUM, TBINNUM: numbers of histogram bins in reference and test image
+ *    nsamples: number of voxels sampled; all voxels if <=0 or too large
+ * SIDE EFFECTS: Prints a one-line summary.
+ *****************************************************************************/
+void dMIoptimizeLBFGS ( float *ctrl, int cnumx, int cnumy, int cnumz,
+    const float *test, const float *ref_f, const unsigned short *ref_us,
+    float spacex, float spacey, float spacez,
+    int xdim1, int ydim1, int zdim1, int xdim2, int ydim2, int zdim2,
+    int itra, int RBINNUM, int TBINNUM, int nsamples )
+{
+    MIContext c;
+    long nvox, idx, i;
+    int s, n, nparam, m, head, nhist, itr, nevals, tries, accepted, small;
+    float fR0, fRmax, fTmax, binR, v, *g, *xnew, *gnew, *d, *S, *Y;
+    double f, fnew, f0, gd, step, gmax, sy, yy, beta, *rho, *alpha;
+    unsigned int seed;
+
+    memset(&c, 0, sizeof(c));
+    c.test = test;
+    c.xdim = xdim1; c.ydim = ydim1; c.zdim = zdim1;
+    c.cnumx = cnumx; c.cnumy = cnumy; c.cnumz = cnumz;
+    c.RBINNUM = RBINNUM;
+    c.TBINNUM = TBINNUM<8? 8: TBINNUM;
+    if (bspline_weights_init(&c.wx, xdim1, spacex, cnumx) ||
+            bspline_weights_init(&c.wy, ydim1, spacey, cnumy) ||
+            bspline_weights_init(&c.wz, zdim1, spacez, cnumz))
+    {
+        printf("Out of memory in dMIoptimizeLBFGS\n");
+        exit(1);
+    }
+
+    /* intensity ranges */
+    nvox = (long)xdim1*ydim1*zdim1;
+    c.fT0 = fTmax = test[0];
+    for (i=0; i<nvox; i++)
+    {
+        if (test[i] < c.fT0) c.fT0 = test[i];
+        if (test[i] > fTmax) fTmax = test[i];
+    }
+    c.binT = (fTmax-c.fT0+1)/(c.TBINNUM-3);
+    fR0 = fRmax = ref_f? ref_f[0]: ref_us[0];
+    for (i=0; i<(long)xdim2*ydim2*zdim2; i++)
+    {
+        v = ref_f? ref_f[i]: ref_us[i];
+        if (v < fR0) fR0 = v;
+        if (v > fRmax) fRmax = v;
+    }
+    binR = (fRmax-fR0+1)/RBINNUM;
+
+    /* fixed, stratified sample set so that successive evaluations are
+       comparable; samples outside the reference are dropped */
+    if (nsamples<=0 || nsamples>nvox)
+        nsamples = (int)nvox;
+    c.sx = (int *)malloc(nsamples*sizeof(int));
+    c.sy = (int *)malloc(nsamples*sizeof(int));
+    c.sz = (int *)malloc(nsamples*sizeof(int));
+    c.sk = (int *)malloc(nsamples*sizeof(int));
+    seed = 12345;
+    c.nsamples = 0;
+    for (s=0; s<nsamples; s++)
+    {
+        if (nsamples == nvox)
+            idx = s;
+        else
+        {
+            seed = seed*1103515245+12345;
+            idx = (long)((s+((seed>>8)&0xffff)/65536.0)*nvox/nsamples);
+        }
+        c.sx[c.nsamples] = (int)(idx%xdim1);
+        c.sy[c.nsamples] = (int)(idx/xdim1%ydim1);
+        c.sz[c.nsamples] = (int)(idx/((long)xdim1*ydim1));
+        if (c.sx[c.nsamples]>=xdim2 || c.sy[c.nsamples]>=ydim2 ||
+                c.sz[c.nsamples]>=zdim2)
+            continue;
+        idx = ((long)c.sz[c.nsamples]*ydim2+c.sy[c.nsamples])*xdim2+
+            c.sx[c.nsamples];
+        v = ref_f? ref_f[idx]: ref_us[idx];
+        n = (int)floor((v-fR0)/binR+0.5);
+        c.sk[c.nsamples] = n<0? 0: n>RBINNUM-1? RBINNUM-1: n;
+        c.nsamples++;
+    }
+
+    nparam = cnumx*cnumy*cnumz*3;
+    c.nthreads = omp_get_max_threads();
+    c.slp = (float *)malloc(c.nsamples*sizeof(float));
+    c.sdf = (float *)malloc(3*(long)c.nsamples*sizeof(float));
+    c.thist = (double *)malloc((long)c.nthreads*RBINNUM*c.TBINNUM*
+        sizeof(double));
+    c.tgrad = (double *)malloc((long)c.nthreads*nparam*sizeof(double));
+    c.logratio = (double *)malloc(RBINNUM*c.TBINNUM*sizeof(double));
+
+    m = MI_LBFGS_HISTORY;
+    g = (float *)malloc(nparam*sizeof(float));
+    xnew = (float *)malloc(nparam*sizeof(float));
+    gnew = (float *)malloc(nparam*sizeof(float));
+    d = (float *)malloc(nparam*sizeof(float));
+    S = (float *)malloc((long)m*nparam*sizeof(float));
+    Y = (float *)malloc((long)m*nparam*sizeof(float));
+    rho = (double *)malloc(2*m*sizeof(double));
+    alpha = rho+m;
+    if (c.slp==NULL || c.sdf==NULL || c.thist==NULL || c.tgrad==NULL ||
+            c.logratio==NULL || g==NULL || xnew==NULL || gnew==NULL ||
+            d==NULL || S==NULL || Y==NULL || rho==NULL)
+    {
+        printf("Out of memory in dMIoptimizeLBFGS\n");
+        exit(1);
+    }
+
+    f0 = f = mi_evaluate(&c, ctrl, g);
+    nevals = 1;
+    head = nhist = 0;
+    small = 0;
+    for (itr=0; itr<itra; itr++)
+    {
+        /* two-loop recursion: d = -H g */
+        for (i=0; i<nparam; i++)
+            d[i] = -g[i];
+        for (n=0; n<nhist; n++)
+        {
+            s = (head-1-n+m)%m;
+            alpha[s] = rho[s]*dot(S+(long)s*nparam, d, nparam);
+            for (i=0; i<nparam; i++)
+                d[i] -= (float)(alpha[s]*Y[(long)s*nparam+i]);
+        }
+        if (nhist > 0)
+        {
+            s = (head-1+m)%m;
+            sy = 1/rho[s];
+            yy = dot(Y+(long)s*nparam, Y+(long)s*nparam, nparam);
+            for (i=0; i<nparam; i++)
+                d[i] *= (float)(sy/yy);
+        }
+        else
+        {
+            /* steepest descent, largest control point move of one voxel */
+            gmax = 0;
+            for (i=0; i<nparam; i++)
+                if (fabs(g[i]) > gmax)
+                    gmax = fabs(g[i]);
+            if (gmax == 0)
+                break;
+            for (i=0; i<nparam; i++)
+                d[i] = (float)(d[i]/gmax);
+        }
+        for (n=nhist-1; n>=0; n--)
+        {
+            s = (head-1-n+m)%m;
+            beta = rho[s]*dot(Y+(long)s*nparam, d, nparam);
+            for (i=0; i<nparam; i++)
+                d[i] += (float)((alpha[s]-beta)*S[(long)s*nparam+i]);
+        }
+        gd = dot(g, d, nparam);
+        if (gd >= 0)
+        {
+            /* not a descent direction: restart from steepest descent */
+            if (nhist == 0)
+                break;
+            nhist = 0;
+            itr--;
+            continue;
+        }
+
+        /* backtracking line search (Armijo condition) */
+        accepted = 0;
+        for (step=1, tries=0; tries<12; tries++, step*=0.5)
+        {
+            for (i=0; i<nparam; i++)
+                xnew[i] = (float)(ctrl[i]+step*d[i]);
+            fnew = mi_evaluate(&c, xnew, gnew);
+            nevals++;
+            if (fnew <= f+1e-4*step*gd)
+            {
+                accepted = 1;
+                break;
+            }
+        }
+        if (!accepted)
+        {
+            if (nhist == 0)
+                break;
+            nhist = 0;
+            continue;
+        }
+
+        /* update the curvature history */
+        for (i=0; i<nparam; i++)
+        {
+            S[(long)head*nparam+i] = xnew[i]-ctrl[i];
+            Y[(long)head*nparam+i] = gnew[i]-g[i];
+        }
+        sy = dot(S+(long)head*nparam, Y+(long)head*nparam, nparam);
+        if (sy > 1e-12)
+        {
+            rho[head] = 1/sy;
+            head = (head+1)%m;
+            if (nhist < m)
+                nhist++;
+        }
+        memcpy(ctrl, xnew, nparam*sizeof(float));
+        memcpy(g, gnew, nparam*sizeof(float));
+        small = f-fnew<=1e-6*fabs(f)? small+1: 0;
+        f = fnew;
+        if (small >= 3)
+            break;
+    }
+    printf("\n----L-BFGS: %d iterations, %d evaluations, %d samples, MI %f -> %f\n",
+        itr, nevals, c.nsamples, -f0, -f);
+
+    free(g); free(xnew); free(gnew); free(d); free(S); free(Y); free(rho);
+    free(c.sx); free(c.sy); free(c.sz); free(c.sk); free(c.slp); free(c.sdf);
+    free(c.thist); free(c.tgrad); free(c.logratio);
+    bspline_weights_free(&c.wx);
+    bspline_weights_free(&c.wy);
+    bspline_weights_free(&c.wz);
+}
+
+/*****************************************************************************
+ * FUNCTION: bspline_warp
+ * DESCRIPTION: Applies the B-spline deformation and interpolation to a 3d
+ *    image using the tabulated control point weights, one slice per thread.
+ *    Produces the same result as bsplineimage()/bsplineimagedf().
+ * PARAMETERS:
+ *    ctrl: 3D control point mesh
+ *    in: B-spline coefficients of the input image
+ *    spacex, spacey, spacez: control point spacing in voxels
+ *    xdim, ydim, zdim: the dimensions of the image
+ *    cnumx, cnumy, cnumz: control point resolution
+ *    outdf: if not NULL, receives the deformation field (3 shorts/voxel)
+ *    vx, vy, vz: voxel size, used to scale the deformation field
+ * RETURN VALUE:
+ *    out: store the deformed 3-D volume
+ *****************************************************************************/
+void bspline_warp ( const float *ctrl, const float *in, unsigned short *out,
+    float spacex, float spacey, float spacez,
+    int xdim, int ydim, int zdim, int cnumx, int cnumy, int cnumz,
+    short *outdf, float vx, float vy, float vz )
+{
+    BSplineWeights wx, wy, wz;
+    float vdf=(float)(4.0*vz/vx);
+    int z;
+
+    if (bspline_weights_init(&wx, xdim, spacex, cnumx) ||
+            bspline_weights_init(&wy, ydim, spacey, cnumy) ||
+            bspline_weights_init(&wz, zdim, spacez, cnumz))
+    {
+        printf("Out of memory in bspline_warp\n");
+        exit(1);
+    }
+#pragma omp parallel for schedule(dynamic)
+    for (z=0; z<zdim; z++)
+    {
+        int x, y;
+        long vpos, dfpos;
+        float d[3], fsum;
+
+        for (y=0; y<ydim; y++)
+            for (x=0; x<xdim; x++)
+            {
+                vpos = ((long)z*ydim+y)*xdim+x;
+                displacement(ctrl, &wx, &wy, &wz, x, y, z, d);
+                if (outdf)
+                {
+                    dfpos = vpos*3;
+                    outdf[dfpos] = (short)(d[0]>0? d[0]*4+0.5: d[0]*4-0.5);
+                    outdf[dfpos+1] = (short)(d[1]>0? d[1]*4+0.5: d[1]*4-0.5);
+                    outdf[dfpos+2] =
+                        (short)(d[2]>0? d[2]*vdf+0.5: d[2]*vdf-0.5);
+                }
+                fsum = interpolate(in, xdim, ydim, zdim, x+d[0], y+d[1],
+                    z+d[2], NULL);
+                out[vpos] = fsum<0? 0: (unsigned short)(fsum+0.5);
+            }
+    }
+    bspline_weights_free(&wx);
+    bspline_weights_free(&wy);
+    bspline_weights_free(&wz);
+}
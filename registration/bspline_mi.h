@@ -0,0 +1,61 @@
+/*
+  Copyright 1993-2011, 2017 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+//======================================================================
+/**
+ * \file   bspline_mi.h
+ * \brief  Mutual-information B-spline registration engine: cached basis
+ *         weights, one-pass analytic gradient over all control points
+ *         and an L-BFGS update.
+ */
+//======================================================================
+#ifndef __bspline_mi_h
+#define __bspline_mi_h
+
+#define DEFAULT_MI_SAMPLES 131072
+#define MI_LBFGS_HISTORY 5
+
+/* Cubic B-spline weights of the 4 control points supporting each voxel
+ * along one axis.  Control point first[x]+n has weight w[4*x+n]; points
+ * outside the mesh have weight 0. */
+typedef struct _BSplineWeights {
+    int    dim;     /* number of voxels along the axis */
+    int    cnum;    /* number of control points along the axis */
+    int   *first;   /* first supporting control point of each voxel */
+    float *w;       /* 4 weights per voxel */
+} BSplineWeights;
+
+int  bspline_weights_init ( BSplineWeights *t, int dim, float space, int cnum );
+void bspline_weights_free ( BSplineWeights *t );
+
+void dMIoptimizeLBFGS ( float *ctrl, int cnumx, int cnumy, int cnumz,
+    const float *test, const float *ref_f, const unsigned short *ref_us,
+    float spacex, float spacey, float spacez,
+    int xdim1, int ydim1, int zdim1, int xdim2, int ydim2, int zdim2,
+    int itra, int RBINNUM, int TBINNUM, int nsamples );
+
+void bspline_warp ( const float *ctrl, const float *in, unsigned short *out,
+    float spacex, float spacey, float spacez,
+    int xdim, int ydim, int zdim, int cnumx, int cnumy, int cnumz,
+    short *outdf, float vx, float vy, float vz );
+
+#endif
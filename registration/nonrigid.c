@@ -33,9 +33,11 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include  "Etime.h"
 #include  "Viewnix.h"
 #include "slices.c"
+#include "bspline_mi.h"
 #include  <time.h>
 #ifndef __WXWINCE__  
 #include <time.h>  
@@ -1914,7 +1916,7 @@ int main(argc, argv)
 int argc;
 char *argv[];
 {
-        int itr, steps, nlevel, RBINNUM, TBINNUM, SAMPLENUM;
+        int itr, steps, nlevel, RBINNUM, TBINNUM, SAMPLENUM, legacy;
         float ctrlspace, spacex, spacey, spacez, ftmp;
 	int i,j,k,l, nxdim1, nydim1, nzdim1, nxdim2, nydim2, nzdim2, nl, cnumx, cnumy, cnumz, oldcnumx, oldcnumy, oldcnumz;/*number of control points on each direction */
 	float **timg, **rimg;
@@ -1947,6 +1949,12 @@ char *argv[];
 
 		LOG2= 1/log10f(2);
 
+	legacy = 0;
+	if (argc > 1 && strcmp(argv[argc-1], "-legacy") == 0) {
+		legacy = 1;
+		argc--;
+	}
+
         if(argc<8)
         {
                 printf("Usage:\n");
@@ -1959,6 +1967,7 @@ char *argv[];
 		printf("step size: optimization step size\n");
                 printf("ctrlspace: B-spline control point spacing on x-voxel, unit: number of voxels;\n");
                 printf("df (optional): deformation field output using IM0 format;\n");
+                printf("-legacy (optional): optimize one control point at a time instead of L-BFGS on all control points;\n");
                 exit(1);
         }
         fpin = fopen(argv[1], "rb");
@@ -2154,7 +2163,12 @@ printf("\n----Ci time(test): %f seconds (%d Level:%d,%d,%d),\n",getElapsedTime()
 		else {  j = cnumx*cnumy*cnumz*3; for(i=0; i<j; i++) ctrl[i]=0;}
 
 resetTime();
-                if(nxdim1*nydim1*nzdim1 <= SAMPLENUM+50){
+		if (!legacy) {
+			if (nl == 0)  dMIoptimizeLBFGS(ctrl, cnumx, cnumy, cnumz, timg[0], NULL, in2, spacex, spacey, spacez, xdim1, ydim1, zdim1, xdim2, ydim2, zdim2, itr, RBINNUM, TBINNUM, DEFAULT_MI_SAMPLES);
+			else	dMIoptimizeLBFGS(ctrl, cnumx, cnumy, cnumz, timg[nl], rimg[nl], NULL, spacex, spacey, spacez, nxdim1, nydim1, nzdim1, nxdim2, nydim2, nzdim2, itr, RBINNUM, TBINNUM, DEFAULT_MI_SAMPLES);
+printf("\n----L-BFGS opt time: %f/%d sec (%d Level:%d,%d,%d with control mesh %d,%d,%d),\n",getElapsedTime(),itr, nl,nxdim2,nydim2,nzdim2,cnumx, cnumy, cnumz);
+		}
+                else if(nxdim1*nydim1*nzdim1 <= SAMPLENUM+50){
                         if (nl == 0)  dMIoptimize1dif(ctrl, cnumx, cnumy, cnumz, timg[0], in2, spacex, spacey, spacez, xdim1, ydim1, zdim1, xdim2, ydim2, zdim2,itr, steps, RBINNUM, TBINNUM, SAMPLENUM);
 			else	dMIoptimizeall1d(ctrl, cnumx, cnumy, cnumz, timg[nl], rimg[nl], spacex, spacey, spacez, nxdim1, nydim1, nzdim1, nxdim2, nydim2, nzdim2,itr, steps/(nl*30+1), RBINNUM, TBINNUM);
 printf("\n----All opt time: %f/%d sec (%d Level:%d,%d,%d with control mesh %d,%d,%d),\n",getElapsedTime(),itr, nl,nxdim2,nydim2,nzdim2,cnumx, cnumy, cnumz);
@@ -2175,9 +2189,11 @@ resetTime();
 	if(argc == 9) {
 		//save df
 		outdf = (short*)malloc(vsize1*6); //deformation feild output
-		bsplineimagedf(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz, outdf, voxelsize_x1, voxelsize_y1, voxelsize_z1);
+		if (legacy) bsplineimagedf(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz, outdf, voxelsize_x1, voxelsize_y1, voxelsize_z1);
+		else	bspline_warp(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz, outdf, voxelsize_x1, voxelsize_y1, voxelsize_z1);
 	}
-	else	bsplineimage(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz);
+	else if (legacy)	bsplineimage(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz);
+	else	bspline_warp(ctrl, timg[0], out1, spacex, spacey, spacez, xdim1,ydim1,zdim1, cnumx, cnumy, cnumz, NULL, voxelsize_x1, voxelsize_y1, voxelsize_z1);
 printf("\n----Bspline time: %f (%d,%d,%d)\n",getElapsedTime(),xdim1,ydim1,zdim1);
 
 	free(ctrl); 
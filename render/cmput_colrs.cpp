@@ -213,7 +213,7 @@ void cvRenderer::eliminate_unused_colors(void)
 RGB *cvRenderer::color_of_number(int colorn)
 {
 	Shell *obj;
-	static RGB black;
+	static thread_local RGB black;
 
 	for (obj=object_list; obj!=NULL; obj=obj->next)
 	{	if (obj->O.color == colorn)
@@ -57,6 +57,31 @@ cvRenderer::cvRenderer(char **file_list, int num_files, int icons)
 	loadFiles(file_list, num_files, icons);
 	set_colormap();
 	mAux = NULL;
+	mConcurrentStereo = mAuxRendered = false;
+}
+
+/*****************************************************************************
+ * FUNCTION: cvRenderer(cvRenderer *primary)
+ * DESCRIPTION: Creates a renderer for the other view of a stereo pair, which
+ *    renders the objects of primary without loading the files again.
+ * PARAMETERS:
+ *    primary: The renderer whose objects are to be shared.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: primary must have objects loaded and must outlive this
+ *    renderer; syncStereo must be called on primary before each rendering.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: object_list is NULL if memory cannot be allocated.
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+cvRenderer::cvRenderer(cvRenderer *primary)
+{
+	param_init();
+	shareObjects(primary);
+	set_colormap();
+	mAux = NULL;
+	mConcurrentStereo = mAuxRendered = false;
 }
 
 
@@ -885,6 +910,7 @@ XImage& cvRenderer::render ( void ) {
  *****************************************************************************/
 char* cvRenderer::get_recolored_image( int& w, int& h ) {
 	image_valid = FALSE;
+	mAuxRendered = false;
 	if (!colormap_valid)
 		set_colormap();
 	if (make_image(main_image, &cvRenderer::cvCheckInterrupt) == DONE)
@@ -975,7 +1001,40 @@ char* cvRenderer::get_recolored_image2( int& w, int& h ) {
 	return image2->data;
 }
 
+/** \brief renders the other view of a stereo pair while the calling thread
+ *  renders the first.
+ */
+class StereoThread : public wxThread {
+    cvRenderer*  mRenderer;
+    int*         mInterruptFlag;
+public:
+    StereoThread ( cvRenderer* renderer, int* interrupt_flag )
+      : wxThread( wxTHREAD_JOINABLE ), mRenderer(renderer),
+        mInterruptFlag(interrupt_flag)
+    {
+        Create();
+    }
+    ExitCode Entry ( void ) {
+        mRenderer->render( mInterruptFlag );
+        return 0;
+    }
+};
+
 char* cvRenderer::render2 ( int& w, int& h, int& interrupt_flag ) {
+    mAuxRendered = false;
+    if (mAux!=NULL && mConcurrentStereo) {
+        //the two renderers share only read-only object data
+        syncStereo();
+        StereoThread  partner( mAux, &interrupt_flag );
+        if (partner.Run() == wxTHREAD_NO_ERROR) {
+            XImage  xi = render( &interrupt_flag );
+            partner.Wait();
+            mAuxRendered = true;
+            w = xi.width;
+            h = xi.height;
+            return xi.data;
+        }
+    }
     XImage  xi = render( &interrupt_flag );
     w = xi.width;
     h = xi.height;
@@ -2933,6 +2992,7 @@ void cvRenderer::destroy_scene(ViewnixHeader *vh, FILE **fp,
  *    Modified: 1/23/95 interpolate parameter added by Dewey Odhner
  *    Modified: 1/25/95 multiplication tables added by Dewey Odhner
  *    Modified: 2/10/04 sl_scene parameter added by Dewey Odhner
+ *    Modified: 10/19/26 data in memory resliced by VResliceSlice
  *
  *****************************************************************************/
 Function_status cvRenderer::get_oblique_slice(unsigned short **sl_data,
@@ -3183,60 +3243,9 @@ Function_status cvRenderer::get_oblique_slice(unsigned short **sl_data,
 		  }
       } 
 	else /* scene_data == NULL */
-	{
-      img_ptr = *sl_data;
-      for(i=0;i<sl_height;i++)
-	    if (interpolate)
-	      for(j=0;j<sl_width;j++,img_ptr++) 
-	      { point[2]= ends[0][2] + i*v[2] + j*u[2];
-	        if (point[2]<0 || point[2]>=Sl_Sc.slices-1)
-		      continue;
-		    point[0]= ends[0][0] + i*v[0] + j*u[0];
-	        x=Floor(point[0]);
-		    if (x>=0 && x<Sl_Sc.width-1) {
-	          point[1]= ends[0][1] + i*v[1] + j*u[1];
-	          y=Floor(point[1]);
-	          if (y>=0 && y<Sl_Sc.height-1) {
-	            z = Floor(point[2]);
-                ptr1 = Sl_Sc.dbyte_data+Sl_Sc.width*Sl_Sc.height*z;
-                ptr2 = ptr1+Sl_Sc.width*Sl_Sc.height;
-	            dx=point[0]-x; dy=point[1]-y; dz=point[2]-z;
-                /* if within bounds init locations in each slice */
-	            pt1= (unsigned short *)ptr1 + y*Sl_Sc.width+x;
-                pt2= (unsigned short *)ptr2 + y*Sl_Sc.width+x;
-	            *img_ptr= (unsigned short)(.5+ 
-		          (1-dz)*
-		           ((1-dy)*((1-dx)* *pt1 +
-				                dx* *(pt1+1)) +
-		              dy  *((1-dx)* *(pt1+Sl_Sc.width) +
-					            dx* *(pt1+Sl_Sc.width+1))
-		           )+
-		          dz *
-		           ((1-dy)*((1-dx)* *pt2 +
-				                dx* *(pt2+1)) +
-		              dy  *((1-dx)* *(pt2+Sl_Sc.width) +
-					            dx* *(pt2+Sl_Sc.width+1))
-			       ));
-		      }
-	        }
-          }
-		else /* !interpolate */
-	    { x=(int)rint(ends[0][0] + i*v[0]);
-	      y=(int)rint(ends[0][1] + i*v[1]);
-		  z=(int)rint(ends[0][2] + i*v[2]);
-	      for(j=0;j<sl_width;j++,img_ptr++)
-	      { if (z+x_table[2][j]>=0 && z+x_table[2][j]<Sl_Sc.slices-1 &&
-		    	x+x_table[0][j]>=0 && x+x_table[0][j]<Sl_Sc.width-1 &&
-	        	y+x_table[1][j]>=0 && y+x_table[1][j]<Sl_Sc.height-1) {
-              ptr1 = Sl_Sc.dbyte_data+
-					slice_table[z+x_table[2][j]];
-	          pt1= (unsigned short *)ptr1 +
-			  	row_table[y+x_table[1][j]]+x+x_table[0][j];
-	          *img_ptr= *pt1;
-	        }
-          }
-		}
-    }
+	  VResliceSlice(Sl_Sc.dbyte_data, 16, Sl_Sc.width, Sl_Sc.height,
+	    Sl_Sc.slices, ends[0], u, v, sl_width, sl_height,
+	    interpolate? VRESLICE_LINEAR: 0, *sl_data, 16);
   }
   else {
     /* ptr1 always points to the fist slice and ptr2 to the second */
@@ -3350,60 +3359,10 @@ Function_status cvRenderer::get_oblique_slice(unsigned short **sl_data,
 		      }
 		  }
     }
-	else {
-      img_ptr = *sl_data;
-      for(i=0;i<sl_height;i++)
-	    if (interpolate)
-	      for(j=0;j<sl_width;j++,img_ptr++) 
-	      { point[2]= ends[0][2] + i*v[2] + j*u[2];
-	        if (point[2]<0 || point[2]>=Sl_Sc.slices-1)
-		      continue;
-		    point[0]= ends[0][0] + i*v[0] + j*u[0];
-	        x=Floor(point[0]);
-		    if (x>=0 && x<Sl_Sc.width-1) {
-	          point[1]= ends[0][1] + i*v[1] + j*u[1];
-	          y=Floor(point[1]);
-	          if (y>=0 && y<Sl_Sc.height-1) {
-	            z = Floor(point[2]);
-                ptr1_8 = Sl_Sc.byte_data+Sl_Sc.bytes_per_slice*z;
-                ptr2_8 = ptr1_8+Sl_Sc.bytes_per_slice;
-	            dx=point[0]-x; dy=point[1]-y; dz=point[2]-z;
-                /* if within bounds init locations in each slice */
-	            pt1_8= (unsigned char *)ptr1_8 + y*Sl_Sc.width+x;
-                pt2_8= (unsigned char *)ptr2_8 + y*Sl_Sc.width+x;
-	            *img_ptr= (unsigned short)(.5+
-                  (1-dz)*
-		           ((1-dy)*((1-dx)* *pt1_8 +
-				                dx* *(pt1_8+1)) +
-		                dy*((1-dx)* *(pt1_8+Sl_Sc.width) +
-					            dx* *(pt1_8+Sl_Sc.width+1))
-		           )+
-		          dz *
-		           ((1-dy)*((1-dx)* *pt2_8 +
-				                dx* *(pt2_8+1)) +
-			            dy*((1-dx)* *(pt2_8+Sl_Sc.width) +
-					            dx* *(pt2_8+Sl_Sc.width+1))
-		           ));
-		      }
-	        }
-	      }
-		else
-	    { x=(int)rint(ends[0][0] + i*v[0]);
-	      y=(int)rint(ends[0][1] + i*v[1]);
-		  z=(int)rint(ends[0][2] + i*v[2]);
-	      for(j=0;j<sl_width;j++,img_ptr++) 
-	      { if (z+x_table[2][j]>=0 && z+x_table[2][j]<Sl_Sc.slices-1 &&
-		    	x+x_table[0][j]>=0 && x+x_table[0][j]<Sl_Sc.width-1 &&
-	        	y+x_table[1][j]>=0 && y+x_table[1][j]<Sl_Sc.height-1) {
-              ptr1_8 = Sl_Sc.byte_data+
-			    slice_table[z+x_table[2][j]];
-	          pt1_8= (unsigned char *)ptr1_8 +
-			    row_table[y+x_table[1][j]]+x+x_table[0][j];
-	          *img_ptr= *pt1_8;
-	        }
-	      }
-		}
-	}
+	else /* scene_data == NULL */
+	  VResliceSlice(Sl_Sc.byte_data, 8, Sl_Sc.width, Sl_Sc.height,
+	    Sl_Sc.slices, ends[0], u, v, sl_width, sl_height,
+	    interpolate? VRESLICE_LINEAR: 0, *sl_data, 16);
   }
 
   if (scene_data) {
@@ -4839,3 +4798,222 @@ void cvRenderer::setStereoTransform ( void ) {
     ::MtoA( mAux->glob_angle, mAux->glob_angle+1, mAux->glob_angle+2, rot_matrix );
 }
 /*****************************************************************************/
+/**
+ * \brief copies the settings of one virtual object to another
+ * \returns true if the color of the object changed
+ */
+static bool copy_object_settings ( Virtual_object* to,
+                                   const Virtual_object* from )
+{
+    bool  recolor = to->color != from->color ||
+                    memcmp( &to->rgb, &from->rgb, sizeof(RGB) ) != 0;
+    if (to->specular_fraction != from->specular_fraction ||
+        to->specular_exponent != from->specular_exponent ||
+        to->diffuse_exponent  != from->diffuse_exponent  ||
+        to->specular_n        != from->specular_n        ||
+        to->diffuse_n         != from->diffuse_n)
+    {
+        to->specular_fraction  = from->specular_fraction;
+        to->specular_exponent  = from->specular_exponent;
+        to->diffuse_exponent   = from->diffuse_exponent;
+        to->specular_n         = from->specular_n;
+        to->diffuse_n          = from->diffuse_n;
+        to->shade_lut_computed = FALSE;
+    }
+    to->on      = from->on;
+    to->opacity = from->opacity;
+    to->rgb     = from->rgb;
+    to->color   = from->color;
+    return recolor;
+}
+/*****************************************************************************/
+/**
+ * \brief this function replaces the objects of the aux stereo renderer with
+ * objects that share the data of the objects of the primary renderer.
+ * only the object images, which depend on the view, are kept separately.
+ * \returns 0 if successful; 1 if memory cannot be allocated
+ */
+int cvRenderer::shareObjects ( cvRenderer* primary ) {
+    Shell  *obj, *copy, **tail_ptr;
+
+    while (object_list)
+        remove_object(object_list);
+    icons_exist = primary->icons_exist;
+    tail_ptr = &object_list;
+    for (obj=primary->object_list; obj!=NULL; obj=obj->next) {
+        copy = (Shell *)malloc( sizeof(Shell) );
+        if (copy == NULL) {
+            while (object_list)
+                remove_object(object_list);
+            return 1;
+        }
+        *copy = *obj;
+        copy->next = NULL;
+        copy->shared = true;
+        copy->original = false;
+        memset( &copy->O.main_image, 0, sizeof(Object_image) );
+        memset( &copy->O.icon, 0, sizeof(Object_image) );
+        copy->O.shade_lut_computed = FALSE;
+        copy->reflection = NULL;
+        *tail_ptr = copy;
+        tail_ptr = &copy->next;
+    }
+    if (object_list == NULL)
+        return 0;
+    copyView( primary );
+    if (st_cl(&object_list->main_data)!=BINARY_B &&
+            st_cl(&object_list->main_data)!=BINARY_A &&
+            st_cl(&object_list->main_data)!=T_SHELL)
+        compute_v_object_color_table();
+    if (st_cl(&object_list->main_data)==PERCENT ||
+            st_cl(&object_list->main_data)==DIRECT)
+        check_true_color();
+    else
+        true_color = FALSE;
+    colormap_valid = FALSE;
+    return 0;
+}
+/*****************************************************************************/
+/**
+ * \brief this function copies the objects' data, placement and appearance
+ * and the rendering settings of the primary renderer to the aux stereo
+ * renderer.  the object lists must correspond.
+ */
+void cvRenderer::copyView ( cvRenderer* primary ) {
+    Shell  *obj, *pobj;
+    bool  recolor = false;
+
+    for (obj=object_list, pobj=primary->object_list; obj!=NULL && pobj!=NULL;
+            obj=obj->next, pobj=pobj->next) {
+        obj->main_data = pobj->main_data;
+        obj->icon_data = pobj->icon_data;
+        memcpy( obj->angle, pobj->angle, sizeof(triple) );
+        memcpy( obj->displacement, pobj->displacement, sizeof(triple) );
+        memcpy( obj->plan_angle, pobj->plan_angle, sizeof(triple) );
+        memcpy( obj->plan_displacement, pobj->plan_displacement,
+            sizeof(triple) );
+        obj->mobile          = pobj->mobile;
+        obj->secondary       = pobj->secondary;
+        obj->diameter        = pobj->diameter;
+        obj->marks           = pobj->marks;
+        obj->mark_array_size = pobj->mark_array_size;
+        obj->mark            = pobj->mark;
+        if (copy_object_settings( &obj->O, &pobj->O ))
+            recolor = true;
+        if (obj->reflection!=NULL && pobj->reflection==NULL) {
+            destroy_virtual_object( obj->reflection );
+            free( obj->reflection );
+            obj->reflection = NULL;
+        }
+        if (obj->reflection==NULL && pobj->reflection!=NULL) {
+            obj->reflection = (Virtual_object *)
+                calloc( 1, sizeof(Virtual_object) );
+            if (obj->reflection == NULL) {
+                report_malloc_error();
+                continue;
+            }
+            recolor = true;
+        }
+        if (obj->reflection!=NULL &&
+                copy_object_settings( obj->reflection, pobj->reflection ))
+            recolor = true;
+    }
+
+    anti_alias = primary->anti_alias;
+    maximum_intensity_projection = primary->maximum_intensity_projection;
+    box   = primary->box;
+    plane = primary->plane;
+    line  = primary->line;
+    marks = primary->marks;
+    memcpy( glob_angle, primary->glob_angle, sizeof(glob_angle) );
+    memcpy( glob_displacement, primary->glob_displacement,
+        sizeof(glob_displacement) );
+    memcpy( plane_normal, primary->plane_normal, sizeof(plane_normal) );
+    plane_displacement = primary->plane_displacement;
+    memcpy( line_angle, primary->line_angle, sizeof(line_angle) );
+    memcpy( line_displacement, primary->line_displacement,
+        sizeof(line_displacement) );
+    selected_object    = primary->selected_object;
+    ambient            = primary->ambient;
+    plane_transparency = primary->plane_transparency;
+    mark_color         = primary->mark_color;
+    fade_edge          = primary->fade_edge;
+    surface_red_factor   = primary->surface_red_factor;
+    surface_green_factor = primary->surface_green_factor;
+    surface_blue_factor  = primary->surface_blue_factor;
+    for (int j=0; j<4; j++) {
+        tissue_opacity[j] = primary->tissue_opacity[j];
+        tissue_red[j]     = primary->tissue_red[j];
+        tissue_green[j]   = primary->tissue_green[j];
+        tissue_blue[j]    = primary->tissue_blue[j];
+    }
+    surface_strength = primary->surface_strength;
+    emission_power   = primary->emission_power;
+    surf_pct_power   = primary->surf_pct_power;
+    perspective      = primary->perspective;
+    viewport_size    = primary->viewport_size;
+    viewport_back    = primary->viewport_back;
+    t_shell_detail   = primary->t_shell_detail;
+
+    if (global_level!=primary->global_level ||
+            global_width!=primary->global_width) {
+        global_level = primary->global_level;
+        global_width = primary->global_width;
+        compute_v_object_color_table();
+    }
+    if (memcmp( &background, &primary->background, sizeof(RGB) ) != 0 ||
+            ncolors != primary->ncolors || gray_scale != primary->gray_scale)
+        recolor = true;
+    background = primary->background;
+    gray_scale = primary->gray_scale;
+    while (ncolors < primary->ncolors)
+        new_color();
+    ncolors = primary->ncolors;
+    if (recolor)
+        colormap_valid = FALSE;
+
+    if (main_image==NULL || scale!=primary->scale ||
+            (primary->main_image!=NULL &&
+             main_image->width!=primary->main_image->width)) {
+        scale = primary->scale;
+        resize_image();
+    }
+    depth_scale = primary->depth_scale;
+}
+/*****************************************************************************/
+/**
+ * \brief this function brings the aux stereo renderer up to date with this
+ * (the primary) renderer and sets its view to the other eye.
+ */
+void cvRenderer::syncStereo ( void ) {
+    assert( this->mAux != NULL );
+
+    Shell  *obj, *aobj;
+    for (obj=object_list, aobj=mAux->object_list; obj!=NULL && aobj!=NULL;
+            obj=obj->next, aobj=aobj->next)
+        ;
+    if (obj!=NULL || aobj!=NULL || mAux->object_list==NULL)
+        mAux->shareObjects( this );
+    else
+        mAux->copyView( this );
+    setStereoTransform();
+}
+/*****************************************************************************/
+/**
+ * \brief this function returns the view of the aux stereo renderer that
+ * goes with the last view returned by render2, rendering it now unless it
+ * was rendered concurrently by render2.
+ */
+char* cvRenderer::renderStereoPartner ( int& w, int& h, int& interrupt_flag ) {
+    assert( this->mAux != NULL );
+
+    if (!mAuxRendered) {
+        syncStereo();
+        return mAux->render2( w, h, interrupt_flag );
+    }
+    mAuxRendered = false;
+    w = mAux->main_image->width;
+    h = mAux->main_image->height;
+    return mAux->main_image->data;
+}
+/*****************************************************************************/
@@ -81,6 +81,15 @@ typedef struct Object_image {
 	unsigned char **opacity_buffer, **likelihood_buffer;
 } Object_image;
 
+typedef struct Skip_tiles {
+	int *floor; /* for each tile of SKIP_TILE x SKIP_TILE object image pixels,
+		the least value of each channel, -1 if any pixel is background, or NULL
+		if rows are not to be skipped */
+	int tiles_x, tiles_y, channels; /* 3 for red, green, blue; 1 for opacity */
+	int margin; /* the farthest a voxel projects from its pixel */
+	int slices; /* projected since the tiles were made */
+} Skip_tiles;
+
 typedef struct Shell_data {
 	int in_memory; /* flag that TSE's are in memory */
 	int rows, slices; /* the number of rows per slice and slices in the shell*/
@@ -93,6 +102,8 @@ typedef struct Shell_data {
 	struct Shell_file *file; /* the file information, even if the shell has
 		not been stored in a file */
 	int bounds[3][2], threshold[6]; /* for scene data */
+	unsigned short (*row_range)[2]; /* for DIRECT data, the least and greatest
+		density in each row, or NULL; see set_row_ranges */
 } Shell_data;
 
 typedef struct Shell_file {
@@ -260,6 +271,8 @@ typedef struct Shell {
 	triple *mark;
 	Virtual_object O, *reflection;
 	bool original;
+	bool shared; /* main_data, icon_data and mark belong to an object of
+		another renderer */
 } Shell;
 
 typedef struct Manip_event {
@@ -417,6 +430,7 @@ void axis_rot(double dest[3][3], int axis, double angle);
 void transpose(double dest[3][3], double src[3][3]);
 int VInvertMatrix(double Ainv[], double A[], int N);
 void destroy_object_data(Shell_data *object_data);
+int set_row_ranges(Shell_data *object_data);
 void destroy_file_header(ViewnixHeader *file_header);
 float scn_slice_location(Shell_data *shell_data, int slice);
 int get_string(char string[], FILE *file, int string_size);
@@ -426,6 +440,15 @@ int free_children(Plan_tree *node);
 void MtoA(double *A1, double *A2, double *A3, double M[3][3]);
 void view_interpolate(double between[3], double pose1[3], double pose2[3],
 	double partway);
+
+typedef struct {double angle[3]; int views;} Key_pose;
+int movie_frames(const Key_pose key_pose[], int key_poses);
+void movie_pose(double angle[3], Key_pose key_pose[], int key_poses,
+	int frame);
+int read_movie_sequence(const char filename[], Key_pose **key_pose,
+	int *key_poses);
+int write_movie_header(FILE *movie_file, const char path[],
+	cvRenderer *renderer, int frames, char bad_group[5], char bad_element[5]);
 void AtoM(double M[3][3], double A1, double A2, double A3);
 void AtoV(double V[3], double A1, double A2);
 void VtoA(double *A1, double *A2, double V[3]);
@@ -452,10 +475,17 @@ bool incompatible(Shell_data *shell_data1, Shell_data *shell_data2);
 class cvRenderer {
 public:
 	cvRenderer(char **file_list, int num_files, int icons=FALSE);
+	cvRenderer(cvRenderer *primary);
 	~cvRenderer(void);
 
 	cvRenderer*  mAux;  ///< optional, extra renderer for stereo
+	bool  mConcurrentStereo;  ///< render2 also renders mAux on another thread
+	bool  mAuxRendered;  ///< mAux has rendered the view of the last render2
 	void setStereoTransform ( void );
+	void syncStereo ( void );
+	char* renderStereoPartner ( int& w, int& h, int& interrupt_flag );
+	int shareObjects(cvRenderer *primary);
+	void copyView(cvRenderer *primary);
 
 	Shell *object_list; /* linked list of all the objects (shells) */
 	Slice_image *slice_list; /* linked list of all the displayed slices */
@@ -975,6 +1005,10 @@ protected:
 	int d_mip_quick_project(Shell_data *object_data,
 		Object_image *object_image, double projection_matrix[3][3],
 		double projection_offset[3], Priority (*check_event)(cvRenderer *));
+	void d_mip_ceiling(int lo, int hi, int threshold[6], int ceiling[3]);
+	int skip_row(Skip_tiles *tiles, Shell_data *object_data,
+		unsigned short **row_ptr_ptr, int row_x, int row_y,
+		int column_x_table[1024], int column_y_table[1024]);
 	int tpatch_project(Shell_data *object_data, Object_image *object_image,
 		double projection_matrix[3][3], double projection_offset[3],
 		int angle_shade[BG_CODES], Priority (*check_event)(cvRenderer *));
@@ -201,6 +201,7 @@ int put_new_data(Shell_data *object2, size_t *&new_ptr_table,
 		object2->ptr_table[0])/tse_size);
 	object2->file->file_header.str.volume_valid = FALSE;
 	object2->file->file_header.str.surface_area_valid = FALSE;
+	set_row_ranges(object2);
 	return (0);
 }
 
@@ -721,6 +722,7 @@ Function_status cvRenderer::do_cut(Shell *primary_object, int icon_flag,
 		st_cl(primary_object_data)==BINARY_A? 2:3));
 	out_object1_data->file->file_header.str.volume_valid = FALSE;
 	out_object1_data->file->file_header.str.surface_area_valid = FALSE;
+	set_row_ranges(out_object1_data);
 	return DONE;
 }
 
@@ -865,6 +867,7 @@ void compactify_object_data(Shell_data *obj_data)
 		obj_data->rows = 0;
 	obj_data->file->file_header.str.num_of_NTSE[obj_data->shell_number] =
 		1+obj_data->slices*(1+obj_data->rows);
+	set_row_ranges(obj_data);
 }
 
 /*****************************************************************************
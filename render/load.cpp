@@ -1179,6 +1179,7 @@ int cvRenderer::load_shell(Shell_file *shell_file, FILE *infile,
  * HISTORY:
  *    Created: 7/11/01 by Dewey Odhner
  *    Modified: 9/3/02 check for abort by Dewey Odhner
+ *    Modified: 10/19/26 row ranges set
  *
  *****************************************************************************/
 int cvRenderer::load_direct_data(Shell_file *shell_file, FILE *infile,
@@ -3465,6 +3466,7 @@ int cvRenderer::load_direct_data(Shell_file *shell_file, FILE *infile,
 		}
 	free(data_buffer8);
 	obj_data->in_memory = TRUE;
+	set_row_ranges(obj_data);
 	return (0);
 }
 
@@ -3690,18 +3692,21 @@ void compute_diameter(Shell *obj, int icons_exist)
  *    Created: 1992 by Dewey Odhner
  *    Modified: 4/26/94 to set overlay_bad by Dewey Odhner
  *    Modified: 2/28/97 object->mark freed by Dewey Odhner
+ *    Modified: 10/19/26 data of a shared object left alone.
  *
  *****************************************************************************/
 void cvRenderer::destroy_object(Shell *object)
 {
-	destroy_object_data(&object->main_data);
-	destroy_object_data(&object->icon_data);
+	if (!object->shared)
+	{	destroy_object_data(&object->main_data);
+		destroy_object_data(&object->icon_data);
+	}
 	destroy_virtual_object(&object->O);
 	if (object->reflection)
 	{	destroy_virtual_object(object->reflection);
 		free(object->reflection);
 	}
-	if (object->mark)
+	if (object->mark && !object->shared)
 		free(object->mark);
 	free(object);
 }
@@ -3719,6 +3724,7 @@ void cvRenderer::destroy_object(Shell *object)
  * HISTORY:
  *    Created: 1992 by Dewey Odhner
  *    Modified: 5/31/94 to check object_data->ptr_table[0] by Dewey Odhner
+ *    Modified: 10/19/26 row_range freed
  *
  *****************************************************************************/
 void destroy_object_data(Shell_data *object_data)
@@ -3729,6 +3735,8 @@ void destroy_object_data(Shell_data *object_data)
 		free(object_data->ptr_table[0]);
 	if (object_data->ptr_table)
 		free(object_data->ptr_table);
+	if (object_data->row_range)
+		free(object_data->row_range);
 	if (object_data->file)
 	{	object_data->file->references--;
 		object_data->file->file_header.gen.filename_valid = FALSE;
@@ -3747,6 +3755,54 @@ void destroy_object_data(Shell_data *object_data)
 	}
 }
 
+/*****************************************************************************
+ * FUNCTION: set_row_ranges
+ * DESCRIPTION: Finds the least and greatest density in each row of an object
+ *    of class DIRECT, so that a maximum intensity projection can skip rows
+ *    that cannot change the image.
+ * PARAMETERS:
+ *    object_data: The object data.  Any previous row ranges are freed.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: This must be called again whenever the TSE's of the
+ *    object change.
+ * RETURN VALUE: 0 if successful or the object is not DIRECT data in memory,
+ *    1 if memory cannot be allocated; object_data->row_range is then NULL.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int set_row_ranges(Shell_data *object_data)
+{
+	int row, rows;
+	unsigned short *this_ptr;
+
+	if (object_data->row_range)
+	{	free(object_data->row_range);
+		object_data->row_range = NULL;
+	}
+	if (st_cl(object_data)!=DIRECT || !object_data->in_memory ||
+			object_data->ptr_table==NULL)
+		return (0);
+	rows = object_data->rows*object_data->slices;
+	object_data->row_range =
+		(unsigned short (*)[2])malloc((rows+1)*sizeof(*object_data->row_range));
+	if (object_data->row_range == NULL)
+		return (1);
+	for (row=0; row<rows; row++)
+	{	object_data->row_range[row][0] = 65535;
+		object_data->row_range[row][1] = 0;
+		for (this_ptr=object_data->ptr_table[row];
+				this_ptr<object_data->ptr_table[row+1]; this_ptr+=3)
+		{	if (this_ptr[2] < object_data->row_range[row][0])
+				object_data->row_range[row][0] = this_ptr[2];
+			if (this_ptr[2] > object_data->row_range[row][1])
+				object_data->row_range[row][1] = this_ptr[2];
+		}
+	}
+	return (0);
+}
+
 /*****************************************************************************
  * FUNCTION: destroy_virtual_object
  * DESCRIPTION: Frees the memory occupied by a Virtual_object.
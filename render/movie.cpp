@@ -0,0 +1,274 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cvRender.h"
+
+/*****************************************************************************
+ * FUNCTION: movie_frames
+ * DESCRIPTION: Returns the number of frames in a movie of a key pose
+ *    sequence.
+ * PARAMETERS:
+ *    key_pose: The key poses, each with the number of views interpolated
+ *       between it and the previous key pose.
+ *    key_poses: The number of key poses.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The number of frames.  If the sequence returns to the first
+ *    pose, the last key pose is not repeated.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int movie_frames(const Key_pose key_pose[], int key_poses)
+{
+	int frames=key_poses, j;
+
+	for (j=0; j<key_poses-1; j++)
+		frames += key_pose[j+1].views;
+	if (key_poses>2 && key_pose[key_poses-1].angle[0]==key_pose[0].angle[0] &&
+			key_pose[key_poses-1].angle[1]==key_pose[0].angle[1] &&
+			key_pose[key_poses-1].angle[2]==key_pose[0].angle[2])
+		frames--;
+	return frames;
+}
+
+/*****************************************************************************
+ * FUNCTION: movie_pose
+ * DESCRIPTION: Computes the view angles of a frame of a movie of a key pose
+ *    sequence.
+ * PARAMETERS:
+ *    angle: The view angles (as cvRenderer::glob_angle) will go here.
+ *    key_pose: The key poses.
+ *    key_poses: The number of key poses.
+ *    frame: The frame number from 0.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: frame must be less than movie_frames(key_pose, key_poses).
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void movie_pose(double angle[3], Key_pose key_pose[], int key_poses,
+	int frame)
+{
+	int k;
+
+	for (k=0; k<key_poses-1 && frame>key_pose[k+1].views; k++)
+		frame -= key_pose[k+1].views+1;
+	if (frame == 0)
+		memcpy(angle, key_pose[k].angle, 3*sizeof(double));
+	else
+		view_interpolate(angle, key_pose[k].angle, key_pose[k+1].angle,
+			frame/(key_pose[k+1].views+1.0));
+}
+
+/*****************************************************************************
+ * FUNCTION: read_movie_sequence
+ * DESCRIPTION: Reads a key pose sequence as saved by the manipulate tool:
+ *    the number of key poses, then "{angle0, angle1, angle2} views" for
+ *    each.
+ * PARAMETERS:
+ *    filename: The sequence file.
+ *    key_pose: The key poses will be allocated and stored here.
+ *    key_poses: The number of key poses will go here.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 if successful, 1 if memory cannot be allocated, 2 if the
+ *    file is not a valid sequence, 4 if the file cannot be opened.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int read_movie_sequence(const char filename[], Key_pose **key_pose,
+	int *key_poses)
+{
+	FILE *sequence_file;
+	int pose;
+
+	sequence_file = fopen(filename, "rb");
+	if (sequence_file == NULL)
+		return 4;
+	if (fscanf(sequence_file, "%d\n", key_poses)!=1 || *key_poses<1)
+	{
+		fclose(sequence_file);
+		return 2;
+	}
+	*key_pose = (Key_pose *)malloc(*key_poses*sizeof(Key_pose));
+	if (*key_pose == NULL)
+	{
+		fclose(sequence_file);
+		return 1;
+	}
+	for (pose=0; pose<*key_poses; pose++)
+		if (fscanf(sequence_file, "{%lf, %lf, %lf} %d\n",
+				(*key_pose)[pose].angle, (*key_pose)[pose].angle+1,
+				(*key_pose)[pose].angle+2, &(*key_pose)[pose].views)!=4 ||
+				(*key_pose)[pose].views<0)
+		{
+			free(*key_pose);
+			*key_pose = NULL;
+			fclose(sequence_file);
+			return 2;
+		}
+	fclose(sequence_file);
+	return 0;
+}
+
+/*****************************************************************************
+ * FUNCTION: write_movie_header
+ * DESCRIPTION: Writes the header of a MOVIE0 file of renderings of the main
+ *    image and positions the file for the frame data.
+ * PARAMETERS:
+ *    movie_file: The file, open for writing.
+ *    path: The name of the file.
+ *    renderer: The renderer the frames come from.
+ *    frames: The number of frames.
+ *    bad_group, bad_element: If VWriteHeader finds an undefined item, its
+ *       group and element will go here, otherwise empty strings; each must
+ *       have room for 5 chars.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: renderer must have objects loaded.
+ * RETURN VALUE: 0 if successful, 1 if memory cannot be allocated, otherwise
+ *    the error code of VWriteHeader or VSeekData.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26 from SurfViewCanvas::save_movie
+ *
+ *****************************************************************************/
+int write_movie_header(FILE *movie_file, const char path[],
+	cvRenderer *renderer, int frames, char bad_group[5], char bad_element[5])
+{
+	int error_code;
+	ViewnixHeader *header;
+	float smallest_value[3], largest_value[3];
+	short signed_bits[3], bit_fields[6];
+	Shell_data *obj_data=&renderer->object_list->main_data;
+	ViewnixHeader *in=&obj_data->file->file_header;
+
+	bad_group[0] = bad_element[0] = 0;
+	header = (ViewnixHeader *)calloc(1, sizeof(ViewnixHeader));
+	if (header == NULL)
+		return 1;
+	strcpy(header->gen.filename1, in->gen.filename);
+	strncpy(header->gen.filename, path, sizeof(header->gen.filename)-1);
+	header->gen.filename1_valid = header->gen.filename_valid = 1;
+	strcpy(header->gen.recognition_code, "VIEWNIX1.0");
+	header->gen.data_type = MOVIE0;
+	header->gen.data_type_valid = header->gen.recognition_code_valid = 1;
+	if (in->gen.study_date_valid)
+	{	strcpy(header->gen.study_date, in->gen.study_date);
+		header->gen.study_date_valid = 1;
+	}
+	if (in->gen.study_time_valid)
+	{	strcpy(header->gen.study_time, in->gen.study_time);
+		header->gen.study_time_valid = 1;
+	}
+	if (in->gen.modality_valid)
+	{	strcpy(header->gen.modality, in->gen.modality);
+		header->gen.modality_valid = 1;
+	}
+	if (in->gen.institution_valid)
+	{	strcpy(header->gen.institution, in->gen.institution);
+		header->gen.institution_valid = 1;
+	}
+	if (in->gen.physician_valid)
+	{	strcpy(header->gen.physician, in->gen.physician);
+		header->gen.physician_valid = 1;
+	}
+	if (in->gen.department_valid)
+	{	strcpy(header->gen.department, in->gen.department);
+		header->gen.department_valid = 1;
+	}
+	if (in->gen.radiologist_valid)
+	{	strcpy(header->gen.radiologist, in->gen.radiologist);
+		header->gen.radiologist_valid = 1;
+	}
+	if (in->gen.model_valid)
+	{	strcpy(header->gen.model, in->gen.model);
+		header->gen.model_valid = 1;
+	}
+	if (in->gen.patient_name_valid)
+	{	strcpy(header->gen.patient_name, in->gen.patient_name);
+		header->gen.patient_name_valid = 1;
+	}
+	if (in->gen.patient_id_valid)
+	{	strcpy(header->gen.patient_id, in->gen.patient_id);
+		header->gen.patient_id_valid = 1;
+	}
+	if (in->gen.study_valid)
+	{	strcpy(header->gen.study, in->gen.study);
+		header->gen.study_valid = 1;
+	}
+	if (in->gen.series_valid)
+	{	strcpy(header->gen.series, in->gen.series);
+		header->gen.series_valid = 1;
+	}
+	header->dsp.num_of_elems = 3;
+	header->dsp.measurement_unit[0] = header->dsp.measurement_unit[1] =
+		in->str.measurement_unit[0];
+	header->dsp.measurement_unit_valid = 1;
+	header->dsp.dimension = 5;
+	smallest_value[0] = smallest_value[1] = smallest_value[2] = 0;
+	header->dsp.smallest_value = smallest_value;
+	largest_value[0] = largest_value[1] = largest_value[2] = 255;
+	header->dsp.largest_value = largest_value;
+	header->dsp.num_of_integers = header->dsp.num_of_elems;
+	signed_bits[0] = signed_bits[1] = signed_bits[2] = 0;
+	header->dsp.signed_bits = signed_bits;
+	bit_fields[0] = 0;
+	bit_fields[1] = 7;
+	bit_fields[2] = 8;
+	bit_fields[3] = 15;
+	bit_fields[4] = 16;
+	bit_fields[5] = 23;
+	header->dsp.num_of_bits = 24;
+	header->dsp.bit_fields = bit_fields;
+	header->dsp.num_of_images = frames;
+	header->dsp.xysize[0] = renderer->main_image->width;
+	header->dsp.xysize[1] = renderer->main_image->height;
+	header->dsp.xypixsz[0] = header->dsp.xypixsz[1] =
+		(float)(1/(renderer->scale*unit_mm(obj_data)));
+	header->dsp.dimension_valid = header->dsp.num_of_elems_valid =
+		header->dsp.smallest_value_valid = header->dsp.largest_value_valid =
+		header->dsp.num_of_integers_valid = header->dsp.signed_bits_valid =
+		header->dsp.num_of_bits_valid = header->dsp.bit_fields_valid =
+		header->dsp.num_of_images_valid = header->dsp.xysize_valid =
+		header->dsp.xypixsz_valid = 1;
+	error_code = VWriteHeader(movie_file, header, bad_group, bad_element);
+	free(header);
+	switch (error_code)
+	{	case 0:
+		case 107:
+		case 106:
+			break;
+		default:
+			return error_code;
+	}
+	return VSeekData(movie_file, 0);
+}
@@ -197,7 +197,8 @@ int get_patch(Patch **patch, double projection_matrix[3][3])
  *    T_x, T_y, T_z: A table defining the numbered vertices of a voxel in terms
  *       of direction from the center along the coordinate axes (-1 or 1).
  *    v: Which of the 64827 triangle patches to compute.
- *    new_view: Flag indicating view may be different from the previous call.
+ *    new_view: Flag indicating view may be different from the previous call
+ *       by the same thread.
  *    tweak: Adjust for only 3 voxel edge points per edge.
  * SIDE EFFECTS: None
  * ENTRY CONDITIONS:
@@ -207,6 +208,7 @@ int get_patch(Patch **patch, double projection_matrix[3][3])
  * EXIT CONDITIONS:
  * HISTORY:
  *    Created: 9/10/03 by Dewey Odhner
+ *    Modified: 10/19/26 voxel edge points kept per thread.
  *
  *****************************************************************************/
 int get_triangle_patch(Patch **patch, double projection_matrix[3][3],
@@ -217,7 +219,7 @@ int get_triangle_patch(Patch **patch, double projection_matrix[3][3],
 	int top_cornern, bottom_cornern, j, k, y, tn,
 			last_right_end, new_right_end, left_cornern, right_cornern,
 			new_left_end, last_left_end, m, env[3];
-	static double voxel_edge_point[13][7][2];
+	static thread_local double voxel_edge_point[13][7][2];
 	double second_left[2], second_right[1];
 
 	if (new_view)
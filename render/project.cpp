@@ -32,6 +32,9 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 #define RO_BW 0
 #define CO_BW 0
 
+#define SKIP_TILE 8 /* pixels on a side of the tiles used to skip rows */
+#define SKIP_UPDATE_SLICES 4 /* slices projected between tile updates */
+
 #define Malloc(ptr, type, num, bequest) \
 {	ptr = (type *)malloc((num)*sizeof(type)); \
 	if (ptr == NULL) \
@@ -49,6 +52,12 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 	(((x)&NZ)!=0) \
 )
 
+/* Checks whether the row at row_ptr_ptr can be skipped; for use in the
+   projection functions of DIRECT objects. */
+#define Skip_row(row_ptr_ptr) \
+	skip_row(&skip_tiles, object_data, row_ptr_ptr, this_row_x, this_row_y, \
+		column_x_table, column_y_table)
+
 
 int number_of_triangles[255]; /* in each t-shell configuration */
 
@@ -9852,6 +9861,255 @@ int cvRenderer::d_project(Shell_data *object_data,
 }
 
 
+/*****************************************************************************
+ * FUNCTION: patch_reach
+ * DESCRIPTION: Returns the farthest a patch extends from its center pixel.
+ * PARAMETERS:
+ *    patch: The patch.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: The distance in pixels.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int patch_reach(Patch *patch)
+{
+	int reach, line;
+
+	reach = -patch->top>patch->bottom? -patch->top: patch->bottom;
+	for (line=0; line<patch->bottom-patch->top; line++)
+	{	if (-patch->lines[line].left > reach)
+			reach = -patch->lines[line].left;
+		if (patch->lines[line].right > reach)
+			reach = patch->lines[line].right;
+	}
+	return reach;
+}
+
+/*****************************************************************************
+ * FUNCTION: init_skip_tiles
+ * DESCRIPTION: Sets up the tiles of an object image used to skip rows of
+ *    voxels that cannot change the projection.  No rows will be skipped
+ *    until the first call to skip_tiles_slice that updates the tiles.
+ * PARAMETERS:
+ *    tiles: The tiles to set up.
+ *    object_image: The object image to be projected.
+ *    channels: 3 to keep the least red, green, blue of each tile (maximum
+ *       intensity projection); 1 to keep the least opacity.
+ *    margin: The farthest in pixels a voxel can project from its pixel.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None; if memory cannot be allocated, tiles->floor is NULL
+ *    and no rows will be skipped.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static void init_skip_tiles(Skip_tiles *tiles, Object_image *object_image,
+	int channels, int margin)
+{
+	int j;
+
+	tiles->tiles_x = tiles->tiles_y =
+		(object_image->image_size+SKIP_TILE-1)/SKIP_TILE;
+	tiles->channels = channels;
+	tiles->margin = margin;
+	tiles->slices = 0;
+	tiles->floor = (int *)malloc(tiles->tiles_x*tiles->tiles_y*channels*
+		sizeof(int));
+	if (tiles->floor)
+		for (j=0; j<tiles->tiles_x*tiles->tiles_y*channels; j++)
+			tiles->floor[j] = -1;
+}
+
+/*****************************************************************************
+ * FUNCTION: skip_tiles_slice
+ * DESCRIPTION: Counts a slice projected and every SKIP_UPDATE_SLICES slices
+ *    finds the least value of each tile of the object image.  Since
+ *    projecting only raises pixel values, the values found remain lower
+ *    bounds for the rest of the projection.
+ * PARAMETERS:
+ *    tiles: The tiles set up by init_skip_tiles.
+ *    object_image: The object image being projected.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static void skip_tiles_slice(Skip_tiles *tiles, Object_image *object_image)
+{
+	int tx, ty, x, y, c, *floor;
+
+	if (tiles->floor==NULL || ++tiles->slices%SKIP_UPDATE_SLICES)
+		return;
+	for (ty=0; ty<tiles->tiles_y; ty++)
+		for (tx=0; tx<tiles->tiles_x; tx++)
+		{	floor = tiles->floor+(ty*tiles->tiles_x+tx)*tiles->channels;
+			for (c=0; c<tiles->channels; c++)
+				floor[c] = tiles->channels==3? V_OBJECT_IMAGE_BACKGROUND:
+					MAX_OPACITY;
+			for (y=ty*SKIP_TILE; y<(ty+1)*SKIP_TILE &&
+					y<object_image->image_size; y++)
+				for (x=tx*SKIP_TILE; x<(tx+1)*SKIP_TILE &&
+						x<object_image->image_size; x++)
+					if (tiles->channels == 3)
+					{	Pixel_unit *pixel=
+							(Pixel_unit *)object_image->image[y]+x*3;
+
+						if (pixel[0] == V_OBJECT_IMAGE_BACKGROUND)
+							floor[0] = floor[1] = floor[2] = -1;
+						else
+							for (c=0; c<3; c++)
+								if (pixel[c] < floor[c])
+									floor[c] = pixel[c];
+					}
+					else if (object_image->opacity_buffer[y][x] < floor[0])
+						floor[0] = object_image->opacity_buffer[y][x];
+		}
+}
+
+/*****************************************************************************
+ * FUNCTION: d_mip_ceiling
+ * DESCRIPTION: Finds the greatest color d_mip_paint_one_voxel or
+ *    d_mip_patch_one_voxel can give a voxel of density in a range.
+ * PARAMETERS:
+ *    lo, hi: The range of density.
+ *    threshold: Intensity levels defining the different materials.
+ *    ceiling: The greatest red, green, blue will go here.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The static variables materl_opacity, materl_red,
+ *    materl_green, materl_blue, gray_flag must be valid.
+ * RETURN VALUE: None
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+void cvRenderer::d_mip_ceiling(int lo, int hi, int threshold[6],
+	int ceiling[3])
+{
+	int density[14], n=0, j, c;
+	unsigned front_materl, back_materl, pb, pf;
+
+	/* The color is monotone in density between thresholds. */
+	density[n++] = lo;
+	density[n++] = hi;
+	for (j=0; j<6; j++)
+	{	if (threshold[j]>lo && threshold[j]<=hi)
+			density[n++] = threshold[j];
+		if (threshold[j]-1>=lo && threshold[j]-1<hi)
+			density[n++] = threshold[j]-1;
+	}
+	ceiling[0] = ceiling[1] = ceiling[2] = 0;
+	for (j=0; j<n; j++)
+	{	for(back_materl=3; back_materl; back_materl--)
+			if (density[j] >= threshold[(back_materl-1)*2])
+				break;
+		front_materl = back_materl==3? 2: back_materl==2? 1: 0;
+		pb = back_materl==0? 0: density[j]>=threshold[back_materl*2-1]? 255:
+			(int)(255.*(density[j]-threshold[back_materl*2-2])/
+			(threshold[back_materl*2-1]-threshold[back_materl*2-2]));
+		pf = 255-pb;
+		c = (unsigned short)(float)((pf*materl_opacity[front_materl]*
+			materl_red[front_materl]+pb*materl_opacity[back_materl]*
+			materl_red[back_materl])*(1./255));
+		if (c > ceiling[0])
+			ceiling[0] = c;
+		if (gray_flag)
+			continue;
+		c = (unsigned short)(float)((pf*materl_opacity[front_materl]*
+			materl_green[front_materl]+pb*materl_opacity[back_materl]*
+			materl_green[back_materl])*(1./255));
+		if (c > ceiling[1])
+			ceiling[1] = c;
+		c = (unsigned short)(float)((pf*materl_opacity[front_materl]*
+			materl_blue[front_materl]+pb*materl_opacity[back_materl]*
+			materl_blue[back_materl])*(1./255));
+		if (c > ceiling[2])
+			ceiling[2] = c;
+	}
+}
+
+/*****************************************************************************
+ * FUNCTION: skip_row
+ * DESCRIPTION: Checks whether projecting a row of voxels of an object of
+ *    class DIRECT can change the object image.  For maximum intensity
+ *    projection, no voxel can change a pixel whose color is already at
+ *    least the brightest the densities of the row can give; when
+ *    compositing, no voxel can change a pixel that is already opaque.
+ * PARAMETERS:
+ *    tiles: The tiles of the object image from skip_tiles_slice.
+ *    object_data: The shell being rendered.
+ *    row_ptr_ptr: The entry of object_data->ptr_table for the row.
+ *    row_x, row_y: The object image buffer coordinates of the row
+ *       in 0x10000 units per pixel.
+ *    column_x_table, column_y_table: Lookup tables giving the coordinates of
+ *       a voxel relative to the row, same units as row coordinates, indexed
+ *       by y1 value of the voxel.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: The row must be in memory.  The static variables
+ *    materl_opacity, materl_red, materl_green, materl_blue, gray_flag must
+ *    be valid.
+ * RETURN VALUE: Non-zero if the row can be skipped.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+int cvRenderer::skip_row(Skip_tiles *tiles, Shell_data *object_data,
+	unsigned short **row_ptr_ptr, int row_x, int row_y,
+	int column_x_table[1024], int column_y_table[1024])
+{
+	int ceiling[3], x0, y0, x1, y1, steps, step, reach, x, y, tx, ty, c,
+		*floor;
+	unsigned icoord;
+
+	if (tiles->floor==NULL || tiles->slices<SKIP_UPDATE_SLICES ||
+			row_ptr_ptr[1]==row_ptr_ptr[0])
+		return FALSE;
+	if (tiles->channels == 3)
+	{	if (object_data->row_range == NULL)
+			return FALSE;
+		d_mip_ceiling(object_data->row_range[row_ptr_ptr-
+			object_data->ptr_table][0], object_data->row_range[row_ptr_ptr-
+			object_data->ptr_table][1], object_data->threshold, ceiling);
+	}
+	else
+		ceiling[0] = MAX_OPACITY;
+
+	/* The voxels project near the segment between the first and last. */
+	icoord = row_x+column_x_table[row_ptr_ptr[0][0]&0x3ff];
+	x0 = icoord/0x10000;
+	icoord = row_y+column_y_table[row_ptr_ptr[0][0]&0x3ff];
+	y0 = icoord/0x10000;
+	icoord = row_x+column_x_table[row_ptr_ptr[1][-3]&0x3ff];
+	x1 = icoord/0x10000;
+	icoord = row_y+column_y_table[row_ptr_ptr[1][-3]&0x3ff];
+	y1 = icoord/0x10000;
+	steps = (abs(x1-x0)>abs(y1-y0)? abs(x1-x0): abs(y1-y0))/SKIP_TILE+1;
+	reach = SKIP_TILE/2+tiles->margin+1;
+	for (step=0; step<=steps; step++)
+	{	x = x0+(x1-x0)*step/steps;
+		y = y0+(y1-y0)*step/steps;
+		for (ty=(y-reach)/SKIP_TILE; ty<=(y+reach)/SKIP_TILE; ty++)
+			for (tx=(x-reach)/SKIP_TILE; tx<=(x+reach)/SKIP_TILE; tx++)
+			{	if (tx<0 || ty<0 || tx>=tiles->tiles_x || ty>=tiles->tiles_y)
+					continue;
+				floor = tiles->floor+(ty*tiles->tiles_x+tx)*tiles->channels;
+				for (c=0; c<tiles->channels; c++)
+					if (floor[c] < ceiling[c])
+						return FALSE;
+			}
+	}
+	return TRUE;
+}
+
 /*****************************************************************************
  * FUNCTION: d_patch_project
  * DESCRIPTION: Renders an object of class DIRECT by parallel
@@ -9922,6 +10180,7 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 		this_slice_x, this_slice_y, this_slice_z, order,
 		itop_margin, ibottom_margin, ileft_margin, iright_margin, error_code;
 	unsigned short *this_ptr, **next_ptr_ptr, *next_ptr, *this_slice_ptr;
+	Skip_tiles skip_tiles;
 	double top_margin, bottom_margin, left_margin, right_margin, voxel_depth,
 		temp_matrix[3][3], temp_vector[3];
 
@@ -9989,6 +10248,7 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 	ibottom_margin = (int)rint(0x10000*bottom_margin);
 	ileft_margin = (int)rint(0x10000*left_margin);
 	iright_margin = (int)rint(0x10000*right_margin);
+	init_skip_tiles(&skip_tiles, object_image, 1, patch_reach(patch));
 	switch (order)
 	{
 		case CO_BW+RO_BW+SL_BW:
@@ -10004,10 +10264,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10016,7 +10278,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -10063,10 +10326,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10076,6 +10341,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_patch_one_voxel(this_row_z, angle_shade,this_row_x,
@@ -10103,10 +10370,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10115,7 +10384,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -10150,10 +10420,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10163,7 +10435,9 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_patch_one_voxel(this_row_z, angle_shade,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -10190,10 +10464,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10202,7 +10478,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -10236,10 +10513,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10249,6 +10528,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_patch_one_voxel(this_row_z, angle_shade,this_row_x,
@@ -10273,10 +10554,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10285,7 +10568,8 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -10317,10 +10601,12 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -10330,7 +10616,9 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_patch_one_voxel(this_row_z, angle_shade,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -10348,6 +10636,7 @@ int cvRenderer::d_patch_project(Shell_data *object_data,
 			}
 			break;
 	}
+	free(skip_tiles.floor);
 	free(patch->lines[0].weight);
 	free(patch);
 	return (0);
@@ -10652,6 +10941,7 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 		column_x_table[1024], column_y_table[1024], column_z_table[1024],
 		this_slice_x, this_slice_y, this_slice_z;
 	unsigned short *this_ptr, **next_ptr_ptr, *next_ptr, *this_slice_ptr;
+	Skip_tiles skip_tiles;
 
 	order =	(projection_matrix[2][0]>=0? CO_BW: CO_FW) +
 			(projection_matrix[2][1]>=0? RO_BW: RO_FW) +
@@ -10672,6 +10962,7 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 		column_y_table[coln] = coln*column_y_factor;
 		column_z_table[coln] = (int)(Z_SUBLEVELS*MIDDLE_DEPTH+coln*column_z_factor);
 	}
+	init_skip_tiles(&skip_tiles, object_image, 1, 1);
 	switch (order)
 	{	case CO_BW+RO_BW+SL_BW:
 			this_slice_x = (int)(0x10000*(projection_offset[0]/*+.5*/)+
@@ -10685,7 +10976,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10694,7 +10988,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -10702,11 +10997,11 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 								this_row_x, this_row_y, column_x_table,
 								column_y_table, column_z_table, this_ptr,
 								object_image, object_data->threshold);
-						next_ptr_ptr--;
-						this_row_x -= row_x_factor;
-						this_row_z -= row_z_factor;
-						this_row_y -= row_y_factor;
 					}
+					next_ptr_ptr--;
+					this_row_x -= row_x_factor;
+					this_row_z -= row_z_factor;
+					this_row_y -= row_y_factor;
 				}
 				this_slice_x -= slice_x_factor;
 				this_slice_y -= slice_y_factor;
@@ -10725,7 +11020,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10735,6 +11033,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_paint_one_voxel(this_row_z, angle_shade,this_row_x,
@@ -10760,7 +11060,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->slices-1)*slice_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10769,7 +11072,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -10801,7 +11105,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->slices-1)*slice_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10811,7 +11118,9 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_paint_one_voxel(this_row_z, angle_shade,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -10836,7 +11145,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10845,7 +11157,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -10876,7 +11189,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10886,6 +11202,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_paint_one_voxel(this_row_z, angle_shade,this_row_x,
@@ -10908,7 +11226,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 			this_slice_z = (int)(Z_SUBLEVELS*projection_offset[2]);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10917,7 +11238,8 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -10946,7 +11268,10 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 			this_slice_z = (int)(Z_SUBLEVELS*projection_offset[2]);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -10956,7 +11281,9 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_paint_one_voxel(this_row_z, angle_shade,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -10973,6 +11300,7 @@ int cvRenderer::d_quick_project(Shell_data *object_data,
 			}
 			break;
 	}
+	free(skip_tiles.floor);
 	return (0);
 }
 
@@ -11245,6 +11573,7 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 		this_slice_x, this_slice_y, this_slice_z, order,
 		itop_margin, ibottom_margin, ileft_margin, iright_margin, error_code;
 	unsigned short *this_ptr, **next_ptr_ptr, *next_ptr, *this_slice_ptr;
+	Skip_tiles skip_tiles;
 	double top_margin, bottom_margin, left_margin, right_margin;
 
 	order =	(projection_matrix[2][0]>=0? CO_BW: CO_FW) +
@@ -11281,6 +11610,7 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 	ibottom_margin = (int)rint(0x10000*bottom_margin);
 	ileft_margin = (int)rint(0x10000*left_margin);
 	iright_margin = (int)rint(0x10000*right_margin);
+	init_skip_tiles(&skip_tiles, object_image, 3, patch_reach(patch));
 	switch (order)
 	{
 		case CO_BW+RO_BW+SL_BW:
@@ -11296,10 +11626,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11308,7 +11640,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -11355,10 +11688,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11368,6 +11703,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_patch_one_voxel(this_row_z,this_row_x,
@@ -11395,10 +11732,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11407,7 +11746,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -11442,10 +11782,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11455,7 +11797,9 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_patch_one_voxel(this_row_z,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -11482,10 +11826,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11494,7 +11840,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -11528,10 +11875,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11541,6 +11890,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_patch_one_voxel(this_row_z,this_row_x,
@@ -11565,10 +11916,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11577,7 +11930,8 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -11609,10 +11963,12 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
 				{
+					free(skip_tiles.floor);
 					free(patch->lines[0].weight);
 					free(patch);
 					return (401);
 				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];
 				next_ptr_ptr =
@@ -11622,7 +11978,9 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_patch_one_voxel(this_row_z,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -11640,6 +11998,7 @@ int cvRenderer::d_mip_patch_project(Shell_data *object_data,
 			}
 			break;
 	}
+	free(skip_tiles.floor);
 	free(patch->lines[0].weight);
 	free(patch);
 	return (0);
@@ -11896,6 +12255,7 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 		column_x_table[1024], column_y_table[1024], column_z_table[1024],
 		this_slice_x, this_slice_y, this_slice_z;
 	unsigned short *this_ptr, **next_ptr_ptr, *next_ptr, *this_slice_ptr;
+	Skip_tiles skip_tiles;
 
 	order =	(projection_matrix[2][0]>=0? CO_BW: CO_FW) +
 			(projection_matrix[2][1]>=0? RO_BW: RO_FW) +
@@ -11916,6 +12276,7 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 		column_y_table[coln] = coln*column_y_factor;
 		column_z_table[coln] = (int)(Z_SUBLEVELS*MIDDLE_DEPTH+coln*column_z_factor);
 	}
+	init_skip_tiles(&skip_tiles, object_image, 3, 1);
 	switch (order)
 	{	case CO_BW+RO_BW+SL_BW:
 			this_slice_x = (int)(0x10000*(projection_offset[0]/*+.5*/)+
@@ -11929,7 +12290,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -11938,7 +12302,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -11946,11 +12311,11 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 								this_row_x, this_row_y, column_x_table,
 								column_y_table, column_z_table, this_ptr,
 								object_image, object_data->threshold);
-						next_ptr_ptr--;
-						this_row_x -= row_x_factor;
-						this_row_z -= row_z_factor;
-						this_row_y -= row_y_factor;
 					}
+					next_ptr_ptr--;
+					this_row_x -= row_x_factor;
+					this_row_z -= row_z_factor;
+					this_row_y -= row_y_factor;
 				}
 				this_slice_x -= slice_x_factor;
 				this_slice_y -= slice_y_factor;
@@ -11969,7 +12334,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -11979,6 +12347,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_paint_one_voxel(this_row_z,this_row_x,
@@ -12004,7 +12374,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->slices-1)*slice_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12013,7 +12386,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -12045,7 +12419,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->slices-1)*slice_z_factor);
 			for (this_slice=object_data->slices-1; this_slice>=0; this_slice--)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12055,7 +12432,9 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_paint_one_voxel(this_row_z,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -12080,7 +12459,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12089,7 +12471,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
-				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0)
+				{	if (next_ptr_ptr[1]-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr))
 					{	this_ptr = next_ptr_ptr[1]-3;
 						next_ptr = *next_ptr_ptr;
 						for (; this_ptr>=next_ptr; this_ptr-=3)
@@ -12120,7 +12503,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				(object_data->rows-1)*row_z_factor);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12130,6 +12516,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_z = this_slice_z;
 				for (this_row=object_data->rows-1; this_row>=0; this_row--)
 				{	this_ptr = next_ptr_ptr[-1];
+					if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
 					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_paint_one_voxel(this_row_z,this_row_x,
@@ -12152,7 +12540,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 			this_slice_z = (int)(Z_SUBLEVELS*projection_offset[2]);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12161,7 +12552,8 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0)
+				{	if (*next_ptr_ptr-3-this_slice_ptr >= 0 &&
+							!Skip_row(next_ptr_ptr-1))
 					{	this_ptr = *next_ptr_ptr-3;
 						for (next_ptr=
 								next_ptr_ptr[-1];
@@ -12190,7 +12582,10 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 			this_slice_z = (int)(Z_SUBLEVELS*projection_offset[2]);
 			for (this_slice=0; this_slice<object_data->slices; this_slice++)
 			{	if (check_event && check_event(this)==FIRST)
+				{	free(skip_tiles.floor);
 					return (401);
+				}
+				skip_tiles_slice(&skip_tiles, object_image);
 				this_slice_ptr =
 					object_data->ptr_table[this_slice*object_data->rows];;
 				next_ptr_ptr =
@@ -12200,7 +12595,9 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 				this_row_y = this_slice_y;
 				this_row_z = this_slice_z;
 				for (this_row=0; this_row<object_data->rows; this_row++)
-				{	for (next_ptr=*next_ptr_ptr;
+				{	if (Skip_row(next_ptr_ptr-1))
+						this_ptr = *next_ptr_ptr;
+					for (next_ptr=*next_ptr_ptr;
 							this_ptr<next_ptr; this_ptr+=3)
 						d_mip_paint_one_voxel(this_row_z,this_row_x,
 							this_row_y, column_x_table, column_y_table,
@@ -12217,6 +12614,7 @@ int cvRenderer::d_mip_quick_project(Shell_data *object_data,
 			}
 			break;
 	}
+	free(skip_tiles.floor);
 	return (0);
 }
 
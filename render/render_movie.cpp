@@ -0,0 +1,331 @@
+/*
+  Copyright 1993-2026 Medical Image Processing Group
+              Department of Radiology
+            University of Pennsylvania
+
+This file is part of CAVASS.
+
+CAVASS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+CAVASS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* render_movie: renders a movie of a key pose sequence without a display.
+ *
+ * The frames are rendered concurrently by a pool of renderers that share
+ * the shells loaded by the first one (see cvRenderer(cvRenderer *)), a
+ * batch at a time, and written in order as each batch is finished.
+ */
+
+
+#include  "cavass.h"
+#ifdef  Left
+    #undef  Left
+#endif
+#ifdef  Right
+    #undef  Right
+#endif
+
+#include "cvRender.h"
+#include "tiffio.h"
+#include <wx/init.h>
+#include <wx/image.h>
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#define omp_get_thread_num() 0
+#endif
+
+#define FRAMES_PER_THREAD 4	/* frames rendered by each thread in a batch */
+
+typedef enum {MV0_MOVIE, TIFF_MOVIE, PNG_MOVIE} Movie_format;
+
+/* The renderer calls these to run external programs and report errors. */
+void run_command(char cmnd[], bool fg)
+{
+	if (system(cmnd))
+		fprintf(stderr, "Command \"%s\" failed.\n", cmnd);
+	free(cmnd);
+}
+
+void display_message(const char msg[])
+{
+	fprintf(stderr, "%s\n", msg);
+}
+
+/* Output files are always overwritten. */
+bool ok_to_write(const char file_name[])
+{
+	return true;
+}
+
+static void usage(const char program[])
+{
+	fprintf(stderr,
+"Usage: %s <input> <sequence> <output> [-threads n] [-scale f] [-antialias]\n"
+"  input: a structure or shell file (.BS0, .BS2, .SH0, ...)\n"
+"  sequence: key poses as saved by the manipulate tool\n"
+"  output: .MV0, .tif (one directory per frame), or .png (numbered files)\n"
+"  -threads n: number of renderers; default is the number of processors\n"
+"  -scale f: scale of the images in pixels/mm\n"
+"  -antialias: anti-alias the images\n", program);
+	exit(1);
+}
+
+static bool has_suffix(const char path[], const char suffix[])
+{
+	size_t n=strlen(path), m=strlen(suffix);
+
+	return n>m && strcasecmp(path+n-m, suffix)==0;
+}
+
+/*****************************************************************************
+ * FUNCTION: write_tiff_frame
+ * DESCRIPTION: Writes a frame to a TIFF file as a new directory.
+ * PARAMETERS:
+ *    tif: The TIFF file.
+ *    data: The frame, 3 bytes per pixel.
+ *    width, height: The frame dimensions.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 if successful, 3 if the write fails.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26 from SurfViewCanvas::save_movie
+ *
+ *****************************************************************************/
+static int write_tiff_frame(TIFF *tif, unsigned char *data, int width,
+	int height)
+{
+	TIFFSetField( tif, TIFFTAG_IMAGEWIDTH,      width               );
+	TIFFSetField( tif, TIFFTAG_IMAGELENGTH,     height              );
+	TIFFSetField( tif, TIFFTAG_BITSPERSAMPLE,   8                   );
+	TIFFSetField( tif, TIFFTAG_SAMPLESPERPIXEL, 3                   );
+	TIFFSetField( tif, TIFFTAG_ORIENTATION,     ORIENTATION_TOPLEFT );
+	TIFFSetField( tif, TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG );
+	TIFFSetField( tif, TIFFTAG_PHOTOMETRIC,     PHOTOMETRIC_RGB     );
+#ifdef ALLOW_LZW
+	TIFFSetField( tif, TIFFTAG_COMPRESSION,     COMPRESSION_LZW     );
+#else
+	TIFFSetField( tif, TIFFTAG_COMPRESSION,     COMPRESSION_NONE    );
+#endif
+	for (int row=0; row<height; row++)
+		if (TIFFWriteScanline( tif, &data[row*width*3], row ) < 0)
+			return 3;
+	return TIFFWriteDirectory( tif )? 0: 3;
+}
+
+/*****************************************************************************
+ * FUNCTION: write_png_frame
+ * DESCRIPTION: Writes a frame to a numbered PNG file.
+ * PARAMETERS:
+ *    path: The output name; the frame number is inserted before ".png".
+ *    frame: The frame number from 0.
+ *    data: The frame, 3 bytes per pixel.
+ *    width, height: The frame dimensions.
+ * SIDE EFFECTS: None
+ * ENTRY CONDITIONS: None
+ * RETURN VALUE: 0 if successful, 3 if the write fails.
+ * EXIT CONDITIONS: None
+ * HISTORY:
+ *    Created: 10/19/26
+ *
+ *****************************************************************************/
+static int write_png_frame(const char path[], int frame, unsigned char *data,
+	int width, int height)
+{
+	wxString name(path, strlen(path)-4);
+
+	name += wxString::Format("%04d.png", frame);
+	/* static data: the image does not free it */
+	wxImage image(width, height, data, true);
+	return image.SaveFile(name, wxBITMAP_TYPE_PNG)? 0: 3;
+}
+
+int main(int argc, char *argv[])
+{
+	wxInitializer initializer;
+	Movie_format format;
+	Key_pose *key_pose;
+	int key_poses, frames, threads=omp_get_max_threads(), anti_alias=FALSE,
+		error_code=0, frame_bytes, width, height, batch, start, j;
+	double scale=0;
+	char *file_list[1], bad_group[5], bad_element[5];
+	unsigned char *frame_data;
+	FILE *movie_file=NULL;
+	TIFF *tif=NULL;
+	cvRenderer **renderer;
+
+	if (argc < 4)
+		usage(argv[0]);
+	for (j=4; j<argc; j++)
+		if (strcmp(argv[j], "-threads")==0 && j+1<argc)
+			threads = atoi(argv[++j]);
+		else if (strcmp(argv[j], "-scale")==0 && j+1<argc)
+			scale = atof(argv[++j]);
+		else if (strcmp(argv[j], "-antialias") == 0)
+			anti_alias = TRUE;
+		else
+			usage(argv[0]);
+	if (threads < 1)
+		threads = 1;
+	if (has_suffix(argv[3], ".MV0"))
+		format = MV0_MOVIE;
+	else if (has_suffix(argv[3], ".tif") || has_suffix(argv[3], ".tiff"))
+		format = TIFF_MOVIE;
+	else if (has_suffix(argv[3], ".png"))
+		format = PNG_MOVIE;
+	else
+		usage(argv[0]);
+	if (!initializer.IsOk())
+	{
+		fprintf(stderr, "Cannot initialize wxWidgets.\n");
+		exit(1);
+	}
+	if (format == PNG_MOVIE)
+		wxImage::AddHandler(new wxPNGHandler);
+
+	switch (read_movie_sequence(argv[2], &key_pose, &key_poses))
+	{
+		case 0:
+			break;
+		case 1:
+			fprintf(stderr, "Out of memory.\n");
+			exit(1);
+		case 4:
+			fprintf(stderr, "Cannot open %s.\n", argv[2]);
+			exit(1);
+		default:
+			fprintf(stderr, "%s is not a valid sequence.\n", argv[2]);
+			exit(1);
+	}
+	frames = movie_frames(key_pose, key_poses);
+
+	/* The first renderer loads the shells; the rest share them and its
+	   settings. */
+	renderer = (cvRenderer **)malloc(threads*sizeof(cvRenderer *));
+	if (renderer == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	file_list[0] = argv[1];
+	renderer[0] = new cvRenderer(file_list, 1);
+	if (renderer[0]->object_list == NULL)
+	{
+		fprintf(stderr, "Cannot load %s.\n", argv[1]);
+		exit(1);
+	}
+	renderer[0]->setAntialias(anti_alias != FALSE);
+	if (scale > 0)
+		renderer[0]->setScale(scale);
+	for (j=1; j<threads; j++)
+		renderer[j] = new cvRenderer(renderer[0]);
+	width = renderer[0]->main_image->width;
+	height = renderer[0]->main_image->height;
+	frame_bytes = width*height*3;
+
+	batch = threads*FRAMES_PER_THREAD;
+	if (batch > frames)
+		batch = frames;
+	frame_data = (unsigned char *)malloc((size_t)batch*frame_bytes);
+	if (frame_data == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+
+	switch (format)
+	{
+		case MV0_MOVIE:
+			movie_file = fopen(argv[3], "wb+");
+			if (movie_file == NULL)
+			{
+				fprintf(stderr, "Unable to create file %s\n", argv[3]);
+				exit(1);
+			}
+			error_code = write_movie_header(movie_file, argv[3], renderer[0],
+				frames, bad_group, bad_element);
+			if (error_code && bad_group[0])
+				fprintf(stderr,
+					"Group %s element %s undefined in VWriteHeader\n",
+					bad_group, bad_element);
+			break;
+		case TIFF_MOVIE:
+			tif = TIFFOpen(argv[3], "wb");
+			if (tif == NULL)
+			{
+				fprintf(stderr, "Unable to create file %s\n", argv[3]);
+				exit(1);
+			}
+			break;
+		case PNG_MOVIE:
+			break;
+	}
+
+	for (start=0; error_code==0 && start<frames; start+=batch)
+	{
+		int count=frames-start<batch? frames-start: batch, frame;
+
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+		for (frame=0; frame<count; frame++)
+		{
+			cvRenderer *r=renderer[omp_get_thread_num()];
+
+			movie_pose(r->glob_angle, key_pose, key_poses, start+frame);
+			memcpy(frame_data+(size_t)frame*frame_bytes, r->render().data,
+				frame_bytes);
+		}
+
+		for (frame=0; error_code==0 && frame<count; frame++)
+		{
+			unsigned char *data=frame_data+(size_t)frame*frame_bytes;
+			int obytes;
+
+			switch (format)
+			{
+				case MV0_MOVIE:
+					error_code = VWriteData((char *)data, 1, frame_bytes,
+						movie_file, &obytes);
+					if (error_code==0 && obytes!=frame_bytes)
+						error_code = 3;
+					break;
+				case TIFF_MOVIE:
+					error_code = write_tiff_frame(tif, data, width, height);
+					break;
+				case PNG_MOVIE:
+					error_code = write_png_frame(argv[3], start+frame, data,
+						width, height);
+					break;
+			}
+		}
+		fprintf(stderr, "%d frames to go.\n", frames-start-count);
+	}
+
+	if (movie_file)
+		VCloseData(movie_file);
+	if (tif)
+		TIFFClose(tif);
+	free(frame_data);
+	for (j=threads-1; j>=0; j--)
+		delete renderer[j];
+	free(renderer);
+	free(key_pose);
+	if (error_code)
+	{
+		fprintf(stderr, "File write failed.\n");
+		exit(1);
+	}
+	exit(0);
+}
@@ -33,9 +33,10 @@ along with CAVASS.  If not, see <http://www.gnu.org/licenses/>.
 
 typedef int Chunk[CHUNKSIZE];
 
-static Chunk storage[CHUNKS];
-static int nused, thisn;
-static char flags[CHUNKS];
+/* Each thread has its own chunks, so that renderers can run concurrently. */
+static thread_local Chunk storage[CHUNKS];
+static thread_local int nused, thisn;
+static thread_local char flags[CHUNKS];
 
 /*****************************************************************************
  * FUNCTION: salloc
@@ -68,7 +69,8 @@ char *salloc(unsigned long size)
  * DESCRIPTION: Frees allocated memory.
  * PARAMETERS:
  *    ptr: The address of the memory block to be freed.  Must be allocated by
- *       salloc, calloc, or malloc and not subsequently freed.
+ *       salloc in the same thread, calloc, or malloc and not subsequently
+ *       freed.
  * SIDE EFFECTS: None
  * ENTRY CONDITIONS: None
  * RETURN VALUE: None
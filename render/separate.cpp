@@ -550,6 +550,7 @@ Function_status cvRenderer::combine_object_data(Shell_data *object_data1,
 		(data_class==BINARY_B||data_class==BINARY_A? 2:3);
 	object_data1->file->file_header.str.volume_valid = FALSE;
 	object_data1->file->file_header.str.surface_area_valid = FALSE;
+	set_row_ranges(object_data1);
 	return (DONE);
 }
 
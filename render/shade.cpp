@@ -130,14 +130,15 @@ void VComputeShadeLut(int shade_lut[SHADE_LUT_SIZE], double diffuse_exponent,
  * EXIT CONDITIONS: None
  * HISTORY:
  *    Created: 2/20/90 by Dewey Odhner
+ *    Modified: 10/19/26 table kept per thread.
  *
  *****************************************************************************/
 static float (*get_gradient_table(void))[3]
 {
-	static int done;
+	static thread_local int done;
 	int i;
 	double gx, gy, gz, norm_factor;
-	static float g_table[G_CODES][3];
+	static thread_local float g_table[G_CODES][3];
 
 	if (done)
 		return (g_table);
@@ -166,14 +167,15 @@ static float (*get_gradient_table(void))[3]
  * EXIT CONDITIONS: None
  * HISTORY:
  *    Created: 5/16/01 by Dewey Odhner
+ *    Modified: 10/19/26 table kept per thread.
  *
  *****************************************************************************/
 static float (*bget_gradient_table(void))[3]
 {
-	static int done;
+	static thread_local int done;
 	int i;
 	double gx, gy, gz, norm_factor;
-	static float g_table[BG_CODES][3];
+	static thread_local float g_table[BG_CODES][3];
 
 	if (done)
 		return (g_table);
@@ -217,8 +219,8 @@ static float (*bget_gradient_table(void))[3]
  *       in *rend_params.
  *    object_class: Indicates which size of look-up table to initialize.
  *    show_back: Allows the back of a surface to be seen if non-zero.
- * SIDE EFFECTS: The table returned on previous calls will be overwritten and
- *    the same address will be returned again.
+ * SIDE EFFECTS: The table returned on previous calls by the same thread will
+ *    be overwritten and the same address will be returned again.
  * ENTRY CONDITIONS: None
  * RETURN VALUE: None
  * EXIT CONDITIONS: None
@@ -229,13 +231,15 @@ static float (*bget_gradient_table(void))[3]
  *    Modified: 3/18/94 parameters modified by Dewey Odhner
  *    Modified: 5/16/01 parameter object_class added by Dewey Odhner
  *    Modified: 9/19/01 parameter show_back added by Dewey Odhner
+ *    Modified: 10/19/26 table kept per thread so that two renderers can
+ *       run at once.
  *
  *****************************************************************************/
 void VGetAngleShades(int **angle_shade, double rotation_matrix[3][3],
 	Rendering_parameters *rend_params, int flags,
 	Classification_type object_class, int show_back)
 {
-	static int ang_shade[BG_CODES];
+	static thread_local int ang_shade[BG_CODES];
 	int local_shade_lut[SHADE_LUT_SIZE], *shade_lut;
 	unsigned short j;
 	double cos_theta;